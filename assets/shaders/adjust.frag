@@ -0,0 +1,23 @@
+#version 130
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+uniform sampler2D texture2d;
+
+/* 256x1 rgba table folding all adjustments (built on cpu by `ColorLut`) */
+uniform sampler2D texture_lut;
+
+out vec4 color_out;
+
+void main() {
+  // entries at texel centers, so linear filtering interpolates between them for half-float inputs
+  vec4 color = texture(texture2d, texture_coord_vert);
+  vec3 coord = (clamp(color.rgb, 0.0, 1.0) * 255.0 + 0.5) / 256.0;
+  color_out = vec4(
+    texture(texture_lut, vec2(coord.r, 0.5)).r,
+    texture(texture_lut, vec2(coord.g, 0.5)).g,
+    texture(texture_lut, vec2(coord.b, 0.5)).b,
+    color.a
+  );
+}
@@ -0,0 +1,33 @@
+#version 130
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+uniform sampler2D texture2d;
+
+/* 1d kernel computed on cpu (see `BlurKernel`): tap 0 at center, others on both sides */
+const int N_TAPS_MAX = 32;
+uniform float weights[N_TAPS_MAX];
+uniform float offsets[N_TAPS_MAX];
+uniform float n_taps;
+
+/* (1, 0) for horizontal pass & (0, 1) for vertical pass */
+uniform float direction_x;
+uniform float direction_y;
+
+out vec4 color_out;
+
+/* Inspired by: https://www.rastergrid.com/blog/2010/09/efficient-gaussian-blur-with-linear-sampling/ */
+void main() {
+  // offsets fall between 2 texels, so linear filtering averages them in one fetch
+  vec2 size = textureSize(texture2d, 0);
+  vec2 step_uv = vec2(direction_x, direction_y) / size;
+
+  vec4 sum = weights[0] * texture(texture2d, texture_coord_vert);
+  for (int i = 1; i < int(n_taps); i++) {
+    sum += weights[i] * texture(texture2d, texture_coord_vert + offsets[i] * step_uv);
+    sum += weights[i] * texture(texture2d, texture_coord_vert - offsets[i] * step_uv);
+  }
+
+  color_out = sum;
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+in vec2 corner_vert;
+
+uniform vec4 color;
+uniform float hardness;
+
+out vec4 color_out;
+
+/**
+ * Circular dab from its signed distance field (distance to center in radius units)
+ * Opaque up to `hardness`, then fades out linearly to the edge (antialiased border)
+ */
+void main() {
+  float distance = length(corner_vert);
+  if (distance > 1.0)
+    discard;
+
+  float alpha = 1.0 - smoothstep(hardness, 1.0, distance);
+  color_out = vec4(color.rgb, color.a * alpha);
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// corner of unit quad in [-1, 1] & center of dab (one per instance) in nanovg coords (origin at lower-left corner)
+layout (location = 0) in vec2 corner;
+layout (location = 1) in vec2 center;
+
+uniform vec2 size_framebuffer;
+uniform float radius;
+
+out vec2 corner_vert;
+
+/* Position quad around dab's center in NDC space (y flipped like nanovg, whose y = 0 is last row of texture) */
+void main() {
+  vec2 position = center + corner * radius;
+  vec2 position_ndc = vec2(position.x / size_framebuffer.x * 2.0 - 1.0, 1.0 - 2.0 * position.y / size_framebuffer.y);
+  gl_Position = vec4(position_ndc, 0, 1);
+  corner_vert = corner;
+}
@@ -0,0 +1,38 @@
+#version 330 core
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+/* effects output & reference image (stretched over image if sizes differ) */
+uniform sampler2D texture2d;
+uniform sampler2D texture_reference;
+
+/* `CompareView` (1: difference, 2: heatmap, 3: flicker), gain of error & flicker phase */
+uniform int view;
+uniform float gain;
+uniform int is_reference;
+
+out vec4 color_out;
+
+/* Blue (no error) to red (error of 1 after gain) through cyan, green & yellow */
+vec3 get_heat(float value) {
+  const vec3 colors[5] = vec3[](vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 1.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0),
+                                vec3(1.0, 0.0, 0.0));
+  float position = clamp(value, 0.0, 1.0) * 4.0;
+  int i_color = min(int(position), 3);
+  return mix(colors[i_color], colors[i_color + 1], position - float(i_color));
+}
+
+/* Per-channel absolute difference, its magnitude as a heatmap, or either image (alternated by caller) */
+void main() {
+  vec3 color = clamp(texture(texture2d, texture_coord_vert).rgb, 0.0, 1.0);
+  vec3 color_reference = texture(texture_reference, texture_coord_vert).rgb;
+  vec3 difference = abs(color - color_reference);
+
+  if (view == 1)
+    color_out = vec4(min(difference * gain, 1.0), 1.0);
+  else if (view == 2)
+    color_out = vec4(get_heat(length(difference) / sqrt(3.0) * gain), 1.0);
+  else
+    color_out = vec4((is_reference != 0) ? color_reference : color, 1.0);
+}
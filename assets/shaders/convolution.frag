@@ -0,0 +1,39 @@
+#version 130
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+uniform sampler2D texture2d;
+
+out vec4 color_out;
+
+/* `RADIUS`, `WEIGHTS` & `IS_GRADIENT` defined by cpu before compiling a variant (see `ConvolutionKernel`) */
+const int SIZE = 2 * RADIUS + 1;
+const float weights[SIZE * SIZE] = WEIGHTS;
+
+void main() {
+  // texels fetched exactly (clamped at borders like cpu version)
+  ivec2 size = textureSize(texture2d, 0);
+  ivec2 position = ivec2(texture_coord_vert * vec2(size));
+  vec4 center = texelFetch(texture2d, position, 0);
+
+  // constant bounds, so loops are unrolled by compiler
+  vec4 sum = vec4(0.0);
+  vec4 sum_y = vec4(0.0);
+  for (int y = -RADIUS; y <= RADIUS; y++) {
+    for (int x = -RADIUS; x <= RADIUS; x++) {
+      vec4 color = texelFetch(texture2d, clamp(position + ivec2(x, y), ivec2(0), size - 1), 0);
+      sum += weights[(y + RADIUS) * SIZE + (x + RADIUS)] * color;
+#ifdef IS_GRADIENT
+      sum_y += weights[(x + RADIUS) * SIZE + (y + RADIUS)] * color;
+#endif
+    }
+  }
+
+#ifdef IS_GRADIENT
+  sum = sqrt(sum * sum + sum_y * sum_y);
+#endif
+
+  // alpha kept (clamped as half-float targets aren't)
+  color_out = vec4(clamp(sum.rgb, 0.0, 1.0), center.a);
+}
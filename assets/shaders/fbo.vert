@@ -5,6 +5,9 @@ layout (location = 1) in vec2 texture_coord;
 
 out vec2 texture_coord_vert;
 
+/* sub-rectangle of texture sampled (lower-left & upper-right uv), changed when drawing visible region to screen */
+uniform vec4 uv_rect = vec4(0.0, 0.0, 1.0, 1.0);
+
 /**
  * Shader used to render to texture via fbo, so displayed image (modified by frag. shaders) can be saved to disk later
  * vertex positions passed in NDC space
@@ -13,5 +16,5 @@ void main() {
   // z = -1 at near-plane & z = 1 at far-plane (z = 0 in between) - left-hand rule
   // image (of same size) displayed only when z in [-1, 1]
   gl_Position = vec4(position, 0, 1);
-  texture_coord_vert = texture_coord;
+  texture_coord_vert = mix(uv_rect.xy, uv_rect.zw, texture_coord);
 }
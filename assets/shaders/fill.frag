@@ -0,0 +1,18 @@
+#version 330 core
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+/* region filled (r8, same size as target texture) */
+uniform sampler2D texture2d;
+uniform vec4 color;
+
+out vec4 color_out;
+
+/* Opaque color over region (same output whether target is premultiplied or not) */
+void main() {
+  if (texelFetch(texture2d, ivec2(gl_FragCoord.xy), 0).r < 0.5)
+    discard;
+
+  color_out = color;
+}
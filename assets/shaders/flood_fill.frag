@@ -0,0 +1,68 @@
+#version 330 core
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+/* region grown so far (r8, only valid inside `bounds`) & image whose colors are compared to the seed's one */
+uniform sampler2D texture2d;
+uniform sampler2D texture_color;
+
+/* positions in texels (fragment rows are texture rows), bounds as (x_min, y_min, x_max, y_max) with max excluded */
+uniform ivec2 seed;
+uniform ivec4 bounds;
+
+/* pass grows region along rows (1, 0) or columns (0, 1), over at most `radius` similar pixels */
+uniform ivec2 direction;
+uniform int radius;
+
+/* max. difference of any channel with seed's color (normalized) */
+uniform float tolerance;
+
+out vec4 color_out;
+
+vec4 color_seed;
+
+bool is_similar(ivec2 position) {
+  vec4 difference = abs(texelFetch(texture_color, position, 0) - color_seed);
+  return max(max(difference.r, difference.g), max(difference.b, difference.a)) <= tolerance;
+}
+
+bool is_filled(ivec2 position) {
+  if (position == seed)
+    return true;
+
+  bool is_inside = all(greaterThanEqual(position, bounds.xy)) && all(lessThan(position, bounds.zw));
+  return is_inside && texelFetch(texture2d, position, 0).r > 0.5;
+}
+
+/**
+ * Pixel joins region if it's similar to seed & connected to region through similar pixels along direction
+ * Pixels outside region discarded (not counted by occlusion query, which tells when region stops growing)
+ */
+void main() {
+  color_seed = texelFetch(texture_color, seed, 0);
+  ivec2 size = textureSize(texture_color, 0);
+  ivec2 position = ivec2(gl_FragCoord.xy);
+  if (!is_similar(position))
+    discard;
+
+  if (is_filled(position)) {
+    color_out = vec4(1.0);
+    return;
+  }
+
+  for (int sign = -1; sign <= 1; sign += 2) {
+    for (int i = 1; i <= radius; i++) {
+      ivec2 neighbour = position + sign * i * direction;
+      if (any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, size)) || !is_similar(neighbour))
+        break;
+
+      if (is_filled(neighbour)) {
+        color_out = vec4(1.0);
+        return;
+      }
+    }
+  }
+
+  discard;
+}
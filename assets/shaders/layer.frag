@@ -0,0 +1,21 @@
+#version 130
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+uniform sampler2D texture2d;
+
+/* annotation layers are drawn premultiplied (on transparent texture), image layer isn't */
+uniform float opacity;
+uniform int is_premultiplied;
+
+out vec4 color_out;
+
+/* Layer scaled by its opacity, output premultiplied (blended with `GL_ONE, GL_ONE_MINUS_SRC_ALPHA`) */
+void main() {
+  vec4 color = texture(texture2d, texture_coord_vert);
+  if (is_premultiplied == 0)
+    color.rgb *= color.a;
+
+  color_out = color * opacity;
+}
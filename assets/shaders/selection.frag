@@ -0,0 +1,22 @@
+#version 330 core
+
+/* modified from `imgui/imgui_impl_opengl3.cpp` */ 
+in vec2 texture_coord_vert;
+
+/* output of effects & their input, mixed by coverage of selection */
+uniform sampler2D texture2d;
+uniform sampler2D texture_input;
+
+/* selection's mask covers its bounding box only (fragment rows are texture rows, i.e. image rows) */
+uniform sampler2D mask;
+uniform ivec2 origin_mask;
+
+out vec4 color_out;
+
+/* Effects shown inside selection, input left as is outside it (drawn with scissor test on bounding box) */
+void main() {
+  vec4 color_effects = texture(texture2d, texture_coord_vert);
+  vec4 color_input = texture(texture_input, texture_coord_vert);
+  float coverage = texelFetch(mask, ivec2(gl_FragCoord.xy) - origin_mask, 0).r;
+  color_out = mix(color_input, color_effects, coverage);
+}
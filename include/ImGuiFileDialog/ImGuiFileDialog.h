@@ -652,6 +652,7 @@ struct IGFD_Thumbnail_Info
 #include <list>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 namespace IGFD
 {
@@ -849,6 +850,17 @@ namespace IGFD
 		std::set<std::string> prSelectedFileNames;							// the user selection of FilePathNames
 		bool prCreateDirectoryMode = false;									// for create directory widget
 
+		struct ScanState;													// entries streamed by the scan thread (defined in cpp)
+		struct ScanCacheEntry												// complete scan of a directory
+		{
+			time_t dirModifTime = 0;
+			std::vector<std::shared_ptr<FileInfos>> files;
+		};
+		std::shared_ptr<ScanState> prScan = nullptr;						// in-flight scan (detached thread, null when done)
+		std::map<std::string, ScanCacheEntry> prScanCache;					// per directory + filter + flags
+		std::list<std::string> prScanCacheOrder;							// oldest first, for eviction
+		size_t prCountSorted = 0U;											// file list size at last sort during a scan
+
 	public:
 		char puVariadicBuffer[MAX_FILE_DIALOG_NAME_BUFFER] = "";			// called by prSelectableItem
 		bool puInputPathActivated = false;									// show input for path edition
@@ -886,6 +898,9 @@ namespace IGFD
 		void prAddFileNameInSelection(const std::string& vFileName, bool vSetLastSelectionFileName);	// selection : add a file name
 		void AddFile(const FileDialogInternal& vFileDialogInternal, 
 			const std::string& vPath, const std::string& vFileName, const char& vFileType);				// add file called by scandir
+		static std::shared_ptr<FileInfos> prCreateFileInfos(const FilterManager& vFilterManager, ImGuiFileDialogFlags vFlags,
+			const std::string& vPath, const std::string& vFileName, const char& vFileType);				// null if filtered out (callable from scan thread)
+		bool prIsShownInFilteredList(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) const;
 
 	public:
 		FileManager();
@@ -920,7 +935,10 @@ namespace IGFD
 		
 		//depend of dirent.h
 		void SetCurrentDir(const std::string& vPath);													// define current directory for scan
-		void ScanDir(const FileDialogInternal& vFileDialogInternal, const std::string& vPath);			// scan the directory for retrieve the file list
+		void ScanDir(const FileDialogInternal& vFileDialogInternal, const std::string& vPath);			// scan the directory for retrieve the file list (streamed from a thread)
+		void DrainScan(const FileDialogInternal& vFileDialogInternal);									// append entries scanned since last frame
+		void CancelScan();																				// stop in-flight scan (e.g. directory changed)
+		bool IsScanning() const;
 
 	public:
 		std::string GetResultingPath();
@@ -940,6 +958,8 @@ namespace IGFD
 #ifdef USE_THUMBNAILS
 	typedef std::function<void(IGFD_Thumbnail_Info*)> CreateThumbnailFun;	// texture 2d creation function binding
 	typedef std::function<void(IGFD_Thumbnail_Info*)> DestroyThumbnailFun;	// texture 2d destroy function binding
+	typedef std::function<void(uint8_t* vDatas, int vWidth, int vHeight)> ThumbnailLoadedFun;	// rgba datas (or null on failure), callable from any thread
+	typedef std::function<void(const std::string& vFilePathName, const ThumbnailLoadedFun& vOnLoaded)> LoadThumbnailFun;	// user loader replacing the extraction thread
 #endif
 	class ThumbnailFeature
 	{
@@ -973,6 +993,7 @@ namespace IGFD
 
 		CreateThumbnailFun prCreateThumbnailFun = nullptr;
 		DestroyThumbnailFun prDestroyThumbnailFun = nullptr;
+		LoadThumbnailFun prLoadThumbnailFun = nullptr;
 
 	protected:
 		DisplayModeEnum prDisplayMode = DisplayModeEnum::FILE_LIST;
@@ -992,6 +1013,7 @@ namespace IGFD
 	public:
 		void SetCreateThumbnailCallback(const CreateThumbnailFun& vCreateThumbnailFun);
 		void SetDestroyThumbnailCallback(const DestroyThumbnailFun& vCreateThumbnailFun);
+		void SetLoadThumbnailCallback(const LoadThumbnailFun& vLoadThumbnailFun);	// decode asynchronously with own loader (extraction thread not started)
 		
 		// must be call in gpu zone (rendering, possibly one rendering thread)
 		void ManageGPUThumbnails();	// in gpu rendering zone, whill create or destroy texture
@@ -0,0 +1,108 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include <memory>
+
+#include "image.hpp"
+
+#include "jobs/bounded_queue.hpp"
+#include "image/image_encoder.hpp"
+#include "image/annotations.hpp"
+#include "image/stroke_rasterizer.hpp"
+
+/* Options of batch run (parsed from command line) */
+struct BatchOptions {
+  std::string dir_in;
+  std::string dir_out;
+
+  /* effects applied in order, e.g. {"grayscale", "gaussian:10"} */
+  std::vector<std::string> effects;
+
+  /* extension of output files (encoder picked from it) */
+  std::string format;
+
+  /* gpu processing needs a gl context current on calling thread */
+  bool use_gpu;
+
+  int n_threads_decode;
+  int n_threads_encode;
+  size_t size_queue;
+
+  /* jpeg quality & png level */
+  ImageEncoder::Options encoding;
+
+  /* folder of reference images compared to outputs (empty: no comparison) & thresholds of a failed comparison */
+  std::string dir_reference;
+  double psnr_min;
+  double ssim_min;
+
+  /* circles & lines burnt into outputs after effects: one file for all images, or folder of files of same stem */
+  std::string path_annotations;
+};
+
+/**
+ * Applies same effects to all images in a directory, with decoding, processing & encoding as overlapping stages
+ * Stages exchange images through bounded queues (so at most a few decoded images are in memory)
+ * Decoding & encoding run on worker threads, processing on cpu (`ImageUtils`) or gpu (shaders on calling thread)
+ * Annotations (if any) are read by decoders & burnt on cpu by processing stage, whatever device ran the effects
+ */
+class Pipeline {
+public:
+  Pipeline(const BatchOptions& options);
+  bool run();
+
+  static bool is_supported(const std::string& effect, bool use_gpu);
+
+private:
+  /* seed, color & tolerance of a fill effect */
+  struct FillOptions {
+    int x;
+    int y;
+    unsigned char color[4];
+    int tolerance;
+  };
+
+  static bool parse_fill(const std::string& effect, FillOptions& fill);
+  static bool parse_adjust(const std::string& effect, std::unordered_map<std::string, float>& parameters);
+
+  /* image travelling through stages (pixels either in `image` or in `pixels` after a gpu readback) */
+  struct Item {
+    std::string path_in;
+    std::string path_out;
+    Image image;
+    std::vector<unsigned char> pixels;
+
+    /* shapes drawn over image once processed (shared by all images if a single file was given) */
+    std::shared_ptr<const Annotations> annotations;
+  };
+
+  BatchOptions m_options;
+  std::vector<std::string> m_paths;
+
+  BoundedQueue<Item*> m_queue_decoded;
+  BoundedQueue<Item*> m_queue_processed;
+
+  std::atomic<size_t> m_i_path;
+  std::atomic<int> m_n_decoders;
+  std::atomic<size_t> m_n_done;
+  std::atomic<size_t> m_n_failed;
+  std::atomic<size_t> m_n_regressions;
+
+  /* shapes of single annotations file (unset if a folder was given) */
+  std::shared_ptr<const Annotations> m_annotations;
+
+  bool list_paths();
+  bool load_annotations(Item& item);
+  void annotate(Item& item, StrokeRasterizer& rasterizer);
+  void decode();
+  void process_cpu();
+  void process_gpu();
+  void encode();
+  bool compare(const Item& item);
+};
+
+#endif // PIPELINE_HPP
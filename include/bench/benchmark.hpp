@@ -0,0 +1,42 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+
+/* Timing of one benchmark case (durations in ms) */
+struct BenchmarkResult {
+  std::string name;
+  std::string variant;
+  int width;
+  int height;
+  int n_channels;
+  int n_threads;
+  int n_iterations = 0;
+  double duration_median = 0.0;
+  double duration_min = 0.0;
+};
+
+/**
+ * Collects results of benchmark cases & writes them as json (to diff across commits)
+ * Each case runs at least `N_ITERATIONS_MIN` times & until `DURATION_MIN` is reached (or `N_ITERATIONS_MAX`)
+ */
+class Benchmark {
+public:
+  Benchmark();
+  const BenchmarkResult& measure_cpu(const BenchmarkResult& info, const std::function<void()>& func);
+  const BenchmarkResult& measure_gpu(const BenchmarkResult& info, const std::function<void()>& func);
+  bool write_json(const std::string& path) const;
+
+private:
+  static const int N_ITERATIONS_MIN = 3;
+  static const int N_ITERATIONS_MAX = 100;
+  static constexpr double DURATION_MIN = 250.0;
+
+  std::vector<BenchmarkResult> m_results;
+
+  const BenchmarkResult& add(BenchmarkResult result, std::vector<double>& durations);
+};
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,32 @@
+#ifndef REPLAY_REPORT_HPP
+#define REPLAY_REPORT_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Frame times of a replayed session (in ms) & checksum of canvas once it finished
+ * Percentiles catch performance regressions, checksum catches rendering changes (compared across commits)
+ */
+class ReplayReport {
+public:
+  ReplayReport(const std::string& path_log, float fps);
+  void add_cpu(float duration);
+  void add_gpu(float duration);
+  void set_checksum(uint64_t checksum);
+  void print() const;
+  bool write_json(const std::string& path) const;
+
+private:
+  std::string m_path_log;
+  float m_fps;
+  std::vector<float> m_durations_cpu;
+  std::vector<float> m_durations_gpu;
+  uint64_t m_checksum;
+
+  static float get_percentile(std::vector<float> durations, float percentile);
+  static std::string format_checksum(uint64_t checksum);
+};
+
+#endif // REPLAY_REPORT_HPP
@@ -0,0 +1,62 @@
+#ifndef COMMAND_HPP
+#define COMMAND_HPP
+
+#include <string>
+
+/* Actions enqueued by ui (menu, toolbar & canvas input) then dispatched once per frame to canvas & window */
+enum class CommandType {
+  OPEN_IMAGE,    // path
+  NEW_DOCUMENT,  // path opened in a new document, value: read-only
+  SWITCH_DOCUMENT, // value: index of document
+  CLOSE_DOCUMENT,  // value: index of document
+  SAVE_IMAGE,    // path
+  EXPORT_IMAGE,  // path (format from extension), value: jpeg quality, x1: png level, y1: downscale factor
+  BROWSE,        // value: step in folder (+1/-1)
+  PLAY_SEQUENCE, // value: frames per second (0 stops playback), path: any frame of sequence (current image if empty)
+  COMPARE,       // path: reference image (current one kept if empty), value: `CompareView` (NONE leaves compare mode), x1: gain
+  UNDO,
+  REDO,
+  EFFECT,        // value: `Shader` appended to effects chain (grayscale, blur, sharpen, sobel or adjust)
+  SET_BLUR,      // value: stage of chain, x1: radius, y1: is_box
+  SET_RADIUS,    // value: stage of chain, x1: radius of convolution
+  SET_ADJUSTMENT, // value: stage of chain, path: name of adjustment, x1: its value
+  REMOVE_EFFECT,
+  CLEAR_EFFECTS,
+  SET_BACKEND,   // value: `Backend` of effects
+  VIEW,          // value: `Shader` of view
+  ZOOM,          // value: +1 to zoom in, -1 to zoom out (2x around canvas' center), 0 for x2: factor around x1, y1
+  PAN,           // x1, y1: displacement of view
+  DRAW_CIRCLE,   // x1, y1: center
+  DRAW_LINE,     // x1, y1, x2, y2: end points
+  BRUSH_TO,      // x1, y1: next position of circle brush
+  END_STROKE,    // shape/stroke drawn so far becomes one operation in history
+  ADD_LAYER,     // transparent annotation layer on top of image
+  REMOVE_LAYER,  // value: index of layer
+  SELECT_LAYER,  // value: index of layer drawn on (0: image)
+  SET_LAYER,     // value: index of layer, x1: opacity, y1: is_visible
+  SELECT_RECT,   // x1, y1, x2, y2: opposite corners of rectangle effects are restricted to
+  SELECT_TO,     // x1, y1: next vertex of lasso
+  END_SELECTION, // lasso drawn so far closed into selection
+  CLEAR_SELECTION,
+  FILL,          // x1, y1: clicked pixel, value: tolerance (0-255)
+  MAGIC_WAND,    // x1, y1: clicked pixel, value: tolerance (0-255)
+  LOAD_OVERLAY,  // path: circles & lines drawn over image (.json or .csv), overlay cleared if empty
+  QUIT,
+};
+
+/**
+ * Command & its payload (unused fields left to 0)
+ * Positions in image pixels, nanovg convention (origin at lower-left corner), so a replay doesn't depend on window layout
+ */
+struct Command {
+  CommandType type;
+  int value = 0;
+  float x1 = 0.0f, y1 = 0.0f, x2 = 0.0f, y2 = 0.0f;
+  std::string path = "";
+
+  std::string serialize() const;
+  static bool parse(const std::string& line, Command& command);
+  static const char* get_name(CommandType type);
+};
+
+#endif // COMMAND_HPP
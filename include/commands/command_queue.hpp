@@ -0,0 +1,23 @@
+#ifndef COMMAND_QUEUE_HPP
+#define COMMAND_QUEUE_HPP
+
+#include <vector>
+
+#include "commands/command.hpp"
+
+/**
+ * Commands enqueued during a frame (by menu, toolbar & canvas), taken all at once by frame to dispatch them
+ * Only used from main thread (no locking)
+ */
+class CommandQueue {
+public:
+  static CommandQueue& get();
+
+  void push(const Command& command);
+  std::vector<Command> take();
+
+private:
+  std::vector<Command> m_commands;
+};
+
+#endif // COMMAND_QUEUE_HPP
@@ -0,0 +1,47 @@
+#ifndef SESSION_LOG_HPP
+#define SESSION_LOG_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include "commands/command.hpp"
+
+/**
+ * Commands dispatched in a session written to a text file (`--record`), to be replayed in same order later (`--replay`)
+ * Frames only counted while canvas is idle (i.e. not waiting for an open or save), so a replay doesn't depend on
+ * how long decodes & encodes take on the machine it runs on
+ * Format: `frame <i>` line followed by the commands dispatched at frame i (see `Command::serialize()`)
+ */
+class SessionLog {
+public:
+  /* set from command-line arguments (empty if not recording/replaying) */
+  static std::string path_record;
+  static std::string path_replay;
+
+  /* simulated frame rate of replays (imgui time advances by a fixed step, whatever the actual frame time) */
+  static float fps_replay;
+
+  SessionLog();
+  bool is_replaying() const;
+  void record(unsigned int i_frame, const std::vector<Command>& commands);
+  std::vector<Command> replay(unsigned int i_frame);
+  void free();
+
+private:
+  struct Entry {
+    unsigned int i_frame;
+    Command command;
+  };
+
+  std::ofstream m_file_record;
+
+  /* replayed commands & index of next one */
+  std::vector<Entry> m_entries;
+  size_t m_i_entry;
+  bool m_is_replaying;
+
+  void load(const std::string& path);
+};
+
+#endif // SESSION_LOG_HPP
@@ -0,0 +1,25 @@
+#ifndef BLUR_KERNEL_HPP
+#define BLUR_KERNEL_HPP
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * 1d kernel of separable blur (applied horizontally then vertically)
+ * Pairs of adjacent texels merged into one linearly-interpolated fetch (halves # of taps)
+ */
+struct BlurKernel {
+  /* must match array size in `blur_separable.frag` */
+  static const int N_TAPS_MAX = 32;
+  static const int RADIUS_MAX = 2 * (N_TAPS_MAX - 1);
+
+  /* tap 0 at center, others fetched on both sides at +/- offset (in pixels) */
+  std::vector<float> weights;
+  std::vector<float> offsets;
+
+  BlurKernel(int radius, bool is_box=false);
+  std::unordered_map<std::string, float> to_parameters(float direction_x, float direction_y) const;
+};
+
+#endif // BLUR_KERNEL_HPP
@@ -0,0 +1,51 @@
+#ifndef COMPUTE_EFFECTS_HPP
+#define COMPUTE_EFFECTS_HPP
+
+#include <array>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "glad/glad.h"
+
+#include "texture_2d.hpp"
+#include "gpu/program_cache.hpp"
+#include "effects/program_table.hpp"
+
+/* Effects run as fragment shaders on a quad (always available) or as compute shaders (GL >= 4.3) */
+enum class Backend {
+  FRAGMENT,
+  COMPUTE,
+};
+
+/**
+ * Compute-shader versions of effects (indexed by `Shader`), with same uniforms as fragment ones
+ * Neighbourhood of each workgroup cached in shared memory for convolutions (e.g. blurs)
+ */
+class ComputeEffects {
+public:
+  /* cleared to force fragment backend (e.g. `--backend fragment`) */
+  static bool is_enabled;
+  static bool is_supported();
+  static GLuint load(const std::string& path);
+
+  ComputeEffects();
+  bool has_failed() const;
+  bool has(Shader shader);
+  void render(Shader shader, const std::unordered_map<std::string, float>& parameters,
+              const Texture2D& source, const Texture2D& target);
+  void free();
+
+private:
+  /* must match `local_size_x` in compute shaders */
+  static const int SIZE_GROUP = 16;
+  static const int SIZE_GROUP_LINE = 128;
+
+  /* programs ready (0 if none), builds not finished yet & uniforms locations of each shader */
+  std::array<GLuint, N_SHADERS> m_programs;
+  std::array<std::optional<ProgramCache::Build>, N_SHADERS> m_builds;
+  std::array<std::unordered_map<std::string, GLint>, N_SHADERS> m_locations;
+  bool m_has_failed;
+};
+
+#endif // COMPUTE_EFFECTS_HPP
@@ -0,0 +1,161 @@
+#ifndef EFFECT_CHAIN_HPP
+#define EFFECT_CHAIN_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include "framebuffer.hpp"
+#include "program.hpp"
+#include "texture_2d.hpp"
+#include "render/renderer.hpp"
+#include "image/depth.hpp"
+#include "gpu/selection_mask.hpp"
+#include "image/color_lut.hpp"
+#include "image/dirty_region.hpp"
+#include "gpu/tile_scheduler.hpp"
+
+#include "effects/compute_effects.hpp"
+#include "effects/program_table.hpp"
+
+/* Stage of effect chain: shader & its float uniforms */
+struct Effect {
+  Shader shader;
+  std::unordered_map<std::string, float> parameters;
+};
+
+/**
+ * Ordered effects (e.g. grayscale then blur x3) applied to image through ping-pong textures
+ * Output of the stage preceding the last edited one is cached, so only stages after a changed parameter are re-run
+ * At most 3 full-size textures alive at once whatever the # of stages (cached input, source & target),
+ * & previous output kept on screen until a time-sliced render is done
+ * Intermediate textures have the depth of the input (8-bit, 16-bit), or are half-float if `is_half_float`,
+ * & a single channel for monochrome inputs (effects then operate on that channel only)
+ * Adjustment stages sample a lookup table rebuilt on cpu only when one of their parameters changes
+ * With a selection, passes are scissored to its bounding box (grown by radius of later stages) & output is only valid
+ * over that box (effects mixed with input there accord. to mask)
+ * With a frame budget (see `TileScheduler`), stages are rendered in tiles over several frames, render resumed on next
+ * call until output is complete (restarted if input or a parameter changed meanwhile)
+ */
+class EffectChain {
+public:
+  /* render effects in half-float to avoid banding of chained stages (e.g. successive blurs) */
+  static bool is_half_float;
+
+  static Depth get_depth_output(Depth depth_input);
+
+  EffectChain();
+  void push(Shader shader, const std::unordered_map<std::string, float>& parameters={});
+  void pop();
+  void clear();
+  void set_parameter(size_t i_stage, const std::string& name, float value);
+  void invalidate();
+  void set_backend(Backend backend);
+  Backend get_backend() const;
+  void set_format(int n_channels, Depth depth_input);
+  void set_selection(SelectionMask* selection);
+
+  const Texture2D& render(Renderer& renderer, ProgramTable& programs, Framebuffer& framebuffer, const Texture2D& input,
+                          bool is_complete=false);
+  bool is_pending() const;
+  float get_progress() const;
+
+  std::vector<Effect> get_effects() const;
+  bool is_empty() const;
+  int get_radius() const;
+  unsigned int get_n_passes() const;
+  unsigned int get_n_skipped() const;
+  float get_duration_gpu();
+  int get_n_tiles_frame() const;
+  float get_duration_tile() const;
+  size_t get_n_bytes() const;
+  void evict();
+  void free();
+
+private:
+  /* textures kept for reuse in later passes (others freed) */
+  static const size_t N_TEXTURES_FREE = 2;
+
+  /* stage re-rendered when its revision differs from the one of its output (table only set for adjustments) */
+  struct Stage {
+    Effect effect;
+    unsigned int revision;
+    unsigned int revision_rendered;
+    std::optional<ColorLut> lut;
+  };
+
+  std::vector<Stage> m_stages;
+
+  /* input texture & its content revision (bumped by `invalidate()`) last rendered from */
+  GLuint m_id_input;
+  unsigned int m_revision_input;
+  unsigned int m_revision_input_rendered;
+
+  /* output of last stage & cached output of stage `m_i_cached` (i.e. input of edited stage) */
+  std::optional<Texture2D> m_texture_output;
+  std::optional<Texture2D> m_texture_cached;
+  size_t m_i_cached;
+
+  /* released textures recycled as ping-pong targets */
+  std::vector<Texture2D> m_textures_free;
+  int m_n_channels;
+  Depth m_depth;
+
+  /* compute shaders used for effects having a compute version (created on first selection) */
+  Backend m_backend;
+  std::unique_ptr<ComputeEffects> m_compute;
+
+  /* table of adjustment stage being rendered (re-uploaded per stage, only 1KB) */
+  std::optional<Texture2D> m_texture_lut;
+
+  /* region effects are restricted to (owned by canvas, NULL for whole image) */
+  SelectionMask* m_selection;
+
+  unsigned int m_n_passes;
+  unsigned int m_n_skipped;
+
+  /**
+   * Render in progress: stages re-rendered, next tile of stage `i_stage` (`n_stages` for selection's blend),
+   * & revisions of input & stages it started from (restarted if any of them changed)
+   */
+  struct Job {
+    GLuint id_input;
+    int width;
+    int height;
+    unsigned int revision_input;
+    std::vector<unsigned int> revisions;
+
+    size_t i_dirty;
+    size_t i_stage;
+    int i_tile;
+    int n_tiles_x;
+    int n_tiles_y;
+    int n_tiles_done;
+    int n_tiles_total;
+
+    Texture2D source;
+    std::optional<Texture2D> target;
+  };
+
+  std::optional<Job> m_job;
+
+  /* tiles run per frame & gpu time of last render (or of its last slice) measured without stalling */
+  TileScheduler m_scheduler;
+  int m_n_tiles_frame;
+
+  Texture2D acquire(int width, int height);
+  void release(const Texture2D& texture);
+  void release_cached();
+  bool start(const Texture2D& input);
+  bool is_current(const Job& job, const Texture2D& input) const;
+  int run(Renderer& renderer, ProgramTable& programs, Framebuffer& framebuffer, const Texture2D& input, int n_tiles_max);
+  void cancel();
+  void upload_lut(const ColorLut& lut);
+  bool render_stage(const Stage& stage, Renderer& renderer, ProgramTable& programs, Framebuffer& framebuffer,
+                    const Texture2D& source, const Texture2D& target, int margin, const DirtyRegion::Rect* tile);
+  static int get_radius(const Stage& stage);
+};
+
+#endif // EFFECT_CHAIN_HPP
@@ -0,0 +1,110 @@
+#ifndef PROGRAM_TABLE_HPP
+#define PROGRAM_TABLE_HPP
+
+#include <array>
+#include <string>
+#include <optional>
+#include <unordered_map>
+
+#include "glad/glad.h"
+
+#include "program.hpp"
+#include "image/convolution_kernel.hpp"
+
+/* View & effects shaders (values index programs tables, so no string is hashed to pick a program) */
+enum class Shader {
+  COLOR,
+  GRAYSCALE,
+  MONOCHROME,
+  BLUR,
+  BLUR_SEPARABLE,
+  SHARPEN,
+  SOBEL,
+  ADJUST,
+  LAYER,
+  COMPARE,
+};
+
+/* Name (shown in ui & given to batch) & sources of shader (no compute path if it has no compute version) */
+struct ShaderInfo {
+  Shader shader;
+  const char* name;
+  const char* path_fragment;
+  const char* path_compute;
+};
+
+/* in same order as enumeration */
+constexpr ShaderInfo SHADERS[] = {
+  { Shader::COLOR, "color", "assets/shaders/color.frag", nullptr },
+  { Shader::GRAYSCALE, "grayscale", "assets/shaders/grayscale.frag", "assets/shaders/compute/grayscale.comp" },
+  { Shader::MONOCHROME, "monochrome", "assets/shaders/monochrome.frag", "assets/shaders/compute/monochrome.comp" },
+  { Shader::BLUR, "blur", "assets/shaders/blur.frag", "assets/shaders/compute/blur.comp" },
+  { Shader::BLUR_SEPARABLE, "blur_separable", "assets/shaders/blur_separable.frag", "assets/shaders/compute/blur_separable.comp" },
+  { Shader::SHARPEN, "sharpen", "assets/shaders/convolution.frag", nullptr },
+  { Shader::SOBEL, "sobel", "assets/shaders/convolution.frag", nullptr },
+  { Shader::ADJUST, "adjust", "assets/shaders/adjust.frag", nullptr },
+  { Shader::LAYER, "layer", "assets/shaders/layer.frag", nullptr },
+  { Shader::COMPARE, "compare", "assets/shaders/compare.frag", nullptr },
+};
+
+constexpr size_t N_SHADERS = sizeof(SHADERS) / sizeof(SHADERS[0]);
+
+constexpr bool is_shaders_table_ordered() {
+  for (size_t i_shader = 0; i_shader < N_SHADERS; i_shader++) {
+    if (static_cast<size_t>(SHADERS[i_shader].shader) != i_shader)
+      return false;
+  }
+
+  return true;
+}
+
+static_assert(is_shaders_table_ordered(), "SHADERS must be indexed by Shader");
+
+constexpr const ShaderInfo& get_shader_info(Shader shader) {
+  return SHADERS[static_cast<size_t>(shader)];
+}
+
+/* Kernel of convolution shaders (one variant of `convolution.frag` compiled per radius), empty for other shaders */
+constexpr std::optional<Kernel> get_kernel(Shader shader) {
+  switch (shader) {
+    case Shader::SHARPEN:
+      return Kernel::SHARPEN;
+    case Shader::SOBEL:
+      return Kernel::SOBEL;
+    default:
+      return {};
+  }
+}
+
+std::optional<Shader> find_shader(const std::string& name);
+
+/**
+ * Fragment programs of shaders (indexed by `Shader`), each compiled on first use
+ * Uniforms locations queried once after linking & sampler bound to unit 0 then, so re-rendering doesn't query them
+ * Convolution shaders have a program per radius (their kernel's weights injected as constants)
+ */
+class ProgramTable {
+public:
+  static std::unordered_map<std::string, GLint> get_locations(GLuint program);
+
+  static int get_variant(Shader shader, int radius);
+  static int get_variant(Shader shader, const std::unordered_map<std::string, float>& parameters);
+
+  ProgramTable();
+  const Program& get(Shader shader, int radius=0);
+  GLint get_location(Shader shader, const std::string& name, int radius=0) const;
+  void free();
+
+private:
+  struct Entry {
+    std::optional<Program> program;
+    std::unordered_map<std::string, GLint> locations;
+  };
+
+  /* keyed by radius (0 for shaders without variants) */
+  std::array<std::unordered_map<int, Entry>, N_SHADERS> m_entries;
+
+  static std::string write_variant(const ShaderInfo& info, Kernel kernel, int radius);
+};
+
+#endif // PROGRAM_TABLE_HPP
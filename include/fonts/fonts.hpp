@@ -1,8 +1,13 @@
 #ifndef FONTS_HPP
 #define FONTS_HPP
 
+#include <string>
+
+#include "imgui.h"
+
 namespace Fonts {
-  void load();
+  void load(ImFontAtlas* atlas);
+  std::string get_dir_cache();
 };
 
 #endif // FONTS_HPP
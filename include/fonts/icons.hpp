@@ -0,0 +1,28 @@
+#ifndef ICONS_HPP
+#define ICONS_HPP
+
+#include "IconsFontAwesome5.h"
+
+/**
+ * Icons shown in ui: only their glyphs are merged into font atlas
+ * Any icon used in a widget must be added here, otherwise it's rendered as fallback glyph ('?')
+ */
+namespace Icons {
+  constexpr const char* USED[] = {
+    ICON_FA_FOLDER_OPEN,
+    ICON_FA_SAVE,
+    ICON_FA_WINDOW_CLOSE,
+    ICON_FA_PLUS_CIRCLE,
+    ICON_FA_MINUS_CIRCLE,
+    ICON_FA_CIRCLE,
+    ICON_FA_PEN,
+    ICON_FA_PAINT_BRUSH,
+    ICON_FA_PAINT_ROLLER,
+    ICON_FA_VECTOR_SQUARE,
+    ICON_FA_DRAW_POLYGON,
+    ICON_FA_MAGIC,
+    ICON_FA_FILL_DRIP,
+  };
+};
+
+#endif // ICONS_HPP
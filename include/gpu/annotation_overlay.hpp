@@ -0,0 +1,56 @@
+#ifndef ANNOTATION_OVERLAY_HPP
+#define ANNOTATION_OVERLAY_HPP
+
+#include <optional>
+
+#include "nanovg.h"
+
+#include "framebuffer.hpp"
+#include "texture_2d.hpp"
+
+#include "image/annotations.hpp"
+
+/**
+ * Circles & lines loaded from a file (File menu), drawn over canvas from a cached texture of image's size
+ * Rendered with nanovg only when shapes or image size changed: one path per batch of same style (all its
+ * circles filled or lines stroked at once), so a render takes one fill/stroke per style instead of one per shape
+ * Stencil buffer of its own, as sub-paths of a fill are resolved with the stencil (canvas' fbo only has a color buffer)
+ * Texture is premultiplied rgba (nanovg's output over transparent pixels)
+ */
+class AnnotationOverlay {
+public:
+  static constexpr const char* OWNER = "annotation overlay";
+
+  /* counters for profiling (duration in sec) */
+  struct Stats {
+    unsigned int n_renders;
+    unsigned int n_paths_last_render;
+    double duration_last_render;
+  };
+
+  AnnotationOverlay();
+  bool load(const std::string& path, std::string& error);
+  void clear();
+  bool empty() const;
+  const Annotations& get_annotations() const;
+  const Texture2D* update(NVGcontext* vg, int width, int height);
+  const Stats& get_stats() const;
+  void free();
+
+private:
+  Annotations m_annotations;
+
+  /* created on first render (freed with gpu resources of document, e.g. when it's evicted) */
+  std::optional<Texture2D> m_texture;
+  std::optional<Framebuffer> m_framebuffer;
+  GLuint m_id_stencil;
+
+  /* revision of shapes in texture */
+  unsigned int m_revision;
+
+  Stats m_stats;
+
+  void render(NVGcontext* vg);
+};
+
+#endif // ANNOTATION_OVERLAY_HPP
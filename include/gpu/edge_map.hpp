@@ -0,0 +1,57 @@
+#ifndef EDGE_MAP_HPP
+#define EDGE_MAP_HPP
+
+#include <optional>
+
+#include "framebuffer.hpp"
+#include "texture_2d.hpp"
+#include "render/renderer.hpp"
+
+#include "effects/program_table.hpp"
+#include "gpu/pixel_reader.hpp"
+#include "image/dirty_region.hpp"
+
+/**
+ * Sobel gradient magnitude of canvas content kept on gpu, for tools snapping to image edges (e.g. line tool)
+ * Rendered on first query, then only over regions changed since (given by dirty-region tracker)
+ * Queried by tiny asynchronous readbacks of a window around cursor, so snapping never reads back the whole image
+ * (result of a window requested in a previous frame, positions then searched in it on cpu)
+ * Positions in image pixels with origin at upper-left corner (i.e. rows of texture)
+ */
+class EdgeMap {
+public:
+  /* max. distance of snapped pixel from queried one (window read back is `2 * RADIUS + 1` pixels wide) */
+  static const int RADIUS = 8;
+
+  /* min. gradient magnitude (any channel, in [0, 255]) of a pixel snapped to */
+  static const int THRESHOLD = 48;
+
+  static constexpr const char* OWNER = "edge map";
+
+  EdgeMap();
+  void update(Renderer& renderer, ProgramTable& programs, const Texture2D& source, const DirtyRegion& dirty);
+  void request(int x, int y);
+  bool snap(float x, float y, float& x_snapped, float& y_snapped);
+  bool is_pending() const;
+  void free();
+
+private:
+  std::optional<Texture2D> m_texture;
+  std::optional<Framebuffer> m_framebuffer;
+
+  /* texture edges were computed from & revision of its dirty regions at that time */
+  GLuint m_id_source;
+  unsigned int m_revision;
+
+  /* created on first request (freed with edge map, e.g. when document is evicted) */
+  std::optional<PixelReader> m_pixel_reader;
+  Readback m_readback;
+  bool m_has_readback;
+
+  /* pixel & revision of edges last requested (not read back twice) */
+  int m_x_requested;
+  int m_y_requested;
+  unsigned int m_revision_requested;
+};
+
+#endif // EDGE_MAP_HPP
@@ -0,0 +1,59 @@
+#ifndef FLOOD_FILL_HPP
+#define FLOOD_FILL_HPP
+
+#include <optional>
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+
+#include "framebuffer.hpp"
+#include "program.hpp"
+#include "texture_2d.hpp"
+#include "render/renderer.hpp"
+
+#include "image/dirty_region.hpp"
+
+/**
+ * Region of pixels connected to a seed & within a tolerance of its color (4-connectivity), grown on gpu
+ * Ping-pong passes alternating rows & columns, each one growing region over up to `RADIUS` similar pixels,
+ * scissored to the bounds region can have reached so far (cost scales with region, image never read back)
+ * Growth stops once an occlusion query, read every `N_PASSES_CHECK` passes, counts as many pixels as before
+ * Positions in image pixels with origin at upper-left corner (i.e. rows of texture)
+ */
+class FloodFill {
+public:
+  static const int RADIUS = 32;
+  static const int N_PASSES_CHECK = 8;
+
+  /* avoids endless growth in pathological cases (e.g. a spiral one pixel wide) */
+  static const int N_PASSES_MAX = 4096;
+
+  FloodFill();
+  bool grow(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& image, int x, int y, float tolerance);
+  void fill(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& target, const glm::vec4& color);
+
+  const Texture2D& get_mask() const;
+  const DirtyRegion::Rect& get_rect() const;
+  unsigned int get_n_passes() const;
+  void free();
+
+private:
+  /* grows region (ping-pong between two r8 textures) & paints it (compiled on first use) */
+  std::optional<Program> m_program_grow;
+  std::optional<Program> m_program_fill;
+
+  /* masks of image's size (from pool), `m_i_mask` holds last region grown */
+  std::optional<Texture2D> m_masks[2];
+  size_t m_i_mask;
+
+  /* bounds region can have reached (mask undefined outside them) */
+  DirtyRegion::Rect m_rect;
+
+  GLuint m_query;
+  unsigned int m_n_passes;
+
+  void init();
+  void acquire(int width, int height);
+};
+
+#endif // FLOOD_FILL_HPP
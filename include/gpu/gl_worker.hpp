@@ -0,0 +1,45 @@
+#ifndef GL_WORKER_HPP
+#define GL_WORKER_HPP
+
+#include <memory>
+#include <atomic>
+#include <functional>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "jobs/worker.hpp"
+
+/**
+ * Worker thread owning a hidden gl context shared with main window's one (textures, buffers & syncs are shared,
+ * fbos & vaos aren't), so uploads & readbacks don't compete with ui rendering on main thread
+ * Each task waits on a fence of commands issued by main thread before it was submitted (e.g. texture allocation),
+ * & is fenced in turn so main thread knows when its results are visible (`is_done()`)
+ * Unavailable (callers fall back to main thread) if shared context couldn't be created, or before `init()`
+ */
+class GlWorker {
+public:
+  struct Ticket {
+    std::atomic<bool> is_run;
+    GLsync fence;
+
+    Ticket();
+    ~Ticket();
+  };
+
+  GlWorker();
+  bool init(GLFWwindow* window_main);
+  bool is_available() const;
+  std::shared_ptr<Ticket> submit(const std::function<void()>& task);
+  static bool is_done(Ticket& ticket);
+  static void wait(Ticket& ticket);
+  void free();
+
+  static GlWorker& get();
+
+private:
+  GLFWwindow* m_window;
+  std::unique_ptr<Worker> m_worker;
+};
+
+#endif // GL_WORKER_HPP
@@ -0,0 +1,41 @@
+#ifndef GPU_RESOURCES_HPP
+#define GPU_RESOURCES_HPP
+
+#include <map>
+#include <memory>
+#include <optional>
+
+#include "nanovg.h"
+
+#include "render/renderer.hpp"
+
+#include "effects/program_table.hpp"
+
+/**
+ * Gl objects shared by all documents (canvases) of a gl context: shaders programs, nanovg context,
+ * renderer's buffers & surface geometry, so each document only owns its textures & framebuffers
+ * Created on first use with the context current, freed once by frame (not by canvases)
+ * Renderer's program is set by each canvas to its view shader before drawing with it
+ */
+class GpuResources {
+public:
+  ProgramTable& get_programs();
+  Renderer& get_renderer();
+  NVGcontext* get_vg();
+  void free();
+
+  static GpuResources& get();
+
+private:
+  /* programs compiled on first use (table shared by view & effects shaders) */
+  ProgramTable m_programs;
+  std::optional<Renderer> m_renderer;
+  NVGcontext* m_vg;
+
+  /* registries keyed by gl context (e.g. bench runs frames on successive windows) */
+  static std::map<void*, std::unique_ptr<GpuResources>> m_registries;
+
+  GpuResources();
+};
+
+#endif // GPU_RESOURCES_HPP
@@ -0,0 +1,46 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include "glad/glad.h"
+
+#include "texture_2d.hpp"
+
+/* Per-channel histogram of a texture, with min/max/mean derived from it (exact, unlike a mip reduction) */
+struct ImageStats {
+  static const int N_BINS = 256;
+
+  int width;
+  int height;
+  int n_channels;
+  unsigned int bins[4][N_BINS];
+  int min[4];
+  int max[4];
+  float mean[4];
+};
+
+/**
+ * Histogram computed on gpu with a compute shader (GL >= 4.3), so image is never read back
+ * Only bins (4KB) are copied to cpu, once a fence tells the dispatch is done (polled each frame)
+ */
+class Histogram {
+public:
+  Histogram();
+  bool has_failed() const;
+  bool request(const Texture2D& texture);
+  bool poll(ImageStats& stats);
+  bool is_pending() const;
+  void free();
+
+private:
+  /* must match `local_size_x/y` in compute shader */
+  static const int SIZE_GROUP = 16;
+
+  GLuint m_program;
+  GLuint m_buffer;
+  GLsync m_fence;
+  int m_width;
+  int m_height;
+  int m_n_channels;
+};
+
+#endif // HISTOGRAM_HPP
@@ -0,0 +1,68 @@
+#ifndef IMAGE_COMPARISON_HPP
+#define IMAGE_COMPARISON_HPP
+
+#include <optional>
+
+#include "glad/glad.h"
+
+#include "framebuffer.hpp"
+#include "texture_2d.hpp"
+#include "render/renderer.hpp"
+
+#include "effects/program_table.hpp"
+#include "image/similarity.hpp"
+
+/* Views of compare mode (values of `compare.frag`'s `view`) */
+enum class CompareView {
+  NONE,       // compare mode left
+  DIFFERENCE, // per-channel absolute difference (scaled by gain)
+  HEATMAP,    // magnitude of difference from blue to red
+  FLICKER,    // image & reference alternated
+};
+
+/**
+ * Image compared on gpu to a reference texture: views rendered by a fragment shader into a texture shown instead of image
+ * Metrics (mse/psnr/ssim) reduced by two compute passes (GL >= 4.3): one group per ssim window, then one over windows,
+ * so only two scalars are read back, once a fence tells the dispatch is done (polled each frame, like `Histogram`)
+ */
+class ImageComparison {
+public:
+  /* duration of each image in flicker view (sec) */
+  static constexpr float PERIOD_FLICKER = 0.5f;
+
+  /* errors of a few levels made visible in difference & heatmap views */
+  static constexpr float GAIN_DEFAULT = 4.0f;
+
+  ImageComparison(ProgramTable& programs);
+  const Texture2D& render(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& texture,
+                          const Texture2D& reference, CompareView view, float gain, bool is_reference);
+  bool has_metrics() const;
+  bool request(const Texture2D& texture, const Texture2D& reference);
+  bool poll(Similarity& similarity);
+  bool is_pending() const;
+  void free();
+
+private:
+  /* owner of view texture in memory panel */
+  static constexpr const char* OWNER = "comparison";
+
+  /* must match `SIZE_WINDOW` & `SIZE_GROUP` in compute shaders */
+  static const int SIZE_WINDOW = Similarity::SIZE_WINDOW;
+
+  /* `Shader::COMPARE` draws views (image sampled from unit 0 by renderer, reference from unit 1), shared by documents */
+  ProgramTable& m_programs;
+  std::optional<Texture2D> m_texture_view;
+
+  /* compute passes & their buffers (partials resized to # of windows) */
+  GLuint m_program_windows;
+  GLuint m_program_reduce;
+  GLuint m_buffer_partials;
+  GLuint m_buffer_totals;
+  size_t m_n_partials_max;
+  GLsync m_fence;
+  int m_width;
+  int m_height;
+  int m_n_windows;
+};
+
+#endif // IMAGE_COMPARISON_HPP
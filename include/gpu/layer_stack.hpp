@@ -0,0 +1,92 @@
+#ifndef LAYER_STACK_HPP
+#define LAYER_STACK_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+
+#include "glad/glad.h"
+
+#include "framebuffer.hpp"
+#include "texture_2d.hpp"
+#include "render/renderer.hpp"
+
+#include "effects/program_table.hpp"
+#include "image/depth.hpp"
+#include "image/dirty_region.hpp"
+#include "history/history.hpp"
+
+/**
+ * Image layer (index 0, texture owned by canvas) & annotation layers drawn over it, each with opacity & visibility
+ * Annotation layers are rgba8 textures (transparent initially) drawn on premultiplied by nanovg & stamp brush
+ * Layers composited on gpu into a cached texture, re-blended only over region changed since last composite
+ * Layers below & above active one are pre-merged, so painting costs at most 3 blends whatever the # of layers
+ * (a single one when active layer is the top one & the image is visible)
+ */
+class LayerStack {
+public:
+  struct Layer {
+    std::string name;
+    Texture2D texture;
+    float opacity;
+    bool is_visible;
+
+    /* undo/redo of shapes drawn on annotation layer (NULL for image layer, recorded by canvas) */
+    std::unique_ptr<History> history;
+
+    /* pixels kept on cpu while document is evicted from vram */
+    std::vector<unsigned char> pixels_evicted;
+  };
+
+  LayerStack(ProgramTable& programs, const Texture2D& image, Depth depth);
+  size_t add(Framebuffer& framebuffer);
+  void remove(size_t i_layer);
+  void set_active(size_t i_layer);
+  void set(size_t i_layer, float opacity, bool is_visible);
+
+  const Texture2D& composite(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& image, const DirtyRegion& dirty);
+  Layer& get_active();
+  size_t get_i_active() const;
+  const std::vector<Layer>& get_layers() const;
+  unsigned int get_n_blends() const;
+  size_t get_n_bytes() const;
+
+  void evict();
+  void restore();
+  void free();
+
+private:
+  /* owner of layer & composite textures in memory panel */
+  static constexpr const char* OWNER = "layers";
+
+  int m_width;
+  int m_height;
+  Depth m_depth;
+
+  std::vector<Layer> m_layers;
+  size_t m_i_active;
+  unsigned int m_n_added;
+
+  /* `Shader::LAYER` draws a layer scaled by its opacity (premultiplied output), shared by documents */
+  ProgramTable& m_programs;
+
+  /**
+   * Pre-merged layers below & above active one (unset if none of them is visible), re-merged when stack changes
+   * Composite (merged below, active, merged above) & revision of dirty region it's up-to-date with
+   */
+  std::optional<Texture2D> m_texture_below;
+  std::optional<Texture2D> m_texture_above;
+  std::optional<Texture2D> m_texture_composite;
+  bool m_is_merged;
+  bool m_is_composited;
+  unsigned int m_revision_composited;
+  unsigned int m_n_blends;
+
+  void invalidate();
+  void merge(size_t i_begin, size_t i_end, std::optional<Texture2D>& target, Renderer& renderer, Framebuffer& framebuffer);
+  void blend(Renderer& renderer, const Texture2D& texture, bool is_premultiplied, float opacity);
+  void release(std::optional<Texture2D>& texture);
+};
+
+#endif // LAYER_STACK_HPP
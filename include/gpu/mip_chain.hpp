@@ -0,0 +1,39 @@
+#ifndef MIP_CHAIN_HPP
+#define MIP_CHAIN_HPP
+
+#include "glad/glad.h"
+
+#include "texture_2d.hpp"
+#include "image/dirty_region.hpp"
+
+/**
+ * Mipmaps of displayed texture for zoomed-out views (avoids aliasing & fetching every texel)
+ * Only levels needed for current zoom are generated, & only when texture content changed
+ * Levels updated only over changed region (2:1 linear blits between levels) when drawing touched a part of texture
+ */
+class MipChain {
+public:
+  MipChain();
+  void update(const Texture2D& texture, const DirtyRegion& dirty, float zoom, int margin=0);
+  unsigned int get_n_generated() const;
+  unsigned int get_n_skipped() const;
+  unsigned int get_n_partial() const;
+  void free();
+
+private:
+  /* texture & revision of dirty region mipmaps were last generated for */
+  GLuint m_id_texture;
+  unsigned int m_revision;
+  int m_level_max;
+
+  /* read & draw fbos for blits between levels (created on first partial update) */
+  GLuint m_fbos[2];
+
+  unsigned int m_n_generated;
+  unsigned int m_n_skipped;
+  unsigned int m_n_partial;
+
+  void downsample(const Texture2D& texture, const DirtyRegion::Rect& rect);
+};
+
+#endif // MIP_CHAIN_HPP
@@ -0,0 +1,93 @@
+#ifndef OWNED_HPP
+#define OWNED_HPP
+
+#include <optional>
+#include <utility>
+
+/**
+ * Move-only owner of a resource of opengl-utils (`Image`, `Texture2D`, `Framebuffer`), whose handles are copyable
+ * structs freed by hand: resource freed once when its owner goes out of scope, incl. on early returns & exceptions
+ * (e.g. `ShaderException` thrown by a later compile), & copies of the handle can't free it twice
+ * Code using the resource takes a `const T&` from `get()` (non-owning view, handle isn't copied)
+ * @param Release Called on resource to free it (`free()` by default, e.g. `ImageUtils::free` for pooled pixels)
+ */
+template <typename T>
+class Owned {
+public:
+  using Release = void (*)(T&);
+
+  Owned():
+    m_resource(),
+    m_release(&release_default)
+  {
+  }
+
+  explicit Owned(const T& resource, Release release=&release_default):
+    m_resource(resource),
+    m_release(release)
+  {
+  }
+
+  Owned(Owned&& other) noexcept:
+    m_resource(std::move(other.m_resource)),
+    m_release(other.m_release)
+  {
+    other.m_resource.reset();
+  }
+
+  Owned& operator=(Owned&& other) noexcept {
+    if (this != &other) {
+      reset();
+      m_resource = std::move(other.m_resource);
+      m_release = other.m_release;
+      other.m_resource.reset();
+    }
+
+    return *this;
+  }
+
+  Owned(const Owned&) = delete;
+  Owned& operator=(const Owned&) = delete;
+
+  ~Owned() {
+    reset();
+  }
+
+  const T& get() const {
+    return *m_resource;
+  }
+
+  const T* operator->() const {
+    return &*m_resource;
+  }
+
+  explicit operator bool() const {
+    return m_resource.has_value();
+  }
+
+  /* Give up ownership (e.g. texture handed over to a member freed by hand) */
+  T release() {
+    T resource = *m_resource;
+    m_resource.reset();
+    return resource;
+  }
+
+  /* Free resource now (no-op if none is owned) */
+  void reset() {
+    if (!m_resource)
+      return;
+
+    m_release(*m_resource);
+    m_resource.reset();
+  }
+
+private:
+  std::optional<T> m_resource;
+  Release m_release;
+
+  static void release_default(T& resource) {
+    resource.free();
+  }
+};
+
+#endif // OWNED_HPP
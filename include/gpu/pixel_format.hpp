@@ -0,0 +1,24 @@
+#ifndef PIXEL_FORMAT_HPP
+#define PIXEL_FORMAT_HPP
+
+#include "glad/glad.h"
+
+#include "texture_2d.hpp"
+#include "image/depth.hpp"
+
+/**
+ * Opengl formats of textures by # of channels & depth
+ * 3-channel 16-bit textures stored as rgba (rgb16 & rgb16f aren't required to be renderable, drivers pad them anyway)
+ * 1 & 2-channel textures kept as r/rg & sampled as gray (& alpha) through a swizzle mask (opengl >= 3.3)
+ */
+namespace PixelFormat {
+  GLenum get_format_sized(int n_channels, Depth depth);
+  GLenum get_type(Depth depth);
+  int get_n_bytes_channel(Depth depth);
+  const char* get_name(Depth depth);
+  int get_n_channels(const Texture2D& texture);
+  bool has_swizzle();
+  void swizzle_gray(const Texture2D& texture);
+};
+
+#endif // PIXEL_FORMAT_HPP
@@ -0,0 +1,69 @@
+#ifndef PIXEL_READER_HPP
+#define PIXEL_READER_HPP
+
+#include <vector>
+#include <memory>
+#include <optional>
+
+#include "glad/glad.h"
+
+#include "framebuffer.hpp"
+#include "texture_2d.hpp"
+
+#include "gpu/gl_worker.hpp"
+
+/* Pixels read from fbo region, available some frames after being requested */
+struct Readback {
+  int x;
+  int y;
+  int width;
+  int height;
+  int n_channels;
+  std::vector<unsigned char> data;
+};
+
+/**
+ * Asynchronous readback of fbo regions through a ring of pixel buffer objects (PBO)
+ * `glReadPixels()` into a bound PBO returns immediately, a fence tells when the copy is done on the gpu,
+ * so results are retrieved (with `poll()`) one or two frames later without stalling the cpu
+ * Whole textures are read on `GlWorker` when available (fbos aren't shared, so regions are read on main thread),
+ * from a snapshot copied on main context, which also moves the copy of pixels to cpu memory off main thread
+ */
+class PixelReader {
+public:
+  PixelReader(int n_buffers=3);
+  bool request(const Framebuffer& framebuffer, int x, int y, int width, int height, int n_channels);
+  bool request(const Texture2D& texture);
+  bool poll(Readback& readback);
+  bool wait(Readback& readback);
+  bool is_pending() const;
+  void free();
+
+private:
+  /* one slot in ring of PBOs */
+  struct Slot {
+    GLuint pbo;
+    GLsizeiptr size;
+    GLsync fence;
+    Readback readback;
+
+    /* readback on worker's shared context of a snapshot of texture (pooled), written into `data_worker` */
+    std::shared_ptr<GlWorker::Ticket> ticket;
+    std::shared_ptr<std::vector<unsigned char>> data_worker;
+    std::optional<Texture2D> snapshot;
+  };
+
+  std::vector<Slot> m_slots;
+
+  /* next slot to write to & oldest pending slot to read from */
+  int m_i_write;
+  int m_i_read;
+  int m_n_pending;
+
+  Slot* begin_request(int x, int y, int width, int height, int n_channels, bool has_pbo=true);
+  void end_request(Slot* slot);
+  bool read(Slot& slot, Readback& readback);
+  void release_snapshot(Slot& slot);
+};
+
+#endif // PIXEL_READER_HPP
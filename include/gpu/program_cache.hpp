@@ -0,0 +1,40 @@
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+/**
+ * Programs built from shaders sources, with their linked binaries cached on disk (`glGetProgramBinary()`)
+ * Cache entries keyed by sources & driver (vendor, renderer & version), so an updated driver recompiles them
+ * Builds are split in `start()` & `finish()`: with `KHR_parallel_shader_compile` the driver compiles in background
+ * meanwhile & `is_ready()` tells when `finish()` won't block
+ */
+namespace ProgramCache {
+  /* shader stage & path of its source */
+  struct Source {
+    GLenum type;
+    std::string path;
+  };
+
+  /* program being compiled/linked (or loaded from binary) */
+  struct Build {
+    GLuint program;
+    std::vector<GLuint> shaders;
+    std::string name;
+    std::string path_binary;
+    bool is_binary;
+  };
+
+  bool start(const std::vector<Source>& sources, Build& build);
+  bool is_ready(const Build& build);
+  GLuint finish(Build& build);
+  GLuint load(const std::vector<Source>& sources);
+
+  bool has_parallel_compile();
+  std::string get_dir_cache();
+};
+
+#endif // PROGRAM_CACHE_HPP
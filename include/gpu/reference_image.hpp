@@ -0,0 +1,47 @@
+#ifndef REFERENCE_IMAGE_HPP
+#define REFERENCE_IMAGE_HPP
+
+#include <string>
+#include <memory>
+#include <atomic>
+
+#include "image.hpp"
+#include "texture_2d.hpp"
+
+#include "image/block_encoder.hpp"
+#include "jobs/worker.hpp"
+
+/**
+ * Read-only image displayed from a block-compressed texture (4-8x less vram than rgba, no effects texture)
+ * Exact pixel values come from an uncompressed cpu copy, decoded on a worker on first query (unless already decoded)
+ */
+class ReferenceImage {
+public:
+  static bool is_supported(BlockEncoder::Codec codec);
+
+  ReferenceImage(const BlockEncoder::Blocks& blocks, const std::string& path, const std::shared_ptr<Image>& image);
+  const Texture2D& get_texture() const;
+  const Image* get_image_async(Worker& worker);
+  std::shared_ptr<Image> get_image();
+
+  int get_width() const;
+  int get_height() const;
+  size_t get_n_bytes() const;
+  void free();
+
+private:
+  Texture2D m_texture;
+  std::string m_path;
+  size_t m_n_bytes;
+
+  /* cpu copy shared with decoding task (image set before `is_loaded`) */
+  struct Pixels {
+    std::shared_ptr<Image> image;
+    std::atomic<bool> is_requested;
+    std::atomic<bool> is_loaded;
+  };
+
+  std::shared_ptr<Pixels> m_pixels;
+};
+
+#endif // REFERENCE_IMAGE_HPP
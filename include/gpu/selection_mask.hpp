@@ -0,0 +1,56 @@
+#ifndef SELECTION_MASK_HPP
+#define SELECTION_MASK_HPP
+
+#include <vector>
+#include <optional>
+
+#include "glad/glad.h"
+
+#include "framebuffer.hpp"
+#include "program.hpp"
+#include "texture_2d.hpp"
+#include "render/renderer.hpp"
+
+#include "image/dirty_region.hpp"
+
+/**
+ * Rectangle or lasso selection restricting effects to a region of image
+ * Mask (1 inside polygon, 0 outside) rasterized on cpu over the polygon's bounding box only & uploaded as a r8 texture,
+ * so its cost, like the one of effect passes scissored to the box, scales with the area selected
+ * Positions in image pixels with origin at upper-left corner (i.e. rows of texture)
+ */
+class SelectionMask {
+public:
+  /* position in image pixels (kept free of ui types, as headless batch links effects chain too) */
+  struct Vertex {
+    float x, y;
+  };
+
+  SelectionMask();
+  bool set(const std::vector<Vertex>& polygon, int width, int height);
+  void set(Framebuffer& framebuffer, const Texture2D& mask, const DirtyRegion::Rect& rect);
+  void clear();
+
+  bool is_empty() const;
+  const DirtyRegion::Rect& get_rect() const;
+  const std::vector<Vertex>& get_polygon() const;
+
+  void blend(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& input, const Texture2D& effects,
+             const Texture2D& target);
+  void free();
+
+private:
+  std::vector<Vertex> m_polygon;
+  DirtyRegion::Rect m_rect;
+  std::optional<Texture2D> m_texture;
+
+  /* mixes effects' output with their input accord. to mask (compiled on first selection) */
+  std::optional<Program> m_program;
+  GLint m_location_texture_input;
+  GLint m_location_mask;
+  GLint m_location_origin_mask;
+
+  void rasterize(std::vector<unsigned char>& coverages) const;
+};
+
+#endif // SELECTION_MASK_HPP
@@ -0,0 +1,95 @@
+#ifndef SEQUENCE_PLAYER_HPP
+#define SEQUENCE_PLAYER_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "glad/glad.h"
+
+#include "image.hpp"
+#include "texture_2d.hpp"
+#include "jobs/bounded_queue.hpp"
+
+/**
+ * Plays a numbered image sequence (e.g. "shot_0001.png", "shot_0002.png", ...) in a loop at a fixed frame rate
+ * Background thread decodes frames ahead into a ring of `N_FRAMES_RING` (blocks when it's full)
+ * Frame due at current time uploaded through two pixel buffer objects used in turn
+ * (next frame copied into one while the driver may still be transferring the previous one from the other)
+ * Frames decoded too late are shown anyway & clock shifted (playback slows down instead of showing nothing),
+ * frames overtaken by time skipped: both counted as dropped
+ * Unreadable frames skipped, & playback stopped by decoder once a whole pass over sequence failed (see `has_failed()`)
+ */
+class SequencePlayer {
+public:
+  /* frames decoded ahead of the one shown (~ 1/3 sec at 24 fps) */
+  static const int N_FRAMES_RING = 8;
+  static const int FPS_DEFAULT = 24;
+
+  /* counters of player updated last (shown by performance overlay) */
+  struct Stats {
+    bool is_playing;
+    int fps;
+    int n_frames;
+    int i_frame;
+    unsigned int n_shown;
+    unsigned int n_dropped;
+    int n_buffered;
+    float duration_decode;
+    float duration_decode_max;
+  };
+
+  static Stats stats;
+
+  SequencePlayer();
+  bool start(const std::string& path, int fps=FPS_DEFAULT);
+  std::shared_ptr<Image> get_frame();
+  void upload(const Texture2D& texture, const Image& frame);
+  void stop();
+  bool is_playing() const;
+  bool has_failed() const;
+  unsigned int get_n_shown() const;
+  void free();
+
+  static std::vector<std::string> list_frames(const std::string& path);
+
+private:
+  /* decoded frame, its index counted from start of playback (increases across loops) */
+  struct Frame {
+    int index;
+    std::shared_ptr<Image> image;
+  };
+
+  std::vector<std::string> m_paths;
+  int m_fps;
+
+  std::thread m_thread;
+  std::unique_ptr<BoundedQueue<Frame>> m_frames;
+
+  /* frame popped before it was due */
+  Frame m_frame_next;
+
+  /* time slot (in frames since start) of last frame shown */
+  std::chrono::steady_clock::time_point m_time_start;
+  int m_i_slot;
+  unsigned int m_n_shown;
+  unsigned int m_n_dropped;
+
+  /* decode times of last frame & max. so far in ms (written by decoder thread) */
+  std::atomic<float> m_duration_decode;
+  std::atomic<float> m_duration_decode_max;
+
+  /* no frame of sequence could be decoded (set by decoder thread before it closes ring) */
+  std::atomic<bool> m_has_failed;
+
+  GLuint m_pbos[2];
+  int m_i_pbo;
+
+  void decode();
+  void update_stats();
+};
+
+#endif // SEQUENCE_PLAYER_HPP
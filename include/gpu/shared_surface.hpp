@@ -0,0 +1,74 @@
+#ifndef SHARED_SURFACE_HPP
+#define SHARED_SURFACE_HPP
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+
+#include "texture_2d.hpp"
+
+#include "gpu/gl_worker.hpp"
+
+/**
+ * Canvas output published into a named posix shared-memory object, read by other processes without copies nor files
+ * (opt-in with `--share <name>`, e.g. "/imgui-example" for `/dev/shm/imgui-example`)
+ * Single object for the app: active document publishes its output whenever it changed (or another one became active)
+ * Memory starts with `Header`, followed by tightly packed 8-bit rows (origin at lower-left corner, as in opengl)
+ * Texture read by `glGetTexImage()` straight into mapping (from a snapshot on `GlWorker` when available, otherwise
+ * on main thread)
+ * Sequence is odd while pixels are written: readers check it's even & unchanged after reading (seqlock),
+ * & remap when `n_bytes_mapping` grows (object resized for a larger image)
+ */
+class SharedSurface {
+public:
+  /* name of shared-memory object (empty: nothing published) */
+  static std::string name;
+
+  static constexpr char MAGIC[4] = { 'S', 'H', 'M', '1' };
+  static const size_t N_BYTES_HEADER = 64;
+
+  /* header at start of shared memory (fixed-size fields, native endianness) */
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    std::atomic<uint64_t> sequence;
+    uint32_t width;
+    uint32_t height;
+    uint32_t n_channels;
+    uint32_t n_bytes_row;
+    uint64_t n_bytes_mapping;
+  };
+
+  static_assert(sizeof(Header) <= N_BYTES_HEADER, "Header must fit before pixels");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "Sequence must be lock-free to be shared by processes");
+
+  bool is_current(const void* source, unsigned int revision) const;
+  bool publish(const Texture2D& texture, const void* source, unsigned int revision);
+  bool is_busy() const;
+  void free();
+
+  static SharedSurface& get();
+
+private:
+  int m_fd;
+  unsigned char* m_data;
+  size_t m_n_bytes;
+
+  /* document & its revision published last */
+  const void* m_source;
+  unsigned int m_revision;
+
+  /* publish running on gl worker (mapping not resized meanwhile) & copy of texture it reads */
+  std::shared_ptr<GlWorker::Ticket> m_ticket;
+  std::optional<Texture2D> m_snapshot;
+
+  SharedSurface();
+  bool map(size_t n_bytes);
+  Header* get_header() const;
+  void release_snapshot();
+};
+
+#endif // SHARED_SURFACE_HPP
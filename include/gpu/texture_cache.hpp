@@ -0,0 +1,51 @@
+#ifndef TEXTURE_CACHE_HPP
+#define TEXTURE_CACHE_HPP
+
+#include <string>
+#include <list>
+#include <optional>
+#include <unordered_map>
+
+#include "texture_2d.hpp"
+
+/**
+ * Textures of images already uploaded (e.g. neighbours of current image in folder), keyed by path
+ * Least recently used textures given back to `TexturePool` once total size exceeds the vram budget
+ */
+class TextureCache {
+public:
+  /* owners in memory panel of cached textures & of those taken back (e.g. displayed image) */
+  static constexpr const char* OWNER = "prefetch cache";
+  static constexpr const char* OWNER_TAKEN = "canvas image";
+
+  TextureCache(size_t n_bytes_max=N_BYTES_MAX);
+  bool contains(const std::string& path) const;
+  void insert(const std::string& path, const Texture2D& texture);
+  std::optional<Texture2D> take(const std::string& path);
+  void touch(const std::string& path);
+  void set_n_bytes_max(size_t n_bytes_max);
+  size_t get_n_bytes() const;
+  size_t get_size() const;
+  void free();
+
+private:
+  /* default vram budget */
+  static const size_t N_BYTES_MAX = 512 * 1024 * 1024;
+
+  struct Entry {
+    std::string path;
+    Texture2D texture;
+    size_t n_bytes;
+  };
+
+  size_t m_n_bytes_max;
+  size_t m_n_bytes;
+
+  /* most recently used first */
+  std::list<Entry> m_entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_iterators;
+
+  void evict();
+};
+
+#endif // TEXTURE_CACHE_HPP
@@ -0,0 +1,73 @@
+#ifndef TEXTURE_POOL_HPP
+#define TEXTURE_POOL_HPP
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <string>
+
+#include "glad/glad.h"
+
+#include "texture_2d.hpp"
+
+#include "image/depth.hpp"
+
+/**
+ * Textures recycled on image change, keyed by size, # of channels & depth (a same-size image reuses the storage)
+ * Storage is immutable (`glTexStorage2D()`) when supported, with a full mip chain, so uploads are sub-image updates
+ * & drivers don't reallocate behind the scenes (textures not released to the pool can still be freed directly)
+ * Textures registered in `MemoryTracker` under owner given on acquire (owner of released ones is the pool)
+ */
+class TexturePool {
+public:
+  struct Stats {
+    size_t n_hits;
+    size_t n_misses;
+    size_t n_bytes_cached;
+  };
+
+  TexturePool(size_t n_bytes_cached_max=N_BYTES_CACHED_MAX);
+  Texture2D acquire(int width, int height, int n_channels, Depth depth=Depth::UNORM8, const std::string& owner=OWNER);
+  void release(const Texture2D& texture);
+  Depth get_depth(const Texture2D& texture) const;
+  Stats get_stats() const;
+  void trim();
+  void free();
+
+  static TexturePool& get();
+
+private:
+  /* released textures beyond this total size are freed (oldest first) */
+  static const size_t N_BYTES_CACHED_MAX = 256 * 1024 * 1024;
+
+  /* owner of released textures in memory panel (& of acquired ones by default) */
+  static constexpr const char* OWNER = "texture pool";
+
+  /* width, height, # of channels & depth */
+  using Key = std::tuple<int, int, int, Depth>;
+
+  struct Entry {
+    Texture2D texture;
+    size_t n_bytes;
+    unsigned int i_released;
+  };
+
+  size_t m_n_bytes_cached_max;
+  std::map<Key, std::vector<Entry>> m_buckets;
+
+  /* # of channels & depth of textures handed out (not stored in `Texture2D`) */
+  struct Format {
+    int n_channels;
+    Depth depth;
+  };
+
+  std::map<GLuint, Format> m_formats;
+
+  Stats m_stats;
+  unsigned int m_i_released;
+
+  static size_t get_n_bytes(int width, int height, Depth depth);
+  void evict();
+};
+
+#endif // TEXTURE_POOL_HPP
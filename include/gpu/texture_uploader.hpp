@@ -0,0 +1,62 @@
+#ifndef TEXTURE_UPLOADER_HPP
+#define TEXTURE_UPLOADER_HPP
+
+#include <memory>
+#include <atomic>
+
+#include "glad/glad.h"
+
+#include "image.hpp"
+#include "texture_2d.hpp"
+
+#include "image/depth.hpp"
+#include "gpu/gl_worker.hpp"
+
+/**
+ * Streams image pixels into an already allocated texture through a pixel buffer object (PBO)
+ * Image uploaded in bands of rows (one band per call to `update()`), so large images don't stall a single frame
+ * Bands go through the shared `UploadRing` when buffer storage is supported (no map/unmap per band)
+ * With a shared context on `GlWorker`, whole image is uploaded there instead (band by band, so it can be cancelled)
+ * & `update()` only polls its fence
+ */
+class TextureUploader {
+public:
+  TextureUploader(size_t size_band=SIZE_BAND);
+  void start(const Texture2D& texture, const std::shared_ptr<Image>& image, Depth depth=Depth::UNORM8);
+  bool update();
+  void cancel();
+  bool is_busy() const;
+  float get_progress() const;
+  void free();
+
+private:
+  /* max. # of bytes uploaded per frame */
+  static const size_t SIZE_BAND = 16 * 1024 * 1024;
+
+  GLuint m_pbo;
+  size_t m_size_band;
+
+  /* destination texture */
+  GLuint m_id_texture;
+  GLenum m_format;
+  GLenum m_type;
+
+  std::shared_ptr<Image> m_image;
+  size_t m_n_bytes_row;
+  int m_n_rows_band;
+  int m_i_row;
+
+  /* upload running on `GlWorker` (rows uploaded so far shared with worker thread) */
+  struct Upload {
+    std::atomic<int> i_row;
+    std::atomic<bool> is_cancelled;
+  };
+
+  std::shared_ptr<GlWorker::Ticket> m_ticket;
+  std::shared_ptr<Upload> m_upload;
+
+  void upload_pbo(int n_rows);
+  void start_worker();
+};
+
+#endif // TEXTURE_UPLOADER_HPP
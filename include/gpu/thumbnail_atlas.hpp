@@ -0,0 +1,65 @@
+#ifndef THUMBNAIL_ATLAS_HPP
+#define THUMBNAIL_ATLAS_HPP
+
+#include <string>
+#include <list>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+
+#include "framebuffer.hpp"
+#include "texture_2d.hpp"
+
+/**
+ * Small thumbnails packed into slots of a single texture, keyed by path (e.g. strip of open & recent images)
+ * Drawing all of them then binds one texture, & imgui merges them into one draw command
+ * Thumbnail rendered on gpu from a displayed texture (no decode): box-filtered 2:1 passes through pooled textures
+ * (i.e. mip levels computed on the side, so texture's own mipmaps are left as they are), then drawn into its slot
+ * Least recently captured thumbnail replaced when all slots are taken, last slot left gray for placeholders
+ */
+class ThumbnailAtlas {
+public:
+  /* side of square slots in atlas pixels (thumbnail fitted inside, keeping aspect ratio) */
+  static const int SIZE_SLOT = 96;
+  static const int N_SLOTS_X = 8;
+  static const int N_SLOTS_Y = 4;
+  static constexpr const char* OWNER = "thumbnail atlas";
+
+  /* thumbnail's region of atlas in uv (origin at first row, as expected by `ImGui::Image()`) */
+  struct Region {
+    float u_min;
+    float v_min;
+    float u_max;
+    float v_max;
+  };
+
+  ThumbnailAtlas();
+  void create();
+  bool capture(const std::string& path, const Texture2D& texture);
+  bool contains(const std::string& path) const;
+  Region get_region(const std::string& path) const;
+  void remove(const std::string& path);
+  GLuint get_id() const;
+  void free();
+
+private:
+  struct Entry {
+    std::string path;
+    int i_slot;
+    int width;
+    int height;
+  };
+
+  std::optional<Texture2D> m_texture;
+  std::optional<Framebuffer> m_framebuffer;
+
+  /* most recently captured first, & slots not taken yet (reset with atlas texture) */
+  std::list<Entry> m_entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_iterators;
+  std::vector<int> m_slots_free;
+
+  int take_slot();
+  void draw(const Texture2D& source, const Texture2D& target, int x, int y, int width, int height);
+};
+
+#endif // THUMBNAIL_ATLAS_HPP
@@ -0,0 +1,51 @@
+#ifndef TILE_SCHEDULER_HPP
+#define TILE_SCHEDULER_HPP
+
+#include "glad/glad.h"
+
+/**
+ * Per-frame budget of gpu work split into tiles (e.g. effects chain on a 16K image), so a long job runs over several
+ * frames instead of stalling one of them (or tripping the driver's watchdog)
+ * Tiles of a frame timed by a pair of `GL_TIMESTAMP` queries read once available (a frame or two later, cpu never
+ * waits), so timing also works inside another timer's `GL_TIME_ELAPSED` query (e.g. `Benchmark::measure_gpu()`),
+ * cost of a tile smoothed over frames & # of tiles of next frames set so their cost fits in `budget`
+ */
+class TileScheduler {
+public:
+  /* gpu time per frame given to tiled jobs in ms (0: jobs run at once whatever their cost) */
+  static float budget;
+
+  /* side of square tiles in pixels */
+  static const int SIZE_TILE = 512;
+
+  TileScheduler();
+  bool is_enabled() const;
+  int get_n_tiles_frame();
+  void begin();
+  void end(int n_tiles);
+  float get_duration();
+  float get_duration_tile() const;
+  void free();
+
+private:
+  /* tiles per frame until a first measure is read, & upper bound whatever their cost */
+  static const int N_TILES_INITIAL = 4;
+  static const int N_TILES_MAX = 1024;
+
+  /* weight of new measure in smoothed cost of a tile */
+  static constexpr float WEIGHT_MEASURE = 0.25f;
+
+  /* timestamps before & after tiles of measured frame */
+  GLuint m_queries[2];
+  bool m_is_pending;
+  bool m_is_open;
+  int m_n_tiles_timed;
+
+  /* gpu time of last frame's tiles & smoothed cost of a tile in ms (negative until measured) */
+  float m_duration;
+  float m_duration_tile;
+
+  void read();
+};
+
+#endif // TILE_SCHEDULER_HPP
@@ -0,0 +1,101 @@
+#ifndef TILED_IMAGE_HPP
+#define TILED_IMAGE_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <list>
+#include <set>
+#include <vector>
+#include <functional>
+
+#include "imgui.h"
+
+#include "image.hpp"
+#include "texture_2d.hpp"
+#include "framebuffer.hpp"
+#include "render/renderer.hpp"
+
+#include "image/image_vg.hpp"
+#include "image/pyramid_file.hpp"
+
+/**
+ * Virtual texture for images larger than `GL_MAX_TEXTURE_SIZE`
+ * Full-resolution pixels kept on cpu, split into fixed-size gpu tiles uploaded only when visible
+ * Least-recently used tiles evicted when more than `n_tiles_max` are resident (painted ones written back first)
+ * Each resident tile has its own shapes texture (drawn on with nanovg) & effects texture (rendered with shader)
+ * Pixels either from a cpu image, or decoded lazily from a pyramid file (coarser level shown when zoomed out,
+ * tiles painted at full resolution kept on cpu & drawn over it)
+ */
+class TiledImage {
+public:
+  static const int SIZE_TILE = 512;
+
+  TiledImage(const std::shared_ptr<Image>& image, int n_tiles_max=N_TILES_MAX);
+  TiledImage(const std::shared_ptr<PyramidFile>& pyramid, int n_tiles_max=N_TILES_MAX);
+  void render(Renderer& renderer, Framebuffer& framebuffer, bool has_effects, float zoom, const ImVec2& origin,
+              const ImVec2& position_visible, const ImVec2& size_visible);
+  void invalidate();
+
+  void draw_circle(ImageVG& image_vg, Framebuffer& framebuffer, float x, float y);
+  void draw_line(ImageVG& image_vg, Framebuffer& framebuffer, float x1, float y1, float x2, float y2);
+
+  const Texture2D* attach_tile(Framebuffer& framebuffer, bool has_effects, int x, int y, ImVec2& origin_tile);
+  std::shared_ptr<Image> get_image();
+
+  int get_width() const;
+  int get_height() const;
+  int get_n_resident() const;
+  void free();
+
+private:
+  /* 256 tiles of 512x512 RGBA (with effects texture) ~ 512 MB of vram */
+  static const int N_TILES_MAX = 256;
+
+  /* gpu copy of image region at (x, y) in full-resolution pixels (origin at upper-left corner) of a pyramid level */
+  struct Tile {
+    int x;
+    int y;
+    int level;
+    Texture2D texture_shapes;
+    Texture2D texture_effects;
+    unsigned int revision_effects;
+    bool is_painted;
+    unsigned int frame_used;
+    std::list<int>::iterator it_lru;
+  };
+
+  std::shared_ptr<Image> m_image;
+  std::shared_ptr<PyramidFile> m_pyramid;
+  int m_width;
+  int m_height;
+  int m_n_channels;
+  int m_n_tiles_max;
+
+  /* tiles & their first index per level (only full resolution for a cpu image) */
+  std::vector<PyramidFile::Level> m_levels;
+
+  /* rows of painted full-resolution tiles of pyramid (evicted ones) & all painted tiles' indices */
+  std::unordered_map<int, std::vector<unsigned char>> m_painted;
+  std::set<int> m_indices_painted;
+
+  /* resident tiles by index (across levels) & their usage order (most recent first) */
+  std::unordered_map<int, Tile> m_tiles;
+  std::list<int> m_lru;
+
+  /* effects re-rendered on tiles with an older revision */
+  unsigned int m_revision;
+  unsigned int m_frame;
+
+  int get_index(int level, int i_tile_x, int i_tile_y) const;
+  int get_level(float zoom) const;
+  Tile& get_tile(int level, int i_tile_x, int i_tile_y, const unsigned char* data_decoded=NULL);
+  void decode_tiles(int level, int i_tile_x_min, int i_tile_y_min, int i_tile_x_max, int i_tile_y_max);
+  void read_tile(int level, int i_tile_x, int i_tile_y, unsigned char* data) const;
+  void evict();
+  void write_back(Tile& tile);
+  void render_effects(Tile& tile, Renderer& renderer, Framebuffer& framebuffer);
+  void draw_region(float x_min, float y_min, float x_max, float y_max, ImageVG& image_vg, Framebuffer& framebuffer,
+                   const std::function<void(Tile&, float, float)>& draw);
+};
+
+#endif // TILED_IMAGE_HPP
@@ -0,0 +1,54 @@
+#ifndef UPLOAD_RING_HPP
+#define UPLOAD_RING_HPP
+
+#include <deque>
+
+#include "glad/glad.h"
+
+/**
+ * Persistently mapped pixel buffer (`ARB_buffer_storage`) used as a ring for texture uploads
+ * Pixels are written straight into gpu-visible memory, then copied to textures by the gpu from a buffer offset
+ * A fence per upload tells when its region can be overwritten, so writers only wait when ring is full
+ */
+class UploadRing {
+public:
+  /* region of ring handed out by `allocate()` (writable from any thread until passed to `upload()`) */
+  struct Region {
+    unsigned char* data;
+    size_t offset;
+    size_t size;
+  };
+
+  UploadRing(size_t size=SIZE);
+  bool is_supported() const;
+  bool allocate(size_t n_bytes, Region& region);
+  void upload(const Region& region, GLuint id_texture, int x, int y, int width, int height, GLenum format,
+              GLenum type=GL_UNSIGNED_BYTE);
+  void free();
+
+  static UploadRing& get();
+
+private:
+  /* ring large enough for a few bands of `TextureUploader` in flight */
+  static const size_t SIZE = 64 * 1024 * 1024;
+
+  /* offsets kept aligned for fast copies */
+  static const size_t ALIGNMENT = 256;
+
+  /* region read by gpu until fence is signaled */
+  struct Fence {
+    size_t begin;
+    size_t end;
+    GLsync sync;
+  };
+
+  GLuint m_pbo;
+  unsigned char* m_data;
+  size_t m_size;
+  size_t m_head;
+  std::deque<Fence> m_fences;
+
+  void wait(Fence& fence);
+};
+
+#endif // UPLOAD_RING_HPP
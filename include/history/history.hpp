@@ -0,0 +1,96 @@
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+#include <vector>
+#include <deque>
+#include <unordered_set>
+
+#include "glad/glad.h"
+
+#include "texture_2d.hpp"
+#include "image/depth.hpp"
+
+/**
+ * Undo/redo history recording only image tiles modified by each operation (copy-on-write)
+ * Tile content before first modification copied on the gpu into pooled atlas textures,
+ * then spilled to compressed cpu memory (oldest operations first) when gpu budget is exceeded
+ * Oldest operations forgotten when cpu budget is exceeded
+ * Atlas pages & compressed tiles registered in `MemoryTracker` (owner "undo history")
+ */
+class History {
+public:
+  static const int SIZE_TILE = 128;
+
+  History(size_t budget_gpu=BUDGET_GPU, size_t budget_cpu=BUDGET_CPU);
+  void reset(const Texture2D& texture, Depth depth=Depth::UNORM8);
+  void touch(float x_min, float y_min, float x_max, float y_max);
+  void commit();
+  bool undo();
+  bool redo();
+  void spill_all();
+  void rebind(const Texture2D& texture);
+
+  size_t get_n_undo() const;
+  size_t get_n_redo() const;
+  size_t get_size_gpu() const;
+  size_t get_size_cpu() const;
+  void set_budgets(size_t budget_gpu, size_t budget_cpu);
+  void free();
+
+private:
+  /* default budgets in bytes */
+  static const size_t BUDGET_GPU = 256 * 1024 * 1024;
+  static const size_t BUDGET_CPU = 1024 * 1024 * 1024;
+
+  /* atlas page of 16x16 tiles */
+  static const int N_TILES_PAGE = 16;
+  static const int SIZE_PAGE = N_TILES_PAGE * SIZE_TILE;
+
+  /* copy of a tile (origin at upper-left corner), either in atlas slot or compressed on cpu (slot = -1) */
+  struct Snapshot {
+    int x;
+    int y;
+    int width;
+    int height;
+    int slot;
+    std::vector<unsigned char> data;
+  };
+
+  /* tiles modified by one operation (e.g. brush stroke) */
+  using Entry = std::vector<Snapshot>;
+
+  size_t m_budget_gpu;
+  size_t m_budget_cpu;
+
+  /* texture whose modifications are recorded */
+  GLuint m_id_texture;
+  GLenum m_format;
+  GLenum m_format_sized;
+  GLenum m_type;
+  int m_width;
+  int m_height;
+  int m_n_bytes_pixel;
+
+  std::deque<Entry> m_undo;
+  std::deque<Entry> m_redo;
+  Entry m_entry;
+  std::unordered_set<int> m_tiles_entry;
+
+  /* atlas pages & free slots */
+  std::vector<GLuint> m_pages;
+  std::vector<int> m_slots_free;
+  GLuint m_fbo;
+  size_t m_size_cpu;
+
+  Snapshot capture(int x, int y, int width, int height);
+  void restore(const Snapshot& snapshot);
+  void release(Entry& entry);
+  void clear(std::deque<Entry>& entries);
+  int allocate_slot();
+  bool spill();
+  void to_cpu(Snapshot& snapshot);
+  void enforce_budget_cpu();
+  void delete_pages();
+};
+
+#endif // HISTORY_HPP
@@ -0,0 +1,84 @@
+#ifndef ANNOTATIONS_HPP
+#define ANNOTATIONS_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <array>
+
+#include "image/image_view.hpp"
+#include "image/stroke_rasterizer.hpp"
+
+/**
+ * Circles & lines submitted in bulk by scripts (e.g. thousands of detections per image), without a gl context
+ * Grouped by type & style as they're added, so each group is drawn at once (one nanovg path in app's overlay,
+ * one pass of `StrokeRasterizer` in batch): groups drawn in order of their first shape, shapes of a group in order added
+ * Positions in image pixels with origin at upper-left corner (as emitted by detectors), sizes in pixels
+ *
+ * Files loaded by `load()` accord. to their extension:
+ * - .csv: one shape per line, `circle,<x>,<y>[,<radius>[,<color>]]` or `line,<x1>,<y1>,<x2>,<y2>[,<width>[,<color>]]`
+ *         (empty fields take defaults, blank lines, lines starting with '#' & a `type,...` header skipped)
+ * - .json: array of objects (or object with such a "shapes" array), e.g. `{"type": "circle", "x": 10, "y": 20,
+ *          "radius": 4, "color": "#ff0000"}` or `{"type": "line", "x1": 0, "y1": 0, "x2": 5, "y2": 5, "width": 2}`
+ *          (other keys ignored, e.g. scores or labels of detections)
+ * Colors given as `#rrggbb` or `#rrggbbaa` (straight alpha)
+ */
+class Annotations {
+public:
+  enum class Type { CIRCLE, LINE };
+
+  /* straight-alpha color in [0, 1], radius of circles or width of lines */
+  struct Style {
+    float r;
+    float g;
+    float b;
+    float a;
+    float size;
+  };
+
+  struct Shape {
+    float x1, y1, x2, y2;
+  };
+
+  /* shapes of same type & style */
+  struct Batch {
+    Type type;
+    Style style;
+    std::vector<Shape> shapes;
+  };
+
+  /* same white circles & black lines as drawn from ui */
+  static const Style STYLE_CIRCLE;
+  static const Style STYLE_LINE;
+
+  Annotations();
+  void add_circle(float x, float y, const Style& style=STYLE_CIRCLE);
+  void add_line(float x1, float y1, float x2, float y2, const Style& style=STYLE_LINE);
+  bool load(const std::string& path, std::string& error);
+  void clear();
+  bool empty() const;
+
+  const std::vector<Batch>& get_batches() const;
+  size_t get_n_shapes() const;
+  unsigned int get_revision() const;
+  void rasterize(StrokeRasterizer& rasterizer, const ImageView& view) const;
+
+  static bool parse_color(const std::string& text, Style& style);
+
+private:
+  std::vector<Batch> m_batches;
+
+  /* index of batch of each type & style (key: type followed by style's fields) */
+  std::map<std::array<float, 6>, size_t> m_i_batches;
+
+  size_t m_n_shapes;
+
+  /* incremented on each change (overlay rendered again only when it changed) */
+  unsigned int m_revision;
+
+  void add(Type type, const Shape& shape, const Style& style);
+  bool load_csv(const std::string& text, std::string& error);
+  bool load_json(const std::string& text, std::string& error);
+};
+
+#endif // ANNOTATIONS_HPP
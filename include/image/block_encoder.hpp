@@ -0,0 +1,38 @@
+#ifndef BLOCK_ENCODER_HPP
+#define BLOCK_ENCODER_HPP
+
+#include <string>
+#include <vector>
+
+#include "image.hpp"
+
+/**
+ * Compress 8-bit images into 4x4 blocks sampled directly by the gpu (bc1: 8:1 for rgb, bc3: 4:1 for rgba, bc4: 2:1 for gray)
+ * Endpoints from the bounding box of each block (inset by 1/16th), fast enough to run on a worker thread as images open
+ * Blocks cached on disk next to fonts' atlas, keyed by image's path, size & modification time
+ */
+namespace BlockEncoder {
+  enum class Codec {
+    BC1,
+    BC3,
+    BC4,
+  };
+
+  /* blocks in row order, borders padded by repeating last row/column (i.e. `width` & `height` unpadded) */
+  struct Blocks {
+    int width;
+    int height;
+    int n_channels;
+    Codec codec;
+    std::vector<unsigned char> data;
+  };
+
+  Codec get_codec(int n_channels);
+  void encode(const Image& image, Blocks& blocks);
+
+  std::string get_path_cache(const std::string& path_image);
+  bool read(const std::string& path, Blocks& blocks);
+  void write(const std::string& path, const Blocks& blocks);
+};
+
+#endif // BLOCK_ENCODER_HPP
@@ -0,0 +1,58 @@
+#ifndef BRUSH_HPP
+#define BRUSH_HPP
+
+#include <vector>
+
+#include "glad/glad.h"
+
+#include "framebuffer.hpp"
+#include "program.hpp"
+
+/**
+ * Stamp brush: stroke path interpolated with dabs at fixed spacing, all dabs of a frame drawn
+ * in one instanced draw of a circle's signed distance field (instead of one nanovg frame per dab)
+ * Coordinates in nanovg convention (origin at lower-left corner of fbo) like `ImageVG`
+ */
+class Brush {
+public:
+  /* radius in pixels, hardness in [0, 1] (1: hard edge), spacing between dabs as a fraction of radius */
+  float radius;
+  float hardness;
+  float spacing;
+
+  Brush();
+  void begin_stroke(float x, float y);
+  void move_to(float x, float y);
+  void end_stroke();
+  bool is_stroking() const;
+  bool get_bounds(float& x_min, float& y_min, float& x_max, float& y_max) const;
+  bool flush(const Framebuffer& framebuffer);
+  unsigned int get_n_dabs_last_flush() const;
+  void free();
+
+private:
+  Program m_program;
+  GLuint m_vao;
+  GLuint m_vbo_quad;
+  GLuint m_vbo_dabs;
+
+  /* uniforms locations (looked up once) */
+  GLint m_location_size;
+  GLint m_location_radius;
+  GLint m_location_hardness;
+  GLint m_location_color;
+
+  /* centers of dabs waiting to be drawn (x, y interleaved) & last position on stroke path */
+  std::vector<float> m_dabs;
+  float m_x_last;
+  float m_y_last;
+  bool m_is_stroking;
+
+  /* distance travelled since last dab (carried over between mouse positions) */
+  float m_distance;
+  unsigned int m_n_dabs_last_flush;
+
+  void stamp(float x, float y);
+};
+
+#endif // BRUSH_HPP
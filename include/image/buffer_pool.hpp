@@ -0,0 +1,51 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * Pixel buffers recycled between image operations, in buckets of size classes (at most 25% larger than requested)
+ * Buffers come from `malloc()`, so those not released to the pool can still be freed by `Image::free()`
+ * Thread-safe (filters & encoders run on worker threads)
+ * Buffers in use & cached reported to `MemoryTracker` as two allocations
+ */
+class BufferPool {
+public:
+  struct Stats {
+    size_t n_hits;
+    size_t n_misses;
+    size_t n_bytes_used;
+    size_t n_bytes_peak;
+    size_t n_bytes_cached;
+  };
+
+  BufferPool(size_t n_bytes_cached_max=N_BYTES_CACHED_MAX);
+  unsigned char* acquire(size_t n_bytes);
+  bool release(unsigned char* data);
+  void trim();
+  Stats get_stats() const;
+  void free();
+
+  static BufferPool& get();
+
+private:
+  /* released buffers beyond this total size are freed */
+  static const size_t N_BYTES_CACHED_MAX = 512 * 1024 * 1024;
+
+  size_t m_n_bytes_cached_max;
+
+  /* free buffers by size class & size class of buffers handed out */
+  std::unordered_map<size_t, std::vector<unsigned char*>> m_buckets;
+  std::unordered_map<unsigned char*, size_t> m_sizes;
+
+  mutable std::mutex m_mutex;
+  Stats m_stats;
+
+  static size_t get_size_class(size_t n_bytes);
+  void report() const;
+};
+
+#endif // BUFFER_POOL_HPP
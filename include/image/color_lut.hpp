@@ -0,0 +1,28 @@
+#ifndef COLOR_LUT_HPP
+#define COLOR_LUT_HPP
+
+#include <array>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Point operations (levels, brightness, contrast, gamma, curve & per-channel gains) folded into one lookup table
+ * Built on cpu only when a parameter changes, then applied in a single pass whatever the # of adjustments
+ * (a fetch from a 256x1 texture on gpu, a lookup per byte in `ImageUtils::apply_lut()` on cpu)
+ * Entries are rgba (alpha left unchanged), i.e. the layout of the gpu texture
+ */
+struct ColorLut {
+  static const int SIZE = 256;
+
+  /* control points of curve, evenly spaced over [0, 1] & linearly interpolated */
+  static const int N_POINTS_CURVE = 5;
+
+  std::array<unsigned char, SIZE * 4> table;
+
+  static std::unordered_map<std::string, float> get_defaults();
+
+  ColorLut();
+  ColorLut(const std::unordered_map<std::string, float>& parameters);
+};
+
+#endif // COLOR_LUT_HPP
@@ -0,0 +1,122 @@
+#ifndef CONVOLUTION_KERNEL_HPP
+#define CONVOLUTION_KERNEL_HPP
+
+#include <array>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <optional>
+
+/* 2d kernels generated at compile-time by radius (shared by cpu filters & glsl variants of `convolution.frag`) */
+enum class Kernel {
+  BOX,
+  GAUSSIAN,
+  SHARPEN,
+  SOBEL,
+};
+
+/**
+ * Weights of a (2 * radius + 1)^2 kernel, computed by constexpr functions so cpu loops over them are fully unrolled
+ * (weights are then immediates) & glsl variants get the same values as `#define`s
+ * Sobel's weights are those of the horizontal gradient (vertical one uses them transposed), & output is magnitude
+ */
+template <Kernel KERNEL, int RADIUS>
+struct ConvolutionKernel {
+  static_assert(RADIUS >= 1, "Kernel needs at least a radius of 1");
+
+  static constexpr int SIZE = 2 * RADIUS + 1;
+  static constexpr int N_WEIGHTS = SIZE * SIZE;
+  static constexpr bool IS_GRADIENT = KERNEL == Kernel::SOBEL;
+
+  /* fixed-point weights used by cpu (accumulated in ints, then shifted back) */
+  static constexpr int SHIFT = 12;
+
+  /* exp(x) = exp(x / 2^n)^(2^n), series converging fast for small argument (std::exp isn't constexpr) */
+  static constexpr float exp(float x) {
+    float x_small = x / 256.0f;
+    float term = 1.0f, sum = 1.0f;
+    for (int i = 1; i < 8; i++) {
+      term *= x_small / i;
+      sum += term;
+    }
+
+    for (int i = 0; i < 8; i++)
+      sum *= sum;
+
+    return sum;
+  }
+
+  /* weight before normalization (x, y relative to center) */
+  static constexpr float get_weight(int x, int y) {
+    switch (KERNEL) {
+      case Kernel::BOX:
+        return 1.0f;
+      case Kernel::GAUSSIAN: {
+        // same sigma as `BlurKernel`'s
+        float sigma = RADIUS / 3.0f;
+        return exp(-(x * x + y * y) / (2.0f * sigma * sigma));
+      }
+      case Kernel::SHARPEN:
+        // unsharp mask: 2 * pixel - box average
+        return (x == 0 && y == 0) ? 2.0f * N_WEIGHTS - 1.0f : -1.0f;
+      default:
+        // extended sobel (x / distance^2), matches 3x3 one up to a factor
+        return (x == 0) ? 0.0f : (float) x / (x * x + y * y);
+    }
+  }
+
+  /* normalized to sum of 1 (sum of positive weights for gradients, so a full step gives 1) */
+  static constexpr std::array<float, N_WEIGHTS> get_weights() {
+    std::array<float, N_WEIGHTS> weights {};
+    float sum = 0.0f;
+    for (int y = -RADIUS; y <= RADIUS; y++) {
+      for (int x = -RADIUS; x <= RADIUS; x++) {
+        float weight = get_weight(x, y);
+        weights[(y + RADIUS) * SIZE + (x + RADIUS)] = weight;
+        if (!IS_GRADIENT || weight > 0.0f)
+          sum += weight;
+      }
+    }
+
+    for (float& weight : weights)
+      weight /= (KERNEL == Kernel::SHARPEN) ? N_WEIGHTS : sum;
+
+    return weights;
+  }
+
+  static constexpr std::array<int, N_WEIGHTS> get_weights_fixed() {
+    std::array<int, N_WEIGHTS> weights_fixed {};
+    for (int i = 0; i < N_WEIGHTS; i++) {
+      float weight = WEIGHTS[i] * (1 << SHIFT);
+      weights_fixed[i] = (int) (weight >= 0.0f ? weight + 0.5f : weight - 0.5f);
+    }
+
+    return weights_fixed;
+  }
+
+  static constexpr std::array<float, N_WEIGHTS> WEIGHTS = get_weights();
+  static constexpr std::array<int, N_WEIGHTS> WEIGHTS_FIXED = get_weights_fixed();
+
+  /* `#define`s inserted after `#version` line of `convolution.frag` */
+  static std::string to_defines() {
+    // fixed notation so glsl parses all values as floats
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(9);
+    stream << "#define RADIUS " << RADIUS << "\n" << "#define WEIGHTS float[](";
+    for (int i = 0; i < N_WEIGHTS; i++)
+      stream << (i > 0 ? ", " : "") << WEIGHTS[i];
+    stream << ")\n";
+    if (IS_GRADIENT)
+      stream << "#define IS_GRADIENT\n";
+
+    return stream.str();
+  }
+};
+
+/* radii for which kernels are instantiated (a variant for each, radius switches must list them all) */
+constexpr int RADIUS_MAX_CONVOLUTION = 3;
+
+std::optional<Kernel> find_kernel(const std::string& name);
+std::string get_kernel_defines(Kernel kernel, int radius);
+
+#endif // CONVOLUTION_KERNEL_HPP
@@ -0,0 +1,14 @@
+#ifndef DEPTH_HPP
+#define DEPTH_HPP
+
+/**
+ * Storage of each channel of image pixels & textures
+ * 16-bit samples of decoded images are kept in `Image::data` in native byte order (2 bytes each)
+ */
+enum class Depth {
+  UNORM8,
+  UNORM16,
+  FLOAT16,
+};
+
+#endif // DEPTH_HPP
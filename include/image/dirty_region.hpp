@@ -0,0 +1,46 @@
+#ifndef DIRTY_REGION_HPP
+#define DIRTY_REGION_HPP
+
+#include <vector>
+
+/**
+ * Regions of image modified since a given revision, as a grid of tiles each holding the revision of its last change
+ * Fed by drawing operations, queried by each consumer (effects pass, mipmaps, readback) from its own revision,
+ * so one consumer catching up doesn't hide changes from the others
+ * Positions in image pixels with origin at upper-left corner (i.e. rows of texture)
+ */
+class DirtyRegion {
+public:
+  static const int SIZE_TILE = 64;
+
+  /* pixels covered by changed tiles (clamped to image) */
+  struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  DirtyRegion();
+  void reset(int width, int height);
+  void add(float x_min, float y_min, float x_max, float y_max);
+  void add_all();
+
+  unsigned int get_revision() const;
+  bool get_bounds(unsigned int revision, int margin, Rect& rect) const;
+  bool is_whole(const Rect& rect) const;
+  static bool intersect(const Rect& a, const Rect& b, Rect& rect);
+
+private:
+  int m_width;
+  int m_height;
+  int m_n_tiles_x;
+  int m_n_tiles_y;
+
+  /* revision of last change to each tile, & of last change to whole image (avoids a pass over all tiles) */
+  std::vector<unsigned int> m_revisions;
+  unsigned int m_revision_whole;
+  unsigned int m_revision;
+};
+
+#endif // DIRTY_REGION_HPP
@@ -0,0 +1,29 @@
+#ifndef IMAGE_DECODER_HPP
+#define IMAGE_DECODER_HPP
+
+#include <string>
+
+#include "image.hpp"
+#include "image/depth.hpp"
+
+/**
+ * Decode images from a memory-mapped file (compressed bytes never copied to the heap)
+ * Peak memory of opening an image is then its decoded pixels & the decoder's own scratch buffers
+ * Jpeg & png decoded by libjpeg(-turbo) & libpng when compiled in (`HAS_LIBJPEG`, `HAS_LIBPNG`), by stb otherwise
+ * 16-bit png only kept at full precision for callers asking for it (others get 8-bit channels)
+ */
+namespace ImageDecoder {
+  /* header of an image (`is_reducible` if it can be decoded at a fraction of its size, i.e. jpeg) */
+  struct Info {
+    int width;
+    int height;
+    int n_channels;
+    bool is_reducible;
+  };
+
+  Image decode(const std::string& path, int height_min=0, Depth* depth=NULL);
+  bool get_info(const std::string& path, Info& info);
+  void reduce_to_8bit(Image& image);
+};
+
+#endif // IMAGE_DECODER_HPP
@@ -0,0 +1,27 @@
+#ifndef IMAGE_ENCODER_HPP
+#define IMAGE_ENCODER_HPP
+
+#include <string>
+
+#include "image.hpp"
+
+/**
+ * Write images in format given by extension of path
+ * Jpeg encoded by libjpeg(-turbo) when compiled in (`HAS_LIBJPEG`), png by `PngWriter` (multithreaded zlib),
+ * raw, ppm, pgm & tiff by `RawWriter` (uncompressed), pyramids (".pyr") by `PyramidFile`,
+ * with `Image::save()` (stb) used for other formats & as fallback
+ */
+namespace ImageEncoder {
+  /* quality of jpeg & zlib level of png (fast compression: size within a few % of default level) */
+  const int QUALITY_JPEG = 90;
+  const int LEVEL_PNG = 2;
+
+  struct Options {
+    int quality = QUALITY_JPEG;
+    int level = LEVEL_PNG;
+  };
+
+  bool encode(const Image& image, const std::string& path, const Options& options=Options());
+};
+
+#endif // IMAGE_ENCODER_HPP
@@ -0,0 +1,51 @@
+#ifndef IMAGE_KERNELS_HPP
+#define IMAGE_KERNELS_HPP
+
+/**
+ * Row kernels used by `ImageUtils`, with a scalar reference & SIMD versions selected at runtime
+ * SIMD versions replace divisions by fixed-point multiplies giving the same result bit for bit
+ */
+namespace ImageKernels {
+  enum class Isa {
+    SCALAR,
+    SSE4,
+    AVX2,
+    NEON,
+  };
+
+  /* single-channel average of rgb components of `width` pixels */
+  using GrayscaleRow = void (*)(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels);
+
+  /* 3x3 average of `row` using rows above & below (first & last pixels copied) */
+  using BlurRow = void (*)(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                           unsigned char* row_out, int width, int n_channels);
+
+  struct Kernels {
+    Isa isa;
+    GrayscaleRow to_grayscale_row;
+    BlurRow blur_row;
+  };
+
+  const Kernels& get();
+  bool select(Isa isa);
+  bool is_supported(Isa isa);
+  const char* get_name(Isa isa);
+
+  void to_grayscale_row_scalar(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels);
+  void blur_row_scalar(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                       unsigned char* row_out, int width, int n_channels);
+
+  void to_grayscale_row_sse4(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels);
+  void blur_row_sse4(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                     unsigned char* row_out, int width, int n_channels);
+
+  void to_grayscale_row_avx2(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels);
+  void blur_row_avx2(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                     unsigned char* row_out, int width, int n_channels);
+
+  void to_grayscale_row_neon(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels);
+  void blur_row_neon(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                     unsigned char* row_out, int width, int n_channels);
+};
+
+#endif // IMAGE_KERNELS_HPP
@@ -1,11 +1,62 @@
 #ifndef IMAGE_UTILS_HPP
 #define IMAGE_UTILSHPP
 
+#include <vector>
+#include <functional>
+
 #include "image.hpp"
+#include "image/image_view.hpp"
+#include "image/integral_image.hpp"
+#include "image/convolution_kernel.hpp"
+#include "image/color_lut.hpp"
+#include "image/similarity.hpp"
 
+/**
+ * Cpu filters writing into caller-provided buffers (input & output mustn't overlap)
+ * Views can be crops of larger images, output views are contiguous unless given with a stride
+ */
 namespace ImageUtils {
+  /* rows per chunk of parallel loops (same bands whatever the # of threads) */
+  const int N_ROWS_BAND = 16;
+
+  /* bytes of a row per chunk of column-wise parallel loops (e.g. vertical pass of box filter) */
+  const int N_BYTES_BAND = 256;
+
+  /* iterated box filters approximating a gaussian */
+  const int N_BOXES_GAUSSIAN = 3;
+
+  /* sensitivity to local contrast & dynamic range of standard deviation of Sauvola's threshold */
+  const double THRESHOLD_K = 0.2;
+  const double THRESHOLD_R = 128.0;
+
+  void to_grayscale(const ImageView& view_in, const ImageView& view_out);
+  ImageView to_grayscale(const ImageView& view_in, unsigned char* data_out);
+  void blur(const ImageView& view_in, const ImageView& view_out);
+  ImageView blur(const ImageView& view_in, unsigned char* data_out);
+  void box_blur(const ImageView& view_in, const ImageView& view_out, int radius);
+  void gaussian_blur(const ImageView& view_in, const ImageView& view_out, int radius);
+  void integrate(const ImageView& view, int i_channel, IntegralImage& integral);
+  void threshold(const ImageView& view_in, const ImageView& view_out, int radius);
+  void convolve(const ImageView& view_in, const ImageView& view_out, Kernel kernel, int radius);
+  void apply_lut(const ImageView& view_in, const ImageView& view_out, const ColorLut& lut);
+  void downscale(const ImageView& view_in, const ImageView& view_out, int factor);
+  ImageView downscale(const ImageView& view_in, int factor, unsigned char* data_out);
+  bool flood_fill_mask(const ImageView& view, int x, int y, int tolerance, std::vector<unsigned char>& mask);
+  bool flood_fill(const ImageView& view, int x, int y, const unsigned char* color, int tolerance);
+  bool compare(const ImageView& view, const ImageView& view_reference, Similarity& similarity);
+
   Image to_grayscale(Image& image_in);
   Image blur(Image& image_in);
+  Image box_blur(Image& image_in, int radius);
+  Image gaussian_blur(Image& image_in, int radius);
+  Image threshold(Image& image_in, int radius);
+  Image convolve(Image& image_in, Kernel kernel, int radius);
+  void apply_lut(Image& image, const ColorLut& lut);
+  void free(Image& image);
+
+  void set_n_threads(int n_threads);
+  int get_n_threads();
+  void parallel_for(int n_items, int size_chunk, const std::function<void(int, int)>& func);
 };
 
 #endif // IMAGE_UTILS_HPP
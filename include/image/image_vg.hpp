@@ -1,21 +1,55 @@
 #ifndef IMAGE_VG_HPP
 #define IMAGE_VG_HPP
 
+#include <vector>
+
 #include "nanovg.h"
 
 #include "texture.hpp"
 #include "framebuffer.hpp"
 
-/* Wrapper class for drawing on opengl texture with NanoVG */
+/**
+ * Wrapper class for drawing on opengl texture with NanoVG
+ * Shapes are queued & drawn together by `flush()` in a single nanovg frame (i.e. one fbo bind)
+ */
 struct ImageVG {
-  ImageVG();
+  /* shapes sizes in pixels (needed to know which image region a shape covers) */
+  static const float RADIUS_CIRCLE;
+  static const float WIDTH_STROKE;
+
+  /* counters for profiling (duration in sec) */
+  struct Stats {
+    unsigned int n_flushes;
+    unsigned int n_shapes;
+    unsigned int n_shapes_last_flush;
+    double duration_last_flush;
+  };
+
+  ImageVG(NVGcontext* vg);
   void draw_circle(const Framebuffer& framebuffer, float x, float y);
   void draw_line(const Framebuffer& framebuffer, float x1, float y1, float x2, float y2);
+  void flush();
+  const Stats& get_stats() const;
   void free();
 
 private:
-  /* nanovg context */
+  /* nanovg context (shared by documents) */
   NVGcontext* m_vg;
+
+  /* queued shape with colors picked at time of drawing */
+  struct Shape {
+    enum { CIRCLE, LINE } type;
+    float x1, y1, x2, y2;
+    NVGcolor color;
+  };
+
+  /* shapes waiting to be drawn on fbo they were queued for */
+  std::vector<Shape> m_shapes;
+  const Framebuffer* m_framebuffer;
+
+  Stats m_stats;
+
+  void queue(const Framebuffer& framebuffer, const Shape& shape);
 };
 
 #endif // IMAGE_VG_HPP
@@ -0,0 +1,30 @@
+#ifndef IMAGE_VIEW_HPP
+#define IMAGE_VIEW_HPP
+
+#include <cstddef>
+
+#include "image.hpp"
+
+/**
+ * Non-owning view on pixels of an image or of a region of it (no copy)
+ * Rows are `stride` bytes apart, so a crop of a view shares the pixels of the full image
+ */
+struct ImageView {
+  unsigned char* data;
+  int width;
+  int height;
+  int n_channels;
+  size_t stride;
+
+  ImageView();
+  ImageView(unsigned char* d, int w, int h, int n, size_t s=0);
+  ImageView(const Image& image);
+
+  unsigned char* get_row(int i_row) const;
+  ImageView crop(int x, int y, int w, int h) const;
+  bool is_contiguous() const;
+  size_t get_n_bytes_row() const;
+  size_t get_n_bytes() const;
+};
+
+#endif // IMAGE_VIEW_HPP
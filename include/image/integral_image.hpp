@@ -0,0 +1,27 @@
+#ifndef INTEGRAL_IMAGE_HPP
+#define INTEGRAL_IMAGE_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Summed-area tables of one channel & of its squares (built by `ImageUtils::integrate()`)
+ * Mean & variance of any rectangle in 4 lookups each, whatever its size
+ * Tables have an extra first row & column of zeros (entry (x, y) sums pixels above & left of it)
+ */
+struct IntegralImage {
+  int width;
+  int height;
+  std::vector<uint64_t> sums;
+  std::vector<uint64_t> sums_squared;
+
+  IntegralImage();
+  double get_mean(int x, int y, int w, int h) const;
+  double get_variance(int x, int y, int w, int h) const;
+
+private:
+  uint64_t get_sum(const std::vector<uint64_t>& table, int x, int y, int w, int h) const;
+};
+
+#endif // INTEGRAL_IMAGE_HPP
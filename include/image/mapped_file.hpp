@@ -0,0 +1,24 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Read-only memory mapping of a whole file (pages loaded by kernel on access, no heap copy)
+ * Mapped pages are backed by the file, so they're dropped under memory pressure instead of swapped
+ */
+class MappedFile {
+public:
+  MappedFile(const std::string& path);
+  bool is_mapped() const;
+  const unsigned char* get_data() const;
+  size_t get_size() const;
+  void free();
+
+private:
+  unsigned char* m_data;
+  size_t m_size;
+};
+
+#endif // MAPPED_FILE_HPP
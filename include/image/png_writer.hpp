@@ -0,0 +1,24 @@
+#ifndef PNG_WRITER_HPP
+#define PNG_WRITER_HPP
+
+#include <cstdio>
+
+#include "image.hpp"
+
+/**
+ * Png encoder deflating groups of rows in parallel (on threads of `ImageUtils`), like pigz does for gzip
+ * Each group is a raw deflate stream primed with the last 32KB of the previous group & ended by a sync flush,
+ * so their concatenation is a single standard zlib stream (adler-32 of groups combined at the end)
+ * Written as one png file with one IDAT chunk per group
+ */
+namespace PngWriter {
+  /* filtered bytes per group (smaller groups balance threads better but lose a bit of compression at boundaries) */
+  const size_t N_BYTES_GROUP = 1 << 20;
+
+  /* max. window of deflate, used as dictionary of next group */
+  const size_t N_BYTES_WINDOW = 1 << 15;
+
+  bool write(const Image& image, FILE* file, int level);
+};
+
+#endif // PNG_WRITER_HPP
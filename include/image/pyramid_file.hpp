@@ -0,0 +1,76 @@
+#ifndef PYRAMID_FILE_HPP
+#define PYRAMID_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "image.hpp"
+
+/**
+ * Multi-resolution tiled image on disk (".pyr"), opened instantly (only header & index are read)
+ * Level 0 at full resolution, each next one half the size of previous one (2x2 average), down to a single tile
+ * Tiles of `SIZE_TILE`^2 pixels (smaller on right/bottom borders) deflated separately (kept as is if not smaller)
+ * File mapped in memory, so only pages of tiles decoded are loaded by os, & tiles can be decoded on any thread
+ * Layout (little-endian): magic, width, height, # of channels, tile size, # of levels,
+ * then offset (u64) & size (u32) of each tile (level by level, in rows), then tiles
+ * Cached pyramids (see `get_path_cache()`) evicted least recently used first once their total exceeds `budget_cache`
+ */
+class PyramidFile {
+public:
+  static const int SIZE_TILE = 512;
+
+  /* max. size in bytes of cached pyramids (least recently opened ones removed beyond it) */
+  static size_t budget_cache;
+
+  /* size of a level in pixels & tiles, & position of its first tile in index */
+  struct Level {
+    int width;
+    int height;
+    int n_tiles_x;
+    int n_tiles_y;
+    size_t i_tile_first;
+  };
+
+  PyramidFile();
+  bool open(const std::string& path);
+  bool read_tile(int level, int i_tile_x, int i_tile_y, unsigned char* data) const;
+
+  int get_width() const;
+  int get_height() const;
+  int get_n_channels() const;
+  int get_n_levels() const;
+  const Level& get_level(int level) const;
+  void free();
+
+  static bool write(const Image& image, const std::string& path, int level_zlib);
+  static bool is_pyramid(const std::string& path);
+  static std::string get_path_cache(const std::string& path_image);
+  static void use_cache(const std::string& path);
+
+private:
+  /* tile `n_bytes` long at `offset` in file (raw pixels if that's their size) */
+  struct Entry {
+    uint64_t offset;
+    uint32_t n_bytes;
+  };
+
+  static constexpr char MAGIC[4] = { 'P', 'Y', 'R', '1' };
+  static const size_t N_BYTES_HEADER = sizeof(MAGIC) + 5 * sizeof(uint32_t);
+  static const size_t N_BYTES_ENTRY = sizeof(uint64_t) + sizeof(uint32_t);
+
+  int m_fd;
+  unsigned char* m_data;
+  size_t m_n_bytes;
+
+  int m_width;
+  int m_height;
+  int m_n_channels;
+  std::vector<Level> m_levels;
+  std::vector<Entry> m_entries;
+
+  static std::vector<Level> get_levels(int width, int height);
+};
+
+#endif // PYRAMID_FILE_HPP
@@ -0,0 +1,44 @@
+#ifndef RAW_WRITER_HPP
+#define RAW_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <optional>
+
+#include "image.hpp"
+
+/**
+ * Uncompressed formats for intermediate files, written as fast as the disk allows:
+ * headerless raw (size & channels known by reader), binary ppm (rgb) & pgm (gray), baseline tiff (one strip)
+ * Pixels either written in place into a memory-mapped file (e.g. by `glGetTexImage()` on `GlWorker`),
+ * or from an image with large unbuffered writes
+ * Channels missing from input replicate its first one (gray to rgb), extra ones are dropped (pgm keeps first channel)
+ */
+namespace RawWriter {
+  enum class Format {
+    RAW,
+    PPM,
+    PGM,
+    TIFF,
+  };
+
+  /* size of blocks in which rows are converted before being written (when channels differ) */
+  const size_t N_BYTES_BLOCK = 4 << 20;
+
+  /* output file mapped in memory: header already written, pixels to write at `data + offset_pixels` */
+  struct Mapping {
+    int fd;
+    unsigned char* data;
+    size_t n_bytes;
+    size_t offset_pixels;
+  };
+
+  std::optional<Format> find_format(const std::string& path);
+  int get_n_channels(Format format, int n_channels);
+  std::vector<unsigned char> get_header(Format format, int width, int height, int n_channels);
+  bool write(const Image& image, const std::string& path, Format format);
+  bool map(const std::string& path, Format format, int width, int height, int n_channels, Mapping& mapping);
+  bool unmap(Mapping& mapping, const std::string& path, bool is_written);
+};
+
+#endif // RAW_WRITER_HPP
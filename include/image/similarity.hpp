@@ -0,0 +1,30 @@
+#ifndef SIMILARITY_HPP
+#define SIMILARITY_HPP
+
+/**
+ * Similarity of an image to a reference of same size, on channels normalized to [0, 1] (alpha ignored)
+ * Error summed over rgb (gray images count their channel thrice), ssim computed on luma
+ * SSIM averaged over non-overlapping `SIZE_WINDOW`^2 windows (partial ones along last row & column),
+ * a cheaper approximation of the sliding gaussian window of the reference definition
+ * Same definition on gpu (`ImageComparison`) & cpu (`ImageUtils::compare()`, used by batch)
+ */
+struct Similarity {
+  static const int SIZE_WINDOW = 8;
+
+  /* stabilizing constants of ssim, (0.01 * L)^2 & (0.03 * L)^2 with dynamic range L = 1 */
+  static constexpr double C1 = 0.0001;
+  static constexpr double C2 = 0.0009;
+
+  int width;
+  int height;
+  double mse;
+
+  /* in dB (infinite if images are identical) */
+  double psnr;
+  double ssim;
+
+  static double get_psnr(double mse);
+  static double get_ssim(double n_pixels, double sum_a, double sum_b, double sum_aa, double sum_bb, double sum_ab);
+};
+
+#endif // SIMILARITY_HPP
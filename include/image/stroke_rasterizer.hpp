@@ -0,0 +1,77 @@
+#ifndef STROKE_RASTERIZER_HPP
+#define STROKE_RASTERIZER_HPP
+
+#include <vector>
+
+#include "image/image_view.hpp"
+
+/**
+ * Cpu counterpart of `ImageVG` (same shapes, sizes & coords) drawing on 8-bit pixels without a gl context,
+ * e.g. to burn annotations into images from a headless job
+ * Shapes are queued & drawn together by `flush()`: binned into square tiles of image, then tiles rasterized in parallel
+ * (each tile draws its shapes in the order they were queued, so overlapping shapes blend as on gpu)
+ * Coverage antialiased over one pixel at shapes edges (pixels whose center is inside match nanovg's output)
+ * Positions in nanovg coords (origin at lower-left corner), like shapes drawn on canvas
+ */
+struct StrokeRasterizer {
+  /* default shapes sizes in pixels (same as `ImageVG`, which needs a gl context & isn't linked by headless tools) */
+  static constexpr float RADIUS_CIRCLE = 25.0f;
+  static constexpr float WIDTH_STROKE = 10.0f;
+
+  /* side of tiles shapes are binned into (in pixels) */
+  static const int SIZE_TILE = 64;
+
+  /* straight-alpha color in [0, 1] (a is opacity, i.e. `1 - w` of `Color::stroke` & `Color::fill`) */
+  struct Rgba {
+    float r;
+    float g;
+    float b;
+    float a;
+  };
+
+  /* counters for profiling (duration in sec) */
+  struct Stats {
+    unsigned int n_flushes;
+    unsigned int n_shapes;
+    unsigned int n_shapes_last_flush;
+    unsigned int n_tiles_last_flush;
+    double duration_last_flush;
+  };
+
+  /* colors & sizes picked by shapes queued afterwards (black stroke & white fill of ui's sizes by default) */
+  Rgba color_stroke;
+  Rgba color_fill;
+  float radius_circle;
+  float width_stroke;
+
+  StrokeRasterizer();
+  void draw_circle(const ImageView& view, float x, float y);
+  void draw_line(const ImageView& view, float x1, float y1, float x2, float y2);
+  void flush();
+  const Stats& get_stats() const;
+  void free();
+
+private:
+  /* queued shape in image pixels (origin at upper-left corner) with its color, size & bounding box */
+  struct Shape {
+    enum { CIRCLE, LINE } type;
+    float x1, y1, x2, y2;
+    Rgba color;
+    float size;
+    int x_min = 0, y_min = 0, x_max = 0, y_max = 0;
+  };
+
+  /* shapes waiting to be drawn on view they were queued for */
+  std::vector<Shape> m_shapes;
+  ImageView m_view;
+
+  /* indices of shapes overlapping each tile (kept between flushes to reuse their storage) */
+  std::vector<std::vector<int>> m_bins;
+
+  Stats m_stats;
+
+  void queue(const ImageView& view, Shape shape);
+  void rasterize(const Shape& shape, int x_min, int y_min, int x_max, int y_max) const;
+};
+
+#endif // STROKE_RASTERIZER_HPP
@@ -0,0 +1,53 @@
+#ifndef THUMBNAIL_CACHE_HPP
+#define THUMBNAIL_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+#include "jobs/worker.hpp"
+
+/* Downscaled rgba copy of an image (empty `data` if image couldn't be decoded) */
+struct Thumbnail {
+  int width;
+  int height;
+  std::vector<unsigned char> data;
+};
+
+/**
+ * Thumbnails decoded & downscaled on a pool of workers, then kept on disk
+ * Cache entries are keyed by path, modification time & size of file (an edited image gets a new entry),
+ * so a folder opened again shows its thumbnails without decoding any image
+ */
+class ThumbnailCache {
+public:
+  using Callback = std::function<void(const Thumbnail& thumbnail)>;
+
+  ThumbnailCache(int height, int n_threads=2);
+  void request(const std::string& path, const Callback& callback);
+  void cancel();
+  void free();
+
+  static std::string get_dir_cache();
+
+private:
+  /* thumbnails wider than this many heights are squeezed (e.g. panoramas) */
+  static const int RATIO_MAX = 4;
+
+  int m_height;
+  std::string m_dir_cache;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  /* requests older than a `cancel()` are skipped (callback gets an empty thumbnail) */
+  std::atomic<unsigned int> m_generation;
+
+  Thumbnail load(const std::string& path) const;
+  std::string get_path_cache(const std::string& path) const;
+  Thumbnail downscale(const unsigned char* pixels, int width, int height, int n_channels) const;
+  static bool read(const std::string& path_cache, Thumbnail& thumbnail);
+  static bool write(const std::string& path_cache, const Thumbnail& thumbnail);
+};
+
+#endif // THUMBNAIL_CACHE_HPP
@@ -0,0 +1,87 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+/**
+ * Queue between two pipeline stages (e.g. decoding & processing) holding at most `capacity` items
+ * Producers block when it's full (bounds memory), consumers block until an item arrives or it's closed
+ */
+template <typename T>
+class BoundedQueue {
+public:
+  BoundedQueue(size_t capacity):
+    m_capacity(capacity),
+    m_is_closed(false)
+  {
+  }
+
+  /* Wait for space then add item (returns false if queue was closed) */
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition_push.wait(lock, [this] { return m_is_closed || m_items.size() < m_capacity; });
+    if (m_is_closed)
+      return false;
+
+    m_items.push(std::move(item));
+    m_condition_pop.notify_one();
+    return true;
+  }
+
+  /* Wait for an item (returns false once queue is closed & empty) */
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition_pop.wait(lock, [this] { return m_is_closed || !m_items.empty(); });
+    if (m_items.empty())
+      return false;
+
+    item = std::move(m_items.front());
+    m_items.pop();
+    m_condition_push.notify_one();
+    return true;
+  }
+
+  /* Item if one is available, without waiting */
+  bool try_pop(T& item) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_items.empty())
+      return false;
+
+    item = std::move(m_items.front());
+    m_items.pop();
+    m_condition_push.notify_one();
+    return true;
+  }
+
+  /* No more items will be pushed (consumers drain remaining ones) */
+  void close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_is_closed = true;
+    m_condition_push.notify_all();
+    m_condition_pop.notify_all();
+  }
+
+  /* Items currently queued (e.g. frames decoded ahead) */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_items.size();
+  }
+
+  bool is_closed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_is_closed;
+  }
+
+private:
+  size_t m_capacity;
+  bool m_is_closed;
+  std::queue<T> m_items;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_condition_push;
+  std::condition_variable m_condition_pop;
+};
+
+#endif // BOUNDED_QUEUE_HPP
@@ -0,0 +1,40 @@
+#ifndef JOB_HPP
+#define JOB_HPP
+
+#include <string>
+#include <atomic>
+#include <chrono>
+
+/* Stages of a background job (e.g. save) */
+enum class JobStatus {
+  QUEUED,
+  READBACK, // waiting for pixels from gpu
+  RUNNING,  // on worker thread (e.g. encoding/decoding)
+  UPLOAD,   // streaming pixels to gpu
+  DONE,
+  FAILED,
+};
+
+/**
+ * Job shared between main thread (which displays it) & worker thread (which updates its status)
+ * `progress` in [0, 1] for current stage (negative if unknown)
+ * `time_finished` set by ui when it first sees the job finished (to hide it after a while)
+ * Durations in seconds (negative until known) & # of pixels processed set by worker (e.g. timings of exports)
+ */
+struct Job {
+  std::string label;
+  std::atomic<JobStatus> status;
+  std::atomic<float> progress;
+  double time_finished;
+
+  std::chrono::steady_clock::time_point time_queued;
+  std::atomic<float> duration_waiting;
+  std::atomic<float> duration_running;
+  std::atomic<size_t> n_pixels;
+
+  Job(const std::string& label);
+  bool is_finished() const;
+  const char* get_status_name() const;
+};
+
+#endif // JOB_HPP
@@ -0,0 +1,51 @@
+#ifndef TASK_GRAPH_HPP
+#define TASK_GRAPH_HPP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+
+/* Thread a task runs on (opengl & glfw calls need main thread) */
+enum class TaskThread {
+  MAIN,
+  WORKER,
+};
+
+/**
+ * Tasks run once all their dependencies are done (e.g. startup: image decoded while gl context is created)
+ * Main-thread tasks run on thread calling `run()`, each worker task on its own thread
+ * Each task timed & recorded as a profiler zone (names must outlive the graph's capture)
+ */
+class TaskGraph {
+public:
+  /* times in ms rel. to start of `run()` */
+  struct Timing {
+    std::string name;
+    TaskThread thread;
+    float time_start;
+    float duration;
+  };
+
+  TaskGraph();
+  void add(const std::string& name, const std::vector<std::string>& dependencies, TaskThread thread,
+           const std::function<void()>& func);
+  void run();
+  const std::vector<Timing>& get_timings() const;
+  float get_duration() const;
+  void print() const;
+
+private:
+  struct Task {
+    std::string name;
+    std::vector<size_t> dependencies;
+    TaskThread thread;
+    std::function<void()> func;
+  };
+
+  std::vector<Task> m_tasks;
+  std::vector<Timing> m_timings;
+  float m_duration;
+};
+
+#endif // TASK_GRAPH_HPP
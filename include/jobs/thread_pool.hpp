@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+/**
+ * Threads running chunks of a parallel loop (e.g. bands of image rows)
+ * Each thread has its own queue & steals from others when it runs empty (calling thread helps too)
+ * Tasks must not call opengl functions (gl context is only current on main thread)
+ */
+class ThreadPool {
+public:
+  ThreadPool(int n_threads=0);
+  ~ThreadPool();
+  void parallel_for(int n_items, int size_chunk, const std::function<void(int, int)>& func);
+  int get_n_threads() const;
+  void free();
+
+private:
+  /* tasks pushed & popped at front by owner, stolen from back by other threads */
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_threads;
+
+  /* idle threads sleep until tasks are queued */
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::atomic<int> m_n_tasks;
+  bool m_is_stopped;
+
+  bool pop(size_t i_queue, std::function<void()>& task);
+  void run(size_t i_queue);
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,33 @@
+#ifndef WORKER_HPP
+#define WORKER_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <atomic>
+
+/**
+ * Background thread running submitted tasks in order (e.g. image encoding/decoding)
+ * Tasks must not call opengl functions (gl context is only current on main thread)
+ */
+class Worker {
+public:
+  Worker();
+  void submit(const std::function<void()>& task);
+  size_t get_n_pending() const;
+  void free();
+
+private:
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::queue<std::function<void()>> m_tasks;
+  std::atomic<size_t> m_n_pending;
+  bool m_is_stopped;
+
+  void run();
+};
+
+#endif // WORKER_HPP
@@ -0,0 +1,60 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <string>
+#include <vector>
+
+#include "glad/glad.h"
+
+/**
+ * Gpu durations of named passes measured with timestamp queries
+ * Timestamps can be nested (e.g. passes inside whole frame) unlike `GL_TIME_ELAPSED` queries (used by effects chain)
+ * Each pass cycles through a ring of queries read once available, so cpu never waits for gpu
+ */
+class GpuTimer {
+public:
+  /* frames in flight before a pass is skipped (results usually available 1-2 frames later) */
+  static const int N_QUERIES = 4;
+
+  /* duration in ms of last pass measured & frame it was issued in */
+  struct Result {
+    std::string name;
+    float duration;
+    unsigned int i_frame;
+  };
+
+  GpuTimer();
+  static GpuTimer& get();
+
+  void begin(const std::string& name);
+  void end(const std::string& name);
+  void collect();
+  std::vector<Result> get_results() const;
+  void set_enabled(bool is_enabled);
+  void free();
+
+private:
+  struct Slot {
+    GLuint queries[2];
+    unsigned int i_frame;
+    bool is_pending;
+  };
+
+  struct Pass {
+    std::string name;
+    Slot slots[N_QUERIES];
+    int i_slot;
+    bool is_open;
+    Result result;
+  };
+
+  /* few passes in order of first measure (linear search) */
+  std::vector<Pass> m_passes;
+  unsigned int m_i_frame;
+  bool m_is_enabled;
+
+  Pass& find(const std::string& name);
+  bool read(Pass& pass, Slot& slot);
+};
+
+#endif // GPU_TIMER_HPP
@@ -0,0 +1,70 @@
+#ifndef MEMORY_TRACKER_HPP
+#define MEMORY_TRACKER_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+/* What an allocation is (textures, incl. fbo attachments, & buffer objects are in vram) */
+enum class MemoryKind {
+  TEXTURE,
+  BUFFER,
+  CPU,
+};
+
+/* Soft budgets caches read before growing (they evict or skip work beyond them, nothing is enforced here) */
+enum class MemoryBudget {
+  THUMBNAILS,
+  PREFETCH,
+  UNDO_GPU,
+  UNDO_CPU,
+};
+
+/**
+ * Registry of live allocations with their size, format & owner, fed by the code allocating them
+ * (texture pool, caches, pbos, history & cpu buffer pool), so memory panel shows where memory went
+ * An allocation is keyed by its kind & id (gl name, or address of owner for cpu memory), tracking it again updates it
+ * Thread-safe (cpu buffers are allocated on worker threads)
+ */
+class MemoryTracker {
+public:
+  struct Allocation {
+    MemoryKind kind;
+    uintptr_t id;
+    std::string owner;
+    std::string format;
+    size_t n_bytes;
+  };
+
+  static const int N_BUDGETS = 4;
+
+  MemoryTracker();
+  void track(MemoryKind kind, uintptr_t id, const std::string& owner, const std::string& format, size_t n_bytes);
+  void untrack(MemoryKind kind, uintptr_t id);
+  bool set_owner(MemoryKind kind, uintptr_t id, const std::string& owner);
+  void prune();
+
+  size_t get_n_bytes_gpu() const;
+  size_t get_n_bytes_cpu() const;
+  size_t get_n_bytes(const std::string& owner) const;
+  std::vector<Allocation> get_largest(size_t n) const;
+  std::vector<Allocation> get_owners() const;
+
+  void set_budget(MemoryBudget budget, size_t n_bytes);
+  size_t get_budget(MemoryBudget budget) const;
+  static const char* get_name(MemoryBudget budget);
+
+  static MemoryTracker& get();
+
+private:
+  using Key = std::pair<MemoryKind, uintptr_t>;
+
+  std::map<Key, Allocation> m_allocations;
+  size_t m_budgets[N_BUDGETS];
+  mutable std::mutex m_mutex;
+};
+
+#endif // MEMORY_TRACKER_HPP
@@ -0,0 +1,93 @@
+#ifndef METRICS_EXPORTER_HPP
+#define METRICS_EXPORTER_HPP
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+/* Text format of exported metrics */
+enum class MetricsFormat {
+  JSON,
+  PROMETHEUS,
+};
+
+/* Counters only increase (totals since start), gauges are the latest value */
+enum class MetricType {
+  COUNTER,
+  GAUGE,
+};
+
+/**
+ * Metrics of unattended runs (batch jobs, kiosks) exported without the ui, in json or prometheus text format
+ * Snapshot written every `interval` sec to `path` (replaced atomically, so readers never see a partial file)
+ * and/or served over http on `127.0.0.1:port` (any request answered with latest values, e.g. scraped by prometheus)
+ * Sources push values from their own thread (decoders & encoders on workers, gpu passes & memory on main thread),
+ * snapshots formatted & written by a background thread
+ * Frame times kept as histogram in ms with cumulative buckets (as expected by prometheus)
+ */
+class MetricsExporter {
+public:
+  /* file written periodically (empty: none) & http port (0: none) */
+  static std::string path;
+  static int port;
+  static MetricsFormat format;
+
+  /* seconds between two writes of file */
+  static float interval;
+
+  /* prefix of all metric names */
+  static constexpr const char* PREFIX = "imgui_example_";
+
+  /* upper bounds of frame-time buckets in ms (last one is +Inf) */
+  static const int N_BUCKETS = 8;
+  static constexpr double BOUNDS_FRAME[N_BUCKETS] = { 4.0, 8.0, 16.7, 33.3, 50.0, 100.0, 250.0, 1000.0 };
+
+  MetricsExporter();
+  ~MetricsExporter();
+  bool start();
+  bool is_enabled() const;
+
+  void add(const std::string& name, double value, const std::string& label="", const std::string& value_label="");
+  void set(const std::string& name, double value, MetricType type=MetricType::GAUGE,
+           const std::string& label="", const std::string& value_label="");
+  void add_frame(float duration);
+
+  std::string get_text(MetricsFormat format) const;
+  bool write();
+  void free();
+
+  static MetricsExporter& get();
+  static bool parse_format(const std::string& name, MetricsFormat& format);
+
+private:
+  /* value of a metric for a given label (e.g. `pass="effects"`, no label if empty) */
+  struct Metric {
+    std::string name;
+    std::string label;
+    std::string value_label;
+    MetricType type;
+    double value;
+  };
+
+  /* keyed by name then label, so series of a same metric are listed together */
+  std::map<std::pair<std::string, std::string>, Metric> m_metrics;
+
+  /* frame-time histogram (counts per bucket, not cumulative, incl. +Inf) */
+  unsigned long long m_counts_frame[N_BUCKETS + 1];
+  unsigned long long m_n_frames;
+  double m_duration_frames;
+
+  mutable std::mutex m_mutex;
+  std::thread m_thread;
+  std::atomic<bool> m_is_running;
+  int m_fd;
+
+  void run();
+  void serve();
+  std::string get_json() const;
+  std::string get_prometheus() const;
+};
+
+#endif // METRICS_EXPORTER_HPP
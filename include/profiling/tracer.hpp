@@ -0,0 +1,61 @@
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Nested zones timed per thread (e.g. `PROFILE_ZONE("Frame::render");` at start of a scope)
+ * Zones compiled out unless `PROFILING_ENABLED` is defined (cmake option `PROFILING`)
+ */
+#ifdef PROFILING_ENABLED
+  #define PROFILE_CONCAT_IMPL(a, b) a##b
+  #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+  #define PROFILE_ZONE(name) Zone PROFILE_CONCAT(zone_, __LINE__)(name)
+#else
+  #define PROFILE_ZONE(name)
+#endif
+
+/* Zone timed from construction to destruction (`name` must outlive the capture, e.g. a string literal) */
+class Zone {
+public:
+  explicit Zone(const char* name);
+  ~Zone();
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+private:
+  const char* m_name;
+  int64_t m_time_start;
+};
+
+/**
+ * Gathers zones recorded by all threads into rolling per-zone statistics & optional capture
+ * Each thread writes into its own ring buffer without locking (events dropped if buffer full),
+ * buffers are drained by `collect()` (called once per frame by ui)
+ */
+namespace Tracer {
+  /* durations in ms over last `N_SAMPLES` calls of zone */
+  struct ZoneStats {
+    std::string name;
+    int depth;
+    unsigned int n_calls;
+    float duration_last;
+    float duration_mean;
+    float duration_max;
+  };
+
+  const int N_SAMPLES = 120;
+
+  void collect();
+  std::vector<ZoneStats> get_stats();
+  unsigned int get_n_dropped();
+
+  void start_capture();
+  bool stop_capture(const std::string& path);
+  bool is_capturing();
+};
+
+#endif // TRACER_HPP
@@ -2,41 +2,172 @@
 #define CANVAS_HPP
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <cstdint>
 
 #include "imgui.h"
 
 #include "framebuffer.hpp"
 #include "program.hpp"
+#include "image.hpp"
 #include "render/renderer.hpp"
 
 #include "tooltips/tooltip_image.hpp"
 #include "tooltips/tooltip_pixel.hpp"
+#include "tooltips/tooltip_neighbourhood.hpp"
+#include "canvas_view.hpp"
+#include "ui/enumerations/mode.hpp"
 
 #include "image/image_vg.hpp"
+#include "image/brush.hpp"
+#include "history/history.hpp"
+#include "image/dirty_region.hpp"
+#include "effects/effect_chain.hpp"
+#include "effects/program_table.hpp"
+#include "gpu/pixel_reader.hpp"
+#include "gpu/texture_uploader.hpp"
+#include "gpu/tiled_image.hpp"
+#include "gpu/sequence_player.hpp"
+#include "gpu/shared_surface.hpp"
+#include "gpu/mip_chain.hpp"
+#include "gpu/histogram.hpp"
+#include "gpu/image_comparison.hpp"
+#include "gpu/texture_cache.hpp"
+#include "gpu/reference_image.hpp"
+#include "gpu/gpu_resources.hpp"
+#include "gpu/layer_stack.hpp"
+#include "gpu/selection_mask.hpp"
+#include "gpu/flood_fill.hpp"
+#include "gpu/edge_map.hpp"
+#include "gpu/annotation_overlay.hpp"
+#include "jobs/worker.hpp"
+#include "jobs/job.hpp"
+#include "image/image_encoder.hpp"
+#include "image/pyramid_file.hpp"
 
 /* Canvas where image is displayed */
 class Canvas {
 public:
-  Canvas(const std::string path_image);
+  Canvas(const Image& image, const std::string& path_image);
   void render();
   void free();
 
-  void set_shader(const std::string& key);
+  void set_shader(Shader shader);
 
-  void change_image(const std::string& path_image);
+  void change_image(const std::string& path_image, bool is_read_only=false);
+  void browse(int step);
+  void play_sequence(const std::string& path, int fps);
+  bool is_playing() const;
   void save_image(const std::string& path_image);
+  void export_image(const std::string& path_image, const ImageEncoder::Options& options, int factor);
   void to_grayscale();
   void blur();
+  void set_blur(size_t i_stage, int radius, bool is_box);
+  void convolve(Shader shader);
+  void set_radius(size_t i_stage, int radius);
+  void adjust();
+  void set_adjustment(size_t i_stage, const std::string& name, float value);
+  void remove_effect();
+  void clear_effects();
 
   void zoom_in();
   void zoom_out();
+  void zoom_at(float factor, float x, float y);
+  void pan(float dx, float dy);
+
+  void undo();
+  void redo();
+
+  void add_layer();
+  void remove_layer(size_t i_layer);
+  void select_layer(size_t i_layer);
+  void set_layer(size_t i_layer, float opacity, bool is_visible);
+  const LayerStack* get_layers() const;
+
+  void select_rect(float x1, float y1, float x2, float y2);
+  void select_to(float x, float y);
+  void end_selection();
+  void clear_selection();
+  void fill(float x, float y, float tolerance);
+  void magic_wand(float x, float y, float tolerance);
+
+  void load_overlay(const std::string& path);
+
+  void draw_circle(float x, float y);
+  void draw_line(float x1, float y1, float x2, float y2);
+  void brush_to(float x, float y);
+  void flush_strokes();
+  void end_stroke();
 
   void move_cursor();
   void draw(const std::string& type_shape, bool has_strokes=true);
 
+  bool is_busy() const;
+  void update_jobs();
+  uint64_t get_checksum();
+
+  const std::string& get_path() const;
+  const Texture2D* get_texture_thumbnail();
+  unsigned int get_revision() const;
+  size_t get_n_bytes_gpu() const;
+  bool evict();
+  void restore();
+  bool is_evicted() const;
+
+  unsigned int get_n_skipped_passes() const;
+  std::vector<Effect> get_effects() const;
+  void set_backend(Backend backend);
+  Backend get_backend() const;
+  float get_duration_effects();
+  int get_n_tiles_effects() const;
+  float get_duration_tile_effects() const;
+  const std::vector<std::shared_ptr<Job>>& get_jobs() const;
+
+  /* totals over saves & exports finished in session (durations summed over workers) */
+  struct ExportStats {
+    int n_done;
+    int n_failed;
+    double n_megapixels;
+    double duration_waiting;
+    double duration_running;
+  };
+
+  const std::deque<std::shared_ptr<Job>>& get_exports() const;
+  const ExportStats& get_export_stats() const;
+  size_t get_n_exports_pending() const;
+  const ImageStats* get_image_stats() const;
+
+  /* compare mode shown in its panel (metrics unset until computed, or if sizes differ) */
+  struct Comparison {
+    std::string path;
+    CompareView view;
+    float gain;
+    bool is_loaded;
+    bool has_metrics;
+    std::optional<Similarity> similarity;
+  };
+
+  void compare(const std::string& path, CompareView view, float gain);
+  bool is_comparing() const;
+  const Comparison& get_comparison() const;
+
 private:
-  /* shaders programs to pick from accord. to effect applied to image */
-  std::unordered_map<std::string, Program> m_programs;
+  /* initial radius of blur appended to effects chain (in pixels) */
+  static const int RADIUS_BLUR = 5;
+
+  /* min. height of preview decoded before full image (only shown if image is at least twice as tall) */
+  static const int HEIGHT_PREVIEW = 1024;
+
+  /* images prefetched before & after current one in browse mode (stepping forward is more likely) */
+  static const int N_PREFETCH_BEFORE = 1;
+  static const int N_PREFETCH_AFTER = 2;
+
+  /* shaders programs to pick from accord. to effect applied to image (compiled on first use, shared by documents) */
+  ProgramTable& m_programs;
 
   /**
    * In Normal mode: texture to pass to shader drawing surface geometry
@@ -45,6 +176,9 @@ private:
    */
   Texture2D m_texture_shapes;
 
+  /* depth of image channels (16-bit png kept at full precision through shapes, history & effects) */
+  Depth m_depth;
+
   /**
    * In Normal mode: Texture attached to fbo (to render surface geometry to)
    * In Draw shapes mode: unused
@@ -59,23 +193,295 @@ private:
    * - To read pixels values in tooltip
    */
   Framebuffer m_framebuffer;
-  Renderer m_renderer;
+  Shader m_shader_view;
+
+  /* shared by documents, drawing with `m_shader_view` once set by `get_renderer()` */
+  Renderer& m_renderer;
+
+  /**
+   * Effects applied successively to `m_texture_shapes` (Edit menu)
+   * Its output is then rendered with view shader (`m_shader_view`) into `m_texture_effects`
+   */
+  EffectChain m_effect_chain;
+
+  /* time-sliced render of effects spanning several frames (shown in jobs overlay) */
+  std::shared_ptr<Job> m_job_effects;
 
   /* Needed to work out mouse location rel. to image */
   int m_width;
   int m_height;
 
-  /* for drawing shapes on texture (through fbo) using VG */
+  /* for drawing shapes on texture (through fbo) using VG (shared context), & stamp brush for circle brush tool */
   ImageVG m_image_vg;
+  Brush m_brush;
 
-  float m_zoom;
+  /* undo/redo of shapes drawn on `m_texture_shapes` (not available in tiled mode) */
+  History m_history;
+
+  /**
+   * Annotation layers over image (Layers panel), composited into effects chain's input (created on first layer added)
+   * Shapes & strokes drawn on active layer (image itself if it's layer 0), discarded when another image is opened
+   */
+  std::unique_ptr<LayerStack> m_layers;
+
+  /**
+   * Selection effects are restricted to (rectangle & lasso tools), & vertices of lasso being drawn (image pixels)
+   * Cleared when another image is opened, not available for tiles
+   */
+  SelectionMask m_selection;
+  std::vector<SelectionMask::Vertex> m_lasso;
+
+  /* region grown on gpu from clicked pixel, painted by fill tool or selected by magic wand */
+  FloodFill m_flood_fill;
+
+  /* gradients of drawn image the line tool snaps to (updated over dirty regions while tool is active) */
+  EdgeMap m_edge_map;
+
+  /**
+   * Circles & lines loaded in bulk from a file (File menu), drawn over image from a texture rendered once per change
+   * Not part of image (neither saved nor undone), kept when another image is opened (e.g. detections over frames)
+   */
+  AnnotationOverlay m_overlay;
+
+  /**
+   * Regions drawn on since effects texture, mipmaps & saved pixels were last updated (each keeps its own revision)
+   * Effects stages themselves re-render whole textures (their outputs aren't kept from one render to the next)
+   */
+  DirtyRegion m_dirty;
+  unsigned int m_revision_dirty_effects;
+
+  /* zoom & pan of image inside canvas (only visible part of image is drawn), pan kept while mouse button is down */
+  CanvasView m_view;
+  bool m_is_panning;
+
+  /* mipmaps of displayed texture when zoomed out */
+  MipChain m_mip_chain;
+
+  /**
+   * Display-resolution mode (View menu): view shader run at screen resolution on visible region from a draw callback,
+   * so `m_texture_effects` is only rendered at image resolution when its pixels are needed (save, histogram, tooltips)
+   */
+  struct Display {
+    Texture2D texture;
+    ImVec2 position;
+    ImVec2 size;
+    ImVec2 uv_start;
+    ImVec2 uv_end;
+  };
+
+  std::optional<Display> m_display;
+
+  /**
+   * Histogram & stats of effects texture (View menu), recomputed on gpu only once canvas changed
+   * Created on first use, results arrive a frame or two after request
+   */
+  std::unique_ptr<Histogram> m_histogram;
+  std::optional<ImageStats> m_image_stats;
+  unsigned int m_revision_histogram;
 
   /* Tooltips */
   TooltipImage m_tooltip_image;
   TooltipPixel m_tooltip_pixel;
+  TooltipNeighbourhood m_tooltip_neighbourhood;
+
+  /**
+   * Revision of canvas content (image, shader & shapes drawn) vs. revision rendered to `m_texture_effects`
+   * Effect pass skipped (& counted) when cached effects texture is up-to-date
+   */
+  unsigned int m_revision;
+  unsigned int m_revision_effects;
+  unsigned int m_n_skipped_passes;
+
+  /* saves encoded in parallel (bounded, as each holds a copy of pixels) */
+  static const int N_WORKERS_SAVE = 2;
+
+  /* finished exports listed in ui */
+  static const int N_EXPORTS_SHOWN = 16;
+
+  /**
+   * Non-blocking saves: effects texture read back through PBOs, then encoded on least busy worker
+   * `m_saves` in same order as readbacks in `m_pixel_reader`, `m_jobs` shown in ui until finished
+   * Exports queued together (e.g. several formats) share one readback, as nothing changes in between
+   */
+  struct Save {
+    std::string path;
+    std::shared_ptr<Job> job;
+    ImageEncoder::Options options;
+
+    /* pixels averaged by blocks of `factor`^2 before encoding (1: full size) */
+    int factor;
+
+    /* no readback if nothing changed since previous save, partial one if only a region did */
+    bool has_readback = false;
+    bool is_partial = false;
+  };
+
+  PixelReader m_pixel_reader;
+  std::vector<std::unique_ptr<Worker>> m_workers_save;
+
+  /* copies of texture being written by gl worker into raw files (given back to pool once read) */
+  struct Snapshot {
+    std::shared_ptr<GlWorker::Ticket> ticket;
+    Texture2D texture;
+  };
+
+  std::vector<Snapshot> m_snapshots_raw;
+
+  /**
+   * Pixels of last save, onto which regions changed since are read back (first save reads whole texture)
+   * Read from texture of mode they were saved in (see `get_texture_export()`)
+   */
+  std::shared_ptr<Readback> m_pixels_saved;
+  unsigned int m_revision_dirty_saved;
+  bool m_has_pixels_saved;
+  Mode m_mode_saved;
+  std::deque<Save> m_saves;
+  std::vector<std::shared_ptr<Job>> m_jobs;
+
+  /* pending & last finished saves, with totals over those finished (for exports panel) */
+  std::deque<std::shared_ptr<Job>> m_exports;
+  ExportStats m_export_stats;
+
+  /**
+   * Non-blocking opens: image decoded on worker thread, then streamed to `m_texture_upload` through a PBO
+   * Previous image still displayed until new texture is complete (then swapped with `m_texture_shapes`)
+   */
+  struct Open {
+    std::string path;
+    std::shared_ptr<Job> job;
+    std::shared_ptr<Image> image;
+
+    /* reduced-size decode of image (set before `has_preview`) & full dimensions */
+    std::shared_ptr<Image> preview;
+    std::atomic<bool> has_preview;
+    int width;
+    int height;
+
+    /* depth of decoded channels (8-bit if image is too large for a texture, as tiles are processed on cpu) */
+    Depth depth;
+
+    /* compressed blocks of read-only image (set before status, `image` unset if read from disk cache) */
+    std::shared_ptr<BlockEncoder::Blocks> blocks;
+
+    /* pyramid file opened instead of decoding (cached pyramid of an image too large for a texture, or a ".pyr") */
+    std::shared_ptr<PyramidFile> pyramid;
+
+    /* image no longer wanted (e.g. another one shown meanwhile from browse cache) */
+    std::atomic<bool> is_canceled;
+  };
+
+  Worker m_worker_decode;
+  TextureUploader m_uploader;
+  std::deque<std::shared_ptr<Open>> m_opens;
+  std::optional<Texture2D> m_texture_upload;
+
+  /**
+   * Preview of image being opened, shown stretched to full size until full resolution is uploaded
+   * Drawing & tooltips disabled meanwhile (uv of preview don't match pixels of full image)
+   */
+  std::optional<Texture2D> m_texture_preview;
+  ImVec2 m_size_preview;
+
+  /**
+   * Browse mode (File menu): neighbours of current image in its folder are decoded on their own worker,
+   * then uploaded (after opens) into `m_cache`, so stepping to one of them is only a swap of textures
+   * Current image goes back into cache when stepping away from it (unless it was edited)
+   */
+  std::string m_path_image;
+  std::string m_path_prefetched;
+  std::vector<std::string> m_paths_folder;
+  TextureCache m_cache;
+  Worker m_worker_prefetch;
+  TextureUploader m_uploader_prefetch;
+  std::deque<std::shared_ptr<Open>> m_prefetches;
+  std::optional<Texture2D> m_texture_prefetch;
+
+  /* frames of a numbered sequence streamed into `m_texture_shapes`, effects re-run on each one */
+  SequencePlayer m_sequence;
+
+  /**
+   * Compare mode (File menu): reference decoded on worker & uploaded in one go, then effects texture shown against it
+   * Metrics recomputed on gpu once effects texture or reference changed (results of a previous reference dropped)
+   */
+  Comparison m_comparison;
+  std::unique_ptr<ImageComparison> m_image_comparison;
+  std::shared_ptr<Open> m_open_compare;
+  std::optional<Texture2D> m_texture_compare;
+  unsigned int m_n_references;
+  unsigned int m_n_references_requested;
+  std::optional<unsigned int> m_revision_compared;
+
+  /* tiled mode: set when opened image exceeds max. texture size (replaces `m_texture_shapes`/`m_texture_effects`) */
+  std::unique_ptr<TiledImage> m_tiled;
+  GLint m_size_texture_max;
+
+  /**
+   * Read-only mode (File menu): image shown from a compressed texture, full-size textures given back to pool
+   * Left on first edit (drawing, effects, view shader) by uploading the cpu copy into an uncompressed texture
+   */
+  std::unique_ptr<ReferenceImage> m_reference;
+
+  /**
+   * Background document evicted from vram (memory budget of documents exceeded): pixels of image texture
+   * kept on cpu & uploaded again on activation, placeholders in place of image & effects textures meanwhile
+   */
+  struct Evicted {
+    std::vector<unsigned char> data;
+    int n_channels;
+  };
+
+  std::optional<Evicted> m_evicted;
+
+  static void on_draw_display(const ImDrawList* draw_list, const ImDrawCmd* command);
+  static void on_draw_overlay(const ImDrawList* draw_list, const ImDrawCmd* command);
 
-  void render_to_fbo();
+  void set_program_view(Shader shader);
+  Renderer& get_renderer();
+  const Texture2D& get_texture_target() const;
+  History& get_history();
+  const Texture2D& get_texture_composite();
+  const Texture2D& get_texture_export();
+  void clear_layers();
+  void update_texture_effects();
+  int get_n_channels_effects() const;
+  Shader get_shader_view() const;
+  void invalidate();
+  void invalidate(float x_min, float y_min, float x_max, float y_max);
+  void invalidate_view();
+  void invalidate_effects();
+  void set_selection(const std::vector<SelectionMask::Vertex>& polygon);
+  void update_selection(bool was_empty, const DirtyRegion::Rect& rect_previous);
+  void render_selection();
+  std::optional<ImVec2> snap_to_edge();
+  void update_opens();
+  void show_preview(Open& open);
+  void hide_preview();
+  void replace_texture(const Texture2D& texture, bool is_freed);
+  void show_reference(Open& open);
+  bool make_editable();
+  void update_folder(const std::string& path);
+  void update_prefetches();
+  void update_sequence();
+  void update_shared();
+  void update_compare_open();
+  const Texture2D& render_comparison(const Texture2D& texture);
+  void release_compare();
+  std::shared_ptr<Open> decode(const std::string& path, Worker& worker, bool has_preview, bool is_read_only=false);
+  void encode(const Save& save, const std::shared_ptr<Readback>& pixels);
+  bool write_raw(const Save& save);
+  void bake(bool is_complete=false);
+  void render_to_fbo(bool is_complete=false);
+  void update_job_effects();
+  void render_display();
   void render_image(float y_offset);
+  void render_overlay(const ImVec2& position_screen, const ImVec2& size_screen, const ImVec2& uv_start, const ImVec2& uv_end);
+  void update_histogram();
+  void render_tooltips_tiled(const ImVec2& position_mouse_img);
+  void render_tooltips_reference(const ImVec2& position_mouse_img);
+  ImVec2 get_mouse_position() const;
+  ImVec2 get_mouse_position_vg() const;
+  std::vector<ImVec2> get_mouse_positions_vg() const;
+  void navigate();
 };
 
 #endif // CANVAS_HPP
@@ -0,0 +1,41 @@
+#ifndef CANVAS_VIEW_HPP
+#define CANVAS_VIEW_HPP
+
+#include "imgui.h"
+
+/**
+ * Continuous zoom & pan of image inside canvas (replaces imgui window's scrolling)
+ * Maps screen positions to image pixels exactly & gives the visible sub-rectangle of image, so only it is drawn
+ * Positions in image pixels with origin at upper-left corner (like screen positions)
+ */
+class CanvasView {
+public:
+  static constexpr float ZOOM_MIN = 1.0f / 64.0f;
+  static constexpr float ZOOM_MAX = 64.0f;
+
+  CanvasView();
+  void update(const ImVec2& origin, const ImVec2& size, const ImVec2& size_image);
+
+  void zoom_at(float factor, const ImVec2& position_image);
+  void zoom_center(float factor);
+  void pan(const ImVec2& displacement_image);
+
+  ImVec2 to_image(const ImVec2& position_screen) const;
+  ImVec2 to_screen(const ImVec2& position_image) const;
+  bool get_visible(ImVec2& position, ImVec2& size) const;
+  float get_zoom() const;
+
+private:
+  /* canvas' upper-left corner & size on screen */
+  ImVec2 m_origin;
+  ImVec2 m_size;
+  ImVec2 m_size_image;
+
+  /* image position shown at canvas' upper-left corner */
+  float m_zoom;
+  ImVec2 m_offset;
+
+  void clamp();
+};
+
+#endif // CANVAS_VIEW_HPP
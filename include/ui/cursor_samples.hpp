@@ -0,0 +1,33 @@
+#ifndef CURSOR_SAMPLES_HPP
+#define CURSOR_SAMPLES_HPP
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * Every cursor position reported by glfw between two frames, with its timestamp
+ * (imgui only keeps the last one, so a fast stroke would be drawn from one position per frame)
+ * Positions in screen coords like `ImGuiIO::MousePos`
+ * Declared static so it can be accessed from all classes (like `Redraw`)
+ */
+struct CursorSamples {
+  struct Sample {
+    float x;
+    float y;
+    double time;
+  };
+
+  /* samples kept between two frames (oldest dropped, e.g. high-rate mouse while main loop stalls) */
+  static const size_t N_SAMPLES_MAX = 1024;
+
+  static void push(double x, double y);
+  static void begin_frame();
+  static const std::vector<Sample>& get();
+
+private:
+  /* received since last frame began vs. handed to current frame */
+  static std::vector<Sample> samples_pending;
+  static std::vector<Sample> samples;
+};
+
+#endif // CURSOR_SAMPLES_HPP
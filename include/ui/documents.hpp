@@ -0,0 +1,61 @@
+#ifndef DOCUMENTS_HPP
+#define DOCUMENTS_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "image.hpp"
+
+#include "ui/canvas.hpp"
+
+/**
+ * Open documents (one canvas each) shown in tabs, only the active one rendered & receiving commands
+ * Canvases share programs, nanovg context & renderer (`GpuResources`), & only own their textures & framebuffers
+ * Least recently active background documents evicted from vram once their total exceeds budget,
+ * then restored from their cpu copy on activation
+ * Closed documents with pending saves kept (tab marked as saving) until their saves are encoded
+ */
+class Documents {
+public:
+  Documents(const Image& image, const std::string& path_image, size_t budget_gpu=BUDGET_GPU);
+  void render_tabs();
+  void enforce_budget();
+  void update_closing();
+
+  void open(const std::string& path_image, bool is_read_only=false);
+  void activate(size_t i_document);
+  void close(size_t i_document);
+
+  Canvas& get_active();
+  Canvas& get(size_t i_document);
+  size_t get_i_active() const;
+  size_t get_n_documents() const;
+  size_t get_n_bytes_gpu() const;
+  void free();
+
+private:
+  /* default budget in bytes of documents' image, effects & history textures */
+  static const size_t BUDGET_GPU = 1024 * 1024 * 1024;
+
+  struct Document {
+    std::unique_ptr<Canvas> canvas;
+
+    /* unique id of tab (paths may be opened twice) & frame of last activation (for eviction) */
+    unsigned int id;
+    unsigned int i_activated;
+
+    /* close requested while canvas was busy (erased once its jobs are finished) */
+    bool is_closing;
+  };
+
+  size_t m_budget_gpu;
+  std::vector<Document> m_documents;
+  size_t m_i_active;
+  unsigned int m_id_next;
+  unsigned int m_i_activation;
+
+  void erase(size_t i_document);
+};
+
+#endif // DOCUMENTS_HPP
@@ -5,7 +5,8 @@
 enum HoverMode {
   NONE = 0,
   IMAGE_SUBSET = 1,
-  PIXEL_VALUE = 2
+  PIXEL_VALUE = 2,
+  NEIGHBOURHOOD = 3
 };
 
 #endif // HOVER_MODE_HPP
@@ -11,30 +11,54 @@
 #include "program.hpp"
 
 #include "ui/canvas.hpp"
+#include "ui/documents.hpp"
 #include "ui/menu.hpp"
 #include "ui/toolbar.hpp"
+#include "ui/perf_overlay.hpp"
+#include "ui/memory_panel.hpp"
+#include "ui/thumbnails.hpp"
+#include "ui/thumbnail_strip.hpp"
 
 #include "ui/listeners/listener_canvas.hpp"
 #include "ui/listeners/listener_window.hpp"
 
+#include "commands/session_log.hpp"
+
 /* Main ImGui window */
 class Frame {
 public:
-  Frame(const Window& window, const std::string& path_image);
+  Frame(const Window& window, const Image& image, const std::string& path_image);
   void render();
   void free();
+  Canvas& get_canvas();
 
 private:
   Window m_window;
 
-  /* Main menu, image holder, toolbar components */
+  /* Main menu, documents (image holders in tabs), toolbar components */
   Menu m_menu;
-  Canvas m_canvas;
+  Documents m_documents;
   Toolbar m_toolbar;
 
+  /* cpu & gpu frame times */
+  PerfOverlay m_perf_overlay;
+
+  /* vram & ram by owner, budgets of caches */
+  MemoryPanel m_memory_panel;
+
+  /* thumbnails in open/save dialogs */
+  Thumbnails m_thumbnails;
+
+  /* open documents & recent images (thumbnails in a gpu atlas) */
+  ThumbnailStrip m_thumbnail_strip;
+
   /* listeners for events rel. to canvas & window */
   ListenerCanvas m_listener_canvas;
   ListenerWindow m_listener_window;
+
+  /* commands recorded to/replayed from a session log, at index of frame they were dispatched */
+  SessionLog m_session_log;
+  unsigned int m_i_frame;
 };
 
 #endif // FRAME_HPP
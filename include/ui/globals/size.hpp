@@ -11,6 +11,7 @@
 struct Size {
   static ImVec2 menu;
   static ImVec2 toolbar;
+  static ImVec2 tabs;
   static ImVec2 canvas;
 };
 
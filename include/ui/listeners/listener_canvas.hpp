@@ -1,25 +1,47 @@
 #ifndef LISTENER_CANVAS_HPP
 #define LISTENER_CANVAS_HPP
 
+#include <vector>
+
 #include "ui/canvas.hpp"
+#include "ui/documents.hpp"
+#include "commands/command.hpp"
 
-/* Handler for events pertaining to image canvas */
+/* Handler for events pertaining to image canvas (commands sent to active document) */
 class ListenerCanvas {
 public:
-  ListenerCanvas(Canvas* canvas);
-  void handle_all();
+  ListenerCanvas(Documents* documents);
+  void render();
+  void handle_all(const std::vector<Command>& commands);
 private:
+  /* formats offered by exports panel (extension appended to base path) */
+  static const int N_FORMATS_EXPORT = 8;
+
+  /* fields of exports panel, kept between frames */
+  struct ExportForm {
+    char path[256];
+    bool formats[N_FORMATS_EXPORT];
+    int quality;
+    int level;
+    int factor;
+  };
+
+  Documents* m_documents;
   Canvas* m_canvas;
+  ExportForm m_export;
+
+  void handle(const Command& command);
 
-  void on_open_image();
-  void on_save_image();
-  void on_to_grayscale();
-  void on_blur();
-  void on_view_color();
-  void on_view_grayscale();
-  void on_view_monochrome();
-  void on_zoom_in();
-  void on_zoom_out();
+  void show_open_dialog();
+  void show_save_dialog();
+  void show_compare_dialog();
+  void show_overlay_dialog();
+  void show_jobs();
+  void show_exports();
+  void show_effects();
+  void show_histogram();
+  void show_comparison();
+  void show_layers();
 };
 
 #endif // LISTENER_CANVAS_HPP
@@ -1,17 +1,19 @@
 #ifndef LISTENER_WINDOW_HPP
 #define LISTENER_WINDOW_HPP
 
+#include <vector>
+
 #include "window.hpp"
 
+#include "commands/command.hpp"
+
 /* Handler for events pertaining to glfw window */
 class ListenerWindow {
 public:
   ListenerWindow(Window* window);
-  void handle_all();
+  void handle_all(const std::vector<Command>& commands);
 private:
   Window* m_window;
-
-  void on_quit_app();
 };
 
 #endif // LISTENER_WINDOW_HPP
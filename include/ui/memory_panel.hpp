@@ -0,0 +1,25 @@
+#ifndef MEMORY_PANEL_HPP
+#define MEMORY_PANEL_HPP
+
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * Window with vram & ram registered in `MemoryTracker` (toggled from menu View)
+ * Totals by owner, largest allocations & sliders for soft budgets of caches
+ */
+class MemoryPanel {
+public:
+  /* largest allocations listed */
+  static const int N_LARGEST = 10;
+
+  /* max. of budget sliders (in MB) */
+  static const int BUDGET_MAX = 4096;
+
+  void render();
+
+private:
+  static const char* get_kind(MemoryKind kind);
+  static float to_mb(size_t n_bytes);
+};
+
+#endif // MEMORY_PANEL_HPP
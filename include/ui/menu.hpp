@@ -1,17 +1,16 @@
 #ifndef MENU_HPP
 #define MENU_HPP
 
-/* Main menu with booleans flags set on menu item click */
+/* Main menu with booleans flags set on menu item click (actions enqueued as commands) */
 struct Menu {
   /**
    * flags set on button click/radio button check (needed to activate listeners in `Dialog`)
    * Declared static so they can be accessed from all classes (incl. listeners)
    */
-  static bool open_image, save_image, quit_app; // menu File
-  static bool to_grayscale, blur; // menu Edit
-  static bool view_color, view_grayscale, view_monochrome; // menu View
-  static bool zoom_in, zoom_out; // menu Zoom
-  static bool draw_circle, draw_line, brush_circle, brush_line; // menu Draw
+  static bool open_image, save_image, export_image, browse_folder, open_read_only, open_new_document, play_sequence, compare_image, load_overlay; // menu File
+  static bool view_histogram, view_performance, view_memory, view_display_resolution, view_layers, view_thumbnails, view_overlay; // menu View
+  static bool draw_circle, draw_line, brush_circle, brush_line, fill; // menu Draw
+  static bool select_rect, select_lasso, magic_wand; // menu Select
 
   Menu();
   void render();
@@ -0,0 +1,50 @@
+#ifndef PACING_HPP
+#define PACING_HPP
+
+#include <chrono>
+
+/**
+ * Latency-optimized frame pacing (opt-in, for drawing): input polled right before frame is built,
+ * & main loop sleeps after each present so input is sampled as late as possible before next vsync
+ * Input-to-present latency measured from first input event of a frame (as seen in glfw callbacks) to its present
+ * Declared static so it can be accessed from all classes (like `Redraw`)
+ */
+struct Pacing {
+  static bool low_latency;
+
+  /* vsync disabled while a brush stroke is drawn (frames still capped at refresh rate by limiter) */
+  static bool no_vsync_drawing;
+
+  /* last measured input-to-present latency (in ms) & # of measurements so far (to detect a new one) */
+  static float latency;
+  static unsigned int n_latencies;
+
+  static void init();
+  static void limit();
+  static void begin_frame();
+  static void end_frame();
+  static void on_input();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /* slack left before predicted present, so a slower frame doesn't miss vsync (in ms) */
+  static constexpr float MARGIN = 1.5f;
+
+  /* weight of last frame in running mean of frame work (poll to present) */
+  static constexpr float WEIGHT_WORK = 0.1f;
+
+  static float period;
+  static float duration_work;
+  static bool is_vsync_off;
+  static bool has_input_pending;
+  static bool has_input_frame;
+  static Clock::time_point time_input_pending;
+  static Clock::time_point time_input_frame;
+  static Clock::time_point time_start;
+  static Clock::time_point time_present;
+
+  static bool is_drawing();
+};
+
+#endif // PACING_HPP
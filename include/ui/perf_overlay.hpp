@@ -0,0 +1,58 @@
+#ifndef PERF_OVERLAY_HPP
+#define PERF_OVERLAY_HPP
+
+#include <chrono>
+#include <vector>
+
+/**
+ * Overlay with rolling graphs of cpu & gpu frame times (toggled from menu View)
+ * Gpu time per pass read from `GpuTimer` to show which one dominates, cpu zones from `Tracer`
+ * Input-to-present latency measured by `Pacing` (only frames showing some input)
+ * Same measures (with memory & pools) pushed to `MetricsExporter` when enabled, even with overlay hidden
+ */
+class PerfOverlay {
+public:
+  /* frames kept in graphs & percentiles */
+  static const int N_FRAMES = 240;
+
+  /* chrome trace written in working directory */
+  static constexpr const char* PATH_TRACE = "trace.json";
+
+  /* gpu passes timed even with overlay hidden (e.g. by replay benchmark) */
+  static bool is_timed;
+
+  PerfOverlay();
+  void begin_frame();
+  void end_frame();
+  void render();
+
+private:
+  /* ring buffers of durations in ms (`m_i_head` is next written) */
+  std::vector<float> m_durations_cpu;
+  std::vector<float> m_durations_gpu;
+  std::vector<float> m_latencies;
+  int m_i_head_cpu;
+  int m_i_head_gpu;
+  int m_i_head_latency;
+  int m_n_cpu;
+  int m_n_gpu;
+  int m_n_latency;
+
+  /* frame index of last gpu frame duration pushed */
+  unsigned int m_i_frame_gpu;
+
+  /* # of latencies measured when last one was pushed */
+  unsigned int m_n_latencies;
+  std::chrono::steady_clock::time_point m_time_start;
+
+  /* last time gauges were pushed to metrics exporter (cumulative values only needed once per write) */
+  std::chrono::steady_clock::time_point m_time_metrics;
+
+  void render_zones();
+  void export_metrics(float duration_cpu);
+  static void push(std::vector<float>& durations, int& i_head, int& n, float duration);
+  static float get_percentile(const std::vector<float>& durations, int n, float percentile);
+  static void render_graph(const char* label, const std::vector<float>& durations, int i_head, int n);
+};
+
+#endif // PERF_OVERLAY_HPP
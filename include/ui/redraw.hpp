@@ -0,0 +1,50 @@
+#ifndef REDRAW_HPP
+#define REDRAW_HPP
+
+#include <atomic>
+
+#include "GLFW/glfw3.h"
+
+/**
+ * On-demand rendering (opt-in): main loop waits for events instead of redrawing continuously
+ * Frames are requested by input events, async jobs (from any thread) or explicitly by `Frame`/`Canvas`
+ * Declared static so it can be accessed from all classes (like `Menu` & `Toolbar` flags)
+ */
+struct Redraw {
+  static bool on_demand;
+
+  /* max. time (in sec) to wait for an event before drawing an idle frame anyway */
+  static double max_idle;
+
+  /* frames rendered bcoz of events/requests vs. after idle timeout */
+  static unsigned int n_frames_active;
+  static unsigned int n_frames_idle;
+
+  static void install_callbacks(GLFWwindow* window);
+  static void request(int n_frames=N_FRAMES_SETTLE);
+  static void request_async();
+  static void wait();
+  static void print();
+
+private:
+  /* imgui needs a few frames to settle after an input (e.g. hover state, menus layout) */
+  static const int N_FRAMES_SETTLE = 3;
+  static std::atomic<int> n_frames_pending;
+
+  /* glfw callbacks previously registered (chained to) */
+  static GLFWcursorposfun callback_cursor_pos;
+  static GLFWmousebuttonfun callback_mouse_button;
+  static GLFWscrollfun callback_scroll;
+  static GLFWkeyfun callback_key;
+  static GLFWcharfun callback_char;
+  static GLFWwindowsizefun callback_window_size;
+
+  static void on_cursor_pos(GLFWwindow* window, double x, double y);
+  static void on_mouse_button(GLFWwindow* window, int button, int action, int mods);
+  static void on_scroll(GLFWwindow* window, double x_offset, double y_offset);
+  static void on_key(GLFWwindow* window, int key, int scancode, int action, int mods);
+  static void on_char(GLFWwindow* window, unsigned int codepoint);
+  static void on_window_size(GLFWwindow* window, int width, int height);
+};
+
+#endif // REDRAW_HPP
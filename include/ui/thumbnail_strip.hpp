@@ -0,0 +1,51 @@
+#ifndef THUMBNAIL_STRIP_HPP
+#define THUMBNAIL_STRIP_HPP
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "gpu/thumbnail_atlas.hpp"
+#include "ui/documents.hpp"
+
+/**
+ * Strip of open documents followed by recently closed images at bottom of canvas (toggled from menu View)
+ * Thumbnails rendered on gpu from active document's output (no decode) into a shared atlas, so strip is drawn
+ * with one texture & one draw list whatever its # of entries (names shown in tooltips, not under thumbnails)
+ * Click switches to an open document or reopens a recent image in a new tab
+ * Documents without a full-size texture (tiles, read-only images) & recent images not captured shown as gray placeholders
+ */
+class ThumbnailStrip {
+public:
+  /* recently closed images listed (most recent first, for current session) */
+  static const int N_RECENT = 16;
+
+  /* larger side of thumbnails on screen (in pixels) */
+  static constexpr float SIZE_DISPLAY = 64.0f;
+
+  /* min. time (in sec) between two captures of an edited document (e.g. while drawing) */
+  static constexpr double INTERVAL_CAPTURE = 1.0;
+
+  ThumbnailStrip();
+  void update(Documents& documents);
+  void render();
+  void free();
+
+private:
+  ThumbnailAtlas m_atlas;
+
+  /* paths of open documents in previous frame (closed ones moved to recent images) */
+  std::vector<std::string> m_paths_open;
+  std::deque<std::string> m_paths_recent;
+  size_t m_i_active;
+
+  /* revision of document captured for each path & time of last capture */
+  std::unordered_map<std::string, unsigned int> m_revisions;
+  double m_time_capture;
+
+  void add_recent(const std::string& path);
+  bool render_entry(const std::string& path, bool is_active);
+};
+
+#endif // THUMBNAIL_STRIP_HPP
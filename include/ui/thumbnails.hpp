@@ -0,0 +1,28 @@
+#ifndef THUMBNAILS_HPP
+#define THUMBNAILS_HPP
+
+#include "image/thumbnail_cache.hpp"
+
+/**
+ * Thumbnails of open/save dialogs (thumbnails list mode of `ImGuiFileDialog`)
+ * Decoded by `ThumbnailCache` instead of dialog's single thread, textures created at most `N_UPLOADS_FRAME` per frame
+ * & while their total size is below thumbnails budget of `MemoryTracker`
+ */
+class Thumbnails {
+public:
+  /* same as `DisplayMode_ThumbailsList_ImageHeight` in dialog's config */
+  static const int HEIGHT = 32;
+  static const int N_UPLOADS_FRAME = 32;
+  static constexpr const char* OWNER = "thumbnails";
+
+  Thumbnails();
+  void upload();
+  void free();
+
+private:
+  ThumbnailCache m_cache;
+  int m_n_uploads;
+  bool m_was_opened;
+};
+
+#endif // THUMBNAILS_HPP
@@ -1,12 +1,14 @@
 #ifndef TOOLTIP_IMAGE_HPP
 #define TOOLTIP_IMAGE_HPP
 
+#include "imgui.h"
+
 #include "texture_2d.hpp"
 
 class TooltipImage {
 public:
   TooltipImage(const Texture2D& texture);
-  void render(float y_offset, float zoom);
+  void render(const ImVec2& position_image, float zoom, const Texture2D* texture=NULL, const ImVec2& origin_tile={ 0.0f, 0.0f });
 private:
   Texture2D m_texture;
 };
@@ -0,0 +1,37 @@
+#ifndef TOOLTIP_NEIGHBOURHOOD_HPP
+#define TOOLTIP_NEIGHBOURHOOD_HPP
+
+#include "imgui.h"
+
+#include "framebuffer.hpp"
+#include "image.hpp"
+#include "gpu/pixel_reader.hpp"
+
+/**
+ * Grid of pixel values around cursor with their mean & standard deviation per channel
+ * Whole block fetched by one asynchronous readback per frame (whatever the grid size)
+ */
+class TooltipNeighbourhood {
+public:
+  TooltipNeighbourhood(const Framebuffer& framebuffer);
+  void render(const ImVec2& position_image, int size, const ImVec2& origin_tile={ 0.0f, 0.0f });
+  void render_cpu(const ImVec2& position_image, int size, const Image* image);
+  void free();
+
+private:
+  /* on-screen size of a grid cell in pixels */
+  static constexpr float SIZE_CELL = 8.0f;
+
+  /* pointer to canvas' fbo (its attached texture changes with mode) */
+  const Framebuffer* m_framebuffer;
+
+  /* block shown lags one or two frames behind cursor */
+  PixelReader m_pixel_reader;
+  Readback m_readback;
+  bool m_has_value;
+
+  static void get_block(int x, int y, int size, int width, int height, int& x_min, int& y_min, int& size_x, int& size_y);
+  void show(const Readback& block, const ImVec2& position_image, const ImVec2& origin_block);
+};
+
+#endif // TOOLTIP_NEIGHBOURHOOD_HPP
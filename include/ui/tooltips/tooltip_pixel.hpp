@@ -1,14 +1,27 @@
 #ifndef TOOLTIP_PIXEL_HPP
 #define TOOLTIP_PIXEL_HPP
 
+#include "imgui.h"
+
 #include "framebuffer.hpp"
+#include "image.hpp"
+#include "gpu/pixel_reader.hpp"
 
 class TooltipPixel {
 public:
   TooltipPixel(const Framebuffer& framebuffer);
-  void render(float y_offset, float y_scroll);
+  void render(const ImVec2& position_image, const ImVec2& origin_tile={ 0.0f, 0.0f });
+  void render_cpu(const ImVec2& position_image, const Image* image);
+  void free();
+
 private:
-  Framebuffer m_framebuffer;
+  /* pointer to canvas' fbo (its attached texture changes with mode) */
+  const Framebuffer* m_framebuffer;
+
+  /* async readback: value shown lags one or two frames behind cursor */
+  PixelReader m_pixel_reader;
+  Readback m_readback;
+  bool m_has_value;
 };
 
 #endif // TOOLTIP_PIXEL_HPP
@@ -81,8 +81,9 @@ SOFTWARE.
 #include <cstdlib>
 #include <algorithm>
 #include <iostream>
+#include <chrono>
 
-#ifdef USE_THUMBNAILS
+#if defined(USE_THUMBNAILS) && !defined(DONT_USE_STB_FOR_THUMBNAILS)
 #ifndef DONT_DEFINE_AGAIN__STB_IMAGE_IMPLEMENTATION
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -95,7 +96,7 @@ SOFTWARE.
 #endif // STB_IMAGE_RESIZE_IMPLEMENTATION
 #endif // DONT_DEFINE_AGAIN__STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb/stb_image_resize.h"
-#endif // USE_THUMBNAILS
+#endif // USE_THUMBNAILS && !DONT_USE_STB_FOR_THUMBNAILS
 
 namespace IGFD
 {
@@ -256,6 +257,13 @@ namespace IGFD
 #define IMGUI_RADIO_BUTTON inRadioButton
 #endif // IMGUI_RADIO_BUTTON
 #endif  // USE_THUMBNAILS
+// background directory scan
+#ifndef countSortedMin
+#define countSortedMin 64U
+#endif // countSortedMin
+#ifndef countScanCacheMax
+#define countScanCacheMax 16U
+#endif // countScanCacheMax
 #ifdef USE_BOOKMARK
 #ifndef defaultBookmarkPaneWith
 #define defaultBookmarkPaneWith 150.0f
@@ -1446,7 +1454,8 @@ namespace IGFD
 		return fileNameExt;
 	}
 
-	void IGFD::FileManager::AddFile(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const char& vFileType)
+	std::shared_ptr<IGFD::FileInfos> IGFD::FileManager::prCreateFileInfos(const FilterManager& vFilterManager, ImGuiFileDialogFlags vFlags,
+		const std::string& vPath, const std::string& vFileName, const char& vFileType)
 	{
 		auto infos = std::make_shared<FileInfos>();
 
@@ -1455,10 +1464,10 @@ namespace IGFD
 		infos->fileNameExt_optimized = prOptimizeFilenameForSearchOperations(infos->fileNameExt);
 		infos->fileType = vFileType;
 
-		if (infos->fileNameExt.empty() || (infos->fileNameExt == "." && !vFileDialogInternal.puFilterManager.puDLGFilters.empty())) return; // filename empty or filename is the current dir '.' //-V807
-		if (infos->fileNameExt != ".." && (vFileDialogInternal.puDLGflags & ImGuiFileDialogFlags_DontShowHiddenFiles) && infos->fileNameExt[0] == '.') // dont show hidden files
-			if (!vFileDialogInternal.puFilterManager.puDLGFilters.empty() || (vFileDialogInternal.puFilterManager.puDLGFilters.empty() && infos->fileNameExt != ".")) // except "." if in directory mode //-V728
-				return;
+		if (infos->fileNameExt.empty() || (infos->fileNameExt == "." && !vFilterManager.puDLGFilters.empty())) return nullptr; // filename empty or filename is the current dir '.' //-V807
+		if (infos->fileNameExt != ".." && (vFlags & ImGuiFileDialogFlags_DontShowHiddenFiles) && infos->fileNameExt[0] == '.') // dont show hidden files
+			if (!vFilterManager.puDLGFilters.empty() || (vFilterManager.puDLGFilters.empty() && infos->fileNameExt != ".")) // except "." if in directory mode //-V728
+				return nullptr;
 
 		if (infos->fileType == 'f' ||
 			infos->fileType == 'l') // link can have the same extention of a file
@@ -1469,18 +1478,37 @@ namespace IGFD
 				infos->fileExt = infos->fileNameExt.substr(lpt);
 			}
 
-			if (!vFileDialogInternal.puFilterManager.IsCoveredByFilters(infos->fileExt))
+			if (!vFilterManager.IsCoveredByFilters(infos->fileExt))
 			{
-				return;
+				return nullptr;
 			}
 		}
 
-		vFileDialogInternal.puFilterManager.prFillFileStyle(infos);
+		vFilterManager.prFillFileStyle(infos);
 
 		prCompleteFileInfos(infos);
-		prFileList.push_back(infos);
+		return infos;
 	}
 
+	void IGFD::FileManager::AddFile(const FileDialogInternal& vFileDialogInternal, const std::string& vPath, const std::string& vFileName, const char& vFileType)
+	{
+		auto infos = prCreateFileInfos(vFileDialogInternal.puFilterManager, vFileDialogInternal.puDLGflags, vPath, vFileName, vFileType);
+		if (infos.use_count())
+			prFileList.push_back(infos);
+	}
+
+	// shared between dialog & scan thread, which is detached so a slow directory (e.g. network share) never blocks the ui
+	struct IGFD::FileManager::ScanState
+	{
+		std::string cacheKey;
+		time_t dirModifTime = 0;
+		std::mutex mutex;
+		std::vector<std::shared_ptr<FileInfos>> files;		// scanned, not drained yet (guarded by mutex)
+		std::vector<std::shared_ptr<FileInfos>> allFiles;		// drained so far, cached once scan is done (dialog side only)
+		std::atomic<bool> isCanceled{ false };
+		std::atomic<bool> isDone{ false };
+	};
+
 	void IGFD::FileManager::ScanDir(const FileDialogInternal& vFileDialogInternal, const std::string& vPath)
 	{
 		std::string	path = vPath;
@@ -1497,65 +1525,182 @@ namespace IGFD
 				path += std::string(1u, PATH_SEP);
 #endif // WIN32
 
+			CancelScan();
 			ClearFileLists();
-
-#ifdef USE_STD_FILESYSTEM
-			//const auto wpath = IGFD::Utils::WGetString(path.c_str());
-			const std::filesystem::path fspath(path);
-			const auto dir_iter = std::filesystem::directory_iterator(fspath);
 			AddFile(vFileDialogInternal, path, "..", 'd');
-			for (const auto& file : dir_iter)
+
+			// filters & flags copied, as they can change while the thread runs
+			FilterManager filterManager = vFileDialogInternal.puFilterManager;
+			ImGuiFileDialogFlags flags = vFileDialogInternal.puDLGflags;
+			std::string cacheKey = path + '\n' + filterManager.GetSelectedFilter().filter + '\n' + std::to_string(flags);
+
+			struct stat statInfos = {};
+			time_t dirModifTime = (stat(path.c_str(), &statInfos) == 0) ? statInfos.st_mtime : 0;
+
+			// unchanged directory listed again from cache (copies, as thumbnails textures of previous listing are destroyed)
+			auto it = prScanCache.find(cacheKey);
+			if (it != prScanCache.end() && dirModifTime != 0 && it->second.dirModifTime == dirModifTime)
 			{
-				char fileType = 0;
-				if (file.is_symlink())
-					fileType = 'l';
-				else if (file.is_directory())
-					fileType = 'd';
-				else
-					fileType = 'f';
-				auto fileNameExt = file.path().filename().string();
-				AddFile(vFileDialogInternal, path, fileNameExt, fileType);
+				for (const auto& file : it->second.files)
+				{
+					auto infos = std::make_shared<FileInfos>(*file);
+#ifdef USE_THUMBNAILS
+					infos->thumbnailInfo = IGFD_Thumbnail_Info();
+#endif // USE_THUMBNAILS
+					prFileList.push_back(infos);
+				}
+
+				SortFields(vFileDialogInternal, puSortingField, false);
+				return;
 			}
-#else // dirent
-			struct dirent** files = nullptr;
-			size_t n = scandir(path.c_str(), &files, nullptr, inAlphaSort);
-			if (n)
+
+			prScan = std::make_shared<ScanState>();
+			prScan->cacheKey = cacheKey;
+			prScan->dirModifTime = dirModifTime;
+			prCountSorted = 0U;
+
+			std::shared_ptr<ScanState> scan = prScan;
+			std::thread([scan, filterManager, flags, path]()
 			{
-				size_t i;
+				// entries handed to dialog in chunks (by count or time), drained once per frame
+				const size_t countChunk = 256U;
+				const auto durationChunk = std::chrono::milliseconds(50);
+				std::vector<std::shared_ptr<FileInfos>> chunk;
+				auto timeChunk = std::chrono::steady_clock::now();
 
-				for (i = 0; i < n; i++)
+				auto addEntry = [&](const std::string& vFileName, char vFileType)
 				{
-					struct dirent* ent = files[i];
+					if (vFileName == "..")
+						return;
 
-					char fileType = 0;
-					switch (ent->d_type)
+					auto infos = prCreateFileInfos(filterManager, flags, path, vFileName, vFileType);
+					if (infos.use_count())
+						chunk.push_back(infos);
+
+					auto now = std::chrono::steady_clock::now();
+					if (chunk.size() >= countChunk || (!chunk.empty() && now - timeChunk >= durationChunk))
 					{
-					case DT_REG:
-						fileType = 'f'; break;
-					case DT_DIR:
-						fileType = 'd'; break;
-					case DT_LNK:
-						fileType = 'l'; break;
+						std::lock_guard<std::mutex> lock(scan->mutex);
+						scan->files.insert(scan->files.end(), chunk.begin(), chunk.end());
+						chunk.clear();
+						timeChunk = now;
 					}
+				};
+
+#ifdef USE_STD_FILESYSTEM
+				std::error_code error;
+				const std::filesystem::path fspath(path);
+				for (auto dir_iter = std::filesystem::directory_iterator(fspath, error);
+					!error && dir_iter != std::filesystem::directory_iterator() && !scan->isCanceled;
+					dir_iter.increment(error))
+				{
+					const auto& file = *dir_iter;
+					char fileType = 0;
+					if (file.is_symlink())
+						fileType = 'l';
+					else if (file.is_directory())
+						fileType = 'd';
+					else
+						fileType = 'f';
+					addEntry(file.path().filename().string(), fileType);
+				}
+#else // dirent
+				// readdir streams entries (scandir reads & sorts the whole directory first)
+				DIR* dir = opendir(path.c_str());
+				if (dir)
+				{
+					struct dirent* ent = nullptr;
+					while (!scan->isCanceled && (ent = readdir(dir)) != nullptr)
+					{
+						char fileType = 0;
+						switch (ent->d_type)
+						{
+						case DT_REG:
+							fileType = 'f'; break;
+						case DT_DIR:
+							fileType = 'd'; break;
+						case DT_LNK:
+							fileType = 'l'; break;
+						}
 
-					auto fileNameExt = ent->d_name;
+						addEntry(ent->d_name, fileType);
+					}
 
-					AddFile(vFileDialogInternal, path, fileNameExt, fileType);
+					closedir(dir);
 				}
+#endif // USE_STD_FILESYSTEM
 
-				for (i = 0; i < n; i++)
 				{
-					free(files[i]);
+					std::lock_guard<std::mutex> lock(scan->mutex);
+					scan->files.insert(scan->files.end(), chunk.begin(), chunk.end());
 				}
+				scan->isDone = true;
+			}).detach();
+		}
+	}
 
-				free(files);
-			}
-#endif // USE_STD_FILESYSTEM
+	void IGFD::FileManager::DrainScan(const FileDialogInternal& vFileDialogInternal)
+	{
+		if (!prScan.use_count())
+			return;
+
+		// read before taking entries, so no entry pushed before completion is missed
+		const bool isDone = prScan->isDone;
+		std::vector<std::shared_ptr<FileInfos>> files;
+		{
+			std::lock_guard<std::mutex> lock(prScan->mutex);
+			files.swap(prScan->files);
+		}
 
+		// new entries filtered one by one & shown at end of list until next sort
+		for (const auto& file : files)
+		{
+			prFileList.push_back(file);
+			prScan->allFiles.push_back(file);
+			if (prIsShownInFilteredList(vFileDialogInternal, file))
+				prFilteredFileList.push_back(file);
+		}
+
+		// whole list re-sorted each time it grew by half (& when scan ends), i.e. O(log n) sorts
+		if (isDone || prFileList.size() >= prCountSorted + prCountSorted / 2U + countSortedMin)
+		{
 			SortFields(vFileDialogInternal, puSortingField, false);
+			prCountSorted = prFileList.size();
+		}
+
+		if (isDone)
+		{
+			if (prScan->dirModifTime != 0)
+			{
+				if (prScanCache.find(prScan->cacheKey) == prScanCache.end())
+					prScanCacheOrder.push_back(prScan->cacheKey);
+				prScanCache[prScan->cacheKey] = { prScan->dirModifTime, std::move(prScan->allFiles) };
+
+				while (prScanCacheOrder.size() > countScanCacheMax)
+				{
+					prScanCache.erase(prScanCacheOrder.front());
+					prScanCacheOrder.pop_front();
+				}
+			}
+
+			prScan.reset();
 		}
 	}
 
+	void IGFD::FileManager::CancelScan()
+	{
+		if (prScan.use_count())
+		{
+			prScan->isCanceled = true;
+			prScan.reset();
+		}
+	}
+
+	bool IGFD::FileManager::IsScanning() const
+	{
+		return prScan.use_count() > 0;
+	}
+
 	bool IGFD::FileManager::GetDrives()
 	{
 		auto drives = IGFD::Utils::GetDrivesList();
@@ -1652,18 +1797,22 @@ namespace IGFD
 		prFilteredFileList.clear();
 		for (const auto& file : prFileList)
 		{
-			if (!file.use_count())
-				continue;
-			bool show = true;
-			if (!file->IsTagFound(vFileDialogInternal.puSearchManager.puSearchTag))  // if search tag
-				show = false;
-			if (puDLGDirectoryMode && file->fileType != 'd') // directory mode
-				show = false;
-			if (show)
+			if (prIsShownInFilteredList(vFileDialogInternal, file))
 				prFilteredFileList.push_back(file);
 		}
 	}
 
+	bool IGFD::FileManager::prIsShownInFilteredList(const FileDialogInternal& vFileDialogInternal, const std::shared_ptr<FileInfos>& vInfos) const
+	{
+		if (!vInfos.use_count())
+			return false;
+		if (!vInfos->IsTagFound(vFileDialogInternal.puSearchManager.puSearchTag))  // if search tag
+			return false;
+		if (puDLGDirectoryMode && vInfos->fileType != 'd') // directory mode
+			return false;
+		return true;
+	}
+
 	std::string IGFD::FileManager::prRoundNumber(double vvalue, int n)
 	{
 		std::stringstream tmp;
@@ -2394,6 +2543,11 @@ namespace IGFD
 #ifdef USE_THUMBNAILS
 	void IGFD::ThumbnailFeature::prStartThumbnailFileDatasExtraction()
 	{
+		// user loader decodes thumbnails on its own threads
+		if (prLoadThumbnailFun)
+			return;
+
+#ifndef DONT_USE_STB_FOR_THUMBNAILS
 		const bool res = prThumbnailGenerationThread.use_count() && prThumbnailGenerationThread->joinable();
 		if (!res)
 		{
@@ -2408,6 +2562,7 @@ namespace IGFD
 						obj->join();
 				});
 		}
+#endif // DONT_USE_STB_FOR_THUMBNAILS
 	}
 
 	bool IGFD::ThumbnailFeature::prStopThumbnailFileDatasExtraction()
@@ -2423,6 +2578,7 @@ namespace IGFD
 	
 	void IGFD::ThumbnailFeature::prThreadThumbnailFileDatasExtractionFunc()
 	{
+#ifndef DONT_USE_STB_FOR_THUMBNAILS
 		prCountFiles = 0U;
 		prIsWorking = true;
 
@@ -2515,6 +2671,7 @@ namespace IGFD
 				}
 			}
 		}
+#endif // DONT_USE_STB_FOR_THUMBNAILS
 	}
 
 	inline void inVariadicProgressBar(float fraction, const ImVec2& size_arg, const char* fmt, ...)
@@ -2560,6 +2717,32 @@ namespace IGFD
 					//|| file->fileExt == ".hdr" => format float so in few times
 					)
 				{
+					// user loader calls back (from its own threads) once file is decoded
+					if (prLoadThumbnailFun)
+					{
+						vFileInfos->thumbnailInfo.isLoadingOrLoaded = true;
+						auto fpn = vFileInfos->filePath + std::string(1u, PATH_SEP) + vFileInfos->fileNameExt;
+						std::shared_ptr<FileInfos> file = vFileInfos;
+						prLoadThumbnailFun(fpn, [this, file](uint8_t* vDatas, int vWidth, int vHeight)
+						{
+							// failed thumbnail requested again next time file is shown
+							auto th = &file->thumbnailInfo;
+							if (!vDatas)
+							{
+								th->isLoadingOrLoaded = false;
+								return;
+							}
+
+							th->textureFileDatas = vDatas;
+							th->textureWidth = vWidth;
+							th->textureHeight = vHeight;
+							th->textureChannels = 4;
+							th->isReadyToUpload = true;
+							prAddThumbnailToCreate(file);
+						});
+						return;
+					}
+
 					// write => thread concurency issues
 					prThumbnailFileDatasToGetMutex.lock();
 					prThumbnailFileDatasToGet.push_back(vFileInfos);
@@ -2641,21 +2824,37 @@ namespace IGFD
 		prDestroyThumbnailFun = vCreateThumbnailFun;
 	}
 
+	void IGFD::ThumbnailFeature::SetLoadThumbnailCallback(const LoadThumbnailFun& vLoadThumbnailFun)
+	{
+		prLoadThumbnailFun = vLoadThumbnailFun;
+	}
+
 	void IGFD::ThumbnailFeature::ManageGPUThumbnails()
 	{
 		if (prCreateThumbnailFun)
 		{
-			if (!prThumbnailToCreate.empty())
+			// taken under lock, as loader threads keep pushing
+			// thumbnails still waiting for upload (callback may limit uploads per frame) are kept for next frame
+			std::list<std::shared_ptr<FileInfos>> thumbnailsToCreate;
+			prThumbnailToCreateMutex.lock();
+			thumbnailsToCreate.swap(prThumbnailToCreate);
+			prThumbnailToCreateMutex.unlock();
+
+			std::list<std::shared_ptr<FileInfos>> thumbnailsDelayed;
+			for (const auto& file : thumbnailsToCreate)
 			{
-				for (const auto& file : prThumbnailToCreate)
+				if (file.use_count())
 				{
-					if (file.use_count())
-					{
-						prCreateThumbnailFun(&file->thumbnailInfo);
-					}
+					prCreateThumbnailFun(&file->thumbnailInfo);
+					if (file->thumbnailInfo.isReadyToUpload)
+						thumbnailsDelayed.push_back(file);
 				}
+			}
+
+			if (!thumbnailsDelayed.empty())
+			{
 				prThumbnailToCreateMutex.lock();
-				prThumbnailToCreate.clear();
+				prThumbnailToCreate.splice(prThumbnailToCreate.begin(), thumbnailsDelayed);
 				prThumbnailToCreateMutex.unlock();
 			}
 		}
@@ -3649,6 +3848,9 @@ namespace IGFD
 					fdFile.ScanDir(prFileDialogInternal, fdFile.puDLGpath);
 				}
 
+				// entries streamed by background scan
+				fdFile.DrainScan(prFileDialogInternal);
+
 				// draw dialog parts
 				prDrawHeader(); // bookmark, directory, path
 				prDrawContent(); // bookmark, files view, side pane 
@@ -4280,6 +4482,7 @@ namespace IGFD
 
 	void IGFD::FileDialog::Close()
 	{
+		prFileDialogInternal.puFileManager.CancelScan();
 		prFileDialogInternal.puDLGkey.clear();
 		prFileDialogInternal.puShowDialog = false;
 	}
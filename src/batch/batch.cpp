@@ -0,0 +1,152 @@
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "batch/pipeline.hpp"
+#include "image/image_utils.hpp"
+#include "profiling/metrics_exporter.hpp"
+
+/**
+ * Usage: ./batch <dir_in> <dir_out> [--effects <e1,e2,...>] [--format <png|jpg|bmp|tga|raw|ppm|pgm|tif|pyr>] [--gpu]
+ *                [--threads <n>] [--decoders <n>] [--encoders <n>] [--queue <n>] [--quality <1-100>] [--level <0-9>]
+ *                [--compare <dir_reference>] [--psnr-min <dB>] [--ssim-min <0-1>] [--annotations <path>]
+ *                [--metrics <path>] [--metrics-port <port>] [--metrics-format <json|prometheus>] [--metrics-interval <s>]
+ * --effects: applied in order among grayscale, blur, gaussian:<radius>, box:<radius>, sharpen:<radius>, sobel:<radius>
+ *            (radius 1-3 for the last two), adjust:<name>=<value>[:<name>=<value>...] (black, white, brightness,
+ *            contrast, gamma, curve[0-4], gain_r/g/b folded into one lookup table), on gpu only monochrome,
+ *            and on cpu only fill:<x>:<y>:<rrggbb>[:<tolerance>] (region of similar color around pixel filled)
+ *            & threshold:<radius> (each channel binarized by mean & deviation of pixels within radius)
+ * --gpu: process with shaders through an offscreen gl context (cpu used otherwise, no display needed)
+ * --threads: threads used by cpu filters & png encoder (default: 1 per hardware thread)
+ * --quality: of jpeg outputs (default: 90)
+ * --level: speed/size trade-off of png & pyr outputs, from 0 (stored) & 1 (fastest) to 9 (smallest, default: 2)
+ * --format pyr: tiled multi-resolution file, opened instantly by main app whatever the image's size
+ * --compare: processed images compared (before encoding) to files of same name in given folder, e.g. outputs of a
+ *            previous run, psnr & ssim printed for each (same metrics as compare mode of main app, computed on cpu)
+ * --psnr-min, --ssim-min: images below either threshold (or without a reference of same size) count as failed,
+ *                         so exit code tells whether a regression happened
+ * --annotations: circles & lines (.json or .csv, see `Annotations`) drawn over each image after its effects, from one
+ *                file for all images or from files of same stem in given folder (images without one left as is)
+ * --metrics: write images done/failed, decode/encode throughput & buffer pool hits to a file periodically
+ *            (& once more when run is over), --metrics-port serves them over http on 127.0.0.1 while running
+ */
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cout << "Usage: " << argv[0] << " <dir_in> <dir_out> [--effects grayscale,blur] [--format png] [--gpu] "
+              << "[--threads n] [--decoders n] [--encoders n] [--queue n] [--quality n] [--level n] "
+              << "[--compare dir] [--psnr-min db] [--ssim-min s] [--annotations path] "
+              << "[--metrics path] [--metrics-port n] [--metrics-format json|prometheus] [--metrics-interval s]" << '\n';
+    return 1;
+  }
+
+  BatchOptions options = { argv[1], argv[2], {}, "png", false, 2, 2, 4, {}, "", 0.0, 0.0, "" };
+  for (int i_arg = 3; i_arg < argc; i_arg++) {
+    bool has_value = i_arg + 1 < argc;
+    if (std::strcmp(argv[i_arg], "--effects") == 0 && has_value) {
+      std::stringstream stream(argv[++i_arg]);
+      std::string effect;
+      while (std::getline(stream, effect, ','))
+        options.effects.push_back(effect);
+    } else if (std::strcmp(argv[i_arg], "--format") == 0 && has_value) {
+      options.format = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--gpu") == 0) {
+      options.use_gpu = true;
+    } else if (std::strcmp(argv[i_arg], "--threads") == 0 && has_value) {
+      ImageUtils::set_n_threads(std::atoi(argv[++i_arg]));
+    } else if (std::strcmp(argv[i_arg], "--decoders") == 0 && has_value) {
+      options.n_threads_decode = std::max(1, std::atoi(argv[++i_arg]));
+    } else if (std::strcmp(argv[i_arg], "--encoders") == 0 && has_value) {
+      options.n_threads_encode = std::max(1, std::atoi(argv[++i_arg]));
+    } else if (std::strcmp(argv[i_arg], "--queue") == 0 && has_value) {
+      options.size_queue = std::max(1, std::atoi(argv[++i_arg]));
+    } else if (std::strcmp(argv[i_arg], "--quality") == 0 && has_value) {
+      options.encoding.quality = std::clamp(std::atoi(argv[++i_arg]), 1, 100);
+    } else if (std::strcmp(argv[i_arg], "--level") == 0 && has_value) {
+      options.encoding.level = std::clamp(std::atoi(argv[++i_arg]), 0, 9);
+    } else if (std::strcmp(argv[i_arg], "--compare") == 0 && has_value) {
+      options.dir_reference = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--psnr-min") == 0 && has_value) {
+      options.psnr_min = std::atof(argv[++i_arg]);
+    } else if (std::strcmp(argv[i_arg], "--ssim-min") == 0 && has_value) {
+      options.ssim_min = std::atof(argv[++i_arg]);
+    } else if (std::strcmp(argv[i_arg], "--annotations") == 0 && has_value) {
+      options.path_annotations = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--metrics") == 0 && has_value) {
+      MetricsExporter::path = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--metrics-port") == 0 && has_value) {
+      MetricsExporter::port = std::atoi(argv[++i_arg]);
+    } else if (std::strcmp(argv[i_arg], "--metrics-format") == 0 && has_value) {
+      if (!MetricsExporter::parse_format(argv[++i_arg], MetricsExporter::format))
+        std::cout << "Unknown metrics format " << argv[i_arg] << ", prometheus used" << '\n';
+    } else if (std::strcmp(argv[i_arg], "--metrics-interval") == 0 && has_value) {
+      MetricsExporter::interval = std::max((float) std::atof(argv[++i_arg]), 0.1f);
+    }
+  }
+
+  for (const std::string& effect : options.effects) {
+    if (!Pipeline::is_supported(effect, options.use_gpu)) {
+      std::cout << "Effect " << effect << " not supported" << (options.use_gpu ? "" : " on cpu (try --gpu)") << '\n';
+      return 1;
+    }
+  }
+
+  // metrics written & served while images are processed, final totals written once run is over
+  MetricsExporter::get().start();
+
+  // cpu processing doesn't need any gl context (e.g. on servers without display)
+  if (!options.use_gpu) {
+    Pipeline pipeline(options);
+    bool is_success = pipeline.run();
+    MetricsExporter::get().free();
+    return is_success ? 0 : 1;
+  }
+
+  // offscreen context from a hidden window (gl 4.3 for compute shaders if available, 3.3 otherwise)
+  if (!glfwInit()) {
+    std::cout << "Failed to initialize glfw" << '\n';
+    return 1;
+  }
+
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  GLFWwindow* window = NULL;
+  const int versions[][2] = { {4, 3}, {3, 3} };
+  for (const auto& version : versions) {
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+    window = glfwCreateWindow(1, 1, "batch", NULL, NULL);
+    if (window != NULL)
+      break;
+  }
+
+  if (window == NULL) {
+    std::cout << "Failed to create offscreen OpenGL context" << '\n';
+    glfwTerminate();
+    return 1;
+  }
+
+  glfwMakeContextCurrent(window);
+  if (!gladLoadGL()) {
+    std::cout << "Failed to load Glad (OpenGL)" << "\n";
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 1;
+  }
+
+  bool is_success = false;
+  {
+    Pipeline pipeline(options);
+    is_success = pipeline.run();
+  }
+  MetricsExporter::get().free();
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+
+  return is_success ? 0 : 1;
+}
@@ -0,0 +1,507 @@
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <cstdlib>
+#include <sstream>
+
+#include "glad/glad.h"
+
+#include "framebuffer.hpp"
+#include "program.hpp"
+#include "render/renderer.hpp"
+
+#include "batch/pipeline.hpp"
+#include "image/image_utils.hpp"
+#include "image/buffer_pool.hpp"
+#include "image/image_encoder.hpp"
+#include "profiling/metrics_exporter.hpp"
+#include "effects/effect_chain.hpp"
+#include "effects/blur_kernel.hpp"
+#include "gpu/pixel_reader.hpp"
+#include "gpu/owned.hpp"
+#include "geometries/surface_ndc.hpp"
+#include "shader_exception.hpp"
+
+namespace fs = std::filesystem;
+
+Pipeline::Pipeline(const BatchOptions& options):
+  m_options(options),
+  m_queue_decoded(options.size_queue),
+  m_queue_processed(options.size_queue),
+  m_i_path(0),
+  m_n_decoders(0),
+  m_n_done(0),
+  m_n_failed(0),
+  m_n_regressions(0),
+  m_annotations()
+{
+}
+
+/**
+ * Fill given as `fill:<x>:<y>:<rrggbb>[:<tolerance>]` (seed with origin at upper-left corner, tolerance 0-255)
+ * @return false if effect isn't a valid fill
+ */
+bool Pipeline::parse_fill(const std::string& effect, FillOptions& fill) {
+  if (effect.rfind("fill:", 0) != 0)
+    return false;
+
+  std::vector<std::string> fields;
+  size_t i_start = 5;
+  while (true) {
+    size_t i_colon = effect.find(':', i_start);
+    fields.push_back(effect.substr(i_start, i_colon - i_start));
+    if (i_colon == std::string::npos)
+      break;
+    i_start = i_colon + 1;
+  }
+
+  if (fields.size() < 3 || fields.size() > 4 || fields[2].size() != 6)
+    return false;
+
+  unsigned long rgb = std::strtoul(fields[2].c_str(), NULL, 16);
+  fill.x = std::atoi(fields[0].c_str());
+  fill.y = std::atoi(fields[1].c_str());
+  fill.color[0] = (rgb >> 16) & 0xff;
+  fill.color[1] = (rgb >> 8) & 0xff;
+  fill.color[2] = rgb & 0xff;
+  fill.color[3] = 255;
+  fill.tolerance = fields.size() == 4 ? std::atoi(fields[3].c_str()) : 32;
+  return true;
+}
+
+/**
+ * Adjustments given as `adjust:<name>=<value>[:<name>=<value>...]` (names of `ColorLut::get_defaults()`)
+ * @param parameters Defaults overridden by given adjustments
+ * @return false if effect isn't a valid adjustment
+ */
+bool Pipeline::parse_adjust(const std::string& effect, std::unordered_map<std::string, float>& parameters) {
+  if (effect.rfind("adjust:", 0) != 0)
+    return false;
+
+  parameters = ColorLut::get_defaults();
+  size_t i_start = 7;
+  while (i_start <= effect.size()) {
+    size_t i_colon = std::min(effect.find(':', i_start), effect.size());
+    std::string field = effect.substr(i_start, i_colon - i_start);
+    size_t i_equal = field.find('=');
+    if (i_equal == std::string::npos || parameters.find(field.substr(0, i_equal)) == parameters.end())
+      return false;
+
+    parameters[field.substr(0, i_equal)] = std::atof(field.c_str() + i_equal + 1);
+    i_start = i_colon + 1;
+  }
+
+  return true;
+}
+
+/**
+ * Whether effect can be applied on given device
+ * Both support `grayscale`, `blur` (3x3), `gaussian:<radius>`/`box:<radius>` (running sums on cpu)
+ * `sharpen:<radius>`/`sobel:<radius>` (kernels of radius 1-3) & `adjust:<name>=<value>...`, gpu also `monochrome`
+ * & cpu also `fill:...` & `threshold:<radius>`
+ */
+bool Pipeline::is_supported(const std::string& effect, bool use_gpu) {
+  if (effect == "grayscale" || effect == "blur")
+    return true;
+
+  // fill of clicked region only has a cpu version in batch (`FloodFill` needs the app's canvas)
+  FillOptions fill;
+  if (parse_fill(effect, fill))
+    return !use_gpu;
+
+  // local threshold reads window statistics from summed-area tables built on cpu
+  if (effect.rfind("threshold:", 0) == 0)
+    return !use_gpu;
+
+  bool is_separable = effect.rfind("gaussian:", 0) == 0 || effect.rfind("box:", 0) == 0;
+  bool is_convolution = effect.rfind("sharpen:", 0) == 0 || effect.rfind("sobel:", 0) == 0;
+  std::unordered_map<std::string, float> parameters;
+  return is_separable || is_convolution || parse_adjust(effect, parameters) || (use_gpu && effect == "monochrome");
+}
+
+/**
+ * Images in input directory, sorted so runs are reproducible
+ * @return false if directory can't be listed (e.g. missing), rather than running on no images
+ */
+bool Pipeline::list_paths() {
+  const std::vector<std::string> extensions = { ".jpg", ".jpeg", ".png", ".bmp", ".tga", ".gif", ".psd", ".hdr", ".pic" };
+  std::error_code error;
+  fs::directory_iterator iterator(m_options.dir_in, error);
+  if (error) {
+    std::cout << "Failed to list " << m_options.dir_in << ": " << error.message() << '\n';
+    return false;
+  }
+
+  for (const fs::directory_entry& entry : iterator) {
+    std::string extension = entry.path().extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (entry.is_regular_file() && std::find(extensions.begin(), extensions.end(), extension) != extensions.end())
+      m_paths.push_back(entry.path().string());
+  }
+
+  std::sort(m_paths.begin(), m_paths.end());
+  return true;
+}
+
+/**
+ * Shapes of image read from annotations folder (`<stem>.json`, else `<stem>.csv`), or shared ones of a single file
+ * @return false if image's annotations file is malformed (images without one aren't annotated)
+ */
+bool Pipeline::load_annotations(Item& item) {
+  if (m_options.path_annotations.empty() || m_annotations) {
+    item.annotations = m_annotations;
+    return true;
+  }
+
+  for (const char* extension : { ".json", ".csv" }) {
+    fs::path path = fs::path(m_options.path_annotations) / fs::path(item.path_in).stem();
+    path += extension;
+    if (!fs::is_regular_file(path))
+      continue;
+
+    std::shared_ptr<Annotations> annotations = std::make_shared<Annotations>();
+    std::string error;
+    if (!annotations->load(path.string(), error)) {
+      std::cout << "Failed to load annotations of " << item.path_in << ": " << error << '\n';
+      return false;
+    }
+
+    item.annotations = annotations;
+    return true;
+  }
+
+  return true;
+}
+
+/* Burn shapes into processed pixels (tiles of image rasterized in parallel) */
+void Pipeline::annotate(Item& item, StrokeRasterizer& rasterizer) {
+  if (!item.annotations || item.annotations->empty())
+    return;
+
+  auto time_start = std::chrono::steady_clock::now();
+  item.annotations->rasterize(rasterizer, ImageView(item.image));
+
+  MetricsExporter& exporter = MetricsExporter::get();
+  exporter.add("batch_annotations_total", (double) item.annotations->get_n_shapes());
+  exporter.add("batch_annotations_seconds_total", std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count());
+}
+
+/**
+ * Run all stages until every image is encoded
+ * Gpu processing (if enabled) runs on calling thread (where gl context is current)
+ * @return false if input directory can't be listed, or an image couldn't be decoded or saved
+ */
+bool Pipeline::run() {
+  if (!list_paths())
+    return false;
+
+  // single annotations file read once for all images
+  if (!m_options.path_annotations.empty() && !fs::is_directory(m_options.path_annotations)) {
+    std::shared_ptr<Annotations> annotations = std::make_shared<Annotations>();
+    std::string error;
+    if (!annotations->load(m_options.path_annotations, error)) {
+      std::cout << "Failed to load annotations: " << error << '\n';
+      return false;
+    }
+    m_annotations = annotations;
+  }
+
+  fs::create_directories(m_options.dir_out);
+  std::cout << "Processing " << m_paths.size() << " images from " << m_options.dir_in << '\n';
+  MetricsExporter::get().set("batch_images_queued", m_paths.size());
+
+  auto time_start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> decoders;
+  m_n_decoders = m_options.n_threads_decode;
+  for (int i_thread = 0; i_thread < m_options.n_threads_decode; i_thread++)
+    decoders.push_back(std::thread(&Pipeline::decode, this));
+
+  std::vector<std::thread> encoders;
+  for (int i_thread = 0; i_thread < m_options.n_threads_encode; i_thread++)
+    encoders.push_back(std::thread(&Pipeline::encode, this));
+
+  auto join = [&]() {
+    for (std::thread& thread : decoders)
+      thread.join();
+    for (std::thread& thread : encoders)
+      thread.join();
+  };
+
+  // closes processed queue once decoded one is drained
+  // on failure (e.g. `ShaderException` from a program compiled on first use), stages stopped before rethrowing,
+  // as destroying threads still joinable would terminate the program
+  try {
+    if (m_options.use_gpu)
+      process_gpu();
+    else
+      process_cpu();
+  } catch (...) {
+    m_queue_decoded.close();
+    m_queue_processed.close();
+    join();
+
+    Item* item;
+    while (m_queue_decoded.try_pop(item)) {
+      ImageUtils::free(item->image);
+      delete item;
+    }
+    throw;
+  }
+
+  join();
+
+  double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+  BufferPool::Stats stats = BufferPool::get().get_stats();
+  std::cout << "Processed " << m_n_done << " images (" << m_n_failed << " failed) in " << duration << " s: "
+            << m_n_done / duration << " images/s" << '\n'
+            << "Buffer pool: " << stats.n_hits << " hits, " << stats.n_misses << " misses, "
+            << stats.n_bytes_peak / (1024 * 1024) << " MB peak" << '\n';
+  if (!m_options.dir_reference.empty())
+    std::cout << "Compared to " << m_options.dir_reference << ": " << m_n_regressions << " below thresholds" << '\n';
+
+  return m_n_failed == 0 && m_n_regressions == 0;
+}
+
+/* Decoding stage (one per decoding thread): takes next path until none left */
+void Pipeline::decode() {
+  while (true) {
+    size_t i_path = m_i_path++;
+    if (i_path >= m_paths.size())
+      break;
+
+    const std::string& path = m_paths[i_path];
+    fs::path path_out = fs::path(m_options.dir_out) / fs::path(path).stem();
+    path_out += "." + m_options.format;
+
+    auto time_start = std::chrono::steady_clock::now();
+    Item* item = new Item { path, path_out.string(), Image(path, false), {}, {} };
+    if (item->image.data == NULL) {
+      std::cout << "Failed to decode " << path << '\n';
+      m_n_failed++;
+      MetricsExporter::get().add("batch_images_total", 1.0, "status", "failed");
+      delete item;
+      continue;
+    }
+
+    // malformed annotations fail image rather than writing it without them
+    if (!load_annotations(*item)) {
+      m_n_failed++;
+      MetricsExporter::get().add("batch_images_total", 1.0, "status", "failed");
+      ImageUtils::free(item->image);
+      delete item;
+      continue;
+    }
+
+    // same throughput metrics as app's decoder
+    MetricsExporter& exporter = MetricsExporter::get();
+    exporter.add("decode_images_total", 1.0);
+    exporter.add("decode_pixels_total", (double) item->image.width * item->image.height);
+    exporter.add("decode_seconds_total", std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count());
+
+    // queue closed by a failed processing stage
+    if (!m_queue_decoded.push(item)) {
+      ImageUtils::free(item->image);
+      delete item;
+      break;
+    }
+  }
+
+  // last decoder to finish lets processing stage drain its queue
+  if (--m_n_decoders == 0)
+    m_queue_decoded.close();
+}
+
+/* Processing stage on cpu: effects applied in order (each filter parallelized over row bands) */
+void Pipeline::process_cpu() {
+  StrokeRasterizer rasterizer;
+  Item* item;
+  while (m_queue_decoded.pop(item)) {
+    for (const std::string& effect : m_options.effects) {
+      if (effect == "grayscale" && item->image.n_channels >= 3)
+        item->image = ImageUtils::to_grayscale(item->image);
+      else if (effect == "blur")
+        item->image = ImageUtils::blur(item->image);
+      else if (effect.rfind("box:", 0) == 0)
+        item->image = ImageUtils::box_blur(item->image, std::max(std::atoi(effect.c_str() + 4), 0));
+      else if (effect.rfind("gaussian:", 0) == 0)
+        item->image = ImageUtils::gaussian_blur(item->image, std::max(std::atoi(effect.c_str() + 9), 0));
+      else if (effect.rfind("sharpen:", 0) == 0)
+        item->image = ImageUtils::convolve(item->image, Kernel::SHARPEN, std::atoi(effect.c_str() + 8));
+      else if (effect.rfind("sobel:", 0) == 0)
+        item->image = ImageUtils::convolve(item->image, Kernel::SOBEL, std::atoi(effect.c_str() + 6));
+      else if (effect.rfind("threshold:", 0) == 0)
+        item->image = ImageUtils::threshold(item->image, std::atoi(effect.c_str() + 10));
+
+      FillOptions fill;
+      if (parse_fill(effect, fill))
+        ImageUtils::flood_fill(ImageView(item->image), fill.x, fill.y, fill.color, fill.tolerance);
+
+      // adjustments folded into one table (built once per image, only 256 entries)
+      std::unordered_map<std::string, float> parameters;
+      if (parse_adjust(effect, parameters))
+        ImageUtils::apply_lut(item->image, ColorLut(parameters));
+    }
+
+    annotate(*item, rasterizer);
+    m_queue_processed.push(item);
+  }
+
+  m_queue_processed.close();
+}
+
+/**
+ * Processing stage on gpu: image uploaded, effects chain rendered, then read back asynchronously
+ * Readback of an image overlaps with upload & rendering of next ones
+ */
+void Pipeline::process_gpu() {
+  // same shaders as canvas (throws `ShaderException` if one fails to compile)
+  ProgramTable programs;
+
+  Framebuffer framebuffer;
+  Renderer renderer(programs.get(Shader::COLOR), SurfaceNDC(), {
+    {0, "position", 2, 4, 0},
+    {1, "texture_coord", 2, 4, 2}
+  });
+
+  EffectChain chain;
+  if (ComputeEffects::is_supported())
+    chain.set_backend(Backend::COMPUTE);
+
+  for (const std::string& effect : m_options.effects) {
+    if (effect == "grayscale" || effect == "monochrome" || effect == "blur") {
+      chain.push(*find_shader(effect));
+      continue;
+    }
+
+    std::unordered_map<std::string, float> parameters;
+    if (parse_adjust(effect, parameters)) {
+      chain.push(Shader::ADJUST, parameters);
+      continue;
+    }
+
+    // convolution variant compiled for given radius
+    size_t i_colon = effect.find(':');
+    std::optional<Shader> shader = find_shader(effect.substr(0, i_colon));
+    if (shader && get_kernel(*shader)) {
+      chain.push(*shader, { { "radius", (float) std::atoi(effect.substr(i_colon + 1).c_str()) } });
+      continue;
+    }
+
+    // separable blur given as `gaussian:<radius>` or `box:<radius>`
+    BlurKernel kernel(std::atoi(effect.substr(i_colon + 1).c_str()), effect.rfind("box", 0) == 0);
+    chain.push(Shader::BLUR_SEPARABLE, kernel.to_parameters(1.0f, 0.0f));
+    chain.push(Shader::BLUR_SEPARABLE, kernel.to_parameters(0.0f, 1.0f));
+  }
+
+  // items in same order as their pending readbacks (annotated on cpu once read back, as batch doesn't link nanovg)
+  StrokeRasterizer rasterizer;
+  PixelReader pixel_reader(m_options.size_queue);
+  std::deque<Item*> items_pending;
+  Readback readback;
+
+  auto send = [&](Readback& readback) {
+    Item* item = items_pending.front();
+    items_pending.pop_front();
+    item->pixels = std::move(readback.data);
+    item->image = Image(readback.width, readback.height, readback.n_channels, item->pixels.data());
+    annotate(*item, rasterizer);
+    m_queue_processed.push(item);
+  };
+
+  Item* item;
+  while (m_queue_decoded.pop(item)) {
+    // all readback buffers in use: wait for oldest
+    if (pixel_reader.is_pending() && items_pending.size() >= m_options.size_queue && pixel_reader.wait(readback))
+      send(readback);
+
+    // rows of rgb images aren't 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    Owned<Texture2D> texture(Texture2D(item->image));
+    int n_channels = item->image.n_channels;
+    ImageUtils::free(item->image);
+
+    chain.invalidate();
+    const Texture2D& output = chain.render(renderer, programs, framebuffer, texture.get(), true);
+    framebuffer.attach_texture(output);
+    pixel_reader.request(framebuffer, 0, 0, texture->width, texture->height, n_channels);
+    items_pending.push_back(item);
+
+    // deletion deferred by driver until rendering is done
+    texture.reset();
+
+    while (pixel_reader.poll(readback))
+      send(readback);
+  }
+
+  while (!items_pending.empty() && pixel_reader.wait(readback))
+    send(readback);
+
+  m_queue_processed.close();
+
+  chain.free();
+  pixel_reader.free();
+  renderer.free();
+  framebuffer.free();
+  programs.free();
+}
+
+/**
+ * Compare processed image to reference of same file name (decoded pixels, so lossy formats don't add their error)
+ * @return false if reference is missing, of another size, or below a threshold
+ */
+bool Pipeline::compare(const Item& item) {
+  std::string name = fs::path(item.path_out).filename().string();
+  Image reference((fs::path(m_options.dir_reference) / name).string(), false);
+  Similarity similarity;
+  bool is_compared = reference.data != NULL && ImageUtils::compare(ImageView(item.image), ImageView(reference), similarity);
+  reference.free();
+
+  std::stringstream stream;
+  if (!is_compared) {
+    stream << name << ": no reference of same size" << '\n';
+    std::cout << stream.str();
+    return false;
+  }
+
+  bool is_similar = similarity.psnr >= m_options.psnr_min && similarity.ssim >= m_options.ssim_min;
+  stream << name << ": psnr " << similarity.psnr << " dB, ssim " << similarity.ssim << (is_similar ? "" : " (below thresholds)")
+         << '\n';
+  std::cout << stream.str();
+  return is_similar;
+}
+
+/* Encoding stage (one per encoding thread): writes processed images to output directory */
+void Pipeline::encode() {
+  Item* item;
+  while (m_queue_processed.pop(item)) {
+    MetricsExporter& exporter = MetricsExporter::get();
+    if (!m_options.dir_reference.empty() && !compare(*item)) {
+      m_n_regressions++;
+      exporter.add("batch_regressions_total", 1.0);
+    }
+
+    if (ImageEncoder::encode(item->image, item->path_out, m_options.encoding)) {
+      m_n_done++;
+      exporter.add("batch_images_total", 1.0, "status", "done");
+    } else {
+      std::cout << "Failed to save " << item->path_out << '\n';
+      m_n_failed++;
+      exporter.add("batch_images_total", 1.0, "status", "failed");
+    }
+
+    // pixels read back from gpu owned by item
+    if (item->pixels.empty())
+      ImageUtils::free(item->image);
+    delete item;
+
+    BufferPool::Stats stats = BufferPool::get().get_stats();
+    exporter.set("cache_hits_total", stats.n_hits, MetricType::COUNTER, "cache", "buffer_pool");
+    exporter.set("cache_misses_total", stats.n_misses, MetricType::COUNTER, "cache", "buffer_pool");
+    exporter.set("memory_cpu_bytes", stats.n_bytes_used + stats.n_bytes_cached);
+  }
+}
@@ -0,0 +1,495 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "window.hpp"
+#include "program.hpp"
+#include "framebuffer.hpp"
+#include "render/renderer.hpp"
+#include "geometries/surface_ndc.hpp"
+#include "texture_2d.hpp"
+
+#include "bench/benchmark.hpp"
+#include "bench/replay_report.hpp"
+#include "image/image_utils.hpp"
+#include "image/image_kernels.hpp"
+#include "image/image_vg.hpp"
+#include "image/stroke_rasterizer.hpp"
+#include "effects/blur_kernel.hpp"
+#include "effects/program_table.hpp"
+#include "ui/frame.hpp"
+#include "ui/perf_overlay.hpp"
+#include "profiling/gpu_timer.hpp"
+#include "gpu/owned.hpp"
+#include "gpu/gpu_resources.hpp"
+#include "commands/session_log.hpp"
+
+namespace {
+  struct Resolution {
+    int width;
+    int height;
+  };
+
+  const Resolution RESOLUTIONS[] = { {640, 480}, {1920, 1080}, {3840, 2160}, {7680, 4320} };
+  const int N_CHANNELS[] = { 1, 3, 4 };
+  const int RADII_BLUR[] = { 5, 20, 50 };
+  const int N_FRAMES = 10;
+  const int N_SHAPES = 10000;
+
+  /* max. share of channels differing between cpu & gpu strokes (more is reported as a failure of the run) */
+  const double SHARE_DIFFERENT_MAX = 0.01;
+
+  /* Circles & lines at seeded positions in nanovg coords (same shapes for cpu & gpu runs) */
+  template <typename Draw>
+  void draw_shapes(const Resolution& resolution, const Draw& draw) {
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution_x(0.0f, resolution.width);
+    std::uniform_real_distribution<float> distribution_y(0.0f, resolution.height);
+    for (int i_shape = 0; i_shape < N_SHAPES; i_shape++) {
+      float x = distribution_x(generator), y = distribution_y(generator);
+      bool is_circle = i_shape % 2 == 0;
+      draw(is_circle, x, y, x + distribution_x(generator) / 8.0f, y + distribution_y(generator) / 8.0f);
+    }
+  }
+
+  /* Cpu filters for each instruction set supported & with 1 vs all threads (same seeded pixels for all runs) */
+  void bench_cpu(Benchmark& benchmark) {
+    const ImageKernels::Isa isas[] = {
+      ImageKernels::Isa::SCALAR, ImageKernels::Isa::SSE4, ImageKernels::Isa::AVX2, ImageKernels::Isa::NEON
+    };
+    int n_threads_max = ImageUtils::get_n_threads();
+    std::mt19937 generator(0);
+
+    for (const Resolution& resolution : RESOLUTIONS) {
+      for (int n_channels : N_CHANNELS) {
+        std::vector<unsigned char> pixels_in(resolution.width * resolution.height * n_channels);
+        std::vector<unsigned char> pixels_out(pixels_in.size());
+        for (unsigned char& pixel : pixels_in)
+          pixel = generator() & 0xff;
+        ImageView view_in(pixels_in.data(), resolution.width, resolution.height, n_channels);
+
+        for (ImageKernels::Isa isa : isas) {
+          if (!ImageKernels::select(isa))
+            continue;
+
+          for (int n_threads : { 1, n_threads_max }) {
+            ImageUtils::set_n_threads(n_threads);
+            BenchmarkResult info = { "", ImageKernels::get_name(isa), resolution.width, resolution.height, n_channels, n_threads };
+
+            // grayscale averages rgb components
+            if (n_channels >= 3) {
+              info.name = "cpu_grayscale";
+              benchmark.measure_cpu(info, [&]() { ImageUtils::to_grayscale(view_in, pixels_out.data()); });
+            }
+
+            info.name = "cpu_blur";
+            benchmark.measure_cpu(info, [&]() { ImageUtils::blur(view_in, pixels_out.data()); });
+
+            if (n_threads_max == 1)
+              break;
+          }
+        }
+      }
+    }
+
+    // shapes binned into tiles rasterized in parallel
+    for (const Resolution& resolution : RESOLUTIONS) {
+      std::vector<unsigned char> pixels(resolution.width * resolution.height * 4, 0x80);
+      ImageView view(pixels.data(), resolution.width, resolution.height, 4);
+      StrokeRasterizer rasterizer;
+
+      for (int n_threads : { 1, n_threads_max }) {
+        ImageUtils::set_n_threads(n_threads);
+        BenchmarkResult info = { "cpu_strokes", "shapes=" + std::to_string(N_SHAPES), resolution.width, resolution.height, 4, n_threads };
+        benchmark.measure_cpu(info, [&]() {
+          draw_shapes(resolution, [&](bool is_circle, float x1, float y1, float x2, float y2) {
+            if (is_circle)
+              rasterizer.draw_circle(view, x1, y1);
+            else
+              rasterizer.draw_line(view, x1, y1, x2, y2);
+          });
+          rasterizer.flush();
+        });
+
+        if (n_threads_max == 1)
+          break;
+      }
+    }
+
+    // local threshold from summed-area tables (same cost whatever the radius)
+    for (const Resolution& resolution : RESOLUTIONS) {
+      std::vector<unsigned char> pixels_in(resolution.width * resolution.height);
+      std::vector<unsigned char> pixels_out(pixels_in.size());
+      for (unsigned char& pixel : pixels_in)
+        pixel = generator() & 0xff;
+      ImageView view_in(pixels_in.data(), resolution.width, resolution.height, 1);
+      ImageView view_out(pixels_out.data(), resolution.width, resolution.height, 1);
+
+      for (int radius : RADII_BLUR) {
+        BenchmarkResult info = { "cpu_threshold", "radius=" + std::to_string(radius), resolution.width, resolution.height, 1, n_threads_max };
+        benchmark.measure_cpu(info, [&]() { ImageUtils::threshold(view_in, view_out, radius); });
+      }
+    }
+
+    // restore defaults
+    ImageUtils::set_n_threads(0);
+    ImageKernels::select(ImageKernels::get().isa);
+  }
+
+  /**
+   * Local threshold of seeded pixels against one computed from windows summed pixel by pixel
+   * Summed-area tables give the same integer sums, so outputs should be identical
+   * @return false if any pixel differs
+   */
+  bool check_threshold() {
+    const int width = 97, height = 61, radius = 7;
+    std::mt19937 generator(0);
+    std::vector<unsigned char> pixels_in(width * height);
+    std::vector<unsigned char> pixels_out(pixels_in.size());
+    for (unsigned char& pixel : pixels_in)
+      pixel = generator() & 0xff;
+    ImageUtils::threshold(ImageView(pixels_in.data(), width, height, 1), ImageView(pixels_out.data(), width, height, 1), radius);
+
+    size_t n_different = 0;
+    for (int y = 0; y < height; y++) {
+      int y_min = std::max(y - radius, 0), y_max = std::min(y + radius + 1, height);
+      for (int x = 0; x < width; x++) {
+        int x_min = std::max(x - radius, 0), x_max = std::min(x + radius + 1, width);
+        uint64_t sum = 0, sum_squared = 0;
+        for (int y_window = y_min; y_window < y_max; y_window++) {
+          for (int x_window = x_min; x_window < x_max; x_window++) {
+            uint64_t value = pixels_in[y_window * width + x_window];
+            sum += value;
+            sum_squared += value * value;
+          }
+        }
+
+        double n_pixels = (double) (x_max - x_min) * (y_max - y_min);
+        double mean = (double) sum / n_pixels;
+        double variance = std::max((double) sum_squared / n_pixels - mean * mean, 0.0);
+        double threshold = mean * (1.0 + ImageUtils::THRESHOLD_K * (std::sqrt(variance) / ImageUtils::THRESHOLD_R - 1.0));
+        unsigned char expected = pixels_in[y * width + x] > threshold ? 255 : 0;
+        n_different += pixels_out[y * width + x] != expected;
+      }
+    }
+
+    std::cout << "Threshold: " << n_different << " of " << pixels_in.size()
+              << " pixels differ from windows summed pixel by pixel" << '\n';
+    return n_different == 0;
+  }
+
+  /* Single pass of each shader (same programs as canvas) on an rgba texture of each resolution */
+  void bench_gpu(Benchmark& benchmark) {
+    ProgramTable programs;
+    Renderer renderer(programs.get(Shader::COLOR), SurfaceNDC(), {
+      {0, "position", 2, 4, 0},
+      {1, "texture_coord", 2, 4, 2}
+    });
+    Framebuffer framebuffer;
+
+    for (const Resolution& resolution : RESOLUTIONS) {
+      std::vector<unsigned char> pixels(resolution.width * resolution.height * 4, 0x80);
+      Texture2D source(Image(resolution.width, resolution.height, 4, pixels.data()));
+      Texture2D target(Image(resolution.width, resolution.height, 4, NULL));
+
+      framebuffer.attach_texture(target);
+      BenchmarkResult info = { "", "", resolution.width, resolution.height, 4, 1 };
+
+      // each pass renders into a cleared fbo like `EffectChain::render_stage()`
+      auto render = [&](Shader shader, const std::unordered_map<std::string, float>& parameters) {
+        const Program& program = programs.get(shader);
+        program.use();
+        for (const auto& pair : parameters)
+          glUniform1f(programs.get_location(shader, pair.first), pair.second);
+        program.unuse();
+
+        framebuffer.bind();
+        glViewport(0, 0, resolution.width, resolution.height);
+        framebuffer.clear({ 1.0f, 1.0f, 1.0f, 1.0f });
+        renderer.program = program;
+        renderer.draw({ {"texture2d", source} });
+        framebuffer.unbind();
+      };
+
+      for (const ShaderInfo& shader : SHADERS) {
+        // compositing of layers & compare views aren't effects
+        if (shader.shader == Shader::BLUR_SEPARABLE || shader.shader == Shader::LAYER || shader.shader == Shader::COMPARE)
+          continue;
+
+        info.name = std::string("gpu_") + shader.name;
+        benchmark.measure_gpu(info, [&]() { render(shader.shader, {}); });
+      }
+
+      // horizontal pass only (vertical one costs the same)
+      for (int radius : RADII_BLUR) {
+        info.name = "gpu_blur_separable";
+        info.variant = "radius=" + std::to_string(radius);
+        std::unordered_map<std::string, float> parameters = BlurKernel(radius).to_parameters(1.0f, 0.0f);
+        benchmark.measure_gpu(info, [&]() { render(Shader::BLUR_SEPARABLE, parameters); });
+      }
+
+      source.free();
+      target.free();
+    }
+
+    renderer.free();
+    framebuffer.free();
+    programs.free();
+  }
+
+  /**
+   * Same shapes drawn by nanovg (`ImageVG`) & by cpu rasterizer on same pixels
+   * Pixels differing by more than half the contrast of the shapes printed (nanovg's context isn't antialiased,
+   * so only antialiased edges of cpu output should differ by less than that)
+   * @return false if share of differing channels exceeds `SHARE_DIFFERENT_MAX` at a resolution
+   */
+  bool bench_strokes(Benchmark& benchmark) {
+    bool is_matching = true;
+    ImageVG image_vg(GpuResources::get().get_vg());
+    StrokeRasterizer rasterizer;
+    Framebuffer framebuffer;
+
+    for (const Resolution& resolution : RESOLUTIONS) {
+      std::vector<unsigned char> pixels(resolution.width * resolution.height * 4, 0x80);
+      Texture2D target(Image(resolution.width, resolution.height, 4, pixels.data()));
+      framebuffer.attach_texture(target);
+      BenchmarkResult info = { "gpu_strokes", "shapes=" + std::to_string(N_SHAPES), resolution.width, resolution.height, 4, 1 };
+
+      auto draw_gpu = [&]() {
+        draw_shapes(resolution, [&](bool is_circle, float x1, float y1, float x2, float y2) {
+          if (is_circle)
+            image_vg.draw_circle(framebuffer, x1, y1);
+          else
+            image_vg.draw_line(framebuffer, x1, y1, x2, y2);
+        });
+        image_vg.flush();
+      };
+      benchmark.measure_gpu(info, draw_gpu);
+
+      // one draw of each on initial pixels
+      glBindTexture(GL_TEXTURE_2D, target.id);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, resolution.width, resolution.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+      glBindTexture(GL_TEXTURE_2D, 0);
+      draw_gpu();
+
+      std::vector<unsigned char> pixels_gpu(pixels.size());
+      glBindTexture(GL_TEXTURE_2D, target.id);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels_gpu.data());
+      glBindTexture(GL_TEXTURE_2D, 0);
+
+      ImageView view(pixels.data(), resolution.width, resolution.height, 4);
+      draw_shapes(resolution, [&](bool is_circle, float x1, float y1, float x2, float y2) {
+        if (is_circle)
+          rasterizer.draw_circle(view, x1, y1);
+        else
+          rasterizer.draw_line(view, x1, y1, x2, y2);
+      });
+      rasterizer.flush();
+
+      size_t n_different = 0;
+      for (size_t i_byte = 0; i_byte < pixels.size(); i_byte++)
+        n_different += std::abs(pixels[i_byte] - pixels_gpu[i_byte]) > 0x40;
+      double share_different = (double) n_different / pixels.size();
+      bool is_below = share_different <= SHARE_DIFFERENT_MAX;
+      is_matching = is_matching && is_below;
+      std::cout << "Strokes " << resolution.width << "x" << resolution.height << ": "
+                << 100.0 * share_different << "% of channels differ between cpu & gpu"
+                << (is_below ? "" : " (above threshold of " + std::to_string(100.0 * SHARE_DIFFERENT_MAX) + "%)") << '\n';
+
+      target.free();
+    }
+
+    framebuffer.free();
+    image_vg.free();
+    return is_matching;
+  }
+
+  /**
+   * Whole frame (ui, canvas & effects) with each bundled image, vsync disabled
+   * Cpu time of `Frame::render()` & gpu time of commands it issues
+   */
+  void bench_frames(Benchmark& benchmark, Window& window) {
+    std::vector<std::string> paths;
+    for (const auto& entry : std::filesystem::directory_iterator("assets/images"))
+      paths.push_back(entry.path().string());
+    std::sort(paths.begin(), paths.end());
+
+    glfwSwapInterval(0);
+    for (const std::string& path : paths) {
+      // freed even if canvas construction throws (e.g. `ShaderException`)
+      Owned<Image> image(Image(path, false));
+      Frame frame(window, image.get(), path);
+      BenchmarkResult info = { "", std::filesystem::path(path).filename().string(), image->width, image->height, image->n_channels, 1 };
+      image.reset();
+
+      auto render = [&]() {
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        frame.render();
+        window.process_events();
+      };
+
+      // let first frames upload textures & build font atlas
+      for (int i_frame = 0; i_frame < N_FRAMES; i_frame++) {
+        render();
+        window.render();
+      }
+
+      info.name = "frame_cpu";
+      benchmark.measure_cpu(info, [&]() { render(); glFinish(); });
+      info.name = "frame_gpu";
+      benchmark.measure_gpu(info, render);
+
+      frame.free();
+    }
+  }
+
+  /* initial image of `main`, which recorded sessions start from */
+  const std::string PATH_IMAGE_SESSION = "./assets/images/nature.jpg";
+
+  /**
+   * Replay recorded session (commands dispatched at same frame indices) as fast as possible, vsync disabled
+   * Frames advance imgui time by a fixed step, so a replay only depends on the log & the initial image
+   * Cpu time measured around each frame, gpu time read from `GpuTimer` (a few frames later)
+   */
+  ReplayReport bench_replay(Window& window, const std::string& path_log, float fps) {
+    SessionLog::path_replay = path_log;
+    SessionLog::fps_replay = fps;
+    PerfOverlay::is_timed = true;
+    glfwSwapInterval(0);
+
+    Owned<Image> image(Image(PATH_IMAGE_SESSION, false));
+    Frame frame(window, image.get(), PATH_IMAGE_SESSION);
+    image.reset();
+
+    ReplayReport report(path_log, fps);
+    unsigned int i_frame_gpu = 0;
+    auto add_gpu = [&]() {
+      for (const GpuTimer::Result& result : GpuTimer::get().get_results()) {
+        if (result.name == "frame" && result.i_frame != i_frame_gpu) {
+          report.add_gpu(result.duration);
+          i_frame_gpu = result.i_frame;
+        }
+      }
+    };
+
+    // window closed by quit command at end of replay
+    while (!window.is_closed()) {
+      auto time_start = std::chrono::steady_clock::now();
+      glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+      frame.render();
+      window.process_events();
+      window.render();
+      report.add_cpu(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - time_start).count());
+      add_gpu();
+    }
+
+    // gpu time of last frame
+    glFinish();
+    GpuTimer::get().collect();
+    add_gpu();
+
+    report.set_checksum(frame.get_canvas().get_checksum());
+    frame.free();
+    return report;
+  }
+}
+
+/**
+ * Usage: ./bench [--output <path>] [--cpu-only] [--replay <path> [--fps <n>]]
+ * --output: json file results are written to (default: bench.json)
+ * --cpu-only: skip gpu passes & frames (no display needed)
+ * --replay: only replay session recorded with `./main --record <path>` & write its report (frame times & checksum)
+ * --fps: simulated frame rate of replay, > 0 (default: 60)
+ * Run from repo's root, as shaders & images are loaded from `assets/`
+ */
+int main(int argc, char** argv) {
+  std::string path_output = "bench.json";
+  std::string path_replay = "";
+  float fps = 60.0f;
+  bool is_cpu_only = false;
+  for (int i_arg = 1; i_arg < argc; i_arg++) {
+    if (std::strcmp(argv[i_arg], "--output") == 0 && i_arg + 1 < argc) {
+      path_output = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--cpu-only") == 0) {
+      is_cpu_only = true;
+    } else if (std::strcmp(argv[i_arg], "--replay") == 0 && i_arg + 1 < argc) {
+      path_replay = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--fps") == 0 && i_arg + 1 < argc) {
+      // simulated frame time of replay must be positive & finite
+      char* end;
+      fps = std::strtof(argv[++i_arg], &end);
+      if (end == argv[i_arg] || *end != '\0' || !std::isfinite(fps) || fps <= 0.0f) {
+        std::cout << "Invalid frame rate " << argv[i_arg] << '\n'
+                  << "Usage: " << argv[0] << " [--output path] [--cpu-only] [--replay path [--fps n]]" << '\n';
+        return 1;
+      }
+    }
+  }
+
+  if (!path_replay.empty()) {
+    Window window("Replay");
+    if (window.is_null()) {
+      std::cout << "Failed to create window or OpenGL context" << "\n";
+      return 1;
+    }
+
+    window.make_context();
+    if (!gladLoadGL()) {
+      std::cout << "Failed to load Glad (OpenGL)" << "\n";
+      window.destroy();
+      return 1;
+    }
+
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << "\n";
+    ReplayReport report = bench_replay(window, path_replay, fps);
+    window.destroy();
+
+    report.print();
+    return report.write_json(path_output) ? 0 : 1;
+  }
+
+  Benchmark benchmark;
+  bench_cpu(benchmark);
+  bool is_matching = check_threshold();
+
+  if (!is_cpu_only) {
+    Window window("Benchmark");
+    if (window.is_null()) {
+      std::cout << "Failed to create window or OpenGL context" << "\n";
+      return 1;
+    }
+
+    window.make_context();
+    if (!gladLoadGL()) {
+      std::cout << "Failed to load Glad (OpenGL)" << "\n";
+      window.destroy();
+      return 1;
+    }
+
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << "\n";
+    bench_gpu(benchmark);
+    is_matching = bench_strokes(benchmark) && is_matching;
+    bench_frames(benchmark, window);
+    window.destroy();
+  }
+
+  // results written even if a check failed (threshold, or cpu & gpu strokes)
+  bool is_written = benchmark.write_json(path_output);
+  return is_written && is_matching ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+
+#include "glad/glad.h"
+
+#include "bench/benchmark.hpp"
+
+Benchmark::Benchmark()
+{
+}
+
+/* Time `func` with wall clock (1 warm-up run not counted) */
+const BenchmarkResult& Benchmark::measure_cpu(const BenchmarkResult& info, const std::function<void()>& func) {
+  func();
+
+  std::vector<double> durations;
+  double duration_total = 0.0;
+  while ((int) durations.size() < N_ITERATIONS_MIN ||
+         (duration_total < DURATION_MIN && (int) durations.size() < N_ITERATIONS_MAX)) {
+    auto time_start = std::chrono::steady_clock::now();
+    func();
+    double duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+    durations.push_back(duration);
+    duration_total += duration;
+  }
+
+  return add(info, durations);
+}
+
+/* Time gl commands issued by `func` with timer queries (result read right away, so gpu is drained each run) */
+const BenchmarkResult& Benchmark::measure_gpu(const BenchmarkResult& info, const std::function<void()>& func) {
+  GLuint query;
+  glGenQueries(1, &query);
+  func();
+  glFinish();
+
+  std::vector<double> durations;
+  double duration_total = 0.0;
+  while ((int) durations.size() < N_ITERATIONS_MIN ||
+         (duration_total < DURATION_MIN && (int) durations.size() < N_ITERATIONS_MAX)) {
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    func();
+    glEndQuery(GL_TIME_ELAPSED);
+
+    GLuint64 duration_ns;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &duration_ns);
+    durations.push_back(duration_ns / 1e6);
+    duration_total += duration_ns / 1e6;
+  }
+
+  glDeleteQueries(1, &query);
+  return add(info, durations);
+}
+
+/* Store result with median & min of durations & print it */
+const BenchmarkResult& Benchmark::add(BenchmarkResult result, std::vector<double>& durations) {
+  std::sort(durations.begin(), durations.end());
+  result.n_iterations = durations.size();
+  result.duration_median = durations[durations.size() / 2];
+  result.duration_min = durations.front();
+
+  std::cout << result.name << " [" << result.variant << "] " << result.width << "x" << result.height
+            << "x" << result.n_channels << " threads=" << result.n_threads << ": "
+            << result.duration_median << " ms (min " << result.duration_min << " ms)" << '\n';
+
+  m_results.push_back(result);
+  return m_results.back();
+}
+
+/* One json object per result, in order of measurement */
+bool Benchmark::write_json(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::cout << "Failed to write " << path << '\n';
+    return false;
+  }
+
+  file << "{\n  \"results\": [\n";
+  for (size_t i_result = 0; i_result < m_results.size(); i_result++) {
+    const BenchmarkResult& result = m_results[i_result];
+    file << "    {"
+         << "\"name\": \"" << result.name << "\", "
+         << "\"variant\": \"" << result.variant << "\", "
+         << "\"width\": " << result.width << ", "
+         << "\"height\": " << result.height << ", "
+         << "\"n_channels\": " << result.n_channels << ", "
+         << "\"n_threads\": " << result.n_threads << ", "
+         << "\"n_iterations\": " << result.n_iterations << ", "
+         << "\"ms_median\": " << result.duration_median << ", "
+         << "\"ms_min\": " << result.duration_min
+         << "}" << (i_result + 1 < m_results.size() ? "," : "") << '\n';
+  }
+  file << "  ]\n}\n";
+
+  return true;
+}
@@ -0,0 +1,88 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "bench/replay_report.hpp"
+
+/**
+ * @param path_log Session log replayed
+ * @param fps Simulated frame rate of replay
+ */
+ReplayReport::ReplayReport(const std::string& path_log, float fps):
+  m_path_log(path_log),
+  m_fps(fps),
+  m_checksum(0)
+{
+}
+
+/* Cpu time of one frame (incl. buffers swap, vsync disabled) */
+void ReplayReport::add_cpu(float duration) {
+  m_durations_cpu.push_back(duration);
+}
+
+/* Gpu time of one frame (frames whose timer query was skipped are missing) */
+void ReplayReport::add_gpu(float duration) {
+  m_durations_gpu.push_back(duration);
+}
+
+void ReplayReport::set_checksum(uint64_t checksum) {
+  m_checksum = checksum;
+}
+
+/* Nearest-rank percentile (0 if no durations) */
+float ReplayReport::get_percentile(std::vector<float> durations, float percentile) {
+  if (durations.empty())
+    return 0.0f;
+
+  std::sort(durations.begin(), durations.end());
+  size_t i_duration = std::min(durations.size() - 1, (size_t) (percentile / 100.0f * durations.size()));
+  return durations[i_duration];
+}
+
+std::string ReplayReport::format_checksum(uint64_t checksum) {
+  std::stringstream stream;
+  stream << std::hex << std::setw(16) << std::setfill('0') << checksum;
+  return stream.str();
+}
+
+void ReplayReport::print() const {
+  std::cout << "Replay of " << m_path_log << " (" << m_durations_cpu.size() << " frames at " << m_fps << " fps)" << '\n';
+  std::cout << "cpu: p50 " << get_percentile(m_durations_cpu, 50.0f) << " ms, p90 " << get_percentile(m_durations_cpu, 90.0f)
+            << " ms, p99 " << get_percentile(m_durations_cpu, 99.0f) << " ms, max " << get_percentile(m_durations_cpu, 100.0f) << " ms" << '\n';
+  std::cout << "gpu: p50 " << get_percentile(m_durations_gpu, 50.0f) << " ms, p90 " << get_percentile(m_durations_gpu, 90.0f)
+            << " ms, p99 " << get_percentile(m_durations_gpu, 99.0f) << " ms, max " << get_percentile(m_durations_gpu, 100.0f)
+            << " ms (" << m_durations_gpu.size() << " frames timed)" << '\n';
+  std::cout << "checksum: " << format_checksum(m_checksum) << '\n';
+}
+
+/* Percentiles of cpu & gpu frame times, & checksum as hex string (json has no 64-bit integers) */
+bool ReplayReport::write_json(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::cout << "Failed to write " << path << '\n';
+    return false;
+  }
+
+  const std::vector<float>* durations[] = { &m_durations_cpu, &m_durations_gpu };
+  const char* names[] = { "cpu", "gpu" };
+
+  file << "{\n"
+       << "  \"replay\": \"" << m_path_log << "\",\n"
+       << "  \"fps\": " << m_fps << ",\n"
+       << "  \"n_frames\": " << m_durations_cpu.size() << ",\n";
+  for (int i_clock = 0; i_clock < 2; i_clock++) {
+    const std::vector<float>& durations_clock = *durations[i_clock];
+    file << "  \"" << names[i_clock] << "\": {"
+         << "\"n_frames\": " << durations_clock.size() << ", "
+         << "\"ms_p50\": " << get_percentile(durations_clock, 50.0f) << ", "
+         << "\"ms_p90\": " << get_percentile(durations_clock, 90.0f) << ", "
+         << "\"ms_p99\": " << get_percentile(durations_clock, 99.0f) << ", "
+         << "\"ms_max\": " << get_percentile(durations_clock, 100.0f)
+         << "},\n";
+  }
+  file << "  \"checksum\": \"" << format_checksum(m_checksum) << "\"\n}\n";
+
+  return true;
+}
@@ -0,0 +1,132 @@
+#include <sstream>
+#include <iomanip>
+
+#include "commands/command.hpp"
+
+namespace {
+  const CommandType TYPES[] = {
+    CommandType::OPEN_IMAGE, CommandType::NEW_DOCUMENT, CommandType::SWITCH_DOCUMENT, CommandType::CLOSE_DOCUMENT,
+    CommandType::SAVE_IMAGE, CommandType::EXPORT_IMAGE, CommandType::BROWSE, CommandType::PLAY_SEQUENCE, CommandType::COMPARE,
+    CommandType::UNDO, CommandType::REDO, CommandType::EFFECT, CommandType::SET_BLUR, CommandType::SET_RADIUS, CommandType::SET_ADJUSTMENT,
+    CommandType::REMOVE_EFFECT, CommandType::CLEAR_EFFECTS, CommandType::SET_BACKEND, CommandType::VIEW, CommandType::ZOOM, CommandType::PAN,
+    CommandType::DRAW_CIRCLE, CommandType::DRAW_LINE, CommandType::BRUSH_TO, CommandType::END_STROKE, CommandType::ADD_LAYER,
+    CommandType::REMOVE_LAYER, CommandType::SELECT_LAYER, CommandType::SET_LAYER, CommandType::SELECT_RECT,
+    CommandType::SELECT_TO, CommandType::END_SELECTION, CommandType::CLEAR_SELECTION, CommandType::FILL,
+    CommandType::MAGIC_WAND, CommandType::LOAD_OVERLAY, CommandType::QUIT,
+  };
+}
+
+/**
+ * One line: name, value, positions & path (last as it may contain spaces)
+ * Floats written with enough digits to be read back exactly
+ */
+std::string Command::serialize() const {
+  std::stringstream stream;
+  stream << get_name(type) << ' ' << value << std::setprecision(9) << ' ' << x1 << ' ' << y1 << ' ' << x2 << ' ' << y2;
+  if (!path.empty())
+    stream << ' ' << path;
+
+  return stream.str();
+}
+
+/* Read command written by `serialize()` (false if line is malformed or names an unknown command) */
+bool Command::parse(const std::string& line, Command& command) {
+  std::stringstream stream(line);
+  std::string name;
+  command = { CommandType::QUIT };
+  if (!(stream >> name >> command.value >> command.x1 >> command.y1 >> command.x2 >> command.y2))
+    return false;
+
+  // path is rest of line after separating space
+  std::getline(stream, command.path);
+  if (!command.path.empty() && command.path[0] == ' ')
+    command.path.erase(0, 1);
+
+  for (CommandType type : TYPES) {
+    if (name == get_name(type)) {
+      command.type = type;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char* Command::get_name(CommandType type) {
+  switch (type) {
+    case CommandType::OPEN_IMAGE:
+      return "open_image";
+    case CommandType::NEW_DOCUMENT:
+      return "new_document";
+    case CommandType::SWITCH_DOCUMENT:
+      return "switch_document";
+    case CommandType::CLOSE_DOCUMENT:
+      return "close_document";
+    case CommandType::SAVE_IMAGE:
+      return "save_image";
+    case CommandType::EXPORT_IMAGE:
+      return "export_image";
+    case CommandType::BROWSE:
+      return "browse";
+    case CommandType::PLAY_SEQUENCE:
+      return "play_sequence";
+    case CommandType::COMPARE:
+      return "compare";
+    case CommandType::UNDO:
+      return "undo";
+    case CommandType::REDO:
+      return "redo";
+    case CommandType::EFFECT:
+      return "effect";
+    case CommandType::SET_BLUR:
+      return "set_blur";
+    case CommandType::SET_RADIUS:
+      return "set_radius";
+    case CommandType::SET_ADJUSTMENT:
+      return "set_adjustment";
+    case CommandType::REMOVE_EFFECT:
+      return "remove_effect";
+    case CommandType::CLEAR_EFFECTS:
+      return "clear_effects";
+    case CommandType::SET_BACKEND:
+      return "set_backend";
+    case CommandType::VIEW:
+      return "view";
+    case CommandType::ZOOM:
+      return "zoom";
+    case CommandType::PAN:
+      return "pan";
+    case CommandType::DRAW_CIRCLE:
+      return "draw_circle";
+    case CommandType::DRAW_LINE:
+      return "draw_line";
+    case CommandType::BRUSH_TO:
+      return "brush_to";
+    case CommandType::END_STROKE:
+      return "end_stroke";
+    case CommandType::ADD_LAYER:
+      return "add_layer";
+    case CommandType::REMOVE_LAYER:
+      return "remove_layer";
+    case CommandType::SELECT_LAYER:
+      return "select_layer";
+    case CommandType::SET_LAYER:
+      return "set_layer";
+    case CommandType::SELECT_RECT:
+      return "select_rect";
+    case CommandType::SELECT_TO:
+      return "select_to";
+    case CommandType::END_SELECTION:
+      return "end_selection";
+    case CommandType::CLEAR_SELECTION:
+      return "clear_selection";
+    case CommandType::FILL:
+      return "fill";
+    case CommandType::MAGIC_WAND:
+      return "magic_wand";
+    case CommandType::LOAD_OVERLAY:
+      return "load_overlay";
+    default:
+      return "quit";
+  }
+}
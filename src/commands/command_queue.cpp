@@ -0,0 +1,18 @@
+#include "commands/command_queue.hpp"
+
+/* Queue shared by ui components */
+CommandQueue& CommandQueue::get() {
+  static CommandQueue queue;
+  return queue;
+}
+
+void CommandQueue::push(const Command& command) {
+  m_commands.push_back(command);
+}
+
+/* Commands in order they were enqueued (queue left empty) */
+std::vector<Command> CommandQueue::take() {
+  std::vector<Command> commands;
+  commands.swap(m_commands);
+  return commands;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <sstream>
+
+#include "commands/session_log.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+std::string SessionLog::path_record = "";
+std::string SessionLog::path_replay = "";
+float SessionLog::fps_replay = 60.0f;
+
+/* Open file session is recorded to & read session to replay, accord. to command-line arguments */
+SessionLog::SessionLog():
+  m_i_entry(0),
+  m_is_replaying(false)
+{
+  if (!SessionLog::path_replay.empty())
+    load(SessionLog::path_replay);
+
+  if (!SessionLog::path_record.empty()) {
+    m_file_record.open(SessionLog::path_record);
+    if (!m_file_record)
+      std::cout << "Failed to open session log for recording: " << SessionLog::path_record << '\n';
+  }
+}
+
+/* Commands to replay (lines that can't be parsed are skipped) */
+void SessionLog::load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cout << "Failed to open session log to replay: " << path << '\n';
+    return;
+  }
+
+  unsigned int i_frame = 0;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty())
+      continue;
+
+    if (line.compare(0, 6, "frame ") == 0) {
+      std::stringstream(line.substr(6)) >> i_frame;
+      continue;
+    }
+
+    Command command;
+    if (Command::parse(line, command))
+      m_entries.push_back({ i_frame, command });
+    else
+      std::cout << "Invalid command in session log: " << line << '\n';
+  }
+
+  m_is_replaying = true;
+  std::cout << "Replaying " << m_entries.size() << " commands from: " << path << '\n';
+}
+
+/* Whether commands come from replayed session (ui input ignored meanwhile) */
+bool SessionLog::is_replaying() const {
+  return m_is_replaying;
+}
+
+/* Append commands dispatched at given frame (nothing written for frames without commands) */
+void SessionLog::record(unsigned int i_frame, const std::vector<Command>& commands) {
+  if (!m_file_record.is_open() || commands.empty())
+    return;
+
+  m_file_record << "frame " << i_frame << '\n';
+  for (const Command& command : commands)
+    m_file_record << command.serialize() << '\n';
+}
+
+/**
+ * Commands recorded at given frame (& earlier ones not dispatched yet), only called on frames where canvas is idle
+ * Quit command returned once all commands are replayed, so a replay can be run unattended
+ */
+std::vector<Command> SessionLog::replay(unsigned int i_frame) {
+  std::vector<Command> commands;
+  if (!m_is_replaying)
+    return commands;
+
+  // quit at first idle frame after last command (e.g. once a final save is written)
+  if (m_i_entry == m_entries.size()) {
+    std::cout << "Replay finished after " << i_frame << " frames" << '\n';
+    commands.push_back({ CommandType::QUIT });
+    m_is_replaying = false;
+    return commands;
+  }
+
+  while (m_i_entry < m_entries.size() && m_entries[m_i_entry].i_frame <= i_frame) {
+    commands.push_back(m_entries[m_i_entry].command);
+    m_i_entry++;
+  }
+
+  return commands;
+}
+
+void SessionLog::free() {
+  if (m_file_record.is_open())
+    m_file_record.close();
+}
@@ -0,0 +1,54 @@
+#include <cmath>
+#include <algorithm>
+
+#include "effects/blur_kernel.hpp"
+
+/**
+ * Precompute weights & offsets of linearly-sampled taps (called only when radius changes)
+ * @param radius Half-width of kernel in pixels (gaussian's sigma = radius / 3)
+ * @param is_box Uniform weights instead of gaussian ones
+ */
+BlurKernel::BlurKernel(int radius, bool is_box) {
+  radius = std::clamp(radius, 1, RADIUS_MAX);
+
+  // discrete weights of 1 side (incl. center) normalized over whole kernel
+  std::vector<float> weights_discrete(radius + 1);
+  float sigma = radius / 3.0f;
+  float sum = 0.0f;
+  for (int i = 0; i <= radius; i++) {
+    weights_discrete[i] = is_box ? 1.0f : std::exp(-(i * i) / (2.0f * sigma * sigma));
+    sum += (i == 0) ? weights_discrete[i] : 2.0f * weights_discrete[i];
+  }
+
+  for (float& weight : weights_discrete)
+    weight /= sum;
+
+  // texels (i, i+1) fetched at once at offset weighted towards the heavier one
+  weights.push_back(weights_discrete[0]);
+  offsets.push_back(0.0f);
+  for (int i = 1; i <= radius; i += 2) {
+    float weight_1 = weights_discrete[i];
+    float weight_2 = (i + 1 <= radius) ? weights_discrete[i + 1] : 0.0f;
+    weights.push_back(weight_1 + weight_2);
+    offsets.push_back((i * weight_1 + (i + 1) * weight_2) / (weight_1 + weight_2));
+  }
+}
+
+/**
+ * Uniforms of `blur_separable.frag` for one pass
+ * @param direction_x,direction_y (1, 0) for horizontal pass, (0, 1) for vertical one
+ */
+std::unordered_map<std::string, float> BlurKernel::to_parameters(float direction_x, float direction_y) const {
+  std::unordered_map<std::string, float> parameters = {
+    { "direction_x", direction_x },
+    { "direction_y", direction_y },
+    { "n_taps", (float) weights.size() },
+  };
+
+  for (size_t i = 0; i < weights.size(); i++) {
+    parameters["weights[" + std::to_string(i) + "]"] = weights[i];
+    parameters["offsets[" + std::to_string(i) + "]"] = offsets[i];
+  }
+
+  return parameters;
+}
@@ -0,0 +1,142 @@
+#include "effects/compute_effects.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+bool ComputeEffects::is_enabled = true;
+
+/* Compute shaders need GL 4.3 (glad must also be generated for it) */
+bool ComputeEffects::is_supported() {
+#ifdef GL_VERSION_4_3
+  return is_enabled && GLAD_GL_VERSION_4_3;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Start building one compute program per effect (`has_failed()` then tells whether backend can be used)
+ * Builds loaded from binary cache or compiled in background by driver, effects use fragment shaders until ready
+ */
+ComputeEffects::ComputeEffects():
+  m_programs(),
+  m_builds(),
+  m_locations(),
+  m_has_failed(false)
+{
+  if (!is_supported()) {
+    m_has_failed = true;
+    return;
+  }
+
+#ifdef GL_VERSION_4_3
+  for (const ShaderInfo& info : SHADERS) {
+    if (info.path_compute == nullptr)
+      continue;
+
+    ProgramCache::Build build;
+    if (ProgramCache::start({ { GL_COMPUTE_SHADER, info.path_compute } }, build))
+      m_builds[static_cast<size_t>(info.shader)] = build;
+    else
+      m_has_failed = true;
+  }
+#endif
+}
+
+/* Compile & link compute shader or load it from binary cache (returns 0 on failure, also used by other compute passes e.g. histogram) */
+GLuint ComputeEffects::load(const std::string& path) {
+#ifdef GL_VERSION_4_3
+  return ProgramCache::load({ { GL_COMPUTE_SHADER, path } });
+#else
+  return 0;
+#endif
+}
+
+bool ComputeEffects::has_failed() const {
+  return m_has_failed;
+}
+
+/* Whether effect has a compute version ready (its build is finished once driver is done) */
+bool ComputeEffects::has(Shader shader) {
+  size_t i_shader = static_cast<size_t>(shader);
+  if (m_programs[i_shader] != 0)
+    return true;
+
+  std::optional<ProgramCache::Build>& build = m_builds[i_shader];
+  if (!build || !ProgramCache::is_ready(*build))
+    return false;
+
+  GLuint program = ProgramCache::finish(*build);
+  build.reset();
+  if (program == 0)
+    return false;
+
+  m_programs[i_shader] = program;
+  m_locations[i_shader] = ProgramTable::get_locations(program);
+  return true;
+}
+
+/**
+ * Run effect from `source` into `target` (same size, RGBA8 storage)
+ * @param parameters Float uniforms (same as fragment version of effect)
+ */
+void ComputeEffects::render(Shader shader, const std::unordered_map<std::string, float>& parameters,
+                            const Texture2D& source, const Texture2D& target) {
+#ifdef GL_VERSION_4_3
+  size_t i_shader = static_cast<size_t>(shader);
+  const std::unordered_map<std::string, GLint>& locations = m_locations[i_shader];
+  glUseProgram(m_programs[i_shader]);
+  for (const auto& pair : parameters) {
+    auto it = locations.find(pair.first);
+    if (it != locations.end())
+      glUniform1f(it->second, pair.second);
+  }
+
+  // source sampled like in fragment shader (sampler bound to unit 0 at link time), target written as image
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, source.id);
+  glBindImageTexture(0, target.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+  // blurs along a line use 1d groups (one row/column per group), other effects 2d tiles
+  int width = target.width;
+  int height = target.height;
+  if (shader == Shader::BLUR_SEPARABLE) {
+    auto it = parameters.find("direction_y");
+    bool is_vertical = it != parameters.end() && it->second > 0.5f;
+    int length_line = is_vertical ? height : width;
+    int n_lines = is_vertical ? width : height;
+    glDispatchCompute((length_line + SIZE_GROUP_LINE - 1) / SIZE_GROUP_LINE, n_lines, 1);
+  } else {
+    glDispatchCompute((width + SIZE_GROUP - 1) / SIZE_GROUP, (height + SIZE_GROUP - 1) / SIZE_GROUP, 1);
+  }
+
+  // image writes visible to later stages sampling target, & to readbacks
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+  glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+#endif
+}
+
+void ComputeEffects::free() {
+#ifdef GL_VERSION_4_3
+  for (GLuint program : m_programs) {
+    if (program != 0)
+      glDeleteProgram(program);
+  }
+
+  // builds never used (deleting them doesn't wait for driver)
+  for (std::optional<ProgramCache::Build>& build : m_builds) {
+    if (!build)
+      continue;
+
+    for (GLuint shader : build->shaders)
+      glDeleteShader(shader);
+    glDeleteProgram(build->program);
+  }
+#endif
+  m_programs.fill(0);
+  for (std::optional<ProgramCache::Build>& build : m_builds)
+    build.reset();
+  for (auto& locations : m_locations)
+    locations.clear();
+}
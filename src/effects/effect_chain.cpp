@@ -0,0 +1,648 @@
+#include <iostream>
+#include <algorithm>
+#include <limits>
+
+#include "effects/effect_chain.hpp"
+#include "gpu/pixel_format.hpp"
+#include "profiling/memory_tracker.hpp"
+
+// static members definition (avoids linking error) & initialization
+bool EffectChain::is_half_float = false;
+
+/* Depth of textures rendered by effects applied to an input of given depth */
+Depth EffectChain::get_depth_output(Depth depth_input) {
+  return is_half_float ? Depth::FLOAT16 : depth_input;
+}
+
+EffectChain::EffectChain():
+  m_id_input(0),
+  m_revision_input(1),
+  m_revision_input_rendered(0),
+  m_i_cached(0),
+  m_n_channels(4),
+  m_depth(get_depth_output(Depth::UNORM8)),
+  m_backend(Backend::FRAGMENT),
+  m_selection(NULL),
+  m_n_passes(0),
+  m_n_skipped(0),
+  m_n_tiles_frame(0)
+{
+}
+
+/**
+ * Run effects with fragment or compute shaders (falls back to fragment ones if compute shaders unsupported)
+ * Whole chain re-rendered with new backend (e.g. to compare their timings on same input)
+ */
+void EffectChain::set_backend(Backend backend) {
+  if (backend == Backend::COMPUTE && !m_compute) {
+    m_compute = std::make_unique<ComputeEffects>();
+    if (m_compute->has_failed())
+      std::cout << "Compute shaders unavailable, effects rendered with fragment shaders" << '\n';
+  }
+
+  if (backend == Backend::COMPUTE && m_compute->has_failed())
+    backend = Backend::FRAGMENT;
+
+  if (backend != m_backend) {
+    m_backend = backend;
+    invalidate();
+  }
+}
+
+Backend EffectChain::get_backend() const {
+  return m_backend;
+}
+
+/**
+ * Match format of intermediate textures to input (e.g. 16-bit or monochrome image opened), recycled ones of previous format freed
+ * @param n_channels 1 for monochrome inputs, 4 otherwise
+ */
+void EffectChain::set_format(int n_channels, Depth depth_input) {
+  Depth depth = get_depth_output(depth_input);
+  if (n_channels == m_n_channels && depth == m_depth)
+    return;
+
+  cancel();
+  for (Texture2D& texture : m_textures_free)
+    texture.free();
+  m_textures_free.clear();
+
+  if (m_texture_cached)
+    m_texture_cached->free();
+  m_texture_cached.reset();
+  if (m_texture_output)
+    m_texture_output->free();
+  m_texture_output.reset();
+
+  m_n_channels = n_channels;
+  m_depth = depth;
+  invalidate();
+}
+
+/**
+ * Restrict effects to selection (whole chain re-rendered over its bounding box)
+ * @param selection Kept by caller until reset (NULL to apply effects to whole image again)
+ */
+void EffectChain::set_selection(SelectionMask* selection) {
+  m_selection = selection;
+  invalidate();
+}
+
+/**
+ * Append effect at end of chain
+ * Current output becomes the cached input of new stage (so only new stage is rendered)
+ * @param parameters Float uniforms set on shader before rendering stage
+ */
+void EffectChain::push(Shader shader, const std::unordered_map<std::string, float>& parameters) {
+  cancel();
+  if (m_texture_output) {
+    release_cached();
+    m_texture_cached = m_texture_output;
+    m_i_cached = m_stages.size() - 1;
+    m_texture_output.reset();
+  }
+
+  m_stages.push_back({ { shader, parameters }, 1, 0, {} });
+  if (shader == Shader::ADJUST)
+    m_stages.back().lut = ColorLut(parameters);
+}
+
+/* Remove last effect (its cached input becomes chain's output if available) */
+void EffectChain::pop() {
+  if (m_stages.empty())
+    return;
+
+  cancel();
+  m_stages.pop_back();
+  if (m_texture_output) {
+    release(*m_texture_output);
+    m_texture_output.reset();
+  }
+
+  if (m_texture_cached && m_i_cached + 1 == m_stages.size()) {
+    m_texture_output = m_texture_cached;
+    m_texture_cached.reset();
+  } else if (m_texture_cached && m_i_cached >= m_stages.size()) {
+    release_cached();
+  }
+}
+
+/* Remove all effects */
+void EffectChain::clear() {
+  while (!m_stages.empty())
+    pop();
+
+  if (m_texture_output) {
+    release(*m_texture_output);
+    m_texture_output.reset();
+  }
+}
+
+/**
+ * Change uniform of given stage (only this stage & next ones are re-rendered)
+ * @param i_stage Index of stage in chain
+ */
+void EffectChain::set_parameter(size_t i_stage, const std::string& name, float value) {
+  Stage& stage = m_stages.at(i_stage);
+  auto it = stage.effect.parameters.find(name);
+  if (it != stage.effect.parameters.end() && it->second == value)
+    return;
+
+  stage.effect.parameters[name] = value;
+  stage.revision++;
+  if (stage.lut)
+    stage.lut = ColorLut(stage.effect.parameters);
+}
+
+/* Mark input content as changed (e.g. shapes drawn), so whole chain is re-rendered */
+void EffectChain::invalidate() {
+  m_revision_input++;
+}
+
+/**
+ * Render stages whose output is outdated, starting from cached intermediate texture when possible
+ * Time-sliced render only runs the tiles fitting in this frame's budget, & is resumed on next call
+ * Framebuffer attachment & viewport are changed, renderer's program is restored afterwards
+ * @param programs Fragment programs of effects (compiled on first use, unless effect is run by compute shader)
+ * @param input Texture chain is applied to
+ * @param is_complete Run remaining tiles whatever their cost (e.g. output saved right away)
+ * @return Output of last stage (`input` itself if chain is empty),
+ *         previous output (or `input` before a first one) while a time-sliced render is pending
+ */
+const Texture2D& EffectChain::render(Renderer& renderer, ProgramTable& programs, Framebuffer& framebuffer,
+                                     const Texture2D& input, bool is_complete) {
+  if (m_stages.empty())
+    return input;
+
+  // job started from a changed input or parameter restarted from current ones
+  if (m_job && !is_current(*m_job, input))
+    cancel();
+
+  if (!m_job && !start(input)) {
+    m_n_skipped++;
+    return *m_texture_output;
+  }
+
+  // tiles of this frame timed together (their cost sets # of tiles in next frames)
+  int n_tiles_max = is_complete ? std::numeric_limits<int>::max() : m_scheduler.get_n_tiles_frame();
+  Program program_view = renderer.program;
+  m_scheduler.begin();
+  m_n_tiles_frame = run(renderer, programs, framebuffer, input, n_tiles_max);
+  m_scheduler.end(m_n_tiles_frame);
+  renderer.program = program_view;
+
+  if (m_job)
+    return m_texture_output ? *m_texture_output : input;
+
+  return *m_texture_output;
+}
+
+/**
+ * Start job re-rendering stages from first changed one
+ * @return false if output is up-to-date (nothing to render)
+ */
+bool EffectChain::start(const Texture2D& input) {
+  // any change of input invalidates every cached texture
+  bool has_input_changed = input.id != m_id_input || m_revision_input != m_revision_input_rendered;
+  if (has_input_changed)
+    release_cached();
+
+  // first stage with changed parameter (or without rendered output)
+  size_t n_stages = m_stages.size();
+  size_t i_dirty = n_stages;
+  for (size_t i_stage = 0; i_stage < n_stages; i_stage++) {
+    const Stage& stage = m_stages[i_stage];
+    if (has_input_changed || stage.revision != stage.revision_rendered) {
+      i_dirty = i_stage;
+      break;
+    }
+  }
+
+  if (!m_texture_output)
+    i_dirty = std::min(i_dirty, m_texture_cached ? m_i_cached + 1 : 0);
+
+  if (i_dirty == n_stages)
+    return false;
+
+  // cached texture outdated if produced by a changed stage
+  if (m_texture_cached && m_i_cached >= i_dirty)
+    release_cached();
+
+  // outdated output still shown while a time-sliced job runs (if it has input's size)
+  bool is_kept = m_scheduler.is_enabled() && m_texture_output &&
+                 m_texture_output->width == input.width && m_texture_output->height == input.height;
+  if (m_texture_output && !is_kept) {
+    release(*m_texture_output);
+    m_texture_output.reset();
+  }
+
+  // resume from cached intermediate texture if it precedes first changed stage
+  size_t i_start = m_texture_cached ? m_i_cached + 1 : 0;
+  Texture2D source = m_texture_cached ? *m_texture_cached : input;
+
+  // single tile over whole image without a frame budget
+  int n_tiles_x = 1, n_tiles_y = 1;
+  if (m_scheduler.is_enabled()) {
+    n_tiles_x = (input.width + TileScheduler::SIZE_TILE - 1) / TileScheduler::SIZE_TILE;
+    n_tiles_y = (input.height + TileScheduler::SIZE_TILE - 1) / TileScheduler::SIZE_TILE;
+  }
+
+  std::vector<unsigned int> revisions;
+  for (const Stage& stage : m_stages)
+    revisions.push_back(stage.revision);
+
+  int n_tiles_total = (int) (n_stages - i_start) * n_tiles_x * n_tiles_y + (m_selection ? 1 : 0);
+  m_job = Job {
+    input.id, input.width, input.height, m_revision_input, revisions,
+    i_dirty, i_start, 0, n_tiles_x, n_tiles_y, 0, n_tiles_total,
+    source, {}
+  };
+
+  return true;
+}
+
+/* Whether job was started from current input & parameters of stages */
+bool EffectChain::is_current(const Job& job, const Texture2D& input) const {
+  if (job.id_input != input.id || job.width != input.width || job.height != input.height ||
+      job.revision_input != m_revision_input || job.revisions.size() != m_stages.size())
+    return false;
+
+  for (size_t i_stage = 0; i_stage < m_stages.size(); i_stage++) {
+    if (job.revisions[i_stage] != m_stages[i_stage].revision)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Run next tiles of job (in order of stages, as a stage samples whole output of previous one)
+ * Output published (& job ended) once all stages & selection's blend are rendered
+ * @param n_tiles_max Tiles rendered at most (those outside selection skipped without counting)
+ * @return # of tiles rendered
+ */
+int EffectChain::run(Renderer& renderer, ProgramTable& programs, Framebuffer& framebuffer, const Texture2D& input,
+                     int n_tiles_max) {
+  Job& job = *m_job;
+  size_t n_stages = m_stages.size();
+  int n_tiles_stage = job.n_tiles_x * job.n_tiles_y;
+
+  // pixels of a stage sampled by later ones around selection (sum of their radii)
+  std::vector<int> margins(n_stages, 0);
+  for (size_t i_stage = n_stages - 1; i_stage > 0; i_stage--)
+    margins[i_stage - 1] = margins[i_stage] + get_radius(m_stages[i_stage]);
+
+  int n_tiles = 0;
+  while (job.i_stage < n_stages && n_tiles < n_tiles_max) {
+    Stage& stage = m_stages[job.i_stage];
+    if (!job.target)
+      job.target = acquire(input.width, input.height);
+
+    // untiled stage may run a compute shader over whole image
+    bool is_rendered;
+    if (n_tiles_stage == 1) {
+      is_rendered = render_stage(stage, renderer, programs, framebuffer, job.source, *job.target, margins[job.i_stage], NULL);
+    } else {
+      int x = (job.i_tile % job.n_tiles_x) * TileScheduler::SIZE_TILE;
+      int y = (job.i_tile / job.n_tiles_x) * TileScheduler::SIZE_TILE;
+      DirtyRegion::Rect tile = {
+        x, y, std::min(TileScheduler::SIZE_TILE, input.width - x), std::min(TileScheduler::SIZE_TILE, input.height - y)
+      };
+      is_rendered = render_stage(stage, renderer, programs, framebuffer, job.source, *job.target, margins[job.i_stage], &tile);
+    }
+
+    job.i_tile++;
+    job.n_tiles_done++;
+    if (is_rendered)
+      n_tiles++;
+    if (job.i_tile < n_tiles_stage)
+      continue;
+
+    // source recycled unless it's the input or the cached intermediate texture
+    bool is_source_pooled = job.source.id != input.id && !(m_texture_cached && job.source.id == m_texture_cached->id);
+
+    // input of first changed stage kept, as it's likely to be edited again
+    if (job.i_stage + 1 == job.i_dirty && job.i_stage + 1 < n_stages) {
+      if (is_source_pooled)
+        release(job.source);
+      release_cached();
+      m_texture_cached = job.target;
+      m_i_cached = job.i_stage;
+    } else if (is_source_pooled) {
+      release(job.source);
+    }
+
+    job.source = *job.target;
+    job.target.reset();
+    job.i_tile = 0;
+    job.i_stage++;
+    m_n_passes++;
+  }
+
+  // selection's blend left to next frame if budget is spent
+  if (job.i_stage < n_stages || (m_selection && n_tiles >= n_tiles_max))
+    return n_tiles;
+
+  // effects mixed with input accord. to selection's mask (input itself sampled outside mask)
+  Texture2D output = job.source;
+  if (m_selection) {
+    output = acquire(input.width, input.height);
+    m_selection->blend(renderer, framebuffer, input, job.source, output);
+    if (job.source.id != input.id && !(m_texture_cached && job.source.id == m_texture_cached->id))
+      release(job.source);
+
+    job.n_tiles_done++;
+    n_tiles++;
+    m_n_passes++;
+  }
+
+  for (Stage& stage : m_stages)
+    stage.revision_rendered = stage.revision;
+
+  if (m_texture_output)
+    release(*m_texture_output);
+  m_texture_output = output;
+  m_id_input = job.id_input;
+  m_revision_input_rendered = job.revision_input;
+  m_job.reset();
+
+  return n_tiles;
+}
+
+/* Drop job in progress & textures it rendered so far (output of its last completed render kept) */
+void EffectChain::cancel() {
+  if (!m_job)
+    return;
+
+  if (m_job->target)
+    release(*m_job->target);
+  if (m_job->source.id != m_job->id_input && !(m_texture_cached && m_job->source.id == m_texture_cached->id))
+    release(m_job->source);
+
+  m_job.reset();
+}
+
+/* Whether a time-sliced render is waiting for next frames (output returned meanwhile is outdated) */
+bool EffectChain::is_pending() const {
+  return m_job.has_value();
+}
+
+/* Fraction of pending render's tiles done (negative if none pending) */
+float EffectChain::get_progress() const {
+  if (!m_job)
+    return -1.0f;
+
+  return (float) m_job->n_tiles_done / std::max(m_job->n_tiles_total, 1);
+}
+
+/**
+ * Render `source` with stage's shader & uniforms into `target`
+ * @param margin Pixels around selection's bounding box rendered too (sampled by later stages)
+ * @param tile Region of `target` rendered (NULL for whole target)
+ * @return false if tile is outside selection's bounding box (nothing rendered)
+ */
+bool EffectChain::render_stage(const Stage& stage, Renderer& renderer, ProgramTable& programs, Framebuffer& framebuffer,
+                               const Texture2D& source, const Texture2D& target, int margin, const DirtyRegion::Rect* tile) {
+  // compute shaders bind their images as rgba8 (& dispatch over whole image, so selections & tiles use fragment shaders)
+  Shader shader = stage.effect.shader;
+  bool is_rgba8 = m_n_channels == 4 && m_depth == Depth::UNORM8;
+  if (m_backend == Backend::COMPUTE && m_compute->has(shader) && is_rgba8 && !m_selection && tile == NULL) {
+    m_compute->render(shader, stage.effect.parameters, source, target);
+    return true;
+  }
+
+  // scissored to tile & to selection's bounding box
+  DirtyRegion::Rect rect = tile ? *tile : DirtyRegion::Rect { 0, 0, target.width, target.height };
+  if (m_selection) {
+    const DirtyRegion::Rect& rect_selection = m_selection->get_rect();
+    DirtyRegion::Rect rect_grown = {
+      rect_selection.x - margin, rect_selection.y - margin,
+      rect_selection.width + 2 * margin, rect_selection.height + 2 * margin
+    };
+    if (!DirtyRegion::intersect(rect, rect_grown, rect))
+      return false;
+  }
+
+  // uniforms other than textures are kept by program until next change (locations cached by table)
+  int variant = ProgramTable::get_variant(shader, stage.effect.parameters);
+  const Program& program = programs.get(shader, variant);
+  program.use();
+  for (const auto& pair : stage.effect.parameters)
+    glUniform1f(programs.get_location(shader, pair.first, variant), pair.second);
+  if (stage.lut)
+    glUniform1i(programs.get_location(shader, "texture_lut"), 1);
+  program.unuse();
+
+  if (stage.lut) {
+    upload_lut(*stage.lut);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_texture_lut->id);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+  framebuffer.attach_texture(target);
+  framebuffer.bind();
+  glViewport(0, 0, target.width, target.height);
+  bool is_scissored = tile || m_selection;
+  if (is_scissored) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(rect.x, rect.y, rect.width, rect.height);
+  }
+  framebuffer.clear({ 1.0f, 1.0f, 1.0f, 1.0f });
+
+  renderer.program = program;
+  renderer.draw({ {"texture2d", source} });
+  framebuffer.unbind();
+
+  if (is_scissored)
+    glDisable(GL_SCISSOR_TEST);
+
+  if (stage.lut) {
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+  return true;
+}
+
+/* Upload table of adjustment stage (texture created on first use, filtered linearly for half-float inputs) */
+void EffectChain::upload_lut(const ColorLut& lut) {
+  if (!m_texture_lut) {
+    m_texture_lut = Texture2D(Image(ColorLut::SIZE, 1, 4, NULL));
+    glBindTexture(GL_TEXTURE_2D, m_texture_lut->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ColorLut::SIZE, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, m_texture_lut->id);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, ColorLut::SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, lut.table.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* Texture of given size (& chain's format), recycled from a previous pass if possible */
+Texture2D EffectChain::acquire(int width, int height) {
+  // textures of previous image's size no longer needed
+  for (auto it = m_textures_free.begin(); it != m_textures_free.end(); ) {
+    if (it->width == width && it->height == height) {
+      Texture2D texture = *it;
+      m_textures_free.erase(it);
+      return texture;
+    }
+
+    it->free();
+    it = m_textures_free.erase(it);
+  }
+
+  // sized format required to bind texture as image in compute shaders
+  // linear filtering needed by effects sampling between texels (e.g. separable blur)
+  Texture2D texture(Image(width, height, m_n_channels, NULL));
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glTexImage2D(GL_TEXTURE_2D, 0, PixelFormat::get_format_sized(m_n_channels, m_depth), width, height, 0, texture.format,
+               PixelFormat::get_type(m_depth), NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  PixelFormat::swizzle_gray(texture);
+
+  // entry dropped by `MemoryTracker::prune()` once texture is freed
+  std::string format = std::to_string(m_n_channels) + " ch " + PixelFormat::get_name(m_depth);
+  MemoryTracker::get().track(MemoryKind::TEXTURE, texture.id, "effect passes", format,
+                             (size_t) width * height * m_n_channels * PixelFormat::get_n_bytes_channel(m_depth));
+  return texture;
+}
+
+/* Give texture back for reuse by later passes (freed if enough are kept) */
+void EffectChain::release(const Texture2D& texture) {
+  if (m_textures_free.size() < N_TEXTURES_FREE)
+    m_textures_free.push_back(texture);
+  else
+    texture.free();
+}
+
+void EffectChain::release_cached() {
+  if (!m_texture_cached)
+    return;
+
+  release(*m_texture_cached);
+  m_texture_cached.reset();
+}
+
+/* Effects in order of application (e.g. to show them in ui) */
+std::vector<Effect> EffectChain::get_effects() const {
+  std::vector<Effect> effects;
+  for (const Stage& stage : m_stages)
+    effects.push_back(stage.effect);
+
+  return effects;
+}
+
+bool EffectChain::is_empty() const {
+  return m_stages.empty();
+}
+
+/**
+ * Distance (in pixels) over which a change to input spreads in output (sum of kernels' radii)
+ * +1 as taps of separable blur are sampled linearly between two texels
+ */
+int EffectChain::get_radius() const {
+  int radius = 0;
+  for (const Stage& stage : m_stages)
+    radius += get_radius(stage);
+
+  return radius;
+}
+
+/* Distance over which given stage spreads a change (0 for per-pixel effects) */
+int EffectChain::get_radius(const Stage& stage) {
+  if (stage.effect.shader == Shader::BLUR)
+    return 1;
+
+  if (stage.effect.shader == Shader::BLUR_SEPARABLE) {
+    auto it = stage.effect.parameters.find("radius");
+    return (it != stage.effect.parameters.end() ? (int) it->second : 0) + 1;
+  }
+
+  if (get_kernel(stage.effect.shader))
+    return ProgramTable::get_variant(stage.effect.shader, stage.effect.parameters);
+
+  return 0;
+}
+
+/* Stages rendered so far vs. renders skipped bcoz output was up-to-date (for profiling) */
+unsigned int EffectChain::get_n_passes() const {
+  return m_n_passes;
+}
+
+unsigned int EffectChain::get_n_skipped() const {
+  return m_n_skipped;
+}
+
+/**
+ * Gpu time of last render of the chain in ms, or of its last slice if time-sliced
+ * (updated once result available, i.e. a frame or two later)
+ */
+float EffectChain::get_duration_gpu() {
+  return m_scheduler.get_duration();
+}
+
+/* Tiles rendered by last call to `render()` & smoothed cost of a tile in ms (negative until measured) */
+int EffectChain::get_n_tiles_frame() const {
+  return m_n_tiles_frame;
+}
+
+float EffectChain::get_duration_tile() const {
+  return m_scheduler.get_duration_tile();
+}
+
+/* Vram held by intermediate textures (e.g. for memory budget of documents) */
+size_t EffectChain::get_n_bytes() const {
+  size_t n_bytes_pixel = m_n_channels * PixelFormat::get_n_bytes_channel(m_depth);
+  size_t n_pixels = 0;
+  if (m_texture_output)
+    n_pixels += (size_t) m_texture_output->width * m_texture_output->height;
+  if (m_texture_cached)
+    n_pixels += (size_t) m_texture_cached->width * m_texture_cached->height;
+  if (m_job && m_job->target)
+    n_pixels += (size_t) m_job->target->width * m_job->target->height;
+  for (const Texture2D& texture : m_textures_free)
+    n_pixels += (size_t) texture.width * texture.height;
+
+  return n_pixels * n_bytes_pixel;
+}
+
+/* Free intermediate textures but keep stages (whole chain re-rendered on next render) */
+void EffectChain::evict() {
+  cancel();
+  release_cached();
+  if (m_texture_output)
+    m_texture_output->free();
+  m_texture_output.reset();
+
+  for (Texture2D& texture : m_textures_free)
+    texture.free();
+  m_textures_free.clear();
+  invalidate();
+}
+
+void EffectChain::free() {
+  cancel();
+  if (m_compute)
+    m_compute->free();
+  m_scheduler.free();
+  if (m_texture_lut)
+    m_texture_lut->free();
+  m_texture_lut.reset();
+
+  release_cached();
+  if (m_texture_output)
+    m_texture_output->free();
+  m_texture_output.reset();
+
+  for (Texture2D& texture : m_textures_free)
+    texture.free();
+  m_textures_free.clear();
+}
@@ -0,0 +1,151 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+
+#include "effects/program_table.hpp"
+#include "gpu/program_cache.hpp"
+
+#include "shader_exception.hpp"
+
+/* Shader with given name (e.g. effect given on command-line), empty if unknown */
+std::optional<Shader> find_shader(const std::string& name) {
+  for (const ShaderInfo& info : SHADERS) {
+    if (name == info.name)
+      return info.shader;
+  }
+
+  return {};
+}
+
+/**
+ * Locations of active uniforms of linked program (array elements listed individually, e.g. `weights[3]`)
+ * Sampler `texture2d` bound to texture unit 0 (the one textures are rendered from)
+ */
+std::unordered_map<std::string, GLint> ProgramTable::get_locations(GLuint program) {
+  std::unordered_map<std::string, GLint> locations;
+  GLint n_uniforms = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &n_uniforms);
+
+  for (GLint i_uniform = 0; i_uniform < n_uniforms; i_uniform++) {
+    char name[256];
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(program, i_uniform, sizeof(name), NULL, &size, &type, name);
+
+    // name of arrays ends with `[0]`
+    std::string base = name;
+    size_t i_bracket = base.find('[');
+    if (i_bracket == std::string::npos) {
+      locations[base] = glGetUniformLocation(program, name);
+      continue;
+    }
+
+    base.resize(i_bracket);
+    for (GLint i_element = 0; i_element < size; i_element++) {
+      std::string name_element = base + "[" + std::to_string(i_element) + "]";
+      locations[name_element] = glGetUniformLocation(program, name_element.c_str());
+    }
+  }
+
+  auto it = locations.find("texture2d");
+  if (it != locations.end()) {
+    glUseProgram(program);
+    glUniform1i(it->second, 0);
+    glUseProgram(0);
+  }
+
+  return locations;
+}
+
+/* Radius of variant of convolution shader (clamped to instantiated kernels), 0 for other shaders */
+int ProgramTable::get_variant(Shader shader, int radius) {
+  return get_kernel(shader) ? std::clamp(radius, 1, RADIUS_MAX_CONVOLUTION) : 0;
+}
+
+/* Variant picked by `radius` parameter of effect */
+int ProgramTable::get_variant(Shader shader, const std::unordered_map<std::string, float>& parameters) {
+  auto it = parameters.find("radius");
+  return get_variant(shader, it != parameters.end() ? (int) it->second : 1);
+}
+
+/**
+ * Source of shader with kernel's constants inserted after its `#version` line, written next to cached programs
+ * (`Program` compiles from files), `#line` keeps compilation errors pointing at lines of original source
+ * @return Path of variant (empty on failure)
+ */
+std::string ProgramTable::write_variant(const ShaderInfo& info, Kernel kernel, int radius) {
+  std::ifstream file_in(info.path_fragment);
+  std::string line_version;
+  if (!file_in || !std::getline(file_in, line_version))
+    return "";
+
+  std::stringstream stream;
+  stream << file_in.rdbuf();
+
+  std::error_code error;
+  std::filesystem::create_directories(ProgramCache::get_dir_cache(), error);
+  std::string name = std::string(info.name) + "_" + std::to_string(radius) + ".frag";
+  std::string path = (std::filesystem::path(ProgramCache::get_dir_cache()) / name).string();
+
+  std::ofstream file_out(path);
+  file_out << line_version << '\n' << get_kernel_defines(kernel, radius) << "#line 2\n" << stream.str();
+  file_out.close();
+  return file_out ? path : "";
+}
+
+ProgramTable::ProgramTable():
+  m_entries()
+{
+}
+
+/**
+ * Program of shader, compiled with `fbo.vert` on first request
+ * Throws `ShaderException` if one of its shaders failed to compile
+ * @param radius Picks variant of convolution shaders (ignored by others)
+ */
+const Program& ProgramTable::get(Shader shader, int radius) {
+  radius = get_variant(shader, radius);
+  Entry& entry = m_entries[static_cast<size_t>(shader)][radius];
+  if (entry.program)
+    return *entry.program;
+
+  const ShaderInfo& info = get_shader_info(shader);
+  std::optional<Kernel> kernel = get_kernel(shader);
+  std::string path_fragment = kernel ? write_variant(info, *kernel, radius) : info.path_fragment;
+  if (path_fragment.empty())
+    throw ShaderException();
+
+  Program program("assets/shaders/fbo.vert", path_fragment);
+  if (program.has_failed()) {
+    program.free();
+    throw ShaderException();
+  }
+
+  entry.program = program;
+  entry.locations = get_locations(program.id);
+  return *entry.program;
+}
+
+/* Location of uniform cached at link time (-1 if inactive, like `glGetUniformLocation()`) */
+GLint ProgramTable::get_location(Shader shader, const std::string& name, int radius) const {
+  const std::unordered_map<int, Entry>& variants = m_entries[static_cast<size_t>(shader)];
+  auto it_variant = variants.find(get_variant(shader, radius));
+  if (it_variant == variants.end())
+    return -1;
+
+  const Entry& entry = it_variant->second;
+  auto it = entry.locations.find(name);
+  return it != entry.locations.end() ? it->second : -1;
+}
+
+void ProgramTable::free() {
+  for (std::unordered_map<int, Entry>& variants : m_entries) {
+    for (auto& pair : variants) {
+      if (pair.second.program)
+        pair.second.program->free();
+    }
+
+    variants.clear();
+  }
+}
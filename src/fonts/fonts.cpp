@@ -1,25 +1,199 @@
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+
 #include "imgui.h"
-#include "IconsFontAwesome5.h"
 
 #include "fonts/fonts.hpp"
+#include "fonts/icons.hpp"
+
+namespace {
+  const char MAGIC[8] = { 'A', 'T', 'L', 'S', '0', '0', '0', '1' };
+
+  const char* PATH_TEXT = "assets/fonts/DroidSans.ttf";
+  const char* PATH_ICONS = "assets/fonts/fa-solid-900.ttf";
+  const float SIZE_PIXEL = 16.0f;
+
+  bool read_file(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+      return false;
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+    content = stream.str();
+    return true;
+  }
+
+  template <typename T>
+  void write_value(std::ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  bool read_value(std::ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+
+  /**
+   * Cache key: imgui version (glyphs stored as raw structs), fonts contents, size & glyph ranges
+   * Fonts contents hashed rather than their mtime, as assets are usually copied along executable
+   */
+  bool get_key(const ImVector<ImWchar>& ranges_icons, std::string& key) {
+    std::string font_text, font_icons;
+    if (!read_file(PATH_TEXT, font_text) || !read_file(PATH_ICONS, font_icons))
+      return false;
+
+    std::stringstream stream;
+    stream << IMGUI_VERSION << '|' << SIZE_PIXEL << '|' << std::hash<std::string>()(font_text) << '|'
+           << std::hash<std::string>()(font_icons) << '|';
+    for (ImWchar c : ranges_icons)
+      stream << c << ',';
+
+    std::stringstream name;
+    name << std::hex << std::hash<std::string>()(stream.str()) << ".atlas";
+    key = name.str();
+    return true;
+  }
+
+  /* Pixels (alpha8), baked lines & merged font's glyphs of built atlas (temporary file renamed once complete) */
+  void write_atlas(const std::string& path, ImFontAtlas* atlas) {
+    unsigned char* pixels;
+    int width, height;
+    atlas->GetTexDataAsAlpha8(&pixels, &width, &height);
+    const ImFont* font = atlas->Fonts[0];
+
+    std::string path_tmp = path + ".tmp";
+    {
+      std::ofstream file(path_tmp, std::ios::binary);
+      file.write(MAGIC, sizeof(MAGIC));
+      write_value(file, width);
+      write_value(file, height);
+      write_value(file, atlas->TexUvWhitePixel);
+      write_value(file, atlas->TexUvLines);
+
+      write_value(file, font->FontSize);
+      write_value(file, font->Ascent);
+      write_value(file, font->Descent);
+      write_value(file, font->FallbackChar);
+      write_value(file, font->EllipsisChar);
+      write_value(file, font->DotChar);
+      write_value(file, font->Glyphs.Size);
+      file.write(reinterpret_cast<const char*>(font->Glyphs.Data), font->Glyphs.Size * sizeof(ImFontGlyph));
+      file.write(reinterpret_cast<const char*>(pixels), width * height);
+      if (!file)
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(path_tmp, path, error);
+  }
+
+  /**
+   * Restore atlas as left by `ImFontAtlas::Build()`, without rasterizing glyphs
+   * Software mouse cursors disabled (their rects aren't restored)
+   * @return false if file is missing or truncated (atlas left empty)
+   */
+  bool read_atlas(const std::string& path, ImFontAtlas* atlas) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+      return false;
+
+    int width, height, n_glyphs;
+    ImVec2 uv_white;
+    ImVec4 uv_lines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    float size, ascent, descent;
+    ImWchar char_fallback, char_ellipsis, char_dot;
+    if (!read_value(file, width) || !read_value(file, height) || !read_value(file, uv_white) || !read_value(file, uv_lines) ||
+        !read_value(file, size) || !read_value(file, ascent) || !read_value(file, descent) ||
+        !read_value(file, char_fallback) || !read_value(file, char_ellipsis) || !read_value(file, char_dot) ||
+        !read_value(file, n_glyphs) || width <= 0 || height <= 0 || n_glyphs <= 0)
+      return false;
+
+    ImVector<ImFontGlyph> glyphs;
+    glyphs.resize(n_glyphs);
+    unsigned char* pixels = (unsigned char*) IM_ALLOC(width * height);
+    if (!file.read(reinterpret_cast<char*>(glyphs.Data), n_glyphs * sizeof(ImFontGlyph)) ||
+        !file.read(reinterpret_cast<char*>(pixels), width * height)) {
+      IM_FREE(pixels);
+      return false;
+    }
+
+    // freed by atlas like built ones
+    ImFont* font = IM_NEW(ImFont);
+    font->FontSize = size;
+    font->Ascent = ascent;
+    font->Descent = descent;
+    font->FallbackChar = char_fallback;
+    font->EllipsisChar = char_ellipsis;
+    font->DotChar = char_dot;
+    font->Glyphs.swap(glyphs);
+    font->ContainerAtlas = atlas;
+    font->BuildLookupTable();
+    atlas->Fonts.push_back(font);
+
+    atlas->Flags |= ImFontAtlasFlags_NoMouseCursors;
+    atlas->TexPixelsAlpha8 = pixels;
+    atlas->TexWidth = width;
+    atlas->TexHeight = height;
+    atlas->TexUvScale = ImVec2(1.0f / width, 1.0f / height);
+    atlas->TexUvWhitePixel = uv_white;
+    std::memcpy(atlas->TexUvLines, uv_lines, sizeof(uv_lines));
+    atlas->TexReady = true;
+
+    return true;
+  }
+}
+
+/* `$XDG_CACHE_HOME` (or `~/.cache`) subfolder, local folder if neither is set */
+std::string Fonts::get_dir_cache() {
+  const char* dir_xdg = std::getenv("XDG_CACHE_HOME");
+  const char* dir_home = std::getenv("HOME");
+  std::filesystem::path dir = (dir_xdg && *dir_xdg) ? std::filesystem::path(dir_xdg) :
+                              (dir_home && *dir_home) ? std::filesystem::path(dir_home) / ".cache" : ".cache";
+
+  return (dir / "imgui-example" / "fonts").string();
+}
 
 /**
- * Load DroidSans text font & fontAwesome icon font
- * `ImGui::GetIO()` requires ImGui context to have been created
+ * Load DroidSans text font & fontAwesome icons used by ui (see `Icons::USED`)
+ * Atlas restored from disk cache when fonts & ranges haven't changed, otherwise built & cached
+ * Only touches given atlas (e.g. `ImGui::GetIO().Fonts`), so it can run on a worker thread before first frame
  */
-void Fonts::load() {
+void Fonts::load(ImFontAtlas* atlas) {
+  // glyph ranges of icons (instead of whole fontAwesome range)
+  ImFontGlyphRangesBuilder builder;
+  for (const char* icon : Icons::USED)
+    builder.AddText(icon);
+  ImVector<ImWchar> ranges_icons;
+  builder.BuildRanges(&ranges_icons);
+
+  std::string path_cache;
+  std::string key;
+  if (get_key(ranges_icons, key)) {
+    std::error_code error;
+    std::filesystem::create_directories(get_dir_cache(), error);
+    path_cache = (std::filesystem::path(get_dir_cache()) / key).string();
+    if (read_atlas(path_cache, atlas))
+      return;
+  }
+
   // load droid-sans text font (first font loaded used by default without push/pop)
-  ImGuiIO& io = ImGui::GetIO(); // configures imgui
-  float size_pixel = 16.0f;
-  ImFont* font = io.Fonts->AddFontFromFileTTF("assets/fonts/DroidSans.ttf", size_pixel);
+  atlas->AddFontFromFileTTF(PATH_TEXT, SIZE_PIXEL);
 
   // merge font-awesome icons with previous font (droid-sans)
   ImFontConfig icon_font_config;
   icon_font_config.MergeMode = true;
-  const ImWchar range_glyphs[] = { ICON_MIN_FA, ICON_MAX_FA, 0 };
-  ImFont* font_icon = io.Fonts->AddFontFromFileTTF("assets/fonts/fa-solid-900.ttf", size_pixel, &icon_font_config, range_glyphs);
+  atlas->AddFontFromFileTTF(PATH_ICONS, SIZE_PIXEL, &icon_font_config, ranges_icons.Data);
 
-  // font's texture atlas normally auto built but `range_glyphs` needs to be persistent when called
+  // font's texture atlas normally auto built but `ranges_icons` needs to be persistent when called
   // https://github.com/ocornut/imgui/blob/master/docs/FONTS.md
-  io.Fonts->Build();
+  atlas->Build();
+
+  if (!path_cache.empty())
+    write_atlas(path_cache, atlas);
 }
@@ -0,0 +1,134 @@
+#include <chrono>
+
+#include "gpu/annotation_overlay.hpp"
+#include "gpu/texture_pool.hpp"
+#include "profiling/gpu_timer.hpp"
+#include "profiling/tracer.hpp"
+
+AnnotationOverlay::AnnotationOverlay():
+  m_annotations(),
+  m_id_stencil(0),
+  m_revision(0),
+  m_stats { 0, 0, 0.0 }
+{
+}
+
+/* Replace shapes by those of a .json or .csv file (format in `Annotations`), kept as is on failure */
+bool AnnotationOverlay::load(const std::string& path, std::string& error) {
+  return m_annotations.load(path, error);
+}
+
+void AnnotationOverlay::clear() {
+  m_annotations.clear();
+  free();
+}
+
+bool AnnotationOverlay::empty() const {
+  return m_annotations.empty();
+}
+
+const Annotations& AnnotationOverlay::get_annotations() const {
+  return m_annotations;
+}
+
+/**
+ * Texture with shapes of overlay, rendered again only if they changed since (or image was resized)
+ * Called each frame overlay is shown (between nanovg frames, i.e. not while `ImageVG` flushes)
+ * @param vg Nanovg context shared by documents
+ * @param width,height Of image shapes are drawn over
+ * @return Texture drawn over image, NULL if overlay is empty
+ */
+const Texture2D* AnnotationOverlay::update(NVGcontext* vg, int width, int height) {
+  if (m_annotations.empty())
+    return NULL;
+
+  bool is_same_size = m_texture && m_texture->width == width && m_texture->height == height;
+  if (is_same_size && m_revision == m_annotations.get_revision())
+    return &*m_texture;
+
+  if (!is_same_size) {
+    if (m_texture)
+      TexturePool::get().release(*m_texture);
+    m_texture = TexturePool::get().acquire(width, height, 4, Depth::UNORM8, OWNER);
+    if (!m_framebuffer)
+      m_framebuffer.emplace();
+    if (m_id_stencil == 0)
+      glGenRenderbuffers(1, &m_id_stencil);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, m_id_stencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  }
+
+  render(vg);
+  m_revision = m_annotations.get_revision();
+  return &*m_texture;
+}
+
+/* All shapes drawn in one nanovg frame over cleared texture, with one path (& one fill or stroke) per batch */
+void AnnotationOverlay::render(NVGcontext* vg) {
+  PROFILE_ZONE("AnnotationOverlay::render");
+  auto time_start = std::chrono::steady_clock::now();
+  GpuTimer::get().begin("annotation overlay");
+
+  m_framebuffer->attach_texture(*m_texture);
+  m_framebuffer->bind();
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_id_stencil);
+  glViewport(0, 0, m_texture->width, m_texture->height);
+  m_framebuffer->clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+  glClearStencil(0);
+  glClear(GL_STENCIL_BUFFER_BIT);
+
+  // positions of shapes have their origin at upper-left corner of image (nanovg's is at lower-left one)
+  float height = m_texture->height;
+  nvgBeginFrame(vg, m_texture->width, m_texture->height, 1.0f);
+
+  for (const Annotations::Batch& batch : m_annotations.get_batches()) {
+    NVGcolor color = nvgRGBAf(batch.style.r, batch.style.g, batch.style.b, batch.style.a);
+    nvgBeginPath(vg);
+
+    if (batch.type == Annotations::Type::CIRCLE) {
+      for (const Annotations::Shape& shape : batch.shapes)
+        nvgCircle(vg, shape.x1, height - shape.y1, batch.style.size);
+      nvgFillColor(vg, color);
+      nvgFill(vg);
+    } else {
+      for (const Annotations::Shape& shape : batch.shapes) {
+        nvgMoveTo(vg, shape.x1, height - shape.y1);
+        nvgLineTo(vg, shape.x2, height - shape.y2);
+      }
+      nvgStrokeWidth(vg, batch.style.size);
+      nvgStrokeColor(vg, color);
+      nvgStroke(vg);
+    }
+  }
+
+  nvgEndFrame(vg);
+
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+  m_framebuffer->unbind();
+  GpuTimer::get().end("annotation overlay");
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - time_start;
+  m_stats.n_renders++;
+  m_stats.n_paths_last_render = m_annotations.get_batches().size();
+  m_stats.duration_last_render = duration.count();
+}
+
+const AnnotationOverlay::Stats& AnnotationOverlay::get_stats() const {
+  return m_stats;
+}
+
+/* Gpu resources given back (shapes kept, rendered again by next update) */
+void AnnotationOverlay::free() {
+  if (m_texture)
+    TexturePool::get().release(*m_texture);
+  if (m_framebuffer)
+    m_framebuffer->free();
+  if (m_id_stencil != 0)
+    glDeleteRenderbuffers(1, &m_id_stencil);
+
+  m_texture.reset();
+  m_framebuffer.reset();
+  m_id_stencil = 0;
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cmath>
+
+#include "gpu/edge_map.hpp"
+#include "gpu/texture_pool.hpp"
+
+EdgeMap::EdgeMap():
+  m_id_source(0),
+  m_revision(0),
+  m_readback(),
+  m_has_readback(false),
+  m_x_requested(-1),
+  m_y_requested(-1),
+  m_revision_requested(0)
+{
+}
+
+/**
+ * Render gradients of `source` over regions changed since last update (whole texture when source was replaced)
+ * Called while a snapping tool is active only, so edges aren't computed for documents nobody snaps on
+ * @param source Image with its drawn shapes (effects not applied)
+ */
+void EdgeMap::update(Renderer& renderer, ProgramTable& programs, const Texture2D& source, const DirtyRegion& dirty) {
+  bool is_same_source = m_texture && source.id == m_id_source &&
+                        source.width == m_texture->width && source.height == m_texture->height;
+
+  // 1px around changed tiles also affected (3x3 kernel)
+  DirtyRegion::Rect rect = { 0, 0, source.width, source.height };
+  if (is_same_source && !dirty.get_bounds(m_revision, 1, rect))
+    return;
+
+  if (!is_same_source) {
+    if (m_texture)
+      TexturePool::get().release(*m_texture);
+    m_texture = TexturePool::get().acquire(source.width, source.height, 4, Depth::UNORM8, OWNER);
+    if (!m_framebuffer)
+      m_framebuffer.emplace();
+    m_has_readback = false;
+    m_x_requested = m_y_requested = -1;
+  }
+
+  m_framebuffer->attach_texture(*m_texture);
+  m_framebuffer->bind();
+  glViewport(0, 0, m_texture->width, m_texture->height);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(rect.x, rect.y, rect.width, rect.height);
+
+  Program program_view = renderer.program;
+  renderer.program = programs.get(Shader::SOBEL, ProgramTable::get_variant(Shader::SOBEL, 1));
+  renderer.draw({ {"texture2d", source} });
+  renderer.program = program_view;
+
+  glDisable(GL_SCISSOR_TEST);
+  m_framebuffer->unbind();
+
+  m_id_source = source.id;
+  m_revision = dirty.get_revision();
+}
+
+/**
+ * Read back window of gradients around pixel (non-blocking, dropped if previous ones are still in flight)
+ * Called every frame cursor hovers image with snapping tool, latest finished window kept for `snap()`
+ * Same window isn't requested again until cursor moves to another pixel or edges are updated
+ */
+void EdgeMap::request(int x, int y) {
+  if (!m_texture)
+    return;
+
+  if (!m_pixel_reader)
+    m_pixel_reader.emplace();
+
+  while (m_pixel_reader->poll(m_readback))
+    m_has_readback = true;
+
+  if (x == m_x_requested && y == m_y_requested && m_revision == m_revision_requested)
+    return;
+
+  int x_min = std::clamp(x - RADIUS, 0, m_texture->width - 1);
+  int y_min = std::clamp(y - RADIUS, 0, m_texture->height - 1);
+  int x_max = std::clamp(x + RADIUS + 1, 1, m_texture->width);
+  int y_max = std::clamp(y + RADIUS + 1, 1, m_texture->height);
+  if (m_pixel_reader->request(*m_framebuffer, x_min, y_min, x_max - x_min, y_max - y_min, 4)) {
+    m_x_requested = x;
+    m_y_requested = y;
+    m_revision_requested = m_revision;
+  }
+}
+
+/* Whether a window is still being read back (result available in a later frame) */
+bool EdgeMap::is_pending() const {
+  return m_pixel_reader && m_pixel_reader->is_pending();
+}
+
+/**
+ * Strongest edge within `RADIUS` of position in latest window read back (nearest one among equally strong pixels)
+ * Window may lag a frame or two behind cursor, only its pixels are searched then
+ * @param x_snapped,y_snapped Center of pixel snapped to
+ * @return false if no pixel nearby is above `THRESHOLD` (position left as is)
+ */
+bool EdgeMap::snap(float x, float y, float& x_snapped, float& y_snapped) {
+  if (!m_has_readback)
+    return false;
+
+  const Readback& readback = m_readback;
+  int magnitude_max = THRESHOLD - 1;
+  float distance_min = 0.0f;
+  bool is_found = false;
+  for (int y_window = 0; y_window < readback.height; y_window++) {
+    for (int x_window = 0; x_window < readback.width; x_window++) {
+      float x_pixel = readback.x + x_window + 0.5f, y_pixel = readback.y + y_window + 0.5f;
+      float distance = std::hypot(x_pixel - x, y_pixel - y);
+      if (distance > RADIUS)
+        continue;
+
+      // gradients of each channel (strongest one counts, so edges between colors of same luminance are kept)
+      const unsigned char* pixel = &readback.data[((size_t) y_window * readback.width + x_window) * 4];
+      int magnitude = std::max({ pixel[0], pixel[1], pixel[2] });
+      if (magnitude > magnitude_max || (magnitude == magnitude_max && is_found && distance < distance_min)) {
+        magnitude_max = magnitude;
+        distance_min = distance;
+        x_snapped = x_pixel;
+        y_snapped = y_pixel;
+        is_found = true;
+      }
+    }
+  }
+
+  return is_found;
+}
+
+void EdgeMap::free() {
+  if (m_texture)
+    TexturePool::get().release(*m_texture);
+  if (m_framebuffer)
+    m_framebuffer->free();
+  if (m_pixel_reader)
+    m_pixel_reader->free();
+
+  m_texture.reset();
+  m_framebuffer.reset();
+  m_pixel_reader.reset();
+  m_has_readback = false;
+  m_id_source = 0;
+  m_x_requested = m_y_requested = -1;
+}
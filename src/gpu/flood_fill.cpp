@@ -0,0 +1,210 @@
+#include <algorithm>
+
+#include "gpu/flood_fill.hpp"
+#include "gpu/texture_pool.hpp"
+
+#include "shader_exception.hpp"
+
+namespace {
+  Program compile(const char* path_fragment) {
+    Program program("assets/shaders/fbo.vert", path_fragment);
+    if (program.has_failed()) {
+      program.free();
+      throw ShaderException();
+    }
+
+    return program;
+  }
+}
+
+FloodFill::FloodFill():
+  m_program_grow(),
+  m_program_fill(),
+  m_masks(),
+  m_i_mask(0),
+  m_rect({ 0, 0, 0, 0 }),
+  m_query(0),
+  m_n_passes(0)
+{
+}
+
+/* Programs & query created on first fill (throws `ShaderException` if a shader fails to compile) */
+void FloodFill::init() {
+  if (m_program_grow)
+    return;
+
+  m_program_grow = compile("assets/shaders/flood_fill.frag");
+  m_program_fill = compile("assets/shaders/fill.frag");
+  glGenQueries(1, &m_query);
+
+  // colors compared sampled from unit 1 (region from unit 0, bound by renderer)
+  m_program_grow->use();
+  glUniform1i(glGetUniformLocation(m_program_grow->id, "texture2d"), 0);
+  glUniform1i(glGetUniformLocation(m_program_grow->id, "texture_color"), 1);
+  glUniform1i(glGetUniformLocation(m_program_grow->id, "radius"), RADIUS);
+  m_program_grow->unuse();
+}
+
+/* Masks matching image's size (previous ones given back to pool) */
+void FloodFill::acquire(int width, int height) {
+  for (std::optional<Texture2D>& mask : m_masks) {
+    if (mask && (mask->width != width || mask->height != height)) {
+      TexturePool::get().release(*mask);
+      mask.reset();
+    }
+
+    if (!mask)
+      mask = TexturePool::get().acquire(width, height, 1, Depth::UNORM8, "flood fill");
+  }
+}
+
+/**
+ * Grow region from seed until it stops changing (mask & its bounds then given by `get_mask()` & `get_rect()`)
+ * Framebuffer attachment & viewport are changed, renderer's program is restored afterwards
+ * @param image Texture whose colors are compared (read on gpu only)
+ * @param x,y Seed in image pixels (origin at upper-left corner)
+ * @param tolerance Max. difference of any channel with seed's color (in [0, 1])
+ * @return false if seed is outside image
+ */
+bool FloodFill::grow(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& image, int x, int y, float tolerance) {
+  if (x < 0 || y < 0 || x >= image.width || y >= image.height)
+    return false;
+
+  init();
+  acquire(image.width, image.height);
+
+  GLuint id_program = m_program_grow->id;
+  GLint location_bounds = glGetUniformLocation(id_program, "bounds");
+  GLint location_direction = glGetUniformLocation(id_program, "direction");
+  m_program_grow->use();
+  glUniform2i(glGetUniformLocation(id_program, "seed"), x, y);
+  glUniform1f(glGetUniformLocation(id_program, "tolerance"), tolerance);
+  glUniform4i(location_bounds, 0, 0, 0, 0);
+  m_program_grow->unuse();
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, image.id);
+  glActiveTexture(GL_TEXTURE0);
+
+  Program program_view = renderer.program;
+  renderer.program = *m_program_grow;
+  glViewport(0, 0, image.width, image.height);
+  glEnable(GL_SCISSOR_TEST);
+
+  // region can only have grown by `RADIUS` along direction of each pass
+  int x_min = x, y_min = y, x_max = x + 1, y_max = y + 1;
+  GLuint n_pixels_checked = 0;
+  m_n_passes = 0;
+  while (m_n_passes < N_PASSES_MAX) {
+    bool is_horizontal = m_n_passes % 2 == 0;
+    int x_min_grown = is_horizontal ? std::max(x_min - RADIUS, 0) : x_min;
+    int x_max_grown = is_horizontal ? std::min(x_max + RADIUS, image.width) : x_max;
+    int y_min_grown = is_horizontal ? y_min : std::max(y_min - RADIUS, 0);
+    int y_max_grown = is_horizontal ? y_max : std::min(y_max + RADIUS, image.height);
+
+    // source masked by bounds of previous pass (nothing valid before first one)
+    const Texture2D& source = *m_masks[m_i_mask];
+    const Texture2D& target = *m_masks[1 - m_i_mask];
+    m_program_grow->use();
+    if (m_n_passes > 0)
+      glUniform4i(location_bounds, x_min, y_min, x_max, y_max);
+    glUniform2i(location_direction, is_horizontal ? 1 : 0, is_horizontal ? 0 : 1);
+    m_program_grow->unuse();
+
+    framebuffer.attach_texture(target);
+    framebuffer.bind();
+    glScissor(x_min_grown, y_min_grown, x_max_grown - x_min_grown, y_max_grown - y_min_grown);
+    framebuffer.clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+
+    m_n_passes++;
+    bool is_checked = m_n_passes % N_PASSES_CHECK == 0;
+    if (is_checked)
+      glBeginQuery(GL_SAMPLES_PASSED, m_query);
+    renderer.draw({ {"texture2d", source} });
+    if (is_checked)
+      glEndQuery(GL_SAMPLES_PASSED);
+    framebuffer.unbind();
+
+    m_i_mask = 1 - m_i_mask;
+    x_min = x_min_grown;
+    y_min = y_min_grown;
+    x_max = x_max_grown;
+    y_max = y_max_grown;
+
+    // region unchanged over last passes (incl. a horizontal & a vertical one) can't grow anymore
+    if (is_checked) {
+      GLuint n_pixels = 0;
+      glGetQueryObjectuiv(m_query, GL_QUERY_RESULT, &n_pixels);
+      if (n_pixels == n_pixels_checked)
+        break;
+      n_pixels_checked = n_pixels;
+    }
+  }
+
+  glDisable(GL_SCISSOR_TEST);
+  renderer.program = program_view;
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+
+  m_rect = { x_min, y_min, x_max - x_min, y_max - y_min };
+  return true;
+}
+
+/**
+ * Paint last region grown with opaque color (over its bounds only)
+ * @param target Texture of same size as the one region was grown on (e.g. active layer)
+ * @param color Rgba in [0, 1]
+ */
+void FloodFill::fill(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& target, const glm::vec4& color) {
+  m_program_fill->use();
+  glUniform4f(glGetUniformLocation(m_program_fill->id, "color"), color.x, color.y, color.z, color.w);
+  m_program_fill->unuse();
+
+  framebuffer.attach_texture(target);
+  framebuffer.bind();
+  glViewport(0, 0, target.width, target.height);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(m_rect.x, m_rect.y, m_rect.width, m_rect.height);
+
+  Program program_view = renderer.program;
+  renderer.program = *m_program_fill;
+  renderer.draw({ {"texture2d", *m_masks[m_i_mask]} });
+  renderer.program = program_view;
+
+  glDisable(GL_SCISSOR_TEST);
+  framebuffer.unbind();
+}
+
+/* Region grown last (1 inside it, only valid over `get_rect()`) */
+const Texture2D& FloodFill::get_mask() const {
+  return *m_masks[m_i_mask];
+}
+
+const DirtyRegion::Rect& FloodFill::get_rect() const {
+  return m_rect;
+}
+
+/* Passes run by last growth (for profiling) */
+unsigned int FloodFill::get_n_passes() const {
+  return m_n_passes;
+}
+
+void FloodFill::free() {
+  for (std::optional<Texture2D>& mask : m_masks) {
+    if (mask)
+      TexturePool::get().release(*mask);
+    mask.reset();
+  }
+
+  if (m_program_grow)
+    m_program_grow->free();
+  if (m_program_fill)
+    m_program_fill->free();
+  m_program_grow.reset();
+  m_program_fill.reset();
+
+  if (m_query != 0)
+    glDeleteQueries(1, &m_query);
+  m_query = 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <thread>
+
+#include "gpu/gl_worker.hpp"
+
+GlWorker::Ticket::Ticket():
+  is_run(false),
+  fence(NULL)
+{
+}
+
+/* Sync objects are shared, so fence can be deleted from whichever context releases ticket last */
+GlWorker::Ticket::~Ticket() {
+  if (fence != NULL)
+    glDeleteSync(fence);
+}
+
+GlWorker::GlWorker():
+  m_window(NULL),
+  m_worker()
+{
+}
+
+/**
+ * Create hidden 1x1 window sharing objects with main one (same context hints), & make it current on worker thread
+ * Called on main thread (glfw windows can only be created there), main context stays current
+ * @return false if shared context couldn't be created
+ */
+bool GlWorker::init(GLFWwindow* window_main) {
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  m_window = glfwCreateWindow(1, 1, "gl worker", NULL, window_main);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+  if (m_window == NULL) {
+    std::cout << "Shared gl context unavailable: uploads & readbacks stay on main thread" << '\n';
+    return false;
+  }
+
+  GLFWwindow* window = m_window;
+  m_worker = std::make_unique<Worker>();
+  m_worker->submit([window]() { glfwMakeContextCurrent(window); });
+
+  return true;
+}
+
+bool GlWorker::is_available() const {
+  return m_worker != nullptr;
+}
+
+/**
+ * Queue task calling gl functions on worker's context (to call from main thread)
+ * Objects task uses must be kept alive by it until it has run (e.g. captured shared pointers)
+ */
+std::shared_ptr<GlWorker::Ticket> GlWorker::submit(const std::function<void()>& task) {
+  // flushed so worker's context sees main thread's commands once fence is signaled
+  GLsync fence_main = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glFlush();
+
+  std::shared_ptr<Ticket> ticket = std::make_shared<Ticket>();
+  m_worker->submit([ticket, task, fence_main]() {
+    glWaitSync(fence_main, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(fence_main);
+    task();
+
+    ticket->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+    ticket->is_run = true;
+  });
+
+  return ticket;
+}
+
+/**
+ * Whether task ran & gpu finished its commands (non-blocking, to call from main thread)
+ * Objects it modified must be re-bound on main context to see their new content
+ */
+bool GlWorker::is_done(Ticket& ticket) {
+  if (!ticket.is_run)
+    return false;
+  if (ticket.fence == NULL)
+    return true;
+
+  // timeout = 0: only query fence status
+  GLenum status = glClientWaitSync(ticket.fence, 0, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    return false;
+
+  glDeleteSync(ticket.fence);
+  ticket.fence = NULL;
+  return true;
+}
+
+/* Block until task ran & gpu finished its commands (for one-off consumers that need the result right away) */
+void GlWorker::wait(Ticket& ticket) {
+  while (!ticket.is_run)
+    std::this_thread::yield();
+
+  if (ticket.fence != NULL) {
+    glClientWaitSync(ticket.fence, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(ticket.fence);
+    ticket.fence = NULL;
+  }
+}
+
+/* Finish pending tasks, then destroy shared context (on main thread) */
+void GlWorker::free() {
+  if (m_worker == nullptr)
+    return;
+
+  m_worker->submit([]() { glfwMakeContextCurrent(NULL); });
+  m_worker->free();
+  m_worker.reset();
+  glfwDestroyWindow(m_window);
+  m_window = NULL;
+}
+
+GlWorker& GlWorker::get() {
+  static GlWorker worker;
+  return worker;
+}
@@ -0,0 +1,64 @@
+#include "GLFW/glfw3.h"
+
+#include "gpu/gpu_resources.hpp"
+#include "geometries/surface_ndc.hpp"
+
+#define NANOVG_GL3_IMPLEMENTATION
+#include "nanovg_gl.h"
+
+// static members definition (avoids linking error) & initialization
+std::map<void*, std::unique_ptr<GpuResources>> GpuResources::m_registries;
+
+GpuResources::GpuResources():
+  m_programs(),
+  m_renderer(),
+  m_vg(NULL)
+{
+}
+
+/* Registry of current gl context (created on first call) */
+GpuResources& GpuResources::get() {
+  std::unique_ptr<GpuResources>& registry = m_registries[glfwGetCurrentContext()];
+  if (!registry)
+    registry.reset(new GpuResources());
+
+  return *registry;
+}
+
+ProgramTable& GpuResources::get_programs() {
+  return m_programs;
+}
+
+/**
+ * Renderer of a full-screen quad (in ndc), created with color shader (throws `ShaderException` if it fails to compile)
+ * Its program is replaced by the caller's view (or effect) shader before each draw
+ */
+Renderer& GpuResources::get_renderer() {
+  if (!m_renderer) {
+    m_renderer.emplace(m_programs.get(Shader::COLOR), SurfaceNDC(), std::vector<Attribute> {
+      {0, "position", 2, 4, 0},
+      {1, "texture_coord", 2, 4, 2}
+    });
+  }
+
+  return *m_renderer;
+}
+
+/* Nanovg context (similar to html5 canvas) drawing shapes of all documents */
+NVGcontext* GpuResources::get_vg() {
+  if (m_vg == NULL)
+    m_vg = nvgCreateGL3(NVG_STENCIL_STROKES | NVG_DEBUG);
+
+  return m_vg;
+}
+
+/* Free programs, buffers & nanovg context (once all documents are freed), created again if used afterwards */
+void GpuResources::free() {
+  m_programs.free();
+  if (m_renderer)
+    m_renderer->free();
+  m_renderer.reset();
+  if (m_vg != NULL)
+    nvgDeleteGL3(m_vg);
+  m_vg = NULL;
+}
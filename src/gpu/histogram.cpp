@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "gpu/histogram.hpp"
+#include "effects/compute_effects.hpp"
+
+Histogram::Histogram():
+  m_program(0),
+  m_buffer(0),
+  m_fence(NULL),
+  m_width(0),
+  m_height(0),
+  m_n_channels(0)
+{
+  if (!ComputeEffects::is_supported())
+    return;
+
+  m_program = ComputeEffects::load("assets/shaders/compute/histogram.comp");
+  if (m_program == 0)
+    return;
+
+  // sampler bound to unit 0 once (textures always sampled from it)
+  glUseProgram(m_program);
+  glUniform1i(glGetUniformLocation(m_program, "texture2d"), 0);
+  glUseProgram(0);
+
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ImageStats::bins), NULL, GL_DYNAMIC_READ);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/* Compute shaders unavailable (no panel shown) */
+bool Histogram::has_failed() const {
+  return m_program == 0;
+}
+
+bool Histogram::is_pending() const {
+  return m_fence != NULL;
+}
+
+/**
+ * Dispatch histogram of texture's level 0 (non-blocking)
+ * @return false if previous request not read yet (request dropped)
+ */
+bool Histogram::request(const Texture2D& texture) {
+#ifdef GL_VERSION_4_3
+  if (has_failed() || is_pending())
+    return false;
+
+  // bins cleared on gpu (no upload)
+  GLuint zero = 0;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+  glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_buffer);
+
+  glUseProgram(m_program);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glDispatchCompute((texture.width + SIZE_GROUP - 1) / SIZE_GROUP, (texture.height + SIZE_GROUP - 1) / SIZE_GROUP, 1);
+
+  // atomic writes visible to `glGetBufferSubData()`
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  m_width = texture.width;
+  m_height = texture.height;
+  m_n_channels = (texture.format == GL_RED) ? 1 : (texture.format == GL_RGB) ? 3 : 4;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Copy bins if dispatch finished & derive per-channel min/max/mean from them
+ * @return false if no request pending or not done yet (stats unchanged)
+ */
+bool Histogram::poll(ImageStats& stats) {
+  if (!is_pending())
+    return false;
+
+  GLenum status = glClientWaitSync(m_fence, 0, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    return false;
+
+  glDeleteSync(m_fence);
+  m_fence = NULL;
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(stats.bins), stats.bins);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  stats.width = m_width;
+  stats.height = m_height;
+  stats.n_channels = m_n_channels;
+
+  for (int i_channel = 0; i_channel < 4; i_channel++) {
+    const unsigned int* bins = stats.bins[i_channel];
+    double sum = 0.0;
+    unsigned long long n_pixels = 0;
+    stats.min[i_channel] = ImageStats::N_BINS - 1;
+    stats.max[i_channel] = 0;
+
+    for (int value = 0; value < ImageStats::N_BINS; value++) {
+      if (bins[value] == 0)
+        continue;
+
+      stats.min[i_channel] = std::min(stats.min[i_channel], value);
+      stats.max[i_channel] = std::max(stats.max[i_channel], value);
+      sum += static_cast<double>(value) * bins[value];
+      n_pixels += bins[value];
+    }
+
+    stats.mean[i_channel] = n_pixels > 0 ? sum / n_pixels : 0.0f;
+  }
+
+  return true;
+}
+
+void Histogram::free() {
+  if (m_fence != NULL)
+    glDeleteSync(m_fence);
+  m_fence = NULL;
+
+  if (m_buffer != 0)
+    glDeleteBuffers(1, &m_buffer);
+  if (m_program != 0)
+    glDeleteProgram(m_program);
+  m_buffer = 0;
+  m_program = 0;
+}
@@ -0,0 +1,211 @@
+#include <algorithm>
+
+#include "gpu/image_comparison.hpp"
+#include "gpu/texture_pool.hpp"
+#include "effects/compute_effects.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * Compute passes only created if supported
+ * @param programs Table of canvas, compiling view shader on first render (throws `ShaderException` then)
+ */
+ImageComparison::ImageComparison(ProgramTable& programs):
+  m_programs(programs),
+  m_texture_view(),
+  m_program_windows(0),
+  m_program_reduce(0),
+  m_buffer_partials(0),
+  m_buffer_totals(0),
+  m_n_partials_max(0),
+  m_fence(NULL),
+  m_width(0),
+  m_height(0),
+  m_n_windows(0)
+{
+  if (!ComputeEffects::is_supported())
+    return;
+
+  m_program_windows = ComputeEffects::load("assets/shaders/compute/compare.comp");
+  m_program_reduce = ComputeEffects::load("assets/shaders/compute/compare_reduce.comp");
+  if (m_program_windows == 0 || m_program_reduce == 0)
+    return;
+
+  // samplers bound to units 0 & 1 once
+  glUseProgram(m_program_windows);
+  glUniform1i(glGetUniformLocation(m_program_windows, "texture2d"), 0);
+  glUniform1i(glGetUniformLocation(m_program_windows, "texture_reference"), 1);
+  glUseProgram(0);
+
+  glGenBuffers(1, &m_buffer_partials);
+  glGenBuffers(1, &m_buffer_totals);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer_totals);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * sizeof(double), NULL, GL_DYNAMIC_READ);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/**
+ * Render view of image against reference into a texture of image's size (reused while size doesn't change)
+ * Framebuffer attachment & viewport are changed, renderer's program is restored afterwards
+ * @param gain Scale of error in difference & heatmap views
+ * @param is_reference Whether flicker view shows reference (phase given by caller)
+ */
+const Texture2D& ImageComparison::render(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& texture,
+                                         const Texture2D& reference, CompareView view, float gain, bool is_reference) {
+  if (m_texture_view && (m_texture_view->width != texture.width || m_texture_view->height != texture.height)) {
+    TexturePool::get().release(*m_texture_view);
+    m_texture_view.reset();
+  }
+
+  if (!m_texture_view)
+    m_texture_view = TexturePool::get().acquire(texture.width, texture.height, 4, Depth::UNORM8, OWNER);
+
+  // `texture2d` bound to unit 0 by table
+  const Program& program = m_programs.get(Shader::COMPARE);
+  program.use();
+  glUniform1i(m_programs.get_location(Shader::COMPARE, "texture_reference"), 1);
+  glUniform1i(m_programs.get_location(Shader::COMPARE, "view"), (int) view);
+  glUniform1f(m_programs.get_location(Shader::COMPARE, "gain"), gain);
+  glUniform1i(m_programs.get_location(Shader::COMPARE, "is_reference"), is_reference);
+  program.unuse();
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, reference.id);
+  glActiveTexture(GL_TEXTURE0);
+
+  framebuffer.attach_texture(*m_texture_view);
+  framebuffer.bind();
+  glViewport(0, 0, texture.width, texture.height);
+
+  Program program_view = renderer.program;
+  renderer.program = program;
+  renderer.draw({ {"texture2d", texture} });
+  renderer.program = program_view;
+  framebuffer.unbind();
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+
+  return *m_texture_view;
+}
+
+/* Compute shaders unavailable (views only, no metrics) */
+bool ImageComparison::has_metrics() const {
+  return m_program_windows != 0 && m_program_reduce != 0;
+}
+
+bool ImageComparison::is_pending() const {
+  return m_fence != NULL;
+}
+
+/**
+ * Dispatch metrics of texture's level 0 relative to reference (non-blocking)
+ * @return false if sizes differ or previous request not read yet (request dropped)
+ */
+bool ImageComparison::request(const Texture2D& texture, const Texture2D& reference) {
+#ifdef GL_VERSION_4_3
+  if (!has_metrics() || is_pending() || texture.width != reference.width || texture.height != reference.height)
+    return false;
+
+  int n_windows_x = (texture.width + SIZE_WINDOW - 1) / SIZE_WINDOW;
+  int n_windows_y = (texture.height + SIZE_WINDOW - 1) / SIZE_WINDOW;
+  size_t n_partials = (size_t) n_windows_x * n_windows_y;
+
+  // partials only reallocated for a larger image
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer_partials);
+  if (n_partials > m_n_partials_max) {
+    glBufferData(GL_SHADER_STORAGE_BUFFER, n_partials * 2 * sizeof(float), NULL, GL_DYNAMIC_COPY);
+    MemoryTracker::get().track(MemoryKind::BUFFER, m_buffer_partials, OWNER, "ssbo of windows", n_partials * 2 * sizeof(float));
+    m_n_partials_max = n_partials;
+  }
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_buffer_partials);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_buffer_totals);
+
+  glUseProgram(m_program_windows);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, reference.id);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glDispatchCompute(n_windows_x, n_windows_y, 1);
+
+  // partials written by first pass read by second one
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  glUseProgram(m_program_reduce);
+  glUniform1i(glGetUniformLocation(m_program_reduce, "n_partials"), (GLint) n_partials);
+  glDispatchCompute(1, 1, 1);
+
+  // totals visible to `glGetBufferSubData()`
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  m_width = texture.width;
+  m_height = texture.height;
+  m_n_windows = n_partials;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Copy totals if dispatch finished & derive metrics from them
+ * @return false if no request pending or not done yet (similarity unchanged)
+ */
+bool ImageComparison::poll(Similarity& similarity) {
+  if (!is_pending())
+    return false;
+
+  GLenum status = glClientWaitSync(m_fence, 0, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    return false;
+
+  glDeleteSync(m_fence);
+  m_fence = NULL;
+
+  double totals[2];
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer_totals);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(totals), totals);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  similarity.width = m_width;
+  similarity.height = m_height;
+  similarity.mse = totals[0] / ((double) m_width * m_height * 3);
+  similarity.psnr = Similarity::get_psnr(similarity.mse);
+  similarity.ssim = totals[1] / m_n_windows;
+  return true;
+}
+
+void ImageComparison::free() {
+  if (m_fence != NULL)
+    glDeleteSync(m_fence);
+  m_fence = NULL;
+
+  if (m_texture_view)
+    TexturePool::get().release(*m_texture_view);
+  m_texture_view.reset();
+
+  if (m_buffer_partials != 0) {
+    MemoryTracker::get().untrack(MemoryKind::BUFFER, m_buffer_partials);
+    glDeleteBuffers(1, &m_buffer_partials);
+  }
+  if (m_buffer_totals != 0)
+    glDeleteBuffers(1, &m_buffer_totals);
+  if (m_program_windows != 0)
+    glDeleteProgram(m_program_windows);
+  if (m_program_reduce != 0)
+    glDeleteProgram(m_program_reduce);
+  m_buffer_partials = 0;
+  m_buffer_totals = 0;
+  m_program_windows = 0;
+  m_program_reduce = 0;
+  m_n_partials_max = 0;
+}
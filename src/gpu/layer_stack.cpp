@@ -0,0 +1,301 @@
+#include <algorithm>
+
+#include "gpu/layer_stack.hpp"
+#include "gpu/texture_pool.hpp"
+#include "gpu/pixel_format.hpp"
+
+/**
+ * Stack holding only image layer (annotation layers added with `add()`)
+ * @param programs Table of canvas, compiling layer's program on first composite (throws `ShaderException` then)
+ * @param image Texture of image layer (owned by canvas, passed again on each composite)
+ * @param depth Depth of image (kept by composite, annotation layers are 8-bit)
+ */
+LayerStack::LayerStack(ProgramTable& programs, const Texture2D& image, Depth depth):
+  m_width(image.width),
+  m_height(image.height),
+  m_depth(depth),
+  m_layers(),
+  m_i_active(0),
+  m_n_added(0),
+  m_programs(programs),
+  m_texture_below(),
+  m_texture_above(),
+  m_texture_composite(),
+  m_is_merged(false),
+  m_is_composited(false),
+  m_revision_composited(0),
+  m_n_blends(0)
+{
+  m_layers.push_back({ "Image", image, 1.0f, true, nullptr, {} });
+}
+
+/**
+ * Append transparent annotation layer on top of stack, which becomes the active one
+ * @param framebuffer Used to clear new layer
+ * @return Index of new layer
+ */
+size_t LayerStack::add(Framebuffer& framebuffer) {
+  Texture2D texture = TexturePool::get().acquire(m_width, m_height, 4, Depth::UNORM8, OWNER);
+  framebuffer.attach_texture(texture);
+  framebuffer.bind();
+  framebuffer.clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+  framebuffer.unbind();
+
+  std::unique_ptr<History> history = std::make_unique<History>();
+  history->reset(texture);
+  m_layers.push_back({ "Layer " + std::to_string(++m_n_added), texture, 1.0f, true, std::move(history), {} });
+  set_active(m_layers.size() - 1);
+
+  return m_layers.size() - 1;
+}
+
+/* Remove annotation layer (image layer can't be removed), layer below it becomes active if it was */
+void LayerStack::remove(size_t i_layer) {
+  if (i_layer == 0 || i_layer >= m_layers.size())
+    return;
+
+  Layer& layer = m_layers[i_layer];
+  TexturePool::get().release(layer.texture);
+  layer.history->free();
+  m_layers.erase(m_layers.begin() + i_layer);
+
+  if (m_i_active >= i_layer)
+    m_i_active--;
+  invalidate();
+}
+
+/* Layer drawn on by shapes & brush strokes (pre-merged layers change, not the composite) */
+void LayerStack::set_active(size_t i_layer) {
+  if (i_layer >= m_layers.size() || i_layer == m_i_active)
+    return;
+
+  m_i_active = i_layer;
+  invalidate();
+}
+
+/* Change opacity (in [0, 1]) & visibility of layer */
+void LayerStack::set(size_t i_layer, float opacity, bool is_visible) {
+  if (i_layer >= m_layers.size())
+    return;
+
+  Layer& layer = m_layers[i_layer];
+  layer.opacity = std::clamp(opacity, 0.0f, 1.0f);
+  layer.is_visible = is_visible;
+  invalidate();
+}
+
+/* Layers re-merged & composite re-rendered as a whole on next call to `composite()` */
+void LayerStack::invalidate() {
+  m_is_merged = false;
+  m_is_composited = false;
+}
+
+/**
+ * Blend layers into composite texture, only over region changed since last call (e.g. stroke on active layer)
+ * Framebuffer attachment & viewport are changed, renderer's program is restored afterwards
+ * @param programs Table of canvas, compiling layer's program on first composite (throws `ShaderException` then)
+ * @param image Texture of image layer (may have changed, e.g. after eviction)
+ * @return Image itself if it's the only layer & is shown as is
+ */
+const Texture2D& LayerStack::composite(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& image,
+                                       const DirtyRegion& dirty) {
+  if (image.id != m_layers[0].texture.id) {
+    m_layers[0].texture = image;
+    invalidate();
+  }
+
+  if (m_layers.size() == 1 && m_layers[0].is_visible && m_layers[0].opacity == 1.0f)
+    return image;
+
+  Program program_view = renderer.program;
+  renderer.program = m_programs.get(Shader::LAYER);
+  if (!m_is_merged) {
+    merge(0, m_i_active, m_texture_below, renderer, framebuffer);
+    merge(m_i_active + 1, m_layers.size(), m_texture_above, renderer, framebuffer);
+    m_is_merged = true;
+  }
+
+  if (!m_texture_composite) {
+    m_texture_composite = TexturePool::get().acquire(m_width, m_height, 4, m_depth, OWNER);
+    m_is_composited = false;
+  }
+
+  // only region drawn since last composite re-blended
+  DirtyRegion::Rect rect;
+  bool has_changed = dirty.get_bounds(m_revision_composited, 0, rect);
+  if (m_is_composited && !has_changed) {
+    renderer.program = program_view;
+    return *m_texture_composite;
+  }
+
+  bool is_partial = m_is_composited && !dirty.is_whole(rect);
+  framebuffer.attach_texture(*m_texture_composite);
+  framebuffer.bind();
+  glViewport(0, 0, m_width, m_height);
+  if (is_partial) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(rect.x, rect.y, rect.width, rect.height);
+  }
+  framebuffer.clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+
+  const Layer& layer = m_layers[m_i_active];
+  if (m_texture_below)
+    blend(renderer, *m_texture_below, true, 1.0f);
+  if (layer.is_visible)
+    blend(renderer, layer.texture, m_i_active > 0, layer.opacity);
+  if (m_texture_above)
+    blend(renderer, *m_texture_above, true, 1.0f);
+
+  if (is_partial)
+    glDisable(GL_SCISSOR_TEST);
+  framebuffer.unbind();
+  renderer.program = program_view;
+
+  m_revision_composited = dirty.get_revision();
+  m_is_composited = true;
+  return *m_texture_composite;
+}
+
+/* Blend visible layers in [i_begin, i_end) into `target` (freed if none of them is visible) */
+void LayerStack::merge(size_t i_begin, size_t i_end, std::optional<Texture2D>& target, Renderer& renderer,
+                       Framebuffer& framebuffer) {
+  bool has_visible = std::any_of(m_layers.begin() + i_begin, m_layers.begin() + i_end, [](const Layer& layer) {
+    return layer.is_visible;
+  });
+  if (!has_visible) {
+    release(target);
+    return;
+  }
+
+  if (!target)
+    target = TexturePool::get().acquire(m_width, m_height, 4, m_depth, OWNER);
+
+  framebuffer.attach_texture(*target);
+  framebuffer.bind();
+  glViewport(0, 0, m_width, m_height);
+  framebuffer.clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+
+  for (size_t i_layer = i_begin; i_layer < i_end; i_layer++) {
+    const Layer& layer = m_layers[i_layer];
+    if (layer.is_visible)
+      blend(renderer, layer.texture, i_layer > 0, layer.opacity);
+  }
+
+  framebuffer.unbind();
+}
+
+/* Premultiplied "over" blending of texture onto bound framebuffer (renderer's program set to layer's one) */
+void LayerStack::blend(Renderer& renderer, const Texture2D& texture, bool is_premultiplied, float opacity) {
+  const Program& program = m_programs.get(Shader::LAYER);
+  program.use();
+  glUniform1f(m_programs.get_location(Shader::LAYER, "opacity"), opacity);
+  glUniform1i(m_programs.get_location(Shader::LAYER, "is_premultiplied"), is_premultiplied);
+  program.unuse();
+
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  renderer.draw({ {"texture2d", texture} });
+  glDisable(GL_BLEND);
+
+  m_n_blends++;
+}
+
+void LayerStack::release(std::optional<Texture2D>& texture) {
+  if (!texture)
+    return;
+
+  TexturePool::get().release(*texture);
+  texture.reset();
+}
+
+LayerStack::Layer& LayerStack::get_active() {
+  return m_layers[m_i_active];
+}
+
+size_t LayerStack::get_i_active() const {
+  return m_i_active;
+}
+
+/* Layers from bottom (image) to top */
+const std::vector<LayerStack::Layer>& LayerStack::get_layers() const {
+  return m_layers;
+}
+
+/* Number of layers blended so far (for profiling) */
+unsigned int LayerStack::get_n_blends() const {
+  return m_n_blends;
+}
+
+/* Vram held by annotation layers (incl. their history), pre-merged & composite textures (image layer not counted) */
+size_t LayerStack::get_n_bytes() const {
+  size_t n_bytes_pixel = 4 * PixelFormat::get_n_bytes_channel(m_depth);
+  size_t n_pixels = (size_t) m_width * m_height;
+  size_t n_bytes = 0;
+  for (const std::optional<Texture2D>* texture : { &m_texture_below, &m_texture_above, &m_texture_composite }) {
+    if (*texture)
+      n_bytes += n_pixels * n_bytes_pixel;
+  }
+
+  for (size_t i_layer = 1; i_layer < m_layers.size(); i_layer++) {
+    const Layer& layer = m_layers[i_layer];
+    n_bytes += layer.pixels_evicted.empty() ? n_pixels * 4 + layer.history->get_size_gpu() : 0;
+  }
+
+  return n_bytes;
+}
+
+/* Annotation layers read back to cpu (history spilled), their textures & cached ones freed (see `Canvas::evict()`) */
+void LayerStack::evict() {
+  for (size_t i_layer = 1; i_layer < m_layers.size(); i_layer++) {
+    Layer& layer = m_layers[i_layer];
+    layer.pixels_evicted.resize((size_t) m_width * m_height * 4);
+    glBindTexture(GL_TEXTURE_2D, layer.texture.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, layer.pixels_evicted.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    layer.history->spill_all();
+    TexturePool::get().release(layer.texture);
+  }
+
+  release(m_texture_below);
+  release(m_texture_above);
+  release(m_texture_composite);
+  invalidate();
+}
+
+/* Annotation layers uploaded from their cpu copy (before image layer's texture is passed again to `composite()`) */
+void LayerStack::restore() {
+  for (size_t i_layer = 1; i_layer < m_layers.size(); i_layer++) {
+    Layer& layer = m_layers[i_layer];
+    if (layer.pixels_evicted.empty())
+      continue;
+
+    layer.texture = TexturePool::get().acquire(m_width, m_height, 4, Depth::UNORM8, OWNER);
+    glBindTexture(GL_TEXTURE_2D, layer.texture.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, layer.pixels_evicted.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    layer.history->rebind(layer.texture);
+    layer.pixels_evicted.clear();
+    layer.pixels_evicted.shrink_to_fit();
+  }
+
+  invalidate();
+}
+
+/* Give back annotation layers & cached textures to pool (image layer freed by canvas, program by its table) */
+void LayerStack::free() {
+  for (size_t i_layer = 1; i_layer < m_layers.size(); i_layer++) {
+    Layer& layer = m_layers[i_layer];
+    if (layer.pixels_evicted.empty())
+      TexturePool::get().release(layer.texture);
+    layer.history->free();
+  }
+  m_layers.resize(1);
+
+  release(m_texture_below);
+  release(m_texture_above);
+  release(m_texture_composite);
+}
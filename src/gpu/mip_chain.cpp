@@ -0,0 +1,121 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpu/mip_chain.hpp"
+
+MipChain::MipChain():
+  m_id_texture(0),
+  m_revision(0),
+  m_level_max(0),
+  m_fbos{ 0, 0 },
+  m_n_generated(0),
+  m_n_skipped(0),
+  m_n_partial(0)
+{
+}
+
+/**
+ * Make sure mip levels needed to display `texture` at `zoom` are up-to-date
+ * Trilinear filtering then lets the gpu sample the appropriate level
+ * @param dirty Changes to texture content (mipmaps regenerated only over region changed since last update)
+ * @param margin Pixels around changed region also affected (e.g. by blur effects applied to drawn texture)
+ */
+void MipChain::update(const Texture2D& texture, const DirtyRegion& dirty, float zoom, int margin) {
+  // level whose texel size matches a screen pixel (zoom = 1/2^level), clamped to smallest level
+  int n_levels = 1 + (int) std::floor(std::log2(std::max(texture.width, texture.height)));
+  int level_max = (zoom >= 1.0f) ? 0 : std::min((int) std::ceil(std::log2(1.0f / zoom)), n_levels - 1);
+
+  // finer levels already generated for same content
+  bool is_same_texture = texture.id == m_id_texture && level_max <= m_level_max;
+  if (is_same_texture && dirty.get_revision() == m_revision) {
+    m_n_skipped++;
+    return;
+  }
+
+  // part of same texture changed: levels already generated updated over that part only
+  DirtyRegion::Rect rect;
+  if (is_same_texture && m_level_max > 0 && dirty.get_bounds(m_revision, margin, rect) && !dirty.is_whole(rect)) {
+    downsample(texture, rect);
+    m_revision = dirty.get_revision();
+    m_n_partial++;
+    return;
+  }
+
+  // levels above `GL_TEXTURE_MAX_LEVEL` are neither generated nor sampled
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level_max);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, level_max > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  if (level_max > 0) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    m_n_generated++;
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  m_id_texture = texture.id;
+  m_revision = dirty.get_revision();
+  m_level_max = level_max;
+}
+
+/**
+ * Each level rebuilt over changed region from the finer one (linear filter at 2:1 averages 2x2 texels like a box filter)
+ * Region aligned to even texels at each level, so blitted texels don't straddle unchanged ones
+ */
+void MipChain::downsample(const Texture2D& texture, const DirtyRegion::Rect& rect) {
+  if (m_fbos[0] == 0)
+    glGenFramebuffers(2, m_fbos);
+
+  int x_min = rect.x, y_min = rect.y;
+  int x_max = rect.x + rect.width, y_max = rect.y + rect.height;
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbos[0]);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_fbos[1]);
+
+  for (int level = 1; level <= m_level_max; level++) {
+    int width_source = std::max(texture.width >> (level - 1), 1);
+    int height_source = std::max(texture.height >> (level - 1), 1);
+    int width_target = std::max(texture.width >> level, 1);
+    int height_target = std::max(texture.height >> level, 1);
+
+    // bounds at finer level rounded outwards to even texels
+    x_min &= ~1;
+    y_min &= ~1;
+    x_max = std::min(x_max + (x_max & 1), width_source);
+    y_max = std::min(y_max + (y_max & 1), height_source);
+    int x_min_target = x_min / 2, y_min_target = y_min / 2;
+    int x_max_target = std::min((x_max + 1) / 2, width_target);
+    int y_max_target = std::min((y_max + 1) / 2, height_target);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id, level - 1);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id, level);
+    glBlitFramebuffer(x_min, y_min, x_max, y_max, x_min_target, y_min_target, x_max_target, y_max_target,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    x_min = x_min_target;
+    y_min = y_min_target;
+    x_max = x_max_target;
+    y_max = y_max_target;
+  }
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+}
+
+/* Number of times mipmaps were (re)generated */
+unsigned int MipChain::get_n_generated() const {
+  return m_n_generated;
+}
+
+/* Number of frames mipmaps were up-to-date */
+unsigned int MipChain::get_n_skipped() const {
+  return m_n_skipped;
+}
+
+/* Number of times only a changed region of mipmaps was updated */
+unsigned int MipChain::get_n_partial() const {
+  return m_n_partial;
+}
+
+void MipChain::free() {
+  if (m_fbos[0] != 0)
+    glDeleteFramebuffers(2, m_fbos);
+  m_fbos[0] = m_fbos[1] = 0;
+}
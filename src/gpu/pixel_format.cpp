@@ -0,0 +1,74 @@
+#include "gpu/pixel_format.hpp"
+
+/* Internal format of texture (e.g. GL_R16 for 1-channel 16-bit images) */
+GLenum PixelFormat::get_format_sized(int n_channels, Depth depth) {
+  switch (depth) {
+    case Depth::UNORM16:
+      return (n_channels == 1) ? GL_R16 : (n_channels == 2) ? GL_RG16 : GL_RGBA16;
+    case Depth::FLOAT16:
+      return (n_channels == 1) ? GL_R16F : (n_channels == 2) ? GL_RG16F : GL_RGBA16F;
+    default:
+      return (n_channels == 1) ? GL_R8 : (n_channels == 2) ? GL_RG8 : (n_channels == 3) ? GL_RGB8 : GL_RGBA8;
+  }
+}
+
+/* Type of pixels uploaded to/read from texture */
+GLenum PixelFormat::get_type(Depth depth) {
+  switch (depth) {
+    case Depth::UNORM16:
+      return GL_UNSIGNED_SHORT;
+    case Depth::FLOAT16:
+      return GL_HALF_FLOAT;
+    default:
+      return GL_UNSIGNED_BYTE;
+  }
+}
+
+int PixelFormat::get_n_bytes_channel(Depth depth) {
+  return (depth == Depth::UNORM8) ? 1 : 2;
+}
+
+const char* PixelFormat::get_name(Depth depth) {
+  switch (depth) {
+    case Depth::UNORM16:
+      return "16-bit";
+    case Depth::FLOAT16:
+      return "half-float";
+    default:
+      return "8-bit";
+  }
+}
+
+/* # of channels stored by texture (from its unsized format) */
+int PixelFormat::get_n_channels(const Texture2D& texture) {
+  switch (texture.format) {
+    case GL_RED:
+      return 1;
+    case GL_RG:
+      return 2;
+    case GL_RGB:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+bool PixelFormat::has_swizzle() {
+  return GLAD_GL_VERSION_3_3 || GLAD_GL_ARB_texture_swizzle;
+}
+
+/**
+ * Sample 1-channel texture as gray & 2-channel one as gray + alpha (instead of shades of red/green)
+ * Applies to every reader going through samplers (imgui, effects, histogram), not to `glGetTexImage()`
+ */
+void PixelFormat::swizzle_gray(const Texture2D& texture) {
+  int n_channels = get_n_channels(texture);
+  if (n_channels > 2 || !has_swizzle())
+    return;
+
+  GLint mask_r[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+  GLint mask_rg[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, (n_channels == 1) ? mask_r : mask_rg);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,233 @@
+#include <cstring>
+#include <utility>
+
+#include "gpu/pixel_reader.hpp"
+#include "gpu/texture_pool.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * @param n_buffers Number of PBOs in ring (i.e. max. # of readbacks in flight)
+ */
+PixelReader::PixelReader(int n_buffers):
+  m_slots(n_buffers),
+  m_i_write(0),
+  m_i_read(0),
+  m_n_pending(0)
+{
+  for (Slot& slot : m_slots) {
+    glGenBuffers(1, &slot.pbo);
+    slot.size = 0;
+    slot.fence = NULL;
+  }
+}
+
+/**
+ * Start copy of fbo region into next PBO (non-blocking)
+ * Coordinates are rel. to fbo's origin (i.e. first row of attached texture)
+ * @return false if all PBOs still in flight (request dropped)
+ */
+bool PixelReader::request(const Framebuffer& framebuffer, int x, int y, int width, int height, int n_channels) {
+  Slot* slot = begin_request(x, y, width, height, n_channels);
+  if (slot == NULL)
+    return false;
+
+  // last arg is an offset into bound PBO (not a client pointer)
+  GLenum format = (n_channels == 1) ? GL_RED : (n_channels == 3) ? GL_RGB : GL_RGBA;
+  framebuffer.bind();
+  glReadPixels(x, y, width, height, format, GL_UNSIGNED_BYTE, 0);
+  framebuffer.unbind();
+
+  end_request(slot);
+  return true;
+}
+
+/**
+ * Start copy of whole texture (level 0) into next PBO (non-blocking)
+ * Used to save image without stalling on `Texture2D::get_image()`
+ * On `GlWorker` (gl 4.3 needed by `glCopyImageSubData()`), texture is first copied on main context into a pooled
+ * snapshot (a gpu copy ordered before later renders into texture), so worker reads pixels of this request
+ * even if texture is drawn on meanwhile
+ */
+bool PixelReader::request(const Texture2D& texture) {
+  int n_channels = (texture.format == GL_RED) ? 1 : (texture.format == GL_RGB) ? 3 : 4;
+  bool has_worker = GlWorker::get().is_available() && GLAD_GL_VERSION_4_3;
+  Slot* slot = begin_request(0, 0, texture.width, texture.height, n_channels, !has_worker);
+  if (slot == NULL)
+    return false;
+
+  // worker blocks on copy into cpu memory instead of main thread mapping the PBO
+  if (has_worker) {
+    TexturePool& pool = TexturePool::get();
+    Texture2D snapshot = pool.acquire(texture.width, texture.height, n_channels, pool.get_depth(texture), "pixel reader");
+    glCopyImageSubData(texture.id, GL_TEXTURE_2D, 0, 0, 0, 0, snapshot.id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                       texture.width, texture.height, 1);
+
+    std::shared_ptr<std::vector<unsigned char>> data =
+      std::make_shared<std::vector<unsigned char>>((size_t) texture.width * texture.height * n_channels);
+    GLuint id_snapshot = snapshot.id;
+    GLenum format = texture.format;
+
+    slot->snapshot = snapshot;
+    slot->data_worker = data;
+    slot->ticket = GlWorker::get().submit([data, id_snapshot, format]() {
+      glBindTexture(GL_TEXTURE_2D, id_snapshot);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, data->data());
+      glBindTexture(GL_TEXTURE_2D, 0);
+    });
+
+    m_i_write = (m_i_write + 1) % m_slots.size();
+    m_n_pending++;
+    return true;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glGetTexImage(GL_TEXTURE_2D, 0, texture.format, GL_UNSIGNED_BYTE, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  end_request(slot);
+  return true;
+}
+
+/**
+ * Next free slot for region, NULL if ring is full
+ * @param has_pbo Bind slot's PBO (resized to region) as pack buffer, unused by readbacks on worker
+ */
+PixelReader::Slot* PixelReader::begin_request(int x, int y, int width, int height, int n_channels, bool has_pbo) {
+  if (m_n_pending == (int) m_slots.size())
+    return NULL;
+
+  Slot& slot = m_slots[m_i_write];
+  GLsizeiptr size = (GLsizeiptr) width * height * n_channels;
+
+  // storage only reallocated when region size changes
+  if (has_pbo) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (slot.size != size) {
+      glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+      slot.size = size;
+      MemoryTracker::get().track(MemoryKind::BUFFER, slot.pbo, "pixel reader", "pack pbo", size);
+    }
+  }
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  slot.readback.x = x;
+  slot.readback.y = y;
+  slot.readback.width = width;
+  slot.readback.height = height;
+  slot.readback.n_channels = n_channels;
+
+  return &slot;
+}
+
+/* Fence copy issued into slot's PBO & move to next slot in ring */
+void PixelReader::end_request(Slot* slot) {
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  m_i_write = (m_i_write + 1) % m_slots.size();
+  m_n_pending++;
+}
+
+/**
+ * Retrieve oldest readback if gpu is done with it (non-blocking)
+ * @return false if nothing finished yet
+ */
+bool PixelReader::poll(Readback& readback) {
+  if (m_n_pending == 0)
+    return false;
+
+  // timeout = 0: only query fence status
+  Slot& slot = m_slots[m_i_read];
+  if (slot.ticket)
+    return GlWorker::is_done(*slot.ticket) && read(slot, readback);
+
+  GLenum status = glClientWaitSync(slot.fence, 0, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    return false;
+
+  return read(slot, readback);
+}
+
+/**
+ * Retrieve oldest readback, blocking until gpu is done with it
+ * Meant for one-off consumers (e.g. saving to disk) that need the result right away
+ */
+bool PixelReader::wait(Readback& readback) {
+  if (m_n_pending == 0)
+    return false;
+
+  Slot& slot = m_slots[m_i_read];
+  if (slot.ticket)
+    GlWorker::wait(*slot.ticket);
+  else
+    glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+
+  return read(slot, readback);
+}
+
+/* Copy pixels from a signaled slot & release it */
+bool PixelReader::read(Slot& slot, Readback& readback) {
+  m_i_read = (m_i_read + 1) % m_slots.size();
+  m_n_pending--;
+
+  // pixels already copied by worker
+  if (slot.ticket) {
+    readback = slot.readback;
+    readback.data = std::move(*slot.data_worker);
+    slot.ticket.reset();
+    slot.data_worker.reset();
+    release_snapshot(slot);
+    return true;
+  }
+
+  glDeleteSync(slot.fence);
+  slot.fence = NULL;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+  void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+  if (data == NULL) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return false;
+  }
+
+  readback = slot.readback;
+  readback.data.resize(slot.size);
+  std::memcpy(readback.data.data(), data, slot.size);
+
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return true;
+}
+
+bool PixelReader::is_pending() const {
+  return m_n_pending > 0;
+}
+
+/* Snapshot read by worker given back to pool (once its ticket is done) */
+void PixelReader::release_snapshot(Slot& slot) {
+  if (!slot.snapshot)
+    return;
+
+  TexturePool::get().release(*slot.snapshot);
+  slot.snapshot.reset();
+}
+
+/* Destroy PBOs & pending fences (worker's pending readbacks finished first, as they read snapshots) */
+void PixelReader::free() {
+  for (Slot& slot : m_slots) {
+    if (slot.fence != NULL)
+      glDeleteSync(slot.fence);
+    if (slot.ticket) {
+      GlWorker::wait(*slot.ticket);
+      slot.ticket.reset();
+      slot.data_worker.reset();
+    }
+    release_snapshot(slot);
+    MemoryTracker::get().untrack(MemoryKind::BUFFER, slot.pbo);
+    glDeleteBuffers(1, &slot.pbo);
+  }
+
+  m_n_pending = 0;
+}
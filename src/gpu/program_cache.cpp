@@ -0,0 +1,243 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+
+#include "gpu/program_cache.hpp"
+
+// same value in khr & arb versions of extension (missing from headers generated without it)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace {
+  const char MAGIC[8] = { 'P', 'R', 'O', 'G', '0', '0', '0', '1' };
+
+  /* Program binaries need GL 4.1 (or extension) & at least one binary format exposed by driver */
+  bool has_binaries() {
+#ifdef GL_VERSION_4_1
+    static const bool has = [] {
+      if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+        return false;
+
+      GLint n_formats = 0;
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+      return n_formats > 0;
+    }();
+
+    return has;
+#else
+    return false;
+#endif
+  }
+
+  bool read_source(const std::string& path, std::string& source) {
+    std::ifstream file(path);
+    if (!file)
+      return false;
+
+    std::stringstream stream;
+    stream << file.rdbuf();
+    source = stream.str();
+    return true;
+  }
+
+  /* Link program from cached binary (fails if driver rejects it, e.g. after an update not reflected in its version) */
+  bool read_binary(const std::string& path, GLuint program) {
+#ifdef GL_VERSION_4_1
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    GLenum format;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        !file.read(reinterpret_cast<char*>(&format), sizeof(format)))
+      return false;
+
+    std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (binary.empty())
+      return false;
+
+    glProgramBinary(program, format, binary.data(), binary.size());
+    GLint is_linked;
+    glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+    return is_linked;
+#else
+    return false;
+#endif
+  }
+
+  /* Write binary of linked program (temporary file renamed, so a crash never leaves a truncated entry) */
+  void write_binary(const std::string& path, GLuint program) {
+#ifdef GL_VERSION_4_1
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0)
+      return;
+
+    std::vector<char> binary(size);
+    GLenum format;
+    glGetProgramBinary(program, size, NULL, &format, binary.data());
+
+    std::string path_tmp = path + ".tmp";
+    {
+      std::ofstream file(path_tmp, std::ios::binary);
+      file.write(MAGIC, sizeof(MAGIC));
+      file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+      file.write(binary.data(), binary.size());
+      if (!file)
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(path_tmp, path, error);
+#endif
+  }
+}
+
+/* `$XDG_CACHE_HOME` (or `~/.cache`) subfolder, local folder if neither is set */
+std::string ProgramCache::get_dir_cache() {
+  const char* dir_xdg = std::getenv("XDG_CACHE_HOME");
+  const char* dir_home = std::getenv("HOME");
+  std::filesystem::path dir = (dir_xdg && *dir_xdg) ? std::filesystem::path(dir_xdg) :
+                              (dir_home && *dir_home) ? std::filesystem::path(dir_home) / ".cache" : ".cache";
+
+  return (dir / "imgui-example" / "programs").string();
+}
+
+/* Whether driver compiles shaders in background threads (queried once) */
+bool ProgramCache::has_parallel_compile() {
+  static const bool has = [] {
+    GLint n_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &n_extensions);
+    for (GLint i_extension = 0; i_extension < n_extensions; i_extension++) {
+      const char* name = (const char*) glGetStringi(GL_EXTENSIONS, i_extension);
+      if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0)
+        return true;
+    }
+
+    return false;
+  }();
+
+  return has;
+}
+
+/**
+ * Load program from cached binary, or submit its shaders for compilation & linking without waiting for result
+ * @return false if a source couldn't be read
+ */
+bool ProgramCache::start(const std::vector<Source>& sources, Build& build) {
+  build = { 0, {}, sources.empty() ? "" : sources.back().path, "", false };
+
+  std::vector<std::string> texts;
+  std::string key;
+  for (const Source& source : sources) {
+    std::string text;
+    if (!read_source(source.path, text)) {
+      std::cout << "Failed to open shader " << source.path << '\n';
+      return false;
+    }
+
+    key += std::to_string(source.type) + '|' + text + '|';
+    texts.push_back(text);
+  }
+
+  build.program = glCreateProgram();
+  if (has_binaries()) {
+    key += (const char*) glGetString(GL_VENDOR) + std::string("|") + (const char*) glGetString(GL_RENDERER) + "|" +
+           (const char*) glGetString(GL_VERSION);
+
+    std::stringstream name;
+    name << std::hex << std::hash<std::string>()(key) << ".bin";
+    std::error_code error;
+    std::filesystem::create_directories(get_dir_cache(), error);
+    build.path_binary = (std::filesystem::path(get_dir_cache()) / name.str()).string();
+
+    if (read_binary(build.path_binary, build.program)) {
+      build.is_binary = true;
+      return true;
+    }
+  }
+
+  for (size_t i_source = 0; i_source < sources.size(); i_source++) {
+    const char* text = texts[i_source].c_str();
+    GLuint shader = glCreateShader(sources[i_source].type);
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    glAttachShader(build.program, shader);
+    build.shaders.push_back(shader);
+  }
+
+#ifdef GL_VERSION_4_1
+  if (has_binaries())
+    glProgramParameteri(build.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+  glLinkProgram(build.program);
+
+  return true;
+}
+
+/* Whether `finish()` returns without waiting for the driver */
+bool ProgramCache::is_ready(const Build& build) {
+  if (build.is_binary || build.program == 0 || !has_parallel_compile())
+    return true;
+
+  GLint is_completed;
+  glGetProgramiv(build.program, GL_COMPLETION_STATUS_KHR, &is_completed);
+  return is_completed;
+}
+
+/**
+ * Check compilation & linking (blocks until done), then cache binary of newly linked program
+ * @return Program (0 on failure, errors logged)
+ */
+GLuint ProgramCache::finish(Build& build) {
+  if (build.program == 0 || build.is_binary)
+    return build.program;
+
+  bool is_compiled = true;
+  for (GLuint shader : build.shaders) {
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+      char log[512];
+      glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+      std::cout << "Shader of " << build.name << " failed to compile: " << log << '\n';
+      is_compiled = false;
+    }
+
+    glDetachShader(build.program, shader);
+    glDeleteShader(shader);
+  }
+  build.shaders.clear();
+
+  GLint is_linked = 0;
+  if (is_compiled)
+    glGetProgramiv(build.program, GL_LINK_STATUS, &is_linked);
+
+  if (!is_linked) {
+    if (is_compiled)
+      std::cout << "Program " << build.name << " failed to link" << '\n';
+    glDeleteProgram(build.program);
+    build.program = 0;
+    return 0;
+  }
+
+  if (!build.path_binary.empty())
+    write_binary(build.path_binary, build.program);
+
+  return build.program;
+}
+
+/* Build program & wait for it (0 on failure) */
+GLuint ProgramCache::load(const std::vector<Source>& sources) {
+  Build build;
+  if (!start(sources, build)) {
+    if (build.program != 0)
+      glDeleteProgram(build.program);
+    return 0;
+  }
+
+  return finish(build);
+}
@@ -0,0 +1,140 @@
+#include <cstring>
+
+#include "glad/glad.h"
+
+#include "gpu/reference_image.hpp"
+#include "gpu/pixel_format.hpp"
+#include "image/image_decoder.hpp"
+
+// s3tc formats (extension, not core profile)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace {
+  bool has_extension(const char* name) {
+    GLint n_extensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &n_extensions);
+    for (GLint i_extension = 0; i_extension < n_extensions; i_extension++) {
+      if (std::strcmp((const char*) glGetStringi(GL_EXTENSIONS, i_extension), name) == 0)
+        return true;
+    }
+
+    return false;
+  }
+
+  GLenum get_format_compressed(BlockEncoder::Codec codec) {
+    switch (codec) {
+      case BlockEncoder::Codec::BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+      case BlockEncoder::Codec::BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+      default:
+        return GL_COMPRESSED_RED_RGTC1;
+    }
+  }
+}
+
+/* Whether gpu samples given block format (bc4 is core since opengl 3.0, bc1 & bc3 need s3tc extension) */
+bool ReferenceImage::is_supported(BlockEncoder::Codec codec) {
+  static const bool has_s3tc = has_extension("GL_EXT_texture_compression_s3tc");
+  return codec == BlockEncoder::Codec::BC4 || has_s3tc;
+}
+
+/**
+ * Upload compressed blocks (to be called on main thread)
+ * @param path Image decoded again on first pixel query
+ * @param image Already decoded cpu copy (NULL if blocks were read from disk cache)
+ */
+ReferenceImage::ReferenceImage(const BlockEncoder::Blocks& blocks, const std::string& path, const std::shared_ptr<Image>& image):
+  m_texture(Image(blocks.width, blocks.height, blocks.n_channels, NULL)),
+  m_path(path),
+  m_n_bytes(blocks.data.size()),
+  m_pixels(std::make_shared<Pixels>())
+{
+  // storage allocated by constructor replaced by compressed one (single level, sampled at zoom's level by gpu)
+  glBindTexture(GL_TEXTURE_2D, m_texture.id);
+  glCompressedTexImage2D(GL_TEXTURE_2D, 0, get_format_compressed(blocks.codec), blocks.width, blocks.height, 0,
+                         blocks.data.size(), blocks.data.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // gray & alpha of 2-channel images already replicated on rgb by bc3
+  if (blocks.codec == BlockEncoder::Codec::BC4)
+    PixelFormat::swizzle_gray(m_texture);
+
+  m_pixels->image = image;
+  m_pixels->is_requested = image != nullptr;
+  m_pixels->is_loaded = image != nullptr;
+}
+
+const Texture2D& ReferenceImage::get_texture() const {
+  return m_texture;
+}
+
+/**
+ * Uncompressed pixels for exact queries (e.g. pixel tooltip), decoded in background on first call
+ * @return NULL until decoded (caller keeps polling)
+ */
+const Image* ReferenceImage::get_image_async(Worker& worker) {
+  if (m_pixels->is_loaded)
+    return m_pixels->image.get();
+
+  if (!m_pixels->is_requested) {
+    m_pixels->is_requested = true;
+    std::shared_ptr<Pixels> pixels = m_pixels;
+    std::string path = m_path;
+
+    worker.submit([pixels, path]() {
+      auto deleter = [](Image* image) {
+        image->free();
+        delete image;
+      };
+
+      pixels->image = std::shared_ptr<Image>(new Image(ImageDecoder::decode(path)), deleter);
+      pixels->is_loaded = true;
+    });
+  }
+
+  return NULL;
+}
+
+/**
+ * Uncompressed pixels, decoded synchronously if not loaded yet (e.g. before saving or editing image)
+ * @return Image with NULL data if decoding failed
+ */
+std::shared_ptr<Image> ReferenceImage::get_image() {
+  if (m_pixels->is_loaded)
+    return m_pixels->image;
+
+  // decode in flight on worker not waited for (its result kept for later queries)
+  auto deleter = [](Image* image) {
+    image->free();
+    delete image;
+  };
+
+  return std::shared_ptr<Image>(new Image(ImageDecoder::decode(m_path)), deleter);
+}
+
+int ReferenceImage::get_width() const {
+  return m_texture.width;
+}
+
+int ReferenceImage::get_height() const {
+  return m_texture.height;
+}
+
+/* Size of compressed texture in vram */
+size_t ReferenceImage::get_n_bytes() const {
+  return m_n_bytes;
+}
+
+/* Cpu copy freed once decoding job (if any) is done with it */
+void ReferenceImage::free() {
+  m_texture.free();
+}
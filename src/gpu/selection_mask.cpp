@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cmath>
+
+#include "gpu/selection_mask.hpp"
+
+#include "shader_exception.hpp"
+
+SelectionMask::SelectionMask():
+  m_polygon(),
+  m_rect({ 0, 0, 0, 0 }),
+  m_texture(),
+  m_program(),
+  m_location_texture_input(-1),
+  m_location_mask(-1),
+  m_location_origin_mask(-1)
+{
+}
+
+/**
+ * Select inside of polygon (even-odd rule, so self-intersecting lassos leave holes), clamped to image
+ * @param polygon Vertices of rectangle or lasso (closed implicitly)
+ * @param width,height Size of image
+ * @return false if polygon covers no pixel (selection cleared)
+ */
+bool SelectionMask::set(const std::vector<Vertex>& polygon, int width, int height) {
+  clear();
+  if (polygon.size() < 3)
+    return false;
+
+  float x_min = polygon[0].x, y_min = polygon[0].y, x_max = polygon[0].x, y_max = polygon[0].y;
+  for (const Vertex& vertex : polygon) {
+    x_min = std::min(x_min, vertex.x);
+    y_min = std::min(y_min, vertex.y);
+    x_max = std::max(x_max, vertex.x);
+    y_max = std::max(y_max, vertex.y);
+  }
+
+  int x_start = std::max((int) std::floor(x_min), 0);
+  int y_start = std::max((int) std::floor(y_min), 0);
+  int x_end = std::min((int) std::ceil(x_max), width);
+  int y_end = std::min((int) std::ceil(y_max), height);
+  if (x_start >= x_end || y_start >= y_end)
+    return false;
+
+  m_polygon = polygon;
+  m_rect = { x_start, y_start, x_end - x_start, y_end - y_start };
+
+  std::vector<unsigned char> coverages;
+  rasterize(coverages);
+  if (std::none_of(coverages.begin(), coverages.end(), [](unsigned char coverage) { return coverage > 0; })) {
+    clear();
+    return false;
+  }
+
+  // rows of single-channel mask aren't 4-byte aligned
+  m_texture = Texture2D(Image(m_rect.width, m_rect.height, 1, NULL));
+  glBindTexture(GL_TEXTURE_2D, m_texture->id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_rect.width, m_rect.height, 0, GL_RED, GL_UNSIGNED_BYTE, coverages.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return true;
+}
+
+/**
+ * Select region of a mask computed on gpu (e.g. by magic wand), copied without any readback
+ * Outline shows the bounding box (region's contour isn't known on cpu)
+ * @param mask R8 texture of image's size (1 inside region)
+ * @param rect Bounds of region (mask undefined outside them)
+ */
+void SelectionMask::set(Framebuffer& framebuffer, const Texture2D& mask, const DirtyRegion::Rect& rect) {
+  clear();
+  m_rect = rect;
+  float x_min = rect.x, y_min = rect.y, x_max = rect.x + rect.width, y_max = rect.y + rect.height;
+  m_polygon = { { x_min, y_min }, { x_max, y_min }, { x_max, y_max }, { x_min, y_max } };
+
+  m_texture = Texture2D(Image(m_rect.width, m_rect.height, 1, NULL));
+  glBindTexture(GL_TEXTURE_2D, m_texture->id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_rect.width, m_rect.height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  framebuffer.attach_texture(mask);
+  framebuffer.bind();
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_rect.x, m_rect.y, m_rect.width, m_rect.height);
+  framebuffer.unbind();
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/* Scanline fill of polygon over bounding box (pixel selected if its center is inside) */
+void SelectionMask::rasterize(std::vector<unsigned char>& coverages) const {
+  coverages.assign((size_t) m_rect.width * m_rect.height, 0);
+  std::vector<float> crossings;
+  size_t n_vertices = m_polygon.size();
+
+  for (int y = 0; y < m_rect.height; y++) {
+    // abscissas where edges cross the row's centerline (half-open rule avoids counting shared vertices twice)
+    float y_center = m_rect.y + y + 0.5f;
+    crossings.clear();
+    for (size_t i_vertex = 0; i_vertex < n_vertices; i_vertex++) {
+      const Vertex& a = m_polygon[i_vertex];
+      const Vertex& b = m_polygon[(i_vertex + 1) % n_vertices];
+      if ((a.y <= y_center) == (b.y <= y_center))
+        continue;
+
+      crossings.push_back(a.x + (y_center - a.y) / (b.y - a.y) * (b.x - a.x));
+    }
+
+    std::sort(crossings.begin(), crossings.end());
+    unsigned char* row = coverages.data() + (size_t) y * m_rect.width;
+    for (size_t i_crossing = 0; i_crossing + 1 < crossings.size(); i_crossing += 2) {
+      int x_start = std::max((int) std::ceil(crossings[i_crossing] - 0.5f) - m_rect.x, 0);
+      int x_end = std::min((int) std::ceil(crossings[i_crossing + 1] - 0.5f) - m_rect.x, m_rect.width);
+      if (x_start < x_end)
+        std::fill(row + x_start, row + x_end, 255);
+    }
+  }
+}
+
+/* Whole image affected by effects again */
+void SelectionMask::clear() {
+  if (m_texture)
+    m_texture->free();
+  m_texture.reset();
+  m_polygon.clear();
+  m_rect = { 0, 0, 0, 0 };
+}
+
+bool SelectionMask::is_empty() const {
+  return !m_texture;
+}
+
+/* Bounding box of selection (effects passes scissored to it) */
+const DirtyRegion::Rect& SelectionMask::get_rect() const {
+  return m_rect;
+}
+
+/* Vertices of selection (to draw its outline) */
+const std::vector<SelectionMask::Vertex>& SelectionMask::get_polygon() const {
+  return m_polygon;
+}
+
+/**
+ * Render effects' output inside selection & their input outside it into `target`, over bounding box only
+ * (rest of target left undefined, as it's never shown), renderer's program restored afterwards
+ * Throws `ShaderException` if program failed to compile
+ * @param input Texture effects were applied to
+ * @param effects Output of effects (only valid over bounding box)
+ */
+void SelectionMask::blend(Renderer& renderer, Framebuffer& framebuffer, const Texture2D& input, const Texture2D& effects,
+                          const Texture2D& target) {
+  if (!m_program) {
+    Program program("assets/shaders/fbo.vert", "assets/shaders/selection.frag");
+    if (program.has_failed()) {
+      program.free();
+      throw ShaderException();
+    }
+
+    // samplers of input & mask bound to units 1 & 2 (effects' output sampled by renderer from unit 0)
+    m_program = program;
+    m_location_texture_input = glGetUniformLocation(program.id, "texture_input");
+    m_location_mask = glGetUniformLocation(program.id, "mask");
+    m_location_origin_mask = glGetUniformLocation(program.id, "origin_mask");
+    program.use();
+    glUniform1i(glGetUniformLocation(program.id, "texture2d"), 0);
+    glUniform1i(m_location_texture_input, 1);
+    glUniform1i(m_location_mask, 2);
+    program.unuse();
+  }
+
+  m_program->use();
+  glUniform2i(m_location_origin_mask, m_rect.x, m_rect.y);
+  m_program->unuse();
+
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, input.id);
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_2D, m_texture->id);
+  glActiveTexture(GL_TEXTURE0);
+
+  framebuffer.attach_texture(target);
+  framebuffer.bind();
+  glViewport(0, 0, target.width, target.height);
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(m_rect.x, m_rect.y, m_rect.width, m_rect.height);
+
+  Program program_view = renderer.program;
+  renderer.program = *m_program;
+  renderer.draw({ {"texture2d", effects} });
+  renderer.program = program_view;
+
+  glDisable(GL_SCISSOR_TEST);
+  framebuffer.unbind();
+
+  glActiveTexture(GL_TEXTURE2);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+}
+
+void SelectionMask::free() {
+  clear();
+  if (m_program)
+    m_program->free();
+  m_program.reset();
+}
@@ -0,0 +1,249 @@
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+#include "gpu/sequence_player.hpp"
+#include "image/image_decoder.hpp"
+#include "profiling/memory_tracker.hpp"
+
+namespace {
+  /* Extension in lowercase */
+  std::string get_extension(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension;
+  }
+
+  /* File name without extension split into prefix & trailing digits (empty if none) */
+  std::pair<std::string, std::string> split_number(const std::filesystem::path& path) {
+    std::string stem = path.stem().string();
+    size_t i_digits = stem.size();
+    while (i_digits > 0 && std::isdigit((unsigned char) stem[i_digits - 1]))
+      i_digits--;
+
+    return { stem.substr(0, i_digits), stem.substr(i_digits) };
+  }
+}
+
+/* static members definition (avoids linking error) & initialization */
+SequencePlayer::Stats SequencePlayer::stats = { false, 0, 0, 0, 0, 0, 0, 0.0f, 0.0f };
+
+SequencePlayer::SequencePlayer():
+  m_fps(FPS_DEFAULT),
+  m_frame_next(),
+  m_i_slot(-1),
+  m_n_shown(0),
+  m_n_dropped(0),
+  m_duration_decode(0.0f),
+  m_duration_decode_max(0.0f),
+  m_has_failed(false),
+  m_pbos{ 0, 0 },
+  m_i_pbo(0)
+{
+}
+
+/**
+ * Frames of sequence `path` belongs to: files in its folder with same prefix & extension, followed by a number
+ * Sorted by number (padded or not)
+ * @return Empty if name of `path` doesn't end with a number
+ */
+std::vector<std::string> SequencePlayer::list_frames(const std::string& path) {
+  namespace fs = std::filesystem;
+  auto [prefix, digits] = split_number(path);
+  std::string extension = get_extension(path);
+  if (digits.empty())
+    return {};
+
+  std::vector<std::pair<unsigned long long, std::string>> frames;
+  std::error_code error;
+  fs::path dir = fs::path(path).parent_path();
+  for (const auto& entry : fs::directory_iterator(dir.empty() ? fs::path(".") : dir, error)) {
+    auto [prefix_entry, digits_entry] = split_number(entry.path());
+    if (prefix_entry == prefix && !digits_entry.empty() && digits_entry.size() < 20 &&
+        get_extension(entry.path()) == extension && entry.is_regular_file(error))
+      frames.push_back({ std::stoull(digits_entry), entry.path().string() });
+  }
+
+  std::sort(frames.begin(), frames.end());
+  std::vector<std::string> paths;
+  for (const auto& frame : frames)
+    paths.push_back(frame.second);
+
+  return paths;
+}
+
+/**
+ * Start playing sequence `path` belongs to from its first frame (previous playback stopped)
+ * @return false if there's no sequence of at least 2 frames
+ */
+bool SequencePlayer::start(const std::string& path, int fps) {
+  stop();
+  m_paths = list_frames(path);
+  if (m_paths.size() < 2)
+    return false;
+
+  if (m_pbos[0] == 0)
+    glGenBuffers(2, m_pbos);
+
+  m_fps = std::max(fps, 1);
+  m_frames = std::make_unique<BoundedQueue<Frame>>(N_FRAMES_RING);
+  m_frame_next = {};
+  m_time_start = std::chrono::steady_clock::now();
+  m_i_slot = -1;
+  m_n_shown = 0;
+  m_n_dropped = 0;
+  m_duration_decode = 0.0f;
+  m_duration_decode_max = 0.0f;
+  m_has_failed = false;
+
+  m_thread = std::thread(&SequencePlayer::decode, this);
+  update_stats();
+  return true;
+}
+
+/* Decoder thread: frames in order (looping), until ring is closed */
+void SequencePlayer::decode() {
+  // decoded pixels freed when last reference dropped (i.e. after upload, or when ring is discarded)
+  auto deleter = [](Image* image) {
+    image->free();
+    delete image;
+  };
+
+  size_t n_failed = 0;
+  for (int index = 0; !m_frames->is_closed(); index++) {
+    auto time_start = std::chrono::steady_clock::now();
+    std::shared_ptr<Image> image(new Image(ImageDecoder::decode(m_paths[index % m_paths.size()])), deleter);
+    float duration = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - time_start).count();
+    m_duration_decode = duration;
+    m_duration_decode_max = std::max(m_duration_decode_max.load(), duration);
+
+    // unreadable frames skipped (counted as dropped once time passes them), decoder stops if none is readable
+    if (image->data == NULL) {
+      if (++n_failed < m_paths.size())
+        continue;
+
+      m_has_failed = true;
+      m_frames->close();
+      break;
+    }
+    n_failed = 0;
+
+    if (!m_frames->push({ index, image }))
+      break;
+  }
+}
+
+/**
+ * Latest decoded frame due at current time (called once per app frame)
+ * @return NULL if frame shown last is still due, or next one isn't decoded yet
+ */
+std::shared_ptr<Image> SequencePlayer::get_frame() {
+  if (!m_frames)
+    return NULL;
+
+  float time = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_time_start).count();
+  int i_slot = (int) (time * m_fps);
+  std::shared_ptr<Image> image;
+  int index = -1;
+
+  if (i_slot != m_i_slot) {
+    // frames due meanwhile & overtaken by a later one are skipped
+    while (m_frame_next.image || m_frames->try_pop(m_frame_next)) {
+      if (m_frame_next.index > i_slot)
+        break;
+
+      image = m_frame_next.image;
+      index = m_frame_next.index;
+      m_frame_next = {};
+    }
+  }
+
+  if (image) {
+    // clock shifted back to a late frame (decoder slower than frame rate)
+    if (index < i_slot) {
+      m_time_start += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>((float) (i_slot - index) / m_fps));
+    }
+
+    m_n_dropped += std::max(i_slot - m_i_slot - 1, 0);
+    m_i_slot = index;
+    m_n_shown++;
+  }
+
+  update_stats();
+  return image;
+}
+
+/**
+ * Copy frame into texture through next pbo (transfer to texture done asynchronously by driver)
+ * Texture must have frame's size & # of channels (8-bit)
+ */
+void SequencePlayer::upload(const Texture2D& texture, const Image& frame) {
+  GLuint pbo = m_pbos[m_i_pbo];
+  m_i_pbo = 1 - m_i_pbo;
+  size_t size = (size_t) frame.width * frame.height * frame.n_channels;
+
+  // orphaned storage (mapping doesn't wait for a transfer still reading it)
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+  MemoryTracker::get().track(MemoryKind::BUFFER, pbo, "sequence", "unpack pbo", size);
+  void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (data != NULL) {
+    std::memcpy(data, frame.data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.width, frame.height, texture.format, GL_UNSIGNED_BYTE, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/* Counters shown by overlay (from main thread) */
+void SequencePlayer::update_stats() {
+  stats = {
+    is_playing(), m_fps, (int) m_paths.size(), m_i_slot < 0 ? 0 : m_i_slot % (int) m_paths.size(),
+    m_n_shown, m_n_dropped, m_frames ? (int) m_frames->size() : 0, m_duration_decode, m_duration_decode_max
+  };
+}
+
+/* Stop decoder thread (waits for frame being decoded) & drop frames decoded ahead */
+void SequencePlayer::stop() {
+  if (!m_frames)
+    return;
+
+  m_frames->close();
+  if (m_thread.joinable())
+    m_thread.join();
+
+  m_frames.reset();
+  m_frame_next = {};
+  update_stats();
+}
+
+bool SequencePlayer::is_playing() const {
+  return m_frames != NULL;
+}
+
+/* Whole pass over sequence failed to decode (playback to be stopped by caller) */
+bool SequencePlayer::has_failed() const {
+  return m_has_failed;
+}
+
+unsigned int SequencePlayer::get_n_shown() const {
+  return m_n_shown;
+}
+
+void SequencePlayer::free() {
+  stop();
+  if (m_pbos[0] == 0)
+    return;
+
+  MemoryTracker::get().untrack(MemoryKind::BUFFER, m_pbos[0]);
+  MemoryTracker::get().untrack(MemoryKind::BUFFER, m_pbos[1]);
+  glDeleteBuffers(2, m_pbos);
+  m_pbos[0] = m_pbos[1] = 0;
+}
@@ -0,0 +1,170 @@
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "gpu/shared_surface.hpp"
+#include "gpu/pixel_format.hpp"
+#include "gpu/texture_pool.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+std::string SharedSurface::name = "";
+
+SharedSurface::SharedSurface():
+  m_fd(-1),
+  m_data(NULL),
+  m_n_bytes(0),
+  m_source(NULL),
+  m_revision(0),
+  m_ticket(),
+  m_snapshot()
+{
+}
+
+SharedSurface& SharedSurface::get() {
+  static SharedSurface shared;
+  return shared;
+}
+
+/* Whether given revision of document was already published (nothing to do) */
+bool SharedSurface::is_current(const void* source, unsigned int revision) const {
+  return source == m_source && revision == m_revision;
+}
+
+SharedSurface::Header* SharedSurface::get_header() const {
+  return (Header*) m_data;
+}
+
+/**
+ * Create shared-memory object on first call, & grow it to `n_bytes` (never shrunk, so readers' mappings stay valid)
+ * @return false if it couldn't be created or mapped (e.g. no posix shared memory on this platform)
+ */
+bool SharedSurface::map(size_t n_bytes) {
+#ifdef _WIN32
+  return false;
+#else
+  if (m_data != NULL && n_bytes <= m_n_bytes)
+    return true;
+
+  if (m_fd < 0) {
+    m_fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd < 0)
+      return false;
+  }
+
+  // previous mapping's header carried over (sequence keeps increasing for readers)
+  uint64_t sequence = m_data != NULL ? get_header()->sequence.load() : 0;
+  if (m_data != NULL)
+    munmap(m_data, m_n_bytes);
+  m_data = NULL;
+
+  void* data = MAP_FAILED;
+  if (ftruncate(m_fd, n_bytes) == 0)
+    data = mmap(NULL, n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED)
+    return false;
+
+  m_data = (unsigned char*) data;
+  m_n_bytes = n_bytes;
+
+  Header* header = get_header();
+  std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+  header->version = 1;
+  header->sequence = sequence + (sequence % 2);
+  header->n_bytes_mapping = n_bytes;
+  return true;
+#endif
+}
+
+/**
+ * Publish texture's pixels (called when canvas changed), skipped while previous publish is still running
+ * Channels & size of texture given in header (rows of a 8-bit texture, 16-bit/float textures converted by gpu)
+ * @param source,revision Document & its revision texture shows (see `is_current()`)
+ * @return false if skipped (so caller retries later) or shared memory is unavailable
+ */
+bool SharedSurface::publish(const Texture2D& texture, const void* source, unsigned int revision) {
+  if (is_busy())
+    return false;
+
+  m_ticket.reset();
+  release_snapshot();
+  int n_channels = PixelFormat::get_n_channels(texture);
+  size_t n_bytes_row = (size_t) texture.width * n_channels;
+  if (!map(N_BYTES_HEADER + n_bytes_row * texture.height))
+    return false;
+
+  const GLenum FORMATS[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+  GLenum format = FORMATS[n_channels - 1];
+  Header* header = get_header();
+  unsigned char* pixels = m_data + N_BYTES_HEADER;
+  int width = texture.width, height = texture.height;
+
+  // odd sequence while dimensions & pixels are written
+  auto write = [header, pixels, format, width, height, n_channels, n_bytes_row](GLuint id_texture) {
+    header->sequence.fetch_add(1, std::memory_order_acq_rel);
+    header->width = width;
+    header->height = height;
+    header->n_channels = n_channels;
+    header->n_bytes_row = n_bytes_row;
+
+    glBindTexture(GL_TEXTURE_2D, id_texture);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    header->sequence.fetch_add(1, std::memory_order_release);
+  };
+
+  // main thread waits for pixels otherwise (stalls until effects are rendered)
+  // worker reads a snapshot copied on main context, as texture may be rendered to again before worker runs
+  if (GlWorker::get().is_available() && GLAD_GL_VERSION_4_3) {
+    TexturePool& pool = TexturePool::get();
+    m_snapshot = pool.acquire(width, height, n_channels, pool.get_depth(texture), "shared surface");
+    glCopyImageSubData(texture.id, GL_TEXTURE_2D, 0, 0, 0, 0, m_snapshot->id, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+    GLuint id_texture = m_snapshot->id;
+    m_ticket = GlWorker::get().submit([write, id_texture]() { write(id_texture); });
+  } else {
+    write(texture.id);
+  }
+
+  m_source = source;
+  m_revision = revision;
+  return true;
+}
+
+/* Whether pixels are still being written by gl worker */
+bool SharedSurface::is_busy() const {
+  return m_ticket && !GlWorker::is_done(*m_ticket);
+}
+
+/* Snapshot read by worker given back to pool (once publish is done) */
+void SharedSurface::release_snapshot() {
+  if (!m_snapshot)
+    return;
+
+  TexturePool::get().release(*m_snapshot);
+  m_snapshot.reset();
+}
+
+/* Unmap & remove shared-memory object (readers keep their mapping until they unmap it) */
+void SharedSurface::free() {
+#ifndef _WIN32
+  if (m_ticket)
+    GlWorker::wait(*m_ticket);
+  m_ticket.reset();
+  release_snapshot();
+
+  if (m_data != NULL)
+    munmap(m_data, m_n_bytes);
+  if (m_fd >= 0) {
+    close(m_fd);
+    shm_unlink(name.c_str());
+  }
+
+  m_data = NULL;
+  m_n_bytes = 0;
+  m_fd = -1;
+#endif
+}
@@ -0,0 +1,93 @@
+#include "gpu/texture_cache.hpp"
+#include "gpu/texture_pool.hpp"
+#include "gpu/pixel_format.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * @param n_bytes_max Vram budget of cached textures (estimated from their size, rgb counted as rgba)
+ */
+TextureCache::TextureCache(size_t n_bytes_max):
+  m_n_bytes_max(n_bytes_max),
+  m_n_bytes(0)
+{
+}
+
+bool TextureCache::contains(const std::string& path) const {
+  return m_iterators.find(path) != m_iterators.end();
+}
+
+/* Cache texture (owned by cache until taken back), replacing any texture of same path */
+void TextureCache::insert(const std::string& path, const Texture2D& texture) {
+  std::optional<Texture2D> texture_old = take(path);
+  if (texture_old)
+    TexturePool::get().release(*texture_old);
+
+  // drivers store rgb textures with 4 channels per pixel
+  Depth depth = TexturePool::get().get_depth(texture);
+  size_t n_bytes = (size_t) texture.width * texture.height * 4 * PixelFormat::get_n_bytes_channel(depth);
+  m_entries.push_front({ path, texture, n_bytes });
+  m_iterators[path] = m_entries.begin();
+  m_n_bytes += n_bytes;
+  // textures not acquired from pool (e.g. initial image) registered here
+  if (!MemoryTracker::get().set_owner(MemoryKind::TEXTURE, texture.id, OWNER))
+    MemoryTracker::get().track(MemoryKind::TEXTURE, texture.id, OWNER, PixelFormat::get_name(depth), n_bytes);
+
+  evict();
+}
+
+/* Remove texture from cache & give its ownership to caller (e.g. to display it) */
+std::optional<Texture2D> TextureCache::take(const std::string& path) {
+  auto it = m_iterators.find(path);
+  if (it == m_iterators.end())
+    return std::nullopt;
+
+  Texture2D texture = it->second->texture;
+  m_n_bytes -= it->second->n_bytes;
+  m_entries.erase(it->second);
+  m_iterators.erase(it);
+  MemoryTracker::get().set_owner(MemoryKind::TEXTURE, texture.id, OWNER_TAKEN);
+
+  return texture;
+}
+
+/* Mark texture as recently used (e.g. neighbour still wanted), so it's evicted last */
+void TextureCache::touch(const std::string& path) {
+  auto it = m_iterators.find(path);
+  if (it != m_iterators.end())
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+}
+
+void TextureCache::set_n_bytes_max(size_t n_bytes_max) {
+  m_n_bytes_max = n_bytes_max;
+  evict();
+}
+
+size_t TextureCache::get_n_bytes() const {
+  return m_n_bytes;
+}
+
+size_t TextureCache::get_size() const {
+  return m_entries.size();
+}
+
+/* Release least recently used textures until within budget (most recent one always kept) */
+void TextureCache::evict() {
+  while (m_n_bytes > m_n_bytes_max && m_entries.size() > 1) {
+    // neighbours of same size likely (e.g. photos from one camera), so storage is recycled
+    Entry& entry = m_entries.back();
+    TexturePool::get().release(entry.texture);
+    m_n_bytes -= entry.n_bytes;
+    m_iterators.erase(entry.path);
+    m_entries.pop_back();
+  }
+}
+
+/* Give all textures back to pool */
+void TextureCache::free() {
+  for (Entry& entry : m_entries)
+    TexturePool::get().release(entry.texture);
+
+  m_entries.clear();
+  m_iterators.clear();
+  m_n_bytes = 0;
+}
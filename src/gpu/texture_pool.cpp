@@ -0,0 +1,145 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpu/texture_pool.hpp"
+#include "gpu/pixel_format.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * @param n_bytes_cached_max Max. total size of released textures kept for reuse
+ */
+TexturePool::TexturePool(size_t n_bytes_cached_max):
+  m_n_bytes_cached_max(n_bytes_cached_max),
+  m_stats({ 0, 0, 0 }),
+  m_i_released(0)
+{
+}
+
+/* Pool shared by canvas textures (opened images, effects target & prefetched neighbours) */
+TexturePool& TexturePool::get() {
+  static TexturePool pool;
+  return pool;
+}
+
+/* Estimated vram of texture incl. its mip chain (rgb stored as rgba by drivers) */
+size_t TexturePool::get_n_bytes(int width, int height, Depth depth) {
+  return (size_t) width * height * 4 * PixelFormat::get_n_bytes_channel(depth) * 4 / 3;
+}
+
+/**
+ * Texture of given size, # of channels & depth (content undefined), reused from a released one if possible
+ * Mip chain allocated upfront with immutable storage (levels generated by `MipChain` when zoomed out)
+ * Storage of 16-bit & half-float textures always set here (mutable one if immutable storage unsupported)
+ * @param owner Shown in memory panel (e.g. "effects target")
+ */
+Texture2D TexturePool::acquire(int width, int height, int n_channels, Depth depth, const std::string& owner) {
+  auto it = m_buckets.find({ width, height, n_channels, depth });
+  if (it != m_buckets.end() && !it->second.empty()) {
+    Entry entry = it->second.back();
+    it->second.pop_back();
+    m_stats.n_bytes_cached -= entry.n_bytes;
+    m_stats.n_hits++;
+    m_formats[entry.texture.id] = { n_channels, depth };
+    MemoryTracker::get().set_owner(MemoryKind::TEXTURE, entry.texture.id, owner);
+    return entry.texture;
+  }
+
+  // mutable storage given by constructor replaced before any data is uploaded
+  Texture2D texture(Image(width, height, n_channels, NULL));
+  GLenum format_sized = PixelFormat::get_format_sized(n_channels, depth);
+  if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage) {
+    int n_levels = 1 + (int) std::floor(std::log2(std::max(width, height)));
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexStorage2D(GL_TEXTURE_2D, n_levels, format_sized, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  } else if (depth != Depth::UNORM8) {
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, format_sized, width, height, 0, texture.format, PixelFormat::get_type(depth), NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  // kept by texture when recycled (same # of channels)
+  PixelFormat::swizzle_gray(texture);
+
+  m_stats.n_misses++;
+  m_formats[texture.id] = { n_channels, depth };
+  std::string format = std::to_string(n_channels) + " ch " + PixelFormat::get_name(depth);
+  MemoryTracker::get().track(MemoryKind::TEXTURE, texture.id, owner, format, get_n_bytes(width, height, depth));
+  return texture;
+}
+
+/* Give texture back for reuse (freed if it wasn't acquired from pool) */
+void TexturePool::release(const Texture2D& texture) {
+  auto it = m_formats.find(texture.id);
+  if (it == m_formats.end()) {
+    MemoryTracker::get().untrack(MemoryKind::TEXTURE, texture.id);
+    texture.free();
+    return;
+  }
+
+  Format format = it->second;
+  m_formats.erase(it);
+
+  // sampling state reset (e.g. mip levels enabled while zoomed out)
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  size_t n_bytes = get_n_bytes(texture.width, texture.height, format.depth);
+  m_buckets[{ texture.width, texture.height, format.n_channels, format.depth }].push_back({ texture, n_bytes, m_i_released++ });
+  m_stats.n_bytes_cached += n_bytes;
+  MemoryTracker::get().set_owner(MemoryKind::TEXTURE, texture.id, OWNER);
+  evict();
+}
+
+/* Depth of texture handed out by pool (8-bit for textures created elsewhere, e.g. initial image) */
+Depth TexturePool::get_depth(const Texture2D& texture) const {
+  auto it = m_formats.find(texture.id);
+  return (it != m_formats.end()) ? it->second.depth : Depth::UNORM8;
+}
+
+/* Free least recently released textures until within budget */
+void TexturePool::evict() {
+  while (m_stats.n_bytes_cached > m_n_bytes_cached_max) {
+    auto it_oldest = m_buckets.end();
+    for (auto it = m_buckets.begin(); it != m_buckets.end(); ++it) {
+      if (!it->second.empty() && (it_oldest == m_buckets.end() || it->second.front().i_released < it_oldest->second.front().i_released))
+        it_oldest = it;
+    }
+
+    if (it_oldest == m_buckets.end())
+      break;
+
+    Entry& entry = it_oldest->second.front();
+    MemoryTracker::get().untrack(MemoryKind::TEXTURE, entry.texture.id);
+    entry.texture.free();
+    m_stats.n_bytes_cached -= entry.n_bytes;
+    it_oldest->second.erase(it_oldest->second.begin());
+  }
+}
+
+TexturePool::Stats TexturePool::get_stats() const {
+  return m_stats;
+}
+
+/* Free textures kept for reuse now (e.g. vram given back when switching to a compressed image) */
+void TexturePool::trim() {
+  for (auto& pair : m_buckets) {
+    for (Entry& entry : pair.second) {
+      MemoryTracker::get().untrack(MemoryKind::TEXTURE, entry.texture.id);
+      entry.texture.free();
+    }
+  }
+
+  m_buckets.clear();
+  m_stats.n_bytes_cached = 0;
+}
+
+/* Free textures kept for reuse (textures handed out are freed by their owners) */
+void TexturePool::free() {
+  trim();
+  m_formats.clear();
+}
@@ -0,0 +1,155 @@
+#include <cstring>
+#include <algorithm>
+
+#include "gpu/texture_uploader.hpp"
+#include "gpu/upload_ring.hpp"
+#include "gpu/pixel_format.hpp"
+#include "profiling/memory_tracker.hpp"
+
+TextureUploader::TextureUploader(size_t size_band):
+  m_size_band(size_band),
+  m_id_texture(0),
+  m_format(GL_RGBA),
+  m_type(GL_UNSIGNED_BYTE),
+  m_n_bytes_row(0),
+  m_n_rows_band(0),
+  m_i_row(0)
+{
+  glGenBuffers(1, &m_pbo);
+}
+
+/**
+ * Start uploading `image` to `texture` (storage of same size must already be allocated)
+ * Image kept alive until upload finishes
+ * @param depth Depth of image's channels (16-bit samples take 2 bytes in `image->data`)
+ */
+void TextureUploader::start(const Texture2D& texture, const std::shared_ptr<Image>& image, Depth depth) {
+  m_id_texture = texture.id;
+  m_format = texture.format;
+  m_type = PixelFormat::get_type(depth);
+  m_image = image;
+  m_i_row = 0;
+
+  m_n_bytes_row = (size_t) image->width * image->n_channels * PixelFormat::get_n_bytes_channel(depth);
+  m_n_rows_band = std::max(1, (int) (m_size_band / m_n_bytes_row));
+
+  if (GlWorker::get().is_available())
+    start_worker();
+}
+
+/* Upload all bands on worker's shared context (driver copies from client memory there, not on main thread) */
+void TextureUploader::start_worker() {
+  std::shared_ptr<Upload> upload = std::make_shared<Upload>();
+  upload->i_row = 0;
+  upload->is_cancelled = false;
+  m_upload = upload;
+
+  GLuint id_texture = m_id_texture;
+  GLenum format = m_format, type = m_type;
+  std::shared_ptr<Image> image = m_image;
+  size_t n_bytes_row = m_n_bytes_row;
+  int n_rows_band = m_n_rows_band;
+
+  m_ticket = GlWorker::get().submit([upload, id_texture, format, type, image, n_bytes_row, n_rows_band]() {
+    glBindTexture(GL_TEXTURE_2D, id_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i_row = 0; i_row < image->height && !upload->is_cancelled; i_row += n_rows_band) {
+      int n_rows = std::min(n_rows_band, image->height - i_row);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, i_row, image->width, n_rows, format, type, image->data + n_bytes_row * i_row);
+      upload->i_row = i_row + n_rows;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+  });
+}
+
+/**
+ * Upload next band of rows (to call once per frame)
+ * @return true when whole image uploaded
+ */
+bool TextureUploader::update() {
+  if (!is_busy())
+    return true;
+
+  // image released once worker's upload is visible to main context
+  if (m_ticket) {
+    if (!GlWorker::is_done(*m_ticket))
+      return false;
+
+    m_ticket.reset();
+    m_upload.reset();
+    m_image.reset();
+    return true;
+  }
+
+  int n_rows = std::min(m_n_rows_band, m_image->height - m_i_row);
+  size_t size = m_n_bytes_row * n_rows;
+
+  // band written straight into persistently mapped ring when available
+  UploadRing::Region region;
+  if (UploadRing::get().allocate(size, region)) {
+    std::memcpy(region.data, m_image->data + m_n_bytes_row * m_i_row, size);
+    UploadRing::get().upload(region, m_id_texture, 0, m_i_row, m_image->width, n_rows, m_format, m_type);
+    m_i_row += n_rows;
+  } else {
+    upload_pbo(n_rows);
+  }
+
+  // release image once fully uploaded
+  if (m_i_row < m_image->height)
+    return false;
+
+  m_image.reset();
+  return true;
+}
+
+/* Upload band of `n_rows` through own PBO (buffer storage unsupported or band larger than ring) */
+void TextureUploader::upload_pbo(int n_rows) {
+  size_t size = m_n_bytes_row * n_rows;
+
+  // orphan previous storage so mapping doesn't wait for last band's transfer
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+  MemoryTracker::get().track(MemoryKind::BUFFER, m_pbo, "texture uploader", "unpack pbo", size);
+  void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (data != NULL) {
+    std::memcpy(data, m_image->data + m_n_bytes_row * m_i_row, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // last arg is an offset into bound PBO (transfer to texture done asynchronously by driver)
+    glBindTexture(GL_TEXTURE_2D, m_id_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_i_row, m_image->width, n_rows, m_format, m_type, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  m_i_row += n_rows;
+}
+
+/* Stop uploading current image (texture left partially uploaded) */
+void TextureUploader::cancel() {
+  if (m_upload)
+    m_upload->is_cancelled = true;
+
+  m_ticket.reset();
+  m_upload.reset();
+  m_image.reset();
+}
+
+bool TextureUploader::is_busy() const {
+  return m_image != nullptr;
+}
+
+/* Fraction of rows uploaded in [0, 1] */
+float TextureUploader::get_progress() const {
+  if (!is_busy())
+    return 1.0f;
+
+  int i_row = m_upload ? m_upload->i_row.load() : m_i_row;
+  return (float) i_row / m_image->height;
+}
+
+void TextureUploader::free() {
+  MemoryTracker::get().untrack(MemoryKind::BUFFER, m_pbo);
+  glDeleteBuffers(1, &m_pbo);
+}
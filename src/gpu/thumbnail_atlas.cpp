@@ -0,0 +1,171 @@
+#include <algorithm>
+
+#include "gpu/thumbnail_atlas.hpp"
+#include "gpu/texture_pool.hpp"
+#include "gpu/gpu_resources.hpp"
+
+ThumbnailAtlas::ThumbnailAtlas()
+{
+}
+
+/* Atlas texture (cleared to gray, as shown by placeholders) & its fbo, created on first use (gl context current) */
+void ThumbnailAtlas::create() {
+  if (m_texture)
+    return;
+
+  // last slot never given to a thumbnail (left gray for placeholders)
+  m_slots_free.clear();
+  for (int i_slot = N_SLOTS_X * N_SLOTS_Y - 2; i_slot >= 0; i_slot--)
+    m_slots_free.push_back(i_slot);
+
+  m_texture = TexturePool::get().acquire(N_SLOTS_X * SIZE_SLOT, N_SLOTS_Y * SIZE_SLOT, 4, Depth::UNORM8, OWNER);
+  m_framebuffer.emplace();
+  m_framebuffer->attach_texture(*m_texture);
+  m_framebuffer->bind();
+  glViewport(0, 0, m_texture->width, m_texture->height);
+  m_framebuffer->clear({ 0.5f, 0.5f, 0.5f, 1.0f });
+  m_framebuffer->unbind();
+}
+
+/* Slot of a new thumbnail (that of least recently captured one when atlas is full) */
+int ThumbnailAtlas::take_slot() {
+  if (!m_slots_free.empty()) {
+    int i_slot = m_slots_free.back();
+    m_slots_free.pop_back();
+    return i_slot;
+  }
+
+  Entry entry = m_entries.back();
+  m_iterators.erase(entry.path);
+  m_entries.pop_back();
+  return entry.i_slot;
+}
+
+/* Draw whole `source` into given pixels of `target` (bilinear, so a 2:1 draw averages 2x2 texels) */
+void ThumbnailAtlas::draw(const Texture2D& source, const Texture2D& target, int x, int y, int width, int height) {
+  Renderer& renderer = GpuResources::get().get_renderer();
+  m_framebuffer->attach_texture(target);
+  m_framebuffer->bind();
+  glEnable(GL_SCISSOR_TEST);
+  glViewport(x, y, width, height);
+  glScissor(x, y, width, height);
+  m_framebuffer->clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+
+  Program program_view = renderer.program;
+  renderer.program = GpuResources::get().get_programs().get(Shader::COLOR);
+  renderer.draw({ {"texture2d", source} });
+  renderer.program = program_view;
+
+  glDisable(GL_SCISSOR_TEST);
+  m_framebuffer->unbind();
+}
+
+/**
+ * Render thumbnail of texture into its slot, replacing previous thumbnail of same path
+ * Halved by successive 2:1 passes until thumbnail's size is reached (one large minification would alias)
+ * Base level of texture sampled (its mip levels may lag behind its content, see `MipChain`)
+ * @param texture Canvas output (gray if swizzled from a single channel)
+ * @return false if texture is empty
+ */
+bool ThumbnailAtlas::capture(const std::string& path, const Texture2D& texture) {
+  if (texture.width <= 0 || texture.height <= 0)
+    return false;
+
+  create();
+  auto it = m_iterators.find(path);
+  Entry entry;
+  if (it != m_iterators.end()) {
+    entry = *it->second;
+    m_entries.erase(it->second);
+    m_iterators.erase(it);
+  } else {
+    entry = { path, take_slot(), 0, 0 };
+  }
+
+  // fitted into slot keeping aspect ratio (images smaller than a slot aren't enlarged)
+  float scale = std::min(1.0f, (float) SIZE_SLOT / std::max(texture.width, texture.height));
+  entry.width = std::max(1, (int) (texture.width * scale));
+  entry.height = std::max(1, (int) (texture.height * scale));
+
+  GLint filter_min;
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter_min);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // intermediate levels in pooled textures (released right after, so reused by next capture)
+  std::vector<Texture2D> levels;
+  const Texture2D* source = &texture;
+  int width = texture.width, height = texture.height;
+  while (width > 2 * entry.width || height > 2 * entry.height) {
+    width = std::max(entry.width, (width + 1) / 2);
+    height = std::max(entry.height, (height + 1) / 2);
+    levels.push_back(TexturePool::get().acquire(width, height, 4, Depth::UNORM8, OWNER));
+    draw(*source, levels.back(), 0, 0, width, height);
+    source = &levels.back();
+  }
+
+  int x = (entry.i_slot % N_SLOTS_X) * SIZE_SLOT + (SIZE_SLOT - entry.width) / 2;
+  int y = (entry.i_slot / N_SLOTS_X) * SIZE_SLOT + (SIZE_SLOT - entry.height) / 2;
+  draw(*source, *m_texture, x, y, entry.width, entry.height);
+
+  for (const Texture2D& level : levels)
+    TexturePool::get().release(level);
+
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_min);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  m_entries.push_front(entry);
+  m_iterators[path] = m_entries.begin();
+  return true;
+}
+
+bool ThumbnailAtlas::contains(const std::string& path) const {
+  return m_iterators.find(path) != m_iterators.end();
+}
+
+/* Region of thumbnail, or of gray last slot if path has none (same texture drawn either way) */
+ThumbnailAtlas::Region ThumbnailAtlas::get_region(const std::string& path) const {
+  const float SIZE_U = 1.0f / N_SLOTS_X, SIZE_V = 1.0f / N_SLOTS_Y;
+  auto it = m_iterators.find(path);
+  if (it == m_iterators.end()) {
+    float u = (N_SLOTS_X - 1) * SIZE_U, v = (N_SLOTS_Y - 1) * SIZE_V;
+    return { u, v, u + SIZE_U, v + SIZE_V };
+  }
+
+  // pixels of thumbnail only (centered in its slot)
+  const Entry& entry = *it->second;
+  float x = (entry.i_slot % N_SLOTS_X) * SIZE_SLOT + (SIZE_SLOT - entry.width) / 2;
+  float y = (entry.i_slot / N_SLOTS_X) * SIZE_SLOT + (SIZE_SLOT - entry.height) / 2;
+  float width = N_SLOTS_X * SIZE_SLOT, height = N_SLOTS_Y * SIZE_SLOT;
+  return { x / width, y / height, (x + entry.width) / width, (y + entry.height) / height };
+}
+
+/* Free slot of thumbnail (e.g. file no longer listed) */
+void ThumbnailAtlas::remove(const std::string& path) {
+  auto it = m_iterators.find(path);
+  if (it == m_iterators.end())
+    return;
+
+  m_slots_free.push_back(it->second->i_slot);
+  m_entries.erase(it->second);
+  m_iterators.erase(it);
+}
+
+/* Id of atlas texture (0 until created, nothing to draw then) */
+GLuint ThumbnailAtlas::get_id() const {
+  return m_texture ? m_texture->id : 0;
+}
+
+void ThumbnailAtlas::free() {
+  if (m_texture)
+    TexturePool::get().release(*m_texture);
+  if (m_framebuffer)
+    m_framebuffer->free();
+
+  m_texture.reset();
+  m_framebuffer.reset();
+  m_entries.clear();
+  m_iterators.clear();
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "gpu/tile_scheduler.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+float TileScheduler::budget = 0.0f;
+
+TileScheduler::TileScheduler():
+  m_queries { 0, 0 },
+  m_is_pending(false),
+  m_is_open(false),
+  m_n_tiles_timed(0),
+  m_duration(0.0f),
+  m_duration_tile(-1.0f)
+{
+}
+
+bool TileScheduler::is_enabled() const {
+  return budget > 0.0f;
+}
+
+/* Fold measure of a previous frame into cost of a tile, once query result is available */
+void TileScheduler::read() {
+  if (!m_is_pending)
+    return;
+
+  GLint is_available;
+  glGetQueryObjectiv(m_queries[1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+  if (!is_available)
+    return;
+
+  GLuint64 time_start, time_end;
+  glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &time_start);
+  glGetQueryObjectui64v(m_queries[1], GL_QUERY_RESULT, &time_end);
+  m_is_pending = false;
+  m_duration = (time_end - time_start) / 1e6f;
+
+  float duration_tile = m_duration / std::max(m_n_tiles_timed, 1);
+  m_duration_tile = (m_duration_tile < 0.0f) ? duration_tile :
+                    (1.0f - WEIGHT_MEASURE) * m_duration_tile + WEIGHT_MEASURE * duration_tile;
+}
+
+/**
+ * Tiles that fit in budget this frame (at least one, so a job always progresses)
+ * @return Unbounded if scheduler is disabled (job run at once)
+ */
+int TileScheduler::get_n_tiles_frame() {
+  read();
+  if (!is_enabled())
+    return std::numeric_limits<int>::max();
+
+  if (m_duration_tile < 0.0f)
+    return N_TILES_INITIAL;
+
+  return std::clamp((int) std::floor(budget / std::max(m_duration_tile, 1e-3f)), 1, N_TILES_MAX);
+}
+
+/* Start timing tiles of this frame (skipped if previous measure not read yet, as its queries are still in flight) */
+void TileScheduler::begin() {
+  read();
+  if (m_is_pending)
+    return;
+
+  if (m_queries[0] == 0)
+    glGenQueries(2, m_queries);
+  glQueryCounter(m_queries[0], GL_TIMESTAMP);
+  m_is_open = true;
+}
+
+/* @param n_tiles Tiles run since `begin()` (cost of one derived from their total) */
+void TileScheduler::end(int n_tiles) {
+  if (!m_is_open)
+    return;
+
+  glQueryCounter(m_queries[1], GL_TIMESTAMP);
+  m_is_open = false;
+  m_is_pending = true;
+  m_n_tiles_timed = n_tiles;
+}
+
+/* Gpu time of tiles run in last measured frame in ms */
+float TileScheduler::get_duration() {
+  read();
+  return m_duration;
+}
+
+/* Smoothed cost of a tile in ms (negative until first measure) */
+float TileScheduler::get_duration_tile() const {
+  return m_duration_tile;
+}
+
+void TileScheduler::free() {
+  if (m_queries[0] != 0)
+    glDeleteQueries(2, m_queries);
+  m_queries[0] = m_queries[1] = 0;
+  m_is_pending = false;
+  m_is_open = false;
+}
@@ -0,0 +1,446 @@
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+#include "gpu/tiled_image.hpp"
+#include "gpu/upload_ring.hpp"
+#include "gpu/pixel_format.hpp"
+#include "image/image_utils.hpp"
+#include "image/buffer_pool.hpp"
+
+static_assert(TiledImage::SIZE_TILE == PyramidFile::SIZE_TILE, "Gpu tiles must match pyramid's tiles");
+
+/**
+ * @param image Full-resolution cpu image (painted tiles written back to it on eviction)
+ * @param n_tiles_max Max. # of tiles resident on gpu (exceeded only if more tiles are visible)
+ */
+TiledImage::TiledImage(const std::shared_ptr<Image>& image, int n_tiles_max):
+  m_image(image),
+  m_pyramid(),
+  m_width(image->width),
+  m_height(image->height),
+  m_n_channels(image->n_channels),
+  m_n_tiles_max(n_tiles_max),
+  m_levels({ {
+    image->width, image->height,
+    (image->width + SIZE_TILE - 1) / SIZE_TILE, (image->height + SIZE_TILE - 1) / SIZE_TILE,
+    0
+  } }),
+  m_revision(1),
+  m_frame(0)
+{
+}
+
+/**
+ * @param pyramid Opened pyramid file, its tiles decoded when first visible (painted ones kept on cpu on eviction)
+ * @param n_tiles_max Max. # of tiles resident on gpu (exceeded only if more tiles are visible)
+ */
+TiledImage::TiledImage(const std::shared_ptr<PyramidFile>& pyramid, int n_tiles_max):
+  m_image(),
+  m_pyramid(pyramid),
+  m_width(pyramid->get_width()),
+  m_height(pyramid->get_height()),
+  m_n_channels(pyramid->get_n_channels()),
+  m_n_tiles_max(n_tiles_max),
+  m_revision(1),
+  m_frame(0)
+{
+  for (int level = 0; level < pyramid->get_n_levels(); level++)
+    m_levels.push_back(pyramid->get_level(level));
+}
+
+/**
+ * Draw visible tiles on current imgui window's drawlist (uploading missing ones)
+ * Pyramid drawn from its finest level not smaller than screen (tiles painted at full resolution drawn over it)
+ * Caller reserves layout space for visible region afterwards (e.g. with `ImGui::Dummy()`)
+ * @param has_effects Show effects textures (normal mode) or shapes textures (drawing mode)
+ * @param origin Image's upper-left corner on screen (accounts for canvas' zoom & pan)
+ * @param position_visible Upper-left corner of visible region in image pixels
+ * @param size_visible Size of visible region in image pixels
+ */
+void TiledImage::render(Renderer& renderer, Framebuffer& framebuffer, bool has_effects, float zoom, const ImVec2& origin,
+                        const ImVec2& position_visible, const ImVec2& size_visible) {
+  m_frame++;
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+
+  // texels of coarser levels cover 2^level image pixels
+  auto draw_tile = [&](Tile& tile) {
+    if (has_effects && tile.revision_effects != m_revision)
+      render_effects(tile, renderer, framebuffer);
+
+    const Texture2D& texture = has_effects ? tile.texture_effects : tile.texture_shapes;
+    float scale = zoom * (1 << tile.level);
+    ImVec2 p_min = { origin.x + zoom * tile.x, origin.y + zoom * tile.y };
+    ImVec2 p_max = { p_min.x + scale * texture.width, p_min.y + scale * texture.height };
+    draw_list->AddImage((void*)(intptr_t) texture.id, p_min, p_max);
+  };
+
+  int level = get_level(zoom);
+  const PyramidFile::Level& tiles = m_levels[level];
+  int size_tile = SIZE_TILE << level;
+  int i_tile_x_min = std::clamp((int) (position_visible.x / size_tile), 0, tiles.n_tiles_x - 1);
+  int i_tile_y_min = std::clamp((int) (position_visible.y / size_tile), 0, tiles.n_tiles_y - 1);
+  int i_tile_x_max = std::clamp((int) ((position_visible.x + size_visible.x) / size_tile), 0, tiles.n_tiles_x - 1);
+  int i_tile_y_max = std::clamp((int) ((position_visible.y + size_visible.y) / size_tile), 0, tiles.n_tiles_y - 1);
+
+  if (m_pyramid)
+    decode_tiles(level, i_tile_x_min, i_tile_y_min, i_tile_x_max, i_tile_y_max);
+
+  for (int i_tile_y = i_tile_y_min; i_tile_y <= i_tile_y_max; i_tile_y++) {
+    for (int i_tile_x = i_tile_x_min; i_tile_x <= i_tile_x_max; i_tile_x++)
+      draw_tile(get_tile(level, i_tile_x, i_tile_y));
+  }
+
+  // shapes only exist at full resolution
+  if (level > 0) {
+    const PyramidFile::Level& tiles_full = m_levels[0];
+    int i_tile_x_min_full = (int) (position_visible.x / SIZE_TILE);
+    int i_tile_y_min_full = (int) (position_visible.y / SIZE_TILE);
+    int i_tile_x_max_full = (int) ((position_visible.x + size_visible.x) / SIZE_TILE);
+    int i_tile_y_max_full = (int) ((position_visible.y + size_visible.y) / SIZE_TILE);
+
+    for (int i_tile : m_indices_painted) {
+      int i_tile_x = i_tile % tiles_full.n_tiles_x;
+      int i_tile_y = i_tile / tiles_full.n_tiles_x;
+      if (i_tile_x >= i_tile_x_min_full && i_tile_x <= i_tile_x_max_full &&
+          i_tile_y >= i_tile_y_min_full && i_tile_y <= i_tile_y_max_full)
+        draw_tile(get_tile(0, i_tile_x, i_tile_y));
+    }
+  }
+
+  evict();
+}
+
+/* Index of tile among resident ones (unique across levels) */
+int TiledImage::get_index(int level, int i_tile_x, int i_tile_y) const {
+  const PyramidFile::Level& tiles = m_levels[level];
+  return tiles.i_tile_first + i_tile_y * tiles.n_tiles_x + i_tile_x;
+}
+
+/* Coarsest level with at least one texel per screen pixel at given zoom (always full resolution for a cpu image) */
+int TiledImage::get_level(float zoom) const {
+  if (!m_pyramid || zoom >= 1.0f)
+    return 0;
+
+  return std::clamp((int) std::floor(std::log2(1.0f / zoom)), 0, (int) m_levels.size() - 1);
+}
+
+/**
+ * Decode visible tiles of pyramid not yet resident in parallel, then upload them
+ * (zlib decompression dominates first frames after opening or zooming)
+ */
+void TiledImage::decode_tiles(int level, int i_tile_x_min, int i_tile_y_min, int i_tile_x_max, int i_tile_y_max) {
+  std::vector<std::pair<int, int>> indices;
+  for (int i_tile_y = i_tile_y_min; i_tile_y <= i_tile_y_max; i_tile_y++) {
+    for (int i_tile_x = i_tile_x_min; i_tile_x <= i_tile_x_max; i_tile_x++) {
+      if (m_tiles.find(get_index(level, i_tile_x, i_tile_y)) == m_tiles.end())
+        indices.push_back({ i_tile_x, i_tile_y });
+    }
+  }
+
+  if (indices.empty())
+    return;
+
+  const PyramidFile::Level& tiles = m_levels[level];
+  std::vector<std::vector<unsigned char>> data(indices.size());
+  ImageUtils::parallel_for(indices.size(), 1, [&](int begin, int end) {
+    for (int i_index = begin; i_index < end; i_index++) {
+      auto [i_tile_x, i_tile_y] = indices[i_index];
+      int width = std::min(SIZE_TILE, tiles.width - i_tile_x * SIZE_TILE);
+      int height = std::min(SIZE_TILE, tiles.height - i_tile_y * SIZE_TILE);
+      data[i_index].resize((size_t) width * height * m_n_channels);
+      read_tile(level, i_tile_x, i_tile_y, data[i_index].data());
+    }
+  });
+
+  for (size_t i_index = 0; i_index < indices.size(); i_index++)
+    get_tile(level, indices[i_index].first, indices[i_index].second, data[i_index].data());
+}
+
+/**
+ * Pixels of pyramid's tile (painted copy of a full-resolution tile if any)
+ * Corrupted tiles are left black (thread-safe)
+ */
+void TiledImage::read_tile(int level, int i_tile_x, int i_tile_y, unsigned char* data) const {
+  auto it = level == 0 ? m_painted.find(get_index(0, i_tile_x, i_tile_y)) : m_painted.end();
+  if (it != m_painted.end()) {
+    std::memcpy(data, it->second.data(), it->second.size());
+    return;
+  }
+
+  const PyramidFile::Level& tiles = m_levels[level];
+  if (!m_pyramid->read_tile(level, i_tile_x, i_tile_y, data)) {
+    int width = std::min(SIZE_TILE, tiles.width - i_tile_x * SIZE_TILE);
+    int height = std::min(SIZE_TILE, tiles.height - i_tile_y * SIZE_TILE);
+    std::memset(data, 0, (size_t) width * height * m_n_channels);
+  }
+}
+
+/* Re-render effects on all tiles (e.g. after shader change) */
+void TiledImage::invalidate() {
+  m_revision++;
+}
+
+/* Render tile's shapes texture with current shader into its effects texture */
+void TiledImage::render_effects(Tile& tile, Renderer& renderer, Framebuffer& framebuffer) {
+  framebuffer.attach_texture(tile.texture_effects);
+  framebuffer.bind();
+  glViewport(0, 0, tile.texture_effects.width, tile.texture_effects.height);
+  framebuffer.clear({ 1.0f, 1.0f, 1.0f, 1.0f });
+  renderer.draw({ {"texture2d", tile.texture_shapes} });
+  framebuffer.unbind();
+
+  tile.revision_effects = m_revision;
+}
+
+/**
+ * Resident tile at given tile indices of a level (uploaded from cpu image or pyramid if needed)
+ * Marks tile as most recently used
+ * @param data_decoded Tile's pixels if already decoded (see `decode_tiles()`)
+ */
+TiledImage::Tile& TiledImage::get_tile(int level, int i_tile_x, int i_tile_y, const unsigned char* data_decoded) {
+  int i_tile = get_index(level, i_tile_x, i_tile_y);
+  auto it = m_tiles.find(i_tile);
+  if (it != m_tiles.end()) {
+    Tile& tile = it->second;
+    m_lru.splice(m_lru.begin(), m_lru, tile.it_lru);
+    tile.frame_used = m_frame;
+    return tile;
+  }
+
+  // copy tile's rows from cpu image or pyramid (tiles on right/bottom borders can be smaller)
+  // into upload ring when available (copied to texture by gpu), otherwise into a staging vector
+  const PyramidFile::Level& tiles = m_levels[level];
+  int x = i_tile_x * SIZE_TILE;
+  int y = i_tile_y * SIZE_TILE;
+  int width = std::min(SIZE_TILE, tiles.width - x);
+  int height = std::min(SIZE_TILE, tiles.height - y);
+  int n_channels = m_n_channels;
+  size_t n_bytes_row = (size_t) width * n_channels;
+
+  UploadRing::Region region;
+  bool is_ring = data_decoded == NULL && UploadRing::get().allocate(n_bytes_row * height, region);
+  std::vector<unsigned char> data(is_ring || data_decoded != NULL ? 0 : n_bytes_row * height);
+  unsigned char* data_tile = is_ring ? region.data : data.data();
+
+  if (data_decoded == NULL && m_image) {
+    for (int i_row = 0; i_row < height; i_row++) {
+      const unsigned char* row = m_image->data + ((size_t) (y + i_row) * m_image->width + x) * n_channels;
+      std::memcpy(data_tile + i_row * n_bytes_row, row, n_bytes_row);
+    }
+  } else if (data_decoded == NULL) {
+    read_tile(level, i_tile_x, i_tile_y, data_tile);
+  }
+
+  m_lru.push_front(i_tile);
+  Tile tile = {
+    x << level, y << level, level,
+    Texture2D(Image(width, height, n_channels, is_ring ? NULL : (data_decoded != NULL ? (unsigned char*) data_decoded : data.data()))),
+    Texture2D(Image(width, height, n_channels, NULL)),
+    0, false, m_frame, m_lru.begin()
+  };
+
+  PixelFormat::swizzle_gray(tile.texture_shapes);
+  PixelFormat::swizzle_gray(tile.texture_effects);
+
+  if (is_ring)
+    UploadRing::get().upload(region, tile.texture_shapes.id, 0, 0, width, height, tile.texture_shapes.format);
+
+  return m_tiles.emplace(i_tile, tile).first->second;
+}
+
+/* Free least-recently used tiles over budget (tiles visible in current frame are kept) */
+void TiledImage::evict() {
+  while ((int) m_tiles.size() > m_n_tiles_max) {
+    int i_tile = m_lru.back();
+    Tile& tile = m_tiles.at(i_tile);
+    if (tile.frame_used == m_frame)
+      break;
+
+    if (tile.is_painted)
+      write_back(tile);
+
+    tile.texture_shapes.free();
+    tile.texture_effects.free();
+    m_lru.pop_back();
+    m_tiles.erase(i_tile);
+  }
+}
+
+/* Copy painted tile from gpu back to cpu image or pyramid's painted tiles (so shapes drawn aren't lost on eviction) */
+void TiledImage::write_back(Tile& tile) {
+  const Texture2D& texture = tile.texture_shapes;
+  int n_channels = m_n_channels;
+  size_t n_bytes_row = (size_t) texture.width * n_channels;
+  std::vector<unsigned char> data(n_bytes_row * texture.height);
+
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glGetTexImage(GL_TEXTURE_2D, 0, texture.format, GL_UNSIGNED_BYTE, data.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  if (m_pyramid) {
+    m_painted[get_index(0, tile.x / SIZE_TILE, tile.y / SIZE_TILE)] = std::move(data);
+    tile.is_painted = false;
+    return;
+  }
+
+  for (int i_row = 0; i_row < texture.height; i_row++) {
+    unsigned char* row = m_image->data + ((size_t) (tile.y + i_row) * m_image->width + tile.x) * n_channels;
+    std::memcpy(row, data.data() + i_row * n_bytes_row, n_bytes_row);
+  }
+
+  tile.is_painted = false;
+}
+
+/**
+ * Run `draw` on every tile overlapping given region (in image pixels, origin at upper-left corner)
+ * Tile's shapes texture attached to fbo & viewport set to its size before drawing (queued shapes drawn per tile)
+ */
+void TiledImage::draw_region(float x_min, float y_min, float x_max, float y_max, ImageVG& image_vg, Framebuffer& framebuffer,
+                             const std::function<void(Tile&, float, float)>& draw) {
+  const PyramidFile::Level& tiles = m_levels[0];
+  int i_tile_x_min = std::clamp((int) std::floor(x_min / SIZE_TILE), 0, tiles.n_tiles_x - 1);
+  int i_tile_y_min = std::clamp((int) std::floor(y_min / SIZE_TILE), 0, tiles.n_tiles_y - 1);
+  int i_tile_x_max = std::clamp((int) std::floor(x_max / SIZE_TILE), 0, tiles.n_tiles_x - 1);
+  int i_tile_y_max = std::clamp((int) std::floor(y_max / SIZE_TILE), 0, tiles.n_tiles_y - 1);
+
+  for (int i_tile_y = i_tile_y_min; i_tile_y <= i_tile_y_max; i_tile_y++) {
+    for (int i_tile_x = i_tile_x_min; i_tile_x <= i_tile_x_max; i_tile_x++) {
+      Tile& tile = get_tile(0, i_tile_x, i_tile_y);
+      framebuffer.attach_texture(tile.texture_shapes);
+      glViewport(0, 0, tile.texture_shapes.width, tile.texture_shapes.height);
+
+      // nanovg's origin at lower-left corner of tile
+      float x_origin = tile.x;
+      float y_origin = m_height - (tile.y + tile.texture_shapes.height);
+      // shapes flushed while tile still attached
+      draw(tile, x_origin, y_origin);
+      image_vg.flush();
+
+      tile.is_painted = true;
+      tile.revision_effects = 0;
+      m_indices_painted.insert(get_index(0, i_tile_x, i_tile_y));
+    }
+  }
+}
+
+/**
+ * Draw circle on all tiles it covers
+ * @param x,y Center in nanovg coords of whole image (origin at lower-left corner)
+ */
+void TiledImage::draw_circle(ImageVG& image_vg, Framebuffer& framebuffer, float x, float y) {
+  float r = ImageVG::RADIUS_CIRCLE;
+  float y_top = m_height - y;
+
+  draw_region(x - r, y_top - r, x + r, y_top + r, image_vg, framebuffer, [&](Tile&, float x_origin, float y_origin) {
+    image_vg.draw_circle(framebuffer, x - x_origin, y - y_origin);
+  });
+}
+
+/**
+ * Draw line segment on all tiles its bounding box covers
+ * @param x1,y1,x2,y2 End points in nanovg coords of whole image (origin at lower-left corner)
+ */
+void TiledImage::draw_line(ImageVG& image_vg, Framebuffer& framebuffer, float x1, float y1, float x2, float y2) {
+  float r = ImageVG::WIDTH_STROKE / 2.0f;
+  float y1_top = m_height - y1;
+  float y2_top = m_height - y2;
+
+  draw_region(std::min(x1, x2) - r, std::min(y1_top, y2_top) - r, std::max(x1, x2) + r, std::max(y1_top, y2_top) + r,
+              image_vg, framebuffer, [&](Tile&, float x_origin, float y_origin) {
+    image_vg.draw_line(framebuffer, x1 - x_origin, y1 - y_origin, x2 - x_origin, y2 - y_origin);
+  });
+}
+
+/**
+ * Attach resident tile containing pixel (x, y) to fbo (used by tooltips)
+ * @param origin_tile Set to tile's upper-left corner in image pixels
+ * @return Attached texture or NULL if tile not resident
+ */
+const Texture2D* TiledImage::attach_tile(Framebuffer& framebuffer, bool has_effects, int x, int y, ImVec2& origin_tile) {
+  int i_tile_x = std::clamp(x / SIZE_TILE, 0, m_levels[0].n_tiles_x - 1);
+  int i_tile_y = std::clamp(y / SIZE_TILE, 0, m_levels[0].n_tiles_y - 1);
+  auto it = m_tiles.find(get_index(0, i_tile_x, i_tile_y));
+  if (it == m_tiles.end())
+    return NULL;
+
+  const Tile& tile = it->second;
+  const Texture2D& texture = has_effects ? tile.texture_effects : tile.texture_shapes;
+  framebuffer.attach_texture(texture);
+  origin_tile = ImVec2(tile.x, tile.y);
+
+  return &texture;
+}
+
+/**
+ * Full-resolution cpu image, including shapes painted on resident tiles
+ * Pyramid's full level decoded into a new pooled image (tiles in parallel)
+ * @return Image with NULL data if pyramid's image couldn't be allocated
+ */
+std::shared_ptr<Image> TiledImage::get_image() {
+  for (auto& pair : m_tiles) {
+    if (pair.second.is_painted)
+      write_back(pair.second);
+  }
+
+  if (m_image)
+    return m_image;
+
+  unsigned char* data = BufferPool::get().acquire((size_t) m_width * m_height * m_n_channels);
+  if (data == NULL)
+    return std::make_shared<Image>(m_width, m_height, m_n_channels, (unsigned char*) NULL);
+
+  const PyramidFile::Level& tiles = m_levels[0];
+  ImageUtils::parallel_for(tiles.n_tiles_x * tiles.n_tiles_y, 1, [&](int begin, int end) {
+    std::vector<unsigned char> data_tile((size_t) SIZE_TILE * SIZE_TILE * m_n_channels);
+
+    for (int i_tile = begin; i_tile < end; i_tile++) {
+      int x = i_tile % tiles.n_tiles_x * SIZE_TILE;
+      int y = i_tile / tiles.n_tiles_x * SIZE_TILE;
+      int width = std::min(SIZE_TILE, m_width - x);
+      int height = std::min(SIZE_TILE, m_height - y);
+      size_t n_bytes_row = (size_t) width * m_n_channels;
+      read_tile(0, x / SIZE_TILE, y / SIZE_TILE, data_tile.data());
+
+      for (int i_row = 0; i_row < height; i_row++) {
+        unsigned char* row = data + ((size_t) (y + i_row) * m_width + x) * m_n_channels;
+        std::memcpy(row, data_tile.data() + i_row * n_bytes_row, n_bytes_row);
+      }
+    }
+  });
+
+  return std::shared_ptr<Image>(new Image(m_width, m_height, m_n_channels, data), [](Image* image) {
+    ImageUtils::free(*image);
+    delete image;
+  });
+}
+
+int TiledImage::get_width() const {
+  return m_width;
+}
+
+int TiledImage::get_height() const {
+  return m_height;
+}
+
+int TiledImage::get_n_resident() const {
+  return m_tiles.size();
+}
+
+/* Free all resident tiles' textures */
+void TiledImage::free() {
+  for (auto& pair : m_tiles) {
+    pair.second.texture_shapes.free();
+    pair.second.texture_effects.free();
+  }
+
+  m_tiles.clear();
+  m_lru.clear();
+  m_painted.clear();
+  m_indices_painted.clear();
+
+  if (m_pyramid)
+    m_pyramid->free();
+}
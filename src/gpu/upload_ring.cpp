@@ -0,0 +1,113 @@
+#include <algorithm>
+
+#include "gpu/upload_ring.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * @param size Size of ring in bytes (uploads larger than this go through the caller's fallback path)
+ * Buffer & its mapping only created if buffer storage is supported (gl 4.4 or extension)
+ */
+UploadRing::UploadRing(size_t size):
+  m_pbo(0),
+  m_data(NULL),
+  m_size(size),
+  m_head(0)
+{
+  if (!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_buffer_storage)
+    return;
+
+  // coherent mapping: writes visible to gpu without explicit flush
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glGenBuffers(1, &m_pbo);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+  glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_size, NULL, flags);
+  m_data = (unsigned char*) glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_size, flags);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  if (m_data == NULL) {
+    glDeleteBuffers(1, &m_pbo);
+    m_pbo = 0;
+    return;
+  }
+
+  MemoryTracker::get().track(MemoryKind::BUFFER, m_pbo, "upload ring", "persistent pbo", m_size);
+}
+
+/* Ring shared by texture uploads (opened images, prefetches & tiles) */
+UploadRing& UploadRing::get() {
+  static UploadRing ring;
+  return ring;
+}
+
+bool UploadRing::is_supported() const {
+  return m_data != NULL;
+}
+
+/**
+ * Reserve `n_bytes` after last region (wrapping around), waiting for gpu to finish reading regions overlapping it
+ * @return false if unsupported or region larger than ring
+ */
+bool UploadRing::allocate(size_t n_bytes, Region& region) {
+  if (!is_supported() || n_bytes > m_size)
+    return false;
+
+  size_t begin = (m_head + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  if (begin + n_bytes > m_size)
+    begin = 0;
+  size_t end = begin + n_bytes;
+
+  // regions are released in order of upload, so older ones are waited for first
+  auto overlaps = [begin, end](const Fence& fence) { return fence.begin < end && begin < fence.end; };
+  while (std::any_of(m_fences.begin(), m_fences.end(), overlaps)) {
+    wait(m_fences.front());
+    m_fences.pop_front();
+  }
+
+  region = { m_data + begin, begin, n_bytes };
+  m_head = end;
+  return true;
+}
+
+/**
+ * Copy pixels written in `region` to given texture area (asynchronous, done by gpu)
+ * @param format Pixel format of `region` (e.g. `GL_RGBA`), rows tightly packed
+ * @param type Type of channels (e.g. `GL_UNSIGNED_SHORT` for 16-bit images)
+ */
+void UploadRing::upload(const Region& region, GLuint id_texture, int x, int y, int width, int height, GLenum format, GLenum type) {
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+  glBindTexture(GL_TEXTURE_2D, id_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // last arg is an offset into bound PBO
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, (void*) region.offset);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  m_fences.push_back({ region.offset, region.offset + region.size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+}
+
+/* Block until gpu has read fence's region (commands flushed so fence is eventually signaled) */
+void UploadRing::wait(Fence& fence) {
+  const GLuint64 TIMEOUT = 1000000000;
+  while (glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT) == GL_TIMEOUT_EXPIRED) {
+  }
+
+  glDeleteSync(fence.sync);
+}
+
+void UploadRing::free() {
+  for (Fence& fence : m_fences)
+    glDeleteSync(fence.sync);
+  m_fences.clear();
+
+  if (m_pbo == 0)
+    return;
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbo);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  MemoryTracker::get().untrack(MemoryKind::BUFFER, m_pbo);
+  glDeleteBuffers(1, &m_pbo);
+  m_pbo = 0;
+  m_data = NULL;
+}
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cmath>
+
+#include "zlib.h"
+
+#include "history/history.hpp"
+#include "gpu/pixel_format.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * @param budget_gpu Max. size in bytes of atlas pages holding tiles copies on gpu
+ * @param budget_cpu Max. size in bytes of compressed tiles spilled to cpu
+ */
+History::History(size_t budget_gpu, size_t budget_cpu):
+  m_budget_gpu(budget_gpu),
+  m_budget_cpu(budget_cpu),
+  m_id_texture(0),
+  m_format(GL_RGBA),
+  m_format_sized(GL_RGBA8),
+  m_type(GL_UNSIGNED_BYTE),
+  m_width(0),
+  m_height(0),
+  m_n_bytes_pixel(4),
+  m_size_cpu(0)
+{
+  // fbo used as read source of tiles copies
+  glGenFramebuffers(1, &m_fbo);
+}
+
+/**
+ * Forget history & record modifications of given texture (e.g. after opening a new image)
+ * @param depth Depth of texture's channels (tiles copied without loss of precision)
+ */
+void History::reset(const Texture2D& texture, Depth depth) {
+  m_entry.clear();
+  m_tiles_entry.clear();
+  m_undo.clear();
+  m_redo.clear();
+  m_size_cpu = 0;
+
+  // atlas pages have same format as recorded texture
+  delete_pages();
+  m_slots_free.clear();
+
+  m_id_texture = texture.id;
+  m_format = texture.format;
+  m_width = texture.width;
+  m_height = texture.height;
+  int n_channels = (texture.format == GL_RED) ? 1 : (texture.format == GL_RGB) ? 3 : 4;
+  m_format_sized = PixelFormat::get_format_sized(n_channels, depth);
+  m_type = PixelFormat::get_type(depth);
+  m_n_bytes_pixel = n_channels * PixelFormat::get_n_bytes_channel(depth);
+}
+
+/**
+ * Save tiles overlapping region about to be modified (in image pixels, origin at upper-left corner)
+ * Tiles already saved by current operation aren't copied again
+ */
+void History::touch(float x_min, float y_min, float x_max, float y_max) {
+  if (m_id_texture == 0)
+    return;
+
+  int n_tiles_x = (m_width + SIZE_TILE - 1) / SIZE_TILE;
+  int n_tiles_y = (m_height + SIZE_TILE - 1) / SIZE_TILE;
+  int i_tile_x_min = std::clamp((int) std::floor(x_min / SIZE_TILE), 0, n_tiles_x - 1);
+  int i_tile_y_min = std::clamp((int) std::floor(y_min / SIZE_TILE), 0, n_tiles_y - 1);
+  int i_tile_x_max = std::clamp((int) std::floor(x_max / SIZE_TILE), 0, n_tiles_x - 1);
+  int i_tile_y_max = std::clamp((int) std::floor(y_max / SIZE_TILE), 0, n_tiles_y - 1);
+
+  for (int i_tile_y = i_tile_y_min; i_tile_y <= i_tile_y_max; i_tile_y++) {
+    for (int i_tile_x = i_tile_x_min; i_tile_x <= i_tile_x_max; i_tile_x++) {
+      if (!m_tiles_entry.insert(i_tile_y * n_tiles_x + i_tile_x).second)
+        continue;
+
+      int x = i_tile_x * SIZE_TILE;
+      int y = i_tile_y * SIZE_TILE;
+      m_entry.push_back(capture(x, y, std::min(SIZE_TILE, m_width - x), std::min(SIZE_TILE, m_height - y)));
+    }
+  }
+}
+
+/* End current operation (e.g. on mouse release) & push it to undo stack */
+void History::commit() {
+  if (m_entry.empty())
+    return;
+
+  m_undo.push_back(std::move(m_entry));
+  m_entry.clear();
+  m_tiles_entry.clear();
+
+  // a new operation invalidates undone ones
+  clear(m_redo);
+  enforce_budget_cpu();
+}
+
+/**
+ * Restore tiles saved by last operation (current content saved for redo)
+ * @return false if nothing to undo
+ */
+bool History::undo() {
+  commit();
+  if (m_undo.empty())
+    return false;
+
+  Entry entry = std::move(m_undo.back());
+  m_undo.pop_back();
+
+  Entry entry_redo;
+  for (Snapshot& snapshot : entry) {
+    entry_redo.push_back(capture(snapshot.x, snapshot.y, snapshot.width, snapshot.height));
+    restore(snapshot);
+  }
+
+  release(entry);
+  m_redo.push_back(std::move(entry_redo));
+  enforce_budget_cpu();
+
+  return true;
+}
+
+/**
+ * Re-apply last undone operation
+ * @return false if nothing to redo
+ */
+bool History::redo() {
+  if (m_redo.empty())
+    return false;
+
+  Entry entry = std::move(m_redo.back());
+  m_redo.pop_back();
+
+  Entry entry_undo;
+  for (Snapshot& snapshot : entry) {
+    entry_undo.push_back(capture(snapshot.x, snapshot.y, snapshot.width, snapshot.height));
+    restore(snapshot);
+  }
+
+  release(entry);
+  m_undo.push_back(std::move(entry_undo));
+  enforce_budget_cpu();
+
+  return true;
+}
+
+/**
+ * Move all tiles to cpu & free atlas pages (e.g. document sent to background to free vram)
+ * Current operation committed first, oldest operations forgotten if cpu budget is exceeded
+ */
+void History::spill_all() {
+  commit();
+  while (spill()) {}
+
+  delete_pages();
+  m_slots_free.clear();
+  enforce_budget_cpu();
+}
+
+/**
+ * Record modifications of another texture of same size & format holding the same pixels
+ * (e.g. texture re-created when document is brought back to foreground), operations recorded so far kept
+ */
+void History::rebind(const Texture2D& texture) {
+  m_id_texture = texture.id;
+}
+
+/* Copy texture region into an atlas slot on gpu (or compressed on cpu if gpu budget exhausted) */
+History::Snapshot History::capture(int x, int y, int width, int height) {
+  Snapshot snapshot = { x, y, width, height, allocate_slot(), {} };
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+  glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_id_texture, 0);
+
+  if (snapshot.slot >= 0) {
+    // copy from read fbo into atlas page (stays on gpu)
+    int i_tile = snapshot.slot % (N_TILES_PAGE * N_TILES_PAGE);
+    glBindTexture(GL_TEXTURE_2D, m_pages[snapshot.slot / (N_TILES_PAGE * N_TILES_PAGE)]);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, (i_tile % N_TILES_PAGE) * SIZE_TILE, (i_tile / N_TILES_PAGE) * SIZE_TILE, x, y, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  } else {
+    std::vector<unsigned char> data((size_t) width * height * m_n_bytes_pixel);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, width, height, m_format, m_type, data.data());
+
+    uLongf size = compressBound(data.size());
+    snapshot.data.resize(size);
+    compress2(snapshot.data.data(), &size, data.data(), data.size(), Z_BEST_SPEED);
+    snapshot.data.resize(size);
+    m_size_cpu += size;
+  }
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  return snapshot;
+}
+
+/* Copy tile back into recorded texture */
+void History::restore(const Snapshot& snapshot) {
+  if (snapshot.slot >= 0) {
+    int i_tile = snapshot.slot % (N_TILES_PAGE * N_TILES_PAGE);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pages[snapshot.slot / (N_TILES_PAGE * N_TILES_PAGE)], 0);
+    glBindTexture(GL_TEXTURE_2D, m_id_texture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, snapshot.x, snapshot.y, (i_tile % N_TILES_PAGE) * SIZE_TILE, (i_tile / N_TILES_PAGE) * SIZE_TILE,
+                        snapshot.width, snapshot.height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  } else {
+    std::vector<unsigned char> data((size_t) snapshot.width * snapshot.height * m_n_bytes_pixel);
+    uLongf size = data.size();
+    uncompress(data.data(), &size, snapshot.data.data(), snapshot.data.size());
+
+    glBindTexture(GL_TEXTURE_2D, m_id_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, snapshot.x, snapshot.y, snapshot.width, snapshot.height, m_format, m_type, data.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+}
+
+/* Give back atlas slots & cpu memory held by an operation */
+void History::release(Entry& entry) {
+  for (Snapshot& snapshot : entry) {
+    if (snapshot.slot >= 0)
+      m_slots_free.push_back(snapshot.slot);
+    else
+      m_size_cpu -= snapshot.data.size();
+  }
+
+  entry.clear();
+}
+
+void History::clear(std::deque<Entry>& entries) {
+  for (Entry& entry : entries)
+    release(entry);
+
+  entries.clear();
+}
+
+/**
+ * Free slot in atlas, new page allocated if within gpu budget, otherwise oldest tile spilled to cpu
+ * @return -1 if no slot could be freed
+ */
+int History::allocate_slot() {
+  size_t size_page = (size_t) SIZE_PAGE * SIZE_PAGE * m_n_bytes_pixel;
+
+  if (m_slots_free.empty() && (m_pages.size() + 1) * size_page <= m_budget_gpu) {
+    GLuint page;
+    glGenTextures(1, &page);
+    glBindTexture(GL_TEXTURE_2D, page);
+    glTexImage2D(GL_TEXTURE_2D, 0, m_format_sized, SIZE_PAGE, SIZE_PAGE, 0, m_format, m_type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // slots pushed in reverse so first tiles of page are used first
+    int i_page = m_pages.size();
+    m_pages.push_back(page);
+    MemoryTracker::get().track(MemoryKind::TEXTURE, page, "undo history", "atlas page", size_page);
+    for (int i_tile = N_TILES_PAGE * N_TILES_PAGE - 1; i_tile >= 0; i_tile--)
+      m_slots_free.push_back(i_page * N_TILES_PAGE * N_TILES_PAGE + i_tile);
+  }
+
+  if (m_slots_free.empty() && !spill())
+    return -1;
+
+  int slot = m_slots_free.back();
+  m_slots_free.pop_back();
+  return slot;
+}
+
+/**
+ * Move one tile of oldest operation still on gpu to cpu
+ * @return false if no tile left on gpu (except in current operation)
+ */
+bool History::spill() {
+  for (std::deque<Entry>* entries : { &m_undo, &m_redo }) {
+    for (Entry& entry : *entries) {
+      for (Snapshot& snapshot : entry) {
+        if (snapshot.slot >= 0) {
+          to_cpu(snapshot);
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+/* Read tile from its atlas slot & compress it on cpu */
+void History::to_cpu(Snapshot& snapshot) {
+  int i_tile = snapshot.slot % (N_TILES_PAGE * N_TILES_PAGE);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+  glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pages[snapshot.slot / (N_TILES_PAGE * N_TILES_PAGE)], 0);
+
+  std::vector<unsigned char> data((size_t) snapshot.width * snapshot.height * m_n_bytes_pixel);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels((i_tile % N_TILES_PAGE) * SIZE_TILE, (i_tile / N_TILES_PAGE) * SIZE_TILE, snapshot.width, snapshot.height,
+               m_format, m_type, data.data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  uLongf size = compressBound(data.size());
+  snapshot.data.resize(size);
+  compress2(snapshot.data.data(), &size, data.data(), data.size(), Z_BEST_SPEED);
+  snapshot.data.resize(size);
+  m_size_cpu += size;
+
+  m_slots_free.push_back(snapshot.slot);
+  snapshot.slot = -1;
+}
+
+/* Forget oldest operations while compressed tiles exceed cpu budget */
+void History::enforce_budget_cpu() {
+  while (m_size_cpu > m_budget_cpu && !m_undo.empty()) {
+    release(m_undo.front());
+    m_undo.pop_front();
+  }
+
+  MemoryTracker::get().track(MemoryKind::CPU, (uintptr_t) this, "undo history", "compressed tiles", m_size_cpu);
+}
+
+size_t History::get_n_undo() const {
+  return m_undo.size() + (m_entry.empty() ? 0 : 1);
+}
+
+size_t History::get_n_redo() const {
+  return m_redo.size();
+}
+
+/* Size in bytes of atlas pages allocated on gpu */
+size_t History::get_size_gpu() const {
+  return m_pages.size() * SIZE_PAGE * SIZE_PAGE * m_n_bytes_pixel;
+}
+
+/* Size in bytes of compressed tiles on cpu */
+size_t History::get_size_cpu() const {
+  return m_size_cpu;
+}
+
+void History::free() {
+  delete_pages();
+  glDeleteFramebuffers(1, &m_fbo);
+  MemoryTracker::get().untrack(MemoryKind::CPU, (uintptr_t) this);
+}
+
+/**
+ * Budgets read by caller from `MemoryTracker` (e.g. changed in memory panel), applied from next operation on
+ * (over-budget pages aren't freed, but no new ones are allocated)
+ */
+void History::set_budgets(size_t budget_gpu, size_t budget_cpu) {
+  m_budget_gpu = budget_gpu;
+  m_budget_cpu = budget_cpu;
+  enforce_budget_cpu();
+}
+
+/* Free atlas pages (slots of their tiles must not be used anymore) */
+void History::delete_pages() {
+  for (GLuint page : m_pages)
+    MemoryTracker::get().untrack(MemoryKind::TEXTURE, page);
+
+  glDeleteTextures(m_pages.size(), m_pages.data());
+  m_pages.clear();
+}
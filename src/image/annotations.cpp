@@ -0,0 +1,435 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+
+#include "image/annotations.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+const Annotations::Style Annotations::STYLE_CIRCLE = { 1.0f, 1.0f, 1.0f, 1.0f, StrokeRasterizer::RADIUS_CIRCLE };
+const Annotations::Style Annotations::STYLE_LINE = { 0.0f, 0.0f, 0.0f, 1.0f, StrokeRasterizer::WIDTH_STROKE };
+
+namespace {
+  /* fields of a shape read from either format, by key (e.g. "x1", "radius" or "color") */
+  struct Fields {
+    std::unordered_map<std::string, double> numbers;
+    std::unordered_map<std::string, std::string> strings;
+  };
+
+  /**
+   * Minimal reader of the json shapes files need (arrays of flat objects, values of nested ones skipped)
+   * Unicode escapes replaced by '?' (only strings read are types & colors)
+   */
+  class JsonReader {
+  public:
+    JsonReader(const std::string& text): m_text(text), m_i(0) {}
+
+    char peek() {
+      skip_spaces();
+      return m_i < m_text.size() ? m_text[m_i] : '\0';
+    }
+
+    bool consume(char c) {
+      if (peek() != c)
+        return false;
+
+      m_i++;
+      return true;
+    }
+
+    bool read_string(std::string& value) {
+      if (!consume('"'))
+        return false;
+
+      value.clear();
+      while (m_i < m_text.size() && m_text[m_i] != '"') {
+        char c = m_text[m_i++];
+        if (c == '\\' && m_i < m_text.size()) {
+          char escaped = m_text[m_i++];
+          c = (escaped == 'n') ? '\n' : (escaped == 't') ? '\t' : (escaped == 'u') ? '?' : escaped;
+          if (escaped == 'u')
+            m_i = std::min(m_i + 4, m_text.size());
+        }
+        value += c;
+      }
+
+      return consume('"');
+    }
+
+    bool read_number(double& value) {
+      skip_spaces();
+      const char* start = m_text.c_str() + m_i;
+      char* end;
+      value = std::strtod(start, &end);
+      m_i += end - start;
+      return end != start;
+    }
+
+    /* any value (nested arrays & objects included) */
+    bool skip_value() {
+      std::string string;
+      double number;
+      char c = peek();
+      if (c == '"')
+        return read_string(string);
+      if (c == '-' || std::isdigit((unsigned char) c))
+        return read_number(number);
+
+      if (c == '[' || c == '{') {
+        char c_close = (c == '[') ? ']' : '}';
+        m_i++;
+        if (consume(c_close))
+          return true;
+
+        do {
+          if (c == '{' && !(read_string(string) && consume(':')))
+            return false;
+          if (!skip_value())
+            return false;
+        } while (consume(','));
+
+        return consume(c_close);
+      }
+
+      // literals (true, false, null)
+      size_t i_start = m_i;
+      while (m_i < m_text.size() && std::isalpha((unsigned char) m_text[m_i]))
+        m_i++;
+      return m_i > i_start;
+    }
+
+    size_t get_offset() const {
+      return m_i;
+    }
+
+  private:
+    const std::string& m_text;
+    size_t m_i;
+
+    void skip_spaces() {
+      while (m_i < m_text.size() && std::isspace((unsigned char) m_text[m_i]))
+        m_i++;
+    }
+  };
+
+  /* field without surrounding spaces */
+  std::string trim(const std::string& text) {
+    size_t i_start = text.find_first_not_of(" \t");
+    if (i_start == std::string::npos)
+      return "";
+
+    return text.substr(i_start, text.find_last_not_of(" \t") - i_start + 1);
+  }
+
+  /* number of whole field (e.g. "12.5", not "12.5px") */
+  bool parse_number(const std::string& text, double& value) {
+    char* end;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+  }
+
+  /* shape described by its fields added with its style (defaults of its type for missing size & color) */
+  bool add_shape(Annotations& annotations, const Fields& fields, std::string& error) {
+    auto it_type = fields.strings.find("type");
+    std::string type = (it_type != fields.strings.end()) ? it_type->second : "";
+    bool is_circle = type == "circle";
+    if (!is_circle && type != "line") {
+      error = "unknown type \"" + type + "\" (circle or line expected)";
+      return false;
+    }
+
+    // nan & infinite values (e.g. `1e999`, or beyond range of floats) would reach rasterizer's bounds
+    for (const auto& pair : fields.numbers) {
+      if (!std::isfinite((float) pair.second)) {
+        error = "non-finite " + pair.first + " of " + type;
+        return false;
+      }
+    }
+
+    Annotations::Style style = is_circle ? Annotations::STYLE_CIRCLE : Annotations::STYLE_LINE;
+    auto it_size = fields.numbers.find(is_circle ? "radius" : "width");
+    if (it_size != fields.numbers.end())
+      style.size = (float) it_size->second;
+
+    auto it_color = fields.strings.find("color");
+    if (it_color != fields.strings.end() && !Annotations::parse_color(it_color->second, style)) {
+      error = "invalid color \"" + it_color->second + "\"";
+      return false;
+    }
+
+    const std::vector<std::string> keys = is_circle ? std::vector<std::string>{ "x", "y" } :
+                                                      std::vector<std::string>{ "x1", "y1", "x2", "y2" };
+    float positions[4] = {};
+    for (size_t i_key = 0; i_key < keys.size(); i_key++) {
+      auto it_position = fields.numbers.find(keys[i_key]);
+      if (it_position == fields.numbers.end()) {
+        error = "missing " + keys[i_key] + " of " + type;
+        return false;
+      }
+      positions[i_key] = (float) it_position->second;
+    }
+
+    if (is_circle)
+      annotations.add_circle(positions[0], positions[1], style);
+    else
+      annotations.add_line(positions[0], positions[1], positions[2], positions[3], style);
+
+    return true;
+  }
+}
+
+Annotations::Annotations():
+  m_batches(),
+  m_i_batches(),
+  m_n_shapes(0),
+  m_revision(0)
+{
+}
+
+void Annotations::add_circle(float x, float y, const Style& style) {
+  add(Type::CIRCLE, { x, y, 0.0f, 0.0f }, style);
+}
+
+void Annotations::add_line(float x1, float y1, float x2, float y2, const Style& style) {
+  add(Type::LINE, { x1, y1, x2, y2 }, style);
+}
+
+/* Shape appended to batch of its type & style (created on its first shape) */
+void Annotations::add(Type type, const Shape& shape, const Style& style) {
+  std::array<float, 6> key = { (float) type, style.r, style.g, style.b, style.a, style.size };
+  auto it = m_i_batches.find(key);
+  if (it == m_i_batches.end()) {
+    it = m_i_batches.insert({ key, m_batches.size() }).first;
+    m_batches.push_back({ type, style, {} });
+  }
+
+  m_batches[it->second].shapes.push_back(shape);
+  m_n_shapes++;
+  m_revision++;
+}
+
+/**
+ * Replace shapes by those of a .json or .csv file (see format in header)
+ * @param error Reason of failure, with line (csv) or shape (json) at fault
+ * @return false if file can't be read or is malformed (shapes left unchanged)
+ */
+bool Annotations::load(const std::string& path, std::string& error) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "can't open " + path;
+    return false;
+  }
+
+  std::stringstream stream;
+  stream << file.rdbuf();
+  std::string text = stream.str();
+
+  std::string extension = path.substr(std::min(path.find_last_of('.'), path.size()));
+  std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+  if (extension != ".csv" && extension != ".json") {
+    error = "unknown format of " + path + " (.json or .csv expected)";
+    return false;
+  }
+
+  Annotations annotations;
+  bool is_loaded = (extension == ".csv") ? annotations.load_csv(text, error) : annotations.load_json(text, error);
+  if (!is_loaded)
+    return false;
+
+  unsigned int revision = m_revision;
+  *this = std::move(annotations);
+  m_revision = revision + 1;
+  return true;
+}
+
+bool Annotations::load_csv(const std::string& text, std::string& error) {
+  std::stringstream stream(text);
+  std::string line;
+  for (int i_line = 1; std::getline(stream, line); i_line++) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    if (line.empty() || line[0] == '#' || (i_line == 1 && line.rfind("type", 0) == 0))
+      continue;
+
+    std::vector<std::string> values;
+    std::stringstream stream_line(line);
+    std::string value;
+    while (std::getline(stream_line, value, ','))
+      values.push_back(trim(value));
+
+    // columns named as keys of json objects
+    Fields fields;
+    fields.strings["type"] = values[0];
+    const std::vector<std::string> keys = (values[0] == "circle") ? std::vector<std::string>{ "x", "y", "radius", "color" } :
+                                                                    std::vector<std::string>{ "x1", "y1", "x2", "y2", "width", "color" };
+    for (size_t i_value = 1; i_value < values.size() && i_value <= keys.size(); i_value++) {
+      const std::string& key = keys[i_value - 1];
+      double number;
+      if (values[i_value].empty())
+        continue;
+      if (key == "color")
+        fields.strings[key] = values[i_value];
+      else if (parse_number(values[i_value], number))
+        fields.numbers[key] = number;
+      else {
+        error = "line " + std::to_string(i_line) + ": invalid " + key + " \"" + values[i_value] + "\"";
+        return false;
+      }
+    }
+
+    if (!add_shape(*this, fields, error)) {
+      error = "line " + std::to_string(i_line) + ": " + error;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Annotations::load_json(const std::string& text, std::string& error) {
+  JsonReader reader(text);
+  auto fail = [&](const std::string& message) {
+    error = message + " at offset " + std::to_string(reader.get_offset());
+    return false;
+  };
+
+  // nothing but spaces after shapes array (& rest of object wrapping it)
+  std::string key;
+  bool is_wrapped = false;
+  auto finish = [&]() {
+    while (is_wrapped && reader.consume(',')) {
+      if (!reader.read_string(key) || !reader.consume(':') || !reader.skip_value())
+        return fail("key expected");
+    }
+    if (is_wrapped && !reader.consume('}'))
+      return fail("'}' expected");
+    if (reader.peek() != '\0')
+      return fail("unexpected content after shapes");
+
+    return true;
+  };
+
+  // shapes array may be wrapped in an object (other keys skipped)
+  if (reader.consume('{')) {
+    is_wrapped = true;
+    while (true) {
+      if (!reader.read_string(key) || !reader.consume(':'))
+        return fail("key expected");
+      if (key == "shapes")
+        break;
+      if (!reader.skip_value() || !reader.consume(','))
+        return fail("\"shapes\" array expected");
+    }
+  }
+
+  if (!reader.consume('['))
+    return fail("array of shapes expected");
+  if (reader.consume(']'))
+    return finish();
+
+  size_t i_shape = 0;
+  do {
+    if (!reader.consume('{'))
+      return fail("object expected");
+
+    Fields fields;
+    if (!reader.consume('}')) {
+      do {
+        // strings & numbers kept, other values skipped
+        if (!reader.read_string(key) || !reader.consume(':'))
+          return fail("key expected");
+
+        char c = reader.peek();
+        bool is_read = (c == '"') ? reader.read_string(fields.strings[key]) :
+                       (c == '-' || std::isdigit((unsigned char) c)) ? reader.read_number(fields.numbers[key]) :
+                       reader.skip_value();
+        if (!is_read)
+          return fail("invalid value of \"" + key + "\"");
+      } while (reader.consume(','));
+
+      if (!reader.consume('}'))
+        return fail("'}' expected");
+    }
+
+    if (!add_shape(*this, fields, error)) {
+      error = "shape " + std::to_string(i_shape) + ": " + error;
+      return false;
+    }
+    i_shape++;
+  } while (reader.consume(','));
+
+  if (!reader.consume(']'))
+    return fail("']' expected");
+
+  return finish();
+}
+
+/**
+ * Color given as `#rrggbb` or `#rrggbbaa` ('#' optional) set in style
+ * @return false if color isn't made of 6 or 8 hex digits (style left unchanged)
+ */
+bool Annotations::parse_color(const std::string& text, Style& style) {
+  std::string digits = (!text.empty() && text[0] == '#') ? text.substr(1) : text;
+  bool is_hex = std::all_of(digits.begin(), digits.end(), [](char c) { return std::isxdigit((unsigned char) c); });
+  if (!is_hex || (digits.size() != 6 && digits.size() != 8))
+    return false;
+
+  unsigned long rgba = std::strtoul(digits.c_str(), NULL, 16);
+  if (digits.size() == 6)
+    rgba = (rgba << 8) | 0xff;
+
+  style.r = ((rgba >> 24) & 0xff) / 255.0f;
+  style.g = ((rgba >> 16) & 0xff) / 255.0f;
+  style.b = ((rgba >> 8) & 0xff) / 255.0f;
+  style.a = (rgba & 0xff) / 255.0f;
+  return true;
+}
+
+void Annotations::clear() {
+  m_batches.clear();
+  m_i_batches.clear();
+  m_n_shapes = 0;
+  m_revision++;
+}
+
+bool Annotations::empty() const {
+  return m_n_shapes == 0;
+}
+
+const std::vector<Annotations::Batch>& Annotations::get_batches() const {
+  return m_batches;
+}
+
+size_t Annotations::get_n_shapes() const {
+  return m_n_shapes;
+}
+
+unsigned int Annotations::get_revision() const {
+  return m_revision;
+}
+
+/**
+ * Draw shapes on cpu pixels (e.g. burnt into outputs of batch), queued batch after batch then flushed at once
+ * Rasterizer left with colors & sizes of last batches
+ */
+void Annotations::rasterize(StrokeRasterizer& rasterizer, const ImageView& view) const {
+  for (const Batch& batch : m_batches) {
+    StrokeRasterizer::Rgba color = { batch.style.r, batch.style.g, batch.style.b, batch.style.a };
+    if (batch.type == Type::CIRCLE) {
+      rasterizer.color_fill = color;
+      rasterizer.radius_circle = batch.style.size;
+      for (const Shape& shape : batch.shapes)
+        rasterizer.draw_circle(view, shape.x1, view.height - shape.y1);
+    } else {
+      rasterizer.color_stroke = color;
+      rasterizer.width_stroke = batch.style.size;
+      for (const Shape& shape : batch.shapes)
+        rasterizer.draw_line(view, shape.x1, view.height - shape.y1, shape.x2, view.height - shape.y2);
+    }
+  }
+
+  rasterizer.flush();
+}
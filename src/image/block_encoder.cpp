@@ -0,0 +1,274 @@
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#include "image/block_encoder.hpp"
+
+namespace {
+  const char MAGIC[8] = { 'B', 'L', 'K', 'S', '0', '0', '0', '1' };
+
+  /* rgba texels of 4x4 block at (x, y), pixels outside image replaced by nearest border one */
+  void get_texels(const Image& image, int x, int y, unsigned char texels[16][4]) {
+    int n_channels = image.n_channels;
+    for (int i_texel = 0; i_texel < 16; i_texel++) {
+      int x_texel = std::min(x + i_texel % 4, image.width - 1);
+      int y_texel = std::min(y + i_texel / 4, image.height - 1);
+      const unsigned char* pixel = image.data + ((size_t) y_texel * image.width + x_texel) * n_channels;
+
+      // gray (& alpha) replicated on rgb
+      bool is_gray = n_channels <= 2;
+      texels[i_texel][0] = pixel[0];
+      texels[i_texel][1] = is_gray ? pixel[0] : pixel[1];
+      texels[i_texel][2] = is_gray ? pixel[0] : pixel[2];
+      texels[i_texel][3] = (n_channels == 2) ? pixel[1] : (n_channels == 4) ? pixel[3] : 255;
+    }
+  }
+
+  uint16_t to_565(const int color[3]) {
+    return ((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255);
+  }
+
+  void from_565(uint16_t value, int color[3]) {
+    int r = value >> 11, g = (value >> 5) & 63, b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+  }
+
+  /* bc1 color block (8 bytes): two 565 endpoints & 2-bit index per texel into 4 colors interpolated between them */
+  void encode_color(const unsigned char texels[16][4], unsigned char* block) {
+    int color_min[3] = { 255, 255, 255 };
+    int color_max[3] = { 0, 0, 0 };
+    int mean[3] = { 0, 0, 0 };
+    for (int i_texel = 0; i_texel < 16; i_texel++) {
+      for (int i_channel = 0; i_channel < 3; i_channel++) {
+        color_min[i_channel] = std::min(color_min[i_channel], (int) texels[i_texel][i_channel]);
+        color_max[i_channel] = std::max(color_max[i_channel], (int) texels[i_texel][i_channel]);
+        mean[i_channel] += texels[i_texel][i_channel];
+      }
+    }
+
+    // endpoints moved inside bounding box (less error on interpolated colors)
+    for (int i_channel = 0; i_channel < 3; i_channel++) {
+      int inset = (color_max[i_channel] - color_min[i_channel]) >> 4;
+      color_min[i_channel] += inset;
+      color_max[i_channel] -= inset;
+      mean[i_channel] /= 16;
+    }
+
+    // diagonal of bounding box along which colors vary (red & blue flipped if they decrease with green)
+    int covariance_rg = 0, covariance_bg = 0;
+    for (int i_texel = 0; i_texel < 16; i_texel++) {
+      int dg = texels[i_texel][1] - mean[1];
+      covariance_rg += (texels[i_texel][0] - mean[0]) * dg;
+      covariance_bg += (texels[i_texel][2] - mean[2]) * dg;
+    }
+    if (covariance_rg < 0)
+      std::swap(color_min[0], color_max[0]);
+    if (covariance_bg < 0)
+      std::swap(color_min[2], color_max[2]);
+
+    // endpoint 0 > endpoint 1 selects 4-color mode (equal endpoints: all texels use endpoint 0)
+    uint16_t endpoint0 = to_565(color_max);
+    uint16_t endpoint1 = to_565(color_min);
+    if (endpoint0 < endpoint1)
+      std::swap(endpoint0, endpoint1);
+
+    int palette[4][3];
+    from_565(endpoint0, palette[0]);
+    from_565(endpoint1, palette[1]);
+    for (int i_channel = 0; i_channel < 3; i_channel++) {
+      palette[2][i_channel] = (2 * palette[0][i_channel] + palette[1][i_channel]) / 3;
+      palette[3][i_channel] = (palette[0][i_channel] + 2 * palette[1][i_channel]) / 3;
+    }
+
+    uint32_t indices = 0;
+    for (int i_texel = 0; endpoint0 != endpoint1 && i_texel < 16; i_texel++) {
+      int i_best = 0, distance_best = INT32_MAX;
+      for (int i_color = 0; i_color < 4; i_color++) {
+        int distance = 0;
+        for (int i_channel = 0; i_channel < 3; i_channel++) {
+          int d = texels[i_texel][i_channel] - palette[i_color][i_channel];
+          distance += d * d;
+        }
+
+        if (distance < distance_best) {
+          distance_best = distance;
+          i_best = i_color;
+        }
+      }
+
+      indices |= (uint32_t) i_best << (2 * i_texel);
+    }
+
+    block[0] = endpoint0 & 0xFF;
+    block[1] = endpoint0 >> 8;
+    block[2] = endpoint1 & 0xFF;
+    block[3] = endpoint1 >> 8;
+    for (int i_byte = 0; i_byte < 4; i_byte++)
+      block[4 + i_byte] = (indices >> (8 * i_byte)) & 0xFF;
+  }
+
+  /* bc4 block (8 bytes): min & max values & 3-bit index per texel into 8 values interpolated between them */
+  void encode_channel(const unsigned char values[16], unsigned char* block) {
+    int value_min = *std::min_element(values, values + 16);
+    int value_max = *std::max_element(values, values + 16);
+
+    // max first selects 8-value mode (indices 2-7 interpolated from max to min)
+    int palette[8] = { value_max, value_min };
+    for (int i_value = 1; i_value <= 6; i_value++)
+      palette[i_value + 1] = ((7 - i_value) * value_max + i_value * value_min + 3) / 7;
+
+    uint64_t indices = 0;
+    for (int i_texel = 0; value_max != value_min && i_texel < 16; i_texel++) {
+      int i_best = 0;
+      for (int i_value = 1; i_value < 8; i_value++) {
+        if (std::abs(values[i_texel] - palette[i_value]) < std::abs(values[i_texel] - palette[i_best]))
+          i_best = i_value;
+      }
+
+      indices |= (uint64_t) i_best << (3 * i_texel);
+    }
+
+    block[0] = value_max;
+    block[1] = value_min;
+    for (int i_byte = 0; i_byte < 6; i_byte++)
+      block[2 + i_byte] = (indices >> (8 * i_byte)) & 0xFF;
+  }
+
+  /* `$XDG_CACHE_HOME` (or `~/.cache`) subfolder, local folder if neither is set (same root as fonts cache) */
+  std::filesystem::path get_dir_cache() {
+    const char* dir_xdg = std::getenv("XDG_CACHE_HOME");
+    const char* dir_home = std::getenv("HOME");
+    std::filesystem::path dir = (dir_xdg && *dir_xdg) ? std::filesystem::path(dir_xdg) :
+                                (dir_home && *dir_home) ? std::filesystem::path(dir_home) / ".cache" : ".cache";
+
+    return dir / "imgui-example" / "blocks";
+  }
+}
+
+/* Block format for given # of channels (alpha kept by bc3, gray stored once by bc4) */
+BlockEncoder::Codec BlockEncoder::get_codec(int n_channels) {
+  return (n_channels == 1) ? Codec::BC4 : (n_channels == 3) ? Codec::BC1 : Codec::BC3;
+}
+
+/* Compress 8-bit image (any # of channels) into blocks of the format given by `get_codec()` */
+void BlockEncoder::encode(const Image& image, Blocks& blocks) {
+  Codec codec = get_codec(image.n_channels);
+  int n_blocks_x = (image.width + 3) / 4;
+  int n_blocks_y = (image.height + 3) / 4;
+  size_t n_bytes_block = (codec == Codec::BC3) ? 16 : 8;
+
+  blocks.width = image.width;
+  blocks.height = image.height;
+  blocks.n_channels = image.n_channels;
+  blocks.codec = codec;
+  blocks.data.resize((size_t) n_blocks_x * n_blocks_y * n_bytes_block);
+
+  unsigned char texels[16][4];
+  unsigned char values[16];
+  unsigned char* block = blocks.data.data();
+  for (int i_block_y = 0; i_block_y < n_blocks_y; i_block_y++) {
+    for (int i_block_x = 0; i_block_x < n_blocks_x; i_block_x++) {
+      get_texels(image, 4 * i_block_x, 4 * i_block_y, texels);
+
+      // bc3 = alpha block (encoded like bc4) followed by color block
+      if (codec != Codec::BC1) {
+        int i_channel = (codec == Codec::BC4) ? 0 : 3;
+        for (int i_texel = 0; i_texel < 16; i_texel++)
+          values[i_texel] = texels[i_texel][i_channel];
+        encode_channel(values, block);
+        block += 8;
+      }
+
+      if (codec != Codec::BC4) {
+        encode_color(texels, block);
+        block += 8;
+      }
+    }
+  }
+}
+
+/**
+ * Cache file of image's blocks (empty if image can't be stat'ed)
+ * Keyed by absolute path, size & modification time, so an overwritten image is encoded again
+ */
+std::string BlockEncoder::get_path_cache(const std::string& path_image) {
+  std::error_code error;
+  std::filesystem::path path = std::filesystem::absolute(path_image, error);
+  uintmax_t size = std::filesystem::file_size(path, error);
+  auto time_modified = std::filesystem::last_write_time(path, error);
+  if (error)
+    return "";
+
+  std::stringstream stream;
+  stream << std::string(MAGIC, sizeof(MAGIC)) << '|' << path.string() << '|' << size << '|'
+         << time_modified.time_since_epoch().count();
+
+  std::stringstream name;
+  name << std::hex << std::hash<std::string>()(stream.str()) << ".blocks";
+  std::filesystem::create_directories(get_dir_cache(), error);
+  return (get_dir_cache() / name.str()).string();
+}
+
+/**
+ * Header checked against what encoder writes & against size of file before blocks are allocated
+ * @return false if file is missing, truncated or its header is inconsistent (e.g. corrupted cache)
+ */
+bool BlockEncoder::read(const std::string& path, Blocks& blocks) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(MAGIC)];
+  int codec;
+  uint64_t n_bytes;
+  if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+    return false;
+
+  file.read(reinterpret_cast<char*>(&blocks.width), sizeof(int));
+  file.read(reinterpret_cast<char*>(&blocks.height), sizeof(int));
+  file.read(reinterpret_cast<char*>(&blocks.n_channels), sizeof(int));
+  file.read(reinterpret_cast<char*>(&codec), sizeof(int));
+  file.read(reinterpret_cast<char*>(&n_bytes), sizeof(uint64_t));
+  if (!file || blocks.width <= 0 || blocks.height <= 0 || blocks.n_channels < 1 || blocks.n_channels > 4 ||
+      codec != (int) get_codec(blocks.n_channels))
+    return false;
+
+  // size of blocks given by dimensions, & all of them present in file
+  size_t n_bytes_block = ((Codec) codec == Codec::BC3) ? 16 : 8;
+  uint64_t n_bytes_expected = (((uint64_t) blocks.width + 3) / 4) * (((uint64_t) blocks.height + 3) / 4) * n_bytes_block;
+  std::streampos offset = file.tellg();
+  file.seekg(0, std::ios::end);
+  std::streamoff n_bytes_left = file.tellg() - offset;
+  file.seekg(offset);
+  if (!file || n_bytes != n_bytes_expected || n_bytes_left < 0 || (uint64_t) n_bytes_left < n_bytes)
+    return false;
+
+  blocks.codec = (Codec) codec;
+  blocks.data.resize(n_bytes);
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(blocks.data.data()), n_bytes));
+}
+
+/* Temporary file renamed once complete (concurrent readers never see a partial file) */
+void BlockEncoder::write(const std::string& path, const Blocks& blocks) {
+  std::string path_tmp = path + ".tmp";
+  {
+    int codec = (int) blocks.codec;
+    uint64_t n_bytes = blocks.data.size();
+    std::ofstream file(path_tmp, std::ios::binary);
+    file.write(MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(&blocks.width), sizeof(int));
+    file.write(reinterpret_cast<const char*>(&blocks.height), sizeof(int));
+    file.write(reinterpret_cast<const char*>(&blocks.n_channels), sizeof(int));
+    file.write(reinterpret_cast<const char*>(&codec), sizeof(int));
+    file.write(reinterpret_cast<const char*>(&n_bytes), sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(blocks.data.data()), n_bytes);
+    if (!file)
+      return;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(path_tmp, path, error);
+}
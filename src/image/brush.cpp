@@ -0,0 +1,180 @@
+#include <cmath>
+#include <algorithm>
+
+#include "image/brush.hpp"
+#include "ui/globals/color.hpp"
+#include "image/image_vg.hpp"
+
+#include "shader_exception.hpp"
+
+Brush::Brush():
+  radius(ImageVG::RADIUS_CIRCLE),
+  hardness(0.8f),
+  spacing(0.25f),
+
+  m_program("assets/shaders/brush.vert", "assets/shaders/brush.frag"),
+  m_x_last(0.0f),
+  m_y_last(0.0f),
+  m_is_stroking(false),
+  m_distance(0.0f),
+  m_n_dabs_last_flush(0)
+{
+  if (m_program.has_failed())
+    throw ShaderException();
+
+  m_location_size = glGetUniformLocation(m_program.id, "size_framebuffer");
+  m_location_radius = glGetUniformLocation(m_program.id, "radius");
+  m_location_hardness = glGetUniformLocation(m_program.id, "hardness");
+  m_location_color = glGetUniformLocation(m_program.id, "color");
+
+  // unit quad shared by all dabs (drawn as triangle fan)
+  const float corners[] = {
+    -1, -1,
+     1, -1,
+     1,  1,
+    -1,  1,
+  };
+
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo_quad);
+  glGenBuffers(1, &m_vbo_dabs);
+  glBindVertexArray(m_vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo_quad);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*) 0);
+  glEnableVertexAttribArray(0);
+
+  // dabs centers advance once per instance
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo_dabs);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*) 0);
+  glEnableVertexAttribArray(1);
+  glVertexAttribDivisor(1, 1);
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/* Start stroke with a dab at (x, y) */
+void Brush::begin_stroke(float x, float y) {
+  m_is_stroking = true;
+  m_distance = 0.0f;
+  m_x_last = x;
+  m_y_last = y;
+  stamp(x, y);
+}
+
+/**
+ * Extend stroke to (x, y) with dabs every `spacing * radius` pixels along segment
+ * Starts a new stroke if none in progress
+ */
+void Brush::move_to(float x, float y) {
+  if (!m_is_stroking) {
+    begin_stroke(x, y);
+    return;
+  }
+
+  float step = std::max(1.0f, spacing * radius);
+  float dx = x - m_x_last;
+  float dy = y - m_y_last;
+  float length = std::sqrt(dx*dx + dy*dy);
+  if (length == 0.0f)
+    return;
+
+  // distance already travelled since last dab shifts first dab on this segment
+  float t = step - m_distance;
+  while (t <= length) {
+    stamp(m_x_last + dx * t / length, m_y_last + dy * t / length);
+    t += step;
+  }
+
+  m_distance = length - (t - step);
+  m_x_last = x;
+  m_y_last = y;
+}
+
+void Brush::end_stroke() {
+  m_is_stroking = false;
+}
+
+bool Brush::is_stroking() const {
+  return m_is_stroking;
+}
+
+void Brush::stamp(float x, float y) {
+  m_dabs.push_back(x);
+  m_dabs.push_back(y);
+}
+
+/**
+ * Bounding box of dabs queued since last flush (incl. their radius)
+ * @return false if no dab queued
+ */
+bool Brush::get_bounds(float& x_min, float& y_min, float& x_max, float& y_max) const {
+  if (m_dabs.empty())
+    return false;
+
+  x_min = x_max = m_dabs[0];
+  y_min = y_max = m_dabs[1];
+  for (size_t i_dab = 2; i_dab < m_dabs.size(); i_dab += 2) {
+    x_min = std::min(x_min, m_dabs[i_dab]);
+    x_max = std::max(x_max, m_dabs[i_dab]);
+    y_min = std::min(y_min, m_dabs[i_dab + 1]);
+    y_max = std::max(y_max, m_dabs[i_dab + 1]);
+  }
+
+  x_min -= radius;
+  y_min -= radius;
+  x_max += radius;
+  y_max += radius;
+  return true;
+}
+
+/**
+ * Draw all dabs queued since last flush into fbo's attached texture (one instanced draw call)
+ * @return true if something was drawn
+ */
+bool Brush::flush(const Framebuffer& framebuffer) {
+  m_n_dabs_last_flush = m_dabs.size() / 2;
+  if (m_dabs.empty())
+    return false;
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo_dabs);
+  glBufferData(GL_ARRAY_BUFFER, m_dabs.size() * sizeof(float), m_dabs.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // same fill color & alpha convention as `ImageVG`
+  framebuffer.bind();
+  glViewport(0, 0, framebuffer.width, framebuffer.height);
+  glEnable(GL_BLEND);
+  glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  m_program.use();
+  glUniform2f(m_location_size, framebuffer.width, framebuffer.height);
+  glUniform1f(m_location_radius, radius);
+  glUniform1f(m_location_hardness, hardness);
+  glUniform4f(m_location_color, Color::fill.x, Color::fill.y, Color::fill.z, 1.0f - Color::fill.w);
+
+  glBindVertexArray(m_vao);
+  glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, m_n_dabs_last_flush);
+  glBindVertexArray(0);
+
+  m_program.unuse();
+  glDisable(GL_BLEND);
+  framebuffer.unbind();
+
+  m_dabs.clear();
+  return true;
+}
+
+/* Number of dabs drawn in last flush (for profiling) */
+unsigned int Brush::get_n_dabs_last_flush() const {
+  return m_n_dabs_last_flush;
+}
+
+void Brush::free() {
+  m_program.free();
+  glDeleteBuffers(1, &m_vbo_quad);
+  glDeleteBuffers(1, &m_vbo_dabs);
+  glDeleteVertexArrays(1, &m_vao);
+}
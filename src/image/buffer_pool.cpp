@@ -0,0 +1,112 @@
+#include <cstdlib>
+#include <algorithm>
+
+#include "image/buffer_pool.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/**
+ * @param n_bytes_cached_max Max. total size of released buffers kept for reuse
+ */
+BufferPool::BufferPool(size_t n_bytes_cached_max):
+  m_n_bytes_cached_max(n_bytes_cached_max),
+  m_stats({ 0, 0, 0, 0, 0 })
+{
+}
+
+/* Pool shared by image operations */
+BufferPool& BufferPool::get() {
+  static BufferPool pool;
+  return pool;
+}
+
+/* Round up to a quarter of the largest power of 2 below `n_bytes` (e.g. 1MB, 1.25MB, 1.5MB, 1.75MB, 2MB...) */
+size_t BufferPool::get_size_class(size_t n_bytes) {
+  size_t power = 1;
+  while (power * 2 <= n_bytes)
+    power *= 2;
+
+  size_t step = std::max<size_t>(power / 4, 1);
+  return (n_bytes + step - 1) / step * step;
+}
+
+/* Buffer of at least `n_bytes`, reused from a released buffer of same size class if possible */
+unsigned char* BufferPool::acquire(size_t n_bytes) {
+  size_t size_class = get_size_class(n_bytes);
+  unsigned char* data = NULL;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<unsigned char*>& bucket = m_buckets[size_class];
+  if (!bucket.empty()) {
+    data = bucket.back();
+    bucket.pop_back();
+    m_stats.n_bytes_cached -= size_class;
+    m_stats.n_hits++;
+  } else {
+    data = (unsigned char*) std::malloc(size_class);
+    if (data == NULL)
+      return NULL;
+    m_stats.n_misses++;
+  }
+
+  m_sizes[data] = size_class;
+  m_stats.n_bytes_used += size_class;
+  m_stats.n_bytes_peak = std::max(m_stats.n_bytes_peak, m_stats.n_bytes_used);
+  report();
+  return data;
+}
+
+/**
+ * Give buffer back to pool (kept for reuse unless cache is full)
+ * @return false if buffer wasn't acquired from pool (left untouched)
+ */
+bool BufferPool::release(unsigned char* data) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_sizes.find(data);
+  if (it == m_sizes.end())
+    return false;
+
+  size_t size_class = it->second;
+  m_sizes.erase(it);
+  m_stats.n_bytes_used -= size_class;
+
+  if (m_stats.n_bytes_cached + size_class > m_n_bytes_cached_max) {
+    std::free(data);
+  } else {
+    m_buckets[size_class].push_back(data);
+    m_stats.n_bytes_cached += size_class;
+  }
+
+  report();
+  return true;
+}
+
+/* Free buffers kept for reuse (e.g. after a batch) */
+void BufferPool::trim() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& pair : m_buckets) {
+    for (unsigned char* data : pair.second)
+      std::free(data);
+  }
+
+  m_buckets.clear();
+  m_stats.n_bytes_cached = 0;
+  report();
+}
+
+/* Sizes of buffers in use & cached (called with mutex locked, keys are addresses of pool & of its stats) */
+void BufferPool::report() const {
+  MemoryTracker& tracker = MemoryTracker::get();
+  tracker.track(MemoryKind::CPU, (uintptr_t) this, "image buffers", "in use", m_stats.n_bytes_used);
+  tracker.track(MemoryKind::CPU, (uintptr_t) &m_stats, "image buffers", "cached for reuse", m_stats.n_bytes_cached);
+}
+
+/* Hits/misses of `acquire()` & memory used by buffers handed out (current & peak) or cached */
+BufferPool::Stats BufferPool::get_stats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+/* Free cached buffers (buffers still in use are owned by their images) */
+void BufferPool::free() {
+  trim();
+}
@@ -0,0 +1,74 @@
+#include <cmath>
+#include <algorithm>
+
+#include "image/color_lut.hpp"
+
+namespace {
+  float get(const std::unordered_map<std::string, float>& parameters, const std::string& name, float value_default) {
+    auto it = parameters.find(name);
+    return it != parameters.end() ? it->second : value_default;
+  }
+}
+
+/**
+ * Parameters of identity (also the ones shown in effects panel)
+ * black/white: input levels mapped to 0 & 1, brightness in [-1, 1], contrast & gamma around 1,
+ * curve[i]: output at input i / (N_POINTS_CURVE - 1), gain_r/g/b: multipliers of each channel
+ */
+std::unordered_map<std::string, float> ColorLut::get_defaults() {
+  std::unordered_map<std::string, float> parameters = {
+    { "black", 0.0f },
+    { "white", 1.0f },
+    { "brightness", 0.0f },
+    { "contrast", 1.0f },
+    { "gamma", 1.0f },
+    { "gain_r", 1.0f },
+    { "gain_g", 1.0f },
+    { "gain_b", 1.0f },
+  };
+
+  for (int i = 0; i < N_POINTS_CURVE; i++)
+    parameters["curve[" + std::to_string(i) + "]"] = i / (N_POINTS_CURVE - 1.0f);
+
+  return parameters;
+}
+
+/* Identity table */
+ColorLut::ColorLut() {
+  for (int value = 0; value < SIZE; value++)
+    std::fill(table.begin() + value * 4, table.begin() + (value + 1) * 4, value);
+}
+
+/**
+ * Compose adjustments in order: levels, brightness & contrast, gamma, curve, then gains
+ * @param parameters Effect's parameters (missing ones left at their default, see `get_defaults()`)
+ */
+ColorLut::ColorLut(const std::unordered_map<std::string, float>& parameters) {
+  float black = get(parameters, "black", 0.0f);
+  float white = std::max(get(parameters, "white", 1.0f), black + 1.0f / SIZE);
+  float brightness = get(parameters, "brightness", 0.0f);
+  float contrast = get(parameters, "contrast", 1.0f);
+  float gamma = std::max(get(parameters, "gamma", 1.0f), 0.01f);
+  float gains[3] = { get(parameters, "gain_r", 1.0f), get(parameters, "gain_g", 1.0f), get(parameters, "gain_b", 1.0f) };
+
+  float curve[N_POINTS_CURVE];
+  for (int i = 0; i < N_POINTS_CURVE; i++)
+    curve[i] = get(parameters, "curve[" + std::to_string(i) + "]", i / (N_POINTS_CURVE - 1.0f));
+
+  for (int value = 0; value < SIZE; value++) {
+    float level = std::clamp((value / (SIZE - 1.0f) - black) / (white - black), 0.0f, 1.0f);
+    level = std::clamp((level - 0.5f) * contrast + 0.5f + brightness, 0.0f, 1.0f);
+    level = std::pow(level, 1.0f / gamma);
+
+    float position = level * (N_POINTS_CURVE - 1);
+    int i_point = std::min((int) position, N_POINTS_CURVE - 2);
+    float t = position - i_point;
+    level = curve[i_point] + t * (curve[i_point + 1] - curve[i_point]);
+
+    for (int i_channel = 0; i_channel < 3; i_channel++) {
+      float channel = std::clamp(level * gains[i_channel], 0.0f, 1.0f);
+      table[value * 4 + i_channel] = (unsigned char) std::lround(channel * (SIZE - 1));
+    }
+    table[value * 4 + 3] = value;
+  }
+}
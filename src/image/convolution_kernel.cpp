@@ -0,0 +1,51 @@
+#include <algorithm>
+
+#include "image/convolution_kernel.hpp"
+
+namespace {
+  static_assert(RADIUS_MAX_CONVOLUTION == 3, "Radius switches must cover all instantiated radii");
+
+  template <Kernel KERNEL>
+  std::string get_defines(int radius) {
+    switch (radius) {
+      case 1:
+        return ConvolutionKernel<KERNEL, 1>::to_defines();
+      case 2:
+        return ConvolutionKernel<KERNEL, 2>::to_defines();
+      default:
+        return ConvolutionKernel<KERNEL, 3>::to_defines();
+    }
+  }
+}
+
+/* Kernel with given name (e.g. effect given on command-line), empty if unknown */
+std::optional<Kernel> find_kernel(const std::string& name) {
+  if (name == "box")
+    return Kernel::BOX;
+  if (name == "gaussian")
+    return Kernel::GAUSSIAN;
+  if (name == "sharpen")
+    return Kernel::SHARPEN;
+  if (name == "sobel")
+    return Kernel::SOBEL;
+
+  return {};
+}
+
+/**
+ * Constants of glsl variant of kernel
+ * @param radius Clamped to instantiated radii
+ */
+std::string get_kernel_defines(Kernel kernel, int radius) {
+  radius = std::clamp(radius, 1, RADIUS_MAX_CONVOLUTION);
+  switch (kernel) {
+    case Kernel::BOX:
+      return get_defines<Kernel::BOX>(radius);
+    case Kernel::GAUSSIAN:
+      return get_defines<Kernel::GAUSSIAN>(radius);
+    case Kernel::SHARPEN:
+      return get_defines<Kernel::SHARPEN>(radius);
+    default:
+      return get_defines<Kernel::SOBEL>(radius);
+  }
+}
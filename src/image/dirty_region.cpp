@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+
+#include "image/dirty_region.hpp"
+
+DirtyRegion::DirtyRegion():
+  m_width(0),
+  m_height(0),
+  m_n_tiles_x(0),
+  m_n_tiles_y(0),
+  m_revisions(),
+  m_revision_whole(0),
+  m_revision(0)
+{
+}
+
+/* Image of new size (e.g. another one opened), changed as a whole for all consumers */
+void DirtyRegion::reset(int width, int height) {
+  m_width = width;
+  m_height = height;
+  m_n_tiles_x = (width + SIZE_TILE - 1) / SIZE_TILE;
+  m_n_tiles_y = (height + SIZE_TILE - 1) / SIZE_TILE;
+  m_revisions.assign((size_t) m_n_tiles_x * m_n_tiles_y, 0);
+  add_all();
+}
+
+/**
+ * Mark tiles overlapping given rectangle as changed (parts outside image ignored)
+ * @param x_min,y_min,x_max,y_max Bounds of modified pixels (e.g. shape's bounding box incl. stroke width)
+ */
+void DirtyRegion::add(float x_min, float y_min, float x_max, float y_max) {
+  int i_tile_x_min = std::max((int) std::floor(x_min) / SIZE_TILE, 0);
+  int i_tile_y_min = std::max((int) std::floor(y_min) / SIZE_TILE, 0);
+  int i_tile_x_max = std::min((int) std::ceil(x_max) / SIZE_TILE, m_n_tiles_x - 1);
+  int i_tile_y_max = std::min((int) std::ceil(y_max) / SIZE_TILE, m_n_tiles_y - 1);
+  if (i_tile_x_min > i_tile_x_max || i_tile_y_min > i_tile_y_max)
+    return;
+
+  m_revision++;
+  for (int i_tile_y = i_tile_y_min; i_tile_y <= i_tile_y_max; i_tile_y++) {
+    for (int i_tile_x = i_tile_x_min; i_tile_x <= i_tile_x_max; i_tile_x++)
+      m_revisions[i_tile_y * m_n_tiles_x + i_tile_x] = m_revision;
+  }
+}
+
+/* Whole image changed (e.g. effect or view shader changed, undo) */
+void DirtyRegion::add_all() {
+  m_revision++;
+  m_revision_whole = m_revision;
+}
+
+/* Revision of last change, to be kept by consumer once it's up-to-date with current content */
+unsigned int DirtyRegion::get_revision() const {
+  return m_revision;
+}
+
+/**
+ * Bounding box of tiles changed after given revision
+ * @param margin Pixels added around box (e.g. radius of blur effects, as they spread changes to neighbours)
+ * @return false if nothing changed since `revision`
+ */
+bool DirtyRegion::get_bounds(unsigned int revision, int margin, Rect& rect) const {
+  if (revision == m_revision)
+    return false;
+
+  if (m_revision_whole > revision) {
+    rect = { 0, 0, m_width, m_height };
+    return true;
+  }
+
+  int i_tile_x_min = m_n_tiles_x, i_tile_y_min = m_n_tiles_y;
+  int i_tile_x_max = -1, i_tile_y_max = -1;
+  for (int i_tile_y = 0; i_tile_y < m_n_tiles_y; i_tile_y++) {
+    for (int i_tile_x = 0; i_tile_x < m_n_tiles_x; i_tile_x++) {
+      if (m_revisions[i_tile_y * m_n_tiles_x + i_tile_x] <= revision)
+        continue;
+
+      i_tile_x_min = std::min(i_tile_x_min, i_tile_x);
+      i_tile_y_min = std::min(i_tile_y_min, i_tile_y);
+      i_tile_x_max = std::max(i_tile_x_max, i_tile_x);
+      i_tile_y_max = std::max(i_tile_y_max, i_tile_y);
+    }
+  }
+
+  if (i_tile_x_max < 0)
+    return false;
+
+  int x_min = std::max(i_tile_x_min * SIZE_TILE - margin, 0);
+  int y_min = std::max(i_tile_y_min * SIZE_TILE - margin, 0);
+  int x_max = std::min((i_tile_x_max + 1) * SIZE_TILE + margin, m_width);
+  int y_max = std::min((i_tile_y_max + 1) * SIZE_TILE + margin, m_height);
+  rect = { x_min, y_min, x_max - x_min, y_max - y_min };
+  return true;
+}
+
+/* Whether rectangle covers whole image (partial update then no cheaper than a full one) */
+bool DirtyRegion::is_whole(const Rect& rect) const {
+  return rect.x == 0 && rect.y == 0 && rect.width == m_width && rect.height == m_height;
+}
+
+/**
+ * Overlap of two rectangles (e.g. dirty region & bounding box of selection)
+ * @return false if they don't overlap
+ */
+bool DirtyRegion::intersect(const Rect& a, const Rect& b, Rect& rect) {
+  int x_min = std::max(a.x, b.x), y_min = std::max(a.y, b.y);
+  int x_max = std::min(a.x + a.width, b.x + b.width), y_max = std::min(a.y + a.height, b.y + b.height);
+  if (x_min >= x_max || y_min >= y_max)
+    return false;
+
+  rect = { x_min, y_min, x_max - x_min, y_max - y_min };
+  return true;
+}
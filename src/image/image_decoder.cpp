@@ -0,0 +1,300 @@
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <csetjmp>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <chrono>
+
+#include "stb_image.h"
+#ifdef HAS_LIBJPEG
+#include <jpeglib.h>
+#endif
+#ifdef HAS_LIBPNG
+#include <png.h>
+#endif
+
+#include "image/image_decoder.hpp"
+#include "image/mapped_file.hpp"
+#include "profiling/metrics_exporter.hpp"
+
+namespace {
+  /* Throughput of decoders (images, pixels & seconds, whatever thread decoded them) */
+  void add_metrics(const Image& image, std::chrono::steady_clock::time_point time_start) {
+    MetricsExporter& exporter = MetricsExporter::get();
+    if (!exporter.is_enabled() || image.data == NULL)
+      return;
+
+    exporter.add("decode_images_total", 1.0);
+    exporter.add("decode_pixels_total", (double) image.width * image.height);
+    exporter.add("decode_seconds_total", std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count());
+  }
+
+#ifdef HAS_LIBJPEG
+  /* libjpeg calls `exit()` on errors by default, jump back to decoder instead */
+  struct JpegError {
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+  };
+
+  void on_jpeg_error(j_common_ptr info) {
+    longjmp(((JpegError*) info->err)->jump, 1);
+  }
+
+  /**
+   * Decode with dct-domain downscaling by the largest factor among 1/2, 1/4, 1/8 keeping `height_min` rows
+   * (only coefficients needed for the reduced size are transformed, hence much faster on large photos)
+   * @return NULL if image not supported (e.g. cmyk), to fall back to stb
+   */
+  unsigned char* decode_jpeg(const MappedFile& file, int height_min, int& width, int& height, int& n_channels) {
+    jpeg_decompress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = on_jpeg_error;
+
+    // buffer declared before `setjmp()`, so it's still valid after a jump
+    unsigned char* volatile data = NULL;
+    if (setjmp(error.jump)) {
+      std::free(data);
+      jpeg_destroy_decompress(&info);
+      return NULL;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, file.get_data(), file.get_size());
+    jpeg_read_header(&info, TRUE);
+    if (info.num_components != 1 && info.num_components != 3) {
+      jpeg_destroy_decompress(&info);
+      return NULL;
+    }
+
+    info.out_color_space = info.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    info.scale_num = 1;
+    info.scale_denom = 1;
+    if (height_min > 0) {
+      while (info.scale_denom < 8 && (int) info.image_height / (int) (info.scale_denom * 2) >= height_min)
+        info.scale_denom *= 2;
+    }
+
+    jpeg_start_decompress(&info);
+    width = info.output_width;
+    height = info.output_height;
+    n_channels = info.output_components;
+    size_t n_bytes_row = (size_t) width * n_channels;
+
+    // `malloc()` so pixels are freed by `Image::free()` like stb's
+    data = (unsigned char*) std::malloc(n_bytes_row * height);
+    if (data == NULL) {
+      jpeg_destroy_decompress(&info);
+      return NULL;
+    }
+
+    while (info.output_scanline < info.output_height) {
+      JSAMPROW row = data + n_bytes_row * info.output_scanline;
+      jpeg_read_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+
+    return data;
+  }
+#endif
+
+#ifdef HAS_LIBPNG
+  /* Decode with libpng (zlib's inflate is faster than stb's), 16-bit channels reduced to 8-bit */
+  unsigned char* decode_png(const MappedFile& file, int& width, int& height, int& n_channels) {
+    png_image png;
+    std::memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_memory(&png, file.get_data(), file.get_size()))
+      return NULL;
+
+    // same # of channels as stb would return (palette expanded)
+    bool has_alpha = png.format & PNG_FORMAT_FLAG_ALPHA;
+    bool has_color = png.format & PNG_FORMAT_FLAG_COLOR;
+    png.format = (has_color ? PNG_FORMAT_RGB : PNG_FORMAT_GRAY) | (has_alpha ? PNG_FORMAT_FLAG_ALPHA : 0);
+    width = png.width;
+    height = png.height;
+    n_channels = PNG_IMAGE_SAMPLE_CHANNELS(png.format);
+
+    unsigned char* data = (unsigned char*) std::malloc(PNG_IMAGE_SIZE(png));
+    if (data == NULL || !png_image_finish_read(&png, NULL, data, 0, NULL)) {
+      std::free(data);
+      png_image_free(&png);
+      return NULL;
+    }
+
+    return data;
+  }
+
+  /* compressed bytes read by libpng from mapped file */
+  struct PngSource {
+    const unsigned char* data;
+    size_t size;
+    size_t offset;
+  };
+
+  void read_png(png_structp png, png_bytep bytes, png_size_t n_bytes) {
+    PngSource* source = (PngSource*) png_get_io_ptr(png);
+    if (source->offset + n_bytes > source->size)
+      png_error(png, "truncated png");
+
+    std::memcpy(bytes, source->data + source->offset, n_bytes);
+    source->offset += n_bytes;
+  }
+
+  /**
+   * Decode 16-bit png keeping its samples at full precision (simplified api would convert them to linear light)
+   * @return NULL if png has 8-bit channels (or is invalid), to decode it with `decode_png()`
+   */
+  unsigned char* decode_png_16(const MappedFile& file, int& width, int& height, int& n_channels) {
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    if (png == NULL)
+      return NULL;
+    png_infop info = png_create_info_struct(png);
+
+    // buffers declared before `setjmp()`, so they're still valid after a jump on error
+    unsigned char* volatile data = NULL;
+    png_bytep* volatile rows = NULL;
+    if (info == NULL || setjmp(png_jmpbuf(png))) {
+      std::free(data);
+      std::free(rows);
+      png_destroy_read_struct(&png, &info, NULL);
+      return NULL;
+    }
+
+    PngSource source = { file.get_data(), file.get_size(), 0 };
+    png_set_read_fn(png, &source, read_png);
+    png_read_info(png, info);
+    if (png_get_bit_depth(png, info) != 16) {
+      png_destroy_read_struct(&png, &info, NULL);
+      return NULL;
+    }
+
+    // samples stored big-endian in file, transparency chunk expanded to alpha (same channels as 8-bit decode)
+    const uint16_t ORDER_TEST = 1;
+    if (*(const unsigned char*) &ORDER_TEST == 1)
+      png_set_swap(png);
+    if (png_get_valid(png, info, PNG_INFO_tRNS))
+      png_set_tRNS_to_alpha(png);
+    png_read_update_info(png, info);
+
+    width = png_get_image_width(png, info);
+    height = png_get_image_height(png, info);
+    n_channels = png_get_channels(png, info);
+    size_t n_bytes_row = png_get_rowbytes(png, info);
+
+    // `malloc()` so pixels are freed by `Image::free()` like stb's
+    data = (unsigned char*) std::malloc(n_bytes_row * height);
+    rows = (png_bytep*) std::malloc(sizeof(png_bytep) * height);
+    if (data == NULL || rows == NULL)
+      png_error(png, "out of memory");
+
+    for (int i_row = 0; i_row < height; i_row++)
+      rows[i_row] = data + n_bytes_row * i_row;
+    png_read_image(png, rows);
+    png_read_end(png, NULL);
+
+    std::free(rows);
+    png_destroy_read_struct(&png, &info, NULL);
+    return data;
+  }
+#endif
+}
+
+/**
+ * Decode image at `path` without flipping it (same pixels as `Image(path, false)`)
+ * Falls back to stb's buffered file reader if file can't be mapped or is too large for stb's memory api
+ * @param height_min Jpeg may be decoded at a reduced size no smaller than this (e.g. previews & thumbnails),
+ *                   other formats always decoded at full size (0 for full size)
+ * @param depth Set to depth of decoded channels if given (16-bit png then kept at 16 bits with libpng), 8-bit otherwise
+ * @return Image with NULL data on failure
+ */
+Image ImageDecoder::decode(const std::string& path, int height_min, Depth* depth) {
+  if (depth != NULL)
+    *depth = Depth::UNORM8;
+
+  auto time_start = std::chrono::steady_clock::now();
+  MappedFile file(path);
+  if (!file.is_mapped() || file.get_size() > INT_MAX) {
+    file.free();
+    Image image(path, false);
+    add_metrics(image, time_start);
+    return image;
+  }
+
+  // format detected from signature (extension may be wrong), stb used if codec fails
+  const unsigned char* bytes = file.get_data();
+  size_t size = file.get_size();
+  int width, height, n_channels;
+  unsigned char* data = NULL;
+
+#ifdef HAS_LIBJPEG
+  if (size > 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF)
+    data = decode_jpeg(file, height_min, width, height, n_channels);
+#endif
+#ifdef HAS_LIBPNG
+  const unsigned char SIGNATURE_PNG[] = { 0x89, 'P', 'N', 'G' };
+  bool is_png = size > 8 && std::memcmp(bytes, SIGNATURE_PNG, sizeof(SIGNATURE_PNG)) == 0;
+
+  // 16-bit samples stored in image's byte buffer (2 bytes each, native byte order)
+  if (is_png && depth != NULL) {
+    data = decode_png_16(file, width, height, n_channels);
+    if (data != NULL)
+      *depth = Depth::UNORM16;
+  }
+
+  if (is_png && data == NULL)
+    data = decode_png(file, width, height, n_channels);
+#endif
+
+  // pixels allocated with `malloc()`, so freed by `Image::free()` as usual
+  if (data == NULL)
+    data = stbi_load_from_memory(bytes, (int) size, &width, &height, &n_channels, 0);
+  file.free();
+
+  if (data == NULL) {
+    std::cout << "Failed to decode image: " << path << '\n';
+    return Image(0, 0, 0, NULL, path);
+  }
+
+  Image image(width, height, n_channels, data, path);
+  add_metrics(image, time_start);
+  return image;
+}
+
+/* Dimensions read from header only (e.g. to decide whether a reduced preview is worth decoding first) */
+bool ImageDecoder::get_info(const std::string& path, Info& info) {
+  MappedFile file(path);
+  if (!file.is_mapped() || file.get_size() > INT_MAX) {
+    file.free();
+    return false;
+  }
+
+  const unsigned char* bytes = file.get_data();
+  size_t size = file.get_size();
+  bool is_valid = stbi_info_from_memory(bytes, (int) size, &info.width, &info.height, &info.n_channels);
+#ifdef HAS_LIBJPEG
+  info.is_reducible = size > 3 && bytes[0] == 0xFF && bytes[1] == 0xD8 && bytes[2] == 0xFF;
+#else
+  info.is_reducible = false;
+#endif
+  file.free();
+
+  return is_valid;
+}
+
+/**
+ * Reduce 16-bit samples decoded by `decode()` to 8 bits in place (rounded, buffer not shrunk)
+ * Needed where pixels are processed on cpu as bytes (e.g. tiles of images too large for a texture)
+ */
+void ImageDecoder::reduce_to_8bit(Image& image) {
+  const uint16_t* samples = (const uint16_t*) image.data;
+  size_t n_samples = (size_t) image.width * image.height * image.n_channels;
+
+  // each byte written before the (later) sample it overwrites is read
+  for (size_t i_sample = 0; i_sample < n_samples; i_sample++)
+    image.data[i_sample] = (samples[i_sample] * 255u + 32767u) / 65535u;
+}
@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <csetjmp>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+#ifdef HAS_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+#include "image/image_encoder.hpp"
+#include "image/png_writer.hpp"
+#include "image/raw_writer.hpp"
+#include "image/pyramid_file.hpp"
+#include "profiling/metrics_exporter.hpp"
+
+namespace {
+#ifdef HAS_LIBJPEG
+  struct JpegError {
+    jpeg_error_mgr manager;
+    jmp_buf jump;
+  };
+
+  void on_jpeg_error(j_common_ptr info) {
+    longjmp(((JpegError*) info->err)->jump, 1);
+  }
+
+  /* Jpeg has no alpha, so only gray & rgb images are encoded here */
+  bool encode_jpeg(const Image& image, FILE* file, const ImageEncoder::Options& options) {
+    if (image.n_channels != 1 && image.n_channels != 3)
+      return false;
+
+    jpeg_compress_struct info;
+    JpegError error;
+    info.err = jpeg_std_error(&error.manager);
+    error.manager.error_exit = on_jpeg_error;
+    if (setjmp(error.jump)) {
+      jpeg_destroy_compress(&info);
+      return false;
+    }
+
+    jpeg_create_compress(&info);
+    jpeg_stdio_dest(&info, file);
+    info.image_width = image.width;
+    info.image_height = image.height;
+    info.input_components = image.n_channels;
+    info.in_color_space = image.n_channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+    jpeg_set_defaults(&info);
+    jpeg_set_quality(&info, options.quality, TRUE);
+
+    jpeg_start_compress(&info, TRUE);
+    size_t n_bytes_row = (size_t) image.width * image.n_channels;
+    while (info.next_scanline < info.image_height) {
+      JSAMPROW row = image.data + n_bytes_row * info.next_scanline;
+      jpeg_write_scanlines(&info, &row, 1);
+    }
+
+    jpeg_finish_compress(&info);
+    jpeg_destroy_compress(&info);
+    return true;
+  }
+#endif
+
+  /* Groups of rows deflated in parallel (standard png whatever the # of threads) */
+  bool encode_png(const Image& image, FILE* file, const ImageEncoder::Options& options) {
+    return PngWriter::write(image, file, options.level);
+  }
+
+  /* `Image::save()` doesn't report errors, so check written file */
+  bool save_stb(const Image& image, const std::string& path) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    bool existed = fs::exists(path, error);
+    fs::file_time_type time_before = existed ? fs::last_write_time(path, error) : fs::file_time_type::min();
+
+    // pixels not modified (`save()` isn't const)
+    Image(image.width, image.height, image.n_channels, image.data).save(path);
+
+    return fs::exists(path, error) && fs::file_size(path, error) > 0 &&
+           (!existed || fs::last_write_time(path, error) != time_before);
+  }
+
+  /* Write file in format given by extension of path */
+  bool write_file(const Image& image, const std::string& path, const ImageEncoder::Options& options) {
+    if (image.data == NULL || image.n_channels < 1 || image.n_channels > 4)
+      return false;
+
+    // uncompressed formats written without going through stdio's buffer
+    std::optional<RawWriter::Format> format_raw = RawWriter::find_format(path);
+    if (format_raw)
+      return RawWriter::write(image, path, *format_raw);
+
+    // tiled multi-resolution file (8-bit only), opened lazily by canvas
+    if (PyramidFile::is_pyramid(path))
+      return PyramidFile::write(image, path, options.level);
+
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    bool (*encode_codec)(const Image&, FILE*, const ImageEncoder::Options&) = NULL;
+#ifdef HAS_LIBJPEG
+    if ((extension == ".jpg" || extension == ".jpeg") && (image.n_channels == 1 || image.n_channels == 3))
+      encode_codec = encode_jpeg;
+#endif
+    if (extension == ".png")
+      encode_codec = encode_png;
+
+    if (encode_codec == NULL)
+      return save_stb(image, path);
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == NULL)
+      return false;
+
+    bool is_encoded = encode_codec(image, file, options);
+    is_encoded = std::fclose(file) == 0 && is_encoded;
+    if (!is_encoded)
+      std::remove(path.c_str());
+
+    return is_encoded;
+  }
+}
+
+/**
+ * Encode `image` to `path` (format from extension, e.g. ".png", ".jpg")
+ * Throughput of encoders exported with metrics (whatever thread encoded the image)
+ * @param options Jpeg quality & zlib level of png & pyramid (ignored by other formats)
+ * @return false if file couldn't be written
+ */
+bool ImageEncoder::encode(const Image& image, const std::string& path, const Options& options) {
+  auto time_start = std::chrono::steady_clock::now();
+  bool is_encoded = write_file(image, path, options);
+
+  MetricsExporter& exporter = MetricsExporter::get();
+  if (is_encoded && exporter.is_enabled()) {
+    exporter.add("encode_images_total", 1.0);
+    exporter.add("encode_pixels_total", (double) image.width * image.height);
+    exporter.add("encode_seconds_total", std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count());
+  }
+
+  return is_encoded;
+}
@@ -0,0 +1,116 @@
+#include "image/image_kernels.hpp"
+
+namespace {
+  /* best kernels for current cpu, detected on first use (can be overridden by `select()`) */
+  ImageKernels::Kernels kernels;
+  bool is_selected = false;
+
+  ImageKernels::Kernels make_kernels(ImageKernels::Isa isa) {
+    switch (isa) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      case ImageKernels::Isa::SSE4:
+        return { isa, ImageKernels::to_grayscale_row_sse4, ImageKernels::blur_row_sse4 };
+      case ImageKernels::Isa::AVX2:
+        return { isa, ImageKernels::to_grayscale_row_avx2, ImageKernels::blur_row_avx2 };
+#endif
+#if defined(__ARM_NEON)
+      case ImageKernels::Isa::NEON:
+        return { isa, ImageKernels::to_grayscale_row_neon, ImageKernels::blur_row_neon };
+#endif
+      default:
+        return { ImageKernels::Isa::SCALAR, ImageKernels::to_grayscale_row_scalar, ImageKernels::blur_row_scalar };
+    }
+  }
+}
+
+/* Kernels for widest instruction set supported by cpu */
+const ImageKernels::Kernels& ImageKernels::get() {
+  if (!is_selected) {
+    const Isa isas[] = { Isa::AVX2, Isa::SSE4, Isa::NEON, Isa::SCALAR };
+    for (Isa isa : isas) {
+      if (is_supported(isa)) {
+        kernels = make_kernels(isa);
+        break;
+      }
+    }
+
+    is_selected = true;
+  }
+
+  return kernels;
+}
+
+/**
+ * Force kernels of given instruction set (e.g. scalar reference to compare results)
+ * @return false if cpu doesn't support it (selection unchanged)
+ */
+bool ImageKernels::select(Isa isa) {
+  if (!is_supported(isa))
+    return false;
+
+  kernels = make_kernels(isa);
+  is_selected = true;
+  return true;
+}
+
+/* Whether instruction set was compiled in & is supported by cpu */
+bool ImageKernels::is_supported(Isa isa) {
+  switch (isa) {
+    case Isa::SCALAR:
+      return true;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    case Isa::SSE4:
+      return __builtin_cpu_supports("sse4.1");
+    case Isa::AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON)
+    case Isa::NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+const char* ImageKernels::get_name(Isa isa) {
+  switch (isa) {
+    case Isa::SSE4:
+      return "sse4";
+    case Isa::AVX2:
+      return "avx2";
+    case Isa::NEON:
+      return "neon";
+    default:
+      return "scalar";
+  }
+}
+
+/* Reference implementation (output 1 channel) */
+void ImageKernels::to_grayscale_row_scalar(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels) {
+  for (int i_pixel = 0; i_pixel < width; i_pixel++) {
+    const unsigned char* pixel = row_in + n_channels*i_pixel;
+    row_out[i_pixel] = (pixel[0] + pixel[1] + pixel[2]) / 3;
+  }
+}
+
+/* Reference implementation (borders copied, each channel averaged independently) */
+void ImageKernels::blur_row_scalar(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                                   unsigned char* row_out, int width, int n_channels) {
+  int n_bytes_row = width * n_channels;
+  for (int i_col = 0; i_col < n_bytes_row; i_col++) {
+    // pixels on border directly copied
+    if (i_col < n_channels || i_col >= n_bytes_row - n_channels) {
+      row_out[i_col] = row[i_col];
+      continue;
+    }
+
+    int i_col_m1 = i_col - n_channels;
+    int i_col_p1 = i_col + n_channels;
+    row_out[i_col] = (
+        row_above[i_col_m1] + row_above[i_col] + row_above[i_col_p1] +
+        row[i_col_m1]       + row[i_col]       + row[i_col_p1]       +
+        row_below[i_col_m1] + row_below[i_col] + row_below[i_col_p1]
+      ) / 9;
+  }
+}
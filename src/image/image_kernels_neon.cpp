@@ -0,0 +1,92 @@
+/**
+ * NEON kernels (always available on aarch64)
+ * x/3 & x/9 computed as (x * 0xAAAB) >> 17 & (x * 0xE38F) >> 19 (exact for the sums involved)
+ */
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+#include "image/image_kernels.hpp"
+
+namespace {
+  /* (x * multiplier) >> shift on 8 16-bit lanes through 32-bit products */
+  template <int shift>
+  uint16x8_t divide(uint16x8_t x, uint16_t multiplier) {
+    uint32x4_t product_lo = vmull_n_u16(vget_low_u16(x), multiplier);
+    uint32x4_t product_hi = vmull_n_u16(vget_high_u16(x), multiplier);
+    return vshrq_n_u16(vcombine_u16(vshrn_n_u32(product_lo, 16), vshrn_n_u32(product_hi, 16)), shift - 16);
+  }
+
+  /* Sum of 3 bytes vectors (`offset` apart) widened to 16-bit, for low & high halves */
+  void add_3_taps(const unsigned char* p, int offset, uint16x8_t& sum_lo, uint16x8_t& sum_hi) {
+    uint8x16_t taps[3] = { vld1q_u8(p - offset), vld1q_u8(p), vld1q_u8(p + offset) };
+    for (const uint8x16_t& tap : taps) {
+      sum_lo = vaddw_u8(sum_lo, vget_low_u8(tap));
+      sum_hi = vaddw_u8(sum_hi, vget_high_u8(tap));
+    }
+  }
+}
+
+/* 8 pixels per iteration (rgb & rgba deinterleaved on load, other layouts use scalar reference) */
+void ImageKernels::to_grayscale_row_neon(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels) {
+  if (n_channels != 3 && n_channels != 4) {
+    to_grayscale_row_scalar(row_in, row_out, width, n_channels);
+    return;
+  }
+
+  int i_pixel = 0;
+  for (; i_pixel + 8 <= width; i_pixel += 8) {
+    const unsigned char* pixels = row_in + n_channels*i_pixel;
+    uint16x8_t sum;
+    if (n_channels == 3) {
+      uint8x8x3_t rgb = vld3_u8(pixels);
+      sum = vaddw_u8(vaddl_u8(rgb.val[0], rgb.val[1]), rgb.val[2]);
+    } else {
+      uint8x8x4_t rgba = vld4_u8(pixels);
+      sum = vaddw_u8(vaddl_u8(rgba.val[0], rgba.val[1]), rgba.val[2]);
+    }
+
+    vst1_u8(row_out + i_pixel, vmovn_u16(divide<17>(sum, 0xAAAB)));
+  }
+
+  for (; i_pixel < width; i_pixel++) {
+    const unsigned char* pixel = row_in + n_channels*i_pixel;
+    row_out[i_pixel] = (pixel[0] + pixel[1] + pixel[2]) / 3;
+  }
+}
+
+/* 16 bytes per iteration (any # of channels) */
+void ImageKernels::blur_row_neon(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                                 unsigned char* row_out, int width, int n_channels) {
+  // pixels on border directly copied
+  int n_bytes_row = width * n_channels;
+  for (int i_channel = 0; i_channel < n_channels; i_channel++) {
+    row_out[i_channel] = row[i_channel];
+    row_out[n_bytes_row - n_channels + i_channel] = row[n_bytes_row - n_channels + i_channel];
+  }
+
+  int i_col_end = n_bytes_row - n_channels;
+  int i_col = n_channels;
+  for (; i_col + 16 <= i_col_end; i_col += 16) {
+    uint16x8_t sum_lo = vdupq_n_u16(0);
+    uint16x8_t sum_hi = vdupq_n_u16(0);
+    add_3_taps(row_above + i_col, n_channels, sum_lo, sum_hi);
+    add_3_taps(row + i_col, n_channels, sum_lo, sum_hi);
+    add_3_taps(row_below + i_col, n_channels, sum_lo, sum_hi);
+
+    uint8x16_t avg = vcombine_u8(vmovn_u16(divide<19>(sum_lo, 0xE38F)), vmovn_u16(divide<19>(sum_hi, 0xE38F)));
+    vst1q_u8(row_out + i_col, avg);
+  }
+
+  for (; i_col < i_col_end; i_col++) {
+    int i_col_m1 = i_col - n_channels;
+    int i_col_p1 = i_col + n_channels;
+    row_out[i_col] = (
+        row_above[i_col_m1] + row_above[i_col] + row_above[i_col_p1] +
+        row[i_col_m1]       + row[i_col]       + row[i_col_p1]       +
+        row_below[i_col_m1] + row_below[i_col] + row_below[i_col_p1]
+      ) / 9;
+  }
+}
+
+#endif
@@ -0,0 +1,231 @@
+/**
+ * SSE4.1 & AVX2 kernels (compiled with per-function target attributes, used only if cpu supports them)
+ * x/3 & x/9 computed as (x * 0xAAAB) >> 17 & (x * 0xE38F) >> 19 (exact for the sums involved)
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#include <immintrin.h>
+
+#include "image/image_kernels.hpp"
+
+namespace {
+  const short MULTIPLIER_DIV3 = (short) 0xAAAB;
+  const short MULTIPLIER_DIV9 = (short) 0xE38F;
+
+  /**
+   * Red, green & blue components of 8 pixels as 16-bit lanes
+   * @param lo, hi Bytes [0, 16) & [8, 24) of pixels for rgb, [0, 16) & [16, 32) for rgba
+   */
+  __attribute__((target("sse4.1")))
+  __m128i sum_rgb_8(__m128i lo, __m128i hi, int n_channels) {
+    __m128i red, green, blue;
+
+    if (n_channels == 3) {
+      red = _mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, 12, -1, -1, -1, -1, -1, -1, -1)),
+                         _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, 10, -1, 13, -1)));
+      green = _mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(1, -1, 4, -1, 7, -1, 10, -1, 13, -1, -1, -1, -1, -1, -1, -1)),
+                           _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 11, -1, 14, -1)));
+      blue = _mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(2, -1, 5, -1, 8, -1, 11, -1, 14, -1, -1, -1, -1, -1, -1, -1)),
+                          _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, 12, -1, 15, -1)));
+    } else {
+      // red & green of 4 pixels in one register, blue in another
+      __m128i mask_rg = _mm_setr_epi8(0, -1, 4, -1, 8, -1, 12, -1, 1, -1, 5, -1, 9, -1, 13, -1);
+      __m128i mask_b = _mm_setr_epi8(2, -1, 6, -1, 10, -1, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+      __m128i rg_lo = _mm_shuffle_epi8(lo, mask_rg);
+      __m128i rg_hi = _mm_shuffle_epi8(hi, mask_rg);
+      red = _mm_unpacklo_epi64(rg_lo, rg_hi);
+      green = _mm_unpackhi_epi64(rg_lo, rg_hi);
+      blue = _mm_unpacklo_epi64(_mm_shuffle_epi8(lo, mask_b), _mm_shuffle_epi8(hi, mask_b));
+    }
+
+    return _mm_add_epi16(_mm_add_epi16(red, green), blue);
+  }
+
+  /* Same as `sum_rgb_8()` on 2 groups of 8 pixels (one per 128-bit lane) */
+  __attribute__((target("avx2")))
+  __m256i sum_rgb_16(__m256i lo, __m256i hi, int n_channels) {
+    __m256i red, green, blue;
+
+    if (n_channels == 3) {
+      __m256i mask_r_lo = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, -1, 3, -1, 6, -1, 9, -1, 12, -1, -1, -1, -1, -1, -1, -1));
+      __m256i mask_r_hi = _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 7, -1, 10, -1, 13, -1));
+      __m256i mask_g_lo = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, -1, 4, -1, 7, -1, 10, -1, 13, -1, -1, -1, -1, -1, -1, -1));
+      __m256i mask_g_hi = _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 8, -1, 11, -1, 14, -1));
+      __m256i mask_b_lo = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, -1, 5, -1, 8, -1, 11, -1, 14, -1, -1, -1, -1, -1, -1, -1));
+      __m256i mask_b_hi = _mm256_broadcastsi128_si256(_mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 9, -1, 12, -1, 15, -1));
+      red = _mm256_or_si256(_mm256_shuffle_epi8(lo, mask_r_lo), _mm256_shuffle_epi8(hi, mask_r_hi));
+      green = _mm256_or_si256(_mm256_shuffle_epi8(lo, mask_g_lo), _mm256_shuffle_epi8(hi, mask_g_hi));
+      blue = _mm256_or_si256(_mm256_shuffle_epi8(lo, mask_b_lo), _mm256_shuffle_epi8(hi, mask_b_hi));
+    } else {
+      __m256i mask_rg = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, -1, 4, -1, 8, -1, 12, -1, 1, -1, 5, -1, 9, -1, 13, -1));
+      __m256i mask_b = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, -1, 6, -1, 10, -1, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+      __m256i rg_lo = _mm256_shuffle_epi8(lo, mask_rg);
+      __m256i rg_hi = _mm256_shuffle_epi8(hi, mask_rg);
+      red = _mm256_unpacklo_epi64(rg_lo, rg_hi);
+      green = _mm256_unpackhi_epi64(rg_lo, rg_hi);
+      blue = _mm256_unpacklo_epi64(_mm256_shuffle_epi8(lo, mask_b), _mm256_shuffle_epi8(hi, mask_b));
+    }
+
+    return _mm256_add_epi16(_mm256_add_epi16(red, green), blue);
+  }
+
+  /* Remaining pixels/bytes of a row (same arithmetic as scalar reference) */
+  void to_grayscale_tail(const unsigned char* row_in, unsigned char* row_out, int i_pixel, int width, int n_channels) {
+    for (; i_pixel < width; i_pixel++) {
+      const unsigned char* pixel = row_in + n_channels*i_pixel;
+      row_out[i_pixel] = (pixel[0] + pixel[1] + pixel[2]) / 3;
+    }
+  }
+
+  void blur_tail(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                 unsigned char* row_out, int i_col, int i_col_end, int n_channels) {
+    for (; i_col < i_col_end; i_col++) {
+      int i_col_m1 = i_col - n_channels;
+      int i_col_p1 = i_col + n_channels;
+      row_out[i_col] = (
+          row_above[i_col_m1] + row_above[i_col] + row_above[i_col_p1] +
+          row[i_col_m1]       + row[i_col]       + row[i_col_p1]       +
+          row_below[i_col_m1] + row_below[i_col] + row_below[i_col_p1]
+        ) / 9;
+    }
+  }
+
+  /* Copy first & last pixels of row (not blurred) */
+  void blur_borders(const unsigned char* row, unsigned char* row_out, int width, int n_channels) {
+    int n_bytes_row = width * n_channels;
+    for (int i_channel = 0; i_channel < n_channels; i_channel++) {
+      row_out[i_channel] = row[i_channel];
+      row_out[n_bytes_row - n_channels + i_channel] = row[n_bytes_row - n_channels + i_channel];
+    }
+  }
+
+  /* Sum of 3 bytes vectors (`offset` apart) widened to 16-bit, for low & high halves */
+  __attribute__((target("sse4.1")))
+  void add_3_taps(const unsigned char* p, int offset, __m128i& sum_lo, __m128i& sum_hi) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i taps[3] = {
+      _mm_loadu_si128((const __m128i*) (p - offset)),
+      _mm_loadu_si128((const __m128i*) p),
+      _mm_loadu_si128((const __m128i*) (p + offset)),
+    };
+
+    for (const __m128i& tap : taps) {
+      sum_lo = _mm_add_epi16(sum_lo, _mm_unpacklo_epi8(tap, zero));
+      sum_hi = _mm_add_epi16(sum_hi, _mm_unpackhi_epi8(tap, zero));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  __m256i add_3_taps(const unsigned char* p, int offset, __m256i sum) {
+    sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (p - offset))));
+    sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) p)));
+    sum = _mm256_add_epi16(sum, _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (p + offset))));
+    return sum;
+  }
+}
+
+/* 8 pixels per iteration (rgb & rgba only, other layouts use scalar reference) */
+__attribute__((target("sse4.1")))
+void ImageKernels::to_grayscale_row_sse4(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels) {
+  if (n_channels != 3 && n_channels != 4) {
+    to_grayscale_row_scalar(row_in, row_out, width, n_channels);
+    return;
+  }
+
+  // second load ends at last byte of 8th pixel
+  const __m128i multiplier = _mm_set1_epi16(MULTIPLIER_DIV3);
+  int offset_hi = (n_channels == 3) ? 8 : 16;
+  int i_pixel = 0;
+
+  for (; i_pixel + 8 <= width; i_pixel += 8) {
+    const unsigned char* pixels = row_in + n_channels*i_pixel;
+    __m128i lo = _mm_loadu_si128((const __m128i*) pixels);
+    __m128i hi = _mm_loadu_si128((const __m128i*) (pixels + offset_hi));
+
+    __m128i sum = sum_rgb_8(lo, hi, n_channels);
+    __m128i avg = _mm_srli_epi16(_mm_mulhi_epu16(sum, multiplier), 1);
+    _mm_storel_epi64((__m128i*) (row_out + i_pixel), _mm_packus_epi16(avg, avg));
+  }
+
+  to_grayscale_tail(row_in, row_out, i_pixel, width, n_channels);
+}
+
+/* 16 bytes per iteration (any # of channels) */
+__attribute__((target("sse4.1")))
+void ImageKernels::blur_row_sse4(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                                 unsigned char* row_out, int width, int n_channels) {
+  blur_borders(row, row_out, width, n_channels);
+
+  const __m128i multiplier = _mm_set1_epi16(MULTIPLIER_DIV9);
+  int i_col_end = (width - 1) * n_channels;
+  int i_col = n_channels;
+
+  // loads at `i_col + n_channels` stay within row
+  for (; i_col + 16 <= i_col_end; i_col += 16) {
+    __m128i sum_lo = _mm_setzero_si128();
+    __m128i sum_hi = _mm_setzero_si128();
+    add_3_taps(row_above + i_col, n_channels, sum_lo, sum_hi);
+    add_3_taps(row + i_col, n_channels, sum_lo, sum_hi);
+    add_3_taps(row_below + i_col, n_channels, sum_lo, sum_hi);
+
+    __m128i avg_lo = _mm_srli_epi16(_mm_mulhi_epu16(sum_lo, multiplier), 3);
+    __m128i avg_hi = _mm_srli_epi16(_mm_mulhi_epu16(sum_hi, multiplier), 3);
+    _mm_storeu_si128((__m128i*) (row_out + i_col), _mm_packus_epi16(avg_lo, avg_hi));
+  }
+
+  blur_tail(row_above, row, row_below, row_out, i_col, i_col_end, n_channels);
+}
+
+/* 16 pixels per iteration (2 groups of 8 pixels in separate 128-bit lanes) */
+__attribute__((target("avx2")))
+void ImageKernels::to_grayscale_row_avx2(const unsigned char* row_in, unsigned char* row_out, int width, int n_channels) {
+  if (n_channels != 3 && n_channels != 4) {
+    to_grayscale_row_scalar(row_in, row_out, width, n_channels);
+    return;
+  }
+
+  const __m256i multiplier = _mm256_set1_epi16(MULTIPLIER_DIV3);
+  int offset_hi = (n_channels == 3) ? 8 : 16;
+  int i_pixel = 0;
+
+  for (; i_pixel + 16 <= width; i_pixel += 16) {
+    const unsigned char* pixels_1 = row_in + n_channels*i_pixel;
+    const unsigned char* pixels_2 = pixels_1 + 8*n_channels;
+    __m256i lo = _mm256_loadu2_m128i((const __m128i*) pixels_2, (const __m128i*) pixels_1);
+    __m256i hi = _mm256_loadu2_m128i((const __m128i*) (pixels_2 + offset_hi), (const __m128i*) (pixels_1 + offset_hi));
+
+    // packing within lanes leaves results in 1st & 3rd 64-bit words
+    __m256i sum = sum_rgb_16(lo, hi, n_channels);
+    __m256i avg = _mm256_srli_epi16(_mm256_mulhi_epu16(sum, multiplier), 1);
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(avg, avg), 0x08);
+    _mm_storeu_si128((__m128i*) (row_out + i_pixel), _mm256_castsi256_si128(packed));
+  }
+
+  to_grayscale_tail(row_in, row_out, i_pixel, width, n_channels);
+}
+
+/* 16 bytes per iteration widened to 16 16-bit lanes */
+__attribute__((target("avx2")))
+void ImageKernels::blur_row_avx2(const unsigned char* row_above, const unsigned char* row, const unsigned char* row_below,
+                                 unsigned char* row_out, int width, int n_channels) {
+  blur_borders(row, row_out, width, n_channels);
+
+  const __m256i multiplier = _mm256_set1_epi16(MULTIPLIER_DIV9);
+  int i_col_end = (width - 1) * n_channels;
+  int i_col = n_channels;
+
+  for (; i_col + 16 <= i_col_end; i_col += 16) {
+    __m256i sum = _mm256_setzero_si256();
+    sum = add_3_taps(row_above + i_col, n_channels, sum);
+    sum = add_3_taps(row + i_col, n_channels, sum);
+    sum = add_3_taps(row_below + i_col, n_channels, sum);
+
+    __m256i avg = _mm256_srli_epi16(_mm256_mulhi_epu16(sum, multiplier), 3);
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(avg, avg), 0x08);
+    _mm_storeu_si128((__m128i*) (row_out + i_col), _mm256_castsi256_si128(packed));
+  }
+
+  blur_tail(row_above, row, row_below, row_out, i_col, i_col_end, n_channels);
+}
+
+#endif
@@ -4,81 +4,771 @@
  */
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
 
 #include "image/image_utils.hpp"
+#include "image/image_kernels.hpp"
+#include "image/buffer_pool.hpp"
+#include "jobs/thread_pool.hpp"
 
-/* Convert image to grayscale by averaging rgb components */
-Image ImageUtils::to_grayscale(Image& image_in) {
-  int n_channels = image_in.n_channels;
-  int n_pixels = image_in.width * image_in.height;
-  unsigned char* data_in = image_in.data;
-  unsigned char* data_out = new unsigned char[n_pixels];
-
-  for (size_t i_pixel = 0; i_pixel < n_pixels; i_pixel++) {
-    unsigned char red = data_in[n_channels*i_pixel];
-    unsigned char green = data_in[n_channels*i_pixel + 1];
-    unsigned char blue = data_in[n_channels*i_pixel + 2];
-
-    // output single-channel image
-    unsigned char out = (red + green + blue) / 3;
-    data_out[i_pixel] = out;
+namespace {
+  /* shared by all filters, created on first use with 1 thread per hardware thread by default */
+  std::unique_ptr<ThreadPool> pool;
+  int n_threads_pool = 0;
+
+  ThreadPool& get_pool() {
+    if (!pool)
+      pool = std::make_unique<ThreadPool>(n_threads_pool);
+
+    return *pool;
   }
 
-  // new image for result & free input image
-  Image image_out(image_in.width, image_in.height, 1, data_out);
-  image_in.free();
+  /* Call `f(std::integral_constant<int, i>())` for i in [0, n) (weights indexed by it are then immediates) */
+  template <typename F, int... I>
+  inline void unroll(F&& f, std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>()), ...);
+  }
 
-  return image_out;
+  /**
+   * Convolution by kernel of fixed radius (loop over its taps unrolled), borders clamped
+   * Alpha (last channel of 2 & 4-channel views) kept from center pixel
+   */
+  template <Kernel KERNEL, int RADIUS>
+  void convolve(const ImageView& view_in, const ImageView& view_out) {
+    using K = ConvolutionKernel<KERNEL, RADIUS>;
+    int width = view_in.width, height = view_in.height, n_channels = view_in.n_channels;
+    int n_channels_color = (n_channels == 2 || n_channels == 4) ? n_channels - 1 : n_channels;
+
+    get_pool().parallel_for(height, ImageUtils::N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+      const unsigned char* rows[K::SIZE];
+      int offsets[K::SIZE];
+
+      for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+        for (int i = 0; i < K::SIZE; i++)
+          rows[i] = view_in.get_row(std::clamp(i_row + i - RADIUS, 0, height - 1));
+        unsigned char* row_out = view_out.get_row(i_row);
+
+        for (int x = 0; x < width; x++) {
+          for (int i = 0; i < K::SIZE; i++)
+            offsets[i] = std::clamp(x + i - RADIUS, 0, width - 1) * n_channels;
+
+          for (int i_channel = 0; i_channel < n_channels_color; i_channel++) {
+            int sum = 0, sum_y = 0;
+            unroll([&](auto i) {
+              constexpr int i_row_kernel = i / K::SIZE, i_column_kernel = i % K::SIZE;
+              int value = rows[i_row_kernel][offsets[i_column_kernel] + i_channel];
+              sum += K::WEIGHTS_FIXED[i] * value;
+              if constexpr (K::IS_GRADIENT)
+                sum_y += K::WEIGHTS_FIXED[i_column_kernel * K::SIZE + i_row_kernel] * value;
+            }, std::make_integer_sequence<int, K::N_WEIGHTS>());
+
+            int value;
+            if constexpr (K::IS_GRADIENT)
+              value = (int) std::lround(std::sqrt((float) sum * sum + (float) sum_y * sum_y) / (1 << K::SHIFT));
+            else
+              value = (sum + (1 << (K::SHIFT - 1))) >> K::SHIFT;
+            row_out[x * n_channels + i_channel] = std::clamp(value, 0, 255);
+          }
+
+          if (n_channels_color < n_channels)
+            row_out[x * n_channels + n_channels_color] = rows[RADIUS][x * n_channels + n_channels_color];
+        }
+      }
+    });
+  }
+
+  /**
+   * Lookup of each byte in table of its channel (# of channels fixed, so loop over them is unrolled)
+   * Gray of 1 & 2-channel views mapped by red entries (alpha by alpha ones)
+   */
+  template <int N_CHANNELS>
+  void apply_lut(const ImageView& view_in, const ImageView& view_out, const ColorLut& lut) {
+    constexpr int I_ENTRIES[4] = { 0, N_CHANNELS == 2 ? 3 : 1, 2, 3 };
+    const unsigned char* table = lut.table.data();
+    int width = view_in.width;
+
+    get_pool().parallel_for(view_in.height, ImageUtils::N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+      for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+        const unsigned char* row_in = view_in.get_row(i_row);
+        unsigned char* row_out = view_out.get_row(i_row);
+        for (int i_pixel = 0; i_pixel < width; i_pixel++) {
+          for (int i_channel = 0; i_channel < N_CHANNELS; i_channel++) {
+            int i_byte = i_pixel * N_CHANNELS + i_channel;
+            row_out[i_byte] = table[row_in[i_byte] * 4 + I_ENTRIES[i_channel]];
+          }
+        }
+      }
+    });
+  }
+
+  template <Kernel KERNEL>
+  void convolve(const ImageView& view_in, const ImageView& view_out, int radius) {
+    static_assert(RADIUS_MAX_CONVOLUTION == 3, "Radius switches must cover all instantiated radii");
+    switch (radius) {
+      case 1:
+        convolve<KERNEL, 1>(view_in, view_out);
+        break;
+      case 2:
+        convolve<KERNEL, 2>(view_in, view_out);
+        break;
+      default:
+        convolve<KERNEL, 3>(view_in, view_out);
+    }
+  }
 }
 
-/* Blur image using averaging filter */
-Image ImageUtils::blur(Image& image_in) {
-  int n_channels = image_in.n_channels;
-  int width = image_in.width;
-  int height = image_in.height;
-  unsigned char* data_in = image_in.data;
-
-  // transform image data to 2D array
-  unsigned char** data_in_2d = image_in.to_2d_array();
-
-  // 9x9 averaging kernel
-  size_t n_bytes_row = width * n_channels;
-  unsigned char** data_out_2d = new unsigned char*[height];
-
-  for (size_t i_height = 0; i_height < height; i_height++) {
-    data_out_2d[i_height] = new unsigned char[n_bytes_row];
-
-    for (size_t i_width = 0; i_width < width; i_width++) {
-      // pixels on border directly copied
-      if (i_height == 0 || i_width == 0 || i_height == height - 1 || i_width == width - 1) {
-        for (size_t i_channel = 0; i_channel < n_channels; i_channel++) {
-          size_t i_col = n_channels*i_width + i_channel;
-          data_out_2d[i_height][i_col] = data_in_2d[i_height][i_col];
+/**
+ * Change # of threads used by filters (incl. calling thread)
+ * @param n_threads 0 for 1 per hardware thread, 1 to run on calling thread only
+ */
+void ImageUtils::set_n_threads(int n_threads) {
+  n_threads_pool = n_threads;
+  if (pool) {
+    pool->free();
+    pool.reset();
+  }
+}
+
+int ImageUtils::get_n_threads() {
+  return get_pool().get_n_threads();
+}
+
+/* Parallel loop on threads of filters (e.g. for encoders, so they don't oversubscribe cpu with a pool of their own) */
+void ImageUtils::parallel_for(int n_items, int size_chunk, const std::function<void(int, int)>& func) {
+  get_pool().parallel_for(n_items, size_chunk, func);
+}
+
+/**
+ * Convert view to grayscale by averaging rgb components (row kernel picked according to cpu)
+ * @param view_out Single-channel view of same size
+ */
+void ImageUtils::to_grayscale(const ImageView& view_in, const ImageView& view_out) {
+  // bands of rows in parallel
+  const ImageKernels::Kernels& kernels = ImageKernels::get();
+  get_pool().parallel_for(view_in.height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      kernels.to_grayscale_row(view_in.get_row(i_row), view_out.get_row(i_row), view_in.width, view_in.n_channels);
+    }
+  });
+}
+
+/**
+ * @param data_out Buffer of `width * height` bytes
+ * @return Contiguous single-channel view on `data_out`
+ */
+ImageView ImageUtils::to_grayscale(const ImageView& view_in, unsigned char* data_out) {
+  ImageView view_out(data_out, view_in.width, view_in.height, 1);
+  to_grayscale(view_in, view_out);
+
+  return view_out;
+}
+
+/**
+ * Blur view using 3x3 averaging filter (row kernel picked according to cpu)
+ * Pixels on view's border are copied, even if it's a crop of a larger image
+ * @param view_out View of same size & # of channels
+ */
+void ImageUtils::blur(const ImageView& view_in, const ImageView& view_out) {
+  int height = view_in.height;
+  size_t n_bytes_row = view_in.get_n_bytes_row();
+  const ImageKernels::Kernels& kernels = ImageKernels::get();
+
+  // bands of rows in parallel (each output row only depends on input)
+  get_pool().parallel_for(height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      // rows on border directly copied (border pixels of other rows copied by kernel)
+      if (i_row == 0 || i_row == height - 1) {
+        std::memcpy(view_out.get_row(i_row), view_in.get_row(i_row), n_bytes_row);
+        continue;
+      }
+
+      // average pixel values in 3x3 neighborhood
+      kernels.blur_row(view_in.get_row(i_row - 1), view_in.get_row(i_row), view_in.get_row(i_row + 1),
+                       view_out.get_row(i_row), view_in.width, view_in.n_channels);
+    }
+  });
+}
+
+/**
+ * @param data_out Buffer of `width * height * n_channels` bytes
+ * @return Contiguous view on `data_out`
+ */
+ImageView ImageUtils::blur(const ImageView& view_in, unsigned char* data_out) {
+  ImageView view_out(data_out, view_in.width, view_in.height, view_in.n_channels);
+  blur(view_in, view_out);
+
+  return view_out;
+}
+
+/**
+ * Mean of `(2*radius + 1)^2` neighbourhood of each pixel, computed as a horizontal then a vertical running sum
+ * (one add & one subtract per pixel & pass whatever the radius), pixels beyond view's border replicate it
+ * @param view_out View of same size & # of channels (can't be `view_in`)
+ */
+void ImageUtils::box_blur(const ImageView& view_in, const ImageView& view_out, int radius) {
+  int width = view_in.width, height = view_in.height, n_channels = view_in.n_channels;
+  int n_taps = 2 * radius + 1;
+
+  // horizontal pass into output (each row on its own)
+  get_pool().parallel_for(height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      const unsigned char* row_in = view_in.get_row(i_row);
+      unsigned char* row_out = view_out.get_row(i_row);
+
+      for (int i_channel = 0; i_channel < n_channels; i_channel++) {
+        auto at = [&](int x) { return row_in[std::clamp(x, 0, width - 1) * n_channels + i_channel]; };
+        unsigned int sum = 0;
+        for (int x = -radius; x <= radius; x++)
+          sum += at(x);
+
+        for (int x = 0; x < width; x++) {
+          row_out[x * n_channels + i_channel] = (sum + n_taps / 2) / n_taps;
+          sum += at(x + radius + 1) - at(x - radius);
+        }
+      }
+    }
+  });
+
+  // vertical pass in place, by bands of columns (sums of a band kept while walking down its rows)
+  // rows of window copied before being overwritten, as they're still needed by next output rows
+  size_t n_bytes_row = view_in.get_n_bytes_row();
+  int n_bands = (n_bytes_row + N_BYTES_BAND - 1) / N_BYTES_BAND;
+  get_pool().parallel_for(n_bands, 1, [&](int i_band_begin, int i_band_end) {
+    for (int i_band = i_band_begin; i_band < i_band_end; i_band++) {
+      size_t i_byte_begin = (size_t) i_band * N_BYTES_BAND;
+      size_t n_bytes = std::min((size_t) N_BYTES_BAND, n_bytes_row - i_byte_begin);
+
+      // ring of horizontally-blurred rows in window (indexed by row modulo its size)
+      std::vector<unsigned char> rows(n_bytes * n_taps);
+      auto fetch = [&](int y) { return view_out.get_row(std::clamp(y, 0, height - 1)) + i_byte_begin; };
+      std::vector<unsigned int> sums(n_bytes, 0);
+      for (int y = -radius; y <= radius; y++) {
+        const unsigned char* row = fetch(y);
+        std::memcpy(rows.data() + (size_t) ((y + n_taps) % n_taps) * n_bytes, row, n_bytes);
+        for (size_t i = 0; i < n_bytes; i++)
+          sums[i] += row[i];
+      }
+
+      for (int y = 0; y < height; y++) {
+        // row leaving window kept in ring, row entering it read before output overwrites it
+        const unsigned char* row_leaving = rows.data() + (size_t) ((y - radius + n_taps) % n_taps) * n_bytes;
+        unsigned char* row_out = fetch(y);
+        for (size_t i = 0; i < n_bytes; i++)
+          row_out[i] = (sums[i] + n_taps / 2) / n_taps;
+
+        const unsigned char* row_entering = fetch(y + radius + 1);
+        unsigned char* slot = rows.data() + (size_t) ((y - radius + n_taps) % n_taps) * n_bytes;
+        for (size_t i = 0; i < n_bytes; i++) {
+          sums[i] += row_entering[i] - row_leaving[i];
+          slot[i] = row_entering[i];
+        }
+      }
+    }
+  });
+}
+
+/**
+ * Gaussian blur (sigma = radius / 3, like `BlurKernel`) approximated by iterated box filters
+ * Widths of boxes chosen so their variances add up to the gaussian's one (cost independent of radius)
+ * @param view_out View of same size & # of channels (can't be `view_in`)
+ */
+void ImageUtils::gaussian_blur(const ImageView& view_in, const ImageView& view_out, int radius) {
+  // n boxes of odd widths `width_lower` or `width_lower + 2` (the first `n_lower` ones are narrower)
+  double variance = std::pow(radius / 3.0, 2.0);
+  int n = N_BOXES_GAUSSIAN;
+  int width_lower = (int) std::floor(std::sqrt(12.0 * variance / n + 1.0));
+  if (width_lower % 2 == 0)
+    width_lower--;
+  int n_lower = (int) std::round((12.0 * variance - n * width_lower * width_lower - 4.0 * n * width_lower - 3.0 * n) /
+                                 (-4.0 * width_lower - 4.0));
+
+  // boxes ping-pong between output & a pooled buffer, last one written to output
+  // (buffer of its own if pool's allocation failed, throws `std::bad_alloc` if that one also fails)
+  unsigned char* data_tmp = BufferPool::get().acquire(view_in.get_n_bytes());
+  std::vector<unsigned char> fallback;
+  if (data_tmp == NULL) {
+    fallback.resize(view_in.get_n_bytes());
+    data_tmp = fallback.data();
+  }
+  ImageView view_tmp(data_tmp, view_in.width, view_in.height, view_in.n_channels);
+  for (int i_box = 0; i_box < n; i_box++) {
+    int radius_box = ((i_box < n_lower ? width_lower : width_lower + 2) - 1) / 2;
+    const ImageView& source = (i_box == 0) ? view_in : ((n - i_box) % 2 == 0 ? view_out : view_tmp);
+    const ImageView& target = ((n - i_box) % 2 == 1) ? view_out : view_tmp;
+    box_blur(source, target, radius_box);
+  }
+
+  BufferPool::get().release(data_tmp);
+}
+
+/**
+ * Summed-area tables of one channel (rows prefix-summed in parallel, then columns by bands)
+ * @param i_channel Channel integrated (e.g. 0 for single-channel views)
+ */
+void ImageUtils::integrate(const ImageView& view, int i_channel, IntegralImage& integral) {
+  int width = view.width, height = view.height;
+  size_t n_columns = width + 1;
+  integral.width = width;
+  integral.height = height;
+  integral.sums.assign(n_columns * (height + 1), 0);
+  integral.sums_squared.assign(n_columns * (height + 1), 0);
+
+  get_pool().parallel_for(height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      const unsigned char* row = view.get_row(i_row);
+      uint64_t* sums = integral.sums.data() + (i_row + 1) * n_columns;
+      uint64_t* sums_squared = integral.sums_squared.data() + (i_row + 1) * n_columns;
+      for (int x = 0; x < width; x++) {
+        uint64_t value = row[x * view.n_channels + i_channel];
+        sums[x + 1] = sums[x] + value;
+        sums_squared[x + 1] = sums_squared[x] + value * value;
+      }
+    }
+  });
+
+  int n_columns_band = N_BYTES_BAND / sizeof(uint64_t);
+  get_pool().parallel_for(n_columns, n_columns_band, [&](int i_column_begin, int i_column_end) {
+    for (int i_row = 1; i_row <= height; i_row++) {
+      for (int x = i_column_begin; x < i_column_end; x++) {
+        integral.sums[i_row * n_columns + x] += integral.sums[(i_row - 1) * n_columns + x];
+        integral.sums_squared[i_row * n_columns + x] += integral.sums_squared[(i_row - 1) * n_columns + x];
+      }
+    }
+  });
+}
+
+/**
+ * Binarize each color channel by Sauvola's local threshold `mean * (1 + k * (std / r - 1))` over the
+ * `(2*radius + 1)^2` neighbourhood of each pixel (cropped at view's border), alpha copied as is
+ * Mean & variance of each window read from summed-area tables, so cost per pixel doesn't depend on radius
+ * @param view_out View of same size & # of channels (can't be `view_in`)
+ */
+void ImageUtils::threshold(const ImageView& view_in, const ImageView& view_out, int radius) {
+  int width = view_in.width, height = view_in.height, n_channels = view_in.n_channels;
+  int n_channels_color = (n_channels == 2 || n_channels == 4) ? n_channels - 1 : n_channels;
+  radius = std::max(radius, 0);
+  IntegralImage integral;
+
+  for (int i_channel = 0; i_channel < n_channels_color; i_channel++) {
+    integrate(view_in, i_channel, integral);
+
+    get_pool().parallel_for(height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+      for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+        const unsigned char* row_in = view_in.get_row(i_row);
+        unsigned char* row_out = view_out.get_row(i_row);
+        int y_min = std::max(i_row - radius, 0), y_max = std::min(i_row + radius + 1, height);
+
+        for (int x = 0; x < width; x++) {
+          int x_min = std::max(x - radius, 0), x_max = std::min(x + radius + 1, width);
+          double mean = integral.get_mean(x_min, y_min, x_max - x_min, y_max - y_min);
+          double deviation = std::sqrt(integral.get_variance(x_min, y_min, x_max - x_min, y_max - y_min));
+          double threshold = mean * (1.0 + THRESHOLD_K * (deviation / THRESHOLD_R - 1.0));
+          row_out[x * n_channels + i_channel] = row_in[x * n_channels + i_channel] > threshold ? 255 : 0;
         }
+      }
+    });
+  }
+
+  if (n_channels_color < n_channels) {
+    get_pool().parallel_for(height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+      for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+        const unsigned char* row_in = view_in.get_row(i_row);
+        unsigned char* row_out = view_out.get_row(i_row);
+        for (int x = 0; x < width; x++)
+          row_out[x * n_channels + n_channels_color] = row_in[x * n_channels + n_channels_color];
+      }
+    });
+  }
+}
+
+/**
+ * Convolve view by kernel generated at compile-time (same weights as glsl variant of `convolution.frag`)
+ * Dispatched to a version specialized for each kernel & radius (larger radii: use `box_blur()` or `gaussian_blur()`)
+ * @param view_out View of same size & # of channels (can't be `view_in`)
+ * @param radius Clamped to [1, `RADIUS_MAX_CONVOLUTION`]
+ */
+void ImageUtils::convolve(const ImageView& view_in, const ImageView& view_out, Kernel kernel, int radius) {
+  radius = std::clamp(radius, 1, RADIUS_MAX_CONVOLUTION);
+  switch (kernel) {
+    case Kernel::BOX:
+      ::convolve<Kernel::BOX>(view_in, view_out, radius);
+      break;
+    case Kernel::GAUSSIAN:
+      ::convolve<Kernel::GAUSSIAN>(view_in, view_out, radius);
+      break;
+    case Kernel::SHARPEN:
+      ::convolve<Kernel::SHARPEN>(view_in, view_out, radius);
+      break;
+    default:
+      ::convolve<Kernel::SOBEL>(view_in, view_out, radius);
+  }
+}
+
+/**
+ * Map pixels through lookup table folding all adjustments (same table as gpu's adjustment stage)
+ * Byte lookups don't vectorize (no byte gather), so rows are split in bands over threads instead
+ * @param view_out View of same size & # of channels (can be `view_in`, as each byte only depends on itself)
+ */
+void ImageUtils::apply_lut(const ImageView& view_in, const ImageView& view_out, const ColorLut& lut) {
+  switch (view_in.n_channels) {
+    case 1:
+      ::apply_lut<1>(view_in, view_out, lut);
+      break;
+    case 2:
+      ::apply_lut<2>(view_in, view_out, lut);
+      break;
+    case 3:
+      ::apply_lut<3>(view_in, view_out, lut);
+      break;
+    default:
+      ::apply_lut<4>(view_in, view_out, lut);
+  }
+}
+
+/**
+ * Shrink view by an integer factor, each output pixel averaging a `factor`^2 block (e.g. downscaled exports)
+ * Blocks cut by right & bottom borders average their pixels inside view only
+ * @param view_out View of size `ceil(width / factor)` x `ceil(height / factor)` & same # of channels
+ */
+void ImageUtils::downscale(const ImageView& view_in, const ImageView& view_out, int factor) {
+  int n_channels = view_in.n_channels;
+
+  // bands of output rows in parallel
+  get_pool().parallel_for(view_out.height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    std::vector<unsigned int> sums((size_t) view_out.width * n_channels);
+
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      int y_begin = i_row * factor, y_end = std::min(y_begin + factor, view_in.height);
+      std::fill(sums.begin(), sums.end(), 0);
+      for (int y = y_begin; y < y_end; y++) {
+        const unsigned char* row_in = view_in.get_row(y);
+        for (int x = 0; x < view_in.width; x++) {
+          unsigned int* sum = &sums[(size_t) (x / factor) * n_channels];
+          for (int i_channel = 0; i_channel < n_channels; i_channel++)
+            sum[i_channel] += row_in[(size_t) x * n_channels + i_channel];
+        }
+      }
+
+      unsigned char* row_out = view_out.get_row(i_row);
+      for (int x = 0; x < view_out.width; x++) {
+        unsigned int n_pixels = (std::min((x + 1) * factor, view_in.width) - x * factor) * (y_end - y_begin);
+        for (int i_channel = 0; i_channel < n_channels; i_channel++) {
+          size_t i_byte = (size_t) x * n_channels + i_channel;
+          row_out[i_byte] = (sums[i_byte] + n_pixels / 2) / n_pixels;
+        }
+      }
+    }
+  });
+}
+
+/**
+ * @param data_out Buffer of `ceil(width / factor) * ceil(height / factor) * n_channels` bytes
+ * @return Contiguous view on `data_out`
+ */
+ImageView ImageUtils::downscale(const ImageView& view_in, int factor, unsigned char* data_out) {
+  int width = (view_in.width + factor - 1) / factor, height = (view_in.height + factor - 1) / factor;
+  ImageView view_out(data_out, width, height, view_in.n_channels);
+  downscale(view_in, view_out, factor);
+
+  return view_out;
+}
+
+/**
+ * Pixels connected to seed (4-connectivity) whose channels all differ by at most `tolerance` from its ones
+ * (cpu fallback of `FloodFill`, e.g. for headless batch runs)
+ * Similarity of pixels computed by bands in parallel, then region filled span by span on a single thread
+ * @param x,y Seed (origin at first row of view)
+ * @param mask Set to 1 byte per pixel of view, 255 inside region & 0 outside
+ * @return false if seed is outside view
+ */
+bool ImageUtils::flood_fill_mask(const ImageView& view, int x, int y, int tolerance, std::vector<unsigned char>& mask) {
+  if (x < 0 || y < 0 || x >= view.width || y >= view.height)
+    return false;
+
+  int width = view.width, n_channels = view.n_channels;
+  std::vector<unsigned char> color_seed(view.get_row(y) + x * n_channels, view.get_row(y) + (x + 1) * n_channels);
+
+  // 1: similar to seed, 255: filled
+  mask.assign((size_t) width * view.height, 0);
+  get_pool().parallel_for(view.height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      const unsigned char* row = view.get_row(i_row);
+      unsigned char* row_mask = mask.data() + (size_t) i_row * width;
+      for (int i_pixel = 0; i_pixel < width; i_pixel++) {
+        bool is_similar = true;
+        for (int i_channel = 0; i_channel < n_channels && is_similar; i_channel++)
+          is_similar = std::abs(row[i_pixel * n_channels + i_channel] - color_seed[i_channel]) <= tolerance;
+        row_mask[i_pixel] = is_similar;
+      }
+    }
+  });
+
+  // scanline fill: span around each seed filled, then similar pixels above & below it become seeds
+  std::vector<std::pair<int, int>> seeds = { { x, y } };
+  while (!seeds.empty()) {
+    auto [x_seed, y_seed] = seeds.back();
+    seeds.pop_back();
+    unsigned char* row_mask = mask.data() + (size_t) y_seed * width;
+    if (row_mask[x_seed] != 1)
+      continue;
+
+    int x_start = x_seed, x_end = x_seed + 1;
+    while (x_start > 0 && row_mask[x_start - 1] == 1)
+      x_start--;
+    while (x_end < width && row_mask[x_end] == 1)
+      x_end++;
+    std::memset(row_mask + x_start, 255, x_end - x_start);
+
+    for (int y_neighbour : { y_seed - 1, y_seed + 1 }) {
+      if (y_neighbour < 0 || y_neighbour >= view.height)
         continue;
+
+      // one seed per run of similar pixels
+      const unsigned char* row_neighbour = mask.data() + (size_t) y_neighbour * width;
+      for (int x_neighbour = x_start; x_neighbour < x_end; x_neighbour++) {
+        if (row_neighbour[x_neighbour] == 1 && (x_neighbour == x_start || row_neighbour[x_neighbour - 1] != 1))
+          seeds.push_back({ x_neighbour, y_neighbour });
       }
+    }
+  }
+
+  // similar pixels not connected to seed left out
+  get_pool().parallel_for(view.height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (size_t i = (size_t) i_row_begin * width; i < (size_t) i_row_end * width; i++)
+      mask[i] = mask[i] == 255 ? 255 : 0;
+  });
+
+  return true;
+}
+
+/**
+ * Fill region of similar color connected to seed in place (see `flood_fill_mask()`)
+ * @param color Rgba (1-channel views get avg. of rgb, 2-channel ones avg. of rgb & alpha)
+ * @return false if seed is outside view
+ */
+bool ImageUtils::flood_fill(const ImageView& view, int x, int y, const unsigned char* color, int tolerance) {
+  std::vector<unsigned char> mask;
+  if (!flood_fill_mask(view, x, y, tolerance, mask))
+    return false;
+
+  int n_channels = view.n_channels;
+  unsigned char gray = (color[0] + color[1] + color[2]) / 3;
+  unsigned char pixel[4] = { color[0], color[1], color[2], color[3] };
+  if (n_channels <= 2) {
+    pixel[0] = gray;
+    pixel[1] = color[3];
+  }
+
+  get_pool().parallel_for(view.height, N_ROWS_BAND, [&](int i_row_begin, int i_row_end) {
+    for (int i_row = i_row_begin; i_row < i_row_end; i_row++) {
+      unsigned char* row = view.get_row(i_row);
+      const unsigned char* row_mask = mask.data() + (size_t) i_row * view.width;
+      for (int i_pixel = 0; i_pixel < view.width; i_pixel++) {
+        if (row_mask[i_pixel] != 0)
+          std::memcpy(row + i_pixel * n_channels, pixel, n_channels);
+      }
+    }
+  });
+
+  return true;
+}
+
+/**
+ * Error & ssim of view relative to a reference of same size (see `Similarity`), # of channels may differ
+ * Each window of `Similarity::SIZE_WINDOW` rows processed in parallel, sums combined in order (reproducible)
+ * @return false if sizes differ
+ */
+bool ImageUtils::compare(const ImageView& view, const ImageView& view_reference, Similarity& similarity) {
+  if (view.width != view_reference.width || view.height != view_reference.height || view.width == 0 || view.height == 0)
+    return false;
+
+  const int SIZE_WINDOW = Similarity::SIZE_WINDOW;
+  int width = view.width, height = view.height;
+  int n_windows_x = (width + SIZE_WINDOW - 1) / SIZE_WINDOW, n_windows_y = (height + SIZE_WINDOW - 1) / SIZE_WINDOW;
+  std::vector<double> errors(n_windows_y), ssims(n_windows_y);
+
+  // rgb normalized to [0, 1] (gray repeated) & its luma
+  auto get_rgb = [](const unsigned char* pixel, int n_channels, double* rgb) {
+    bool is_gray = n_channels <= 2;
+    for (int i_channel = 0; i_channel < 3; i_channel++)
+      rgb[i_channel] = pixel[is_gray ? 0 : i_channel] / 255.0;
 
-      // average pixel values in 9x9 neighborhood
-      for (size_t i_channel = 0; i_channel < n_channels; i_channel++) {
-        size_t i_col_m1 = n_channels*(i_width - 1) + i_channel;
-        size_t i_col = n_channels*i_width + i_channel;
-        size_t i_col_p1 = n_channels*(i_width + 1) + i_channel;
+    return is_gray ? rgb[0] : 0.299 * rgb[0] + 0.587 * rgb[1] + 0.114 * rgb[2];
+  };
 
-        unsigned char out = (
-            data_in_2d[i_height - 1][i_col_m1] + data_in_2d[i_height - 1][i_col] + data_in_2d[i_height - 1][i_col_p1] +
-            data_in_2d[i_height][i_col_m1]     + data_in_2d[i_height][i_col]     + data_in_2d[i_height][i_col_p1]     +
-            data_in_2d[i_height + 1][i_col_m1] + data_in_2d[i_height + 1][i_col] + data_in_2d[i_height + 1][i_col_p1]
-          ) / 9;
-        data_out_2d[i_height][i_col] = out;
+  get_pool().parallel_for(n_windows_y, 1, [&](int i_window_begin, int i_window_end) {
+    for (int i_window_y = i_window_begin; i_window_y < i_window_end; i_window_y++) {
+      int y_begin = i_window_y * SIZE_WINDOW, y_end = std::min(y_begin + SIZE_WINDOW, height);
+      double error = 0.0, ssim = 0.0;
+
+      for (int i_window_x = 0; i_window_x < n_windows_x; i_window_x++) {
+        int x_begin = i_window_x * SIZE_WINDOW, x_end = std::min(x_begin + SIZE_WINDOW, width);
+        double sum_a = 0.0, sum_b = 0.0, sum_aa = 0.0, sum_bb = 0.0, sum_ab = 0.0;
+
+        for (int y = y_begin; y < y_end; y++) {
+          const unsigned char* row = view.get_row(y);
+          const unsigned char* row_reference = view_reference.get_row(y);
+          for (int x = x_begin; x < x_end; x++) {
+            double rgb[3], rgb_reference[3];
+            double a = get_rgb(row + (size_t) x * view.n_channels, view.n_channels, rgb);
+            double b = get_rgb(row_reference + (size_t) x * view_reference.n_channels, view_reference.n_channels, rgb_reference);
+            for (int i_channel = 0; i_channel < 3; i_channel++)
+              error += (rgb[i_channel] - rgb_reference[i_channel]) * (rgb[i_channel] - rgb_reference[i_channel]);
+
+            sum_a += a;
+            sum_b += b;
+            sum_aa += a * a;
+            sum_bb += b * b;
+            sum_ab += a * b;
+          }
+        }
+
+        double n_pixels = (x_end - x_begin) * (y_end - y_begin);
+        ssim += Similarity::get_ssim(n_pixels, sum_a, sum_b, sum_aa, sum_bb, sum_ab);
       }
+
+      errors[i_window_y] = error;
+      ssims[i_window_y] = ssim;
     }
+  });
+
+  double error = 0.0, ssim = 0.0;
+  for (int i_window_y = 0; i_window_y < n_windows_y; i_window_y++) {
+    error += errors[i_window_y];
+    ssim += ssims[i_window_y];
   }
 
-  delete[] data_in_2d;
+  similarity.width = width;
+  similarity.height = height;
+  similarity.mse = error / ((double) width * height * 3);
+  similarity.psnr = Similarity::get_psnr(similarity.mse);
+  similarity.ssim = ssim / ((double) n_windows_x * n_windows_y);
+  return true;
+}
+
+/**
+ * Convert image to grayscale (new single-channel image returned & input image freed)
+ * Output's pixels come from buffer pool (to be freed with `ImageUtils::free()` for reuse), input returned as is
+ * (& kept) if pool couldn't allocate them
+ */
+Image ImageUtils::to_grayscale(Image& image_in) {
+  unsigned char* data_out = BufferPool::get().acquire((size_t) image_in.width * image_in.height);
+  if (data_out == NULL)
+    return image_in;
+  to_grayscale(ImageView(image_in), data_out);
 
   // new image for result & free input image
-  Image image_out = Image::from_2d_array(data_out_2d, width, height, n_channels);
-  image_in.free();
+  Image image_out(image_in.width, image_in.height, 1, data_out);
+  free(image_in);
+
+  return image_out;
+}
+
+/**
+ * Blur image (new image returned & input image freed)
+ * Output's pixels come from buffer pool (to be freed with `ImageUtils::free()` for reuse), input returned as is
+ * (& kept) if pool couldn't allocate them
+ */
+Image ImageUtils::blur(Image& image_in) {
+  ImageView view_in(image_in);
+  unsigned char* data_out = BufferPool::get().acquire(view_in.get_n_bytes());
+  if (data_out == NULL)
+    return image_in;
+  blur(view_in, data_out);
+
+  // new image for result & free input image
+  Image image_out(image_in.width, image_in.height, image_in.n_channels, data_out);
+  free(image_in);
+
+  return image_out;
+}
+
+/**
+ * Box-filter image (new image returned & input image freed)
+ * Output's pixels come from buffer pool (to be freed with `ImageUtils::free()` for reuse), input returned as is
+ * (& kept) if pool couldn't allocate them
+ */
+Image ImageUtils::box_blur(Image& image_in, int radius) {
+  ImageView view_in(image_in);
+  unsigned char* data_out = BufferPool::get().acquire(view_in.get_n_bytes());
+  if (data_out == NULL)
+    return image_in;
+  box_blur(view_in, ImageView(data_out, image_in.width, image_in.height, image_in.n_channels), radius);
+
+  Image image_out(image_in.width, image_in.height, image_in.n_channels, data_out);
+  free(image_in);
+
+  return image_out;
+}
+
+/**
+ * Blur image with a gaussian approximated by box filters (new image returned & input image freed)
+ * Output's pixels come from buffer pool (to be freed with `ImageUtils::free()` for reuse), input returned as is
+ * (& kept) if pool couldn't allocate them
+ */
+Image ImageUtils::gaussian_blur(Image& image_in, int radius) {
+  ImageView view_in(image_in);
+  unsigned char* data_out = BufferPool::get().acquire(view_in.get_n_bytes());
+  if (data_out == NULL)
+    return image_in;
+  gaussian_blur(view_in, ImageView(data_out, image_in.width, image_in.height, image_in.n_channels), radius);
+
+  Image image_out(image_in.width, image_in.height, image_in.n_channels, data_out);
+  free(image_in);
 
   return image_out;
 }
+
+/**
+ * Binarize image by local threshold (new image returned & input image freed)
+ * Output's pixels come from buffer pool (to be freed with `ImageUtils::free()` for reuse), input returned as is
+ * (& kept) if pool couldn't allocate them
+ */
+Image ImageUtils::threshold(Image& image_in, int radius) {
+  ImageView view_in(image_in);
+  unsigned char* data_out = BufferPool::get().acquire(view_in.get_n_bytes());
+  if (data_out == NULL)
+    return image_in;
+  threshold(view_in, ImageView(data_out, image_in.width, image_in.height, image_in.n_channels), radius);
+
+  Image image_out(image_in.width, image_in.height, image_in.n_channels, data_out);
+  free(image_in);
+
+  return image_out;
+}
+
+/**
+ * Convolve image by given kernel (new image returned & input image freed)
+ * Output's pixels come from buffer pool (to be freed with `ImageUtils::free()` for reuse), input returned as is
+ * (& kept) if pool couldn't allocate them
+ */
+Image ImageUtils::convolve(Image& image_in, Kernel kernel, int radius) {
+  ImageView view_in(image_in);
+  unsigned char* data_out = BufferPool::get().acquire(view_in.get_n_bytes());
+  if (data_out == NULL)
+    return image_in;
+  convolve(view_in, ImageView(data_out, image_in.width, image_in.height, image_in.n_channels), kernel, radius);
+
+  Image image_out(image_in.width, image_in.height, image_in.n_channels, data_out);
+  free(image_in);
+
+  return image_out;
+}
+
+/* Adjust image in place (see `apply_lut()` on views) */
+void ImageUtils::apply_lut(Image& image, const ColorLut& lut) {
+  ImageView view(image);
+  apply_lut(view, view, lut);
+}
+
+/* Give image's pixels back to buffer pool (or free them if they were decoded/allocated elsewhere) */
+void ImageUtils::free(Image& image) {
+  if (!BufferPool::get().release(image.data))
+    image.free();
+  image.data = NULL;
+}
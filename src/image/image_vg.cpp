@@ -1,64 +1,107 @@
+#include <chrono>
+
 #include "image/image_vg.hpp"
 #include "ui/globals/color.hpp"
+#include "profiling/gpu_timer.hpp"
+#include "profiling/tracer.hpp"
 
 #include "framebuffer_exception.hpp"
 
-#define NANOVG_GL3_IMPLEMENTATION
-#include "nanovg_gl.h"
+const float ImageVG::RADIUS_CIRCLE = 25.0f;
+const float ImageVG::WIDTH_STROKE = 10.0f;
 
-ImageVG::ImageVG() {
-  // create nanovg context (similar to html5 canvas)
-  m_vg = nvgCreateGL3(NVG_STENCIL_STROKES | NVG_DEBUG);
+/**
+ * @param vg Nanovg context shared by documents (owned by `GpuResources`)
+ */
+ImageVG::ImageVG(NVGcontext* vg):
+  m_vg(vg),
+  m_framebuffer(NULL),
+  m_stats { 0, 0, 0, 0.0 }
+{
 }
 
-/* Draw circle with nanovg to fbo (i.e. to image texture) */
+/* Queue circle to draw with nanovg to fbo (i.e. to image texture) */
 void ImageVG::draw_circle(const Framebuffer& framebuffer, float x, float y) {
-  // append to framebuffer's attached color buffer
-  framebuffer.bind();
-
-  // same size `nvgBeginFrame()` as `glViewport()`/texture to avoid stretching drawn shapes
-  float pixel_ratio = 1.0f; // framebuffer (i.e. texture) & image have same size
-  nvgBeginFrame(m_vg, framebuffer.width, framebuffer.height, pixel_ratio);
-
-  // draw rectangle & circle on fbo's texture
-  nvgBeginPath(m_vg);
-  nvgCircle(m_vg, x, y, 25);
+  PROFILE_ZONE("ImageVG::draw_circle");
   NVGcolor color_fill = { Color::fill.x, Color::fill.y, Color::fill.z, 1.0f - Color::fill.w };
-  nvgFillColor(m_vg, color_fill);
-  nvgFill(m_vg);
-  nvgClosePath(m_vg);
+  queue(framebuffer, { Shape::CIRCLE, x, y, 0.0f, 0.0f, color_fill });
+}
 
-  nvgEndFrame(m_vg);
+/* Queue line to draw with nanovg to fbo (i.e. to image texture) */
+void ImageVG::draw_line(const Framebuffer& framebuffer, float x1, float y1, float x2, float y2) {
+  PROFILE_ZONE("ImageVG::draw_line");
+  NVGcolor color_stroke = { Color::stroke.x, Color::stroke.y, Color::stroke.z, 1.0f - Color::stroke.w };
+  queue(framebuffer, { Shape::LINE, x1, y1, x2, y2, color_stroke });
+}
 
-  // detach framebuffer
-  framebuffer.unbind();
+/* Shapes queued for another fbo are drawn first */
+void ImageVG::queue(const Framebuffer& framebuffer, const Shape& shape) {
+  if (m_framebuffer != NULL && m_framebuffer != &framebuffer)
+    flush();
+
+  m_framebuffer = &framebuffer;
+  m_shapes.push_back(shape);
 }
 
-/* Draw line with nanovg to fbo (i.e. to image texture) */
-void ImageVG::draw_line(const Framebuffer& framebuffer, float x1, float y1, float x2, float y2) {
+/**
+ * Draw all queued shapes in one nanovg frame
+ * Called once per frame by canvas (fbo must still have the same texture attached as when shapes were queued)
+ */
+void ImageVG::flush() {
+  if (m_shapes.empty())
+    return;
+
+  PROFILE_ZONE("ImageVG::flush");
+  auto time_start = std::chrono::steady_clock::now();
+
+  GpuTimer::get().begin("nanovg");
+
   // append to framebuffer's attached color buffer
-  framebuffer.bind();
+  m_framebuffer->bind();
 
   // same size `nvgBeginFrame()` as `glViewport()`/texture to avoid stretching drawn shapes
   float pixel_ratio = 1.0f; // framebuffer (i.e. texture) & image have same size
-  nvgBeginFrame(m_vg, framebuffer.width, framebuffer.height, pixel_ratio);
+  nvgBeginFrame(m_vg, m_framebuffer->width, m_framebuffer->height, pixel_ratio);
 
-  // draw rectangle & circle on fbo's texture
-  nvgBeginPath(m_vg);
-  nvgMoveTo(m_vg, x1, y1);
-  nvgLineTo(m_vg, x2, y2);
-  NVGcolor color_stroke = { Color::stroke.x, Color::stroke.y, Color::stroke.z, 1.0f - Color::stroke.w };
-  nvgStrokeWidth(m_vg, 10.0f);
-  nvgStrokeColor(m_vg, color_stroke);
-  nvgStroke(m_vg);
+  for (const Shape& shape : m_shapes) {
+    nvgBeginPath(m_vg);
+
+    if (shape.type == Shape::CIRCLE) {
+      nvgCircle(m_vg, shape.x1, shape.y1, RADIUS_CIRCLE);
+      nvgFillColor(m_vg, shape.color);
+      nvgFill(m_vg);
+      nvgClosePath(m_vg);
+    } else {
+      nvgMoveTo(m_vg, shape.x1, shape.y1);
+      nvgLineTo(m_vg, shape.x2, shape.y2);
+      nvgStrokeWidth(m_vg, WIDTH_STROKE);
+      nvgStrokeColor(m_vg, shape.color);
+      nvgStroke(m_vg);
+    }
+  }
 
   nvgEndFrame(m_vg);
 
   // detach framebuffer
-  framebuffer.unbind();
+  m_framebuffer->unbind();
+  GpuTimer::get().end("nanovg");
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - time_start;
+  m_stats.n_flushes++;
+  m_stats.n_shapes += m_shapes.size();
+  m_stats.n_shapes_last_flush = m_shapes.size();
+  m_stats.duration_last_flush = duration.count();
+
+  m_shapes.clear();
+  m_framebuffer = NULL;
+}
+
+const ImageVG::Stats& ImageVG::get_stats() const {
+  return m_stats;
 }
 
-/* free nanovg context */
+/* Drop queued shapes (nanovg context freed with other shared resources) */
 void ImageVG::free() {
-  nvgDeleteGL3(m_vg);
+  m_shapes.clear();
+  m_framebuffer = NULL;
 }
@@ -0,0 +1,62 @@
+#include <algorithm>
+
+#include "image/image_view.hpp"
+
+ImageView::ImageView():
+  data(NULL),
+  width(0),
+  height(0),
+  n_channels(0),
+  stride(0)
+{
+}
+
+/**
+ * @param d Pixel of upper-left corner
+ * @param s Bytes between two consecutive rows (0 for contiguous rows)
+ */
+ImageView::ImageView(unsigned char* d, int w, int h, int n, size_t s):
+  data(d),
+  width(w),
+  height(h),
+  n_channels(n),
+  stride(s == 0 ? (size_t) w * n : s)
+{
+}
+
+/* View on all pixels of image (image keeps ownership) */
+ImageView::ImageView(const Image& image):
+  ImageView(image.data, image.width, image.height, image.n_channels)
+{
+}
+
+unsigned char* ImageView::get_row(int i_row) const {
+  return data + i_row * stride;
+}
+
+/**
+ * View on region of this view (clamped to its bounds), sharing its pixels
+ * @param x,y Upper-left corner of region rel. to view
+ */
+ImageView ImageView::crop(int x, int y, int w, int h) const {
+  x = std::clamp(x, 0, width);
+  y = std::clamp(y, 0, height);
+  w = std::clamp(w, 0, width - x);
+  h = std::clamp(h, 0, height - y);
+
+  return ImageView(get_row(y) + (size_t) x * n_channels, w, h, n_channels, stride);
+}
+
+/* Whether rows follow each other without gaps (e.g. to save/copy pixels at once) */
+bool ImageView::is_contiguous() const {
+  return stride == get_n_bytes_row();
+}
+
+size_t ImageView::get_n_bytes_row() const {
+  return (size_t) width * n_channels;
+}
+
+/* Bytes needed to store view's pixels contiguously */
+size_t ImageView::get_n_bytes() const {
+  return get_n_bytes_row() * height;
+}
@@ -0,0 +1,28 @@
+#include "image/integral_image.hpp"
+
+IntegralImage::IntegralImage():
+  width(0),
+  height(0),
+  sums(),
+  sums_squared()
+{
+}
+
+/* Sum of table over rectangle (must lie inside image) */
+uint64_t IntegralImage::get_sum(const std::vector<uint64_t>& table, int x, int y, int w, int h) const {
+  size_t n_columns = width + 1;
+  return table[(y + h) * n_columns + (x + w)] - table[y * n_columns + (x + w)] -
+         table[(y + h) * n_columns + x] + table[y * n_columns + x];
+}
+
+/* Mean of pixels in rectangle (origin at first row) */
+double IntegralImage::get_mean(int x, int y, int w, int h) const {
+  return (double) get_sum(sums, x, y, w, h) / ((double) w * h);
+}
+
+/* Population variance of pixels in rectangle, as mean of squares minus square of mean */
+double IntegralImage::get_variance(int x, int y, int w, int h) const {
+  double mean = get_mean(x, y, w, h);
+  double variance = (double) get_sum(sums_squared, x, y, w, h) / ((double) w * h) - mean * mean;
+  return variance > 0.0 ? variance : 0.0;
+}
@@ -0,0 +1,52 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "image/mapped_file.hpp"
+
+/* Map file at `path` (check `is_mapped()`, e.g. file missing or empty) */
+MappedFile::MappedFile(const std::string& path):
+  m_data(NULL),
+  m_size(0)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return;
+
+  struct stat stats;
+  if (fstat(fd, &stats) == 0 && stats.st_size > 0) {
+    void* data = mmap(NULL, stats.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      m_data = (unsigned char*) data;
+      m_size = stats.st_size;
+
+      // decoders read compressed data front to back, so kernel can read ahead aggressively
+      madvise(m_data, m_size, MADV_SEQUENTIAL);
+    }
+  }
+
+  // mapping stays valid once file descriptor closed
+  close(fd);
+}
+
+bool MappedFile::is_mapped() const {
+  return m_data != NULL;
+}
+
+const unsigned char* MappedFile::get_data() const {
+  return m_data;
+}
+
+size_t MappedFile::get_size() const {
+  return m_size;
+}
+
+void MappedFile::free() {
+  if (m_data == NULL)
+    return;
+
+  munmap(m_data, m_size);
+  m_data = NULL;
+  m_size = 0;
+}
@@ -0,0 +1,219 @@
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+#include <zlib.h>
+
+#include "image/png_writer.hpp"
+#include "image/image_utils.hpp"
+
+namespace {
+  /* compressed bytes of a group & their checksums */
+  struct Group {
+    int i_row_begin;
+    int i_row_end;
+    std::vector<unsigned char> data;
+    uLong adler;
+    uLong n_bytes_filtered;
+    bool is_valid;
+  };
+
+  void write_u32(unsigned char* bytes, uint32_t value) {
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+  }
+
+  /* Chunk: length, type, data & crc-32 of type & data */
+  bool write_chunk(FILE* file, const char* type, const unsigned char* data, size_t n_bytes) {
+    unsigned char header[8];
+    write_u32(header, n_bytes);
+    std::memcpy(header + 4, type, 4);
+
+    uLong crc = crc32(0L, (const Bytef*) type, 4);
+    if (n_bytes > 0)
+      crc = crc32(crc, data, n_bytes);
+    unsigned char footer[4];
+    write_u32(footer, crc);
+
+    return std::fwrite(header, 1, 8, file) == 8 && (n_bytes == 0 || std::fwrite(data, 1, n_bytes, file) == n_bytes) &&
+           std::fwrite(footer, 1, 4, file) == 4;
+  }
+
+  unsigned char paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+  }
+
+  /* Filter type byte followed by row filtered with it (bytes of pixel left of first one & of row above first row are 0) */
+  void apply_filter(int filter, const unsigned char* row, const unsigned char* row_above, size_t n_bytes_row,
+                    int n_channels, unsigned char* out) {
+    out[0] = filter;
+    unsigned char* out_row = out + 1;
+    size_t n_bytes_left = std::min<size_t>(n_channels, n_bytes_row);
+
+    switch (filter) {
+      case 0:
+        std::memcpy(out_row, row, n_bytes_row);
+        break;
+      case 1:
+        std::memcpy(out_row, row, n_bytes_left);
+        for (size_t i = n_bytes_left; i < n_bytes_row; i++)
+          out_row[i] = row[i] - row[i - n_channels];
+        break;
+      case 2:
+        for (size_t i = 0; i < n_bytes_row; i++)
+          out_row[i] = row[i] - row_above[i];
+        break;
+      case 3:
+        for (size_t i = 0; i < n_bytes_left; i++)
+          out_row[i] = row[i] - row_above[i] / 2;
+        for (size_t i = n_bytes_left; i < n_bytes_row; i++)
+          out_row[i] = row[i] - (row[i - n_channels] + row_above[i]) / 2;
+        break;
+      default:
+        for (size_t i = 0; i < n_bytes_left; i++)
+          out_row[i] = row[i] - row_above[i];
+        for (size_t i = n_bytes_left; i < n_bytes_row; i++)
+          out_row[i] = row[i] - paeth(row[i - n_channels], row_above[i], row_above[i - n_channels]);
+    }
+  }
+
+  /* Filtered bytes as signed values, small for rows that compress well (libpng's heuristic) */
+  unsigned long get_cost(const unsigned char* out, size_t n_bytes_row) {
+    unsigned long sum = 0;
+    for (size_t i = 1; i <= n_bytes_row; i++)
+      sum += out[i] < 128 ? out[i] : 256 - out[i];
+
+    return sum;
+  }
+
+  /* Fast levels always use sub filter, others pick the cheapest of the 5 filters for each row */
+  void filter_row(const unsigned char* row, const unsigned char* row_above, size_t n_bytes_row, int n_channels,
+                  int level, std::vector<unsigned char>& candidate, unsigned char* out) {
+    if (level <= 3) {
+      apply_filter(1, row, row_above, n_bytes_row, n_channels, out);
+      return;
+    }
+
+    apply_filter(0, row, row_above, n_bytes_row, n_channels, out);
+    unsigned long cost_best = get_cost(out, n_bytes_row);
+    for (int filter = 1; filter <= 4; filter++) {
+      apply_filter(filter, row, row_above, n_bytes_row, n_channels, candidate.data());
+      unsigned long cost = get_cost(candidate.data(), n_bytes_row);
+      if (cost < cost_best) {
+        cost_best = cost;
+        std::memcpy(out, candidate.data(), n_bytes_row + 1);
+      }
+    }
+  }
+
+  /**
+   * Filter & deflate rows of group (plus enough preceding rows to prime the window with their filtered bytes)
+   * Rle strategy at fastest levels (runs & repeated pixels found at a fraction of the cost)
+   */
+  void deflate_group(const Image& image, int level, bool is_last, Group& group) {
+    size_t n_bytes_row = (size_t) image.width * image.n_channels;
+    size_t n_bytes_filtered = n_bytes_row + 1;
+    int n_rows_window = std::min<int>(group.i_row_begin, (PngWriter::N_BYTES_WINDOW + n_bytes_filtered - 1) / n_bytes_filtered);
+    int i_row_first = group.i_row_begin - n_rows_window;
+
+    std::vector<unsigned char> filtered((size_t) (group.i_row_end - i_row_first) * n_bytes_filtered);
+    std::vector<unsigned char> candidate(n_bytes_filtered);
+    std::vector<unsigned char> zeros(i_row_first == 0 ? n_bytes_row : 0, 0);
+    for (int i_row = i_row_first; i_row < group.i_row_end; i_row++) {
+      const unsigned char* row = image.data + n_bytes_row * i_row;
+      const unsigned char* row_above = i_row > 0 ? row - n_bytes_row : zeros.data();
+      filter_row(row, row_above, n_bytes_row, image.n_channels, level, candidate,
+                 filtered.data() + (i_row - i_row_first) * n_bytes_filtered);
+    }
+
+    z_stream stream = {};
+    int strategy = level <= 1 ? Z_RLE : Z_FILTERED;
+    if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, strategy) != Z_OK) {
+      group.is_valid = false;
+      return;
+    }
+
+    size_t n_bytes_window = (size_t) n_rows_window * n_bytes_filtered;
+    size_t n_bytes_dictionary = std::min(n_bytes_window, PngWriter::N_BYTES_WINDOW);
+    if (n_bytes_dictionary > 0)
+      deflateSetDictionary(&stream, filtered.data() + n_bytes_window - n_bytes_dictionary, n_bytes_dictionary);
+
+    // sync flush ends group on a byte boundary without a final block, so next group's stream can follow it
+    uLong n_bytes = filtered.size() - n_bytes_window;
+    group.data.resize(deflateBound(&stream, n_bytes) + 16);
+    stream.next_in = filtered.data() + n_bytes_window;
+    stream.avail_in = n_bytes;
+    stream.next_out = group.data.data();
+    stream.avail_out = group.data.size();
+    int status = deflate(&stream, is_last ? Z_FINISH : Z_SYNC_FLUSH);
+    group.is_valid = is_last ? status == Z_STREAM_END : status == Z_OK && stream.avail_in == 0;
+    group.data.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    group.adler = adler32(1L, filtered.data() + n_bytes_window, n_bytes);
+    group.n_bytes_filtered = n_bytes;
+  }
+}
+
+/**
+ * Encode 8-bit image (1 to 4 channels) as png
+ * @param level Zlib level: 0 (stored) to 9 (smallest), 1 is fastest (sub filter & rle), >3 picks filters per row
+ * @return false if image is empty (png needs at least one pixel), or compression or writing failed
+ */
+bool PngWriter::write(const Image& image, FILE* file, int level) {
+  if (image.width <= 0 || image.height <= 0 || image.n_channels < 1 || image.n_channels > 4)
+    return false;
+
+  level = std::clamp(level, 0, 9);
+  size_t n_bytes_filtered = (size_t) image.width * image.n_channels + 1;
+  int n_rows_group = std::max<int>(1, N_BYTES_GROUP / n_bytes_filtered);
+  int n_groups = (image.height + n_rows_group - 1) / n_rows_group;
+
+  std::vector<Group> groups(n_groups);
+  for (int i_group = 0; i_group < n_groups; i_group++) {
+    groups[i_group].i_row_begin = i_group * n_rows_group;
+    groups[i_group].i_row_end = std::min((i_group + 1) * n_rows_group, image.height);
+  }
+
+  ImageUtils::parallel_for(n_groups, 1, [&](int i_group_begin, int i_group_end) {
+    for (int i_group = i_group_begin; i_group < i_group_end; i_group++)
+      deflate_group(image, level, i_group == n_groups - 1, groups[i_group]);
+  });
+
+  if (!std::all_of(groups.begin(), groups.end(), [](const Group& group) { return group.is_valid; }))
+    return false;
+
+  // checksum of whole stream from the ones of its groups
+  uLong adler = groups[0].adler;
+  for (int i_group = 1; i_group < n_groups; i_group++)
+    adler = adler32_combine(adler, groups[i_group].adler, groups[i_group].n_bytes_filtered);
+
+  const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  const unsigned char COLOR_TYPES[] = { 0, 4, 2, 6 };
+  unsigned char header[13] = {};
+  write_u32(header, image.width);
+  write_u32(header + 4, image.height);
+  header[8] = 8;
+  header[9] = COLOR_TYPES[image.n_channels - 1];
+  if (std::fwrite(SIGNATURE, 1, 8, file) != 8 || !write_chunk(file, "IHDR", header, sizeof(header)))
+    return false;
+
+  // zlib header (deflate, 32KB window) & adler-32 trailer in chunks of their own
+  const unsigned char HEADER_ZLIB[2] = { 0x78, 0x01 };
+  unsigned char trailer[4];
+  write_u32(trailer, adler);
+  if (!write_chunk(file, "IDAT", HEADER_ZLIB, 2))
+    return false;
+
+  for (const Group& group : groups) {
+    if (!write_chunk(file, "IDAT", group.data.data(), group.data.size()))
+      return false;
+  }
+
+  return write_chunk(file, "IDAT", trailer, 4) && write_chunk(file, "IEND", NULL, 0);
+}
@@ -0,0 +1,358 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#include <zlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "image/pyramid_file.hpp"
+#include "image/image_view.hpp"
+#include "image/image_utils.hpp"
+
+namespace {
+  void write_u32(unsigned char* bytes, uint32_t value) {
+    for (int i_byte = 0; i_byte < 4; i_byte++)
+      bytes[i_byte] = value >> (8 * i_byte);
+  }
+
+  void write_u64(unsigned char* bytes, uint64_t value) {
+    write_u32(bytes, value);
+    write_u32(bytes + 4, value >> 32);
+  }
+
+  uint32_t read_u32(const unsigned char* bytes) {
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+  }
+
+  uint64_t read_u64(const unsigned char* bytes) {
+    return read_u32(bytes) | ((uint64_t) read_u32(bytes + 4) << 32);
+  }
+
+  /* Pyramids of images opened in tiles, next to blocks of read-only images */
+  std::filesystem::path get_dir_cache() {
+    const char* dir_xdg = std::getenv("XDG_CACHE_HOME");
+    const char* dir_home = std::getenv("HOME");
+    std::filesystem::path dir = (dir_xdg && *dir_xdg) ? std::filesystem::path(dir_xdg) :
+                                (dir_home && *dir_home) ? std::filesystem::path(dir_home) / ".cache" : ".cache";
+
+    return dir / "imgui-example" / "pyramids";
+  }
+}
+
+/* static members definition (avoids linking error) & initialization */
+size_t PyramidFile::budget_cache = (size_t) 8 * 1024 * 1024 * 1024;
+
+PyramidFile::PyramidFile():
+  m_fd(-1),
+  m_data(NULL),
+  m_n_bytes(0),
+  m_width(0),
+  m_height(0),
+  m_n_channels(0),
+  m_levels(),
+  m_entries()
+{
+}
+
+/* Levels from full resolution, halved (rounded up) until image fits in one tile */
+std::vector<PyramidFile::Level> PyramidFile::get_levels(int width, int height) {
+  std::vector<Level> levels;
+  size_t n_tiles = 0;
+  while (true) {
+    int n_tiles_x = (width + SIZE_TILE - 1) / SIZE_TILE;
+    int n_tiles_y = (height + SIZE_TILE - 1) / SIZE_TILE;
+    levels.push_back({ width, height, n_tiles_x, n_tiles_y, n_tiles });
+    n_tiles += (size_t) n_tiles_x * n_tiles_y;
+    if (n_tiles_x == 1 && n_tiles_y == 1)
+      break;
+
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+  }
+
+  return levels;
+}
+
+/**
+ * Map file & read its index (tiles themselves aren't touched)
+ * @return false if file is missing, truncated, or not a pyramid (or no `mmap()` on this platform)
+ */
+bool PyramidFile::open(const std::string& path) {
+#ifdef _WIN32
+  return false;
+#else
+  free();
+  m_fd = ::open(path.c_str(), O_RDONLY);
+  struct stat info;
+  if (m_fd < 0 || fstat(m_fd, &info) != 0 || (size_t) info.st_size < N_BYTES_HEADER) {
+    free();
+    return false;
+  }
+
+  m_n_bytes = info.st_size;
+  void* data = mmap(NULL, m_n_bytes, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED) {
+    m_n_bytes = 0;
+    free();
+    return false;
+  }
+  m_data = (unsigned char*) data;
+
+  const unsigned char* header = m_data + sizeof(MAGIC);
+  m_width = read_u32(header);
+  m_height = read_u32(header + 4);
+  m_n_channels = read_u32(header + 8);
+  int size_tile = read_u32(header + 12);
+  int n_levels = read_u32(header + 16);
+  if (std::memcmp(m_data, MAGIC, sizeof(MAGIC)) != 0 || m_width <= 0 || m_height <= 0 || m_n_channels < 1 ||
+      m_n_channels > 4 || size_tile != SIZE_TILE) {
+    free();
+    return false;
+  }
+
+  m_levels = get_levels(m_width, m_height);
+  size_t n_tiles = m_levels.back().i_tile_first + 1;
+  if ((int) m_levels.size() != n_levels || m_n_bytes < N_BYTES_HEADER + n_tiles * N_BYTES_ENTRY) {
+    free();
+    return false;
+  }
+
+  // tiles pointing outside of file rejected now, so reads don't need to check
+  m_entries.resize(n_tiles);
+  for (size_t i_tile = 0; i_tile < n_tiles; i_tile++) {
+    const unsigned char* entry = m_data + N_BYTES_HEADER + i_tile * N_BYTES_ENTRY;
+    m_entries[i_tile] = { read_u64(entry), read_u32(entry + 8) };
+    if (m_entries[i_tile].offset + m_entries[i_tile].n_bytes > m_n_bytes) {
+      free();
+      return false;
+    }
+  }
+
+  // tiles read in no particular order (those of visible region)
+  madvise(m_data, m_n_bytes, MADV_RANDOM);
+  return true;
+#endif
+}
+
+/**
+ * Decode a tile (thread-safe)
+ * @param data Receives tile's rows (`width * n_channels` bytes each, tiles on right/bottom borders are smaller)
+ * @return false if tile is corrupted
+ */
+bool PyramidFile::read_tile(int level, int i_tile_x, int i_tile_y, unsigned char* data) const {
+  const Level& info = m_levels[level];
+  const Entry& entry = m_entries[info.i_tile_first + (size_t) i_tile_y * info.n_tiles_x + i_tile_x];
+  int width = std::min(SIZE_TILE, info.width - i_tile_x * SIZE_TILE);
+  int height = std::min(SIZE_TILE, info.height - i_tile_y * SIZE_TILE);
+  uLongf n_bytes = (uLongf) width * height * m_n_channels;
+
+  if (entry.n_bytes == n_bytes) {
+    std::memcpy(data, m_data + entry.offset, n_bytes);
+    return true;
+  }
+
+  uLongf n_bytes_out = n_bytes;
+  return uncompress(data, &n_bytes_out, m_data + entry.offset, entry.n_bytes) == Z_OK && n_bytes_out == n_bytes;
+}
+
+int PyramidFile::get_width() const {
+  return m_width;
+}
+
+int PyramidFile::get_height() const {
+  return m_height;
+}
+
+int PyramidFile::get_n_channels() const {
+  return m_n_channels;
+}
+
+int PyramidFile::get_n_levels() const {
+  return m_levels.size();
+}
+
+const PyramidFile::Level& PyramidFile::get_level(int level) const {
+  return m_levels[level];
+}
+
+void PyramidFile::free() {
+#ifndef _WIN32
+  if (m_data != NULL)
+    munmap(m_data, m_n_bytes);
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+
+  m_fd = -1;
+  m_data = NULL;
+  m_n_bytes = 0;
+  m_levels.clear();
+  m_entries.clear();
+}
+
+/**
+ * Build pyramid of 8-bit image & write it (levels downscaled & tiles deflated in parallel, one level in memory at a time)
+ * @param level_zlib Compression level of tiles (fast levels are enough: tiles are mostly read, rarely written)
+ * @return false if file couldn't be written (partial file removed)
+ */
+bool PyramidFile::write(const Image& image, const std::string& path, int level_zlib) {
+  if (image.data == NULL || image.n_channels < 1 || image.n_channels > 4)
+    return false;
+
+  // written under a temporary name, so a reader never sees a partial file (e.g. cache of an aborted open)
+  std::string path_tmp = path + ".tmp";
+  FILE* file = std::fopen(path_tmp.c_str(), "wb");
+  if (file == NULL)
+    return false;
+
+  // index written once offsets of all tiles are known
+  std::vector<Level> levels = get_levels(image.width, image.height);
+  size_t n_tiles = levels.back().i_tile_first + 1;
+  std::vector<unsigned char> header(N_BYTES_HEADER + n_tiles * N_BYTES_ENTRY, 0);
+  std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+  write_u32(header.data() + sizeof(MAGIC), image.width);
+  write_u32(header.data() + sizeof(MAGIC) + 4, image.height);
+  write_u32(header.data() + sizeof(MAGIC) + 8, image.n_channels);
+  write_u32(header.data() + sizeof(MAGIC) + 12, SIZE_TILE);
+  write_u32(header.data() + sizeof(MAGIC) + 16, levels.size());
+  bool is_written = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+  uint64_t offset = header.size();
+
+  ImageView view(image);
+  std::vector<unsigned char> data_level;
+  for (size_t i_level = 0; i_level < levels.size() && is_written; i_level++) {
+    const Level& level = levels[i_level];
+    if (i_level > 0) {
+      std::vector<unsigned char> data_next((size_t) level.width * level.height * image.n_channels);
+      view = ImageUtils::downscale(view, 2, data_next.data());
+      data_level = std::move(data_next);
+    }
+
+    int n_tiles_level = level.n_tiles_x * level.n_tiles_y;
+    std::vector<std::vector<unsigned char>> tiles(n_tiles_level);
+    ImageUtils::parallel_for(n_tiles_level, 1, [&](int i_tile_begin, int i_tile_end) {
+      std::vector<unsigned char> pixels;
+      for (int i_tile = i_tile_begin; i_tile < i_tile_end; i_tile++) {
+        int x = (i_tile % level.n_tiles_x) * SIZE_TILE, y = (i_tile / level.n_tiles_x) * SIZE_TILE;
+        ImageView view_tile = view.crop(x, y, std::min(SIZE_TILE, level.width - x), std::min(SIZE_TILE, level.height - y));
+        size_t n_bytes_row = view_tile.get_n_bytes_row();
+        pixels.resize(n_bytes_row * view_tile.height);
+        for (int i_row = 0; i_row < view_tile.height; i_row++)
+          std::memcpy(pixels.data() + i_row * n_bytes_row, view_tile.get_row(i_row), n_bytes_row);
+
+        // incompressible tile (e.g. noise) stored as is
+        std::vector<unsigned char>& tile = tiles[i_tile];
+        uLongf n_bytes = compressBound(pixels.size());
+        tile.resize(n_bytes);
+        if (compress2(tile.data(), &n_bytes, pixels.data(), pixels.size(), level_zlib) != Z_OK || n_bytes >= pixels.size())
+          tile = pixels;
+        else
+          tile.resize(n_bytes);
+      }
+    });
+
+    for (int i_tile = 0; i_tile < n_tiles_level && is_written; i_tile++) {
+      unsigned char* entry = header.data() + N_BYTES_HEADER + (level.i_tile_first + i_tile) * N_BYTES_ENTRY;
+      write_u64(entry, offset);
+      write_u32(entry + 8, tiles[i_tile].size());
+      is_written = std::fwrite(tiles[i_tile].data(), 1, tiles[i_tile].size(), file) == tiles[i_tile].size();
+      offset += tiles[i_tile].size();
+    }
+  }
+
+  is_written = is_written && std::fseek(file, 0, SEEK_SET) == 0 &&
+               std::fwrite(header.data(), 1, header.size(), file) == header.size();
+  is_written = std::fclose(file) == 0 && is_written;
+
+  std::error_code error;
+  if (is_written)
+    std::filesystem::rename(path_tmp, path, error);
+  if (!is_written || error)
+    std::remove(path_tmp.c_str());
+
+  return is_written && !error;
+}
+
+/* Whether path has extension ".pyr" (opened lazily instead of decoded) */
+bool PyramidFile::is_pyramid(const std::string& path) {
+  std::string extension = std::filesystem::path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+  return extension == ".pyr";
+}
+
+/**
+ * Cache file of image's pyramid, written on first open of an image too large for a texture (reopened from it)
+ * Named after hash of absolute path, size & modification time (empty if image is missing)
+ */
+std::string PyramidFile::get_path_cache(const std::string& path_image) {
+  std::error_code error;
+  std::filesystem::path path = std::filesystem::absolute(path_image, error);
+  uintmax_t size = std::filesystem::file_size(path, error);
+  auto time_modified = std::filesystem::last_write_time(path, error);
+  if (error)
+    return "";
+
+  std::stringstream stream;
+  stream << std::string(MAGIC, sizeof(MAGIC)) << '|' << path.string() << '|' << size << '|'
+         << time_modified.time_since_epoch().count();
+
+  std::stringstream name;
+  name << std::hex << std::hash<std::string>()(stream.str()) << ".pyr";
+  std::filesystem::create_directories(get_dir_cache(), error);
+  return (get_dir_cache() / name.str()).string();
+}
+
+/**
+ * Mark cached pyramid as most recently used (modification time set to now) & evict least recently used others
+ * while cache exceeds `budget_cache` (mapped ones stay readable by their documents until they're closed)
+ * Called once a cached pyramid is opened or written (errors ignored, e.g. file removed by another open meanwhile)
+ */
+void PyramidFile::use_cache(const std::string& path) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+
+  struct File {
+    fs::path path;
+    fs::file_time_type time_used;
+    uintmax_t n_bytes;
+  };
+
+  std::vector<File> files;
+  uintmax_t n_bytes_total = 0;
+  for (const fs::directory_entry& entry : fs::directory_iterator(get_dir_cache(), error)) {
+    std::error_code error_entry;
+    if (entry.path().extension() != ".pyr" || !entry.is_regular_file(error_entry))
+      continue;
+
+    File file = { entry.path(), entry.last_write_time(error_entry), entry.file_size(error_entry) };
+    if (error_entry)
+      continue;
+
+    n_bytes_total += file.n_bytes;
+    if (!fs::equivalent(file.path, path, error_entry))
+      files.push_back(file);
+  }
+
+  std::sort(files.begin(), files.end(), [](const File& file1, const File& file2) {
+    return file1.time_used < file2.time_used;
+  });
+
+  for (const File& file : files) {
+    if (n_bytes_total <= budget_cache)
+      break;
+
+    if (fs::remove(file.path, error))
+      n_bytes_total -= file.n_bytes;
+  }
+}
@@ -0,0 +1,265 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "image/raw_writer.hpp"
+
+namespace {
+  /* tiff field types */
+  const uint16_t TYPE_SHORT = 3;
+  const uint16_t TYPE_LONG = 4;
+
+  /* pixels start at an offset multiple of this (aligned copies into mapped file) */
+  const size_t ALIGNMENT_PIXELS = 16;
+
+  void write_u16(std::vector<unsigned char>& bytes, uint16_t value) {
+    bytes.push_back(value);
+    bytes.push_back(value >> 8);
+  }
+
+  void write_u32(std::vector<unsigned char>& bytes, uint32_t value) {
+    write_u16(bytes, value);
+    write_u16(bytes, value >> 16);
+  }
+
+  /* Ifd entry with a single value (shorts left-justified in 4-byte value field) */
+  void write_entry(std::vector<unsigned char>& bytes, uint16_t tag, uint16_t type, uint32_t count, uint32_t value) {
+    write_u16(bytes, tag);
+    write_u16(bytes, type);
+    write_u32(bytes, count);
+    if (type == TYPE_SHORT && count == 1) {
+      write_u16(bytes, value);
+      write_u16(bytes, 0);
+    } else {
+      write_u32(bytes, value);
+    }
+  }
+
+  /**
+   * Little-endian baseline tiff header: one ifd describing a single uncompressed strip (8 bits per sample),
+   * followed by bits-per-sample array (when it doesn't fit in its entry) & padding up to pixels
+   * Empty if pixels exceed 4GB (offsets are 32-bit)
+   */
+  std::vector<unsigned char> get_header_tiff(int width, int height, int n_channels) {
+    size_t n_bytes_pixels = (size_t) width * height * n_channels;
+    if (n_bytes_pixels > UINT32_MAX - 1024)
+      return {};
+
+    bool has_alpha = n_channels == 2 || n_channels == 4;
+    uint16_t n_entries = has_alpha ? 11 : 10;
+    size_t offset_bits = 8 + 2 + 12 * n_entries + 4;
+    size_t offset_pixels = offset_bits + (n_channels > 2 ? 2 * n_channels : 0);
+    offset_pixels = (offset_pixels + ALIGNMENT_PIXELS - 1) / ALIGNMENT_PIXELS * ALIGNMENT_PIXELS;
+
+    std::vector<unsigned char> bytes = { 'I', 'I', 42, 0 };
+    write_u32(bytes, 8);
+    write_u16(bytes, n_entries);
+
+    // entries sorted by tag
+    write_entry(bytes, 256, TYPE_LONG, 1, width);
+    write_entry(bytes, 257, TYPE_LONG, 1, height);
+    if (n_channels > 2) {
+      write_entry(bytes, 258, TYPE_SHORT, n_channels, offset_bits);
+    } else {
+      // two shorts fit in value field
+      write_u16(bytes, 258);
+      write_u16(bytes, TYPE_SHORT);
+      write_u32(bytes, n_channels);
+      write_u16(bytes, 8);
+      write_u16(bytes, n_channels == 2 ? 8 : 0);
+    }
+    write_entry(bytes, 259, TYPE_SHORT, 1, 1);
+    write_entry(bytes, 262, TYPE_SHORT, 1, n_channels >= 3 ? 2 : 1);
+    write_entry(bytes, 273, TYPE_LONG, 1, offset_pixels);
+    write_entry(bytes, 277, TYPE_SHORT, 1, n_channels);
+    write_entry(bytes, 278, TYPE_LONG, 1, height);
+    write_entry(bytes, 279, TYPE_LONG, 1, n_bytes_pixels);
+    write_entry(bytes, 284, TYPE_SHORT, 1, 1);
+
+    // unassociated alpha (not premultiplied)
+    if (has_alpha)
+      write_entry(bytes, 338, TYPE_SHORT, 1, 2);
+    write_u32(bytes, 0);
+
+    for (int i_channel = 0; i_channel < n_channels && n_channels > 2; i_channel++)
+      write_u16(bytes, 8);
+    bytes.resize(offset_pixels, 0);
+
+    return bytes;
+  }
+
+  /* Pixels with `n_channels_in` converted to `n_channels_out` (gray replicated to rgb, extra channels dropped) */
+  void convert(const unsigned char* in, unsigned char* out, size_t n_pixels, int n_channels_in, int n_channels_out) {
+    bool is_gray = n_channels_out == 1 || n_channels_in < 3;
+    for (size_t i_pixel = 0; i_pixel < n_pixels; i_pixel++) {
+      for (int i_channel = 0; i_channel < n_channels_out; i_channel++)
+        out[i_channel] = in[is_gray ? 0 : i_channel];
+
+      in += n_channels_in;
+      out += n_channels_out;
+    }
+  }
+}
+
+/* Format given by extension of path (".raw", ".ppm", ".pgm", ".tif" or ".tiff"), none for other formats */
+std::optional<RawWriter::Format> RawWriter::find_format(const std::string& path) {
+  std::string extension = std::filesystem::path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+  if (extension == ".raw")
+    return Format::RAW;
+  if (extension == ".ppm")
+    return Format::PPM;
+  if (extension == ".pgm")
+    return Format::PGM;
+  if (extension == ".tif" || extension == ".tiff")
+    return Format::TIFF;
+
+  return std::nullopt;
+}
+
+/* Channels written for an input with `n_channels` (raw & tiff keep them all) */
+int RawWriter::get_n_channels(Format format, int n_channels) {
+  switch (format) {
+    case Format::PPM:
+      return 3;
+    case Format::PGM:
+      return 1;
+    default:
+      return n_channels;
+  }
+}
+
+/**
+ * Bytes preceding pixels in file (none for raw)
+ * @param n_channels Channels written (see `get_n_channels()`)
+ * @return Empty for a tiff too large to be described (> 4GB)
+ */
+std::vector<unsigned char> RawWriter::get_header(Format format, int width, int height, int n_channels) {
+  switch (format) {
+    case Format::PPM:
+    case Format::PGM: {
+      std::string header = std::string(format == Format::PPM ? "P6" : "P5") + "\n" + std::to_string(width) + " " +
+                           std::to_string(height) + "\n255\n";
+      return std::vector<unsigned char>(header.begin(), header.end());
+    }
+    case Format::TIFF:
+      return get_header_tiff(width, height, n_channels);
+    default:
+      return {};
+  }
+}
+
+/**
+ * Write image with unbuffered writes: pixels in one call if channels match, otherwise converted by blocks of rows
+ * @return false if file couldn't be written (partial file removed)
+ */
+bool RawWriter::write(const Image& image, const std::string& path, Format format) {
+  int n_channels = get_n_channels(format, image.n_channels);
+  std::vector<unsigned char> header = get_header(format, image.width, image.height, n_channels);
+  if (header.empty() && format != Format::RAW)
+    return false;
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == NULL)
+    return false;
+
+  // no copy into stdio's buffer, large blocks handed to os directly
+  std::setvbuf(file, NULL, _IONBF, 0);
+  bool is_written = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+
+  if (n_channels == image.n_channels) {
+    size_t n_bytes = (size_t) image.width * image.height * n_channels;
+    is_written = is_written && std::fwrite(image.data, 1, n_bytes, file) == n_bytes;
+  } else {
+    size_t n_bytes_row = (size_t) image.width * n_channels;
+    int n_rows_block = std::max(1, (int) (N_BYTES_BLOCK / n_bytes_row));
+    std::vector<unsigned char> block(n_rows_block * n_bytes_row);
+
+    for (int y = 0; y < image.height && is_written; y += n_rows_block) {
+      int n_rows = std::min(n_rows_block, image.height - y);
+      convert(image.data + (size_t) y * image.width * image.n_channels, block.data(), (size_t) n_rows * image.width,
+              image.n_channels, n_channels);
+      is_written = std::fwrite(block.data(), 1, n_rows * n_bytes_row, file) == n_rows * n_bytes_row;
+    }
+  }
+
+  is_written = std::fclose(file) == 0 && is_written;
+  if (!is_written)
+    std::remove(path.c_str());
+
+  return is_written;
+}
+
+/**
+ * Create output file of its final size & map it in memory with header written (pages flushed to disk by os)
+ * @param n_channels Channels written (see `get_n_channels()`)
+ * @return false if file can't be created, allocated (e.g. disk full) or mapped (e.g. no `mmap()` on this platform)
+ */
+bool RawWriter::map(const std::string& path, Format format, int width, int height, int n_channels, Mapping& mapping) {
+#ifdef _WIN32
+  return false;
+#else
+  std::vector<unsigned char> header = get_header(format, width, height, n_channels);
+  if (header.empty() && format != Format::RAW)
+    return false;
+
+  mapping.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (mapping.fd < 0)
+    return false;
+
+  mapping.offset_pixels = header.size();
+  mapping.n_bytes = header.size() + (size_t) width * height * n_channels;
+  void* data = MAP_FAILED;
+
+  // blocks allocated before mapping, so a full disk fails the save here instead of raising SIGBUS on write
+#ifdef __APPLE__
+  bool is_allocated = ftruncate(mapping.fd, mapping.n_bytes) == 0;
+#else
+  bool is_allocated = posix_fallocate(mapping.fd, 0, mapping.n_bytes) == 0;
+#endif
+  if (is_allocated)
+    data = mmap(NULL, mapping.n_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mapping.fd, 0);
+
+  if (data == MAP_FAILED) {
+    close(mapping.fd);
+    std::remove(path.c_str());
+    return false;
+  }
+
+  // pages written front to back
+  madvise(data, mapping.n_bytes, MADV_SEQUENTIAL);
+  mapping.data = (unsigned char*) data;
+  std::memcpy(mapping.data, header.data(), header.size());
+  return true;
+#endif
+}
+
+/**
+ * Unmap & close file opened by `map()`
+ * @param is_written false if pixels couldn't be written (file removed)
+ */
+bool RawWriter::unmap(Mapping& mapping, const std::string& path, bool is_written) {
+#ifdef _WIN32
+  return false;
+#else
+  is_written = munmap(mapping.data, mapping.n_bytes) == 0 && is_written;
+  is_written = close(mapping.fd) == 0 && is_written;
+  mapping.data = NULL;
+  mapping.fd = -1;
+
+  if (!is_written)
+    std::remove(path.c_str());
+
+  return is_written;
+#endif
+}
@@ -0,0 +1,26 @@
+#include <cmath>
+#include <limits>
+
+#include "image/similarity.hpp"
+
+/* Peak signal-to-noise ratio for a peak value of 1 */
+double Similarity::get_psnr(double mse) {
+  if (mse <= 0.0)
+    return std::numeric_limits<double>::infinity();
+
+  return 10.0 * std::log10(1.0 / mse);
+}
+
+/**
+ * SSIM of a window from sums of its luma values (`a` in image, `b` in reference), their squares & products
+ * @return 1 for identical windows
+ */
+double Similarity::get_ssim(double n_pixels, double sum_a, double sum_b, double sum_aa, double sum_bb, double sum_ab) {
+  double mean_a = sum_a / n_pixels, mean_b = sum_b / n_pixels;
+  double variance_a = sum_aa / n_pixels - mean_a * mean_a;
+  double variance_b = sum_bb / n_pixels - mean_b * mean_b;
+  double covariance = sum_ab / n_pixels - mean_a * mean_b;
+
+  return ((2.0 * mean_a * mean_b + C1) * (2.0 * covariance + C2)) /
+         ((mean_a * mean_a + mean_b * mean_b + C1) * (variance_a + variance_b + C2));
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+
+#include "image/stroke_rasterizer.hpp"
+#include "image/image_utils.hpp"
+
+namespace {
+  /* coverage of pixel at signed distance `distance` inside an edge (antialiased over one pixel) */
+  inline float get_coverage(float distance) {
+    return std::clamp(distance + 0.5f, 0.0f, 1.0f);
+  }
+
+  /**
+   * Blend color over pixel with given coverage (premultiplied source-over as nanovg's gl backend)
+   * Single-channel views get red component (as a red-only texture drawn on by nanovg), 2nd/4th channel is alpha
+   */
+  inline void blend(unsigned char* pixel, int n_channels, const StrokeRasterizer::Rgba& color, float coverage) {
+    float alpha = color.a * coverage;
+    const float components[] = { color.r, color.g, color.b };
+    int n_colors = (n_channels == 2) ? 1 : std::min(n_channels, 3);
+    for (int i_channel = 0; i_channel < n_colors; i_channel++)
+      pixel[i_channel] = (unsigned char) std::lround(pixel[i_channel] + (255.0f * components[i_channel] - pixel[i_channel]) * alpha);
+
+    if (n_channels == 2 || n_channels == 4) {
+      unsigned char& pixel_alpha = pixel[n_channels - 1];
+      pixel_alpha = (unsigned char) std::lround(255.0f * alpha + pixel_alpha * (1.0f - alpha));
+    }
+  }
+}
+
+StrokeRasterizer::StrokeRasterizer():
+  color_stroke({ 0.0f, 0.0f, 0.0f, 1.0f }),
+  color_fill({ 1.0f, 1.0f, 1.0f, 1.0f }),
+  radius_circle(RADIUS_CIRCLE),
+  width_stroke(WIDTH_STROKE),
+  m_shapes(),
+  m_view(),
+  m_bins(),
+  m_stats { 0, 0, 0, 0, 0.0 }
+{
+}
+
+/* Queue filled circle centered on position (radius of `ImageVG`'s circles unless `radius_circle` was changed) */
+void StrokeRasterizer::draw_circle(const ImageView& view, float x, float y) {
+  queue(view, { Shape::CIRCLE, x, y, 0.0f, 0.0f, color_fill, radius_circle });
+}
+
+/* Queue stroked segment (butt caps, as nanovg's default) */
+void StrokeRasterizer::draw_line(const ImageView& view, float x1, float y1, float x2, float y2) {
+  queue(view, { Shape::LINE, x1, y1, x2, y2, color_stroke, width_stroke });
+}
+
+/* Shape moved to image pixels with its bounds, shapes queued for another view drawn first */
+void StrokeRasterizer::queue(const ImageView& view, Shape shape) {
+  if (m_view.data != NULL && m_view.data != view.data)
+    flush();
+
+  m_view = view;
+  shape.y1 = view.height - shape.y1;
+  shape.y2 = view.height - shape.y2;
+
+  // pixels touched by antialiased edge around shape
+  float margin = (shape.type == Shape::CIRCLE ? shape.size : shape.size / 2.0f) + 1.0f;
+  float x_max = shape.type == Shape::CIRCLE ? shape.x1 : std::max(shape.x1, shape.x2);
+  float y_max = shape.type == Shape::CIRCLE ? shape.y1 : std::max(shape.y1, shape.y2);
+  float bounds[] = { std::floor(std::min(shape.x1, x_max) - margin), std::floor(std::min(shape.y1, y_max) - margin),
+                     std::ceil(x_max + margin), std::ceil(y_max + margin) };
+  if (std::any_of(std::begin(bounds), std::end(bounds), [](float bound) { return std::isnan(bound); }))
+    return;
+
+  // clamped as floats (far-off or infinite shapes don't overflow ints)
+  shape.x_min = (int) std::clamp(bounds[0], 0.0f, (float) view.width);
+  shape.y_min = (int) std::clamp(bounds[1], 0.0f, (float) view.height);
+  shape.x_max = (int) std::clamp(bounds[2], 0.0f, (float) view.width);
+  shape.y_max = (int) std::clamp(bounds[3], 0.0f, (float) view.height);
+  if (shape.x_min < shape.x_max && shape.y_min < shape.y_max)
+    m_shapes.push_back(shape);
+}
+
+/**
+ * Draw shape over pixels of given region (coverage sampled at pixels centers)
+ * @param x_min,y_min,x_max,y_max Region of view (max. excluded), inside shape's bounds & a single tile
+ */
+void StrokeRasterizer::rasterize(const Shape& shape, int x_min, int y_min, int x_max, int y_max) const {
+  int n_channels = m_view.n_channels;
+  if (shape.type == Shape::CIRCLE) {
+    for (int y = y_min; y < y_max; y++) {
+      unsigned char* row = m_view.get_row(y);
+      float dy = y + 0.5f - shape.y1;
+      for (int x = x_min; x < x_max; x++) {
+        float dx = x + 0.5f - shape.x1;
+        float coverage = get_coverage(shape.size - std::sqrt(dx * dx + dy * dy));
+        if (coverage > 0.0f)
+          blend(row + x * n_channels, n_channels, shape.color, coverage);
+      }
+    }
+
+    return;
+  }
+
+  // distances along segment & across it (zero-length segments draw nothing, like nanovg strokes)
+  float dx = shape.x2 - shape.x1, dy = shape.y2 - shape.y1;
+  float length = std::sqrt(dx * dx + dy * dy);
+  if (length == 0.0f)
+    return;
+
+  float ux = dx / length, uy = dy / length;
+  for (int y = y_min; y < y_max; y++) {
+    unsigned char* row = m_view.get_row(y);
+    float py = y + 0.5f - shape.y1;
+    for (int x = x_min; x < x_max; x++) {
+      float px = x + 0.5f - shape.x1;
+      float along = px * ux + py * uy;
+      float across = std::abs(px * uy - py * ux);
+      float coverage = get_coverage(shape.size / 2.0f - across) * get_coverage(std::min(along, length - along));
+      if (coverage > 0.0f)
+        blend(row + x * n_channels, n_channels, shape.color, coverage);
+    }
+  }
+}
+
+/**
+ * Draw all queued shapes: each one listed in tiles its bounds overlap, then non-empty tiles drawn in parallel
+ * Tiles don't share pixels, so threads never write to the same pixel & each tile keeps shapes' order
+ */
+void StrokeRasterizer::flush() {
+  if (m_shapes.empty())
+    return;
+
+  auto time_start = std::chrono::steady_clock::now();
+  int n_tiles_x = (m_view.width + SIZE_TILE - 1) / SIZE_TILE;
+  int n_tiles_y = (m_view.height + SIZE_TILE - 1) / SIZE_TILE;
+  m_bins.resize((size_t) n_tiles_x * n_tiles_y);
+
+  std::vector<int> tiles;
+  for (int i_shape = 0; i_shape < (int) m_shapes.size(); i_shape++) {
+    const Shape& shape = m_shapes[i_shape];
+    for (int i_tile_y = shape.y_min / SIZE_TILE; i_tile_y <= (shape.y_max - 1) / SIZE_TILE; i_tile_y++) {
+      for (int i_tile_x = shape.x_min / SIZE_TILE; i_tile_x <= (shape.x_max - 1) / SIZE_TILE; i_tile_x++) {
+        int i_tile = i_tile_y * n_tiles_x + i_tile_x;
+        if (m_bins[i_tile].empty())
+          tiles.push_back(i_tile);
+        m_bins[i_tile].push_back(i_shape);
+      }
+    }
+  }
+
+  // tiles of different sizes (# of shapes), so one tile per chunk balances them across threads
+  ImageUtils::parallel_for(tiles.size(), 1, [&](int i_begin, int i_end) {
+    for (int i = i_begin; i < i_end; i++) {
+      int i_tile = tiles[i];
+      int x_tile = (i_tile % n_tiles_x) * SIZE_TILE, y_tile = (i_tile / n_tiles_x) * SIZE_TILE;
+      for (int i_shape : m_bins[i_tile]) {
+        const Shape& shape = m_shapes[i_shape];
+        rasterize(shape, std::max(shape.x_min, x_tile), std::max(shape.y_min, y_tile),
+                  std::min(shape.x_max, x_tile + SIZE_TILE), std::min(shape.y_max, y_tile + SIZE_TILE));
+      }
+    }
+  });
+
+  for (int i_tile : tiles)
+    m_bins[i_tile].clear();
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - time_start;
+  m_stats.n_flushes++;
+  m_stats.n_shapes += m_shapes.size();
+  m_stats.n_shapes_last_flush = m_shapes.size();
+  m_stats.n_tiles_last_flush = tiles.size();
+  m_stats.duration_last_flush = duration.count();
+
+  m_shapes.clear();
+  m_view = ImageView();
+}
+
+const StrokeRasterizer::Stats& StrokeRasterizer::get_stats() const {
+  return m_stats;
+}
+
+/* Drop queued shapes & storage of bins */
+void StrokeRasterizer::free() {
+  m_shapes.clear();
+  m_bins.clear();
+  m_view = ImageView();
+}
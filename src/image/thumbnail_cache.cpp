@@ -0,0 +1,206 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+
+#include "image.hpp"
+
+#include "image/thumbnail_cache.hpp"
+#include "image/image_decoder.hpp"
+#include "gpu/owned.hpp"
+
+namespace {
+  /* header of cached files followed by width, height & rgba pixels */
+  const char MAGIC[8] = { 'T', 'H', 'U', 'M', 'B', '0', '0', '1' };
+}
+
+/**
+ * @param height Height of thumbnails in pixels (width follows image's aspect ratio)
+ * @param n_threads Workers decoding images concurrently
+ */
+ThumbnailCache::ThumbnailCache(int height, int n_threads):
+  m_height(height),
+  m_dir_cache(get_dir_cache()),
+  m_generation(0)
+{
+  for (int i_thread = 0; i_thread < n_threads; i_thread++)
+    m_workers.push_back(std::make_unique<Worker>());
+
+  std::error_code error;
+  std::filesystem::create_directories(m_dir_cache, error);
+  if (error)
+    std::cout << "Thumbnails cache unavailable: " << error.message() << '\n';
+}
+
+/* `$XDG_CACHE_HOME` (or `~/.cache`) subfolder, local folder if neither is set */
+std::string ThumbnailCache::get_dir_cache() {
+  const char* dir_xdg = std::getenv("XDG_CACHE_HOME");
+  const char* dir_home = std::getenv("HOME");
+  std::filesystem::path dir = (dir_xdg && *dir_xdg) ? std::filesystem::path(dir_xdg) :
+                              (dir_home && *dir_home) ? std::filesystem::path(dir_home) / ".cache" : ".cache";
+
+  return (dir / "imgui-example" / "thumbnails").string();
+}
+
+/**
+ * Queue thumbnail on least busy worker
+ * @param callback Called on worker thread with the thumbnail
+ */
+void ThumbnailCache::request(const std::string& path, const Callback& callback) {
+  auto it = std::min_element(m_workers.begin(), m_workers.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs->get_n_pending() < rhs->get_n_pending();
+  });
+
+  unsigned int generation = m_generation;
+  (*it)->submit([this, path, callback, generation]() {
+    if (generation != m_generation) {
+      callback({ 0, 0, {} });
+      return;
+    }
+
+    callback(load(path));
+  });
+}
+
+/* Skip queued requests (e.g. dialog closed or folder changed) */
+void ThumbnailCache::cancel() {
+  m_generation++;
+}
+
+/* Thumbnail from disk cache, or decoded & downscaled then cached */
+Thumbnail ThumbnailCache::load(const std::string& path) const {
+  std::string path_cache = get_path_cache(path);
+  Thumbnail thumbnail;
+  if (!path_cache.empty() && read(path_cache, thumbnail))
+    return thumbnail;
+
+  // jpeg decoded directly at a fraction of its size (still larger than thumbnail)
+  Image decoded = ImageDecoder::decode(path, m_height);
+  if (decoded.data == NULL)
+    return { 0, 0, {} };
+
+  Owned<Image> image(decoded);
+  thumbnail = downscale(image->data, image->width, image->height, image->n_channels);
+  image.reset();
+
+  if (!path_cache.empty())
+    write(path_cache, thumbnail);
+
+  return thumbnail;
+}
+
+/* Cache file named after hash of path, modification time, size of file & thumbnails height (empty if file missing) */
+std::string ThumbnailCache::get_path_cache(const std::string& path) const {
+  std::error_code error;
+  auto time_modified = std::filesystem::last_write_time(path, error);
+  if (error)
+    return "";
+  auto size = std::filesystem::file_size(path, error);
+  if (error)
+    return "";
+
+  std::stringstream key;
+  key << std::filesystem::absolute(path).string() << '|' << time_modified.time_since_epoch().count() << '|'
+      << size << '|' << m_height;
+
+  std::stringstream name;
+  name << std::hex << std::hash<std::string>()(key.str()) << ".thumb";
+  return (std::filesystem::path(m_dir_cache) / name.str()).string();
+}
+
+/* Box filter (average of source pixels covered by each thumbnail pixel) & expansion to rgba */
+Thumbnail ThumbnailCache::downscale(const unsigned char* pixels, int width, int height, int n_channels) const {
+  Thumbnail thumbnail;
+  thumbnail.height = std::min(m_height, height);
+  thumbnail.width = std::clamp(width * thumbnail.height / height, 1, RATIO_MAX * thumbnail.height);
+  thumbnail.data.resize(thumbnail.width * thumbnail.height * 4);
+
+  for (int y = 0; y < thumbnail.height; y++) {
+    int y_begin = y * height / thumbnail.height;
+    int y_end = std::max((y + 1) * height / thumbnail.height, y_begin + 1);
+
+    for (int x = 0; x < thumbnail.width; x++) {
+      int x_begin = x * width / thumbnail.width;
+      int x_end = std::max((x + 1) * width / thumbnail.width, x_begin + 1);
+
+      uint64_t sums[4] = { 0, 0, 0, 0 };
+      for (int y_src = y_begin; y_src < y_end; y_src++) {
+        const unsigned char* row = pixels + (size_t) y_src * width * n_channels;
+        for (int x_src = x_begin; x_src < x_end; x_src++) {
+          for (int i_channel = 0; i_channel < n_channels; i_channel++)
+            sums[i_channel] += row[x_src * n_channels + i_channel];
+        }
+      }
+
+      int n_pixels = (y_end - y_begin) * (x_end - x_begin);
+      unsigned char average[4];
+      for (int i_channel = 0; i_channel < n_channels; i_channel++)
+        average[i_channel] = sums[i_channel] / n_pixels;
+
+      // gray (& alpha) replicated on rgb, opaque if no alpha
+      unsigned char* pixel = &thumbnail.data[(y * thumbnail.width + x) * 4];
+      bool is_gray = n_channels < 3;
+      pixel[0] = average[0];
+      pixel[1] = is_gray ? average[0] : average[1];
+      pixel[2] = is_gray ? average[0] : average[2];
+      pixel[3] = (n_channels == 2) ? average[1] : (n_channels == 4) ? average[3] : 255;
+    }
+  }
+
+  return thumbnail;
+}
+
+bool ThumbnailCache::read(const std::string& path_cache, Thumbnail& thumbnail) {
+  std::ifstream file(path_cache, std::ios::binary);
+  if (!file)
+    return false;
+
+  char magic[sizeof(MAGIC)];
+  int32_t size[2];
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char*>(size), sizeof(size));
+  if (!file || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || size[0] <= 0 || size[1] <= 0)
+    return false;
+
+  thumbnail.width = size[0];
+  thumbnail.height = size[1];
+  thumbnail.data.resize(thumbnail.width * thumbnail.height * 4);
+  file.read(reinterpret_cast<char*>(thumbnail.data.data()), thumbnail.data.size());
+
+  return static_cast<bool>(file);
+}
+
+/* Written to temporary file (unique per thread) then renamed, so concurrent readers never see a partial entry */
+bool ThumbnailCache::write(const std::string& path_cache, const Thumbnail& thumbnail) {
+  std::stringstream suffix;
+  suffix << ".tmp" << std::this_thread::get_id();
+  std::string path_tmp = path_cache + suffix.str();
+  {
+    std::ofstream file(path_tmp, std::ios::binary);
+    if (!file)
+      return false;
+
+    int32_t size[2] = { thumbnail.width, thumbnail.height };
+    file.write(MAGIC, sizeof(MAGIC));
+    file.write(reinterpret_cast<const char*>(size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(thumbnail.data.data()), thumbnail.data.size());
+    if (!file)
+      return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(path_tmp, path_cache, error);
+  return !error;
+}
+
+/* Wait for queued thumbnails then stop workers */
+void ThumbnailCache::free() {
+  cancel();
+  for (auto& worker : m_workers)
+    worker->free();
+}
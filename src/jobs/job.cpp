@@ -0,0 +1,37 @@
+#include "jobs/job.hpp"
+
+Job::Job(const std::string& label):
+  label(label),
+  status(JobStatus::QUEUED),
+  progress(-1.0f),
+  time_finished(-1.0),
+  time_queued(std::chrono::steady_clock::now()),
+  duration_waiting(-1.0f),
+  duration_running(-1.0f),
+  n_pixels(0)
+{
+}
+
+bool Job::is_finished() const {
+  return status == JobStatus::DONE || status == JobStatus::FAILED;
+}
+
+/* Status shown in ui */
+const char* Job::get_status_name() const {
+  switch (status) {
+    case JobStatus::QUEUED:
+      return "queued";
+    case JobStatus::READBACK:
+      return "reading from gpu";
+    case JobStatus::RUNNING:
+      return "running";
+    case JobStatus::UPLOAD:
+      return "uploading to gpu";
+    case JobStatus::DONE:
+      return "done";
+    case JobStatus::FAILED:
+      return "failed";
+  }
+
+  return "";
+}
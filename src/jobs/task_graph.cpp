@@ -0,0 +1,141 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+
+#include "jobs/task_graph.hpp"
+#include "profiling/tracer.hpp"
+
+TaskGraph::TaskGraph():
+  m_duration(0.0f)
+{
+}
+
+/**
+ * Append task (dependencies must have been added before, so graph can't have cycles)
+ * @param dependencies Names of tasks to wait for
+ */
+void TaskGraph::add(const std::string& name, const std::vector<std::string>& dependencies, TaskThread thread,
+                    const std::function<void()>& func) {
+  Task task = { name, {}, thread, func };
+  for (const std::string& dependency : dependencies) {
+    auto it = std::find_if(m_tasks.begin(), m_tasks.end(), [&](const Task& task) { return task.name == dependency; });
+    if (it == m_tasks.end())
+      throw std::invalid_argument("Unknown dependency " + dependency + " of task " + name);
+    task.dependencies.push_back(it - m_tasks.begin());
+  }
+
+  m_tasks.push_back(task);
+}
+
+/**
+ * Run all tasks & wait for them (main-thread tasks picked in order they were added once ready)
+ * Exception thrown by a task rethrown here after running tasks finish (tasks depending on it are skipped)
+ */
+void TaskGraph::run() {
+  using clock = std::chrono::steady_clock;
+  clock::time_point time_start = clock::now();
+  auto get_time = [&]() {
+    return std::chrono::duration<float, std::milli>(clock::now() - time_start).count();
+  };
+
+  size_t n_tasks = m_tasks.size();
+  std::vector<bool> is_started(n_tasks, false);
+  std::vector<bool> is_done(n_tasks, false);
+  m_timings.assign(n_tasks, {});
+  std::vector<std::thread> threads;
+  std::exception_ptr exception;
+  std::mutex mutex;
+  std::condition_variable condition;
+  size_t n_running = 0;
+
+  auto execute = [&](size_t i_task) {
+    const Task& task = m_tasks[i_task];
+    float time_task = get_time();
+    try {
+      PROFILE_ZONE(task.name.c_str());
+      task.func();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!exception)
+        exception = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    m_timings[i_task] = { task.name, task.thread, time_task, get_time() - time_task };
+    is_done[i_task] = true;
+    n_running--;
+    condition.notify_all();
+  };
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    // start worker tasks whose dependencies are done, find first ready main-thread task
+    size_t i_main = n_tasks;
+    bool has_pending = false;
+    for (size_t i_task = 0; i_task < n_tasks && !exception; i_task++) {
+      if (is_started[i_task])
+        continue;
+
+      has_pending = true;
+      const Task& task = m_tasks[i_task];
+      bool is_ready = std::all_of(task.dependencies.begin(), task.dependencies.end(), [&](size_t i) { return is_done[i]; });
+      if (!is_ready)
+        continue;
+
+      if (task.thread == TaskThread::WORKER) {
+        is_started[i_task] = true;
+        n_running++;
+        threads.push_back(std::thread(execute, i_task));
+      } else if (i_main == n_tasks) {
+        i_main = i_task;
+      }
+    }
+
+    if (i_main < n_tasks) {
+      is_started[i_main] = true;
+      n_running++;
+      lock.unlock();
+      execute(i_main);
+      lock.lock();
+      continue;
+    }
+
+    if (n_running == 0 && (!has_pending || exception))
+      break;
+
+    condition.wait(lock);
+  }
+  lock.unlock();
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  m_duration = get_time();
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+const std::vector<TaskGraph::Timing>& TaskGraph::get_timings() const {
+  return m_timings;
+}
+
+/* Wall-clock time of last run in ms (critical path & waits included) */
+float TaskGraph::get_duration() const {
+  return m_duration;
+}
+
+/* Start & duration of each task, in the order they were added */
+void TaskGraph::print() const {
+  for (const Timing& timing : m_timings) {
+    std::cout << std::left << std::setw(16) << timing.name << std::right << std::fixed << std::setprecision(2)
+              << " start " << std::setw(8) << timing.time_start << " ms, duration " << std::setw(8) << timing.duration
+              << " ms (" << (timing.thread == TaskThread::MAIN ? "main" : "worker") << ")\n";
+  }
+
+  std::cout << "Startup tasks: " << m_duration << " ms" << '\n';
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "jobs/thread_pool.hpp"
+
+/**
+ * @param n_threads Total # of threads incl. calling one (0 for 1 per hardware thread)
+ */
+ThreadPool::ThreadPool(int n_threads):
+  m_n_tasks(0),
+  m_is_stopped(false)
+{
+  if (n_threads <= 0)
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // last queue belongs to calling thread
+  for (int i_thread = 0; i_thread < n_threads; i_thread++)
+    m_queues.push_back(std::make_unique<Queue>());
+
+  for (int i_thread = 0; i_thread < n_threads - 1; i_thread++)
+    m_threads.push_back(std::thread(&ThreadPool::run, this, i_thread));
+}
+
+ThreadPool::~ThreadPool() {
+  free();
+}
+
+/**
+ * Call `func(i_begin, i_end)` on chunks of `[0, n_items)` in parallel & wait for all of them
+ * Chunks are the same whatever the # of threads, so results don't depend on it
+ * @param size_chunk # of items per chunk (e.g. rows per band)
+ */
+void ThreadPool::parallel_for(int n_items, int size_chunk, const std::function<void(int, int)>& func) {
+  size_chunk = std::max(1, size_chunk);
+  int n_chunks = (n_items + size_chunk - 1) / size_chunk;
+  if (m_threads.empty() || n_chunks <= 1) {
+    for (int i_begin = 0; i_begin < n_items; i_begin += size_chunk)
+      func(i_begin, std::min(i_begin + size_chunk, n_items));
+    return;
+  }
+
+  // chunks spread over all queues
+  std::shared_ptr<std::atomic<int>> n_remaining = std::make_shared<std::atomic<int>>(n_chunks);
+  for (int i_chunk = 0; i_chunk < n_chunks; i_chunk++) {
+    int i_begin = i_chunk * size_chunk;
+    int i_end = std::min(i_begin + size_chunk, n_items);
+    Queue& queue = *m_queues[i_chunk % m_queues.size()];
+
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back([&func, i_begin, i_end, n_remaining]() {
+      func(i_begin, i_end);
+      (*n_remaining)--;
+    });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_n_tasks += n_chunks;
+  }
+  m_condition.notify_all();
+
+  // calling thread runs chunks too until they're all taken, then waits for the ones still running
+  size_t i_queue = m_queues.size() - 1;
+  std::function<void()> task;
+  while (*n_remaining > 0) {
+    if (pop(i_queue, task))
+      task();
+    else
+      std::this_thread::yield();
+  }
+}
+
+/* Total # of threads running chunks (incl. calling one) */
+int ThreadPool::get_n_threads() const {
+  return m_queues.size();
+}
+
+/* Stop & join threads (queued tasks are run first) */
+void ThreadPool::free() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_is_stopped = true;
+  }
+
+  m_condition.notify_all();
+  for (std::thread& thread : m_threads) {
+    if (thread.joinable())
+      thread.join();
+  }
+  m_threads.clear();
+}
+
+/* Task from own queue's front, otherwise stolen from back of another one */
+bool ThreadPool::pop(size_t i_queue, std::function<void()>& task) {
+  for (size_t i_offset = 0; i_offset < m_queues.size(); i_offset++) {
+    Queue& queue = *m_queues[(i_queue + i_offset) % m_queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      continue;
+
+    if (i_offset == 0) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    } else {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+
+    m_n_tasks--;
+    return true;
+  }
+
+  return false;
+}
+
+/* Thread's loop: sleep until tasks are queued */
+void ThreadPool::run(size_t i_queue) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this] { return m_is_stopped || m_n_tasks > 0; });
+      if (m_is_stopped && m_n_tasks == 0)
+        return;
+    }
+
+    std::function<void()> task;
+    if (pop(i_queue, task))
+      task();
+  }
+}
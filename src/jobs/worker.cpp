@@ -0,0 +1,56 @@
+#include "jobs/worker.hpp"
+
+Worker::Worker():
+  m_n_pending(0),
+  m_is_stopped(false)
+{
+  m_thread = std::thread(&Worker::run, this);
+}
+
+/* Queue task to run on worker thread */
+void Worker::submit(const std::function<void()>& task) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push(task);
+    m_n_pending++;
+  }
+
+  m_condition.notify_one();
+}
+
+/* Number of tasks queued or running */
+size_t Worker::get_n_pending() const {
+  return m_n_pending;
+}
+
+/* Wait for queued tasks to finish then stop thread */
+void Worker::free() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_is_stopped = true;
+  }
+
+  m_condition.notify_one();
+  if (m_thread.joinable())
+    m_thread.join();
+}
+
+/* Thread's loop: sleep until a task is queued */
+void Worker::run() {
+  while (true) {
+    std::function<void()> task;
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_condition.wait(lock, [this] { return m_is_stopped || !m_tasks.empty(); });
+      if (m_tasks.empty())
+        return;
+
+      task = m_tasks.front();
+      m_tasks.pop();
+    }
+
+    task();
+    m_n_pending--;
+  }
+}
@@ -1,44 +1,176 @@
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <optional>
+#include <algorithm>
 
 #include "glad/glad.h"
+#include "imgui.h"
 #include "ui/frame.hpp"
+#include "ui/redraw.hpp"
+#include "ui/pacing.hpp"
+#include "fonts/fonts.hpp"
+#include "image/image_decoder.hpp"
+#include "image/pyramid_file.hpp"
+#include "effects/compute_effects.hpp"
+#include "effects/effect_chain.hpp"
+#include "gpu/shared_surface.hpp"
+#include "gpu/tile_scheduler.hpp"
+#include "profiling/metrics_exporter.hpp"
+#include "jobs/task_graph.hpp"
+#include "commands/session_log.hpp"
 
-int main() {
-  // glfw window
-  Window window("Image visualizer");
+/* launch time (initialized before `main()`), origin of time-to-first-frame */
+static const std::chrono::steady_clock::time_point time_launch = std::chrono::steady_clock::now();
 
-  if (window.is_null()) {
+/**
+ * Usage: ./main [--on-demand] [--max-idle <seconds>] [--backend <fragment|compute>] [--startup-time]
+ *               [--record <path>] [--replay <path>] [--half-float] [--low-latency] [--no-vsync-drawing] [--share <name>]
+ *               [--frame-budget <ms>] [--metrics <path>] [--metrics-port <port>] [--metrics-format <json|prometheus>]
+ *               [--metrics-interval <seconds>] [--pyramid-cache <MB>]
+ * --on-demand: only redraw on input events/requests (waits for events when idle)
+ * --max-idle: max. time to wait for an event before drawing a frame anyway in on-demand mode
+ * --backend: run effects with fragment shaders, or compute shaders if supported (default)
+ * --startup-time: print duration of each startup task & time to first frame
+ * --record: write commands dispatched during session to a log file
+ * --replay: dispatch commands from a recorded log instead of ui input, then quit
+ * --half-float: render effects into half-float textures (no banding when chaining them, twice the memory)
+ * --low-latency: poll input right before building each frame, & sleep after present so it's sampled as late as possible
+ * --no-vsync-drawing: disable vsync while a brush stroke is drawn (frames still capped at refresh rate by limiter)
+ * --share: publish canvas output into posix shared memory `name` (e.g. "/imgui-example") whenever it changes
+ * --frame-budget: gpu time per frame given to effects, rendered in tiles over several frames when they take longer
+ * --metrics: write frame times, gpu passes, decode/encode throughput, cache hits & memory to a file periodically
+ * --metrics-port: serve same metrics over http on 127.0.0.1 (e.g. scraped by prometheus)
+ * --metrics-format: text format of metrics (default: prometheus)
+ * --metrics-interval: seconds between writes of metrics file (default: 10)
+ * --pyramid-cache: max. size of pyramids cached for images too large for a texture (default: 8192)
+ */
+int main(int argc, char** argv) {
+  bool is_startup_printed = false;
+  for (int i_arg = 1; i_arg < argc; i_arg++) {
+    if (std::strcmp(argv[i_arg], "--on-demand") == 0) {
+      Redraw::on_demand = true;
+    } else if (std::strcmp(argv[i_arg], "--max-idle") == 0 && i_arg + 1 < argc) {
+      Redraw::max_idle = std::atof(argv[++i_arg]);
+    } else if (std::strcmp(argv[i_arg], "--backend") == 0 && i_arg + 1 < argc) {
+      ComputeEffects::is_enabled = std::strcmp(argv[++i_arg], "fragment") != 0;
+    } else if (std::strcmp(argv[i_arg], "--startup-time") == 0) {
+      is_startup_printed = true;
+    } else if (std::strcmp(argv[i_arg], "--record") == 0 && i_arg + 1 < argc) {
+      SessionLog::path_record = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--replay") == 0 && i_arg + 1 < argc) {
+      SessionLog::path_replay = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--half-float") == 0) {
+      EffectChain::is_half_float = true;
+    } else if (std::strcmp(argv[i_arg], "--low-latency") == 0) {
+      Pacing::low_latency = true;
+    } else if (std::strcmp(argv[i_arg], "--no-vsync-drawing") == 0) {
+      Pacing::no_vsync_drawing = true;
+    } else if (std::strcmp(argv[i_arg], "--share") == 0 && i_arg + 1 < argc) {
+      SharedSurface::name = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--frame-budget") == 0 && i_arg + 1 < argc) {
+      TileScheduler::budget = std::max((float) std::atof(argv[++i_arg]), 0.0f);
+    } else if (std::strcmp(argv[i_arg], "--metrics") == 0 && i_arg + 1 < argc) {
+      MetricsExporter::path = argv[++i_arg];
+    } else if (std::strcmp(argv[i_arg], "--metrics-port") == 0 && i_arg + 1 < argc) {
+      MetricsExporter::port = std::atoi(argv[++i_arg]);
+    } else if (std::strcmp(argv[i_arg], "--metrics-format") == 0 && i_arg + 1 < argc) {
+      if (!MetricsExporter::parse_format(argv[++i_arg], MetricsExporter::format))
+        std::cout << "Unknown metrics format " << argv[i_arg] << ", prometheus used" << '\n';
+    } else if (std::strcmp(argv[i_arg], "--metrics-interval") == 0 && i_arg + 1 < argc) {
+      MetricsExporter::interval = std::max((float) std::atof(argv[++i_arg]), 0.1f);
+    } else if (std::strcmp(argv[i_arg], "--pyramid-cache") == 0 && i_arg + 1 < argc) {
+      PyramidFile::budget_cache = (size_t) std::max(std::atof(argv[++i_arg]), 0.0) * 1024 * 1024;
+    }
+  }
+
+  // metrics written & served from a background thread until exit (no gl needed)
+  MetricsExporter::get().start();
+
+  // startup tasks: image decoding & fonts rasterization on workers while gl context, shaders & canvas come up
+  std::string path_image = "./assets/images/nature.jpg";
+  std::optional<Window> window;
+  std::optional<Image> image;
+  std::optional<Frame> frame;
+  bool is_gl_loaded = false;
+  TaskGraph startup;
+
+  startup.add("decode_image", {}, TaskThread::WORKER, [&]() { image = ImageDecoder::decode(path_image); });
+  startup.add("context_imgui", {}, TaskThread::MAIN, [&]() { ImGui::CreateContext(); });
+  startup.add("fonts", {"context_imgui"}, TaskThread::WORKER, [&]() { Fonts::load(ImGui::GetIO().Fonts); });
+
+  // glfw window & glad initialized before calling gl functions
+  startup.add("window", {}, TaskThread::MAIN, [&]() {
+    window.emplace("Image visualizer");
+    if (window->is_null())
+      return;
+
+    window->make_context();
+    is_gl_loaded = gladLoadGL();
+  });
+
+  // window frame with imgui (canvas uploads image & compiles its shaders)
+  startup.add("frame", {"window", "decode_image", "context_imgui"}, TaskThread::MAIN, [&]() {
+    if (is_gl_loaded)
+      frame.emplace(*window, *image, path_image);
+  });
+
+  startup.run();
+  if (image)
+    image->free();
+
+  if (window->is_null()) {
     std::cout << "Failed to create window or OpenGL context" << "\n";
     return 1;
   }
 
-  // initialize glad before calling gl functions
-  window.make_context();
-  if (!gladLoadGL()) {
+  if (!is_gl_loaded) {
     std::cout << "Failed to load Glad (OpenGL)" << "\n";
-    window.destroy();
+    window->destroy();
     return 1;
   } else {
     std::cout << "Opengl version: " << glGetString(GL_VERSION) << "\n";
     std::cout << "GLSL version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << "\n";
   }
 
-  // initialize window frame with imgui
-  std::string path_image = "./assets/images/nature.jpg";
-  Frame frame(window, path_image);
-
   // main loop
-  while (!window.is_closed()) {
+  Pacing::init();
+  bool is_first_frame = true;
+  while (!window->is_closed()) {
+    // low-latency mode (or vsync off while drawing): sleep until just before latest frame start still presented
+    // at next vsync, then poll input (in low-latency mode only)
+    bool is_low_latency = Pacing::low_latency;
+    Pacing::limit();
+
+    // in on-demand mode, sleep until an event/redraw request arrives (or idle timeout expires)
+    if (Redraw::on_demand)
+      Redraw::wait();
+    if (is_low_latency)
+      window->process_events();
+    Pacing::begin_frame();
+
     // clear color & depth & stencil buffers before rendering every frame
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
     // render imgui frame
-    frame.render();
+    frame->render();
 
-    // process events & show rendered buffer
-    window.process_events();
-    window.render();
+    // process events (shown in next frame, unless polled above) & show rendered buffer
+    if (!is_low_latency)
+      window->process_events();
+    window->render();
+    Pacing::end_frame();
+
+    // first frame measured once gpu is done with it (stall only when printed)
+    if (is_first_frame && is_startup_printed) {
+      glFinish();
+      float time_first_frame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - time_launch).count();
+      startup.print();
+      std::cout << "Time to first frame: " << time_first_frame << " ms" << '\n';
+    }
+    is_first_frame = false;
 
     /*
     float fps = ImGui::GetIO().Framerate;
@@ -46,11 +178,15 @@ int main() {
     */
   }
 
+  if (Redraw::on_demand)
+    Redraw::print();
+
   // destroy imgui
-  frame.free();
+  frame->free();
+  MetricsExporter::get().free();
 
   // destroy window & terminate glfw
-  window.destroy();
+  window->destroy();
 
   return 0;
 }
@@ -0,0 +1,124 @@
+#include "profiling/gpu_timer.hpp"
+
+GpuTimer::GpuTimer():
+  m_i_frame(0),
+  m_is_enabled(false)
+{
+}
+
+/* Timer shared by canvas, nanovg & imgui passes */
+GpuTimer& GpuTimer::get() {
+  static GpuTimer timer;
+  return timer;
+}
+
+/* Passes aren't measured when disabled (e.g. overlay hidden) */
+void GpuTimer::set_enabled(bool is_enabled) {
+  m_is_enabled = is_enabled;
+}
+
+/**
+ * Record timestamp before gl commands of pass
+ * Skipped if pass' next query is still in flight (measure lost rather than stalling)
+ */
+void GpuTimer::begin(const std::string& name) {
+  if (!m_is_enabled)
+    return;
+
+  Pass& pass = find(name);
+  Slot& slot = pass.slots[pass.i_slot];
+  if (slot.is_pending && !read(pass, slot))
+    return;
+
+  glQueryCounter(slot.queries[0], GL_TIMESTAMP);
+  slot.i_frame = m_i_frame;
+  pass.is_open = true;
+}
+
+/* Record timestamp after gl commands of pass (ignored if its `begin()` was skipped) */
+void GpuTimer::end(const std::string& name) {
+  if (!m_is_enabled)
+    return;
+
+  Pass& pass = find(name);
+  if (!pass.is_open)
+    return;
+
+  Slot& slot = pass.slots[pass.i_slot];
+  glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+  slot.is_pending = true;
+  pass.is_open = false;
+  pass.i_slot = (pass.i_slot + 1) % N_QUERIES;
+}
+
+/* Read available results, oldest first so each pass ends up with its latest duration (called once per frame) */
+void GpuTimer::collect() {
+  for (Pass& pass : m_passes) {
+    for (int i_query = 0; i_query < N_QUERIES; i_query++) {
+      Slot& slot = pass.slots[(pass.i_slot + i_query) % N_QUERIES];
+      if (slot.is_pending)
+        read(pass, slot);
+    }
+  }
+
+  m_i_frame++;
+}
+
+/* Latest results (passes not run in a frame, e.g. skipped effects, keep an older `i_frame`) */
+std::vector<GpuTimer::Result> GpuTimer::get_results() const {
+  std::vector<Result> results;
+  for (const Pass& pass : m_passes) {
+    if (pass.result.i_frame != 0)
+      results.push_back(pass.result);
+  }
+
+  return results;
+}
+
+/* Pass with given name, created with its queries on first use */
+GpuTimer::Pass& GpuTimer::find(const std::string& name) {
+  for (Pass& pass : m_passes) {
+    if (pass.name == name)
+      return pass;
+  }
+
+  Pass pass;
+  pass.name = name;
+  pass.i_slot = 0;
+  pass.is_open = false;
+  pass.result = { name, 0.0f, 0 };
+  for (Slot& slot : pass.slots) {
+    glGenQueries(2, slot.queries);
+    slot.i_frame = 0;
+    slot.is_pending = false;
+  }
+
+  m_passes.push_back(pass);
+  return m_passes.back();
+}
+
+/* Store slot's duration if gpu reached end timestamp (never blocks) */
+bool GpuTimer::read(Pass& pass, Slot& slot) {
+  GLint is_available;
+  glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &is_available);
+  if (!is_available)
+    return false;
+
+  GLuint64 timestamps[2];
+  glGetQueryObjectui64v(slot.queries[0], GL_QUERY_RESULT, &timestamps[0]);
+  glGetQueryObjectui64v(slot.queries[1], GL_QUERY_RESULT, &timestamps[1]);
+
+  // frame indices start at 1 in results (0 means no result yet)
+  pass.result = { pass.name, (timestamps[1] - timestamps[0]) / 1e6f, slot.i_frame + 1 };
+  slot.is_pending = false;
+  return true;
+}
+
+void GpuTimer::free() {
+  for (Pass& pass : m_passes) {
+    for (Slot& slot : pass.slots)
+      glDeleteQueries(2, slot.queries);
+  }
+
+  m_passes.clear();
+}
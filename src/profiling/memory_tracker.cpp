@@ -0,0 +1,158 @@
+#include <algorithm>
+
+#include "glad/glad.h"
+
+#include "profiling/memory_tracker.hpp"
+
+/* Default budgets (same as those caches had before reading them from here) */
+MemoryTracker::MemoryTracker():
+  m_budgets{ 64 * 1024 * 1024, 512 * 1024 * 1024, 256 * 1024 * 1024, 1024 * 1024 * 1024 }
+{
+}
+
+MemoryTracker& MemoryTracker::get() {
+  static MemoryTracker tracker;
+  return tracker;
+}
+
+/**
+ * Register (or update) an allocation
+ * @param id Gl name of texture/buffer, or any address unique to owner for cpu memory (e.g. `this`)
+ * @param format e.g. # of channels & depth of a texture
+ */
+void MemoryTracker::track(MemoryKind kind, uintptr_t id, const std::string& owner, const std::string& format, size_t n_bytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_allocations[{ kind, id }] = { kind, id, owner, format, n_bytes };
+}
+
+void MemoryTracker::untrack(MemoryKind kind, uintptr_t id) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_allocations.erase({ kind, id });
+}
+
+/**
+ * Allocation handed over to another owner (e.g. texture released to pool, or prefetched image opened)
+ * @return false if allocation isn't tracked
+ */
+bool MemoryTracker::set_owner(MemoryKind kind, uintptr_t id, const std::string& owner) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_allocations.find({ kind, id });
+  if (it == m_allocations.end())
+    return false;
+
+  it->second.owner = owner;
+  return true;
+}
+
+/**
+ * Forget gl objects deleted without being untracked (e.g. pooled texture freed directly by its owner)
+ * To call from main thread (queries gl names on current context)
+ */
+void MemoryTracker::prune() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_allocations.begin(); it != m_allocations.end(); ) {
+    const Allocation& allocation = it->second;
+    bool is_deleted = (allocation.kind == MemoryKind::TEXTURE && !glIsTexture(allocation.id)) ||
+                      (allocation.kind == MemoryKind::BUFFER && !glIsBuffer(allocation.id));
+    it = is_deleted ? m_allocations.erase(it) : std::next(it);
+  }
+}
+
+size_t MemoryTracker::get_n_bytes_gpu() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t n_bytes = 0;
+  for (const auto& [key, allocation] : m_allocations) {
+    if (allocation.kind != MemoryKind::CPU)
+      n_bytes += allocation.n_bytes;
+  }
+
+  return n_bytes;
+}
+
+size_t MemoryTracker::get_n_bytes_cpu() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t n_bytes = 0;
+  for (const auto& [key, allocation] : m_allocations) {
+    if (allocation.kind == MemoryKind::CPU)
+      n_bytes += allocation.n_bytes;
+  }
+
+  return n_bytes;
+}
+
+/* Total size of allocations of given owner (e.g. for a cache to compare with its budget) */
+size_t MemoryTracker::get_n_bytes(const std::string& owner) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t n_bytes = 0;
+  for (const auto& [key, allocation] : m_allocations) {
+    if (allocation.owner == owner)
+      n_bytes += allocation.n_bytes;
+  }
+
+  return n_bytes;
+}
+
+/* `n` largest allocations, largest first */
+std::vector<MemoryTracker::Allocation> MemoryTracker::get_largest(size_t n) const {
+  std::vector<Allocation> allocations;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [key, allocation] : m_allocations)
+      allocations.push_back(allocation);
+  }
+
+  n = std::min(n, allocations.size());
+  std::partial_sort(allocations.begin(), allocations.begin() + n, allocations.end(), [](const Allocation& lhs, const Allocation& rhs) {
+    return lhs.n_bytes > rhs.n_bytes;
+  });
+  allocations.resize(n);
+  return allocations;
+}
+
+/* Totals per owner & kind, largest first (`format` holds # of allocations) */
+std::vector<MemoryTracker::Allocation> MemoryTracker::get_owners() const {
+  std::map<std::pair<std::string, MemoryKind>, std::pair<size_t, size_t>> totals;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& [key, allocation] : m_allocations) {
+      auto& [n_bytes, n_allocations] = totals[{ allocation.owner, allocation.kind }];
+      n_bytes += allocation.n_bytes;
+      n_allocations++;
+    }
+  }
+
+  std::vector<Allocation> owners;
+  for (const auto& [key, total] : totals)
+    owners.push_back({ key.second, 0, key.first, std::to_string(total.second), total.first });
+
+  std::sort(owners.begin(), owners.end(), [](const Allocation& lhs, const Allocation& rhs) {
+    return lhs.n_bytes > rhs.n_bytes;
+  });
+  return owners;
+}
+
+void MemoryTracker::set_budget(MemoryBudget budget, size_t n_bytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_budgets[(int) budget] = n_bytes;
+}
+
+size_t MemoryTracker::get_budget(MemoryBudget budget) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_budgets[(int) budget];
+}
+
+/* Shown in memory panel */
+const char* MemoryTracker::get_name(MemoryBudget budget) {
+  switch (budget) {
+    case MemoryBudget::THUMBNAILS:
+      return "thumbnails";
+    case MemoryBudget::PREFETCH:
+      return "prefetch";
+    case MemoryBudget::UNDO_GPU:
+      return "undo (gpu)";
+    case MemoryBudget::UNDO_CPU:
+      return "undo (cpu)";
+  }
+
+  return "";
+}
@@ -0,0 +1,331 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "profiling/metrics_exporter.hpp"
+
+namespace {
+  /* Value in shortest form keeping integer counters exact (e.g. bytes) */
+  std::string to_string(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+  }
+
+  /* Quotes & backslashes escaped (same rules in json strings & prometheus label values) */
+  std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+      if (c == '"' || c == '\\')
+        escaped += '\\';
+      escaped += (c == '\n') ? ' ' : c;
+    }
+
+    return escaped;
+  }
+
+  const char* get_type_name(MetricType type) {
+    return type == MetricType::COUNTER ? "counter" : "gauge";
+  }
+}
+
+/* static members definition (avoids linking error) & initialization */
+std::string MetricsExporter::path = "";
+int MetricsExporter::port = 0;
+MetricsFormat MetricsExporter::format = MetricsFormat::PROMETHEUS;
+float MetricsExporter::interval = 10.0f;
+
+MetricsExporter::MetricsExporter():
+  m_counts_frame{},
+  m_n_frames(0),
+  m_duration_frames(0.0),
+  m_is_running(false),
+  m_fd(-1)
+{
+}
+
+/* Thread stopped if app exits early without calling `free()` (e.g. no gl context) */
+MetricsExporter::~MetricsExporter() {
+  free();
+}
+
+MetricsExporter& MetricsExporter::get() {
+  static MetricsExporter exporter;
+  return exporter;
+}
+
+/**
+ * Format from its name on command line
+ * @return false if name is neither "json" nor "prometheus"
+ */
+bool MetricsExporter::parse_format(const std::string& name, MetricsFormat& format) {
+  if (name == "json")
+    format = MetricsFormat::JSON;
+  else if (name == "prometheus")
+    format = MetricsFormat::PROMETHEUS;
+  else
+    return false;
+
+  return true;
+}
+
+/* Whether a file or an endpoint was requested (sources skip computing their metrics otherwise) */
+bool MetricsExporter::is_enabled() const {
+  return !path.empty() || port > 0;
+}
+
+/**
+ * Listen on http port if any & start background thread writing file & answering requests
+ * @return false if port couldn't be bound (file still written)
+ */
+bool MetricsExporter::start() {
+  if (!is_enabled() || m_is_running)
+    return true;
+
+  bool is_listening = true;
+#ifndef _WIN32
+  if (port > 0) {
+    // local endpoint only (metrics aren't meant to be exposed on the network)
+    m_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int is_reused = 1;
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (m_fd >= 0)
+      setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &is_reused, sizeof(is_reused));
+    if (m_fd < 0 || bind(m_fd, (sockaddr*) &address, sizeof(address)) != 0 || listen(m_fd, 4) != 0) {
+      std::cout << "Failed to serve metrics on port " << port << '\n';
+      if (m_fd >= 0)
+        close(m_fd);
+      m_fd = -1;
+      is_listening = false;
+    }
+  }
+#else
+  is_listening = port == 0;
+#endif
+
+  m_is_running = true;
+  m_thread = std::thread(&MetricsExporter::run, this);
+  return is_listening;
+}
+
+/**
+ * Add to a counter (e.g. pixels decoded), created at 0
+ * @param label,value_label Series of metric (e.g. "pass" & "effects"), none if empty
+ */
+void MetricsExporter::add(const std::string& name, double value, const std::string& label, const std::string& value_label) {
+  if (!is_enabled())
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_metrics.find({ name, value_label });
+  if (it == m_metrics.end())
+    m_metrics[{ name, value_label }] = { name, label, value_label, MetricType::COUNTER, value };
+  else
+    it->second.value += value;
+}
+
+/* Set latest value of a gauge, or of a counter kept by its source (e.g. hits of a pool) */
+void MetricsExporter::set(const std::string& name, double value, MetricType type,
+                          const std::string& label, const std::string& value_label) {
+  if (!is_enabled())
+    return;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_metrics[{ name, value_label }] = { name, label, value_label, type, value };
+}
+
+/* Count frame in histogram (cpu time of frame in ms) */
+void MetricsExporter::add_frame(float duration) {
+  if (!is_enabled())
+    return;
+
+  int i_bucket = 0;
+  while (i_bucket < N_BUCKETS && duration > BOUNDS_FRAME[i_bucket])
+    i_bucket++;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_counts_frame[i_bucket]++;
+  m_n_frames++;
+  m_duration_frames += duration;
+}
+
+/* Snapshot of all metrics in given format */
+std::string MetricsExporter::get_text(MetricsFormat format) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return format == MetricsFormat::JSON ? get_json() : get_prometheus();
+}
+
+/**
+ * Prometheus text exposition format (one type line per metric, then its series)
+ * https://prometheus.io/docs/instrumenting/exposition_formats/
+ */
+std::string MetricsExporter::get_prometheus() const {
+  std::ostringstream stream;
+  std::string name_previous;
+  for (const auto& pair : m_metrics) {
+    const Metric& metric = pair.second;
+    std::string name = PREFIX + metric.name;
+    if (metric.name != name_previous)
+      stream << "# TYPE " << name << ' ' << get_type_name(metric.type) << '\n';
+    name_previous = metric.name;
+
+    stream << name;
+    if (!metric.label.empty())
+      stream << '{' << metric.label << "=\"" << escape(metric.value_label) << "\"}";
+    stream << ' ' << to_string(metric.value) << '\n';
+  }
+
+  if (m_n_frames > 0) {
+    std::string name = std::string(PREFIX) + "frame_duration_ms";
+    stream << "# TYPE " << name << " histogram" << '\n';
+    unsigned long long n_frames = 0;
+    for (int i_bucket = 0; i_bucket <= N_BUCKETS; i_bucket++) {
+      n_frames += m_counts_frame[i_bucket];
+      std::string bound = i_bucket < N_BUCKETS ? to_string(BOUNDS_FRAME[i_bucket]) : "+Inf";
+      stream << name << "_bucket{le=\"" << bound << "\"} " << n_frames << '\n';
+    }
+
+    stream << name << "_sum " << to_string(m_duration_frames) << '\n'
+           << name << "_count " << m_n_frames << '\n';
+  }
+
+  return stream.str();
+}
+
+/* Json object with a timestamp (unix time in sec), metrics as a list & frame-time histogram (cumulative counts) */
+std::string MetricsExporter::get_json() const {
+  double timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  std::ostringstream stream;
+  stream << "{\n  \"timestamp\": " << to_string(timestamp) << ",\n  \"metrics\": [";
+
+  bool is_first = true;
+  for (const auto& pair : m_metrics) {
+    const Metric& metric = pair.second;
+    stream << (is_first ? "\n" : ",\n") << "    { \"name\": \"" << PREFIX << escape(metric.name) << "\", \"type\": \""
+           << get_type_name(metric.type) << "\", ";
+    if (!metric.label.empty())
+      stream << "\"labels\": { \"" << escape(metric.label) << "\": \"" << escape(metric.value_label) << "\" }, ";
+    stream << "\"value\": " << to_string(metric.value) << " }";
+    is_first = false;
+  }
+
+  stream << "\n  ],\n  \"frame_duration_ms\": { \"count\": " << m_n_frames << ", \"sum\": " << to_string(m_duration_frames)
+         << ", \"buckets\": [";
+  unsigned long long n_frames = 0;
+  for (int i_bucket = 0; i_bucket <= N_BUCKETS; i_bucket++) {
+    n_frames += m_counts_frame[i_bucket];
+    std::string bound = i_bucket < N_BUCKETS ? to_string(BOUNDS_FRAME[i_bucket]) : "\"+Inf\"";
+    stream << (i_bucket > 0 ? ", " : "") << "{ \"le\": " << bound << ", \"count\": " << n_frames << " }";
+  }
+  stream << "] }\n}\n";
+
+  return stream.str();
+}
+
+/**
+ * Write snapshot to file through a temporary one renamed over it (readers see previous or new file, never half of one)
+ * @return false if file couldn't be written (or none requested)
+ */
+bool MetricsExporter::write() {
+  if (path.empty())
+    return false;
+
+  std::string text = get_text(format);
+  std::string path_tmp = path + ".tmp";
+  {
+    std::ofstream file(path_tmp, std::ios::binary | std::ios::trunc);
+    if (!file || !(file << text))
+      return false;
+  }
+
+  return std::rename(path_tmp.c_str(), path.c_str()) == 0;
+}
+
+/* Background thread: file written every `interval` sec, http requests answered in between */
+void MetricsExporter::run() {
+  auto time_write = std::chrono::steady_clock::now();
+  while (m_is_running) {
+    std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - time_write;
+    if (elapsed.count() >= interval) {
+      write();
+      time_write = std::chrono::steady_clock::now();
+    }
+
+    serve();
+  }
+}
+
+/* Answer pending http request if any (waits at most 100ms for one, so thread notices it's stopped) */
+void MetricsExporter::serve() {
+  const int DURATION_POLL = 100;
+#ifndef _WIN32
+  if (m_fd < 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(DURATION_POLL));
+    return;
+  }
+
+  pollfd descriptor = { m_fd, POLLIN, 0 };
+  if (poll(&descriptor, 1, DURATION_POLL) <= 0)
+    return;
+
+  int fd_client = accept(m_fd, NULL, NULL);
+  if (fd_client < 0)
+    return;
+
+  // request itself ignored (same metrics whatever the path)
+  char request[1024];
+  pollfd descriptor_client = { fd_client, POLLIN, 0 };
+  if (poll(&descriptor_client, 1, DURATION_POLL) > 0)
+    recv(fd_client, request, sizeof(request), 0);
+
+  std::string body = get_text(format);
+  std::string type = format == MetricsFormat::JSON ? "application/json" : "text/plain; version=0.0.4";
+  std::string response = "HTTP/1.0 200 OK\r\nContent-Type: " + type + "\r\nContent-Length: " +
+                         std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+  size_t n_sent = 0;
+  while (n_sent < response.size()) {
+    ssize_t n_bytes = send(fd_client, response.data() + n_sent, response.size() - n_sent, MSG_NOSIGNAL);
+    if (n_bytes <= 0)
+      break;
+    n_sent += n_bytes;
+  }
+
+  close(fd_client);
+#else
+  std::this_thread::sleep_for(std::chrono::milliseconds(DURATION_POLL));
+#endif
+}
+
+/* Stop background thread & write final snapshot (e.g. totals of a finished batch run) */
+void MetricsExporter::free() {
+  if (!m_is_running)
+    return;
+
+  m_is_running = false;
+  if (m_thread.joinable())
+    m_thread.join();
+
+#ifndef _WIN32
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+  m_fd = -1;
+
+  write();
+}
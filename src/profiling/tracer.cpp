@@ -0,0 +1,212 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+
+#include "profiling/tracer.hpp"
+
+namespace {
+  struct Event {
+    const char* name;
+    int64_t time_start;
+    int64_t time_stop;
+    int depth;
+  };
+
+  /* Single-producer (owning thread), single-consumer (collector) ring of events */
+  struct EventBuffer {
+    static const size_t N_EVENTS = 1 << 14;
+
+    Event events[N_EVENTS];
+    std::atomic<size_t> i_write{0};
+    std::atomic<size_t> i_read{0};
+    std::atomic<unsigned int> n_dropped{0};
+
+    /* only accessed by owning thread */
+    int depth = 0;
+    unsigned int id_thread;
+  };
+
+  struct Samples {
+    Tracer::ZoneStats stats;
+    std::vector<float> durations;
+    int i_head;
+  };
+
+  /* buffers kept after their thread exits, so their last events are still collected */
+  std::mutex mutex_buffers;
+  std::vector<std::shared_ptr<EventBuffer>> buffers;
+
+  /* collector side (guarded by its own mutex, as collect & capture may be called from different threads) */
+  std::mutex mutex_collector;
+  std::vector<Samples> samples;
+  std::unordered_map<std::string, size_t> indices_samples;
+  std::vector<std::pair<Event, unsigned int>> events_captured;
+  bool is_capture_started = false;
+
+  const auto time_origin = std::chrono::steady_clock::now();
+
+  int64_t get_time() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - time_origin).count();
+  }
+
+  /* Buffer of calling thread, registered on its first zone */
+  EventBuffer& get_buffer() {
+    thread_local std::shared_ptr<EventBuffer> buffer;
+    if (!buffer) {
+      buffer = std::make_shared<EventBuffer>();
+      std::lock_guard<std::mutex> lock(mutex_buffers);
+      buffer->id_thread = buffers.size();
+      buffers.push_back(buffer);
+    }
+
+    return *buffer;
+  }
+
+  void push(EventBuffer& buffer, const Event& event) {
+    size_t i_write = buffer.i_write.load(std::memory_order_relaxed);
+    if (i_write - buffer.i_read.load(std::memory_order_acquire) == EventBuffer::N_EVENTS) {
+      buffer.n_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    buffer.events[i_write % EventBuffer::N_EVENTS] = event;
+    buffer.i_write.store(i_write + 1, std::memory_order_release);
+  }
+
+  void add_sample(const Event& event) {
+    auto it = indices_samples.find(event.name);
+    if (it == indices_samples.end()) {
+      Samples samples_zone = { { event.name, event.depth, 0, 0.0f, 0.0f, 0.0f }, std::vector<float>(), 0 };
+      samples_zone.durations.reserve(Tracer::N_SAMPLES);
+      it = indices_samples.insert({ event.name, samples.size() }).first;
+      samples.push_back(samples_zone);
+    }
+
+    Samples& samples_zone = samples[it->second];
+    float duration = (event.time_stop - event.time_start) / 1e6f;
+    if ((int) samples_zone.durations.size() < Tracer::N_SAMPLES)
+      samples_zone.durations.push_back(duration);
+    else
+      samples_zone.durations[samples_zone.i_head] = duration;
+    samples_zone.i_head = (samples_zone.i_head + 1) % Tracer::N_SAMPLES;
+
+    samples_zone.stats.depth = event.depth;
+    samples_zone.stats.n_calls++;
+    samples_zone.stats.duration_last = duration;
+  }
+}
+
+Zone::Zone(const char* name):
+  m_name(name),
+  m_time_start(get_time())
+{
+  get_buffer().depth++;
+}
+
+Zone::~Zone() {
+  EventBuffer& buffer = get_buffer();
+  buffer.depth--;
+  push(buffer, { m_name, m_time_start, get_time(), buffer.depth });
+}
+
+/* Drain events recorded by all threads since last call into statistics (& capture if started) */
+void Tracer::collect() {
+  std::vector<std::shared_ptr<EventBuffer>> buffers_copy;
+  {
+    std::lock_guard<std::mutex> lock(mutex_buffers);
+    buffers_copy = buffers;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_collector);
+  for (const std::shared_ptr<EventBuffer>& buffer : buffers_copy) {
+    size_t i_read = buffer->i_read.load(std::memory_order_relaxed);
+    size_t i_write = buffer->i_write.load(std::memory_order_acquire);
+
+    for (size_t i_event = i_read; i_event < i_write; i_event++) {
+      const Event& event = buffer->events[i_event % EventBuffer::N_EVENTS];
+      add_sample(event);
+      if (is_capture_started)
+        events_captured.push_back({ event, buffer->id_thread });
+    }
+
+    buffer->i_read.store(i_write, std::memory_order_release);
+  }
+}
+
+/* Zones in order of first record, with mean & max over their last calls */
+std::vector<Tracer::ZoneStats> Tracer::get_stats() {
+  std::lock_guard<std::mutex> lock(mutex_collector);
+  std::vector<ZoneStats> stats;
+  for (const Samples& samples_zone : samples) {
+    ZoneStats stats_zone = samples_zone.stats;
+    float sum = 0.0f;
+    for (float duration : samples_zone.durations) {
+      sum += duration;
+      stats_zone.duration_max = std::max(stats_zone.duration_max, duration);
+    }
+
+    stats_zone.duration_mean = samples_zone.durations.empty() ? 0.0f : sum / samples_zone.durations.size();
+    stats.push_back(stats_zone);
+  }
+
+  return stats;
+}
+
+/* Events lost bcoz a thread filled its buffer before it was collected */
+unsigned int Tracer::get_n_dropped() {
+  std::lock_guard<std::mutex> lock(mutex_buffers);
+  unsigned int n_dropped = 0;
+  for (const std::shared_ptr<EventBuffer>& buffer : buffers)
+    n_dropped += buffer->n_dropped.load(std::memory_order_relaxed);
+
+  return n_dropped;
+}
+
+/* Keep every zone collected from now on (until `stop_capture()`) */
+void Tracer::start_capture() {
+  std::lock_guard<std::mutex> lock(mutex_collector);
+  events_captured.clear();
+  is_capture_started = true;
+}
+
+bool Tracer::is_capturing() {
+  std::lock_guard<std::mutex> lock(mutex_collector);
+  return is_capture_started;
+}
+
+/**
+ * Write captured zones as complete events in chrome trace format (open in chrome://tracing or ui.perfetto.dev)
+ * @return false if file couldn't be written
+ */
+bool Tracer::stop_capture(const std::string& path) {
+  collect();
+
+  std::lock_guard<std::mutex> lock(mutex_collector);
+  is_capture_started = false;
+
+  std::ofstream file(path);
+  if (!file) {
+    std::cout << "Failed to write trace to " << path << '\n';
+    return false;
+  }
+
+  // timestamps & durations in microseconds
+  file << std::fixed << std::setprecision(3);
+  file << "{\"traceEvents\":[\n";
+  for (size_t i_event = 0; i_event < events_captured.size(); i_event++) {
+    const Event& event = events_captured[i_event].first;
+    file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << events_captured[i_event].second
+         << ",\"ts\":" << event.time_start / 1e3 << ",\"dur\":" << (event.time_stop - event.time_start) / 1e3 << "}"
+         << (i_event + 1 < events_captured.size() ? ",\n" : "\n");
+  }
+  file << "],\"displayTimeUnit\":\"ms\"}\n";
+
+  std::cout << "Trace with " << events_captured.size() << " zones written to " << path << '\n';
+  events_captured.clear();
+  return true;
+}
@@ -1,13 +1,17 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
 #include <algorithm>
+#include <filesystem>
+#include <cctype>
+#include <cmath>
 
 #include "glad/glad.h"
 
 #include "ui/canvas.hpp"
 #include "ui/toolbar.hpp"
 #include "ui/menu.hpp"
-#include "ui/imgui_utils.hpp"
+#include "ui/redraw.hpp"
+#include "ui/cursor_samples.hpp"
 
 #include "ui/enumerations/hover_mode.hpp"
 #include "ui/enumerations/mode.hpp"
@@ -18,53 +22,128 @@
 #include "ui/globals/mode.hpp"
 
 #include "image/image_utils.hpp"
+#include "image/image_decoder.hpp"
+#include "image/image_encoder.hpp"
+#include "image/raw_writer.hpp"
+#include "gpu/texture_pool.hpp"
+#include "profiling/memory_tracker.hpp"
+#include "gpu/pixel_format.hpp"
+#include "gpu/gl_worker.hpp"
+#include "effects/blur_kernel.hpp"
+#include "commands/command_queue.hpp"
 
-#include "shader_exception.hpp"
 #include "framebuffer_exception.hpp"
 #include "profiling/profiler.hpp"
-#include "geometries/surface_ndc.hpp"
+#include "profiling/gpu_timer.hpp"
+#include "profiling/tracer.hpp"
 
 /**
  * Canvas showing image
- * @param path_image Path to image to load initially
+ * @param image Initial image, decoded beforehand (e.g. on a worker thread during startup), uploaded but not freed
+ * @param path_image Path of initial image
  * TODO: remove `path_image` to start with an empty canvas
  */
-Canvas::Canvas(const std::string path_image):
-  // `unordered_map::operator[]()` requires map's value (i.e. Program) to have default constructor
-  m_programs {
-    {"color", Program("assets/shaders/fbo.vert", "assets/shaders/color.frag")},
-    {"grayscale", Program("assets/shaders/fbo.vert", "assets/shaders/grayscale.frag")},
-    {"monochrome", Program("assets/shaders/fbo.vert", "assets/shaders/monochrome.frag")},
-    {"blur", Program("assets/shaders/fbo.vert", "assets/shaders/blur.frag")},
-  },
+Canvas::Canvas(const Image& image, const std::string& path_image):
+  // other programs compiled once applied (throws `ShaderException` if view shader fails to compile)
+  m_programs(GpuResources::get().get_programs()),
 
-  m_texture_shapes(Image(path_image, false)),
-  m_texture_effects(Image(m_texture_shapes.width, m_texture_shapes.height, m_texture_shapes.format, NULL)),
+  m_texture_shapes(image),
+  m_depth(Depth::UNORM8),
+  m_texture_effects(TexturePool::get().acquire(m_texture_shapes.width, m_texture_shapes.height, get_n_channels_effects(),
+                                               EffectChain::get_depth_output(m_depth), "effects target")),
 
   m_width(m_texture_shapes.width),
   m_height(m_texture_shapes.height),
 
   m_framebuffer(),
-  m_renderer(m_programs.at("color"), SurfaceNDC(), {
-    {0, "position", 2, 4, 0},
-    {1, "texture_coord", 2, 4, 2}
-  }),
+  m_shader_view(Shader::COLOR),
+  m_renderer(GpuResources::get().get_renderer()),
+  m_effect_chain(),
 
-  m_image_vg(),
+  m_image_vg(GpuResources::get().get_vg()),
+  m_brush(),
+  m_history(),
+  m_layers(),
+  m_selection(),
+  m_lasso(),
+  m_flood_fill(),
+  m_edge_map(),
+  m_overlay(),
+  m_dirty(),
+  m_revision_dirty_effects(0),
 
-  m_zoom(1.0f),
+  m_view(),
+  m_is_panning(false),
+  m_mip_chain(),
+  m_display(),
+  m_histogram(),
+  m_image_stats(),
+  m_revision_histogram(0),
   m_tooltip_image(m_texture_effects),
-  m_tooltip_pixel(m_framebuffer)
+  m_tooltip_pixel(m_framebuffer),
+  m_tooltip_neighbourhood(m_framebuffer),
+
+  // effects texture initially empty (i.e. outdated)
+  m_revision(1),
+  m_revision_effects(0),
+  m_n_skipped_passes(0),
+
+  // up to 4 full-image readbacks in flight
+  m_pixel_reader(4),
+  m_workers_save(),
+  m_snapshots_raw(),
+  m_pixels_saved(),
+  m_revision_dirty_saved(0),
+  m_has_pixels_saved(false),
+  m_mode_saved(Mode::NORMAL),
+  m_exports(),
+  m_export_stats({ 0, 0, 0.0, 0.0, 0.0 }),
+
+  m_worker_decode(),
+  m_uploader(),
+  m_texture_preview(),
+  m_size_preview(),
+
+  m_path_image(path_image),
+  m_cache(),
+  m_worker_prefetch(),
+  m_uploader_prefetch(),
+
+  m_sequence(),
+  m_comparison({ "", CompareView::NONE, ImageComparison::GAIN_DEFAULT, false, false, {} }),
+  m_image_comparison(),
+  m_open_compare(),
+  m_texture_compare(),
+  m_n_references(0),
+  m_n_references_requested(0),
+  m_revision_compared(),
+  m_tiled(),
+  m_reference(),
+  m_evicted()
 {
-  // attach input image texture in normal mode to fbo
-  m_framebuffer.attach_texture(m_texture_effects);
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_size_texture_max);
+  for (int i_worker = 0; i_worker < N_WORKERS_SAVE; i_worker++)
+    m_workers_save.push_back(std::make_unique<Worker>());
 
-  // one of the vertex/fragment shaders failed to compile
-  for (auto& pair : m_programs) {
-    if (pair.second.has_failed()) {
-      throw ShaderException();
-    }
+  m_history.reset(m_texture_shapes);
+  m_dirty.reset(m_width, m_height);
+  PixelFormat::swizzle_gray(m_texture_shapes);
+  m_effect_chain.set_format(get_n_channels_effects(), m_depth);
+
+  // members hold plain gl handles (not freed by their destructors), so textures & fbo created above are freed here
+  try {
+    set_program_view(get_shader_view());
+  } catch (...) {
+    free();
+    throw;
   }
+
+  // effects run as compute shaders when available
+  if (ComputeEffects::is_supported())
+    m_effect_chain.set_backend(Backend::COMPUTE);
+
+  // attach input image texture in normal mode to fbo
+  m_framebuffer.attach_texture(m_texture_effects);
 }
 
 /**
@@ -75,7 +154,7 @@ void Canvas::render() {
   // main window's content size
   ImGuiIO& io = ImGui::GetIO(); // configures imgui
   ImVec2 size_display = io.DisplaySize;
-  float y_offset = Size::menu.y + Size::toolbar.y;
+  float y_offset = Size::menu.y + Size::toolbar.y + Size::tabs.y;
   Size::canvas = { size_display.x, size_display.y - y_offset };
 
   // viewport of same size as texture
@@ -89,61 +168,412 @@ void Canvas::render() {
   ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
   ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f); // otherwise cursor coords rel. to image org starts at 1 (not 0)
   bool p_open;
-  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoBackground;
+  // no scrolling by imgui (image moved by zoom & pan of view instead)
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoBackground |
+                                  ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse;
   ImGui::Begin("Canvas", &p_open, window_flags);
 
   // render image using custom shader (for grayscale) on drawlist associated with current frame
   render_image(y_offset);
 
+  // advance pending saves (readbacks are issued after effects pass)
+  update_jobs();
+  update_shared();
+
   // render imgui window
   ImGui::PopStyleVar(2); // cancel no-padding & no-border (i.e. arg=2 styles)
   ImGui::End();
 }
 
 /**
- * Change to shader identified by its key
- * @param name Shader key in `m_programs`
+ * Change view shader (applied to output of effects chain), compiled on first use
+ * Throws `ShaderException` if it fails to compile
+ */
+void Canvas::set_shader(Shader shader) {
+  if (!make_editable())
+    return;
+
+  set_program_view(shader);
+  invalidate_view();
+}
+
+/* Program drawing output of effects chain (also used for single effect of tiles) */
+void Canvas::set_program_view(Shader shader) {
+  m_shader_view = shader;
+  m_renderer.program = m_programs.get(shader);
+}
+
+/* Renderer shared by documents, set to draw with this canvas' view shader */
+Renderer& Canvas::get_renderer() {
+  m_renderer.program = m_programs.get(m_shader_view);
+  return m_renderer;
+}
+
+/**
+ * Monochrome images keep a single channel through effects (sampled as gray by swizzle), unless annotation layers are
+ * composited over them (in color)
+ * Expanded to rgba by monochrome view shader if swizzle is unsupported (opengl < 3.3)
+ */
+int Canvas::get_n_channels_effects() const {
+  bool is_mono = PixelFormat::get_n_channels(m_texture_shapes) == 1;
+  return (is_mono && PixelFormat::has_swizzle() && !m_layers) ? 1 : 4;
+}
+
+/* Effects target matching image (kept if same size & format) & re-attached to fbo, effects chain's format updated */
+void Canvas::update_texture_effects() {
+  int n_channels_effects = get_n_channels_effects();
+  m_effect_chain.set_format(n_channels_effects, m_depth);
+
+  Depth depth_effects = EffectChain::get_depth_output(m_depth);
+  if (m_texture_effects.width != m_width || m_texture_effects.height != m_height ||
+      PixelFormat::get_n_channels(m_texture_effects) != n_channels_effects ||
+      TexturePool::get().get_depth(m_texture_effects) != depth_effects) {
+    TexturePool::get().release(m_texture_effects);
+    m_texture_effects = TexturePool::get().acquire(m_width, m_height, n_channels_effects, depth_effects, "effects target");
+    m_framebuffer.attach_texture(m_texture_effects);
+    m_tooltip_image = TooltipImage(m_texture_effects);
+  }
+}
+
+/* Texture shapes & strokes are drawn on (active layer) */
+const Texture2D& Canvas::get_texture_target() const {
+  return m_layers ? m_layers->get_active().texture : m_texture_shapes;
+}
+
+/* Undo/redo history of active layer */
+History& Canvas::get_history() {
+  return (m_layers && m_layers->get_i_active() > 0) ? *m_layers->get_active().history : m_history;
+}
+
+/* Input of effects chain: image with visible layers blended over it (image texture itself without layers) */
+const Texture2D& Canvas::get_texture_composite() {
+  if (!m_layers)
+    return m_texture_shapes;
+
+  return m_layers->composite(get_renderer(), m_framebuffer, m_texture_shapes, m_dirty);
+}
+
+/**
+ * Texture saved & exported, as displayed: output of effects in normal mode (rendered if outdated),
+ * layers composited without effects in drawing mode
+ */
+const Texture2D& Canvas::get_texture_export() {
+  if (mode != Mode::NORMAL)
+    return get_texture_composite();
+
+  bake(true);
+  return m_texture_effects;
+}
+
+/**
+ * Displayed image for a thumbnail, without forcing a time-sliced render of effects to complete
+ * @return NULL if there is no full-size texture (tiles, read-only image, evicted or still opening) or it's being rendered
+ */
+const Texture2D* Canvas::get_texture_thumbnail() {
+  if (m_tiled || m_reference || m_texture_preview || m_evicted || !m_opens.empty())
+    return NULL;
+  if (mode != Mode::NORMAL)
+    return &get_texture_composite();
+
+  bake();
+  return m_effect_chain.is_pending() ? NULL : &m_texture_effects;
+}
+
+/* Revision of displayed content (changes when image, shapes or effects change, or mode is switched) */
+unsigned int Canvas::get_revision() const {
+  return 2 * m_revision + (mode == Mode::NORMAL);
+}
+
+/* View shader reset when an image is opened */
+Shader Canvas::get_shader_view() const {
+  bool is_mono = PixelFormat::get_n_channels(m_texture_shapes) == 1;
+  return (is_mono && !PixelFormat::has_swizzle()) ? Shader::MONOCHROME : Shader::COLOR;
+}
+
+/* Mark effects chain & texture as outdated (called when image or shapes drawn change) */
+void Canvas::invalidate() {
+  m_effect_chain.invalidate();
+  invalidate_view();
+}
+
+/**
+ * Mark effects chain & given region of effects texture as outdated (called when shapes are drawn)
+ * @param x_min,y_min,x_max,y_max Bounds of drawn pixels (origin at upper-left corner)
+ */
+void Canvas::invalidate(float x_min, float y_min, float x_max, float y_max) {
+  m_dirty.add(x_min, y_min, x_max, y_max);
+  m_effect_chain.invalidate();
+  m_revision++;
+  Redraw::request();
+}
+
+/* Mark effects texture as outdated, without re-running effects chain (e.g. view shader changed) */
+void Canvas::invalidate_view() {
+  m_dirty.add_all();
+  m_revision++;
+  if (m_tiled)
+    m_tiled->invalidate();
+
+  Redraw::request();
+}
+
+/**
+ * Mark effects texture as outdated after effects changed
+ * Only over selection if any (input shown as is outside it), whole texture otherwise
+ */
+void Canvas::invalidate_effects() {
+  if (m_selection.is_empty() || m_tiled) {
+    invalidate_view();
+    return;
+  }
+
+  const DirtyRegion::Rect& rect = m_selection.get_rect();
+  m_dirty.add(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+  m_revision++;
+  Redraw::request();
+}
+
+/* Number of effect passes skipped bcoz effects texture was up-to-date (for profiling) */
+unsigned int Canvas::get_n_skipped_passes() const {
+  return m_n_skipped_passes;
+}
+
+/**
+ * Render effects texture if outdated
+ * Needed before reading its pixels (save, histogram, tooltips) in display-resolution mode, where it isn't drawn
+ * @param is_complete Finish a time-sliced render of effects at once (e.g. pixels saved), previous texture kept otherwise
  */
-void Canvas::set_shader(const std::string& key) {
-  m_renderer.program = m_programs.at(key);
+void Canvas::bake(bool is_complete) {
+  if (m_revision_effects != m_revision)
+    render_to_fbo(is_complete);
 }
 
-/* render image to framebuffer texture */
-void Canvas::render_to_fbo() {
-  // clear framebuffer's attached color buffer in every frame
+/**
+ * render image to framebuffer texture (only if canvas changed since last pass)
+ * Previous texture kept while a time-sliced render of effects is pending (resumed on next frames)
+ */
+void Canvas::render_to_fbo(bool is_complete) {
+  if (m_revision_effects == m_revision) {
+    m_n_skipped_passes++;
+    return;
+  }
+
+  GpuTimer::get().begin("effects");
+  Renderer& renderer = get_renderer();
+
+  // only stages after a changed one are re-rendered (in textures owned by chain)
+  const Texture2D& texture_input = get_texture_composite();
+  const Texture2D& texture_chain = m_effect_chain.render(renderer, m_programs, m_framebuffer, texture_input, is_complete);
+  update_job_effects();
+  if (m_effect_chain.is_pending()) {
+    GpuTimer::get().end("effects");
+    Redraw::request();
+    return;
+  }
+
+  m_framebuffer.attach_texture(m_texture_effects);
+  glViewport(0, 0, m_width, m_height);
+
+  // only region drawn on since last pass re-rendered (spread by blur effects), whole texture after other changes
+  DirtyRegion::Rect rect;
+  bool is_partial = m_dirty.get_bounds(m_revision_dirty_effects, m_effect_chain.get_radius(), rect) && !m_dirty.is_whole(rect);
+  if (is_partial) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(rect.x, rect.y, rect.width, rect.height);
+  }
+
+  // clear framebuffer's attached color buffer before re-rendering
   m_framebuffer.bind();
   m_framebuffer.clear({ 1.0f, 1.0f, 1.0f, 1.0f });
 
   // draw 2d health bar HUD surface (scaling then translation with origin at lower left corner)
-  m_renderer.draw({ {"texture2d", m_texture_shapes} });
+  // with a selection, chain's output only covers its bounding box (input shown as is around it)
+  bool is_selected = !m_selection.is_empty() && !m_effect_chain.is_empty();
+  renderer.draw({ {"texture2d", is_selected ? texture_input : texture_chain} });
+
+  DirtyRegion::Rect rect_selected;
+  if (is_selected && DirtyRegion::intersect(m_selection.get_rect(), is_partial ? rect : DirtyRegion::Rect { 0, 0, m_width, m_height },
+                                            rect_selected)) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(rect_selected.x, rect_selected.y, rect_selected.width, rect_selected.height);
+    renderer.draw({ {"texture2d", texture_chain} });
+    is_partial = true;
+  }
   m_framebuffer.unbind();
+
+  if (is_partial)
+    glDisable(GL_SCISSOR_TEST);
+  m_revision_dirty_effects = m_dirty.get_revision();
+
+  GpuTimer::get().end("effects");
+  m_revision_effects = m_revision;
+}
+
+/* Job listed while effects are rendered over several frames, with fraction of their tiles done */
+void Canvas::update_job_effects() {
+  if (m_effect_chain.is_pending()) {
+    if (!m_job_effects || m_job_effects->is_finished()) {
+      m_job_effects = std::make_shared<Job>("Effects");
+      m_job_effects->status = JobStatus::RUNNING;
+      m_jobs.push_back(m_job_effects);
+    }
+
+    m_job_effects->progress = m_effect_chain.get_progress();
+  } else if (m_job_effects) {
+    m_job_effects->status = JobStatus::DONE;
+    m_job_effects.reset();
+  }
+}
+
+/**
+ * Publish displayed image to shared memory if it changed since last published (with `--share`)
+ * Tiles & read-only images aren't published (no full-size texture)
+ */
+void Canvas::update_shared() {
+  SharedSurface& shared = SharedSurface::get();
+  unsigned int revision = get_revision();
+  if (SharedSurface::name.empty() || m_tiled || m_reference || m_texture_preview || shared.is_current(this, revision))
+    return;
+
+  // published once a time-sliced render of effects is done (not forced at once on every change)
+  if (mode == Mode::NORMAL) {
+    bake();
+    if (m_effect_chain.is_pending())
+      return;
+  }
+
+  // retried once previous publish is done
+  if (!shared.publish(get_texture_export(), this, revision) && shared.is_busy())
+    Redraw::request(1);
+}
+
+/* Read histogram requested in previous frames & request a new one if effects texture changed since */
+void Canvas::update_histogram() {
+  if (!Menu::view_histogram)
+    return;
+
+  if (!m_histogram)
+    m_histogram = std::make_unique<Histogram>();
+  if (m_histogram->has_failed())
+    return;
+
+  bake();
+
+  ImageStats stats;
+  if (m_histogram->poll(stats))
+    m_image_stats = stats;
+
+  if (m_revision_histogram != m_revision_effects && m_histogram->request(m_texture_effects))
+    m_revision_histogram = m_revision_effects;
+}
+
+/* Latest histogram of effects texture (NULL if not computed yet or compute shaders unavailable) */
+const ImageStats* Canvas::get_image_stats() const {
+  return m_image_stats ? &*m_image_stats : NULL;
 }
 
 /**
- * Show image from texture using custom shader
+ * Show visible part of image from texture using custom shader
  * Change to custom shader before rendering image
- * @param y_offset heights of menu & toolbar used to calculate cursor position rel. to image
+ * @param y_offset heights of menu & toolbar (canvas' upper-left corner on screen)
  */
 void Canvas::render_image(float y_offset) {
-  // different texture rendered & attached to fbo if in drawing/normal mode
-  Texture2D texture = (mode == Mode::NORMAL) ? m_texture_effects : m_texture_shapes;
-  m_framebuffer.attach_texture(texture);
+  PROFILE_ZONE("Canvas::render_image");
+
+  // preview stretched to size of full image (no drawing nor tooltips until it's replaced)
+  ImVec2 size_image = m_texture_preview ? m_size_preview : ImVec2(m_width, m_height);
+  m_view.update({ 0.0f, y_offset }, Size::canvas, size_image);
+  navigate();
+
+  // visible sub-rectangle of image, in image pixels then on screen
+  ImVec2 position_visible, size_visible;
+  bool is_visible = m_view.get_visible(position_visible, size_visible);
+  ImVec2 position_screen = m_view.to_screen(position_visible);
+  ImVec2 size_screen = ImVec2(m_view.get_zoom() * size_visible.x, m_view.get_zoom() * size_visible.y);
+  ImVec2 uv_start = ImVec2(position_visible.x / size_image.x, position_visible.y / size_image.y);
+  ImVec2 uv_end = ImVec2((position_visible.x + size_visible.x) / size_image.x, (position_visible.y + size_visible.y) / size_image.y);
+  ImGui::SetCursorScreenPos(position_screen);
+
+  if (!is_visible) {
+    // image panned out of canvas (zero-sized item is never hovered)
+    ImGui::Dummy({ 0.0f, 0.0f });
+    return;
+  }
+
+  if (m_texture_preview) {
+    ImGui::Image((void*)(intptr_t) m_texture_preview->id, size_screen, uv_start, uv_end);
+    return;
+  }
 
-  // only render to surface geometry when not in drawing mode
-  if (mode == Mode::NORMAL)
-    render_to_fbo();
+  if (m_tiled) {
+    // only tiles in visible region (in image pixels) are uploaded & drawn, then space reserved for visible region
+    m_tiled->render(get_renderer(), m_framebuffer, mode == Mode::NORMAL, m_view.get_zoom(), m_view.to_screen({ 0.0f, 0.0f }),
+                    position_visible, size_visible);
+    ImGui::Dummy(size_screen);
+  } else if (m_reference) {
+    // compressed texture shown as is (no effects until image is edited)
+    ImGui::Image((void*)(intptr_t) m_reference->get_texture().id, size_screen, uv_start, uv_end);
+  } else if (mode == Mode::NORMAL && Menu::view_display_resolution && m_selection.is_empty() && !is_comparing()) {
+    // view shader run by imgui on visible region of screen, sampling effects chain's output (mipmapped when zoomed out)
+    // (not with a selection, as chain's output then only covers its bounding box, nor in compare mode)
+    const Texture2D& texture_chain = m_effect_chain.render(get_renderer(), m_programs, m_framebuffer, get_texture_composite());
+    m_framebuffer.attach_texture(m_texture_effects);
+    update_job_effects();
+    update_histogram();
 
-  // render image & graphics drawn on texture attached to fbo
-  // double casting avoids `warning: cast to pointer from integer of different size` i.e. smaller
-  texture.attach();
-  ImVec2 size_image = ImVec2(m_zoom * m_width, m_zoom * m_height);
-  ImGui::Image((void*)(intptr_t) texture.id, size_image);
+    // mipmaps of previous output kept while a time-sliced render is pending (regions drawn meanwhile updated after it)
+    if (m_effect_chain.is_pending())
+      Redraw::request();
+    else
+      m_mip_chain.update(texture_chain, m_dirty, m_view.get_zoom(), m_effect_chain.get_radius());
+    m_display = { texture_chain, position_screen, size_screen, uv_start, uv_end };
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    draw_list->AddCallback(on_draw_display, this);
+    draw_list->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+    ImGui::Dummy(size_screen);
+  } else {
+    // different texture rendered & attached to fbo if in drawing/normal mode (layers composited without effects)
+    const Texture2D& texture = (mode == Mode::NORMAL) ? m_texture_effects : get_texture_composite();
+    m_framebuffer.attach_texture(texture);
+
+    // only render to surface geometry when not in drawing mode
+    if (mode == Mode::NORMAL) {
+      render_to_fbo();
+      update_histogram();
+    }
+
+    // compare mode shows a view of effects texture against reference instead (rendered each frame, without mipmaps)
+    if (is_comparing()) {
+      const Texture2D& texture_view = render_comparison(texture);
+      ImGui::Image((void*)(intptr_t) texture_view.id, size_screen, uv_start, uv_end);
+    } else {
+      // sample mip level matching zoom (regenerated only when content changed)
+      m_mip_chain.update(texture, m_dirty, m_view.get_zoom(), (mode == Mode::NORMAL) ? m_effect_chain.get_radius() : 0);
+
+      // render visible part of image & graphics drawn on texture attached to fbo
+      // double casting avoids `warning: cast to pointer from integer of different size` i.e. smaller
+      texture.attach();
+      ImGui::Image((void*)(intptr_t) texture.id, size_screen, uv_start, uv_end);
+    }
+  }
+
+  // image of tiled mode may exceed max. texture size, so overlay isn't shown over it
+  if (!m_tiled)
+    render_overlay(position_screen, size_screen, uv_start, uv_end);
+  render_selection();
+
+  // shapes & strokes enqueued as commands (in nanovg coords), drawn once dispatched
+  CommandQueue& queue = CommandQueue::get();
+
+  // line ends snapped to nearest strong edge under cursor if any
+  std::optional<ImVec2> position_snapped = snap_to_edge();
 
   // draw circle/line at mouse click position
   if (ImGui::IsItemClicked()) {
     if (Toolbar::draw_circle) {
-      ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position_vg(m_height, y_offset);
-      m_image_vg.draw_circle(m_framebuffer, position_mouse_img.x, position_mouse_img.y);
+      ImVec2 position_mouse_img = get_mouse_position_vg();
+      queue.push({ CommandType::DRAW_CIRCLE, 0, position_mouse_img.x, position_mouse_img.y });
+      queue.push({ CommandType::END_STROKE });
       Menu::draw_circle = false;
       Toolbar::draw_circle = false;
 
@@ -153,10 +583,11 @@ void Canvas::render_image(float y_offset) {
     // two clicks needed to draw a line (cursor saved on 1st click & reset after 2nd)
     if (Toolbar::draw_line) {
       if (cursor.x == VECTOR_UNSET.x && cursor.y == VECTOR_UNSET.y) {
-        move_cursor();
+        cursor = position_snapped.value_or(get_mouse_position_vg());
       } else {
-        ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position_vg(m_height, y_offset);
-        m_image_vg.draw_line(m_framebuffer, cursor.x, cursor.y, position_mouse_img.x, position_mouse_img.y);
+        ImVec2 position_mouse_img = position_snapped.value_or(get_mouse_position_vg());
+        queue.push({ CommandType::DRAW_LINE, 0, cursor.x, cursor.y, position_mouse_img.x, position_mouse_img.y });
+        queue.push({ CommandType::END_STROKE });
 
         cursor = VECTOR_UNSET;
         Menu::draw_line = false;
@@ -166,113 +597,1958 @@ void Canvas::render_image(float y_offset) {
       }
     }
 
-    // set starting point (initial click) for brush line
-    if (Toolbar::brush_line && cursor.x == VECTOR_UNSET.x && cursor.y == VECTOR_UNSET.y) {
+    // set starting point (initial click) for brush line & rectangle selection
+    if ((Toolbar::brush_line || Toolbar::select_rect) && cursor.x == VECTOR_UNSET.x && cursor.y == VECTOR_UNSET.y) {
       move_cursor();
     }
+
+    if (Toolbar::select_lasso) {
+      ImVec2 position_mouse_img = get_mouse_position_vg();
+      queue.push({ CommandType::SELECT_TO, 0, position_mouse_img.x, position_mouse_img.y });
+    }
+
+    // a fill is one operation in history
+    if (Toolbar::fill) {
+      ImVec2 position_mouse_img = get_mouse_position_vg();
+      queue.push({ CommandType::FILL, Toolbar::tolerance, position_mouse_img.x, position_mouse_img.y });
+      queue.push({ CommandType::END_STROKE });
+    } else if (Toolbar::magic_wand) {
+      ImVec2 position_mouse_img = get_mouse_position_vg();
+      queue.push({ CommandType::MAGIC_WAND, Toolbar::tolerance, position_mouse_img.x, position_mouse_img.y });
+    }
   }
 
-  // brush tool paints while LMB dragged
+  // brush tool paints while LMB dragged, through every cursor sample since previous frame
+  // (dabs & segments of a frame drawn at once when strokes are flushed, so accuracy doesn't depend on frame rate)
   // https://github.com/ocornut/imgui/issues/493
   if (ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
     if (Toolbar::brush_circle) {
-      ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position_vg(m_height, y_offset);
-      m_image_vg.draw_circle(m_framebuffer, position_mouse_img.x, position_mouse_img.y);
+      for (const ImVec2& position_mouse_img : get_mouse_positions_vg())
+        queue.push({ CommandType::BRUSH_TO, 0, position_mouse_img.x, position_mouse_img.y });
     }
     else if (Toolbar::brush_line) {
-        ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position_vg(m_height, y_offset);
-        m_image_vg.draw_line(m_framebuffer, cursor.x, cursor.y, position_mouse_img.x, position_mouse_img.y);
-        move_cursor();
+      for (const ImVec2& position_mouse_img : get_mouse_positions_vg()) {
+        queue.push({ CommandType::DRAW_LINE, 0, cursor.x, cursor.y, position_mouse_img.x, position_mouse_img.y });
+        cursor = position_mouse_img;
+      }
     }
+    else if (Toolbar::select_lasso) {
+      ImVec2 position_mouse_img = get_mouse_position_vg();
+      queue.push({ CommandType::SELECT_TO, 0, position_mouse_img.x, position_mouse_img.y });
+    }
+  }
+
+  // selection made on mouse release (a click without dragging clears it)
+  if (ImGui::IsMouseReleased(ImGuiMouseButton_Left) && Toolbar::select_rect && cursor.x != VECTOR_UNSET.x) {
+    ImVec2 position_mouse_img = get_mouse_position_vg();
+    queue.push({ CommandType::SELECT_RECT, 0, cursor.x, cursor.y, position_mouse_img.x, position_mouse_img.y });
+    cursor = VECTOR_UNSET;
   }
+  if (ImGui::IsMouseReleased(ImGuiMouseButton_Left) && Toolbar::select_lasso)
+    queue.push({ CommandType::END_SELECTION });
 
   // unset cursor position when mouse released in brush line mode
-  if (ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
+  if (ImGui::IsMouseReleased(ImGuiMouseButton_Left) && (Toolbar::brush_circle || Toolbar::brush_line)) {
     if (Toolbar::brush_line)
       cursor = VECTOR_UNSET;
+
+    // a brush stroke is one operation in history
+    queue.push({ CommandType::END_STROKE });
   }
 
   if (ImGui::IsItemHovered()) {
     // show tooltip containing zoomed subset image (source: imgui_demo.cpp:986) or pixel value accord. to toolbar radio button
-    if (Toolbar::hover_mode == HoverMode::IMAGE_SUBSET) {
-      m_tooltip_image.render(y_offset, m_zoom);
+    ImVec2 position_mouse_img = get_mouse_position();
+    if (m_tiled) {
+      render_tooltips_tiled(position_mouse_img);
+    } else if (m_reference) {
+      render_tooltips_reference(position_mouse_img);
+    } else if (Toolbar::hover_mode == HoverMode::IMAGE_SUBSET) {
+      if (mode == Mode::NORMAL)
+        bake();
+      m_tooltip_image.render(position_mouse_img, m_view.get_zoom());
     } else if (Toolbar::hover_mode == HoverMode::PIXEL_VALUE) {
-      float y_scroll = ImGui::GetScrollY();
-      m_tooltip_pixel.render(y_offset, y_scroll);
+      if (mode == Mode::NORMAL)
+        bake();
+      m_tooltip_pixel.render(position_mouse_img);
+    } else if (Toolbar::hover_mode == HoverMode::NEIGHBOURHOOD) {
+      if (mode == Mode::NORMAL)
+        bake();
+      m_tooltip_neighbourhood.render(position_mouse_img, Toolbar::size_neighbourhood);
     }
 
     // change to hand cursor if hovering in drawing mode
-    if (Toolbar::draw_circle || Toolbar::draw_line || Toolbar::brush_circle || Toolbar::brush_line)
+    if (Toolbar::draw_circle || Toolbar::draw_line || Toolbar::brush_circle || Toolbar::brush_line || Toolbar::fill)
       ImGui::SetMouseCursor(ImGuiMouseCursor_Hand);
+    else if (Toolbar::select_rect || Toolbar::select_lasso || Toolbar::magic_wand)
+      ImGui::SetMouseCursor(ImGuiMouseCursor_ResizeAll);
+  }
+}
+
+/**
+ * Draw callback run by imgui's renderer between canvas window's draw commands
+ * Imgui's render state (program, viewport, buffers) restored by `ImDrawCallback_ResetRenderState` queued after it
+ */
+void Canvas::on_draw_display(const ImDrawList* draw_list, const ImDrawCmd* command) {
+  static_cast<Canvas*>(command->UserCallbackData)->render_display();
+}
+
+/**
+ * Render visible region of effects chain's output with view shader straight to screen (one fragment per screen pixel)
+ * Clipped by scissor rect set by imgui for canvas window
+ */
+void Canvas::render_display() {
+  // viewport in framebuffer pixels, origin at lower-left corner
+  ImGuiIO& io = ImGui::GetIO();
+  ImVec2 scale = io.DisplayFramebufferScale;
+  glViewport((GLint) (m_display->position.x * scale.x),
+             (GLint) ((io.DisplaySize.y - m_display->position.y - m_display->size.y) * scale.y),
+             (GLsizei) (m_display->size.x * scale.x), (GLsizei) (m_display->size.y * scale.y));
+
+  // uv flipped vertically, as lower-left corner of viewport shows first row of image (top one on screen)
+  GLint location = m_programs.get_location(m_shader_view, "uv_rect");
+  Renderer& renderer = get_renderer();
+  renderer.program.use();
+  glUniform4f(location, m_display->uv_start.x, m_display->uv_end.y, m_display->uv_end.x, m_display->uv_start.y);
+  renderer.program.unuse();
+
+  renderer.draw({ {"texture2d", m_display->texture} });
+
+  // whole texture sampled again when rendering to fbo
+  renderer.program.use();
+  glUniform4f(location, 0.0f, 0.0f, 1.0f, 1.0f);
+  renderer.program.unuse();
+}
+
+/**
+ * Shapes of overlay drawn over visible region of image (same uv as image), from texture rendered once they changed
+ * Added to draw list without an item, so canvas stays the hovered item for drawing & tooltips
+ */
+void Canvas::render_overlay(const ImVec2& position_screen, const ImVec2& size_screen, const ImVec2& uv_start, const ImVec2& uv_end) {
+  if (!Menu::view_overlay || m_overlay.empty())
+    return;
+
+  const Texture2D* texture = m_overlay.update(GpuResources::get().get_vg(), m_width, m_height);
+  if (texture == NULL)
+    return;
+
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  draw_list->AddCallback(on_draw_overlay, NULL);
+  draw_list->AddImage((void*)(intptr_t) texture->id, position_screen,
+                      { position_screen.x + size_screen.x, position_screen.y + size_screen.y }, uv_start, uv_end);
+  draw_list->AddCallback(ImDrawCallback_ResetRenderState, NULL);
+}
+
+/* Overlay's colors are premultiplied by nanovg, so blended as such (imgui's blending restored after it) */
+void Canvas::on_draw_overlay(const ImDrawList* draw_list, const ImDrawCmd* command) {
+  glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+/**
+ * Tooltips read from the (resident) tile under the cursor
+ * @param position_mouse_img Hovered position in image pixels (origin at upper-left corner)
+ */
+void Canvas::render_tooltips_tiled(const ImVec2& position_mouse_img) {
+  bool has_effects = mode == Mode::NORMAL;
+  ImVec2 origin_tile;
+  const Texture2D* texture = m_tiled->attach_tile(m_framebuffer, has_effects, position_mouse_img.x, position_mouse_img.y, origin_tile);
+  if (texture == NULL)
+    return;
+
+  if (Toolbar::hover_mode == HoverMode::IMAGE_SUBSET)
+    m_tooltip_image.render(position_mouse_img, m_view.get_zoom(), texture, origin_tile);
+  else if (Toolbar::hover_mode == HoverMode::PIXEL_VALUE)
+    m_tooltip_pixel.render(position_mouse_img, origin_tile);
+  else if (Toolbar::hover_mode == HoverMode::NEIGHBOURHOOD)
+    m_tooltip_neighbourhood.render(position_mouse_img, Toolbar::size_neighbourhood, origin_tile);
+}
+
+/**
+ * Zoomed subset sampled from compressed texture, pixel values read from cpu copy (exact)
+ * @param position_mouse_img Hovered position in image pixels (origin at upper-left corner)
+ */
+void Canvas::render_tooltips_reference(const ImVec2& position_mouse_img) {
+  if (Toolbar::hover_mode == HoverMode::IMAGE_SUBSET) {
+    m_tooltip_image.render(position_mouse_img, m_view.get_zoom(), &m_reference->get_texture());
+  } else if (Toolbar::hover_mode == HoverMode::PIXEL_VALUE || Toolbar::hover_mode == HoverMode::NEIGHBOURHOOD) {
+    const Image* image = m_reference->get_image_async(m_worker_decode);
+    if (Toolbar::hover_mode == HoverMode::PIXEL_VALUE)
+      m_tooltip_pixel.render_cpu(position_mouse_img, image);
+    else
+      m_tooltip_neighbourhood.render_cpu(position_mouse_img, Toolbar::size_neighbourhood, image);
+
+    // keep polling until cpu copy is decoded
+    if (image == NULL)
+      Redraw::request();
   }
 }
 
+/**
+ * Draw circle on image (single texture or tiles) & mark effects as outdated
+ * @param x,y Center in nanovg coords (origin at lower-left corner)
+ */
+void Canvas::draw_circle(float x, float y) {
+  if (!make_editable())
+    return;
+
+  if (m_tiled) {
+    m_tiled->draw_circle(m_image_vg, m_framebuffer, x, y);
+    Redraw::request();
+  } else {
+    // save tiles under shape before it's drawn (origin at upper-left corner)
+    float r = ImageVG::RADIUS_CIRCLE;
+    get_history().touch(x - r, m_height - y - r, x + r, m_height - y + r);
+    m_image_vg.draw_circle(m_framebuffer, x, y);
+    invalidate(x - r, m_height - y - r, x + r, m_height - y + r);
+  }
+}
+
+/**
+ * Draw line on image (single texture or tiles) & mark effects as outdated
+ * @param x1,y1,x2,y2 End points in nanovg coords (origin at lower-left corner)
+ */
+void Canvas::draw_line(float x1, float y1, float x2, float y2) {
+  if (!make_editable())
+    return;
+
+  if (m_tiled) {
+    m_tiled->draw_line(m_image_vg, m_framebuffer, x1, y1, x2, y2);
+    Redraw::request();
+  } else {
+    // save tiles under shape before it's drawn (origin at upper-left corner)
+    float r = ImageVG::WIDTH_STROKE / 2.0f;
+    float x_min = std::min(x1, x2) - r, x_max = std::max(x1, x2) + r;
+    float y_min = m_height - std::max(y1, y2) - r, y_max = m_height - std::min(y1, y2) + r;
+    get_history().touch(x_min, y_min, x_max, y_max);
+    m_image_vg.draw_line(m_framebuffer, x1, y1, x2, y2);
+    invalidate(x_min, y_min, x_max, y_max);
+  }
+}
+
+/**
+ * Extend circle brush stroke to given position (dabs interpolated along path)
+ * Tiles aren't supported by the stamp brush (one dab drawn per frame with nanovg instead)
+ * @param x,y Position in nanovg coords (origin at lower-left corner)
+ */
+void Canvas::brush_to(float x, float y) {
+  if (!make_editable())
+    return;
+
+  if (m_tiled) {
+    draw_circle(x, y);
+    return;
+  }
+
+  // dabs not drawn yet (until strokes are flushed), but their bounds are known
+  m_brush.move_to(x, y);
+  float x_min, y_min, x_max, y_max;
+  if (m_brush.get_bounds(x_min, y_min, x_max, y_max))
+    invalidate(x_min, m_height - y_max, x_max, m_height - y_min);
+}
+
+/**
+ * Draw shapes & brush dabs queued by commands dispatched in this frame at once
+ * Drawn on image texture (tracked by history), whether or not drawing mode shows it without effects
+ */
+void Canvas::flush_strokes() {
+  // tiles flush their shapes while attached (nothing drawn on read-only image)
+  if (m_tiled || m_reference)
+    return;
+
+  // save tiles under brush dabs before they're drawn
+  float x_min, y_min, x_max, y_max;
+  if (m_brush.get_bounds(x_min, y_min, x_max, y_max))
+    get_history().touch(x_min, m_height - y_max, x_max, m_height - y_min);
+
+  m_framebuffer.attach_texture(get_texture_target());
+  m_image_vg.flush();
+  m_brush.flush(m_framebuffer);
+}
+
+/* Shape or brush stroke drawn so far becomes one operation in history */
+void Canvas::end_stroke() {
+  flush_strokes();
+  m_brush.end_stroke();
+
+  // budgets set in memory panel enforced by commit
+  MemoryTracker& tracker = MemoryTracker::get();
+  get_history().set_budgets(tracker.get_budget(MemoryBudget::UNDO_GPU), tracker.get_budget(MemoryBudget::UNDO_CPU));
+  get_history().commit();
+}
+
 /* Define line's start point */
 void Canvas::move_cursor() {
-  // float y_offset = Size::menu.y + Size::toolbar.y;
-  // ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position({ 0.0f, y_offset });
-  float y_offset = Size::menu.y + Size::toolbar.y;
-  ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position_vg(m_height, y_offset);
+  cursor = get_mouse_position_vg();
+}
 
-  cursor = position_mouse_img;
+/* Mouse cursor position in image pixels (origin at upper-left corner), exact at any zoom & pan */
+ImVec2 Canvas::get_mouse_position() const {
+  return m_view.to_image(ImGui::GetIO().MousePos);
 }
 
-/* Change image opened in canvas to given `path_image` */
-void Canvas::change_image(const std::string& path_image) {
-  // replace image texture & reset shader
-  Image image_new = Image(path_image, false);
-  m_texture_shapes.set_image(image_new);
-  m_renderer.program = m_programs.at("color");
+/* Mouse cursor position relative to nanovg's origin (lower-left corner) to draw shapes */
+ImVec2 Canvas::get_mouse_position_vg() const {
+  ImVec2 position_mouse_img = get_mouse_position();
+  return ImVec2(position_mouse_img.x, m_height - position_mouse_img.y);
+}
 
-  // update dimensions (needed to get mouse coord rel. to image)
-  m_width = image_new.width;
-  m_height = image_new.height;
+/**
+ * Cursor positions received since previous frame relative to nanovg's origin, in order (empty if cursor didn't move)
+ * Samples are mapped with current view, so they land where the stroke is seen even if first ones predate a zoom or pan
+ */
+std::vector<ImVec2> Canvas::get_mouse_positions_vg() const {
+  std::vector<ImVec2> positions;
+  for (const CursorSamples::Sample& sample : CursorSamples::get()) {
+    ImVec2 position_img = m_view.to_image({ sample.x, sample.y });
+    positions.push_back({ position_img.x, m_height - position_img.y });
+  }
+
+  return positions;
 }
 
-/* Save image opened in canvas to given `path_image` */
-void Canvas::save_image(const std::string& path_image) {
-  // modified image retrieved from opengl texture (from gpu)
-  Image image = m_texture_effects.get_image();
+/**
+ * Zoom with mouse wheel around hovered pixel & pan by dragging with middle button
+ * (or left one when no drawing tool is selected), enqueued as commands like zoom buttons
+ */
+void Canvas::navigate() {
+  ImGuiIO& io = ImGui::GetIO();
+  CommandQueue& queue = CommandQueue::get();
+  bool is_hovered = ImGui::IsWindowHovered();
+
+  // 2x zoom every 4 notches of mouse wheel (finer steps with touchpads)
+  if (is_hovered && io.MouseWheel != 0.0f) {
+    ImVec2 position_mouse_img = get_mouse_position_vg();
+    queue.push({ CommandType::ZOOM, 0, position_mouse_img.x, position_mouse_img.y, std::exp2(io.MouseWheel / 4.0f) });
+  }
 
-  // save image on disk & free pointer
-  image.save(path_image);
-  image.free();
+  bool has_tool = Toolbar::draw_circle || Toolbar::draw_line || Toolbar::brush_circle || Toolbar::brush_line ||
+                  Toolbar::select_rect || Toolbar::select_lasso || Toolbar::fill || Toolbar::magic_wand;
+  if (is_hovered && (ImGui::IsMouseClicked(ImGuiMouseButton_Middle) || (!has_tool && ImGui::IsMouseClicked(ImGuiMouseButton_Left))))
+    m_is_panning = true;
+  if (!ImGui::IsMouseDown(ImGuiMouseButton_Middle) && !ImGui::IsMouseDown(ImGuiMouseButton_Left))
+    m_is_panning = false;
+
+  // image follows cursor (displacement in image pixels, y-axis flipped to nanovg convention)
+  if (m_is_panning && (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f)) {
+    float zoom = m_view.get_zoom();
+    queue.push({ CommandType::PAN, 0, -io.MouseDelta.x / zoom, io.MouseDelta.y / zoom });
+  }
 }
 
-/* Convert image to grayscale on gpu (through shader & fbo) */
-void Canvas::to_grayscale() {
-  m_renderer.program = m_programs.at("grayscale");
+/**
+ * Change image opened in canvas to given `path_image`
+ * Returns immediately: image decoded in background & uploaded over next frames (see `update_opens()`)
+ * @param is_read_only Whether image is shown compressed (for viewing & inspecting it only)
+ */
+void Canvas::change_image(const std::string& path_image, bool is_read_only) {
+  m_sequence.stop();
+  std::shared_ptr<Open> open = decode(path_image, m_worker_decode, true, is_read_only);
+  m_opens.push_back(open);
+  m_jobs.push_back(open->job);
 }
 
-/* Blur image using a 9x9 avg. filter */
-void Canvas::blur() {
-  m_renderer.program = m_programs.at("blur");
+/**
+ * Decode image on given worker (for opens & prefetches)
+ * @param has_preview Whether a reduced-size preview of large jpeg is decoded first
+ * @param is_read_only Whether image is also compressed into blocks (read from disk cache if encoded before)
+ * @return Open whose job status is UPLOAD once decoded image (or blocks) is set (or FAILED)
+ */
+std::shared_ptr<Canvas::Open> Canvas::decode(const std::string& path, Worker& worker, bool has_preview, bool is_read_only) {
+  std::shared_ptr<Open> open = std::make_shared<Open>();
+  open->path = path;
+  open->has_preview = false;
+  open->is_canceled = false;
+  open->depth = Depth::UNORM8;
+  open->job = std::make_shared<Job>("Open " + path);
+
+  // gpu capabilities queried on main thread (bc4 always supported, bc1 & bc3 with s3tc)
+  int size_texture_max = m_size_texture_max;
+  bool has_s3tc = is_read_only && ReferenceImage::is_supported(BlockEncoder::Codec::BC1);
+  auto is_compressible = [is_read_only, has_s3tc, size_texture_max](int width, int height, BlockEncoder::Codec codec) {
+    bool is_supported = codec == BlockEncoder::Codec::BC4 || has_s3tc;
+    return is_read_only && is_supported && width <= size_texture_max && height <= size_texture_max;
+  };
+
+  worker.submit([open, has_preview, size_texture_max, is_read_only, is_compressible]() {
+    // skipped if no longer wanted by the time it's reached
+    if (open->is_canceled) {
+      open->job->status = JobStatus::FAILED;
+      return;
+    }
+
+    open->job->status = JobStatus::RUNNING;
+
+    // blocks cached by a previous read-only open: no decoding (cpu copy decoded on first pixel query)
+    std::string path_cache = is_read_only ? BlockEncoder::get_path_cache(open->path) : "";
+    std::shared_ptr<BlockEncoder::Blocks> blocks = std::make_shared<BlockEncoder::Blocks>();
+    if (!path_cache.empty() && BlockEncoder::read(path_cache, *blocks) &&
+        is_compressible(blocks->width, blocks->height, blocks->codec)) {
+      open->blocks = blocks;
+      open->job->status = JobStatus::UPLOAD;
+      Redraw::request_async();
+      return;
+    }
+
+    // pyramid given or cached by a previous open: only its index is read (tiles decoded when visible)
+    bool is_pyramid = PyramidFile::is_pyramid(open->path);
+    std::string path_pyramid = is_pyramid ? open->path : PyramidFile::get_path_cache(open->path);
+    std::shared_ptr<PyramidFile> pyramid = std::make_shared<PyramidFile>();
+    if (!path_pyramid.empty() && pyramid->open(path_pyramid)) {
+      if (!is_pyramid)
+        PyramidFile::use_cache(path_pyramid);
+      open->pyramid = pyramid;
+      open->job->status = JobStatus::UPLOAD;
+      Redraw::request_async();
+      return;
+    }
+
+    if (is_pyramid) {
+      open->job->status = JobStatus::FAILED;
+      Redraw::request_async();
+      return;
+    }
+
+    // decoded pixels freed when last reference dropped (i.e. after upload)
+    auto deleter = [](Image* image) {
+      image->free();
+      delete image;
+    };
+
+    // large jpeg first decoded at a fraction of its size (a few ms), shown while full image decodes
+    ImageDecoder::Info info;
+    if (has_preview && ImageDecoder::get_info(open->path, info) && info.is_reducible && info.height >= 2 * HEIGHT_PREVIEW) {
+      std::shared_ptr<Image> preview(new Image(ImageDecoder::decode(open->path, HEIGHT_PREVIEW)), deleter);
+      if (preview->data != NULL && preview->height < info.height) {
+        open->width = info.width;
+        open->height = info.height;
+        open->preview = preview;
+        open->has_preview = true;
+        Redraw::request_async();
+      }
+    }
+
+    Depth depth;
+    std::shared_ptr<Image> image(new Image(ImageDecoder::decode(open->path, 0, &depth)), deleter);
+    if (depth != Depth::UNORM8 && (image->width > size_texture_max || image->height > size_texture_max)) {
+      ImageDecoder::reduce_to_8bit(*image);
+      depth = Depth::UNORM8;
+    }
+    // read-only image kept as its 8-bit cpu copy (for pixel queries) & its blocks
+    if (image->data != NULL && is_compressible(image->width, image->height, BlockEncoder::get_codec(image->n_channels))) {
+      if (depth != Depth::UNORM8)
+        ImageDecoder::reduce_to_8bit(*image);
+      depth = Depth::UNORM8;
+
+      BlockEncoder::encode(*image, *blocks);
+      if (!path_cache.empty())
+        BlockEncoder::write(path_cache, *blocks);
+      open->blocks = blocks;
+    }
+    open->depth = depth;
+
+    // pyramid of image too large for a texture cached for next opens (written before tiles can be painted)
+    bool is_large = image->width > size_texture_max || image->height > size_texture_max;
+    if (image->data != NULL && is_large && !path_pyramid.empty() && PyramidFile::write(*image, path_pyramid, 1))
+      PyramidFile::use_cache(path_pyramid);
+
+    // image set before status, so main thread sees it once status changes
+    if (image->data == NULL) {
+      open->job->status = JobStatus::FAILED;
+    } else {
+      open->image = image;
+      open->job->status = JobStatus::UPLOAD;
+    }
+
+    Redraw::request_async();
+  });
+
+  return open;
 }
 
-/* Free opengl texture (image holder) & shaders programs used to display it */
-void Canvas::free() {
-  for (auto& pair: m_programs) {
-    pair.second.free();
+/**
+ * Show image `step` positions after (or before if negative) current one in its folder (browse mode)
+ * Swaps textures if image was prefetched, otherwise opened like any other image
+ */
+void Canvas::browse(int step) {
+  m_sequence.stop();
+
+  // step from last image requested (which may still be opening)
+  std::string path_current = m_path_image;
+  for (const auto& open : m_opens) {
+    if (!open->is_canceled)
+      path_current = open->path;
   }
 
-  // destroy buffers
-  m_renderer.free();
+  update_folder(path_current);
+  auto it = std::find(m_paths_folder.begin(), m_paths_folder.end(), path_current);
+  if (it == m_paths_folder.end())
+    return;
 
-  // destroy texures
-  m_texture_shapes.free();
-  m_texture_effects.free();
+  int i_path = (it - m_paths_folder.begin()) + step;
+  if (i_path < 0 || i_path >= (int) m_paths_folder.size())
+    return;
 
-  // destroy nanovg context
-  m_image_vg.free();
+  // images still opening are superseded (e.g. arrow key held down)
+  const std::string path = m_paths_folder[i_path];
+  for (const auto& open : m_opens)
+    open->is_canceled = true;
 
-  // destroy framebuffer
-  m_framebuffer.free();
+  std::optional<Texture2D> texture = m_cache.take(path);
+  if (!texture) {
+    change_image(path);
+    return;
+  }
+
+  // edited image not cached (stepping back to it shows the file on disk)
+  bool is_edited = m_history.get_n_undo() > 0 || m_history.get_n_redo() > 0 || m_layers;
+  bool is_cached = !m_tiled && !m_reference && !is_edited && !m_path_image.empty();
+  if (is_cached)
+    m_cache.insert(m_path_image, m_texture_shapes);
+
+  replace_texture(*texture, !is_cached);
+  m_path_image = path;
 }
 
-void Canvas::zoom_in() {
-  m_zoom *= 2.0f;
+/**
+ * Play numbered sequence of images `path` belongs to (current image if empty) in a loop, with current effects
+ * Stopped by another open or browse, or when `fps` is 0
+ * Tiled & read-only images can't be played (frames must fit in an uncompressed texture)
+ */
+void Canvas::play_sequence(const std::string& path, int fps) {
+  if (fps <= 0 || m_tiled || m_reference) {
+    m_sequence.stop();
+    return;
+  }
+
+  end_stroke();
+  if (m_sequence.start(path.empty() ? m_path_image : path, fps))
+    Redraw::request();
 }
 
-void Canvas::zoom_out() {
-  m_zoom /= 2.0f;
+bool Canvas::is_playing() const {
+  return m_sequence.is_playing();
+}
+
+/**
+ * Show frame due of sequence being played (effects chain re-run on it when canvas is rendered)
+ * Image texture replaced on first frame & when frame size changes, keeping effects stages
+ */
+void Canvas::update_sequence() {
+  if (!m_sequence.is_playing())
+    return;
+
+  if (m_sequence.has_failed()) {
+    std::cout << "Failed to decode any frame of sequence, playback stopped" << '\n';
+    m_sequence.stop();
+    return;
+  }
+
+  // next frame due at source frame rate even without input
+  Redraw::request();
+  std::shared_ptr<Image> frame = m_sequence.get_frame();
+  if (!frame)
+    return;
+
+  if (m_sequence.get_n_shown() == 1 || frame->width != m_width || frame->height != m_height || m_depth != Depth::UNORM8 ||
+      frame->n_channels != PixelFormat::get_n_channels(m_texture_shapes)) {
+    std::vector<Effect> effects = m_effect_chain.get_effects();
+    Texture2D texture = TexturePool::get().acquire(frame->width, frame->height, frame->n_channels, Depth::UNORM8,
+                                                   TextureCache::OWNER_TAKEN);
+    replace_texture(texture, true);
+    for (const Effect& effect : effects)
+      m_effect_chain.push(effect.shader, effect.parameters);
+  }
+
+  m_sequence.upload(m_texture_shapes, *frame);
+  invalidate();
+}
+
+/**
+ * Enter compare mode against image `path` (decoded in background), change its view, or leave it (view `NONE`)
+ * @param path Reference image (empty: current one kept)
+ * @param gain Scale of error in difference & heatmap views
+ */
+void Canvas::compare(const std::string& path, CompareView view, float gain) {
+  if (view == CompareView::NONE) {
+    release_compare();
+    m_comparison = { "", CompareView::NONE, gain, false, false, {} };
+    Redraw::request();
+    return;
+  }
+
+  m_comparison.view = view;
+  m_comparison.gain = gain;
+  Redraw::request();
+  if (path.empty() || path == m_comparison.path)
+    return;
+
+  // 8-bit decode (metrics defined on normalized 8-bit channels)
+  std::shared_ptr<Open> open = std::make_shared<Open>();
+  open->path = path;
+  open->has_preview = false;
+  open->is_canceled = false;
+  open->depth = Depth::UNORM8;
+  open->job = std::make_shared<Job>("Compare " + path);
+  m_worker_decode.submit([open]() {
+    if (open->is_canceled) {
+      open->job->status = JobStatus::FAILED;
+      return;
+    }
+
+    open->job->status = JobStatus::RUNNING;
+    auto deleter = [](Image* image) {
+      image->free();
+      delete image;
+    };
+    std::shared_ptr<Image> image(new Image(ImageDecoder::decode(open->path)), deleter);
+    if (image->data == NULL) {
+      open->job->status = JobStatus::FAILED;
+    } else {
+      open->image = image;
+      open->job->status = JobStatus::UPLOAD;
+    }
+
+    Redraw::request_async();
+  });
+
+  // reference still decoding superseded
+  if (m_open_compare)
+    m_open_compare->is_canceled = true;
+  m_open_compare = open;
+  m_comparison.path = path;
+  m_jobs.push_back(open->job);
+}
+
+/* Effects texture shown against a reference (only normal mode of an editable image, not while drawing) */
+bool Canvas::is_comparing() const {
+  return m_comparison.view != CompareView::NONE && m_texture_compare && mode == Mode::NORMAL && !m_tiled && !m_reference &&
+         !m_texture_preview;
+}
+
+const Canvas::Comparison& Canvas::get_comparison() const {
+  return m_comparison;
+}
+
+/* Upload decoded reference in one go (replaces previous one, whose metrics are dropped) */
+void Canvas::update_compare_open() {
+  if (!m_open_compare || (!m_open_compare->job->is_finished() && m_open_compare->job->status != JobStatus::UPLOAD))
+    return;
+
+  // nothing compared to, if reference couldn't be decoded
+  std::shared_ptr<Open> open = m_open_compare;
+  m_open_compare.reset();
+  release_compare();
+  if (open->job->status != JobStatus::UPLOAD) {
+    m_comparison.path = "";
+    return;
+  }
+
+  const Image& image = *open->image;
+  Texture2D texture = TexturePool::get().acquire(image.width, image.height, image.n_channels, Depth::UNORM8, "comparison");
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, texture.format, GL_UNSIGNED_BYTE, image.data);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  m_texture_compare = texture;
+  m_comparison.is_loaded = true;
+  m_n_references++;
+  open->job->status = JobStatus::DONE;
+  Redraw::request();
+}
+
+/**
+ * View of effects texture against reference, & metrics polled/requested if either changed since last request
+ * Framebuffer attachment is restored to effects texture (read by tooltips)
+ */
+const Texture2D& Canvas::render_comparison(const Texture2D& texture) {
+  PROFILE_ZONE("Canvas::render_comparison");
+  if (!m_image_comparison)
+    m_image_comparison = std::make_unique<ImageComparison>(m_programs);
+
+  const Texture2D& reference = *m_texture_compare;
+  Similarity similarity;
+  if (m_image_comparison->poll(similarity) && m_n_references_requested == m_n_references)
+    m_comparison.similarity = similarity;
+
+  bool is_same_size = reference.width == texture.width && reference.height == texture.height;
+  m_comparison.has_metrics = m_image_comparison->has_metrics() && is_same_size;
+  if (!is_same_size)
+    m_comparison.similarity.reset();
+
+  bool is_outdated = m_revision_compared != m_revision_effects || m_n_references_requested != m_n_references;
+  if (m_comparison.has_metrics && is_outdated && m_image_comparison->request(texture, reference)) {
+    m_revision_compared = m_revision_effects;
+    m_n_references_requested = m_n_references;
+  }
+
+  // flicker view keeps alternating without input
+  bool is_reference = false;
+  if (m_comparison.view == CompareView::FLICKER) {
+    is_reference = std::fmod(ImGui::GetTime(), 2.0 * ImageComparison::PERIOD_FLICKER) >= ImageComparison::PERIOD_FLICKER;
+    Redraw::request(1);
+  }
+
+  // metrics of next frames still polled while they're computed
+  if (m_image_comparison->is_pending())
+    Redraw::request(1);
+
+  const Texture2D& texture_view = m_image_comparison->render(get_renderer(), m_framebuffer, texture, reference,
+                                                             m_comparison.view, m_comparison.gain, is_reference);
+  m_framebuffer.attach_texture(texture);
+  return texture_view;
+}
+
+/* Reference texture given back to pool (view & metrics buffers kept for next comparison) */
+void Canvas::release_compare() {
+  if (m_open_compare)
+    m_open_compare->is_canceled = true;
+  m_open_compare.reset();
+
+  if (m_texture_compare)
+    TexturePool::get().release(*m_texture_compare);
+  m_texture_compare.reset();
+  m_comparison.is_loaded = false;
+  m_comparison.similarity.reset();
+}
+
+/* Images in folder of `path` sorted by name (extensions of open dialog's filter) */
+void Canvas::update_folder(const std::string& path) {
+  namespace fs = std::filesystem;
+  m_paths_folder.clear();
+
+  std::error_code error;
+  fs::path dir = fs::path(path).parent_path();
+  for (const auto& entry : fs::directory_iterator(dir.empty() ? fs::path(".") : dir, error)) {
+    std::string extension = entry.path().extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    if ((extension == ".jpg" || extension == ".jpeg" || extension == ".png") && entry.is_regular_file(error))
+      m_paths_folder.push_back(entry.path().string());
+  }
+
+  std::sort(m_paths_folder.begin(), m_paths_folder.end());
+}
+
+/**
+ * Upload next band of a decoded neighbour into cache (only while no image is being opened),
+ * & prefetch neighbours of current image once it changed
+ */
+void Canvas::update_prefetches() {
+  m_cache.set_n_bytes_max(MemoryTracker::get().get_budget(MemoryBudget::PREFETCH));
+
+  // cache dropped once browsing stops (prefetches in flight discarded when they finish)
+  if (!Menu::browse_folder) {
+    for (const auto& open : m_prefetches)
+      open->is_canceled = true;
+    if (m_cache.get_size() > 0)
+      m_cache.free();
+    m_path_prefetched.clear();
+  }
+
+  while (!m_prefetches.empty()) {
+    std::shared_ptr<Open> open = m_prefetches.front();
+    JobStatus status = open->job->status;
+    if (status == JobStatus::FAILED || (status == JobStatus::UPLOAD && open->is_canceled && !m_texture_prefetch)) {
+      m_prefetches.pop_front();
+      continue;
+    }
+
+    if (status != JobStatus::UPLOAD || m_uploader.is_busy())
+      break;
+
+    // images too large for a single texture aren't prefetched (opened in tiled mode)
+    if (!m_texture_prefetch) {
+      if (open->pyramid) {
+        open->pyramid->free();
+        m_prefetches.pop_front();
+        continue;
+      }
+
+      const Image& image = *open->image;
+      if (image.width > m_size_texture_max || image.height > m_size_texture_max) {
+        m_prefetches.pop_front();
+        continue;
+      }
+
+      m_texture_prefetch.emplace(TexturePool::get().acquire(image.width, image.height, image.n_channels, open->depth,
+                                                           TextureCache::OWNER));
+      m_uploader_prefetch.start(*m_texture_prefetch, open->image, open->depth);
+      open->image.reset();
+    }
+
+    if (m_uploader_prefetch.update()) {
+      m_cache.insert(open->path, *m_texture_prefetch);
+      m_texture_prefetch.reset();
+      open->job->status = JobStatus::DONE;
+      m_prefetches.pop_front();
+    }
+
+    // keep uploading in next frames even if app is idle
+    Redraw::request();
+    break;
+  }
+
+  if (!Menu::browse_folder || m_path_image.empty() || m_path_image == m_path_prefetched)
+    return;
+
+  // neighbours prefetched, others no longer decoded nor uploaded
+  m_path_prefetched = m_path_image;
+  update_folder(m_path_image);
+  auto it = std::find(m_paths_folder.begin(), m_paths_folder.end(), m_path_image);
+  if (it == m_paths_folder.end())
+    return;
+
+  std::vector<std::string> paths;
+  int i_current = it - m_paths_folder.begin();
+  for (int offset = -N_PREFETCH_BEFORE; offset <= N_PREFETCH_AFTER; offset++) {
+    int i_path = i_current + offset;
+    if (offset != 0 && i_path >= 0 && i_path < (int) m_paths_folder.size())
+      paths.push_back(m_paths_folder[i_path]);
+  }
+
+  for (const auto& open : m_prefetches) {
+    if (std::find(paths.begin(), paths.end(), open->path) == paths.end())
+      open->is_canceled = true;
+  }
+
+  for (const std::string& path : paths) {
+    if (m_cache.contains(path)) {
+      m_cache.touch(path);
+      continue;
+    }
+
+    bool is_pending = std::any_of(m_prefetches.begin(), m_prefetches.end(), [&path](const std::shared_ptr<Open>& open) {
+      return open->path == path && !open->is_canceled;
+    });
+    if (!is_pending)
+      m_prefetches.push_back(decode(path, m_worker_prefetch, false));
+  }
+}
+
+/* Upload preview of image being opened & show it in place of current image */
+void Canvas::show_preview(Open& open) {
+  hide_preview();
+  m_texture_preview.emplace(*open.preview);
+  PixelFormat::swizzle_gray(*m_texture_preview);
+  m_size_preview = { (float) open.width, (float) open.height };
+  open.preview.reset();
+  Redraw::request();
+}
+
+void Canvas::hide_preview() {
+  if (!m_texture_preview)
+    return;
+
+  m_texture_preview->free();
+  m_texture_preview.reset();
+}
+
+/**
+ * Show `texture` in place of current image, leaving tiled mode & resetting shader, effects & history
+ * @param is_freed Whether current texture is given back to pool (false if it's kept elsewhere, e.g. in browse cache)
+ */
+void Canvas::replace_texture(const Texture2D& texture, bool is_freed) {
+  if (is_freed)
+    TexturePool::get().release(m_texture_shapes);
+  m_texture_shapes = texture;
+  hide_preview();
+  if (m_tiled) {
+    m_tiled->free();
+    m_tiled.reset();
+  }
+  if (m_reference) {
+    m_reference->free();
+    m_reference.reset();
+  }
+  clear_layers();
+  clear_selection();
+  set_program_view(get_shader_view());
+  m_effect_chain.clear();
+  invalidate();
+
+  // update dimensions (needed to get mouse coord rel. to image)
+  m_width = m_texture_shapes.width;
+  m_height = m_texture_shapes.height;
+  m_depth = TexturePool::get().get_depth(m_texture_shapes);
+  m_history.reset(m_texture_shapes, m_depth);
+  m_dirty.reset(m_width, m_height);
+
+  // effects target resized with image
+  update_texture_effects();
+}
+
+/* Annotation layers of previous image discarded (e.g. another image opened) */
+void Canvas::clear_layers() {
+  if (!m_layers)
+    return;
+
+  m_layers->free();
+  m_layers.reset();
+}
+
+/**
+ * Show read-only image from its compressed blocks, leaving tiled mode & resetting shader, effects & history
+ * Full-size image & effects textures replaced by 1x1 placeholders (vram given back at once, not kept by pool)
+ */
+void Canvas::show_reference(Open& open) {
+  if (m_tiled) {
+    m_tiled->free();
+    m_tiled.reset();
+  }
+  if (m_reference)
+    m_reference->free();
+  m_reference = std::make_unique<ReferenceImage>(*open.blocks, open.path, open.image);
+  open.blocks.reset();
+  open.image.reset();
+  hide_preview();
+  clear_layers();
+  clear_selection();
+
+  TexturePool& pool = TexturePool::get();
+  pool.release(m_texture_shapes);
+  pool.release(m_texture_effects);
+  pool.trim();
+  m_texture_shapes = pool.acquire(1, 1, 4);
+  m_texture_effects = pool.acquire(1, 1, 4);
+  m_framebuffer.attach_texture(m_texture_effects);
+  m_tooltip_image = TooltipImage(m_texture_effects);
+
+  m_width = m_reference->get_width();
+  m_height = m_reference->get_height();
+  m_depth = Depth::UNORM8;
+  m_history.reset(m_texture_shapes);
+  m_dirty.reset(m_width, m_height);
+  set_program_view(Shader::COLOR);
+  m_effect_chain.clear();
+  m_effect_chain.set_format(4, m_depth);
+  invalidate();
+}
+
+/**
+ * Leave read-only mode before an edit: cpu copy uploaded into an uncompressed texture (decoded now if not queried yet)
+ * @return false if image can't be decoded (edit ignored)
+ */
+bool Canvas::make_editable() {
+  if (!m_reference)
+    return true;
+
+  std::shared_ptr<Image> image = m_reference->get_image();
+  if (image->data == NULL)
+    return false;
+
+  Texture2D texture = TexturePool::get().acquire(image->width, image->height, image->n_channels, Depth::UNORM8,
+                                                 TextureCache::OWNER_TAKEN);
+  glBindTexture(GL_TEXTURE_2D, texture.id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image->width, image->height, texture.format, GL_UNSIGNED_BYTE, image->data);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // placeholders given back to pool
+  replace_texture(texture, true);
+  return true;
+}
+
+/**
+ * Upload decoded images (in order of opening) one band per frame
+ * Once upload complete, new texture replaces displayed one & shader is reset
+ */
+void Canvas::update_opens() {
+  if (m_opens.empty())
+    return;
+
+  std::shared_ptr<Open> open = m_opens.front();
+  if (open->job->status == JobStatus::FAILED) {
+    if (!open->is_canceled)
+      hide_preview();
+    m_opens.pop_front();
+    return;
+  }
+
+  // superseded image dropped once decoded (incl. its partial upload)
+  if (open->is_canceled) {
+    if (open->job->status != JobStatus::UPLOAD)
+      return;
+
+    if (m_texture_upload) {
+      m_uploader.cancel();
+      TexturePool::get().release(*m_texture_upload);
+      m_texture_upload.reset();
+    }
+
+    open->image.reset();
+    open->blocks.reset();
+    if (open->pyramid)
+      open->pyramid->free();
+    open->pyramid.reset();
+    open->job->status = JobStatus::DONE;
+    m_opens.pop_front();
+    return;
+  }
+
+  // preview uploaded at once (small), as soon as it's decoded
+  if (open->has_preview && open->preview)
+    show_preview(*open);
+
+  if (open->job->status != JobStatus::UPLOAD)
+    return;
+
+  // read-only image uploaded at once (compressed blocks are small)
+  if (open->blocks) {
+    show_reference(*open);
+    m_path_image = open->path;
+    open->job->status = JobStatus::DONE;
+    m_opens.pop_front();
+    return;
+  }
+
+  // images too large for a single texture are shown in tiles (kept on cpu or read from pyramid)
+  // (decoded image only held by `open` until its upload starts)
+  if (!m_texture_upload && (open->pyramid || open->image->width > m_size_texture_max ||
+                            open->image->height > m_size_texture_max)) {
+    if (m_tiled)
+      m_tiled->free();
+    if (m_reference)
+      m_reference->free();
+    m_reference.reset();
+    m_tiled = open->pyramid ? std::make_unique<TiledImage>(open->pyramid) : std::make_unique<TiledImage>(open->image);
+    open->image.reset();
+    open->pyramid.reset();
+    hide_preview();
+    clear_layers();
+    clear_selection();
+
+    m_width = m_tiled->get_width();
+    m_height = m_tiled->get_height();
+    set_program_view(Shader::COLOR);
+    m_effect_chain.clear();
+    invalidate();
+
+    m_path_image = open->path;
+    open->job->status = JobStatus::DONE;
+    m_opens.pop_front();
+    return;
+  }
+
+  // allocate storage of decoded image's size without uploading yet
+  if (!m_texture_upload) {
+    const Image& image = *open->image;
+    m_texture_upload.emplace(TexturePool::get().acquire(image.width, image.height, image.n_channels, open->depth,
+                                                         TextureCache::OWNER_TAKEN));
+    m_uploader.start(*m_texture_upload, open->image, open->depth);
+    open->image.reset();
+  }
+
+  bool is_uploaded = m_uploader.update();
+  open->job->progress = m_uploader.get_progress();
+  if (!is_uploaded)
+    return;
+
+  // replace image texture (& leave tiled mode) & reset shader
+  replace_texture(*m_texture_upload, true);
+  m_texture_upload.reset();
+
+  m_path_image = open->path;
+  open->job->status = JobStatus::DONE;
+  m_opens.pop_front();
+}
+
+/**
+ * Queue saving of image opened in canvas to given `path_image`
+ * Returns immediately, progress reported by jobs in `get_jobs()`
+ */
+void Canvas::save_image(const std::string& path_image) {
+  std::shared_ptr<Job> job = std::make_shared<Job>("Save " + path_image);
+  m_saves.push_back({ path_image, job, ImageEncoder::Options(), 1 });
+  m_jobs.push_back(job);
+  m_exports.push_back(job);
+}
+
+/**
+ * Queue export of image opened in canvas with given encoding & downscale (e.g. several formats from exports panel)
+ * Exports queued in the same frame share one readback, & are encoded in parallel
+ * @param factor Image shrunk by this integer factor (1: full size)
+ */
+void Canvas::export_image(const std::string& path_image, const ImageEncoder::Options& options, int factor) {
+  std::shared_ptr<Job> job = std::make_shared<Job>("Export " + path_image);
+  m_saves.push_back({ path_image, job, options, std::max(factor, 1) });
+  m_jobs.push_back(job);
+  m_exports.push_back(job);
+}
+
+/**
+ * Called every frame to advance background opens & saves:
+ *   - upload next band of image being opened
+ *   - start gpu readback of effects texture for queued saves (while PBOs available)
+ *   - send finished readbacks to worker thread for encoding
+ *   - forget finished jobs after they've been shown for a while
+ */
+void Canvas::update_jobs() {
+  update_opens();
+  update_prefetches();
+  update_sequence();
+  update_compare_open();
+
+  // tiled & read-only images are saved from their cpu copy (incl. painted shapes but without effects)
+  if (m_tiled || m_reference) {
+    while (!m_saves.empty() && m_saves.back().job->status == JobStatus::QUEUED) {
+      std::shared_ptr<Image> image = m_tiled ? m_tiled->get_image() : m_reference->get_image();
+      if (image->data == NULL) {
+        m_saves.back().job->status = JobStatus::FAILED;
+        m_saves.pop_back();
+        continue;
+      }
+
+      std::shared_ptr<Readback> pixels = std::make_shared<Readback>();
+      *pixels = { 0, 0, image->width, image->height, image->n_channels,
+                  std::vector<unsigned char>(image->data, image->data + (size_t) image->width * image->height * image->n_channels) };
+      encode(m_saves.back(), pixels);
+      m_saves.pop_back();
+    }
+  }
+
+  // snapshots of raw saves given back to pool once worker read them
+  for (auto it = m_snapshots_raw.begin(); it != m_snapshots_raw.end(); ) {
+    bool is_read = GlWorker::is_done(*it->ticket);
+    if (is_read)
+      TexturePool::get().release(it->texture);
+    it = is_read ? m_snapshots_raw.erase(it) : std::next(it);
+  }
+
+  // raw formats at full size read by gl worker straight into mapped output file (no readback nor copy of pixels)
+  if (GlWorker::get().is_available() && GLAD_GL_VERSION_4_3) {
+    for (auto it = m_saves.begin(); it != m_saves.end(); ) {
+      bool is_written = it->job->status == JobStatus::QUEUED && write_raw(*it);
+      it = is_written ? m_saves.erase(it) : std::next(it);
+    }
+  }
+
+  // only region changed since previous save read back (whole texture for first save or after other changes)
+  for (Save& save : m_saves) {
+    if (save.job->status != JobStatus::QUEUED)
+      continue;
+
+    // pixels of previous save come from other texture after a mode change
+    const Texture2D& texture = get_texture_export();
+    if (m_mode_saved != mode)
+      m_has_pixels_saved = false;
+
+    DirtyRegion::Rect rect;
+    int radius = (mode == Mode::NORMAL) ? m_effect_chain.get_radius() : 0;
+    save.has_readback = m_dirty.get_bounds(m_revision_dirty_saved, radius, rect) || !m_has_pixels_saved;
+    save.is_partial = save.has_readback && m_has_pixels_saved && !m_dirty.is_whole(rect);
+    if (save.has_readback) {
+      bool is_requested;
+      if (save.is_partial) {
+        int n_channels = PixelFormat::get_n_channels(texture);
+        m_framebuffer.attach_texture(texture);
+        is_requested = m_pixel_reader.request(m_framebuffer, rect.x, rect.y, rect.width, rect.height, n_channels);
+      } else {
+        is_requested = m_pixel_reader.request(texture);
+      }
+
+      if (!is_requested)
+        break;
+    }
+
+    m_revision_dirty_saved = m_dirty.get_revision();
+    m_has_pixels_saved = true;
+    m_mode_saved = mode;
+    save.job->status = JobStatus::READBACK;
+  }
+
+  // saves encoded in order, each readback patched onto pixels of previous save (copied, as those may still be encoded)
+  while (!m_saves.empty() && m_saves.front().job->status == JobStatus::READBACK) {
+    Save save = m_saves.front();
+    Readback readback;
+    if (save.has_readback) {
+      if (!m_pixel_reader.poll(readback))
+        break;
+
+      if (!save.is_partial) {
+        m_pixels_saved = std::make_shared<Readback>(std::move(readback));
+      } else {
+        std::shared_ptr<Readback> pixels = std::make_shared<Readback>(*m_pixels_saved);
+        size_t n_bytes_row = (size_t) readback.width * readback.n_channels;
+        for (int y = 0; y < readback.height; y++) {
+          const unsigned char* row = readback.data.data() + y * n_bytes_row;
+          size_t offset = ((size_t) (readback.y + y) * pixels->width + readback.x) * pixels->n_channels;
+          std::copy(row, row + n_bytes_row, pixels->data.begin() + offset);
+        }
+        m_pixels_saved = pixels;
+      }
+    }
+
+    m_saves.pop_front();
+    encode(save, m_pixels_saved);
+  }
+
+  // totals updated once per export (before its finish time is set below), only last ones kept in list
+  for (const auto& job : m_exports) {
+    if (!job->is_finished() || job->time_finished >= 0.0)
+      continue;
+
+    bool is_done = job->status == JobStatus::DONE;
+    m_export_stats.n_done += is_done;
+    m_export_stats.n_failed += !is_done;
+    m_export_stats.n_megapixels += job->n_pixels / 1e6;
+    m_export_stats.duration_waiting += std::max(job->duration_waiting.load(), 0.0f);
+    m_export_stats.duration_running += std::max(job->duration_running.load(), 0.0f);
+  }
+
+  while (m_exports.size() > N_EXPORTS_SHOWN && m_exports.front()->is_finished())
+    m_exports.pop_front();
+
+  // finished jobs still shown in ui for a few seconds
+  double time_now = ImGui::GetTime();
+  for (auto& job : m_jobs) {
+    if (job->is_finished() && job->time_finished < 0.0)
+      job->time_finished = time_now;
+  }
+
+  const double DURATION_SHOWN = 3.0;
+  m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), [time_now, DURATION_SHOWN](const std::shared_ptr<Job>& job) {
+    return job->time_finished >= 0.0 && time_now - job->time_finished > DURATION_SHOWN;
+  }), m_jobs.end());
+
+  // keep polling fences & updating status in on-demand mode
+  if (!m_jobs.empty())
+    Redraw::request();
+}
+
+/**
+ * Downscale, encode & write pixels to disk on least busy worker thread (encoding doesn't need gl context)
+ * @param pixels Image data shared by workers until saved (never modified, later readbacks patch a copy)
+ */
+void Canvas::encode(const Save& save, const std::shared_ptr<Readback>& pixels) {
+  save.job->status = JobStatus::RUNNING;
+
+  auto it = std::min_element(m_workers_save.begin(), m_workers_save.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs->get_n_pending() < rhs->get_n_pending();
+  });
+
+  (*it)->submit([save, pixels]() {
+    auto time_start = std::chrono::steady_clock::now();
+    save.job->duration_waiting = std::chrono::duration<float>(time_start - save.job->time_queued).count();
+
+    // pixels owned by readback or by downscaled copy, so image isn't freed
+    ImageView view(pixels->data.data(), pixels->width, pixels->height, pixels->n_channels);
+    std::vector<unsigned char> data_downscaled;
+    if (save.factor > 1) {
+      size_t width = (view.width + save.factor - 1) / save.factor, height = (view.height + save.factor - 1) / save.factor;
+      data_downscaled.resize(width * height * view.n_channels);
+      view = ImageUtils::downscale(view, save.factor, data_downscaled.data());
+    }
+
+    Image image(view.width, view.height, view.n_channels, view.data);
+    bool is_written = ImageEncoder::encode(image, save.path, save.options);
+    save.job->n_pixels = (size_t) image.width * image.height;
+    save.job->duration_running = std::chrono::duration<float>(std::chrono::steady_clock::now() - time_start).count();
+    save.job->status = is_written ? JobStatus::DONE : JobStatus::FAILED;
+    std::cout << "Saving " << save.path << (is_written ? " done" : " failed") << '\n';
+
+    // wake up main loop to show status
+    Redraw::request_async();
+  });
+}
+
+/**
+ * Write texture exported in a raw format (see `RawWriter`) on gl worker: output file mapped in memory,
+ * & texture read by `glGetTexImage()` directly into it (gpu converts channels, e.g. rgba to rgb for ppm)
+ * @return false if save must go through readback & encoding instead (downscaled, or channels to replicate on cpu)
+ */
+bool Canvas::write_raw(const Save& save) {
+  std::optional<RawWriter::Format> format = RawWriter::find_format(save.path);
+  if (!format || save.factor > 1)
+    return false;
+
+  const Texture2D& texture = get_texture_export();
+  int n_channels_texture = PixelFormat::get_n_channels(texture);
+  int n_channels = RawWriter::get_n_channels(*format, n_channels_texture);
+  if (n_channels > n_channels_texture)
+    return false;
+
+  const GLenum FORMATS[] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+  GLenum format_gl = FORMATS[n_channels - 1];
+  int width = texture.width, height = texture.height;
+  std::shared_ptr<Job> job = save.job;
+  std::string path = save.path;
+  job->status = JobStatus::RUNNING;
+
+  // worker reads a snapshot copied on main context, as texture may be drawn on before worker runs
+  TexturePool& pool = TexturePool::get();
+  Texture2D snapshot = pool.acquire(width, height, n_channels_texture, pool.get_depth(texture), "raw save");
+  glCopyImageSubData(texture.id, GL_TEXTURE_2D, 0, 0, 0, 0, snapshot.id, GL_TEXTURE_2D, 0, 0, 0, 0, width, height, 1);
+  GLuint id_texture = snapshot.id;
+
+  std::shared_ptr<GlWorker::Ticket> ticket = GlWorker::get().submit([job, path, format, format_gl, id_texture, width, height, n_channels]() {
+    auto time_start = std::chrono::steady_clock::now();
+    job->duration_waiting = std::chrono::duration<float>(time_start - job->time_queued).count();
+
+    RawWriter::Mapping mapping;
+    bool is_written = RawWriter::map(path, *format, width, height, n_channels, mapping);
+    if (is_written) {
+      glBindTexture(GL_TEXTURE_2D, id_texture);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glGetTexImage(GL_TEXTURE_2D, 0, format_gl, GL_UNSIGNED_BYTE, mapping.data + mapping.offset_pixels);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      is_written = RawWriter::unmap(mapping, path, true);
+    }
+
+    job->n_pixels = (size_t) width * height;
+    job->duration_running = std::chrono::duration<float>(std::chrono::steady_clock::now() - time_start).count();
+    job->status = is_written ? JobStatus::DONE : JobStatus::FAILED;
+    std::cout << "Saving " << path << (is_written ? " done" : " failed") << '\n';
+
+    Redraw::request_async();
+  });
+  m_snapshots_raw.push_back({ ticket, snapshot });
+
+  return true;
+}
+
+/* Background jobs (e.g. saves) to show in ui */
+const std::vector<std::shared_ptr<Job>>& Canvas::get_jobs() const {
+  return m_jobs;
+}
+
+/* Saves & exports in order they were queued (pending ones & last finished ones) */
+const std::deque<std::shared_ptr<Job>>& Canvas::get_exports() const {
+  return m_exports;
+}
+
+const Canvas::ExportStats& Canvas::get_export_stats() const {
+  return m_export_stats;
+}
+
+/* Saves & exports queued, waiting for readback or being encoded (i.e. queue depth) */
+size_t Canvas::get_n_exports_pending() const {
+  return std::count_if(m_exports.begin(), m_exports.end(), [](const std::shared_ptr<Job>& job) {
+    return !job->is_finished();
+  });
+}
+
+/**
+ * FNV-1a hash of displayed pixels (effects texture, or cpu copy of tiles incl. shapes but without effects,
+ * or of read-only image before compression)
+ * Stable across runs & platforms, to detect rendering changes in replayed sessions
+ * Reads texture back synchronously (stalls until gpu is done)
+ */
+uint64_t Canvas::get_checksum() {
+  std::vector<unsigned char> pixels;
+  if (m_tiled || m_reference) {
+    std::shared_ptr<Image> image = m_tiled ? m_tiled->get_image() : m_reference->get_image();
+    if (image->data != NULL)
+      pixels.assign(image->data, image->data + (size_t) image->width * image->height * image->n_channels);
+  } else {
+    render_to_fbo(true);
+    pixels.resize((size_t) m_width * m_height * 4);
+    glBindTexture(GL_TEXTURE_2D, m_texture_effects.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char byte : pixels) {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+/* Path of image opened in document (shown in its tab) */
+const std::string& Canvas::get_path() const {
+  return m_path_image;
+}
+
+/**
+ * Vram held by document: image & effects textures (incl. their mip chains), effects chain, annotation layers
+ * & undo history on gpu
+ * Tiles, compressed read-only image & browse cache not counted (they have their own budgets)
+ */
+size_t Canvas::get_n_bytes_gpu() const {
+  size_t n_pixels = (size_t) m_texture_shapes.width * m_texture_shapes.height;
+  size_t n_bytes_shapes = n_pixels * PixelFormat::get_n_channels(m_texture_shapes) * PixelFormat::get_n_bytes_channel(m_depth);
+  size_t n_bytes_effects = n_pixels * PixelFormat::get_n_channels(m_texture_effects) *
+                           PixelFormat::get_n_bytes_channel(EffectChain::get_depth_output(m_depth));
+
+  size_t n_bytes_layers = m_layers ? m_layers->get_n_bytes() : 0;
+  return (n_bytes_shapes + n_bytes_effects) * 4 / 3 + m_effect_chain.get_n_bytes() + m_history.get_size_gpu() + n_bytes_layers;
+}
+
+/**
+ * Give vram of a background document back: pixels of image texture read back to cpu (synchronously),
+ * effects textures, history's atlas pages (tiles spilled to cpu) & browse cache freed
+ * Only idle single-texture documents are evicted (tiles are already kept on cpu, read-only images are compressed)
+ * @return false if document can't be evicted (e.g. image still opening or saving)
+ */
+bool Canvas::evict() {
+  if (m_evicted || m_tiled || m_reference || m_texture_preview || m_texture_prefetch || is_busy() || is_playing())
+    return false;
+
+  end_stroke();
+  Evicted evicted = { {}, PixelFormat::get_n_channels(m_texture_shapes) };
+  evicted.data.resize((size_t) m_width * m_height * evicted.n_channels * PixelFormat::get_n_bytes_channel(m_depth));
+  glBindTexture(GL_TEXTURE_2D, m_texture_shapes.id);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glGetTexImage(GL_TEXTURE_2D, 0, m_texture_shapes.format, PixelFormat::get_type(m_depth), evicted.data.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  m_evicted = std::move(evicted);
+
+  m_history.spill_all();
+  if (m_layers)
+    m_layers->evict();
+  m_effect_chain.evict();
+  m_edge_map.free();
+  m_overlay.free();
+  m_cache.free();
+  m_path_prefetched.clear();
+
+  // 1x1 placeholders, full-size textures freed at once (not kept by pool)
+  TexturePool& pool = TexturePool::get();
+  pool.release(m_texture_shapes);
+  pool.release(m_texture_effects);
+  pool.trim();
+  m_texture_shapes = pool.acquire(1, 1, 4);
+  m_texture_effects = pool.acquire(1, 1, 4);
+  m_framebuffer.attach_texture(m_texture_effects);
+  m_tooltip_image = TooltipImage(m_texture_effects);
+
+  return true;
+}
+
+/* Upload pixels of evicted document (on its activation), effects re-rendered & mipmaps regenerated */
+void Canvas::restore() {
+  if (!m_evicted)
+    return;
+
+  TexturePool& pool = TexturePool::get();
+  pool.release(m_texture_shapes);
+  pool.release(m_texture_effects);
+  m_texture_shapes = pool.acquire(m_width, m_height, m_evicted->n_channels, m_depth, TextureCache::OWNER_TAKEN);
+  glBindTexture(GL_TEXTURE_2D, m_texture_shapes.id);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, m_texture_shapes.format, PixelFormat::get_type(m_depth),
+                  m_evicted->data.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  PixelFormat::swizzle_gray(m_texture_shapes);
+  m_evicted.reset();
+
+  m_texture_effects = pool.acquire(m_width, m_height, get_n_channels_effects(), EffectChain::get_depth_output(m_depth),
+                                   "effects target");
+  m_framebuffer.attach_texture(m_texture_effects);
+  m_tooltip_image = TooltipImage(m_texture_effects);
+  m_history.rebind(m_texture_shapes);
+  if (m_layers)
+    m_layers->restore();
+  invalidate();
+}
+
+bool Canvas::is_evicted() const {
+  return m_evicted.has_value();
+}
+
+/* Whether an image is still being opened or saved, or effects rendered over several frames (e.g. replayed session waits for it) */
+bool Canvas::is_busy() const {
+  return !m_opens.empty() || !m_saves.empty() || m_effect_chain.is_pending();
+}
+
+/**
+ * Convert image to grayscale on gpu (appended to effects chain)
+ * Tiles only support one effect (rendered with view shader)
+ */
+void Canvas::to_grayscale() {
+  if (!make_editable())
+    return;
+
+  if (m_tiled)
+    set_program_view(Shader::GRAYSCALE);
+  else
+    m_effect_chain.push(Shader::GRAYSCALE);
+
+  invalidate_effects();
+}
+
+/**
+ * Blur image with a separable gaussian (horizontal then vertical stage appended to effects chain)
+ * Tiles only support a 3x3 avg. filter
+ */
+void Canvas::blur() {
+  if (!make_editable())
+    return;
+
+  if (m_tiled) {
+    set_program_view(Shader::BLUR);
+    invalidate_view();
+    return;
+  }
+
+  m_effect_chain.push(Shader::BLUR_SEPARABLE);
+  m_effect_chain.push(Shader::BLUR_SEPARABLE);
+  set_blur(m_effect_chain.get_effects().size() - 2, RADIUS_BLUR, false);
+}
+
+/**
+ * Change kernel of blur made of stages `i_stage` (horizontal pass) & `i_stage + 1` (vertical pass)
+ * Kernel weights only recomputed here, & only effects from `i_stage` onwards re-rendered
+ * @param radius Half-width of kernel in pixels
+ * @param is_box Box filter instead of gaussian
+ */
+void Canvas::set_blur(size_t i_stage, int radius, bool is_box) {
+  // stale index (e.g. replayed after blur was removed)
+  std::vector<Effect> effects = m_effect_chain.get_effects();
+  if (i_stage + 1 >= effects.size() || effects[i_stage].shader != Shader::BLUR_SEPARABLE ||
+      effects[i_stage + 1].shader != Shader::BLUR_SEPARABLE)
+    return;
+
+  BlurKernel kernel(radius, is_box);
+  std::unordered_map<std::string, float> parameters_h = kernel.to_parameters(1.0f, 0.0f);
+  std::unordered_map<std::string, float> parameters_v = kernel.to_parameters(0.0f, 1.0f);
+
+  // kept for ui (not uniforms of the shader)
+  parameters_h["radius"] = parameters_v["radius"] = radius;
+  parameters_h["is_box"] = parameters_v["is_box"] = is_box;
+
+  for (const auto& pair : parameters_h)
+    m_effect_chain.set_parameter(i_stage, pair.first, pair.second);
+  for (const auto& pair : parameters_v)
+    m_effect_chain.set_parameter(i_stage + 1, pair.first, pair.second);
+
+  invalidate_effects();
+}
+
+/**
+ * Append convolution (e.g. sharpen, sobel edges) to effects chain, with a kernel of radius 1
+ * Tiles only support per-pixel view shaders & 3x3 blur
+ */
+void Canvas::convolve(Shader shader) {
+  if (m_tiled || !make_editable())
+    return;
+
+  m_effect_chain.push(shader, { { "radius", 1.0f } });
+  invalidate_effects();
+}
+
+/* Change radius of convolution at stage `i_stage` (program of that radius compiled on first use) */
+void Canvas::set_radius(size_t i_stage, int radius) {
+  m_effect_chain.set_parameter(i_stage, "radius", radius);
+  invalidate_effects();
+}
+
+/**
+ * Append adjustment stage (levels, brightness/contrast, gamma, curve & gains) left at identity until edited in panel
+ * Tiles only support per-pixel view shaders & 3x3 blur
+ */
+void Canvas::adjust() {
+  if (m_tiled || !make_editable())
+    return;
+
+  m_effect_chain.push(Shader::ADJUST, ColorLut::get_defaults());
+  invalidate_effects();
+}
+
+/* Change one adjustment of stage `i_stage` (its lookup table rebuilt, then stage re-rendered in a single pass) */
+void Canvas::set_adjustment(size_t i_stage, const std::string& name, float value) {
+  m_effect_chain.set_parameter(i_stage, name, value);
+  invalidate_effects();
+}
+
+/* Effects applied to image in order (e.g. to edit their parameters in ui) */
+std::vector<Effect> Canvas::get_effects() const {
+  return m_effect_chain.get_effects();
+}
+
+/* Run effects with fragment or compute shaders (whole chain re-rendered) */
+void Canvas::set_backend(Backend backend) {
+  m_effect_chain.set_backend(backend);
+  invalidate_effects();
+}
+
+Backend Canvas::get_backend() const {
+  return m_effect_chain.get_backend();
+}
+
+/* Gpu time (in ms) of last effects chain render */
+float Canvas::get_duration_effects() {
+  return m_effect_chain.get_duration_gpu();
+}
+
+/* Tiles of effects rendered in last frame & smoothed gpu cost of a tile in ms (with a frame budget) */
+int Canvas::get_n_tiles_effects() const {
+  return m_effect_chain.get_n_tiles_frame();
+}
+
+float Canvas::get_duration_tile_effects() const {
+  return m_effect_chain.get_duration_tile();
+}
+
+/**
+ * Remove last effect applied (previous stages' output reused)
+ * Both stages of a separable blur removed together, as they're pushed & edited as one effect
+ */
+void Canvas::remove_effect() {
+  std::vector<Effect> effects = m_effect_chain.get_effects();
+  bool is_blur = effects.size() >= 2 && effects.back().shader == Shader::BLUR_SEPARABLE;
+  m_effect_chain.pop();
+  if (is_blur)
+    m_effect_chain.pop();
+  invalidate_effects();
+}
+
+/* Remove all effects applied (view shader kept) */
+void Canvas::clear_effects() {
+  m_effect_chain.clear();
+  invalidate_effects();
+}
+
+/* Free opengl textures (image holder) & framebuffer of document */
+void Canvas::free() {
+  // finish pending encodings/decodings (& raw saves being read by gl worker)
+  for (auto& worker : m_workers_save)
+    worker->free();
+  for (const Snapshot& snapshot : m_snapshots_raw) {
+    GlWorker::wait(*snapshot.ticket);
+    TexturePool::get().release(snapshot.texture);
+  }
+  m_snapshots_raw.clear();
+  m_worker_decode.free();
+  m_sequence.free();
+  m_pixel_reader.free();
+  m_worker_prefetch.free();
+  m_uploader.free();
+  m_uploader_prefetch.free();
+  if (m_texture_upload)
+    m_texture_upload->free();
+  if (m_texture_prefetch)
+    m_texture_prefetch->free();
+  m_cache.free();
+  hide_preview();
+  if (m_tiled)
+    m_tiled->free();
+  if (m_reference)
+    m_reference->free();
+  if (m_histogram)
+    m_histogram->free();
+  release_compare();
+  if (m_image_comparison)
+    m_image_comparison->free();
+
+  // destroy effects textures (programs & renderer's buffers shared by documents)
+  m_effect_chain.free();
+
+  // destroy texures (pooled ones freed by frame)
+  m_texture_shapes.free();
+  m_texture_effects.free();
+
+  // drop queued shapes & destroy brush & history
+  m_image_vg.free();
+  m_brush.free();
+  m_history.free();
+  clear_layers();
+  m_selection.free();
+  m_flood_fill.free();
+  m_edge_map.free();
+  m_overlay.free();
+  m_mip_chain.free();
+
+  // destroy readback buffers
+  m_tooltip_pixel.free();
+  m_tooltip_neighbourhood.free();
+
+  // destroy framebuffer
+  m_framebuffer.free();
+}
+
+/* 2x zoom steps around center of canvas */
+void Canvas::zoom_in() {
+  m_view.zoom_center(2.0f);
+  Redraw::request();
+}
+
+void Canvas::zoom_out() {
+  m_view.zoom_center(0.5f);
+  Redraw::request();
+}
+
+/**
+ * Continuous zoom keeping given pixel at the same place on screen
+ * @param x,y Anchor in nanovg coords (origin at lower-left corner)
+ */
+void Canvas::zoom_at(float factor, float x, float y) {
+  m_view.zoom_at(factor, { x, m_height - y });
+  Redraw::request();
+}
+
+/**
+ * Move view by given displacement
+ * @param dx,dy Displacement in image pixels (y-axis pointing up like nanovg coords)
+ */
+void Canvas::pan(float dx, float dy) {
+  m_view.pan({ dx, -dy });
+  Redraw::request();
+}
+
+/* Restore active layer before last operation (shape or brush stroke) */
+void Canvas::undo() {
+  if (!m_tiled && get_history().undo())
+    invalidate();
+}
+
+/* Re-apply last undone operation */
+void Canvas::redo() {
+  if (!m_tiled && get_history().redo())
+    invalidate();
+}
+
+/**
+ * Append transparent annotation layer on top of image, drawn on until another layer is selected
+ * Not available for tiles (read-only image made editable first)
+ */
+void Canvas::add_layer() {
+  if (!make_editable() || m_tiled)
+    return;
+
+  // shapes queued for previous active layer drawn before
+  end_stroke();
+  bool has_layers = m_layers != nullptr;
+  if (!has_layers)
+    m_layers = std::make_unique<LayerStack>(m_programs, m_texture_shapes, m_depth);
+  m_layers->add(m_framebuffer);
+
+  // effects of monochrome image now rendered in color
+  if (!has_layers)
+    update_texture_effects();
+  invalidate();
+}
+
+/* Remove annotation layer (with its history) */
+void Canvas::remove_layer(size_t i_layer) {
+  if (!m_layers)
+    return;
+
+  end_stroke();
+  m_layers->remove(i_layer);
+  invalidate();
+}
+
+/* Layer drawn on by next shapes & strokes (0: image), composite unchanged */
+void Canvas::select_layer(size_t i_layer) {
+  if (!m_layers)
+    return;
+
+  end_stroke();
+  m_layers->set_active(i_layer);
+  Redraw::request();
+}
+
+/* Change opacity & visibility of layer (0: image) */
+void Canvas::set_layer(size_t i_layer, float opacity, bool is_visible) {
+  if (!m_layers)
+    return;
+
+  m_layers->set(i_layer, opacity, is_visible);
+  invalidate();
+}
+
+/* Layers of image (NULL until an annotation layer is added) */
+const LayerStack* Canvas::get_layers() const {
+  return m_layers.get();
+}
+
+/**
+ * Restrict effects to rectangle
+ * @param x1,y1,x2,y2 Opposite corners in nanovg coords (origin at lower-left corner)
+ */
+void Canvas::select_rect(float x1, float y1, float x2, float y2) {
+  m_lasso.clear();
+  float y_min = m_height - std::max(y1, y2), y_max = m_height - std::min(y1, y2);
+  float x_min = std::min(x1, x2), x_max = std::max(x1, x2);
+  set_selection({ { x_min, y_min }, { x_max, y_min }, { x_max, y_max }, { x_min, y_max } });
+}
+
+/**
+ * Append vertex to lasso being drawn (selection made once it's closed by `end_selection()`)
+ * @param x,y Position in nanovg coords (origin at lower-left corner)
+ */
+void Canvas::select_to(float x, float y) {
+  SelectionMask::Vertex vertex = { x, m_height - y };
+  if (!m_lasso.empty() && m_lasso.back().x == vertex.x && m_lasso.back().y == vertex.y)
+    return;
+
+  m_lasso.push_back(vertex);
+  Redraw::request();
+}
+
+/* Close lasso drawn so far into a selection (fewer than 3 vertices clear the selection) */
+void Canvas::end_selection() {
+  std::vector<SelectionMask::Vertex> polygon;
+  polygon.swap(m_lasso);
+  set_selection(polygon);
+}
+
+/* Effects applied to whole image again */
+void Canvas::clear_selection() {
+  m_lasso.clear();
+  set_selection({});
+}
+
+/**
+ * Replace selection by polygon (clamped to image), effects chain re-rendered over new bounding box only
+ * Effects texture outdated over both previous & new bounding boxes
+ * @param polygon Vertices in image pixels (origin at upper-left corner), empty to clear selection
+ */
+void Canvas::set_selection(const std::vector<SelectionMask::Vertex>& polygon) {
+  if (m_tiled || (m_selection.is_empty() && polygon.empty()))
+    return;
+
+  bool was_empty = m_selection.is_empty();
+  DirtyRegion::Rect rect_previous = m_selection.get_rect();
+  m_selection.set(polygon, m_width, m_height);
+  update_selection(was_empty, rect_previous);
+}
+
+/**
+ * Effects restricted to new selection (or applied to whole image again if it's empty)
+ * @param was_empty,rect_previous Whether there was a selection before & its bounding box
+ */
+void Canvas::update_selection(bool was_empty, const DirtyRegion::Rect& rect_previous) {
+  if (!was_empty)
+    m_dirty.add(rect_previous.x, rect_previous.y, rect_previous.x + rect_previous.width, rect_previous.y + rect_previous.height);
+
+  bool is_selected = !m_selection.is_empty();
+  if (is_selected) {
+    const DirtyRegion::Rect& rect = m_selection.get_rect();
+    m_dirty.add(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+  }
+
+  m_effect_chain.set_selection(is_selected ? &m_selection : NULL);
+  if (!m_effect_chain.is_empty() && (was_empty || !is_selected))
+    m_dirty.add_all();
+
+  m_revision++;
+  Redraw::request();
+}
+
+/* Outline of selection, of lasso being drawn & of rectangle being dragged (black & white to show on any image) */
+void Canvas::render_selection() {
+  std::vector<SelectionMask::Vertex> polygon;
+  bool is_closed = true;
+  ImVec2 position_mouse_img = get_mouse_position();
+  if (!m_lasso.empty()) {
+    polygon = m_lasso;
+    polygon.push_back({ position_mouse_img.x, position_mouse_img.y });
+    is_closed = false;
+  } else if (Toolbar::select_rect && cursor.x != VECTOR_UNSET.x && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+    SelectionMask::Vertex corner = { cursor.x, m_height - cursor.y };
+    polygon = { corner, { position_mouse_img.x, corner.y }, { position_mouse_img.x, position_mouse_img.y },
+                { corner.x, position_mouse_img.y } };
+  } else {
+    polygon = m_selection.get_polygon();
+  }
+
+  if (polygon.size() < 2)
+    return;
+
+  std::vector<ImVec2> vertices;
+  for (const SelectionMask::Vertex& vertex : polygon)
+    vertices.push_back(m_view.to_screen({ vertex.x, vertex.y }));
+
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  ImDrawFlags flags = is_closed ? ImDrawFlags_Closed : ImDrawFlags_None;
+  draw_list->AddPolyline(vertices.data(), vertices.size(), IM_COL32(0, 0, 0, 255), flags, 3.0f);
+  draw_list->AddPolyline(vertices.data(), vertices.size(), IM_COL32(255, 255, 255, 255), flags, 1.0f);
+}
+
+/**
+ * Strongest edge near cursor while line tool snaps, marked by a circle (black & white to show on any image)
+ * Edge map brought up to date & window around cursor requested each frame (result read back in a later frame)
+ * Not available for tiles & read-only images (no full-size texture)
+ * @return Snapped position in nanovg coords (origin at lower-left corner), empty if no edge is near cursor
+ */
+std::optional<ImVec2> Canvas::snap_to_edge() {
+  if (!Toolbar::draw_line || !Toolbar::snap_edges || m_tiled || m_reference || m_texture_preview || !ImGui::IsItemHovered())
+    return {};
+
+  ImVec2 position_mouse_img = get_mouse_position();
+  m_edge_map.update(get_renderer(), m_programs, get_texture_composite(), m_dirty);
+  m_edge_map.request((int) position_mouse_img.x, (int) position_mouse_img.y);
+
+  // window requested for current position read in next frames (even without further input)
+  if (m_edge_map.is_pending())
+    Redraw::request(1);
+  ImVec2 position_snapped;
+  if (!m_edge_map.snap(position_mouse_img.x, position_mouse_img.y, position_snapped.x, position_snapped.y))
+    return {};
+
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  ImVec2 position_screen = m_view.to_screen(position_snapped);
+  draw_list->AddCircle(position_screen, 5.0f, IM_COL32(0, 0, 0, 255), 0, 3.0f);
+  draw_list->AddCircle(position_screen, 5.0f, IM_COL32(255, 255, 255, 255), 0, 1.0f);
+  return ImVec2(position_snapped.x, m_height - position_snapped.y);
+}
+
+/**
+ * Fill region of similar color connected to clicked pixel on active layer with fill color (region grown on gpu)
+ * Not available for tiles
+ * @param x,y Clicked position in nanovg coords (origin at lower-left corner)
+ * @param tolerance Max. difference of any channel with clicked pixel's color (in [0, 1])
+ */
+void Canvas::fill(float x, float y, float tolerance) {
+  if (!make_editable() || m_tiled)
+    return;
+
+  // shapes queued before fill drawn first
+  flush_strokes();
+  const Texture2D& target = get_texture_target();
+  Renderer& renderer = get_renderer();
+  if (!m_flood_fill.grow(renderer, m_framebuffer, target, (int) x, (int) (m_height - y), tolerance))
+    return;
+
+  // save tiles under region before it's filled
+  const DirtyRegion::Rect& rect = m_flood_fill.get_rect();
+  get_history().touch(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+  m_flood_fill.fill(renderer, m_framebuffer, target, { Color::fill.x, Color::fill.y, Color::fill.z, 1.0f });
+  invalidate(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+}
+
+/**
+ * Select region of similar color connected to clicked pixel of image (with its layers), mask kept on gpu
+ * @param x,y Clicked position in nanovg coords (origin at lower-left corner)
+ * @param tolerance Max. difference of any channel with clicked pixel's color (in [0, 1])
+ */
+void Canvas::magic_wand(float x, float y, float tolerance) {
+  if (m_tiled || m_reference || m_texture_preview)
+    return;
+
+  m_lasso.clear();
+  bool was_empty = m_selection.is_empty();
+  DirtyRegion::Rect rect_previous = m_selection.get_rect();
+  if (!m_flood_fill.grow(get_renderer(), m_framebuffer, get_texture_composite(), (int) x, (int) (m_height - y), tolerance))
+    return;
+
+  m_selection.set(m_framebuffer, m_flood_fill.get_mask(), m_flood_fill.get_rect());
+  update_selection(was_empty, rect_previous);
+}
+
+/**
+ * Replace overlay by circles & lines of a .json or .csv file (positions with origin at upper-left corner of image)
+ * @param path Cleared if empty
+ */
+void Canvas::load_overlay(const std::string& path) {
+  Redraw::request();
+  if (path.empty()) {
+    m_overlay.clear();
+    return;
+  }
+
+  std::string error;
+  if (!m_overlay.load(path, error)) {
+    std::cout << "Failed to load overlay: " << error << '\n';
+    return;
+  }
+
+  const Annotations& annotations = m_overlay.get_annotations();
+  std::cout << "Loaded overlay: " << annotations.get_n_shapes() << " shapes in " << annotations.get_batches().size()
+            << " styles from " << path << '\n';
 }
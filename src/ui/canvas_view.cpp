@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "ui/canvas_view.hpp"
+
+CanvasView::CanvasView():
+  m_origin(0.0f, 0.0f),
+  m_size(0.0f, 0.0f),
+  m_size_image(0.0f, 0.0f),
+  m_zoom(1.0f),
+  m_offset(0.0f, 0.0f)
+{
+}
+
+/**
+ * Called once per frame before mapping positions (canvas resized with window, image changed on open)
+ * @param origin Canvas' upper-left corner on screen
+ * @param size Canvas' size on screen
+ * @param size_image Size of displayed image in pixels
+ */
+void CanvasView::update(const ImVec2& origin, const ImVec2& size, const ImVec2& size_image) {
+  m_origin = origin;
+  m_size = size;
+  m_size_image = size_image;
+  clamp();
+}
+
+/**
+ * Multiply zoom by given factor while keeping given image point at the same place on screen
+ * @param position_image Anchor (e.g. pixel under cursor)
+ */
+void CanvasView::zoom_at(float factor, const ImVec2& position_image) {
+  float zoom = std::clamp(m_zoom * factor, ZOOM_MIN, ZOOM_MAX);
+  float ratio = m_zoom / zoom;
+  m_offset.x = position_image.x - (position_image.x - m_offset.x) * ratio;
+  m_offset.y = position_image.y - (position_image.y - m_offset.y) * ratio;
+  m_zoom = zoom;
+  clamp();
+}
+
+/* Zoom around image point at the center of canvas (menu & toolbar buttons) */
+void CanvasView::zoom_center(float factor) {
+  zoom_at(factor, to_image({ m_origin.x + m_size.x / 2.0f, m_origin.y + m_size.y / 2.0f }));
+}
+
+/* Move image point shown at canvas' upper-left corner */
+void CanvasView::pan(const ImVec2& displacement_image) {
+  m_offset.x += displacement_image.x;
+  m_offset.y += displacement_image.y;
+  clamp();
+}
+
+ImVec2 CanvasView::to_image(const ImVec2& position_screen) const {
+  return {
+    m_offset.x + (position_screen.x - m_origin.x) / m_zoom,
+    m_offset.y + (position_screen.y - m_origin.y) / m_zoom,
+  };
+}
+
+ImVec2 CanvasView::to_screen(const ImVec2& position_image) const {
+  return {
+    m_origin.x + (position_image.x - m_offset.x) * m_zoom,
+    m_origin.y + (position_image.y - m_offset.y) * m_zoom,
+  };
+}
+
+/**
+ * Sub-rectangle of image inside canvas (in image pixels)
+ * @return false if no part of image is visible
+ */
+bool CanvasView::get_visible(ImVec2& position, ImVec2& size) const {
+  ImVec2 position_min = { std::max(m_offset.x, 0.0f), std::max(m_offset.y, 0.0f) };
+  ImVec2 position_max = {
+    std::min(m_offset.x + m_size.x / m_zoom, m_size_image.x),
+    std::min(m_offset.y + m_size.y / m_zoom, m_size_image.y),
+  };
+
+  position = position_min;
+  size = { position_max.x - position_min.x, position_max.y - position_min.y };
+  return size.x > 0.0f && size.y > 0.0f;
+}
+
+float CanvasView::get_zoom() const {
+  return m_zoom;
+}
+
+/**
+ * Image larger than canvas always covers it, smaller one stays entirely inside it
+ * (offset kept between 0 & the one aligning image's lower-right corner with canvas')
+ */
+void CanvasView::clamp() {
+  float x_aligned = m_size_image.x - m_size.x / m_zoom;
+  float y_aligned = m_size_image.y - m_size.y / m_zoom;
+  m_offset.x = std::clamp(m_offset.x, std::min(x_aligned, 0.0f), std::max(x_aligned, 0.0f));
+  m_offset.y = std::clamp(m_offset.y, std::min(y_aligned, 0.0f), std::max(y_aligned, 0.0f));
+}
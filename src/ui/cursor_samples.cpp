@@ -0,0 +1,26 @@
+#include "GLFW/glfw3.h"
+
+#include "ui/cursor_samples.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+std::vector<CursorSamples::Sample> CursorSamples::samples_pending;
+std::vector<CursorSamples::Sample> CursorSamples::samples;
+
+/* Buffer a cursor position (called from glfw callback, on main thread while events are polled) */
+void CursorSamples::push(double x, double y) {
+  if (samples_pending.size() >= N_SAMPLES_MAX)
+    samples_pending.erase(samples_pending.begin());
+
+  samples_pending.push_back({ (float) x, (float) y, glfwGetTime() });
+}
+
+/* Hand samples received since previous frame to current one (called once per frame, before ui is built) */
+void CursorSamples::begin_frame() {
+  samples.swap(samples_pending);
+  samples_pending.clear();
+}
+
+/* Samples of current frame in order they were received (empty if cursor didn't move) */
+const std::vector<CursorSamples::Sample>& CursorSamples::get() {
+  return samples;
+}
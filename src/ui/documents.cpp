@@ -0,0 +1,197 @@
+#include <filesystem>
+#include <algorithm>
+
+#include "imgui.h"
+
+#include "ui/documents.hpp"
+#include "ui/redraw.hpp"
+#include "ui/globals/size.hpp"
+#include "commands/command_queue.hpp"
+
+/**
+ * @param image Image of first document, decoded beforehand (uploaded but not freed)
+ * @param budget_gpu Max. size in bytes of textures of all documents before background ones are evicted
+ */
+Documents::Documents(const Image& image, const std::string& path_image, size_t budget_gpu):
+  m_budget_gpu(budget_gpu),
+  m_documents(),
+  m_i_active(0),
+  m_id_next(0),
+  m_i_activation(0)
+{
+  m_documents.push_back({ std::make_unique<Canvas>(image, path_image), m_id_next++, m_i_activation++, false });
+}
+
+/**
+ * Tab per document below toolbar (hidden while a single document is open)
+ * Selecting or closing a tab enqueues a command (active tab always shown as selected)
+ * Sets the size of tab bar to place image canvas below it
+ */
+void Documents::render_tabs() {
+  if (m_documents.size() < 2) {
+    Size::tabs = { 0.0f, 0.0f };
+    return;
+  }
+
+  ImVec2 size_display = ImGui::GetIO().DisplaySize;
+  float y_offset = Size::menu.y + Size::toolbar.y;
+  ImGui::SetNextWindowPos({ 0.0f, y_offset });
+  ImGui::SetNextWindowSize({ size_display.x, 0.0f });
+  ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoSavedSettings;
+  ImGui::Begin("Documents", NULL, window_flags);
+  ImGui::PopStyleVar();
+
+  CommandQueue& queue = CommandQueue::get();
+  if (ImGui::BeginTabBar("Tabs", ImGuiTabBarFlags_FittingPolicyScroll)) {
+    for (size_t i_document = 0; i_document < m_documents.size(); i_document++) {
+      const Document& document = m_documents[i_document];
+      std::string name = std::filesystem::path(document.canvas->get_path()).filename().string();
+      std::string label = (name.empty() ? "Untitled" : name) + (document.is_closing ? " (saving)" : "") +
+                          "##" + std::to_string(document.id);
+
+      bool is_open = true;
+      ImGuiTabItemFlags flags = (i_document == m_i_active) ? ImGuiTabItemFlags_SetSelected : ImGuiTabItemFlags_None;
+      if (ImGui::BeginTabItem(label.c_str(), &is_open, flags))
+        ImGui::EndTabItem();
+
+      if (ImGui::IsItemClicked() && i_document != m_i_active)
+        queue.push({ CommandType::SWITCH_DOCUMENT, (int) i_document });
+      if (!is_open)
+        queue.push({ CommandType::CLOSE_DOCUMENT, (int) i_document });
+    }
+
+    ImGui::EndTabBar();
+  }
+
+  Size::tabs = ImGui::GetWindowSize();
+  ImGui::End();
+}
+
+/**
+ * Evict least recently active background documents while textures of all documents exceed budget
+ * Called once per frame (documents still opening or saving skipped until they're idle)
+ */
+void Documents::enforce_budget() {
+  std::vector<size_t> indices;
+  for (size_t i_document = 0; i_document < m_documents.size(); i_document++) {
+    if (i_document != m_i_active && !m_documents[i_document].canvas->is_evicted())
+      indices.push_back(i_document);
+  }
+
+  std::sort(indices.begin(), indices.end(), [this](size_t i_document1, size_t i_document2) {
+    return m_documents[i_document1].i_activated < m_documents[i_document2].i_activated;
+  });
+
+  for (size_t i_document : indices) {
+    if (get_n_bytes_gpu() <= m_budget_gpu)
+      break;
+
+    m_documents[i_document].canvas->evict();
+  }
+}
+
+/**
+ * Open image in a new document (decoded in background), which becomes the active one
+ * Canvas shows a blank 1x1 image until the decoded one is uploaded
+ */
+void Documents::open(const std::string& path_image, bool is_read_only) {
+  unsigned char pixel[] = { 255, 255, 255, 255 };
+  Image image(1, 1, 4, pixel);
+  m_documents.push_back({ std::make_unique<Canvas>(image, ""), m_id_next++, 0, false });
+  m_documents.back().canvas->change_image(path_image, is_read_only);
+  activate(m_documents.size() - 1);
+}
+
+/* Show given document (restored to vram if it was evicted) */
+void Documents::activate(size_t i_document) {
+  if (i_document >= m_documents.size())
+    return;
+
+  m_i_active = i_document;
+  m_documents[m_i_active].i_activated = m_i_activation++;
+  m_documents[m_i_active].canvas->restore();
+  Redraw::request();
+}
+
+/**
+ * Free document once its pending saves are encoded (last document can't be closed)
+ * Busy document only marked as closing, & erased by `update_closing()` once its jobs are finished
+ */
+void Documents::close(size_t i_document) {
+  size_t n_open = std::count_if(m_documents.begin(), m_documents.end(), [](const Document& document) {
+    return !document.is_closing;
+  });
+  if (i_document >= m_documents.size() || m_documents[i_document].is_closing || n_open < 2)
+    return;
+
+  if (m_documents[i_document].canvas->is_busy()) {
+    m_documents[i_document].is_closing = true;
+    Redraw::request();
+    return;
+  }
+
+  erase(i_document);
+}
+
+/**
+ * Advance jobs of closing background documents (only active one is rendered) & erase those done
+ * Called once per frame (after commands, as they may close documents)
+ */
+void Documents::update_closing() {
+  for (size_t i_document = m_documents.size(); i_document-- > 0; ) {
+    Document& document = m_documents[i_document];
+    if (!document.is_closing)
+      continue;
+
+    if (i_document != m_i_active)
+      document.canvas->update_jobs();
+    if (!document.canvas->is_busy())
+      erase(i_document);
+  }
+}
+
+/* Active document erased: its right neighbour activated (or left one for the last tab) */
+void Documents::erase(size_t i_document) {
+  m_documents[i_document].canvas->free();
+  m_documents.erase(m_documents.begin() + i_document);
+
+  if (m_i_active > i_document)
+    m_i_active--;
+  else if (m_i_active == i_document)
+    activate(std::min(i_document, m_documents.size() - 1));
+  Redraw::request();
+}
+
+Canvas& Documents::get_active() {
+  return *m_documents[m_i_active].canvas;
+}
+
+/* Document at given index (e.g. listed in thumbnail strip) */
+Canvas& Documents::get(size_t i_document) {
+  return *m_documents[i_document].canvas;
+}
+
+size_t Documents::get_i_active() const {
+  return m_i_active;
+}
+
+size_t Documents::get_n_documents() const {
+  return m_documents.size();
+}
+
+/* Vram held by textures of all documents (see `Canvas::get_n_bytes_gpu()`) */
+size_t Documents::get_n_bytes_gpu() const {
+  size_t n_bytes = 0;
+  for (const Document& document : m_documents)
+    n_bytes += document.canvas->get_n_bytes_gpu();
+
+  return n_bytes;
+}
+
+void Documents::free() {
+  for (Document& document : m_documents)
+    document.canvas->free();
+  m_documents.clear();
+}
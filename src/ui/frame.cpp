@@ -5,46 +5,104 @@
 #include "ImGuiFileDialog/ImGuiFileDialog.h"
 
 #include "ui/frame.hpp"
+#include "ui/redraw.hpp"
+#include "ui/cursor_samples.hpp"
 #include "fonts/fonts.hpp"
+#include "profiling/gpu_timer.hpp"
+#include "gpu/upload_ring.hpp"
+#include "gpu/gpu_resources.hpp"
+#include "gpu/gl_worker.hpp"
+#include "gpu/shared_surface.hpp"
+#include "gpu/texture_pool.hpp"
+#include "profiling/tracer.hpp"
+#include "commands/command_queue.hpp"
 
 /**
  * Window frame made with imgui
+ * Imgui context & fonts created here unless startup already did it (fonts rasterized on a worker thread)
  * Inspired by: https://github.com/ocornut/imgui/blob/master/examples/example_glfw_opengl3/main.cpp
+ * @param image Initial image (caller frees it)
  */
-Frame::Frame(const Window& window, const std::string& path_image):
+Frame::Frame(const Window& window, const Image& image, const std::string& path_image):
   m_window(window),
 
-  m_canvas(path_image),
   m_menu(),
+  m_documents(image, path_image),
   m_toolbar(),
+  m_perf_overlay(),
+  m_memory_panel(),
+  m_thumbnails(),
+  m_thumbnail_strip(),
 
-  m_listener_canvas(&m_canvas),
-  m_listener_window(&m_window)
+  m_listener_canvas(&m_documents),
+  m_listener_window(&m_window),
+
+  m_session_log(),
+  m_i_frame(0)
 {
+  // redraw on input events in on-demand mode (before imgui installs its own glfw callbacks)
+  Redraw::install_callbacks(m_window.w);
+
   // setup imgui context & glfw/opengl backends
-  ImGui::CreateContext();
+  if (ImGui::GetCurrentContext() == NULL) {
+    ImGui::CreateContext();
+    Fonts::load(ImGui::GetIO().Fonts);
+  }
+
   ImGui_ImplGlfw_InitForOpenGL(m_window.w, true);
   ImGui_ImplOpenGL3_Init(NULL);
 
-  // load text & icon fonts
-  Fonts::load();
+  // uploads of opened images & readbacks of saved ones on a shared context
+  GlWorker::get().init(m_window.w);
 }
 
 /* Render dialog in main loop */
 void Frame::render() {
+  m_perf_overlay.begin_frame();
+  PROFILE_ZONE("Frame::render");
+
   // start imgui frame
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
+
+  // simulated time advances by a fixed step in replays (e.g. for how long finished jobs are shown)
+  if (m_session_log.is_replaying())
+    ImGui::GetIO().DeltaTime = 1.0f / SessionLog::fps_replay;
   ImGui::NewFrame();
+  CursorSamples::begin_frame();
 
-  // top main menu, toolbar, and image canvas
+  // top main menu, toolbar, tabs, and image canvas of active document
   m_menu.render();
   m_toolbar.render();
-  m_canvas.render();
+  m_documents.render_tabs();
+  m_documents.get_active().render();
+
+  m_listener_canvas.render();
+
+  // commands enqueued by ui (or read from replayed session, ui input ignored meanwhile) dispatched at once
+  // replayed frames only advance while canvas is idle (i.e. not waiting for an open or save)
+  bool is_idle = !m_documents.get_active().is_busy();
+  std::vector<Command> commands = CommandQueue::get().take();
+  if (m_session_log.is_replaying()) {
+    commands = is_idle ? m_session_log.replay(m_i_frame) : std::vector<Command>();
+    Redraw::request();
+  }
+  m_session_log.record(m_i_frame, commands);
 
   // event listeners rel. to canvas & window
-  m_listener_canvas.handle_all();
-  m_listener_window.handle_all();
+  m_listener_canvas.handle_all(commands);
+  m_listener_window.handle_all(commands);
+  if (is_idle)
+    m_i_frame++;
+
+  // background documents evicted from vram over budget (after commands, e.g. once another tab was activated)
+  m_documents.enforce_budget();
+
+  // closed documents erased once their saves are encoded
+  m_documents.update_closing();
+
+  // thumbnail of active document captured once commands switched/closed documents
+  m_thumbnail_strip.update(m_documents);
 
   // show metrics window (for loaded fonts & glyphs)
   // ImGui::ShowMetricsWindow();
@@ -52,13 +110,39 @@ void Frame::render() {
   // show demo window (for imgui functionalities)
   // ImGui::ShowDemoWindow();
 
+  m_perf_overlay.render();
+  m_memory_panel.render();
+  m_thumbnail_strip.render();
+
   ImGui::Render();
+  GpuTimer::get().begin("imgui");
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  GpuTimer::get().end("imgui");
+
+  // textures of thumbnails decoded in background (outside of imgui frame)
+  m_thumbnails.upload();
+
+  m_perf_overlay.end_frame();
+}
+
+/* Canvas of active document (e.g. to check its content after a replay) */
+Canvas& Frame::get_canvas() {
+  return m_documents.get_active();
 }
 
-/* Destroy canvas & imgui */
+/* Destroy documents, gl resources they share & imgui */
 void Frame::free() {
-  m_canvas.free();
+  // pending uploads/readbacks finished before textures they use are freed
+  GlWorker::get().free();
+  SharedSurface::get().free();
+  m_session_log.free();
+  m_documents.free();
+  m_thumbnail_strip.free();
+  GpuResources::get().free();
+  TexturePool::get().free();
+  m_thumbnails.free();
+  GpuTimer::get().free();
+  UploadRing::get().free();
 
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
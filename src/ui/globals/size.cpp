@@ -3,4 +3,5 @@
 /* Static member requires a separate definition (avoids linking errors) */
 ImVec2 Size::menu = ImVec2(0.0f, 0.0f);
 ImVec2 Size::toolbar = ImVec2(0.0f, 0.0f);
+ImVec2 Size::tabs = ImVec2(0.0f, 0.0f);
 ImVec2 Size::canvas = ImVec2(0.0f, 0.0f);
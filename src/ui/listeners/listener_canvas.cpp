@@ -1,40 +1,311 @@
 #include <iostream>
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
 
 #include "ImGuiFileDialog/ImGuiFileDialog.h"
 
 #include "ui/listeners/listener_canvas.hpp"
 #include "ui/menu.hpp"
 #include "ui/toolbar.hpp"
+#include "ui/globals/size.hpp"
+#include "effects/blur_kernel.hpp"
+#include "gpu/tile_scheduler.hpp"
+#include "commands/command_queue.hpp"
+#include "profiling/tracer.hpp"
+
+namespace {
+  /* sliders of adjustment stage (see `ColorLut::get_defaults()`) */
+  struct Adjustment {
+    const char* name;
+    float min;
+    float max;
+  };
+
+  const Adjustment ADJUSTMENTS[] = {
+    { "black", 0.0f, 1.0f }, { "white", 0.0f, 1.0f }, { "brightness", -1.0f, 1.0f }, { "contrast", 0.0f, 4.0f },
+    { "gamma", 0.1f, 5.0f }, { "curve[0]", 0.0f, 1.0f }, { "curve[1]", 0.0f, 1.0f }, { "curve[2]", 0.0f, 1.0f },
+    { "curve[3]", 0.0f, 1.0f }, { "curve[4]", 0.0f, 1.0f }, { "gain_r", 0.0f, 2.0f }, { "gain_g", 0.0f, 2.0f },
+    { "gain_b", 0.0f, 2.0f },
+  };
+
+  /* extensions of formats in exports panel (encoder picked from extension), uncompressed ones on second row */
+  const char* FORMATS_EXPORT[] = { ".png", ".jpg", ".bmp", ".tga", ".raw", ".ppm", ".pgm", ".tif" };
+  const int N_FORMATS_ROW = 4;
+}
 
 /**
- * @param canvas Pointer passed so it can be modified (instead of modifying a copy)
+ * @param documents Pointer passed so they can be modified (instead of modifying a copy)
  */
-ListenerCanvas::ListenerCanvas(Canvas* canvas):
-  m_canvas(canvas)
+ListenerCanvas::ListenerCanvas(Documents* documents):
+  m_documents(documents),
+  m_canvas(&documents->get_active()),
+  m_export({ "./assets/images/export", { true, true }, ImageEncoder::QUALITY_JPEG, ImageEncoder::LEVEL_PNG, 1 })
 {
 }
 
-/* Handle all events related to canvas fired on click on menu items or toolbar buttons */
-void ListenerCanvas::handle_all() {
-  on_open_image();
-  on_save_image();
-  on_to_grayscale();
-  on_blur();
-  on_view_color();
-  on_view_grayscale();
-  on_view_monochrome();
-  on_zoom_in();
-  on_zoom_out();
+/* Dialogs (whose result is enqueued as a command) & panels shown over canvas */
+void ListenerCanvas::render() {
+  m_canvas = &m_documents->get_active();
+  Menu::play_sequence = m_canvas->is_playing();
+  show_open_dialog();
+  show_save_dialog();
+  show_compare_dialog();
+  show_overlay_dialog();
+
+  show_jobs();
+  show_exports();
+  show_effects();
+  show_histogram();
+  show_comparison();
+  show_layers();
 }
 
-/* Open a new image */
-void ListenerCanvas::on_open_image() {
+/**
+ * Dispatch commands enqueued in this frame (by menu, toolbar & canvas) in order
+ * Shapes & brush dabs they queued are drawn together at the end
+ */
+void ListenerCanvas::handle_all(const std::vector<Command>& commands) {
+  PROFILE_ZONE("ListenerCanvas::handle_all");
+  m_canvas = &m_documents->get_active();
+  for (const Command& command : commands)
+    handle(command);
+
+  m_canvas->flush_strokes();
+}
+
+void ListenerCanvas::handle(const Command& command) {
+  switch (command.type) {
+    // free previously opened image & open new one (in background), compressed for display if read-only
+    case CommandType::OPEN_IMAGE: {
+      PROFILE_ZONE("ListenerCanvas::on_open_image");
+      m_canvas->change_image(command.path, command.value != 0);
+      std::cout << "Opening image: " << command.path << '\n';
+      break;
+    }
+
+    // open image in a new tab, & switch to or close a tab (shapes drawn so far on active document flushed before)
+    case CommandType::NEW_DOCUMENT: {
+      PROFILE_ZONE("ListenerCanvas::on_new_document");
+      m_canvas->flush_strokes();
+      m_documents->open(command.path, command.value != 0);
+      m_canvas = &m_documents->get_active();
+      std::cout << "Opening image in new tab: " << command.path << '\n';
+      break;
+    }
+
+    case CommandType::SWITCH_DOCUMENT:
+      m_canvas->flush_strokes();
+      m_documents->activate(command.value);
+      m_canvas = &m_documents->get_active();
+      break;
+
+    case CommandType::CLOSE_DOCUMENT:
+      m_canvas->flush_strokes();
+      m_documents->close(command.value);
+      m_canvas = &m_documents->get_active();
+      break;
+
+    case CommandType::SAVE_IMAGE: {
+      PROFILE_ZONE("ListenerCanvas::on_save_image");
+      m_canvas->save_image(command.path);
+      std::cout << "Saving image to: " << command.path << '\n';
+      break;
+    }
+
+    case CommandType::EXPORT_IMAGE: {
+      PROFILE_ZONE("ListenerCanvas::on_export_image");
+      ImageEncoder::Options options;
+      options.quality = command.value;
+      options.level = (int) command.x1;
+      m_canvas->export_image(command.path, options, (int) command.y1);
+      std::cout << "Exporting image to: " << command.path << '\n';
+      break;
+    }
+
+    // step to next/previous image of folder in browse mode
+    case CommandType::BROWSE: {
+      PROFILE_ZONE("ListenerCanvas::on_browse");
+      m_canvas->browse(command.value);
+      break;
+    }
+
+    // play numbered sequence current image belongs to (or stop playing it)
+    case CommandType::PLAY_SEQUENCE: {
+      PROFILE_ZONE("ListenerCanvas::on_play_sequence");
+      m_canvas->play_sequence(command.path, command.value);
+      break;
+    }
+
+    // effects output compared to a reference image (or compare mode left)
+    case CommandType::COMPARE: {
+      PROFILE_ZONE("ListenerCanvas::on_compare");
+      m_canvas->compare(command.path, (CompareView) command.value, command.x1);
+      break;
+    }
+
+    // undo last shape/stroke drawn & redo last undone one
+    case CommandType::UNDO: {
+      PROFILE_ZONE("ListenerCanvas::on_undo");
+      m_canvas->undo();
+      break;
+    }
+
+    case CommandType::REDO: {
+      PROFILE_ZONE("ListenerCanvas::on_redo");
+      m_canvas->redo();
+      break;
+    }
+
+    // convert image to grayscale, blur it (separable gaussian) or convolve it (radius of both set in effects panel)
+    case CommandType::EFFECT: {
+      PROFILE_ZONE("ListenerCanvas::on_effect");
+      if ((Shader) command.value == Shader::GRAYSCALE)
+        m_canvas->to_grayscale();
+      else if ((Shader) command.value == Shader::BLUR)
+        m_canvas->blur();
+      else if (get_kernel((Shader) command.value))
+        m_canvas->convolve((Shader) command.value);
+      else if ((Shader) command.value == Shader::ADJUST)
+        m_canvas->adjust();
+      break;
+    }
+
+    case CommandType::SET_BLUR:
+      m_canvas->set_blur(command.value, command.x1, command.y1 != 0.0f);
+      break;
+
+    case CommandType::SET_RADIUS:
+      m_canvas->set_radius(command.value, command.x1);
+      break;
+
+    case CommandType::SET_ADJUSTMENT:
+      m_canvas->set_adjustment(command.value, command.path, command.x1);
+      break;
+
+    // remove last effect appended to chain (e.g. last blur), or all of them
+    case CommandType::REMOVE_EFFECT: {
+      PROFILE_ZONE("ListenerCanvas::on_remove_effect");
+      m_canvas->remove_effect();
+      break;
+    }
+
+    case CommandType::CLEAR_EFFECTS: {
+      PROFILE_ZONE("ListenerCanvas::on_clear_effects");
+      m_canvas->clear_effects();
+      break;
+    }
+
+    case CommandType::SET_BACKEND:
+      m_canvas->set_backend((Backend) command.value);
+      break;
+
+    // update shader to show image in color or grayscale (1-channel images shown in gray by swizzle)
+    case CommandType::VIEW: {
+      PROFILE_ZONE("ListenerCanvas::on_view");
+      m_canvas->set_shader((Shader) command.value);
+      break;
+    }
+
+    case CommandType::ZOOM:
+      if (command.value > 0)
+        m_canvas->zoom_in();
+      else if (command.value < 0)
+        m_canvas->zoom_out();
+      else
+        m_canvas->zoom_at(command.x2, command.x1, command.y1);
+      break;
+
+    case CommandType::PAN:
+      m_canvas->pan(command.x1, command.y1);
+      break;
+
+    case CommandType::DRAW_CIRCLE:
+      m_canvas->draw_circle(command.x1, command.y1);
+      break;
+
+    case CommandType::DRAW_LINE:
+      m_canvas->draw_line(command.x1, command.y1, command.x2, command.y2);
+      break;
+
+    case CommandType::BRUSH_TO:
+      m_canvas->brush_to(command.x1, command.y1);
+      break;
+
+    case CommandType::END_STROKE:
+      m_canvas->end_stroke();
+      break;
+
+    // annotation layers composited over image (shapes drawn on selected one)
+    case CommandType::ADD_LAYER: {
+      PROFILE_ZONE("ListenerCanvas::on_add_layer");
+      m_canvas->add_layer();
+      break;
+    }
+
+    case CommandType::REMOVE_LAYER:
+      m_canvas->remove_layer(command.value);
+      break;
+
+    case CommandType::SELECT_LAYER:
+      m_canvas->select_layer(command.value);
+      break;
+
+    case CommandType::SET_LAYER:
+      m_canvas->set_layer(command.value, command.x1, command.y1 != 0.0f);
+      break;
+
+    // effects restricted to selection
+    case CommandType::SELECT_RECT:
+      m_canvas->select_rect(command.x1, command.y1, command.x2, command.y2);
+      break;
+
+    case CommandType::SELECT_TO:
+      m_canvas->select_to(command.x1, command.y1);
+      break;
+
+    case CommandType::END_SELECTION:
+      m_canvas->end_selection();
+      break;
+
+    case CommandType::CLEAR_SELECTION:
+      m_canvas->clear_selection();
+      break;
+
+    // region of similar color grown on gpu from clicked pixel
+    case CommandType::FILL: {
+      PROFILE_ZONE("ListenerCanvas::on_fill");
+      m_canvas->fill(command.x1, command.y1, command.value / 255.0f);
+      break;
+    }
+
+    case CommandType::MAGIC_WAND: {
+      PROFILE_ZONE("ListenerCanvas::on_magic_wand");
+      m_canvas->magic_wand(command.x1, command.y1, command.value / 255.0f);
+      break;
+    }
+
+    // shapes of file drawn over image, or overlay cleared
+    case CommandType::LOAD_OVERLAY: {
+      PROFILE_ZONE("ListenerCanvas::on_load_overlay");
+      m_canvas->load_overlay(command.path);
+      break;
+    }
+
+    // handled by window listener
+    default:
+      break;
+  }
+}
+
+/* Dialog to pick image to open (from menu or toolbar) */
+void ListenerCanvas::show_open_dialog() {
   if (Menu::open_image || Toolbar::open_image) {
     std::cout << "Open image menu item enabled!" << '\n';
 
     // https://github.com/aiekick/ImGuiFileDialog#simple-dialog-
     // open image dialog
-    ImGuiFileDialog::Instance()->OpenModal("OpenImageKey", "Open image", "Image files{.jpg,.png}", "./assets/images", "");
+    ImGuiFileDialog::Instance()->OpenModal("OpenImageKey", "Open image", "Image files{.jpg,.png},Pyramids{.pyr}", "./assets/images", "");
     Menu::open_image = false;
     Toolbar::open_image = false;
   }
@@ -43,10 +314,8 @@ void ListenerCanvas::on_open_image() {
   if (ImGuiFileDialog::Instance()->Display("OpenImageKey", ImGuiWindowFlags_None, ImVec2(600, 300), ImVec2(600, 300))) {
     // get file path if ok
     if (ImGuiFileDialog::Instance()->IsOk()) {
-      // free previously opened image & open new one
-      std::string path_image = ImGuiFileDialog::Instance()->GetFilePathName();
-      m_canvas->change_image(path_image);
-      std::cout << "Path of opened image: " << path_image << '\n';
+      CommandType type = Menu::open_new_document ? CommandType::NEW_DOCUMENT : CommandType::OPEN_IMAGE;
+      CommandQueue::get().push({ type, Menu::open_read_only, 0.0f, 0.0f, 0.0f, 0.0f, ImGuiFileDialog::Instance()->GetFilePathName() });
     }
 
     // close file dialog
@@ -54,11 +323,11 @@ void ListenerCanvas::on_open_image() {
   }
 }
 
-/* Save opened/edited image */
-void ListenerCanvas::on_save_image() {
+/* Dialog to pick path opened/edited image is saved to */
+void ListenerCanvas::show_save_dialog() {
   if (Menu::save_image || Toolbar::save_image) {
     // open image dialog
-    ImGuiFileDialog::Instance()->OpenModal("SaveImageKey", "Save image", "Image files{.jpg,.png}", "./assets/images", "");
+    ImGuiFileDialog::Instance()->OpenModal("SaveImageKey", "Save image", "Image files{.jpg,.png},Uncompressed{.raw,.ppm,.pgm,.tif},Pyramids{.pyr}", "./assets/images", "");
     Menu::save_image = false;
     Toolbar::save_image = false;
   }
@@ -66,70 +335,363 @@ void ListenerCanvas::on_save_image() {
   // display save image file dialog
   if (ImGuiFileDialog::Instance()->Display("SaveImageKey", ImGuiWindowFlags_None, ImVec2(600, 300), ImVec2(600, 300))) {
     // get file path if ok
+    if (ImGuiFileDialog::Instance()->IsOk())
+      CommandQueue::get().push({ CommandType::SAVE_IMAGE, 0, 0.0f, 0.0f, 0.0f, 0.0f, ImGuiFileDialog::Instance()->GetFilePathName() });
+
+    // close file dialog
+    ImGuiFileDialog::Instance()->Close();
+  }
+}
+
+/* Dialog to pick reference image compared to displayed one (from menu) */
+void ListenerCanvas::show_compare_dialog() {
+  if (Menu::compare_image) {
+    ImGuiFileDialog::Instance()->OpenModal("CompareImageKey", "Compare with image", "Image files{.jpg,.png}", "./assets/images", "");
+    Menu::compare_image = false;
+  }
+
+  if (ImGuiFileDialog::Instance()->Display("CompareImageKey", ImGuiWindowFlags_None, ImVec2(600, 300), ImVec2(600, 300))) {
+    // view kept if already comparing
     if (ImGuiFileDialog::Instance()->IsOk()) {
-      // free previously opened image & open new one
-      std::string path_image = ImGuiFileDialog::Instance()->GetFilePathName();
-      m_canvas->save_image(path_image);
-      std::cout << "Path for saved image: " << path_image << '\n';
+      const Canvas::Comparison& comparison = m_canvas->get_comparison();
+      CompareView view = (comparison.view == CompareView::NONE) ? CompareView::DIFFERENCE : comparison.view;
+      CommandQueue::get().push({ CommandType::COMPARE, (int) view, comparison.gain, 0.0f, 0.0f, 0.0f,
+                                 ImGuiFileDialog::Instance()->GetFilePathName() });
     }
 
-    // close file dialog
     ImGuiFileDialog::Instance()->Close();
   }
 }
 
-/* convert opened image to grayscale & update shader to show monochrome image */
-void ListenerCanvas::on_to_grayscale() {
-  if (Menu::to_grayscale) {
-    m_canvas->to_grayscale();
-    Menu::to_grayscale = false;
+/* Dialog to pick file of circles & lines drawn over image (from menu) */
+void ListenerCanvas::show_overlay_dialog() {
+  if (Menu::load_overlay) {
+    ImGuiFileDialog::Instance()->OpenModal("LoadOverlayKey", "Load overlay", "Shapes files{.json,.csv}", "./assets", "");
+    Menu::load_overlay = false;
+  }
+
+  if (ImGuiFileDialog::Instance()->Display("LoadOverlayKey", ImGuiWindowFlags_None, ImVec2(600, 300), ImVec2(600, 300))) {
+    if (ImGuiFileDialog::Instance()->IsOk())
+      CommandQueue::get().push({ CommandType::LOAD_OVERLAY, 0, 0.0f, 0.0f, 0.0f, 0.0f, ImGuiFileDialog::Instance()->GetFilePathName() });
+
+    ImGuiFileDialog::Instance()->Close();
   }
 }
 
-/* blur opened image using a 9x9 avg filter */
-void ListenerCanvas::on_blur() {
-  if (Menu::blur) {
-    m_canvas->blur();
-    Menu::blur = false;
+/* Overlay at bottom-left corner with status of background jobs (opens & saves) */
+void ListenerCanvas::show_jobs() {
+  const auto& jobs = m_canvas->get_jobs();
+  if (jobs.empty())
+    return;
+
+  ImVec2 size_display = ImGui::GetIO().DisplaySize;
+  ImGui::SetNextWindowPos({ 10.0f, size_display.y - 10.0f }, ImGuiCond_Always, { 0.0f, 1.0f });
+  ImGui::SetNextWindowBgAlpha(0.75f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+  ImGui::Begin("Jobs", NULL, window_flags);
+
+  for (const auto& job : jobs) {
+    ImVec4 color = (job->status == JobStatus::FAILED) ? ImVec4(1.0f, 0.3f, 0.3f, 1.0f) :
+                   (job->status == JobStatus::DONE) ? ImVec4(0.3f, 1.0f, 0.3f, 1.0f) : ImGui::GetStyle().Colors[ImGuiCol_Text];
+    ImGui::TextColored(color, "%s: %s", job->label.c_str(), job->get_status_name());
+
+    if (!job->is_finished() && job->progress >= 0.0f) {
+      ImGui::SameLine();
+      ImGui::ProgressBar(job->progress, { 100.0f, 0.0f });
+    }
   }
+
+  ImGui::End();
 }
 
-/* update to shader to show image in color */
-void ListenerCanvas::on_view_color() {
-  if (Menu::view_color) {
-    m_canvas->set_shader("color");
-    Menu::view_color = false;
+/**
+ * Window opened from File menu: queues an export per checked format (all sharing one readback),
+ * & shows queue depth, throughput & timings of last exports
+ * Throughput per worker, i.e. pixels encoded over time spent encoding them
+ */
+void ListenerCanvas::show_exports() {
+  if (!Menu::export_image)
+    return;
+
+  ImGui::SetNextWindowBgAlpha(0.75f);
+  ImGui::Begin("Export", &Menu::export_image, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing);
+
+  ImGui::InputText("Path (no extension)", m_export.path, sizeof(m_export.path));
+  for (int i_format = 0; i_format < N_FORMATS_EXPORT; i_format++) {
+    if (i_format % N_FORMATS_ROW > 0)
+      ImGui::SameLine();
+    ImGui::Checkbox(FORMATS_EXPORT[i_format], &m_export.formats[i_format]);
+  }
+
+  ImGui::SliderInt("Jpeg quality", &m_export.quality, 1, 100);
+  ImGui::SliderInt("Png level", &m_export.level, 0, 9);
+  ImGui::SliderInt("Downscale", &m_export.factor, 1, 8, "1/%d");
+
+  // one command per format (replayed sessions export the same files)
+  if (ImGui::Button("Queue")) {
+    for (int i_format = 0; i_format < N_FORMATS_EXPORT; i_format++) {
+      if (!m_export.formats[i_format])
+        continue;
+
+      std::string path = std::string(m_export.path) + FORMATS_EXPORT[i_format];
+      CommandQueue::get().push({ CommandType::EXPORT_IMAGE, m_export.quality, (float) m_export.level, (float) m_export.factor,
+                                 0.0f, 0.0f, path });
+    }
+  }
+  ImGui::Separator();
+
+  const Canvas::ExportStats& stats = m_canvas->get_export_stats();
+  int n_finished = stats.n_done + stats.n_failed;
+  ImGui::Text("Queue depth: %zu", m_canvas->get_n_exports_pending());
+  ImGui::Text("Finished: %d (%d failed)", n_finished, stats.n_failed);
+  if (n_finished > 0) {
+    ImGui::Text("Throughput: %.1f Mpx/s per worker", stats.duration_running > 0.0 ? stats.n_megapixels / stats.duration_running : 0.0);
+    ImGui::Text("Mean wait: %.0f ms, mean encoding: %.0f ms", 1e3 * stats.duration_waiting / n_finished,
+                1e3 * stats.duration_running / n_finished);
+  }
+
+  // wait includes readback, so a job encoded right after its readback waited for gpu only
+  if (ImGui::BeginTable("Exports", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+    ImGui::TableSetupColumn("Job");
+    ImGui::TableSetupColumn("Status");
+    ImGui::TableSetupColumn("Wait (ms)");
+    ImGui::TableSetupColumn("Encoding (ms)");
+    ImGui::TableHeadersRow();
+
+    for (const auto& job : m_canvas->get_exports()) {
+      float duration_waiting = job->duration_waiting, duration_running = job->duration_running;
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(job->label.c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(job->get_status_name());
+      ImGui::TableNextColumn();
+      if (duration_waiting >= 0.0f)
+        ImGui::Text("%.1f", 1e3f * duration_waiting);
+      ImGui::TableNextColumn();
+      if (duration_running >= 0.0f)
+        ImGui::Text("%.1f", 1e3f * duration_running);
+    }
+
+    ImGui::EndTable();
   }
+
+  ImGui::End();
 }
 
-/* update shader to show image in grayscale */
-void ListenerCanvas::on_view_grayscale() {
-  if (Menu::view_grayscale) {
-    m_canvas->set_shader("grayscale");
-    Menu::view_grayscale = false;
+/* Panel at top-right corner listing effects applied to image, with their parameters */
+void ListenerCanvas::show_effects() {
+  std::vector<Effect> effects = m_canvas->get_effects();
+  if (effects.empty())
+    return;
+
+  ImVec2 size_display = ImGui::GetIO().DisplaySize;
+  float y_offset = Size::menu.y + Size::toolbar.y + Size::tabs.y;
+  ImGui::SetNextWindowPos({ size_display.x - 10.0f, y_offset + 10.0f }, ImGuiCond_Always, { 1.0f, 0.0f });
+  ImGui::SetNextWindowBgAlpha(0.75f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+  ImGui::Begin("Effects", NULL, window_flags);
+
+  // same chain can be timed with both backends
+  bool is_compute = m_canvas->get_backend() == Backend::COMPUTE;
+  if (ComputeEffects::is_supported() && ImGui::Checkbox("Compute shaders", &is_compute))
+    CommandQueue::get().push({ CommandType::SET_BACKEND, (int) (is_compute ? Backend::COMPUTE : Backend::FRAGMENT) });
+  ImGui::Text("%s: %.2f ms", is_compute ? "Compute" : "Fragment", m_canvas->get_duration_effects());
+
+  // tiles fitting in frame budget (time above is then the one of last frame's tiles)
+  if (TileScheduler::budget > 0.0f) {
+    float duration_tile = m_canvas->get_duration_tile_effects();
+    ImGui::Text("Tiles: %d / frame (%.2f ms each, budget %.1f ms)", m_canvas->get_n_tiles_effects(),
+                std::max(duration_tile, 0.0f), TileScheduler::budget);
+  }
+  ImGui::Separator();
+
+  for (size_t i_stage = 0; i_stage < effects.size(); i_stage++) {
+    Effect& effect = effects[i_stage];
+    ImGui::PushID(i_stage);
+
+    // separable blur made of horizontal & vertical stages edited together
+    if (effect.shader == Shader::BLUR_SEPARABLE) {
+      int radius = effect.parameters["radius"];
+      bool is_box = effect.parameters["is_box"];
+      ImGui::Text("Blur");
+      bool has_changed = ImGui::SliderInt("Radius", &radius, 1, BlurKernel::RADIUS_MAX);
+      ImGui::SameLine();
+      has_changed |= ImGui::Checkbox("Box", &is_box);
+      if (has_changed)
+        CommandQueue::get().push({ CommandType::SET_BLUR, (int) i_stage, (float) radius, (float) is_box });
+
+      i_stage++;
+    } else if (get_kernel(effect.shader)) {
+      // one program per radius, so slider limited to instantiated kernels
+      int radius = ProgramTable::get_variant(effect.shader, effect.parameters);
+      ImGui::Text("%s", get_shader_info(effect.shader).name);
+      if (ImGui::SliderInt("Radius", &radius, 1, RADIUS_MAX_CONVOLUTION))
+        CommandQueue::get().push({ CommandType::SET_RADIUS, (int) i_stage, (float) radius });
+    } else if (effect.shader == Shader::ADJUST) {
+      // all adjustments folded into one table, so editing one re-renders a single pass
+      ImGui::Text("Adjust");
+      for (const auto& [name, min, max] : ADJUSTMENTS) {
+        float value = effect.parameters[name];
+        if (ImGui::SliderFloat(name, &value, min, max))
+          CommandQueue::get().push({ CommandType::SET_ADJUSTMENT, (int) i_stage, value, 0.0f, 0.0f, 0.0f, name });
+      }
+    } else {
+      ImGui::Text("%s", get_shader_info(effect.shader).name);
+    }
+
+    ImGui::PopID();
   }
+
+  ImGui::End();
 }
 
-/* update to shader to show monochrome (1-channel) image */
-void ListenerCanvas::on_view_monochrome() {
-  if (Menu::view_monochrome) {
-    m_canvas->set_shader("monochrome");
-    Menu::view_monochrome = false;
+/* Panel at top-left corner with histogram & min/max/mean of each channel of displayed image (View menu) */
+void ListenerCanvas::show_histogram() {
+  if (!Menu::view_histogram)
+    return;
+
+  float y_offset = Size::menu.y + Size::toolbar.y + Size::tabs.y;
+  ImGui::SetNextWindowPos({ 10.0f, y_offset + 10.0f }, ImGuiCond_Always, { 0.0f, 0.0f });
+  ImGui::SetNextWindowBgAlpha(0.75f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+  ImGui::Begin("Histogram", NULL, window_flags);
+
+  const ImageStats* stats = m_canvas->get_image_stats();
+  if (!ComputeEffects::is_supported()) {
+    ImGui::TextDisabled("Histogram needs compute shaders (OpenGL 4.3)");
+  } else if (stats == NULL) {
+    ImGui::TextDisabled("Computing histogram...");
+  } else {
+    const char* names[] = { "Red", "Green", "Blue", "Alpha" };
+    const ImVec4 colors[] = { {1.0f, 0.3f, 0.3f, 1.0f}, {0.3f, 1.0f, 0.3f, 1.0f}, {0.4f, 0.5f, 1.0f, 1.0f}, {0.8f, 0.8f, 0.8f, 1.0f} };
+    ImGui::Text("%dx%d", stats->width, stats->height);
+
+    for (int i_channel = 0; i_channel < stats->n_channels; i_channel++) {
+      float bins[ImageStats::N_BINS];
+      for (int i_bin = 0; i_bin < ImageStats::N_BINS; i_bin++)
+        bins[i_bin] = stats->bins[i_channel][i_bin];
+
+      ImGui::PushID(i_channel);
+      ImGui::PushStyleColor(ImGuiCol_PlotHistogram, colors[i_channel]);
+      ImGui::PlotHistogram("", bins, ImageStats::N_BINS, 0, NULL, 0.0f, FLT_MAX, { 256.0f, 50.0f });
+      ImGui::PopStyleColor();
+      ImGui::SameLine();
+      ImGui::Text("%s\nmin %d\nmax %d\nmean %.1f", names[i_channel], stats->min[i_channel], stats->max[i_channel],
+                  stats->mean[i_channel]);
+      ImGui::PopID();
+    }
   }
+
+  ImGui::End();
 }
 
-void ListenerCanvas::on_zoom_in() {
-  if (Menu::zoom_in || Toolbar::zoom_in) {
-    m_canvas->zoom_in();
-    Menu::zoom_in = false;
-    Toolbar::zoom_in = false;
+/* Panel at top of canvas with view & metrics of compare mode (shown while comparing) */
+void ListenerCanvas::show_comparison() {
+  const Canvas::Comparison& comparison = m_canvas->get_comparison();
+  if (comparison.view == CompareView::NONE)
+    return;
+
+  float y_offset = Size::menu.y + Size::toolbar.y + Size::tabs.y;
+  ImGui::SetNextWindowPos({ ImGui::GetIO().DisplaySize.x / 2.0f, y_offset + 10.0f }, ImGuiCond_Always, { 0.5f, 0.0f });
+  ImGui::SetNextWindowBgAlpha(0.75f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+  ImGui::Begin("Comparison", NULL, window_flags);
+  ImGui::Text("Reference: %s", comparison.path.c_str());
+
+  // radio buttons & slider enqueue same command with changed view/gain (reference kept)
+  CommandQueue& queue = CommandQueue::get();
+  int view = (int) comparison.view;
+  float gain = comparison.gain;
+  bool has_changed = ImGui::RadioButton("Difference", &view, (int) CompareView::DIFFERENCE);
+  ImGui::SameLine();
+  has_changed |= ImGui::RadioButton("Heatmap", &view, (int) CompareView::HEATMAP);
+  ImGui::SameLine();
+  has_changed |= ImGui::RadioButton("Flicker", &view, (int) CompareView::FLICKER);
+  ImGui::SetNextItemWidth(200.0f);
+  has_changed |= ImGui::SliderFloat("Gain", &gain, 1.0f, 64.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+  if (has_changed)
+    queue.push({ CommandType::COMPARE, view, gain });
+
+  ImGui::Separator();
+  if (!comparison.is_loaded) {
+    ImGui::TextDisabled("Loading reference...");
+  } else if (!m_canvas->is_comparing()) {
+    ImGui::TextDisabled("Compare mode needs an editable image in normal mode");
+  } else if (!ComputeEffects::is_supported()) {
+    ImGui::TextDisabled("Metrics need compute shaders (OpenGL 4.3)");
+  } else if (!comparison.has_metrics) {
+    ImGui::TextDisabled("No metrics: image & reference sizes differ");
+  } else if (!comparison.similarity) {
+    ImGui::TextDisabled("Computing metrics...");
+  } else {
+    const Similarity& similarity = *comparison.similarity;
+    ImGui::Text("%dx%d", similarity.width, similarity.height);
+    ImGui::Text("MSE  %.6f", similarity.mse);
+    if (std::isinf(similarity.psnr))
+      ImGui::Text("PSNR inf (identical)");
+    else
+      ImGui::Text("PSNR %.2f dB", similarity.psnr);
+    ImGui::Text("SSIM %.4f", similarity.ssim);
   }
+
+  if (ImGui::Button("Stop comparing"))
+    queue.push({ CommandType::COMPARE, (int) CompareView::NONE, gain });
+
+  ImGui::End();
 }
 
-void ListenerCanvas::on_zoom_out() {
-  if (Menu::zoom_out || Toolbar::zoom_out) {
-    m_canvas->zoom_out();
-    Menu::zoom_out = false;
-    Toolbar::zoom_out = false;
+/* Panel at bottom-right corner listing layers from top to bottom (View menu), selected one is drawn on */
+void ListenerCanvas::show_layers() {
+  if (!Menu::view_layers)
+    return;
+
+  ImVec2 size_display = ImGui::GetIO().DisplaySize;
+  ImGui::SetNextWindowPos({ size_display.x - 10.0f, size_display.y - 10.0f }, ImGuiCond_Always, { 1.0f, 1.0f });
+  ImGui::SetNextWindowBgAlpha(0.75f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+  ImGui::Begin("Layers", NULL, window_flags);
+
+  CommandQueue& queue = CommandQueue::get();
+  const LayerStack* layers = m_canvas->get_layers();
+  size_t n_layers = layers ? layers->get_layers().size() : 1;
+  size_t i_active = layers ? layers->get_i_active() : 0;
+
+  for (size_t i_layer = n_layers; i_layer-- > 0; ) {
+    // image shown as only layer until an annotation layer is added
+    std::string name = layers ? layers->get_layers()[i_layer].name : "Image";
+    float opacity = layers ? layers->get_layers()[i_layer].opacity : 1.0f;
+    bool is_visible = layers ? layers->get_layers()[i_layer].is_visible : true;
+    ImGui::PushID(i_layer);
+
+    ImGui::BeginDisabled(layers == NULL);
+    bool has_changed = ImGui::Checkbox("##visible", &is_visible);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100.0f);
+    has_changed |= ImGui::SliderFloat("##opacity", &opacity, 0.0f, 1.0f, "%.2f");
+    if (has_changed)
+      queue.push({ CommandType::SET_LAYER, (int) i_layer, opacity, (float) is_visible });
+    ImGui::EndDisabled();
+
+    ImGui::SameLine();
+    if (ImGui::Selectable(name.c_str(), i_layer == i_active) && i_layer != i_active)
+      queue.push({ CommandType::SELECT_LAYER, (int) i_layer });
+    ImGui::PopID();
   }
+
+  ImGui::Separator();
+  if (ImGui::Button("Add layer"))
+    queue.push({ CommandType::ADD_LAYER });
+  ImGui::SameLine();
+  ImGui::BeginDisabled(i_active == 0);
+  if (ImGui::Button("Remove layer"))
+    queue.push({ CommandType::REMOVE_LAYER, (int) i_active });
+  ImGui::EndDisabled();
+
+  ImGui::End();
 }
@@ -1,6 +1,4 @@
 #include "ui/listeners/listener_window.hpp"
-#include "ui/menu.hpp"
-#include "ui/toolbar.hpp"
 
 /**
  * @param canvas Pointer passed so it can be modified (instead of modifying a copy)
@@ -10,13 +8,10 @@ ListenerWindow::ListenerWindow(Window* window):
 {
 }
 
-/* Handle all events related to glfw window fired on click on menu items or toolbar buttons */
-void ListenerWindow::handle_all() {
-  on_quit_app();
-}
-
-void ListenerWindow::on_quit_app() {
-  if (Menu::quit_app || Toolbar::quit_app) {
-    m_window->close();
+/* Handle commands related to glfw window enqueued by menu items or toolbar buttons */
+void ListenerWindow::handle_all(const std::vector<Command>& commands) {
+  for (const Command& command : commands) {
+    if (command.type == CommandType::QUIT)
+      m_window->close();
   }
 }
@@ -0,0 +1,93 @@
+#include "imgui.h"
+
+#include "ui/memory_panel.hpp"
+#include "ui/menu.hpp"
+
+void MemoryPanel::render() {
+  if (!Menu::view_memory)
+    return;
+
+  // entries of textures & buffers freed outside of tracked code (e.g. by submodules) dropped first
+  MemoryTracker& tracker = MemoryTracker::get();
+  tracker.prune();
+
+  ImGui::SetNextWindowSize({ 420.0f, 0.0f }, ImGuiCond_FirstUseEver);
+  ImGui::Begin("Memory", &Menu::view_memory);
+  ImGui::Text("GPU: %.1f MB", to_mb(tracker.get_n_bytes_gpu()));
+  ImGui::SameLine();
+  ImGui::Text("CPU: %.1f MB", to_mb(tracker.get_n_bytes_cpu()));
+
+  ImGuiTableFlags table_flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+  if (ImGui::CollapsingHeader("Owners", ImGuiTreeNodeFlags_DefaultOpen) &&
+      ImGui::BeginTable("owners", 4, table_flags)) {
+    ImGui::TableSetupColumn("Owner");
+    ImGui::TableSetupColumn("Kind");
+    ImGui::TableSetupColumn("Count");
+    ImGui::TableSetupColumn("MB");
+    ImGui::TableHeadersRow();
+
+    // count of allocations held in format of each total
+    for (const MemoryTracker::Allocation& owner : tracker.get_owners()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(owner.owner.c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(get_kind(owner.kind));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(owner.format.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", to_mb(owner.n_bytes));
+    }
+
+    ImGui::EndTable();
+  }
+
+  if (ImGui::CollapsingHeader("Largest allocations") && ImGui::BeginTable("largest", 4, table_flags)) {
+    ImGui::TableSetupColumn("Owner");
+    ImGui::TableSetupColumn("Kind");
+    ImGui::TableSetupColumn("Format");
+    ImGui::TableSetupColumn("MB");
+    ImGui::TableHeadersRow();
+
+    for (const MemoryTracker::Allocation& allocation : tracker.get_largest(N_LARGEST)) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(allocation.owner.c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(get_kind(allocation.kind));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(allocation.format.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", to_mb(allocation.n_bytes));
+    }
+
+    ImGui::EndTable();
+  }
+
+  // applied by caches next time they grow (prefetch cache every frame, history on next commit)
+  if (ImGui::CollapsingHeader("Budgets", ImGuiTreeNodeFlags_DefaultOpen)) {
+    for (int i_budget = 0; i_budget < MemoryTracker::N_BUDGETS; i_budget++) {
+      MemoryBudget budget = (MemoryBudget) i_budget;
+      int budget_mb = (int) (tracker.get_budget(budget) >> 20);
+      if (ImGui::SliderInt(MemoryTracker::get_name(budget), &budget_mb, 0, BUDGET_MAX, "%d MB"))
+        tracker.set_budget(budget, (size_t) budget_mb << 20);
+    }
+  }
+
+  ImGui::End();
+}
+
+const char* MemoryPanel::get_kind(MemoryKind kind) {
+  switch (kind) {
+    case MemoryKind::TEXTURE:
+      return "texture";
+    case MemoryKind::BUFFER:
+      return "buffer";
+    default:
+      return "cpu";
+  }
+}
+
+float MemoryPanel::to_mb(size_t n_bytes) {
+  return n_bytes / (1024.0f * 1024.0f);
+}
@@ -1,33 +1,46 @@
 #include "imgui/imgui.h"
+#include "ImGuiFileDialog/ImGuiFileDialog.h"
 
 #include "ui/menu.hpp"
 #include "ui/toolbar.hpp"
+#include "ui/pacing.hpp"
 #include "ui/globals/size.hpp"
+#include "commands/command_queue.hpp"
+#include "effects/program_table.hpp"
+#include "gpu/sequence_player.hpp"
 
 /* static members definition (avoids linking error) & initialization */
 // menu File
 bool Menu::open_image = false;
 bool Menu::save_image = false;
-bool Menu::quit_app = false;
-
-// menu Edit
-bool Menu::to_grayscale = false;
-bool Menu::blur = false;
+bool Menu::export_image = false;
+bool Menu::browse_folder = false;
+bool Menu::open_read_only = false;
+bool Menu::open_new_document = false;
+bool Menu::play_sequence = false;
+bool Menu::compare_image = false;
+bool Menu::load_overlay = false;
 
 // menu View
-bool Menu::view_color = false;
-bool Menu::view_grayscale = false;
-bool Menu::view_monochrome = false;
-
-// menu Zoom
-bool Menu::zoom_in = false;
-bool Menu::zoom_out = false;
+bool Menu::view_histogram = false;
+bool Menu::view_performance = false;
+bool Menu::view_memory = false;
+bool Menu::view_display_resolution = true;
+bool Menu::view_layers = false;
+bool Menu::view_thumbnails = false;
+bool Menu::view_overlay = true;
 
 // menu Draw
 bool Menu::draw_circle = false;
 bool Menu::draw_line = false;
 bool Menu::brush_circle = false;
 bool Menu::brush_line = false;
+bool Menu::fill = false;
+
+// menu Select
+bool Menu::select_rect = false;
+bool Menu::select_lasso = false;
+bool Menu::magic_wand = false;
 
 Menu::Menu()
 {
@@ -35,34 +48,86 @@ Menu::Menu()
 
 /**
  * Menu items act like toggle buttons in imgui
- * boolean flag set/unset on every click
+ * boolean flag set/unset on every click, or command enqueued for actions (incl. keyboard shortcuts)
  * Sets the size of menu drawn to place image canvas below it
  */
 void Menu::render() {
+  CommandQueue& queue = CommandQueue::get();
+
   if (ImGui::BeginMainMenuBar()) {
     if (ImGui::BeginMenu("File")) {
       ImGui::MenuItem("Open", NULL, &Menu::open_image);
       ImGui::MenuItem("Save", NULL, &Menu::save_image);
-      ImGui::MenuItem("Quit", NULL, &Menu::quit_app);
+      ImGui::MenuItem("Export...", NULL, &Menu::export_image);
+      ImGui::MenuItem("Open read-only (compressed)", NULL, &Menu::open_read_only);
+      ImGui::MenuItem("Open in new tab", NULL, &Menu::open_new_document);
+      ImGui::Separator();
+      ImGui::MenuItem("Browse folder", NULL, &Menu::browse_folder);
+      if (ImGui::MenuItem("Next image", "Right", false, Menu::browse_folder))
+        queue.push({ CommandType::BROWSE, 1 });
+      if (ImGui::MenuItem("Previous image", "Left", false, Menu::browse_folder))
+        queue.push({ CommandType::BROWSE, -1 });
+      // checked while active document plays (mirrored from canvas by its listener)
+      if (ImGui::MenuItem("Play sequence", NULL, Menu::play_sequence))
+        queue.push({ CommandType::PLAY_SEQUENCE, Menu::play_sequence ? 0 : SequencePlayer::FPS_DEFAULT });
+      ImGui::MenuItem("Compare with...", NULL, &Menu::compare_image);
+      ImGui::MenuItem("Load overlay...", NULL, &Menu::load_overlay);
+      if (ImGui::MenuItem("Clear overlay", NULL))
+        queue.push({ CommandType::LOAD_OVERLAY });
+      ImGui::Separator();
+      if (ImGui::MenuItem("Quit", NULL))
+        queue.push({ CommandType::QUIT });
       ImGui::EndMenu();
     }
 
     if (ImGui::BeginMenu("Edit")) {
-      ImGui::MenuItem("To grayscale", NULL, &Menu::to_grayscale);
-      ImGui::MenuItem("Blur", NULL, &Menu::blur);
+      if (ImGui::MenuItem("Undo", "Ctrl+Z"))
+        queue.push({ CommandType::UNDO });
+      if (ImGui::MenuItem("Redo", "Ctrl+Y"))
+        queue.push({ CommandType::REDO });
+      ImGui::Separator();
+      if (ImGui::MenuItem("To grayscale", NULL))
+        queue.push({ CommandType::EFFECT, (int) Shader::GRAYSCALE });
+      if (ImGui::MenuItem("Blur", NULL))
+        queue.push({ CommandType::EFFECT, (int) Shader::BLUR });
+      if (ImGui::MenuItem("Sharpen", NULL))
+        queue.push({ CommandType::EFFECT, (int) Shader::SHARPEN });
+      if (ImGui::MenuItem("Edges (sobel)", NULL))
+        queue.push({ CommandType::EFFECT, (int) Shader::SOBEL });
+      if (ImGui::MenuItem("Adjust colors", NULL))
+        queue.push({ CommandType::EFFECT, (int) Shader::ADJUST });
+      ImGui::Separator();
+      if (ImGui::MenuItem("Remove last effect", NULL))
+        queue.push({ CommandType::REMOVE_EFFECT });
+      if (ImGui::MenuItem("Clear effects", NULL))
+        queue.push({ CommandType::CLEAR_EFFECTS });
       ImGui::EndMenu();
     }
 
     if (ImGui::BeginMenu("View")) {
-      ImGui::MenuItem("Color", NULL, &Menu::view_color);
-      ImGui::MenuItem("Grayscale", NULL, &Menu::view_grayscale);
-      ImGui::MenuItem("Monochrome", NULL, &Menu::view_monochrome);
+      if (ImGui::MenuItem("Color", NULL))
+        queue.push({ CommandType::VIEW, (int) Shader::COLOR });
+      if (ImGui::MenuItem("Grayscale", NULL))
+        queue.push({ CommandType::VIEW, (int) Shader::GRAYSCALE });
+      ImGui::Separator();
+      ImGui::MenuItem("Histogram", NULL, &Menu::view_histogram);
+      ImGui::MenuItem("Performance", NULL, &Menu::view_performance);
+      ImGui::MenuItem("Memory", NULL, &Menu::view_memory);
+      ImGui::MenuItem("Display resolution", NULL, &Menu::view_display_resolution);
+      ImGui::MenuItem("Layers", NULL, &Menu::view_layers);
+      ImGui::MenuItem("Thumbnails", NULL, &Menu::view_thumbnails);
+      ImGui::MenuItem("Overlay", NULL, &Menu::view_overlay);
+      ImGui::Separator();
+      ImGui::MenuItem("Low-latency pacing", NULL, &Pacing::low_latency);
+      ImGui::MenuItem("No vsync while drawing", NULL, &Pacing::no_vsync_drawing);
       ImGui::EndMenu();
     }
 
     if (ImGui::BeginMenu("Zoom")) {
-      ImGui::MenuItem("Zoom in", NULL, &Menu::zoom_in);
-      ImGui::MenuItem("Zoom out", NULL, &Menu::zoom_out);
+      if (ImGui::MenuItem("Zoom in", NULL))
+        queue.push({ CommandType::ZOOM, 1 });
+      if (ImGui::MenuItem("Zoom out", NULL))
+        queue.push({ CommandType::ZOOM, -1 });
       ImGui::EndMenu();
     }
 
@@ -84,10 +149,44 @@ void Menu::render() {
       ImGui::MenuItem("Brush line", NULL, &Menu::brush_line);
       Toolbar::brush_line = Menu::brush_line;
 
+      ImGui::MenuItem("Fill", NULL, &Menu::fill);
+      Toolbar::fill = Menu::fill;
+
+      ImGui::EndMenu();
+    }
+
+    // effects restricted to selection (one tool at a time)
+    if (ImGui::BeginMenu("Select")) {
+      if (ImGui::MenuItem("Rectangle", NULL, &Menu::select_rect))
+        Menu::select_lasso = Menu::magic_wand = false;
+      if (ImGui::MenuItem("Lasso", NULL, &Menu::select_lasso))
+        Menu::select_rect = Menu::magic_wand = false;
+      if (ImGui::MenuItem("Magic wand", NULL, &Menu::magic_wand))
+        Menu::select_rect = Menu::select_lasso = false;
+      Toolbar::select_rect = Menu::select_rect;
+      Toolbar::select_lasso = Menu::select_lasso;
+      Toolbar::magic_wand = Menu::magic_wand;
+
+      ImGui::Separator();
+      if (ImGui::MenuItem("Deselect", NULL))
+        queue.push({ CommandType::CLEAR_SELECTION });
       ImGui::EndMenu();
     }
 
     Size::menu = ImGui::GetWindowSize();
     ImGui::EndMainMenuBar();
   }
+
+  // shortcuts of undo/redo & of browse mode (arrow keys ignored while typing, e.g. path in file dialog)
+  ImGuiIO& io = ImGui::GetIO();
+  if (io.KeyCtrl && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Z)))
+    queue.push({ CommandType::UNDO });
+  if (io.KeyCtrl && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Y)))
+    queue.push({ CommandType::REDO });
+
+  bool is_key_allowed = Menu::browse_folder && !io.WantTextInput && !ImGuiFileDialog::Instance()->IsOpened();
+  if (is_key_allowed && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_RightArrow)))
+    queue.push({ CommandType::BROWSE, 1 });
+  if (is_key_allowed && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_LeftArrow)))
+    queue.push({ CommandType::BROWSE, -1 });
 }
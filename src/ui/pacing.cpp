@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <thread>
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+#include "imgui.h"
+
+#include "ui/pacing.hpp"
+#include "ui/menu.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+bool Pacing::low_latency = false;
+bool Pacing::no_vsync_drawing = false;
+float Pacing::latency = 0.0f;
+unsigned int Pacing::n_latencies = 0;
+
+float Pacing::period = 1000.0f / 60.0f;
+float Pacing::duration_work = 0.0f;
+bool Pacing::is_vsync_off = false;
+bool Pacing::has_input_pending = false;
+bool Pacing::has_input_frame = false;
+Pacing::Clock::time_point Pacing::time_input_pending;
+Pacing::Clock::time_point Pacing::time_input_frame;
+Pacing::Clock::time_point Pacing::time_start;
+Pacing::Clock::time_point Pacing::time_present;
+
+/* Frame period from refresh rate of primary monitor (60 Hz assumed if unknown), called once window is created */
+void Pacing::init() {
+  GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+  const GLFWvidmode* mode = monitor != NULL ? glfwGetVideoMode(monitor) : NULL;
+  if (mode != NULL && mode->refreshRate > 0)
+    period = 1000.0f / mode->refreshRate;
+
+  time_present = Clock::now();
+}
+
+/**
+ * Adaptive frame limiter, called before input is polled in low-latency mode or while vsync is off for drawing
+ * Sleeps until predicted start of last frame that can still be presented at next vsync (i.e. one period after
+ * last present, minus frame work & a margin), so input isn't sampled a whole frame before it's shown,
+ * & frames drawn without vsync stay capped at refresh rate
+ */
+void Pacing::limit() {
+  if (!low_latency && !is_vsync_off)
+    return;
+
+  float duration_sleep = period - duration_work - MARGIN;
+  Clock::time_point time_wake = time_present + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<float, std::milli>(duration_sleep));
+  if (duration_sleep > 0.0f && time_wake > Clock::now())
+    std::this_thread::sleep_until(time_wake);
+}
+
+/**
+ * Called once input of frame has been polled, right before frame is built
+ * Input received until now is shown by this frame, & vsync toggled when a brush stroke starts/ends
+ */
+void Pacing::begin_frame() {
+  time_start = Clock::now();
+  has_input_frame = has_input_pending;
+  time_input_frame = time_input_pending;
+  has_input_pending = false;
+
+  bool has_vsync_off = no_vsync_drawing && is_drawing();
+  if (has_vsync_off != is_vsync_off) {
+    glfwSwapInterval(has_vsync_off ? 0 : 1);
+    is_vsync_off = has_vsync_off;
+  }
+}
+
+/**
+ * Called after swapping buffers
+ * In low-latency mode, waits for gpu to finish frame so cpu doesn't queue frames ahead (each adds a frame of latency),
+ * which also makes present time measured here accurate (otherwise only a lower bound)
+ */
+void Pacing::end_frame() {
+  if (low_latency)
+    glFinish();
+
+  time_present = Clock::now();
+  float duration = std::chrono::duration<float, std::milli>(time_present - time_start).count();
+  duration_work += WEIGHT_WORK * (std::min(duration, period) - duration_work);
+
+  if (has_input_frame) {
+    latency = std::chrono::duration<float, std::milli>(time_present - time_input_frame).count();
+    n_latencies++;
+  }
+}
+
+/* Input event received (called from glfw callbacks, only first one of a frame is kept) */
+void Pacing::on_input() {
+  if (has_input_pending)
+    return;
+
+  has_input_pending = true;
+  time_input_pending = Clock::now();
+}
+
+/* Brush stroke in progress (brush mode with left button held) */
+bool Pacing::is_drawing() {
+  return (Menu::brush_circle || Menu::brush_line) && ImGui::IsMouseDown(ImGuiMouseButton_Left);
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+#include "imgui.h"
+
+#include "ui/perf_overlay.hpp"
+#include "ui/menu.hpp"
+#include "ui/pacing.hpp"
+#include "profiling/gpu_timer.hpp"
+#include "profiling/tracer.hpp"
+#include "profiling/memory_tracker.hpp"
+#include "profiling/metrics_exporter.hpp"
+#include "gpu/sequence_player.hpp"
+#include "gpu/texture_pool.hpp"
+#include "image/buffer_pool.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+bool PerfOverlay::is_timed = false;
+
+PerfOverlay::PerfOverlay():
+  m_durations_cpu(N_FRAMES, 0.0f),
+  m_durations_gpu(N_FRAMES, 0.0f),
+  m_latencies(N_FRAMES, 0.0f),
+  m_i_head_cpu(0),
+  m_i_head_gpu(0),
+  m_i_head_latency(0),
+  m_n_cpu(0),
+  m_n_gpu(0),
+  m_n_latency(0),
+  m_i_frame_gpu(0),
+  m_n_latencies(0)
+{
+}
+
+/**
+ * Start cpu clock & gpu "frame" pass (called before any gl command of frame)
+ * Gpu results of previous frames read here, as they arrive a few frames later
+ */
+void PerfOverlay::begin_frame() {
+  Tracer::collect();
+
+  GpuTimer& timer = GpuTimer::get();
+  timer.set_enabled(Menu::view_performance || PerfOverlay::is_timed || MetricsExporter::get().is_enabled());
+  timer.collect();
+
+  for (const GpuTimer::Result& result : timer.get_results()) {
+    if (result.name == "frame" && result.i_frame != m_i_frame_gpu) {
+      push(m_durations_gpu, m_i_head_gpu, m_n_gpu, result.duration);
+      m_i_frame_gpu = result.i_frame;
+    }
+  }
+
+  // latency of previous frame known once it was presented
+  if (Pacing::n_latencies != m_n_latencies) {
+    push(m_latencies, m_i_head_latency, m_n_latency, Pacing::latency);
+    m_n_latencies = Pacing::n_latencies;
+  }
+
+  m_time_start = std::chrono::steady_clock::now();
+  timer.begin("frame");
+}
+
+/* Stop cpu clock & gpu "frame" pass (called after imgui draw data is rendered) */
+void PerfOverlay::end_frame() {
+  GpuTimer::get().end("frame");
+
+  std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - m_time_start;
+  push(m_durations_cpu, m_i_head_cpu, m_n_cpu, duration.count());
+  export_metrics(duration.count());
+}
+
+/**
+ * Frame time counted in exporter's histogram, other metrics refreshed at most once per write of exporter:
+ * gpu passes of last measured frame, input latency, memory totals & by owner, hit rates of texture & buffer pools
+ */
+void PerfOverlay::export_metrics(float duration_cpu) {
+  MetricsExporter& exporter = MetricsExporter::get();
+  if (!exporter.is_enabled())
+    return;
+
+  exporter.add_frame(duration_cpu);
+  exporter.add("frames_total", 1.0);
+
+  auto time_now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<float>(time_now - m_time_metrics).count() < std::min(MetricsExporter::interval, 1.0f))
+    return;
+  m_time_metrics = time_now;
+
+  for (const GpuTimer::Result& result : GpuTimer::get().get_results())
+    exporter.set("gpu_pass_ms", result.duration, MetricType::GAUGE, "pass", result.name);
+  if (m_n_latency > 0)
+    exporter.set("latency_ms", Pacing::latency);
+
+  MemoryTracker& tracker = MemoryTracker::get();
+  exporter.set("memory_gpu_bytes", tracker.get_n_bytes_gpu());
+  exporter.set("memory_cpu_bytes", tracker.get_n_bytes_cpu());
+  // textures & buffers of an owner summed as vram
+  std::map<std::string, double> n_bytes_gpu, n_bytes_cpu;
+  for (const MemoryTracker::Allocation& allocation : tracker.get_owners())
+    (allocation.kind == MemoryKind::CPU ? n_bytes_cpu : n_bytes_gpu)[allocation.owner] += allocation.n_bytes;
+  for (const auto& [owner, n_bytes] : n_bytes_gpu)
+    exporter.set("memory_owner_gpu_bytes", n_bytes, MetricType::GAUGE, "owner", owner);
+  for (const auto& [owner, n_bytes] : n_bytes_cpu)
+    exporter.set("memory_owner_cpu_bytes", n_bytes, MetricType::GAUGE, "owner", owner);
+
+  // hit ratio left to monitoring (rate of hits over rate of hits & misses)
+  TexturePool::Stats stats_textures = TexturePool::get().get_stats();
+  exporter.set("cache_hits_total", stats_textures.n_hits, MetricType::COUNTER, "cache", "texture_pool");
+  exporter.set("cache_misses_total", stats_textures.n_misses, MetricType::COUNTER, "cache", "texture_pool");
+  BufferPool::Stats stats_buffers = BufferPool::get().get_stats();
+  exporter.set("cache_hits_total", stats_buffers.n_hits, MetricType::COUNTER, "cache", "buffer_pool");
+  exporter.set("cache_misses_total", stats_buffers.n_misses, MetricType::COUNTER, "cache", "buffer_pool");
+
+  if (SequencePlayer::stats.is_playing)
+    exporter.set("sequence_dropped_total", SequencePlayer::stats.n_dropped, MetricType::COUNTER);
+}
+
+/**
+ * Graphs with p50/p99, table of passes of latest measured gpu frame & cpu zones
+ * Transparent window at bottom-left corner (effects panel is at top-right)
+ */
+void PerfOverlay::render() {
+  if (!Menu::view_performance)
+    return;
+
+  ImVec2 size_display = ImGui::GetIO().DisplaySize;
+  ImGui::SetNextWindowPos({ 10.0f, size_display.y - 10.0f }, ImGuiCond_Always, { 0.0f, 1.0f });
+  ImGui::SetNextWindowBgAlpha(0.35f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav;
+  ImGui::Begin("Performance", &Menu::view_performance, window_flags);
+
+  render_graph("cpu", m_durations_cpu, m_i_head_cpu, m_n_cpu);
+  render_graph("gpu", m_durations_gpu, m_i_head_gpu, m_n_gpu);
+  render_graph("latency", m_latencies, m_i_head_latency, m_n_latency);
+  ImGui::Text("Pacing: %s%s", Pacing::low_latency ? "low-latency" : "default", Pacing::no_vsync_drawing ? ", no vsync drawing" : "");
+  ImGui::Separator();
+
+  // sequence playback: frames dropped (skipped or late) & decoder's time per frame vs. frame budget
+  const SequencePlayer::Stats& stats = SequencePlayer::stats;
+  if (stats.is_playing) {
+    ImVec4 color = stats.duration_decode > 1000.0f / stats.fps ? ImVec4(1.0f, 0.6f, 0.2f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+    ImGui::Text("Sequence: frame %d/%d at %d fps, %d buffered", stats.i_frame + 1, stats.n_frames, stats.fps, stats.n_buffered);
+    ImGui::Text("Shown: %u, dropped: %u", stats.n_shown, stats.n_dropped);
+    ImGui::TextColored(color, "Decode: %.1f ms (max %.1f ms)", stats.duration_decode, stats.duration_decode_max);
+    ImGui::Separator();
+  }
+
+  // passes issued in same frame as last gpu frame measured (others didn't run, e.g. effects up-to-date)
+  std::vector<GpuTimer::Result> results = GpuTimer::get().get_results();
+  float duration_frame = 0.0f;
+  for (const GpuTimer::Result& result : results) {
+    if (result.name == "frame")
+      duration_frame = result.duration;
+  }
+
+  float duration_max = 0.0f;
+  float duration_passes = 0.0f;
+  for (GpuTimer::Result& result : results) {
+    if (result.i_frame != m_i_frame_gpu)
+      result.duration = 0.0f;
+    if (result.name != "frame") {
+      duration_max = std::max(duration_max, result.duration);
+      duration_passes += result.duration;
+    }
+  }
+
+  for (const GpuTimer::Result& result : results) {
+    if (result.name == "frame")
+      continue;
+
+    float percent = duration_frame > 0.0f ? 100.0f * result.duration / duration_frame : 0.0f;
+    ImVec4 color = result.duration == duration_max && duration_max > 0.0f ? ImVec4(1.0f, 0.6f, 0.2f, 1.0f) : ImVec4(1.0f, 1.0f, 1.0f, 1.0f);
+    ImGui::TextColored(color, "%-8s %7.3f ms %5.1f%%", result.name.c_str(), result.duration, percent);
+  }
+  ImGui::Text("%-8s %7.3f ms", "other", std::max(duration_frame - duration_passes, 0.0f));
+  ImGui::Separator();
+
+  render_zones();
+  ImGui::End();
+}
+
+/**
+ * Cpu zones indented by nesting depth, with mean & max over their last calls
+ * Capture written in chrome trace format in working directory
+ */
+void PerfOverlay::render_zones() {
+#ifdef PROFILING_ENABLED
+  for (const Tracer::ZoneStats& stats : Tracer::get_stats()) {
+    ImGui::Text("%*s%-*s %7.3f ms (max %7.3f)", 2*stats.depth, "", 32 - 2*stats.depth, stats.name.c_str(),
+                stats.duration_mean, stats.duration_max);
+  }
+
+  unsigned int n_dropped = Tracer::get_n_dropped();
+  if (n_dropped > 0)
+    ImGui::Text("%u zones dropped", n_dropped);
+
+  if (!Tracer::is_capturing()) {
+    if (ImGui::Button("Start capture"))
+      Tracer::start_capture();
+  } else if (ImGui::Button("Stop & save trace")) {
+    Tracer::stop_capture(PATH_TRACE);
+  }
+#else
+  ImGui::TextDisabled("Cpu zones disabled (build with -DPROFILING=ON)");
+#endif
+}
+
+void PerfOverlay::push(std::vector<float>& durations, int& i_head, int& n, float duration) {
+  durations[i_head] = duration;
+  i_head = (i_head + 1) % N_FRAMES;
+  n = std::min(n + 1, N_FRAMES);
+}
+
+/* Nearest-rank percentile of `n` durations recorded so far */
+float PerfOverlay::get_percentile(const std::vector<float>& durations, int n, float percentile) {
+  if (n == 0)
+    return 0.0f;
+
+  std::vector<float> sorted(durations.begin(), durations.begin() + n);
+  int i_rank = std::min(static_cast<int>(percentile * n), n - 1);
+  std::nth_element(sorted.begin(), sorted.begin() + i_rank, sorted.end());
+  return sorted[i_rank];
+}
+
+/* Oldest to newest duration, scaled to p99 so spikes don't flatten the graph */
+void PerfOverlay::render_graph(const char* label, const std::vector<float>& durations, int i_head, int n) {
+  float p50 = get_percentile(durations, n, 0.50f);
+  float p99 = get_percentile(durations, n, 0.99f);
+
+  char overlay[64];
+  snprintf(overlay, sizeof(overlay), "p50 %.2f ms  p99 %.2f ms", p50, p99);
+
+  // ring buffer not full yet: values start at index 0
+  int offset = n < N_FRAMES ? 0 : i_head;
+  ImGui::PlotLines(label, durations.data(), n, offset, overlay, 0.0f, 1.5f * p99, ImVec2(280.0f, 50.0f));
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+
+#include "ui/redraw.hpp"
+#include "ui/pacing.hpp"
+#include "ui/cursor_samples.hpp"
+
+/* static members definition (avoids linking error) & initialization */
+bool Redraw::on_demand = false;
+double Redraw::max_idle = 1.0;
+unsigned int Redraw::n_frames_active = 0;
+unsigned int Redraw::n_frames_idle = 0;
+std::atomic<int> Redraw::n_frames_pending(N_FRAMES_SETTLE);
+
+GLFWcursorposfun Redraw::callback_cursor_pos = NULL;
+GLFWmousebuttonfun Redraw::callback_mouse_button = NULL;
+GLFWscrollfun Redraw::callback_scroll = NULL;
+GLFWkeyfun Redraw::callback_key = NULL;
+GLFWcharfun Redraw::callback_char = NULL;
+GLFWwindowsizefun Redraw::callback_window_size = NULL;
+
+/**
+ * Request a redraw on every input event
+ * Must be called before `ImGui_ImplGlfw_InitForOpenGL()` so imgui chains its callbacks to these ones
+ */
+void Redraw::install_callbacks(GLFWwindow* window) {
+  callback_cursor_pos = glfwSetCursorPosCallback(window, on_cursor_pos);
+  callback_mouse_button = glfwSetMouseButtonCallback(window, on_mouse_button);
+  callback_scroll = glfwSetScrollCallback(window, on_scroll);
+  callback_key = glfwSetKeyCallback(window, on_key);
+  callback_char = glfwSetCharCallback(window, on_char);
+  callback_window_size = glfwSetWindowSizeCallback(window, on_window_size);
+}
+
+/**
+ * Ask for given # of frames to be rendered
+ * To call from main (gl) thread only
+ */
+void Redraw::request(int n_frames) {
+  if (n_frames_pending < n_frames)
+    n_frames_pending = n_frames;
+}
+
+/* Thread-safe redraw request (e.g. when an async job finishes) that wakes up main loop */
+void Redraw::request_async() {
+  request();
+  glfwPostEmptyEvent();
+}
+
+/**
+ * Called at the beginning of each iteration of main loop in on-demand mode
+ * Blocks until an event is received, a redraw requested or `max_idle` seconds elapsed
+ */
+void Redraw::wait() {
+  if (n_frames_pending <= 0)
+    glfwWaitEventsTimeout(max_idle);
+
+  // events received while waiting request frames through callbacks
+  if (n_frames_pending > 0) {
+    n_frames_pending--;
+    n_frames_active++;
+  } else {
+    n_frames_idle++;
+  }
+}
+
+/* Show # of active & idle frames */
+void Redraw::print() {
+  std::cout << "Frames active: " << n_frames_active << ", idle: " << n_frames_idle << '\n';
+}
+
+void Redraw::on_cursor_pos(GLFWwindow* window, double x, double y) {
+  request();
+  Pacing::on_input();
+  CursorSamples::push(x, y);
+  if (callback_cursor_pos != NULL)
+    callback_cursor_pos(window, x, y);
+}
+
+void Redraw::on_mouse_button(GLFWwindow* window, int button, int action, int mods) {
+  request();
+  Pacing::on_input();
+  if (callback_mouse_button != NULL)
+    callback_mouse_button(window, button, action, mods);
+}
+
+void Redraw::on_scroll(GLFWwindow* window, double x_offset, double y_offset) {
+  request();
+  Pacing::on_input();
+  if (callback_scroll != NULL)
+    callback_scroll(window, x_offset, y_offset);
+}
+
+void Redraw::on_key(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  request();
+  Pacing::on_input();
+  if (callback_key != NULL)
+    callback_key(window, key, scancode, action, mods);
+}
+
+void Redraw::on_char(GLFWwindow* window, unsigned int codepoint) {
+  request();
+  Pacing::on_input();
+  if (callback_char != NULL)
+    callback_char(window, codepoint);
+}
+
+void Redraw::on_window_size(GLFWwindow* window, int width, int height) {
+  request();
+  if (callback_window_size != NULL)
+    callback_window_size(window, width, height);
+}
@@ -0,0 +1,134 @@
+#include <filesystem>
+#include <algorithm>
+
+#include "imgui.h"
+
+#include "ui/thumbnail_strip.hpp"
+#include "ui/menu.hpp"
+#include "commands/command_queue.hpp"
+
+ThumbnailStrip::ThumbnailStrip():
+  m_atlas(),
+  m_paths_open(),
+  m_paths_recent(),
+  m_i_active(0),
+  m_revisions(),
+  m_time_capture(0.0)
+{
+}
+
+/* Move image to front of recent ones (oldest dropped with its thumbnail beyond `N_RECENT`) */
+void ThumbnailStrip::add_recent(const std::string& path) {
+  m_paths_recent.erase(std::remove(m_paths_recent.begin(), m_paths_recent.end(), path), m_paths_recent.end());
+  m_paths_recent.push_front(path);
+
+  while (m_paths_recent.size() > N_RECENT) {
+    m_atlas.remove(m_paths_recent.back());
+    m_revisions.erase(m_paths_recent.back());
+    m_paths_recent.pop_back();
+  }
+}
+
+/**
+ * Track documents closed (or whose image was replaced) since last frame, & capture active document's thumbnail
+ * Called after commands are handled, so listed documents match indices of `SWITCH_DOCUMENT`
+ * Captured when missing, or at most every `INTERVAL_CAPTURE` once document changed (edits picked up by later frames)
+ */
+void ThumbnailStrip::update(Documents& documents) {
+  std::vector<std::string> paths_open;
+  for (size_t i_document = 0; i_document < documents.get_n_documents(); i_document++)
+    paths_open.push_back(documents.get(i_document).get_path());
+
+  for (const std::string& path : m_paths_open) {
+    bool is_open = std::find(paths_open.begin(), paths_open.end(), path) != paths_open.end();
+    if (!path.empty() && !is_open)
+      add_recent(path);
+  }
+
+  // images reopened no longer listed as recent
+  for (const std::string& path : paths_open)
+    m_paths_recent.erase(std::remove(m_paths_recent.begin(), m_paths_recent.end(), path), m_paths_recent.end());
+  m_paths_open = paths_open;
+  m_i_active = documents.get_i_active();
+
+  if (!Menu::view_thumbnails)
+    return;
+
+  // placeholders shown even if no document could be captured yet (e.g. tiled image)
+  m_atlas.create();
+  Canvas& canvas = documents.get_active();
+  const std::string& path = canvas.get_path();
+  auto it = m_revisions.find(path);
+  bool is_captured = m_atlas.contains(path) && it != m_revisions.end();
+  bool is_outdated = is_captured && it->second != canvas.get_revision() &&
+                     ImGui::GetTime() - m_time_capture >= INTERVAL_CAPTURE;
+  if (path.empty() || (is_captured && !is_outdated))
+    return;
+
+  const Texture2D* texture = canvas.get_texture_thumbnail();
+  if (texture != NULL && m_atlas.capture(path, *texture)) {
+    m_revisions[path] = canvas.get_revision();
+    m_time_capture = ImGui::GetTime();
+  }
+}
+
+/**
+ * Thumbnail of image (dimmed unless active) fitted in a square of `SIZE_DISPLAY`
+ * @return true if it was clicked
+ */
+bool ThumbnailStrip::render_entry(const std::string& path, bool is_active) {
+  ThumbnailAtlas::Region region = m_atlas.get_region(path);
+  float width = region.u_max - region.u_min, height = region.v_max - region.v_min;
+  float scale = SIZE_DISPLAY / std::max(width * ThumbnailAtlas::N_SLOTS_X, height * ThumbnailAtlas::N_SLOTS_Y);
+  ImVec2 size = { width * ThumbnailAtlas::N_SLOTS_X * scale, height * ThumbnailAtlas::N_SLOTS_Y * scale };
+
+  // vertically centered in strip (tint only, as borders & labels would be drawn with font texture)
+  ImVec2 position = ImGui::GetCursorPos();
+  ImGui::SetCursorPosY(position.y + (SIZE_DISPLAY - size.y) / 2.0f);
+  ImVec4 tint = is_active ? ImVec4(1.0f, 1.0f, 1.0f, 1.0f) : ImVec4(0.6f, 0.6f, 0.6f, 1.0f);
+  ImGui::Image((void*)(intptr_t) m_atlas.get_id(), size, { region.u_min, region.v_min }, { region.u_max, region.v_max }, tint);
+
+  if (ImGui::IsItemHovered()) {
+    std::string name = std::filesystem::path(path).filename().string();
+    ImGui::SetTooltip("%s", name.empty() ? "Untitled" : name.c_str());
+  }
+
+  bool is_clicked = ImGui::IsItemClicked();
+  ImGui::SameLine();
+  ImGui::SetCursorPosY(position.y);
+  return is_clicked;
+}
+
+/* Strip at bottom-center of canvas (scrolled horizontally when wider than window) */
+void ThumbnailStrip::render() {
+  if (!Menu::view_thumbnails || m_atlas.get_id() == 0)
+    return;
+
+  ImVec2 size_display = ImGui::GetIO().DisplaySize;
+  ImGui::SetNextWindowPos({ size_display.x / 2.0f, size_display.y - 10.0f }, ImGuiCond_Always, { 0.5f, 1.0f });
+  ImGui::SetNextWindowSizeConstraints({ 0.0f, 0.0f }, { size_display.x / 2.0f, size_display.y });
+  ImGui::SetNextWindowBgAlpha(0.35f);
+  ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize |
+                                  ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoFocusOnAppearing |
+                                  ImGuiWindowFlags_NoNav | ImGuiWindowFlags_HorizontalScrollbar;
+  ImGui::Begin("Thumbnails", &Menu::view_thumbnails, window_flags);
+
+  CommandQueue& queue = CommandQueue::get();
+  for (size_t i_document = 0; i_document < m_paths_open.size(); i_document++) {
+    if (render_entry(m_paths_open[i_document], i_document == m_i_active) && i_document != m_i_active)
+      queue.push({ CommandType::SWITCH_DOCUMENT, (int) i_document });
+  }
+
+  for (size_t i_recent = 0; i_recent < m_paths_recent.size(); i_recent++) {
+    if (render_entry(m_paths_recent[i_recent], false))
+      queue.push({ CommandType::NEW_DOCUMENT, 0, 0.0f, 0.0f, 0.0f, 0.0f, m_paths_recent[i_recent] });
+  }
+
+  ImGui::NewLine();
+  ImGui::End();
+}
+
+void ThumbnailStrip::free() {
+  m_atlas.free();
+  m_revisions.clear();
+}
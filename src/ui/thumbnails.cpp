@@ -0,0 +1,87 @@
+#include <cstring>
+
+#include "glad/glad.h"
+#include "ImGuiFileDialog/ImGuiFileDialog.h"
+
+#include "ui/thumbnails.hpp"
+#include "profiling/memory_tracker.hpp"
+
+/* Install loader & texture callbacks on dialog */
+Thumbnails::Thumbnails():
+  m_cache(HEIGHT),
+  m_n_uploads(0),
+  m_was_opened(false)
+{
+  ImGuiFileDialog* dialog = ImGuiFileDialog::Instance();
+
+  // pixels handed to dialog allocated with `new[]` (freed by texture callback below)
+  dialog->SetLoadThumbnailCallback([this](const std::string& path, const IGFD::ThumbnailLoadedFun& on_loaded) {
+    m_cache.request(path, [on_loaded](const Thumbnail& thumbnail) {
+      if (thumbnail.data.empty()) {
+        on_loaded(nullptr, 0, 0);
+        return;
+      }
+
+      uint8_t* data = new uint8_t[thumbnail.data.size()];
+      std::memcpy(data, thumbnail.data.data(), thumbnail.data.size());
+      on_loaded(data, thumbnail.width, thumbnail.height);
+    });
+  });
+
+  // thumbnails beyond budget (per frame or of vram) stay ready to upload & are retried next frame
+  dialog->SetCreateThumbnailCallback([this](IGFD_Thumbnail_Info* info) {
+    if (!info || !info->isReadyToUpload || !info->textureFileDatas || m_n_uploads >= N_UPLOADS_FRAME)
+      return;
+
+    MemoryTracker& tracker = MemoryTracker::get();
+    if (tracker.get_n_bytes(OWNER) >= tracker.get_budget(MemoryBudget::THUMBNAILS))
+      return;
+
+    GLuint id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, info->textureWidth, info->textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 info->textureFileDatas);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    tracker.track(MemoryKind::TEXTURE, id, OWNER, "4 ch 8-bit", (size_t) info->textureWidth * info->textureHeight * 4);
+
+    delete[] info->textureFileDatas;
+    info->textureFileDatas = nullptr;
+    info->textureID = (void*)(intptr_t) id;
+    info->isReadyToUpload = false;
+    info->isReadyToDisplay = true;
+    m_n_uploads++;
+  });
+
+  dialog->SetDestroyThumbnailCallback([](IGFD_Thumbnail_Info* info) {
+    if (!info)
+      return;
+
+    GLuint id = (GLuint)(intptr_t) info->textureID;
+    MemoryTracker::get().untrack(MemoryKind::TEXTURE, id);
+    glDeleteTextures(1, &id);
+  });
+}
+
+/**
+ * Create & destroy thumbnails textures (called after imgui draw data is rendered)
+ * Thumbnails still queued when dialog is closed aren't decoded
+ */
+void Thumbnails::upload() {
+  ImGuiFileDialog* dialog = ImGuiFileDialog::Instance();
+  bool is_opened = dialog->IsOpened();
+  if (m_was_opened && !is_opened)
+    m_cache.cancel();
+  m_was_opened = is_opened;
+
+  m_n_uploads = 0;
+  dialog->ManageGPUThumbnails();
+}
+
+void Thumbnails::free() {
+  m_cache.free();
+}
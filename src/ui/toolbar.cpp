@@ -6,6 +6,7 @@
 #include "ui/toolbar.hpp"
 #include "ui/menu.hpp"
 #include "ui/enumerations/hover_mode.hpp"
+#include "commands/command_queue.hpp"
 
 #include "ui/globals/size.hpp"
 #include "ui/globals/color.hpp"
@@ -15,16 +16,24 @@
 /* static members definition (avoids linking error) & initialization */
 bool Toolbar::open_image = false;
 bool Toolbar::save_image = false;
-bool Toolbar::quit_app = false;
-bool Toolbar::zoom_in = false;
-bool Toolbar::zoom_out = false;
 bool Toolbar::draw_circle = false;
 bool Toolbar::draw_line = false;
 bool Toolbar::brush_circle = false;
 bool Toolbar::brush_line = false;
+bool Toolbar::select_rect = false;
+bool Toolbar::select_lasso = false;
+bool Toolbar::fill = false;
+bool Toolbar::magic_wand = false;
 
-// radio button (0: none, 1: image subset, 2: pixel value)
+// line tool snaps its ends to strong image edges near cursor
+bool Toolbar::snap_edges = true;
+
+// radio button (0: none, 1: image subset, 2: pixel value, 3: neighbourhood) & side of neighbourhood's grid
 int Toolbar::hover_mode = HoverMode::NONE;
+int Toolbar::size_neighbourhood = 15;
+
+// max. difference of any channel with clicked pixel's color (0-255) for fill tool & magic wand
+int Toolbar::tolerance = 32;
 
 Toolbar::Toolbar()
 {
@@ -75,21 +84,21 @@ void Toolbar::render() {
   ImGui::SameLine(0, 1); // offset=0: right after previous item, spacing=1px
 
   if (ImGui::Button(ICON_FA_WINDOW_CLOSE, { 2*size_font, -1.0f })) {
-    Toolbar::quit_app = true;
+    CommandQueue::get().push({ CommandType::QUIT });
   }
   if (ImGui::IsItemHovered())
       ImGui::SetTooltip("Quit");
   ImGui::SameLine(0, 1); // offset=0: right after previous item, spacing=1px
 
   if (ImGui::Button(ICON_FA_PLUS_CIRCLE, { 2*size_font, -1.0f })) {
-    Toolbar::zoom_in = true;
+    CommandQueue::get().push({ CommandType::ZOOM, 1 });
   }
   if (ImGui::IsItemHovered())
       ImGui::SetTooltip("Zoom in");
   ImGui::SameLine(0, 1); // offset=0: right after previous item, spacing=1px
 
   if (ImGui::Button(ICON_FA_MINUS_CIRCLE, { 2*size_font, -1.0f })) {
-    Toolbar::zoom_out = true;
+    CommandQueue::get().push({ CommandType::ZOOM, -1 });
   }
   if (ImGui::IsItemHovered())
       ImGui::SetTooltip("Zoom out");
@@ -143,6 +152,73 @@ void Toolbar::render() {
     ImGui::SetTooltip("Line brush tool");
   ImGui::SameLine(0, 1); // offset=0: pos. right after previous item, spacing=1px
 
+  // selection tools don't leave normal mode (effects shown while selecting region they apply to)
+  ImGui::PushStyleColor(ImGuiCol_Button, style.Colors[Menu::select_rect ? ImGuiCol_ButtonActive : ImGuiCol_Button]);
+  if (ImGui::Button(ICON_FA_VECTOR_SQUARE, { 2*size_font, -1.0f })) {
+    Toolbar::select_rect = Menu::select_rect = !Menu::select_rect;
+    Toolbar::select_lasso = Menu::select_lasso = false;
+    Toolbar::magic_wand = Menu::magic_wand = false;
+  }
+  ImGui::PopStyleColor();
+
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Rectangle selection (effects applied inside it)");
+  ImGui::SameLine(0, 1); // offset=0: pos. right after previous item, spacing=1px
+
+  ImGui::PushStyleColor(ImGuiCol_Button, style.Colors[Menu::select_lasso ? ImGuiCol_ButtonActive : ImGuiCol_Button]);
+  if (ImGui::Button(ICON_FA_DRAW_POLYGON, { 2*size_font, -1.0f })) {
+    Toolbar::select_lasso = Menu::select_lasso = !Menu::select_lasso;
+    Toolbar::select_rect = Menu::select_rect = false;
+    Toolbar::magic_wand = Menu::magic_wand = false;
+  }
+  ImGui::PopStyleColor();
+
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Lasso selection (effects applied inside it)");
+  ImGui::SameLine(0, 1); // offset=0: pos. right after previous item, spacing=1px
+
+  ImGui::PushStyleColor(ImGuiCol_Button, style.Colors[Menu::magic_wand ? ImGuiCol_ButtonActive : ImGuiCol_Button]);
+  if (ImGui::Button(ICON_FA_MAGIC, { 2*size_font, -1.0f })) {
+    Toolbar::magic_wand = Menu::magic_wand = !Menu::magic_wand;
+    Toolbar::select_rect = Menu::select_rect = false;
+    Toolbar::select_lasso = Menu::select_lasso = false;
+  }
+  ImGui::PopStyleColor();
+
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Magic wand (selects similar color around clicked pixel)");
+  ImGui::SameLine(0, 1); // offset=0: pos. right after previous item, spacing=1px
+
+  // change color for toolbar button if in right mode
+  ImGui::PushStyleColor(ImGuiCol_Button, style.Colors[Menu::fill ? ImGuiCol_ButtonActive : ImGuiCol_Button]);
+  if (ImGui::Button(ICON_FA_FILL_DRIP, { 2*size_font, -1.0f })) {
+    Toolbar::fill = Menu::fill = !Menu::fill;
+    mode = (mode == Mode::NORMAL) ? Mode::DRAWING : Mode::NORMAL;
+  }
+  ImGui::PopStyleColor();
+
+  if (ImGui::IsItemHovered())
+    ImGui::SetTooltip("Fill tool (fills similar color around clicked pixel)");
+  ImGui::SameLine(0, 1); // offset=0: pos. right after previous item, spacing=1px
+
+  // tolerance shared by fill tool & magic wand
+  if (Toolbar::fill || Toolbar::magic_wand) {
+    ImGui::SetCursorPos({ ImGui::GetCursorPosX(), size_font/2.0f - 3.0f });
+    ImGui::SetNextItemWidth(5*size_font);
+    ImGui::SliderInt("##tolerance", &Toolbar::tolerance, 0, 255, "tol. %d");
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Max. difference with clicked pixel's color");
+    ImGui::SameLine();
+  }
+
+  if (Toolbar::draw_line) {
+    ImGui::SetCursorPos({ ImGui::GetCursorPosX(), size_font/2.0f - 3.0f });
+    ImGui::Checkbox("Snap", &Toolbar::snap_edges);
+    if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Snap line ends to image edges near cursor");
+    ImGui::SameLine();
+  }
+
   // radio buttons for what to show on image hover (imgui_demo.cpp:560)
   // compile-time casting between pointer types works with reinterpret_cast (not with static_cast)
   ImGui::SetCursorPos({ ImGui::GetCursorPosX(), size_font/2.0f - 3.0f });
@@ -159,6 +235,19 @@ void Toolbar::render() {
   ImGui::RadioButton("Pixel value", &Toolbar::hover_mode, HoverMode::PIXEL_VALUE);
   if (ImGui::IsItemHovered())
       ImGui::SetTooltip("Show hovered pixel value");
+  ImGui::SameLine();
+
+  ImGui::RadioButton("Neighbourhood", &Toolbar::hover_mode, HoverMode::NEIGHBOURHOOD);
+  if (ImGui::IsItemHovered())
+      ImGui::SetTooltip("Show grid of pixel values around hovered one (with mean & std)");
+
+  // grid side kept odd so hovered pixel is at its center
+  if (Toolbar::hover_mode == HoverMode::NEIGHBOURHOOD) {
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(5*size_font);
+    if (ImGui::SliderInt("##size_neighbourhood", &Toolbar::size_neighbourhood, 3, 63, "%d px"))
+      Toolbar::size_neighbourhood |= 1;
+  }
 
   // right alignment: https://github.com/ocornut/imgui/issues/934#issuecomment-340231002
   const float itemSpacing = ImGui::GetStyle().ItemSpacing.x;
@@ -1,6 +1,5 @@
 #include "imgui.h"
 #include "ui/tooltips/tooltip_image.hpp"
-#include "ui/imgui_utils.hpp"
 
 TooltipImage::TooltipImage(const Texture2D& texture):
   m_texture(texture)
@@ -9,24 +8,28 @@ TooltipImage::TooltipImage(const Texture2D& texture):
 
 /**
  * Render magnified image region around hovered pixel
- * @param y_offset Height of menu & toolbar
- * @param zoom Canvas' zoom factor
+ * @param position_image Hovered position in image pixels (origin at upper-left corner)
+ * @param zoom Canvas' zoom factor (region covers the same area on screen at any zoom)
+ * @param texture Texture to magnify instead of whole image one (tile in tiled mode)
+ * @param origin_tile Position in image of `texture`'s upper-left corner
  */
-void TooltipImage::render(float y_offset, float zoom) {
+void TooltipImage::render(const ImVec2& position_image, float zoom, const Texture2D* texture, const ImVec2& origin_tile) {
     ImGui::BeginTooltip();
+    ImGui::Text("x: %f, y: %f", position_image.x, position_image.y);
 
-    // mouse cursor rel. to canvas's origin
-    ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position({ 0.0f, y_offset });
-    ImGui::Text("x: %f, y: %f", position_mouse_img.x, position_mouse_img.y);
+    // position rel. to magnified texture
+    if (texture == NULL)
+      texture = &m_texture;
+    ImVec2 position_texture = ImVec2(position_image.x - origin_tile.x, position_image.y - origin_tile.y);
 
     // starting & ending image offsets in [0, 1]
-    ImVec2 size_image = ImVec2(zoom * m_texture.width, zoom * m_texture.height);
     float zoom_subset = 4.0f;
     float size_region = 32.0f;
+    float size_region_image = size_region / zoom;
     ImVec2 size_subset = ImVec2(zoom_subset * size_region, zoom_subset * size_region);
-    ImVec2 uv_start = ImVec2(position_mouse_img.x / size_image.x, position_mouse_img.y / size_image.y);
-    ImVec2 uv_end = ImVec2((position_mouse_img.x + size_region) / size_image.x, (position_mouse_img.y + size_region) / size_image.y);
-    ImGui::Image((void*)(intptr_t) m_texture.id, size_subset, uv_start, uv_end);
+    ImVec2 uv_start = ImVec2(position_texture.x / texture->width, position_texture.y / texture->height);
+    ImVec2 uv_end = ImVec2((position_texture.x + size_region_image) / texture->width, (position_texture.y + size_region_image) / texture->height);
+    ImGui::Image((void*)(intptr_t) texture->id, size_subset, uv_start, uv_end);
 
     ImGui::EndTooltip();
 }
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+
+#include "imgui.h"
+#include "ui/tooltips/tooltip_neighbourhood.hpp"
+#include "ui/imgui_utils.hpp"
+
+TooltipNeighbourhood::TooltipNeighbourhood(const Framebuffer& framebuffer):
+  m_framebuffer(&framebuffer),
+  m_pixel_reader(),
+  m_has_value(false)
+{
+}
+
+/**
+ * Render block of pixels around cursor read from fbo
+ * @param position_image Hovered position in image pixels (origin at upper-left corner)
+ * @param size Side of grid in pixels (block shifted to stay inside fbo near its borders)
+ * @param origin_tile Position in image of region attached to fbo (in tiled mode)
+ */
+void TooltipNeighbourhood::render(const ImVec2& position_image, int size, const ImVec2& origin_tile) {
+  int x_min, y_min, size_x, size_y;
+  get_block((int) (position_image.x - origin_tile.x), (int) (position_image.y - origin_tile.y), size,
+            m_framebuffer->width, m_framebuffer->height, x_min, y_min, size_x, size_y);
+  m_pixel_reader.request(*m_framebuffer, x_min, y_min, size_x, size_y, m_framebuffer->n_channels);
+
+  // keep most recent block finished on gpu
+  while (m_pixel_reader.poll(m_readback))
+    m_has_value = true;
+
+  ImGui::BeginTooltip();
+  if (m_has_value)
+    show(m_readback, position_image, origin_tile);
+  else
+    ImGui::Text("x: %f, y: %f", position_image.x, position_image.y);
+  ImGui::EndTooltip();
+}
+
+/**
+ * Render block of pixels around cursor read from a cpu copy of the image (e.g. of a compressed reference image)
+ * @param image Uncompressed pixels (NULL while they're being decoded)
+ */
+void TooltipNeighbourhood::render_cpu(const ImVec2& position_image, int size, const Image* image) {
+  ImGui::BeginTooltip();
+
+  if (image == NULL || image->data == NULL) {
+    ImGui::Text("x: %f, y: %f", position_image.x, position_image.y);
+    ImGui::TextDisabled("Loading pixels...");
+  } else {
+    Readback block;
+    get_block((int) position_image.x, (int) position_image.y, size, image->width, image->height,
+              block.x, block.y, block.width, block.height);
+    block.n_channels = image->n_channels;
+    block.data.resize((size_t) block.width * block.height * block.n_channels);
+
+    size_t n_bytes_row = (size_t) block.width * block.n_channels;
+    for (int y = 0; y < block.height; y++) {
+      const unsigned char* row = image->data + ((size_t) (block.y + y) * image->width + block.x) * image->n_channels;
+      std::copy(row, row + n_bytes_row, block.data.begin() + y * n_bytes_row);
+    }
+
+    show(block, position_image, { 0.0f, 0.0f });
+  }
+
+  ImGui::EndTooltip();
+}
+
+/* Square block of given size centered on (x, y) & shifted inside image (smaller if image is) */
+void TooltipNeighbourhood::get_block(int x, int y, int size, int width, int height, int& x_min, int& y_min, int& size_x, int& size_y) {
+  size_x = std::min(size, width);
+  size_y = std::min(size, height);
+  x_min = std::clamp(x - size / 2, 0, width - size_x);
+  y_min = std::clamp(y - size / 2, 0, height - size_y);
+}
+
+/**
+ * Grid of cells colored by pixel values (hovered pixel outlined) followed by stats over block
+ * @param origin_block Position in image of region the block was read from
+ */
+void TooltipNeighbourhood::show(const Readback& block, const ImVec2& position_image, const ImVec2& origin_block) {
+  ImGui::Text("x: %f, y: %f", position_image.x, position_image.y);
+  ImGui::Text("block: %d x %d at (%d, %d)", block.width, block.height,
+              block.x + (int) origin_block.x, block.y + (int) origin_block.y);
+
+  // running sums in [0, 1] for mean & variance
+  int n_channels = block.n_channels;
+  double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+  double sums_squares[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  for (int y = 0; y < block.height; y++) {
+    for (int x = 0; x < block.width; x++) {
+      const unsigned char* pixel = block.data.data() + ((size_t) y * block.width + x) * n_channels;
+      for (int i_channel = 0; i_channel < n_channels; i_channel++) {
+        double value = pixel[i_channel] / 255.0;
+        sums[i_channel] += value;
+        sums_squares[i_channel] += value * value;
+      }
+
+      ImVec2 p_min = { origin.x + x * SIZE_CELL, origin.y + y * SIZE_CELL };
+      ImVec2 p_max = { p_min.x + SIZE_CELL, p_min.y + SIZE_CELL };
+      draw_list->AddRectFilled(p_min, p_max, ImGui::GetColorU32(ImGuiUtils::arr_to_imvec4(pixel, n_channels)));
+    }
+  }
+
+  // hovered pixel (readback may lag behind cursor, so it can fall outside block)
+  int x_hovered = (int) (position_image.x - origin_block.x) - block.x;
+  int y_hovered = (int) (position_image.y - origin_block.y) - block.y;
+  if (x_hovered >= 0 && x_hovered < block.width && y_hovered >= 0 && y_hovered < block.height) {
+    ImVec2 p_min = { origin.x + x_hovered * SIZE_CELL, origin.y + y_hovered * SIZE_CELL };
+    draw_list->AddRect(p_min, { p_min.x + SIZE_CELL, p_min.y + SIZE_CELL }, IM_COL32(255, 0, 255, 255));
+  }
+  ImGui::Dummy({ block.width * SIZE_CELL, block.height * SIZE_CELL });
+
+  // population statistics over block
+  double n_pixels = (double) block.width * block.height;
+  float means[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  float deviations[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  for (int i_channel = 0; i_channel < n_channels; i_channel++) {
+    double mean = sums[i_channel] / n_pixels;
+    means[i_channel] = mean;
+    deviations[i_channel] = std::sqrt(std::max(sums_squares[i_channel] / n_pixels - mean * mean, 0.0));
+  }
+
+  ImGui::Text("mean: %f, %f, %f, %f", means[0], means[1], means[2], means[3]);
+  ImGui::Text("std: %f, %f, %f, %f", deviations[0], deviations[1], deviations[2], deviations[3]);
+}
+
+/* Destroy PBOs used for readback */
+void TooltipNeighbourhood::free() {
+  m_pixel_reader.free();
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "imgui.h"
 #include "ui/tooltips/tooltip_pixel.hpp"
 #include "ui/imgui_utils.hpp"
@@ -7,33 +9,66 @@
  * bcoz user may paint on texture in the meantime
  */
 TooltipPixel::TooltipPixel(const Framebuffer& framebuffer):
-  m_framebuffer(framebuffer)
+  m_framebuffer(&framebuffer),
+  m_pixel_reader(),
+  m_has_value(false)
 {
 }
 
 /**
  * Render pixel value at cursor location
- * @param y_offset Height of menu & toolbar
- * @param y_scroll Height of vertical scroll (bcoz imgui ignores it when given cursor's x,y)
+ * @param position_image Hovered position in image pixels (origin at upper-left corner)
+ * @param origin_tile Position in image of region attached to fbo (in tiled mode)
  */
-void TooltipPixel::render(float y_offset, float y_scroll) {
+void TooltipPixel::render(const ImVec2& position_image, const ImVec2& origin_tile) {
     ImGui::BeginTooltip();
+    ImGui::Text("x: %f, y: %f", position_image.x, position_image.y);
 
-    // mouse cursor rel. to canvas's origin
-    ImVec2 position_mouse_img = ImGuiUtils::get_mouse_position({ 0.0f, y_offset }, y_scroll);
-    ImGui::Text("x: %f, y: %f", position_mouse_img.x, position_mouse_img.y);
+    // request pixel value at (x, y) from fbo without waiting for it (clamped to avoid reading outside fbo)
+    int x = std::clamp((int) (position_image.x - origin_tile.x), 0, m_framebuffer->width - 1);
+    int y = std::clamp((int) (position_image.y - origin_tile.y), 0, m_framebuffer->height - 1);
+    m_pixel_reader.request(*m_framebuffer, x, y, 1, 1, m_framebuffer->n_channels);
 
-    // read pixel value at (x, y) from fbo
-    int n_channels = m_framebuffer.n_channels;
-    unsigned char pixel_value[n_channels];
-    m_framebuffer.get_pixel_value(position_mouse_img.x, position_mouse_img.y, pixel_value);
+    // keep most recent value finished on gpu
+    while (m_pixel_reader.poll(m_readback))
+      m_has_value = true;
 
-    // transform pixel value in [0, 255] into a 4-component vector in [0, 1]
-    ImVec4 color = ImGuiUtils::arr_to_imvec4(pixel_value, n_channels);
-    ImGui::Text("color: %f, %f, %f, %f", color.x, color.y, color.z, color.w);
+    if (m_has_value) {
+      // transform pixel value in [0, 255] into a 4-component vector in [0, 1]
+      ImVec4 color = ImGuiUtils::arr_to_imvec4(m_readback.data.data(), m_readback.n_channels);
+      ImGui::Text("color: %f, %f, %f, %f", color.x, color.y, color.z, color.w);
 
-    // show button with pixel color under cursor
-    ImGui::ColorButton("MyColor##3c", color);
+      // show button with pixel color under cursor
+      ImGui::ColorButton("MyColor##3c", color);
+    }
 
     ImGui::EndTooltip();
 }
+
+/**
+ * Render pixel value at cursor location read from a cpu copy of the image (e.g. of a compressed reference image)
+ * @param image Uncompressed pixels (NULL while they're being decoded)
+ */
+void TooltipPixel::render_cpu(const ImVec2& position_image, const Image* image) {
+    ImGui::BeginTooltip();
+    ImGui::Text("x: %f, y: %f", position_image.x, position_image.y);
+
+    if (image == NULL || image->data == NULL) {
+      ImGui::TextDisabled("Loading pixels...");
+    } else {
+      // cpu copy not flipped (origin at upper-left corner like cursor position)
+      int x = std::clamp((int) position_image.x, 0, image->width - 1);
+      int y = std::clamp((int) position_image.y, 0, image->height - 1);
+      const unsigned char* pixel = image->data + ((size_t) y * image->width + x) * image->n_channels;
+      ImVec4 color = ImGuiUtils::arr_to_imvec4(pixel, image->n_channels);
+      ImGui::Text("color: %f, %f, %f, %f", color.x, color.y, color.z, color.w);
+      ImGui::ColorButton("MyColor##3c", color);
+    }
+
+    ImGui::EndTooltip();
+}
+
+/* Destroy PBOs used for readback */
+void TooltipPixel::free() {
+  m_pixel_reader.free();
+}